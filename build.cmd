@@ -12,9 +12,19 @@ echo Platform: Windows
 REM Source files (including bundled utf8proc)
 set SOURCES=^
 src\diff_api.c ^
+src\diff_session.c ^
+src\flat_lines_diff.c ^
+src\diff_async.c ^
+src\diff_cache.c ^
+src\diff_batch.c ^
+src\three_way_diff.c ^
+src\diff_workspace.c ^
+src\packed_lines_diff.c ^
+src\diff_allocator.c ^
 src\render_plan.c ^
 default_lines_diff_computer.c ^
 src\char_level.c ^
+src\compute_moved_lines.c ^
 src\line_level.c ^
 src\myers.c ^
 src\optimize.c ^
@@ -24,6 +34,8 @@ src\string_hash_map.c ^
 src\utils.c ^
 src\print_utils.c ^
 src\utf8_utils.c ^
+src\arena.c ^
+src\text_lines.c ^
 vendor\utf8proc.c
 
 REM Auto-detect compiler
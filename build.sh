@@ -12,7 +12,7 @@ echo "Platform: Linux"
 # Compiler and flags from CMake configuration
 CC="/usr/bin/cc"
 CFLAGS=" -Wall -Wextra -O2 -DNDEBUG -Iinclude -Ivendor -fPIC"
-LDFLAGS="-shared -lm"
+LDFLAGS="-shared -lm -pthread"
 
 # Detect platform for library extension
 if [[ "$OSTYPE" == "darwin"* ]]; then
@@ -26,9 +26,19 @@ fi
 # Source files (including bundled utf8proc)
 SOURCES="\
 src/diff_api.c \
+src/diff_session.c \
+src/flat_lines_diff.c \
+src/diff_async.c \
+src/diff_cache.c \
+src/diff_batch.c \
+src/three_way_diff.c \
+src/diff_workspace.c \
+src/packed_lines_diff.c \
+src/diff_allocator.c \
 src/render_plan.c \
 default_lines_diff_computer.c \
 src/char_level.c \
+src/compute_moved_lines.c \
 src/line_level.c \
 src/myers.c \
 src/optimize.c \
@@ -38,6 +48,8 @@ src/string_hash_map.c \
 src/utils.c \
 src/print_utils.c \
 src/utf8_utils.c \
+src/arena.c \
+src/text_lines.c \
 vendor/utf8proc.c"
 
 # Build
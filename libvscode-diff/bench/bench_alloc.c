@@ -0,0 +1,51 @@
+// ============================================================================
+// Allocation Counting for the Benchmark Harness
+// ============================================================================
+//
+// A DiffAllocator over the C heap that counts every call the library makes
+// (see diff_allocator.h).
+//
+// ============================================================================
+
+#include "bench_alloc.h"
+#include "diff_allocator.h"
+#include <stdlib.h>
+
+static BenchAllocCounters counters = {0, 0};
+
+static void* counting_allocate(void* user_data, size_t size) {
+    (void)user_data;
+    counters.allocations++;
+    counters.bytes += (int64_t)size;
+    return malloc(size);
+}
+
+static void* counting_allocate_zeroed(void* user_data, size_t count, size_t size) {
+    (void)user_data;
+    counters.allocations++;
+    counters.bytes += (int64_t)(count * size);
+    return calloc(count, size);
+}
+
+static void* counting_reallocate(void* user_data, void* ptr, size_t size) {
+    (void)user_data;
+    counters.allocations++;
+    counters.bytes += (int64_t)size;
+    return realloc(ptr, size);
+}
+
+static void counting_release(void* user_data, void* ptr) {
+    (void)user_data;
+    free(ptr);
+}
+
+void bench_alloc_install(void) {
+    DiffAllocator allocator = {
+        counting_allocate, counting_reallocate, counting_release, counting_allocate_zeroed, NULL,
+    };
+    diff_set_allocator(&allocator);
+}
+
+BenchAllocCounters bench_alloc_counters(void) {
+    return counters;
+}
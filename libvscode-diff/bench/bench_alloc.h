@@ -0,0 +1,28 @@
+/**
+ * Allocation Counting for the Benchmark Harness
+ *
+ * bench_alloc_install() puts a counting allocator in front of the C heap
+ * through the library's allocator hooks, so every allocation the pipeline
+ * makes is counted.
+ *
+ * Counters are plain ints: benchmarks run the pipeline single-threaded.
+ */
+
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int64_t allocations;    // malloc + calloc + realloc calls
+    int64_t bytes;          // Bytes requested by those calls
+} BenchAllocCounters;
+
+/** Install the counting allocator (before anything is allocated) */
+void bench_alloc_install(void);
+
+/** Counters since the program started */
+BenchAllocCounters bench_alloc_counters(void);
+
+#endif // BENCH_ALLOC_H
@@ -0,0 +1,369 @@
+// ============================================================================
+// Benchmark Corpus
+// ============================================================================
+//
+// All text comes from a fixed-seed LCG; changing a generator changes the
+// numbers, so treat edits here like a corpus update and note it in the
+// release that tracks the results.
+//
+// ============================================================================
+
+#include "bench_corpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+typedef struct {
+    uint32_t state;
+} Rng;
+
+static uint32_t rng_next(Rng* rng) {
+    rng->state = rng->state * 1664525u + 1013904223u;
+    return rng->state >> 8;
+}
+
+static int rng_range(Rng* rng, int n) {
+    return (int)(rng_next(rng) % (uint32_t)n);
+}
+
+typedef struct {
+    char** lines;
+    int count;
+    int capacity;
+} LineList;
+
+static bool line_list_push(LineList* list, const char* text) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        char** lines = (char**)realloc(list->lines, (size_t)capacity * sizeof(char*));
+        if (!lines) return false;
+        list->lines = lines;
+        list->capacity = capacity;
+    }
+    size_t len = strlen(text) + 1;
+    char* copy = (char*)malloc(len);
+    if (!copy) return false;
+    memcpy(copy, text, len);
+    list->lines[list->count++] = copy;
+    return true;
+}
+
+static void line_list_free(LineList* list) {
+    for (int i = 0; i < list->count; i++) free(list->lines[i]);
+    free(list->lines);
+}
+
+static const char* const IDENTIFIERS[] = {
+    "buffer", "window", "result", "options", "context", "offset", "length", "index",
+    "cursor", "render", "parse", "update", "config", "handle", "stream", "token",
+};
+#define IDENTIFIER_COUNT ((int)(sizeof(IDENTIFIERS) / sizeof(IDENTIFIERS[0])))
+
+static const char* ident(Rng* rng) {
+    return IDENTIFIERS[rng_range(rng, IDENTIFIER_COUNT)];
+}
+
+/** One line of C-like code, varied by position and the generator */
+static void code_line(Rng* rng, int n, char* out, size_t size) {
+    int indent = 4 * (1 + rng_range(rng, 3));
+    switch (rng_range(rng, 6)) {
+        case 0:
+            snprintf(out, size, "%*sint %s_%d = %s->%s;", indent, "", ident(rng), n, ident(rng), ident(rng));
+            break;
+        case 1:
+            snprintf(out, size, "%*sif (%s_%d > %d) {", indent, "", ident(rng), n, rng_range(rng, 1000));
+            break;
+        case 2:
+            snprintf(out, size, "%*s%s(%s, %s + %d);", indent, "", ident(rng), ident(rng), ident(rng), n);
+            break;
+        case 3:
+            snprintf(out, size, "%*sreturn %s_%s(%s);", indent, "", ident(rng), ident(rng), ident(rng));
+            break;
+        case 4:
+            snprintf(out, size, "%*s// %s the %s before %s", indent, "", ident(rng), ident(rng), ident(rng));
+            break;
+        default:
+            snprintf(out, size, "%*s}", indent, "");
+            break;
+    }
+}
+
+static size_t side_bytes(const LineList* list) {
+    size_t bytes = 0;
+    for (int i = 0; i < list->count; i++) bytes += strlen(list->lines[i]) + 1;
+    return bytes;
+}
+
+// ============================================================================
+// Cases
+// ============================================================================
+
+static bool gen_small_edits(LineList* a, LineList* b, uint32_t seed) {
+    Rng rng = {seed};
+    char line[160];
+    bool ok = true;
+    for (int i = 0; ok && i < 2000; i++) {
+        code_line(&rng, i, line, sizeof(line));
+        ok = line_list_push(a, line);
+    }
+    for (int i = 0; ok && i < a->count; i++) {
+        int roll = rng_range(&rng, 40);
+        if (roll == 0) {
+            // Edit: same shape, different tokens
+            code_line(&rng, i, line, sizeof(line));
+            ok = line_list_push(b, line);
+        } else if (roll == 1) {
+            code_line(&rng, i + 100000, line, sizeof(line));
+            ok = line_list_push(b, line) && line_list_push(b, a->lines[i]);
+        } else if (roll != 2) {
+            ok = line_list_push(b, a->lines[i]);
+        }
+    }
+    return ok;
+}
+
+static bool gen_large_rewrite(LineList* a, LineList* b) {
+    Rng rng = {0x1badb002u};
+    char line[160];
+    bool ok = true;
+    for (int i = 0; ok && i < 2000; i++) {
+        code_line(&rng, i, line, sizeof(line));
+        ok = line_list_push(a, line);
+    }
+    for (int block = 0; ok && block < a->count; block += 20) {
+        bool rewrite = rng_range(&rng, 10) < 7;
+        int lines = rewrite ? 14 + rng_range(&rng, 12) : 20;
+        for (int i = 0; ok && i < lines; i++) {
+            if (rewrite) {
+                code_line(&rng, 200000 + block + i, line, sizeof(line));
+                ok = line_list_push(b, line);
+            } else if (block + i < a->count) {
+                ok = line_list_push(b, a->lines[block + i]);
+            }
+        }
+    }
+    return ok;
+}
+
+static bool gen_reorder(LineList* a, LineList* b) {
+    enum { FUNCTIONS = 200, BODY = 8 };
+    Rng rng = {0xc0ffee11u};
+    char line[160];
+    bool ok = true;
+    for (int f = 0; ok && f < FUNCTIONS; f++) {
+        snprintf(line, sizeof(line), "static int %s_%s_%d(int %s) {", ident(&rng), ident(&rng), f, ident(&rng));
+        ok = line_list_push(a, line);
+        for (int i = 0; ok && i < BODY; i++) {
+            code_line(&rng, f * BODY + i, line, sizeof(line));
+            ok = line_list_push(a, line);
+        }
+        ok = ok && line_list_push(a, "}");
+    }
+
+    // Swap a third of the functions with others, edit a few lines
+    int order[FUNCTIONS];
+    for (int f = 0; f < FUNCTIONS; f++) order[f] = f;
+    for (int k = 0; k < FUNCTIONS / 3; k++) {
+        int x = rng_range(&rng, FUNCTIONS);
+        int y = rng_range(&rng, FUNCTIONS);
+        int t = order[x];
+        order[x] = order[y];
+        order[y] = t;
+    }
+    for (int f = 0; ok && f < FUNCTIONS; f++) {
+        int first = order[f] * (BODY + 2);
+        for (int i = 0; ok && i < BODY + 2; i++) {
+            if (rng_range(&rng, 50) == 0) {
+                code_line(&rng, 300000 + first + i, line, sizeof(line));
+                ok = line_list_push(b, line);
+            } else {
+                ok = line_list_push(b, a->lines[first + i]);
+            }
+        }
+    }
+    return ok;
+}
+
+static bool gen_minified_js(LineList* a, LineList* b) {
+    enum { LINES = 4, LINE_BYTES = 40000 };
+    Rng rng = {0xfeedfaceu};
+    char* original = (char*)malloc(LINE_BYTES + 256);
+    char* modified = (char*)malloc(LINE_BYTES + 256);
+    bool ok = original && modified;
+
+    for (int l = 0; ok && l < LINES; l++) {
+        size_t ia = 0, ib = 0;
+        int token = 0;
+        while (ia < LINE_BYTES) {
+            char piece[128];
+            int n;
+            switch (rng_range(&rng, 4)) {
+                case 0:
+                    n = snprintf(piece, sizeof(piece), "function %c%d(%c,%c){return %c+%c*%d}",
+                                 'a' + rng_range(&rng, 26), token, 'a' + rng_range(&rng, 26), 'b',
+                                 'a' + rng_range(&rng, 26), 'b', rng_range(&rng, 100));
+                    break;
+                case 1:
+                    n = snprintf(piece, sizeof(piece), "var %s%d=%s.%s(%d);", ident(&rng), token,
+                                 ident(&rng), ident(&rng), rng_range(&rng, 10000));
+                    break;
+                case 2:
+                    n = snprintf(piece, sizeof(piece), "if(%s%d){%s=!%s}", ident(&rng), token,
+                                 ident(&rng), ident(&rng));
+                    break;
+                default:
+                    n = snprintf(piece, sizeof(piece), "for(var i=0;i<%d;i++)%s[i]=%d;",
+                                 rng_range(&rng, 64), ident(&rng), token);
+                    break;
+            }
+            memcpy(original + ia, piece, (size_t)n);
+            ia += (size_t)n;
+
+            // About one token in 60 differs on the modified side
+            if (rng_range(&rng, 60) == 0) {
+                n = snprintf(piece, sizeof(piece), "%s%d=%d;", ident(&rng), token, rng_range(&rng, 1000));
+            }
+            memcpy(modified + ib, piece, (size_t)n);
+            ib += (size_t)n;
+            token++;
+        }
+        original[ia] = '\0';
+        modified[ib] = '\0';
+        ok = line_list_push(a, original) && line_list_push(b, modified);
+    }
+
+    free(original);
+    free(modified);
+    return ok;
+}
+
+static bool gen_crlf(LineList* a, LineList* b) {
+    LineList plain_a = {0}, plain_b = {0};
+    bool ok = gen_small_edits(&plain_a, &plain_b, 0x5eed0002u);
+    char line[192];
+    for (int i = 0; ok && i < plain_a.count; i++) {
+        snprintf(line, sizeof(line), "%s\r", plain_a.lines[i]);
+        ok = line_list_push(a, line);
+    }
+    for (int i = 0; ok && i < plain_b.count; i++) {
+        snprintf(line, sizeof(line), "%s\r", plain_b.lines[i]);
+        ok = line_list_push(b, line);
+    }
+    line_list_free(&plain_a);
+    line_list_free(&plain_b);
+    return ok;
+}
+
+static size_t utf8_put(char* out, uint32_t cp) {
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+}
+
+static uint32_t cjk_char(Rng* rng) {
+    int roll = rng_range(rng, 20);
+    if (roll == 0) return 0x3001;                                 // 、
+    if (roll == 1) return 0x3002;                                 // 。
+    if (roll < 6) return 0x3041 + (uint32_t)rng_range(rng, 83);  // Hiragana
+    return 0x4E00 + (uint32_t)rng_range(rng, 3000);              // Common Han
+}
+
+static bool gen_cjk(LineList* a, LineList* b) {
+    Rng rng = {0x7a3b1c9du};
+    char line[256];
+    bool ok = true;
+    for (int i = 0; ok && i < 1500; i++) {
+        int chars = 20 + rng_range(&rng, 40);
+        size_t la = 0, lb = 0;
+        char edited[256];
+        bool edit_line = rng_range(&rng, 10) == 0;
+        for (int c = 0; c < chars; c++) {
+            uint32_t cp = cjk_char(&rng);
+            size_t n = utf8_put(line + la, cp);
+            la += n;
+            if (edit_line && rng_range(&rng, 8) == 0) {
+                lb += utf8_put(edited + lb, cjk_char(&rng));
+            } else {
+                memcpy(edited + lb, line + la - n, n);
+                lb += n;
+            }
+        }
+        line[la] = '\0';
+        edited[lb] = '\0';
+        ok = line_list_push(a, line) && line_list_push(b, edited);
+    }
+    return ok;
+}
+
+// ============================================================================
+// Corpus
+// ============================================================================
+
+enum { CASE_COUNT = 6 };
+
+BenchCase* bench_corpus_create(int* out_count) {
+    static const char* const names[CASE_COUNT] = {
+        "small_edits", "large_rewrite", "reorder", "minified_js", "crlf", "cjk"
+    };
+
+    BenchCase* cases = (BenchCase*)calloc(CASE_COUNT, sizeof(BenchCase));
+    if (!cases) return NULL;
+
+    int built = 0;
+    bool ok = true;
+    for (; ok && built < CASE_COUNT; built++) {
+        LineList a = {0}, b = {0};
+        switch (built) {
+            case 0: ok = gen_small_edits(&a, &b, 0x5eed0001u); break;
+            case 1: ok = gen_large_rewrite(&a, &b); break;
+            case 2: ok = gen_reorder(&a, &b); break;
+            case 3: ok = gen_minified_js(&a, &b); break;
+            case 4: ok = gen_crlf(&a, &b); break;
+            default: ok = gen_cjk(&a, &b); break;
+        }
+
+        BenchCase* c = &cases[built];
+        c->name = names[built];
+        c->original = (const char**)a.lines;
+        c->original_count = a.count;
+        c->modified = (const char**)b.lines;
+        c->modified_count = b.count;
+        c->bytes = side_bytes(&a) + side_bytes(&b);
+        c->options = (DiffOptions){
+            .ignore_trim_whitespace = false,
+            .max_computation_time_ms = 0,
+            .compute_moves = built == 2,
+            .extend_to_subwords = false,
+            .refine_threads = 0,
+            .anchor_unique_lines = false
+        };
+    }
+
+    if (!ok) {
+        bench_corpus_free(cases, built);
+        return NULL;
+    }
+    *out_count = CASE_COUNT;
+    return cases;
+}
+
+void bench_corpus_free(BenchCase* cases, int count) {
+    if (!cases) return;
+    for (int i = 0; i < count; i++) {
+        LineList a = {(char**)cases[i].original, cases[i].original_count, 0};
+        LineList b = {(char**)cases[i].modified, cases[i].modified_count, 0};
+        line_list_free(&a);
+        line_list_free(&b);
+    }
+    free(cases);
+}
@@ -0,0 +1,43 @@
+/**
+ * Benchmark Corpus
+ *
+ * Fixed, generated inputs: every case is produced from a constant seed, so
+ * the same build always measures the same bytes and numbers stay comparable
+ * across releases without checking large files into the repository.
+ *
+ * Cases:
+ * - small_edits:   2000-line source file with scattered one-line edits
+ * - large_rewrite: 2000-line source file with most blocks rewritten
+ * - reorder:       200 functions shuffled (compute_moves on)
+ * - minified_js:   a few ~40 KB lines with edits inside them
+ * - crlf:          small_edits with every line ending in '\r'
+ * - cjk:           1500 lines of Han/kana text with character edits
+ */
+
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include "types.h"
+#include <stddef.h>
+
+typedef struct {
+    const char* name;
+    const char** original;
+    int original_count;
+    const char** modified;
+    int modified_count;
+    DiffOptions options;
+    size_t bytes;           // Total bytes of both sides
+} BenchCase;
+
+/**
+ * Generate every case
+ *
+ * @param out_count Number of cases
+ * @return Cases (free with bench_corpus_free()), or NULL on allocation failure
+ */
+BenchCase* bench_corpus_create(int* out_count);
+
+void bench_corpus_free(BenchCase* cases, int count);
+
+#endif // BENCH_CORPUS_H
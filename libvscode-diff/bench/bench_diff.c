@@ -0,0 +1,331 @@
+// ============================================================================
+// Diff Pipeline Benchmark
+// ============================================================================
+//
+// Usage: bench_diff [--json] [--quick] [--cost-model] [--case <name>]
+//
+// Runs every corpus case (bench_corpus.h) through each pipeline stage and
+// reports, per case and stage:
+//   ns_per_line   wall time per input line (both sides), best of the runs
+//   allocs        allocation calls per run
+//   alloc_bytes   bytes requested per run
+//   peak_rss_kb   process peak RSS after the stage (monotonic across cases)
+//   engines       ranges diffed by each engine (DP / O(ND) / linear-space),
+//                 for the line_alignments and refine_char_level stages
+//
+// Stages:
+//   line_alignments   compute_line_alignments()
+//   refine_char_level refine_diff_char_level() on every line alignment
+//   render_plan       generate_render_plan() on the compute_diff() result
+//   compute_diff      the whole pipeline
+//
+// --json prints one JSON document for tracking numbers across releases.
+// --cost-model selects engines by estimated cost (DiffOptions.cost_model_engine)
+// instead of VSCode's fixed 1700-line / 500-char cutoffs.
+//
+// ============================================================================
+
+#include "bench_alloc.h"
+#include "bench_corpus.h"
+#include "default_lines_diff_computer.h"
+#include "line_level.h"
+#include "char_level.h"
+#include "render_plan.h"
+#include "myers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+// ============================================================================
+// Clock and Memory
+// ============================================================================
+
+static int64_t now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (int64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/** Peak resident set size in KB (-1 if unavailable) */
+static long peak_rss_kb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;         // KB on Linux and the BSDs
+#endif
+#endif
+}
+
+// ============================================================================
+// Stages
+// ============================================================================
+
+typedef struct {
+    const char* name;
+    void (*run)(const BenchCase* c, void* state);
+} Stage;
+
+/** Line alignment options matching compute_diff() for the case */
+static LineAlignmentOptions line_options_for(const BenchCase* c, DiffEngineCounts* counts) {
+    LineAlignmentOptions options = {
+        .anchor_unique_lines = c->options.anchor_unique_lines,
+        .threads = c->options.refine_threads,
+        .linear_space = c->options.linear_space_myers,
+        .engine = {
+            .dp_max_total = c->options.line_dp_max_lines,
+            .cost_model = c->options.cost_model_engine,
+            .dp_max_cells = c->options.dp_max_cells
+        },
+        .engine_counts = counts
+    };
+    return options;
+}
+
+static CharLevelOptions char_options_for(const BenchCase* c, DiffEngineCounts* counts) {
+    CharLevelOptions options = {
+        .consider_whitespace_changes = !c->options.ignore_trim_whitespace,
+        .extend_to_subwords = c->options.extend_to_subwords,
+        .timeout = NULL,
+        .engine = {
+            .dp_max_total = c->options.char_dp_max_chars,
+            .cost_model = c->options.cost_model_engine,
+            .dp_max_cells = c->options.dp_max_cells
+        },
+        .engine_counts = counts,
+        .token_min_chars = c->options.token_refine_min_chars
+    };
+    return options;
+}
+
+static SequenceDiffArray* line_alignments_for(const BenchCase* c, DiffEngineCounts* counts) {
+    LineAlignmentOptions options = line_options_for(c, counts);
+    bool hit_timeout = false;
+    return compute_line_alignments_with_options(c->original, c->original_count,
+                                                c->modified, c->modified_count,
+                                                0, &options, &hit_timeout);
+}
+
+static void run_line_alignments(const BenchCase* c, void* state) {
+    (void)state;
+    free_sequence_diff_array(line_alignments_for(c, NULL));
+}
+
+/** Refinement input: the case's line alignments, computed once */
+static void run_refine_char_level(const BenchCase* c, void* state) {
+    const SequenceDiffArray* diffs = (const SequenceDiffArray*)state;
+    CharLevelOptions options = char_options_for(c, NULL);
+    for (int i = 0; i < diffs->count; i++) {
+        bool hit_timeout = false;
+        RangeMappingArray* mappings = refine_diff_char_level(&diffs->diffs[i],
+                                                             c->original, c->original_count,
+                                                             c->modified, c->modified_count,
+                                                             &options, &hit_timeout);
+        free_range_mapping_array(mappings);
+    }
+}
+
+/** Render plan input: the case's compute_diff() result, computed once */
+static void run_render_plan(const BenchCase* c, void* state) {
+    RenderPlan* plan = generate_render_plan((const LinesDiff*)state,
+                                            c->original, c->original_count,
+                                            c->modified, c->modified_count);
+    free_render_plan(plan);
+}
+
+static void run_compute_diff(const BenchCase* c, void* state) {
+    (void)state;
+    free_lines_diff(compute_diff(c->original, c->original_count,
+                                 c->modified, c->modified_count, &c->options));
+}
+
+static const Stage STAGES[] = {
+    {"line_alignments", run_line_alignments},
+    {"refine_char_level", run_refine_char_level},
+    {"render_plan", run_render_plan},
+    {"compute_diff", run_compute_diff},
+};
+#define STAGE_COUNT ((int)(sizeof(STAGES) / sizeof(STAGES[0])))
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+typedef struct {
+    int iterations;
+    double ns_per_line;
+    double allocs;
+    double alloc_bytes;
+    long peak_rss_kb;
+} StageResult;
+
+/**
+ * Run a stage until min_ns have passed (at least 3 runs, at most 1000) and
+ * keep the fastest run; allocation counts are averaged.
+ */
+static StageResult measure(const Stage* stage, const BenchCase* c, void* state, int64_t min_ns) {
+    StageResult result = {0, 0, 0, 0, 0};
+    int lines = c->original_count + c->modified_count;
+    int64_t best = INT64_MAX;
+    int64_t started = now_ns();
+
+    BenchAllocCounters before = bench_alloc_counters();
+    while (result.iterations < 3 || (now_ns() - started < min_ns && result.iterations < 1000)) {
+        int64_t t0 = now_ns();
+        stage->run(c, state);
+        int64_t elapsed = now_ns() - t0;
+        if (elapsed < best) best = elapsed;
+        result.iterations++;
+    }
+    BenchAllocCounters after = bench_alloc_counters();
+
+    result.ns_per_line = (double)best / (lines > 0 ? lines : 1);
+    result.allocs = (double)(after.allocations - before.allocations) / result.iterations;
+    result.alloc_bytes = (double)(after.bytes - before.bytes) / result.iterations;
+    result.peak_rss_kb = peak_rss_kb();
+    return result;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--json] [--quick] [--cost-model] [--case <name>]\n", program);
+}
+
+/** Engines behind one case's line alignments and their refinement */
+static void count_engines(const BenchCase* c, const SequenceDiffArray* alignments,
+                          DiffEngineCounts* line_counts, DiffEngineCounts* char_counts) {
+    free_sequence_diff_array(line_alignments_for(c, line_counts));
+    CharLevelOptions options = char_options_for(c, char_counts);
+    for (int i = 0; i < alignments->count; i++) {
+        bool hit_timeout = false;
+        free_range_mapping_array(refine_diff_char_level(&alignments->diffs[i],
+                                                        c->original, c->original_count,
+                                                        c->modified, c->modified_count,
+                                                        &options, &hit_timeout));
+    }
+}
+
+static void format_engines(const DiffEngineCounts* counts, char* out, size_t size) {
+    if (!counts) {
+        snprintf(out, size, "-");
+        return;
+    }
+    snprintf(out, size, "%s=%d,%s=%d,%s=%d", diff_engine_name(DIFF_ENGINE_DP), counts->dp,
+             diff_engine_name(DIFF_ENGINE_MYERS), counts->myers,
+             diff_engine_name(DIFF_ENGINE_LINEAR), counts->linear);
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    bool cost_model = false;
+    int64_t min_ns = 300000000;  // 300 ms per stage
+    const char* only = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            min_ns = 20000000;
+        } else if (strcmp(argv[i], "--cost-model") == 0) {
+            cost_model = true;
+        } else if (strcmp(argv[i], "--case") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    bench_alloc_install();
+    int case_count = 0;
+    BenchCase* cases = bench_corpus_create(&case_count);
+    if (!cases) {
+        fprintf(stderr, "Error: cannot generate the corpus\n");
+        return 1;
+    }
+
+    if (json) {
+        printf("{\n  \"version\": \"%s\",\n  \"cost_model\": %s,\n  \"results\": [",
+               get_version(), cost_model ? "true" : "false");
+    } else {
+        printf("%-14s %-18s %8s %8s %6s %12s %12s %14s %12s  %s\n", "case", "stage", "lines", "bytes",
+               "iters", "ns/line", "allocs", "alloc_bytes", "peak_rss_kb", "engines");
+    }
+
+    bool first_record = true;
+    for (int ci = 0; ci < case_count; ci++) {
+        BenchCase* c = &cases[ci];
+        if (only && strcmp(only, c->name) != 0) continue;
+        c->options.cost_model_engine = cost_model;
+
+        // Stage inputs, computed outside the measured runs
+        SequenceDiffArray* alignments = line_alignments_for(c, NULL);
+        LinesDiff* diff = compute_diff(c->original, c->original_count,
+                                       c->modified, c->modified_count, &c->options);
+        if (!alignments || !diff) {
+            fprintf(stderr, "Error: case %s failed\n", c->name);
+            free_sequence_diff_array(alignments);
+            free_lines_diff(diff);
+            bench_corpus_free(cases, case_count);
+            return 1;
+        }
+        void* states[STAGE_COUNT] = {NULL, alignments, diff, NULL};
+        DiffEngineCounts line_counts = {0, 0, 0};
+        DiffEngineCounts char_counts = {0, 0, 0};
+        count_engines(c, alignments, &line_counts, &char_counts);
+        const DiffEngineCounts* stage_counts[STAGE_COUNT] = {&line_counts, &char_counts, NULL, NULL};
+
+        for (int si = 0; si < STAGE_COUNT; si++) {
+            StageResult r = measure(&STAGES[si], c, states[si], min_ns);
+            int lines = c->original_count + c->modified_count;
+            char engines[96];
+            format_engines(stage_counts[si], engines, sizeof(engines));
+            if (json) {
+                printf("%s\n    {\"case\": \"%s\", \"stage\": \"%s\", \"lines\": %d, \"bytes\": %zu, "
+                       "\"iterations\": %d, \"ns_per_line\": %.1f, \"allocs\": %.1f, "
+                       "\"alloc_bytes\": %.0f, \"peak_rss_kb\": %ld, \"engines\": \"%s\"}",
+                       first_record ? "" : ",", c->name, STAGES[si].name, lines, c->bytes,
+                       r.iterations, r.ns_per_line, r.allocs, r.alloc_bytes, r.peak_rss_kb, engines);
+                first_record = false;
+            } else {
+                printf("%-14s %-18s %8d %8zu %6d %12.1f %12.1f %14.0f %12ld  %s\n", c->name, STAGES[si].name,
+                       lines, c->bytes, r.iterations, r.ns_per_line, r.allocs, r.alloc_bytes,
+                       r.peak_rss_kb, engines);
+            }
+            fflush(stdout);
+        }
+
+        free_sequence_diff_array(alignments);
+        free_lines_diff(diff);
+    }
+
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+
+    bench_corpus_free(cases, case_count);
+    return 0;
+}
@@ -7,15 +7,24 @@
 // VSCode Reference:
 //   src/vs/editor/common/diff/defaultLinesDiffComputer/defaultLinesDiffComputer.ts
 //
-// VSCode Parity: 100% (excluding computeMoves)
+// VSCode Parity: 100%
 //
 // ============================================================================
 
+#include "include/default_lines_diff_computer.h"
 #include "include/types.h"
 #include "include/line_level.h"
 #include "include/char_level.h"
 #include "include/range_mapping.h"
 #include "include/utils.h"
+#include "include/platform.h"
+#include "include/arena.h"
+#include "include/diff_allocator.h"
+#include "include/diff_workspace.h"
+#include "include/compute_moved_lines.h"
+#include "include/sequence.h"
+#include "include/string_hash_map.h"
+#include "include/text_lines.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -27,15 +36,19 @@
 static LinesDiff* create_empty_lines_diff(void);
 static LinesDiff* create_full_file_diff(
     const char** original_lines,
+    const int* original_lengths,
     int original_count,
     const char** modified_lines,
+    const int* modified_lengths,
     int modified_count
 );
 static RangeMappingArray* refine_diff(
     const SequenceDiff* diff,
     const char** original_lines,
+    const int* original_lengths,
     int original_count,
     const char** modified_lines,
+    const int* modified_lengths,
     int modified_count,
     Timeout* timeout,
     bool consider_whitespace_changes,
@@ -54,7 +67,7 @@ static RangeMappingArray* refine_diff(
  * VSCode Parity: 100%
  */
 static LinesDiff* create_empty_lines_diff(void) {
-    LinesDiff* result = (LinesDiff*)malloc(sizeof(LinesDiff));
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
     if (!result) return NULL;
     
     result->changes.mappings = NULL;
@@ -66,6 +79,7 @@ static LinesDiff* create_empty_lines_diff(void) {
     result->moves.capacity = 0;
     
     result->hit_timeout = false;
+    result->hit_memory_limit = false;
     
     return result;
 }
@@ -80,17 +94,19 @@ static LinesDiff* create_empty_lines_diff(void) {
  */
 static LinesDiff* create_full_file_diff(
     const char** original_lines,
+    const int* original_lengths,
     int original_count,
     const char** modified_lines,
+    const int* modified_lengths,
     int modified_count
 ) {
-    LinesDiff* result = (LinesDiff*)malloc(sizeof(LinesDiff));
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
     if (!result) return NULL;
     
     // Allocate one DetailedLineRangeMapping
-    result->changes.mappings = (DetailedLineRangeMapping*)malloc(sizeof(DetailedLineRangeMapping));
+    result->changes.mappings = (DetailedLineRangeMapping*)diff_malloc(sizeof(DetailedLineRangeMapping));
     if (!result->changes.mappings) {
-        free(result);
+        diff_free(result);
         return NULL;
     }
     result->changes.count = 1;
@@ -103,10 +119,10 @@ static LinesDiff* create_full_file_diff(
     result->changes.mappings[0].modified.end_line = modified_count + 1;
     
     // Create one RangeMapping for the entire content
-    result->changes.mappings[0].inner_changes = (RangeMapping*)malloc(sizeof(RangeMapping));
+    result->changes.mappings[0].inner_changes = (RangeMapping*)diff_malloc(sizeof(RangeMapping));
     if (!result->changes.mappings[0].inner_changes) {
-        free(result->changes.mappings);
-        free(result);
+        diff_free(result->changes.mappings);
+        diff_free(result);
         return NULL;
     }
     result->changes.mappings[0].inner_change_count = 1;
@@ -117,7 +133,7 @@ static LinesDiff* create_full_file_diff(
     result->changes.mappings[0].inner_changes[0].original.end_line = original_count;
     if (original_count > 0) {
         result->changes.mappings[0].inner_changes[0].original.end_col = 
-            strlen(original_lines[original_count - 1]) + 1;
+            diff_line_length(original_lines, original_lengths, original_count - 1) + 1;
     } else {
         result->changes.mappings[0].inner_changes[0].original.end_col = 1;
     }
@@ -128,7 +144,7 @@ static LinesDiff* create_full_file_diff(
     result->changes.mappings[0].inner_changes[0].modified.end_line = modified_count;
     if (modified_count > 0) {
         result->changes.mappings[0].inner_changes[0].modified.end_col = 
-            strlen(modified_lines[modified_count - 1]) + 1;
+            diff_line_length(modified_lines, modified_lengths, modified_count - 1) + 1;
     } else {
         result->changes.mappings[0].inner_changes[0].modified.end_col = 1;
     }
@@ -139,6 +155,7 @@ static LinesDiff* create_full_file_diff(
     result->moves.capacity = 0;
     
     result->hit_timeout = false;
+    result->hit_memory_limit = false;
     
     return result;
 }
@@ -149,11 +166,13 @@ static LinesDiff* create_full_file_diff(
  * VSCode Reference: equals() from arrays.js
  * VSCode Parity: 100%
  */
-static bool arrays_equal(const char** a, int a_len, const char** b, int b_len) {
+static bool arrays_equal(const char** a, const int* a_lengths, int a_len,
+                         const char** b, const int* b_lengths, int b_len) {
     if (a_len != b_len) return false;
     
     for (int i = 0; i < a_len; i++) {
-        if (strcmp(a[i], b[i]) != 0) {
+        if (!diff_lines_equal(a[i], diff_line_length(a, a_lengths, i),
+                              b[i], diff_line_length(b, b_lengths, i))) {
             return false;
         }
     }
@@ -167,8 +186,10 @@ static bool arrays_equal(const char** a, int a_len, const char** b, int b_len) {
  * 
  * @param diff Line-level diff to refine
  * @param original_lines Original file lines
+ * @param original_lengths Byte length of each original line (NULL = NUL-terminated)
  * @param original_count Number of original lines
  * @param modified_lines Modified file lines
+ * @param modified_lengths Byte length of each modified line (NULL = NUL-terminated)
  * @param modified_count Number of modified lines
  * @param timeout Timeout for computation
  * @param consider_whitespace_changes If true, include whitespace changes
@@ -182,26 +203,41 @@ static bool arrays_equal(const char** a, int a_len, const char** b, int b_len) {
 static RangeMappingArray* refine_diff(
     const SequenceDiff* diff,
     const char** original_lines,
+    const int* original_lengths,
     int original_count,
     const char** modified_lines,
+    const int* modified_lengths,
     int modified_count,
     Timeout* timeout,
     bool consider_whitespace_changes,
     const DiffOptions* options,
     bool* hit_timeout
 ) {
-    (void)timeout;  // timeout handled inside refine_diff_char_level
-    
     // Call our existing refine_diff_char_level function
-    CharLevelOptions char_opts;
-    char_opts.consider_whitespace_changes = consider_whitespace_changes;
-    char_opts.extend_to_subwords = options->extend_to_subwords;
+    // The shared timeout bounds the whole refinement phase, not each hunk
+    CharLevelOptions char_opts = {
+        .consider_whitespace_changes = consider_whitespace_changes,
+        .extend_to_subwords = options->extend_to_subwords,
+        .timeout = timeout,
+        .engine = {
+            .dp_max_total = options->char_dp_max_chars,
+            .cost_model = options->cost_model_engine,
+            .dp_max_cells = options->dp_max_cells
+        },
+        .token_min_chars = options->token_refine_min_chars
+    };
+    
+    DiffStats* stats = diff_get_thread_stats();
+    if (stats) {
+        char_opts.engine_counts = &stats->char_engines;
+        stats->hunks_refined++;
+    }
     
     bool local_timeout = false;
-    RangeMappingArray* result = refine_diff_char_level(
+    RangeMappingArray* result = refine_diff_char_level_n(
         diff,
-        original_lines, original_count,
-        modified_lines, modified_count,
+        original_lines, original_lengths, original_count,
+        modified_lines, modified_lengths, modified_count,
         &char_opts,
         &local_timeout
     );
@@ -213,52 +249,89 @@ static RangeMappingArray* refine_diff(
     return result;
 }
 
+// ============================================================================
+// Refinement Tasks
+// ============================================================================
+//
+// Every region that needs char-level refinement (changed hunks and
+// whitespace-only line changes) becomes a RefineTask, collected in output
+// order. Tasks are independent, so they can run sequentially or on a small
+// worker pool; results are always merged back in task order, which keeps the
+// output identical to the sequential VSCode loop.
+//
+// ============================================================================
+
+typedef struct {
+    SequenceDiff diff;
+    RangeMappingArray* result;
+    bool hit_timeout;
+} RefineTask;
+
+typedef struct {
+    RefineTask* tasks;
+    int count;
+    int capacity;
+} RefineTaskArray;
+
+static bool refine_task_array_push(RefineTaskArray* arr, SequenceDiff diff) {
+    if (arr->count >= arr->capacity) {
+        int new_capacity = arr->capacity == 0 ? 16 : arr->capacity * 2;
+        RefineTask* new_tasks = (RefineTask*)diff_realloc(arr->tasks, new_capacity * sizeof(RefineTask));
+        if (!new_tasks) return false;
+        arr->tasks = new_tasks;
+        arr->capacity = new_capacity;
+    }
+    arr->tasks[arr->count].diff = diff;
+    arr->tasks[arr->count].result = NULL;
+    arr->tasks[arr->count].hit_timeout = false;
+    arr->count++;
+    return true;
+}
+
 /**
  * Scan equal-length line regions for whitespace-only changes.
  * 
  * When two lines have the same hash (trimmed content) but different actual
- * content, they differ only in whitespace. This function detects and refines
- * such differences.
+ * content, they differ only in whitespace. Each such line pair is queued as
+ * a single-line refinement task.
  * 
  * @param equal_lines_count Number of equal lines to scan
  * @param seq1_last_start Current position in original lines
  * @param seq2_last_start Current position in modified lines
  * @param original_lines Original file lines
- * @param original_count Number of original lines
+ * @param original_lengths Byte length of each original line (NULL = NUL-terminated)
  * @param modified_lines Modified file lines
- * @param modified_count Number of modified lines
+ * @param modified_lengths Byte length of each modified line (NULL = NUL-terminated)
  * @param consider_whitespace_changes If false, skip scanning
- * @param timeout Timeout for computation
- * @param options Diff options
- * @param alignments Output: accumulate RangeMappings here
- * @param hit_timeout Output: set to true if any refinement times out
+ * @param tasks Output: queue refinement tasks here
+ * @return false on allocation failure
  * 
  * VSCode Reference: defaultLinesDiffComputer.ts scanForWhitespaceChanges() lines 100-118
  * VSCode Parity: 100%
  */
-static void scan_for_whitespace_changes(
+static bool scan_for_whitespace_changes(
     int equal_lines_count,
     int seq1_last_start,
     int seq2_last_start,
     const char** original_lines,
-    int original_count,
+    const int* original_lengths,
     const char** modified_lines,
-    int modified_count,
+    const int* modified_lengths,
     bool consider_whitespace_changes,
-    Timeout* timeout,
-    const DiffOptions* options,
-    RangeMappingArray* alignments,
-    bool* hit_timeout
+    RefineTaskArray* tasks
 ) {
     if (!consider_whitespace_changes) {
-        return;
+        return true;
     }
     
     for (int i = 0; i < equal_lines_count; i++) {
         int seq1_offset = seq1_last_start + i;
         int seq2_offset = seq2_last_start + i;
         
-        if (strcmp(original_lines[seq1_offset], modified_lines[seq2_offset]) != 0) {
+        if (!diff_lines_equal(original_lines[seq1_offset],
+                              diff_line_length(original_lines, original_lengths, seq1_offset),
+                              modified_lines[seq2_offset],
+                              diff_line_length(modified_lines, modified_lengths, seq2_offset))) {
             // This is because of whitespace changes, diff these lines
             SequenceDiff line_diff = {
                 .seq1_start = seq1_offset,
@@ -266,47 +339,305 @@ static void scan_for_whitespace_changes(
                 .seq2_start = seq2_offset,
                 .seq2_end = seq2_offset + 1
             };
-            
-            bool local_timeout = false;
-            RangeMappingArray* character_diffs = refine_diff(
-                &line_diff,
-                original_lines, original_count,
-                modified_lines, modified_count,
-                timeout,
-                consider_whitespace_changes,
-                options,
-                &local_timeout
-            );
-            
-            if (character_diffs) {
-                // Add all mappings to alignments array
-                for (int j = 0; j < character_diffs->count; j++) {
-                    // Grow alignments array if needed
-                    if (alignments->count >= alignments->capacity) {
-                        size_t new_capacity = alignments->capacity == 0 ? 8 : alignments->capacity * 2;
-                        RangeMapping* new_mappings = (RangeMapping*)realloc(
-                            alignments->mappings,
-                            new_capacity * sizeof(RangeMapping)
-                        );
-                        if (new_mappings) {
-                            alignments->mappings = new_mappings;
-                            alignments->capacity = new_capacity;
-                        }
-                    }
-                    
-                    if (alignments->count < alignments->capacity) {
-                        alignments->mappings[alignments->count++] = character_diffs->mappings[j];
-                    }
-                }
-                
-                range_mapping_array_free(character_diffs);
-            }
-            
-            if (local_timeout) {
-                *hit_timeout = true;
+            if (!refine_task_array_push(tasks, line_diff)) {
+                return false;
             }
         }
     }
+    return true;
+}
+
+/**
+ * Shared state for the refinement worker pool.
+ * Inputs are read-only; each task's output slot is written by one worker.
+ */
+typedef struct {
+    RefineTask* tasks;
+    int task_count;
+    int next_task;            // Guarded by lock
+    diff_mutex_t lock;
+    
+    const char** original_lines;
+    const int* original_lengths;      // NULL = NUL-terminated lines
+    int original_count;
+    const char** modified_lines;
+    const int* modified_lengths;
+    int modified_count;
+    Timeout* timeout;
+    bool consider_whitespace_changes;
+    const DiffOptions* options;
+    DiffMemoryBudget* memory_budget;  // compute_diff()'s budget, forwarded to workers
+    DiffStats* stats;                 // compute_diff()'s statistics (NULL = none)
+    DiffWorkspace* workspace;         // compute_diff()'s workspace (NULL = none)
+} RefineQueue;
+
+/**
+ * Refine one task. All intermediates go to the worker's scratch arena, which
+ * is rewound first; only the returned RangeMappingArray lives on the heap.
+ */
+static void run_refine_task(RefineQueue* queue, RefineTask* task, DiffArena* arena) {
+    DiffArena* previous = NULL;
+    if (arena) {
+        diff_arena_reset(arena);
+        previous = diff_scratch_begin(arena);
+    }
+    
+    task->result = refine_diff(
+        &task->diff,
+        queue->original_lines, queue->original_lengths, queue->original_count,
+        queue->modified_lines, queue->modified_lengths, queue->modified_count,
+        queue->timeout,
+        queue->consider_whitespace_changes,
+        queue->options,
+        &task->hit_timeout
+    );
+    
+    if (arena) {
+        diff_scratch_end(previous);
+    }
+}
+
+static void* refine_worker(void* arg) {
+    RefineQueue* queue = (RefineQueue*)arg;
+    // Timeouts the worker starts itself must see the caller's cancellation
+    diff_set_thread_cancel_flag(queue->timeout->cancel);
+    diff_set_thread_memory_budget(queue->memory_budget);
+    // Counters go to a private copy, merged once the queue is drained
+    DiffStats local_stats;
+    memset(&local_stats, 0, sizeof(local_stats));
+    DiffStats* previous_stats = diff_get_thread_stats();
+    diff_set_thread_stats(queue->stats ? &local_stats : NULL);
+    // One arena per worker for the whole compute_diff call (NULL = heap)
+    DiffArena* arena = diff_workspace_acquire_arena(queue->workspace);
+    for (;;) {
+        diff_mutex_lock(&queue->lock);
+        int idx = queue->next_task++;
+        diff_mutex_unlock(&queue->lock);
+        
+        if (idx >= queue->task_count) break;
+        run_refine_task(queue, &queue->tasks[idx], arena);
+    }
+    diff_workspace_release_arena(queue->workspace, arena);
+    diff_set_thread_stats(previous_stats);
+    if (queue->stats) {
+        diff_mutex_lock(&queue->lock);
+        diff_stats_merge(queue->stats, &local_stats);
+        diff_mutex_unlock(&queue->lock);
+    }
+    return NULL;
+}
+
+/** Upper bound on refinement workers, regardless of DiffOptions */
+#define MAX_REFINE_THREADS 64
+
+/**
+ * Refine all tasks, on options->refine_threads workers when > 1.
+ * 
+ * The calling thread always participates, so if no worker can be started
+ * the tasks still complete sequentially.
+ */
+static void run_refine_tasks(RefineQueue* queue) {
+    int thread_count = queue->options->refine_threads;
+    if (thread_count > MAX_REFINE_THREADS) thread_count = MAX_REFINE_THREADS;
+    if (thread_count > queue->task_count) thread_count = queue->task_count;
+    
+    if (thread_count <= 1) {
+        DiffArena* arena = queue->task_count > 0
+            ? diff_workspace_acquire_arena(queue->workspace) : NULL;
+        for (int i = 0; i < queue->task_count; i++) {
+            run_refine_task(queue, &queue->tasks[i], arena);
+        }
+        diff_workspace_release_arena(queue->workspace, arena);
+        return;
+    }
+    
+    diff_thread_t threads[MAX_REFINE_THREADS];
+    int started = 0;
+    
+    queue->next_task = 0;
+    diff_mutex_init(&queue->lock);
+    
+    // thread_count - 1 workers plus the calling thread
+    for (int i = 0; i < thread_count - 1; i++) {
+        if (!diff_thread_create(&threads[started], refine_worker, queue)) break;
+        started++;
+    }
+    refine_worker(queue);
+    
+    for (int i = 0; i < started; i++) {
+        diff_thread_join(&threads[i]);
+    }
+    diff_mutex_destroy(&queue->lock);
+}
+
+// ============================================================================
+// Moved Blocks
+// ============================================================================
+
+/**
+ * Free the moves and their per-move changes (not the array struct itself).
+ */
+static void free_moved_text_array_contents(MovedTextArray* moves) {
+    if (!moves->moves) return;
+    
+    for (int i = 0; i < moves->count; i++) {
+        MovedText* move = &moves->moves[i];
+        for (int j = 0; j < move->change_count; j++) {
+            diff_free(move->changes[j].inner_changes);
+        }
+        diff_free(move->changes);
+    }
+    diff_free(moves->moves);
+}
+
+/**
+ * NUL-terminated copies of lines of known length, for move detection, which
+ * still works on C strings (not VSCode). All copies share one block, returned
+ * in *out_block; a line's embedded NULs end its copy early.
+ * 
+ * @return array of count line pointers (NULL on allocation failure)
+ */
+static const char** terminated_lines_create(const char** lines, const int* lengths, int count,
+                                            char** out_block) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += (size_t)lengths[i] + 1;
+    }
+    const char** copies = (const char**)diff_malloc(sizeof(char*) * (size_t)(count > 0 ? count : 1));
+    char* block = (char*)diff_malloc(total > 0 ? total : 1);
+    if (!copies || !block) {
+        diff_free(copies);
+        diff_free(block);
+        return NULL;
+    }
+    char* cursor = block;
+    for (int i = 0; i < count; i++) {
+        if (lengths[i] > 0) memcpy(cursor, lines[i], (size_t)lengths[i]);
+        cursor[lengths[i]] = '\0';
+        copies[i] = cursor;
+        cursor += lengths[i] + 1;
+    }
+    *out_block = block;
+    return copies;
+}
+
+/**
+ * Detect moved blocks and diff each one against its new location.
+ * 
+ * @param changes Final line-level changes
+ * @param timeout Shared diff timeout
+ * @param moves Output: moves with their changes filled in
+ * 
+ * VSCode Reference: defaultLinesDiffComputer.ts computeMoves() lines 179-211
+ * VSCode Parity: 100%
+ */
+static void compute_moves(
+    const DetailedLineRangeMappingArray* changes,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    Timeout* timeout,
+    bool consider_whitespace_changes,
+    const DiffOptions* options,
+    MovedTextArray* moves
+) {
+    moves->moves = NULL;
+    moves->count = 0;
+    moves->capacity = 0;
+    
+    // hashedOriginalLines / hashedModifiedLines: trimmed-line IDs from one map
+    DiffWorkspace* workspace = diff_get_thread_workspace();
+    StringHashMap* hash_map = diff_workspace_acquire_hash_map(workspace);
+    ISequence* original_seq = line_sequence_create_n(original_lines, original_lengths, original_count,
+                                                     true, hash_map);
+    ISequence* modified_seq = line_sequence_create_n(modified_lines, modified_lengths, modified_count,
+                                                     true, hash_map);
+    diff_workspace_release_hash_map(workspace, hash_map);
+    
+    // Lines of known length need not be terminated: detect on terminated copies
+    char* original_block = NULL;
+    char* modified_block = NULL;
+    const char** original_terminated = original_lines;
+    const char** modified_terminated = modified_lines;
+    if (original_lengths) {
+        original_terminated = terminated_lines_create(original_lines, original_lengths,
+                                                      original_count, &original_block);
+    }
+    if (modified_lengths) {
+        modified_terminated = terminated_lines_create(modified_lines, modified_lengths,
+                                                      modified_count, &modified_block);
+    }
+    
+    if (original_terminated && modified_terminated) {
+        compute_moved_lines(
+            changes,
+            original_terminated, original_count,
+            modified_terminated, modified_count,
+            original_seq->getElements(original_seq),
+            modified_seq->getElements(modified_seq),
+            timeout,
+            moves
+        );
+    }
+    if (original_lengths) {
+        diff_free((void*)original_terminated);
+        diff_free(original_block);
+    }
+    if (modified_lengths) {
+        diff_free((void*)modified_terminated);
+        diff_free(modified_block);
+    }
+    original_seq->destroy(original_seq);
+    modified_seq->destroy(modified_seq);
+    
+    DiffArena* arena = moves->count > 0 ? diff_workspace_acquire_arena(workspace) : NULL;
+    for (int i = 0; i < moves->count; i++) {
+        MovedText* move = &moves->moves[i];
+        SequenceDiff move_diff = {
+            .seq1_start = move->original.start_line - 1,
+            .seq1_end = move->original.end_line - 1,
+            .seq2_start = move->modified.start_line - 1,
+            .seq2_end = move->modified.end_line - 1
+        };
+        
+        DiffArena* previous = NULL;
+        if (arena) {
+            diff_arena_reset(arena);
+            previous = diff_scratch_begin(arena);
+        }
+        // VSCode ignores the refinement's hitTimeout for moves
+        bool move_hit_timeout = false;
+        RangeMappingArray* move_changes = refine_diff(
+            &move_diff,
+            original_lines, original_lengths, original_count,
+            modified_lines, modified_lengths, modified_count,
+            timeout,
+            consider_whitespace_changes,
+            options,
+            &move_hit_timeout
+        );
+        if (arena) {
+            diff_scratch_end(previous);
+        }
+        if (!move_changes) continue;
+        
+        DetailedLineRangeMappingArray* mappings = line_range_mapping_from_range_mappings_n(
+            move_changes,
+            original_lines, original_lengths, original_count,
+            modified_lines, modified_lengths, modified_count,
+            true  // dontAssertStartLine
+        );
+        range_mapping_array_free(move_changes);
+        if (mappings) {
+            move->changes = mappings->mappings;
+            move->change_count = mappings->count;
+            diff_free(mappings);  // Free the container, not the contents
+        }
+    }
+    diff_workspace_release_arena(workspace, arena);
 }
 
 // ============================================================================
@@ -327,49 +658,337 @@ static void scan_for_whitespace_changes(
  * @return LinesDiff structure containing changes and metadata
  * 
  * VSCode Reference: defaultLinesDiffComputer.ts computeDiff() lines 31-174
- * VSCode Parity: 100% (excluding computeMoves)
+ * VSCode Parity: 100%
  * 
  * Notable differences from VSCode:
- * - No computeMoves implementation (Neovim UI limitation)
  * - No assertion validation (can be added later if needed)
  */
+static LinesDiff* compute_diff_steps(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options,
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide prepared_side
+);
+
+static LinesDiff* compute_diff_run(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options,
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide prepared_side
+);
+
 LinesDiff* compute_diff(
     const char** original_lines,
     int original_count,
     const char** modified_lines,
     int modified_count,
     const DiffOptions* options
+) {
+    return compute_diff_n(original_lines, NULL, original_count,
+                          modified_lines, NULL, modified_count, options);
+}
+
+/**
+ * compute_diff() for lines of known byte length (not VSCode).
+ * 
+ * The lengths travel with the lines through every step, so no step has to
+ * rediscover them with strlen; NULL lengths means NUL-terminated lines.
+ */
+LinesDiff* compute_diff_n(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+) {
+    return compute_diff_run(original_lines, original_lengths, original_count,
+                            modified_lines, modified_lengths, modified_count, options,
+                            NULL, DIFF_PREPARED_ORIGINAL);
+}
+
+/**
+ * compute_diff_n() on a workspace (not VSCode).
+ * 
+ * The workspace is installed for the calling thread, where every step that
+ * allocates working memory picks it up (refinement workers get it through
+ * their queue).
+ */
+LinesDiff* compute_diff_ex(
+    DiffWorkspace* workspace,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+) {
+    DiffWorkspace* previous = diff_get_thread_workspace();
+    diff_set_thread_workspace(workspace);
+    LinesDiff* result = compute_diff_n(original_lines, original_lengths, original_count,
+                                       modified_lines, modified_lengths, modified_count,
+                                       options);
+    diff_set_thread_workspace(previous);
+    return result;
+}
+
+/**
+ * compute_diff_n() body: memory budget and stats around the steps.
+ * prepared (NULL = none) is the already-hashed side named by prepared_side.
+ */
+static LinesDiff* compute_diff_run(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options,
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide prepared_side
+) {
+    int64_t start_ns = diff_stats_clock_ns();
+    LinesDiff* result;
+    if (options->max_memory_bytes <= 0) {
+        result = compute_diff_steps(original_lines, original_lengths, original_count,
+                                    modified_lines, modified_lengths, modified_count, options,
+                                    prepared, prepared_side);
+    } else {
+        // Not VSCode: steps degrade instead of exceeding max_memory_bytes
+        DiffMemoryBudget budget;
+        diff_memory_budget_init(&budget, options->max_memory_bytes);
+        DiffMemoryBudget* previous = diff_get_thread_memory_budget();
+        diff_set_thread_memory_budget(&budget);
+        result = compute_diff_steps(original_lines, original_lengths, original_count,
+                                    modified_lines, modified_lengths, modified_count, options,
+                                    prepared, prepared_side);
+        diff_set_thread_memory_budget(previous);
+        if (result) {
+            result->hit_memory_limit = diff_memory_budget_exceeded(&budget);
+        }
+    }
+    
+    DiffStats* stats = diff_get_thread_stats();
+    if (stats) {
+        stats->total_ns += get_current_time_ns() - start_ns;
+        if (result) {
+            stats->hit_timeout = stats->hit_timeout || result->hit_timeout;
+            stats->hit_memory_limit = stats->hit_memory_limit || result->hit_memory_limit;
+        }
+    }
+    return result;
+}
+
+/**
+ * compute_diff() on two text blobs (not VSCode).
+ * 
+ * Each side is split at '\n' into views of the caller's buffer, so no line
+ * is copied or measured twice (see text_lines.h for the split semantics).
+ */
+LinesDiff* compute_diff_text(
+    const char* original_text,
+    size_t original_len,
+    const char* modified_text,
+    size_t modified_len,
+    const DiffOptions* options
+) {
+    TextLines original;
+    TextLines modified;
+    if (!text_lines_split(original_text, original_len, &original)) {
+        return NULL;
+    }
+    if (!text_lines_split(modified_text, modified_len, &modified)) {
+        text_lines_free(&original);
+        return NULL;
+    }
+    
+    LinesDiff* result = compute_diff_n(original.lines, original.lengths, original.count,
+                                       modified.lines, modified.lengths, modified.count, options);
+    text_lines_free(&original);
+    text_lines_free(&modified);
+    return result;
+}
+
+// ============================================================================
+// Prepared Side (not VSCode)
+// ============================================================================
+
+struct DiffPreparedLines {
+    const char** lines;        // Caller's lines (not owned)
+    const int* lengths;        // Byte length per line (the sequence's own table)
+    int count;
+    PreparedLineSequence line; // Trimmed-line hashes and their frozen map
+};
+
+DiffPreparedLines* diff_prepared_lines_create(const char** lines, const int* lengths, int count) {
+    DiffPreparedLines* prepared = (DiffPreparedLines*)diff_malloc(sizeof(DiffPreparedLines));
+    if (!prepared) {
+        return NULL;
+    }
+    if (!prepared_line_sequence_init(&prepared->line, lines, lengths, count)) {
+        diff_free(prepared);
+        return NULL;
+    }
+    prepared->lines = lines;
+    prepared->lengths = ((const LineSequence*)prepared->line.sequence->data)->line_lengths;
+    prepared->count = count;
+    return prepared;
+}
+
+void diff_prepared_lines_destroy(DiffPreparedLines* prepared) {
+    if (!prepared) {
+        return;
+    }
+    prepared_line_sequence_free(&prepared->line);
+    diff_free(prepared);
+}
+
+/**
+ * compute_diff_n() with one side prepared (not VSCode).
+ * 
+ * Every step runs exactly as in compute_diff_n(); only the line hashing of
+ * the prepared side is skipped, and its measured lengths are reused.
+ */
+LinesDiff* compute_diff_prepared(
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide side,
+    const char** other_lines,
+    const int* other_lengths,
+    int other_count,
+    const DiffOptions* options
+) {
+    if (!prepared || !other_lines || !options) {
+        return NULL;
+    }
+    if (side == DIFF_PREPARED_ORIGINAL) {
+        return compute_diff_run(prepared->lines, prepared->lengths, prepared->count,
+                                other_lines, other_lengths, other_count, options,
+                                prepared, side);
+    }
+    return compute_diff_run(other_lines, other_lengths, other_count,
+                            prepared->lines, prepared->lengths, prepared->count, options,
+                            prepared, side);
+}
+
+/**
+ * compute_diff() collecting where the time went into stats (not VSCode).
+ * 
+ * Statistics already being collected on the calling thread are suspended
+ * for the call, so stats only describes this diff.
+ */
+LinesDiff* compute_diff_with_stats(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    DiffStats* stats
+) {
+    return compute_diff_n_with_stats(original_lines, NULL, original_count,
+                                     modified_lines, NULL, modified_count,
+                                     options, stats);
+}
+
+LinesDiff* compute_diff_n_with_stats(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options,
+    DiffStats* stats
+) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    DiffStats* previous = diff_get_thread_stats();
+    diff_set_thread_stats(stats);
+    LinesDiff* result = compute_diff_n(original_lines, original_lengths, original_count,
+                                       modified_lines, modified_lengths, modified_count,
+                                       options);
+    diff_set_thread_stats(previous);
+    return result;
+}
+
+static LinesDiff* compute_diff_steps(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options,
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide prepared_side
 ) {
     // Early exit: 0-1 lines and equal
-    if (original_count <= 1 && arrays_equal(original_lines, original_count, 
-                                            modified_lines, modified_count)) {
+    if (original_count <= 1 && arrays_equal(original_lines, original_lengths, original_count,
+                                            modified_lines, modified_lengths, modified_count)) {
         return create_empty_lines_diff();
     }
     
     // Early exit: single empty line
-    if ((original_count == 1 && strlen(original_lines[0]) == 0) ||
-        (modified_count == 1 && strlen(modified_lines[0]) == 0)) {
-        return create_full_file_diff(original_lines, original_count,
-                                     modified_lines, modified_count);
+    if ((original_count == 1 && diff_line_length(original_lines, original_lengths, 0) == 0) ||
+        (modified_count == 1 && diff_line_length(modified_lines, modified_lengths, 0) == 0)) {
+        return create_full_file_diff(original_lines, original_lengths, original_count,
+                                     modified_lines, modified_lengths, modified_count);
     }
     
     // Setup timeout
     Timeout timeout;
-    timeout.timeout_ms = options->max_computation_time_ms;
-    timeout.start_time_ms = get_current_time_ms();
+    timeout_init(&timeout, options->max_computation_time_ms);
     
     bool consider_whitespace_changes = !options->ignore_trim_whitespace;
     
     // Line-level diff
     // Use our compute_line_alignments which internally selects DP (<1700 lines) or Myers
+    // (optionally anchored on unique lines for large files)
     // VSCode Reference: defaultLinesDiffComputer.ts lines 66-77
     bool line_hit_timeout = false;
-    SequenceDiffArray* line_alignments = compute_line_alignments(
-        original_lines, original_count,
-        modified_lines, modified_count,
-        timeout.timeout_ms,
-        &line_hit_timeout
-    );
+    LineAlignmentOptions line_options = {
+        .anchor_unique_lines = options->anchor_unique_lines,
+        .threads = options->refine_threads,
+        .linear_space = options->linear_space_myers,
+        .engine = {
+            .dp_max_total = options->line_dp_max_lines,
+            .cost_model = options->cost_model_engine,
+            .dp_max_cells = options->dp_max_cells
+        }
+    };
+    DiffStats* stats = diff_get_thread_stats();
+    if (stats) line_options.engine_counts = &stats->line_engines;
+    SequenceDiffArray* line_alignments;
+    if (!prepared) {
+        line_alignments = compute_line_alignments_n(
+            original_lines, original_lengths, original_count,
+            modified_lines, modified_lengths, modified_count,
+            timeout.timeout_ms,
+            &line_options,
+            &line_hit_timeout
+        );
+    } else if (prepared_side == DIFF_PREPARED_ORIGINAL) {
+        // Not VSCode: only the modified side is hashed here
+        line_alignments = compute_line_alignments_prepared(
+            &prepared->line, true,
+            modified_lines, modified_lengths, modified_count,
+            timeout.timeout_ms, &line_options, &line_hit_timeout);
+    } else {
+        line_alignments = compute_line_alignments_prepared(
+            &prepared->line, false,
+            original_lines, original_lengths, original_count,
+            timeout.timeout_ms, &line_options, &line_hit_timeout);
+    }
     bool hit_timeout = line_hit_timeout;
     
     if (!line_alignments) {
@@ -379,64 +998,100 @@ LinesDiff* compute_diff(
     // Optimize line diffs (already done inside compute_line_diff)
     // No need to call optimize_sequence_diffs or remove_very_short_matching_lines_between_diffs
     
-    // Initialize character mappings array
-    RangeMappingArray* alignments = (RangeMappingArray*)malloc(sizeof(RangeMappingArray));
-    if (!alignments) {
-        sequence_diff_array_free(line_alignments);
-        return NULL;
-    }
-    alignments->mappings = NULL;
-    alignments->count = 0;
-    alignments->capacity = 0;
-    
-    // Character refinement loop
+    // Collect refinement tasks in output order
+    RefineTaskArray tasks = {NULL, 0, 0};
+    bool tasks_ok = true;
     int seq1_last_start = 0;
     int seq2_last_start = 0;
     
-    for (int diff_idx = 0; diff_idx < line_alignments->count; diff_idx++) {
+    for (int diff_idx = 0; diff_idx < line_alignments->count && tasks_ok; diff_idx++) {
         const SequenceDiff* diff = &line_alignments->diffs[diff_idx];
         
         int equal_lines_count = diff->seq1_start - seq1_last_start;
         
         // Scan equal lines for whitespace changes
-        scan_for_whitespace_changes(
+        tasks_ok = scan_for_whitespace_changes(
             equal_lines_count,
             seq1_last_start,
             seq2_last_start,
-            original_lines, original_count,
-            modified_lines, modified_count,
+            original_lines,
+            original_lengths,
+            modified_lines,
+            modified_lengths,
             consider_whitespace_changes,
-            &timeout,
-            options,
-            alignments,
-            &hit_timeout
+            &tasks
         );
         
         seq1_last_start = diff->seq1_end;
         seq2_last_start = diff->seq2_end;
         
         // Refine this diff region
-        bool local_timeout = false;
-        RangeMappingArray* character_diffs = refine_diff(
-            diff,
-            original_lines, original_count,
-            modified_lines, modified_count,
-            &timeout,
-            consider_whitespace_changes,
-            options,
-            &local_timeout
-        );
+        tasks_ok = tasks_ok && refine_task_array_push(&tasks, *diff);
+    }
+    
+    // Scan remaining equal lines
+    int remaining = original_count - seq1_last_start;
+    tasks_ok = tasks_ok && scan_for_whitespace_changes(
+        remaining,
+        seq1_last_start,
+        seq2_last_start,
+        original_lines,
+        original_lengths,
+        modified_lines,
+        modified_lengths,
+        consider_whitespace_changes,
+        &tasks
+    );
+    
+    // Initialize character mappings array
+    RangeMappingArray* alignments = (RangeMappingArray*)diff_malloc(sizeof(RangeMappingArray));
+    if (!tasks_ok || !alignments) {
+        diff_free(alignments);
+        diff_free(tasks.tasks);
+        sequence_diff_array_free(line_alignments);
+        return NULL;
+    }
+    alignments->mappings = NULL;
+    alignments->count = 0;
+    alignments->capacity = 0;
+    
+    // Character refinement (sequential or on the worker pool)
+    RefineQueue queue = {
+        .tasks = tasks.tasks,
+        .task_count = tasks.count,
+        .next_task = 0,
+        .original_lines = original_lines,
+        .original_lengths = original_lengths,
+        .original_count = original_count,
+        .modified_lines = modified_lines,
+        .modified_lengths = modified_lengths,
+        .modified_count = modified_count,
+        .timeout = &timeout,
+        .consider_whitespace_changes = consider_whitespace_changes,
+        .options = options,
+        .memory_budget = diff_get_thread_memory_budget(),
+        .stats = diff_get_thread_stats(),
+        .workspace = diff_get_thread_workspace()
+    };
+    DiffPhaseStart phase_start = diff_stats_phase_start();
+    run_refine_tasks(&queue);
+    diff_stats_add_phase(DIFF_PHASE_CHAR_REFINE, phase_start);
+    
+    // Merge results in task order (deterministic regardless of threading)
+    for (int t = 0; t < tasks.count; t++) {
+        RefineTask* task = &tasks.tasks[t];
         
-        if (local_timeout) {
+        if (task->hit_timeout) {
             hit_timeout = true;
         }
         
+        RangeMappingArray* character_diffs = task->result;
         if (character_diffs) {
             // Add all character mappings
             for (int j = 0; j < character_diffs->count; j++) {
                 if (alignments->count >= alignments->capacity) {
                     size_t new_capacity = alignments->capacity == 0 ? 16 : alignments->capacity * 2;
-                    RangeMapping* new_mappings = (RangeMapping*)realloc(
+                    RangeMapping* new_mappings = (RangeMapping*)diff_realloc(
                         alignments->mappings,
                         new_capacity * sizeof(RangeMapping)
                     );
@@ -454,48 +1109,38 @@ LinesDiff* compute_diff(
             range_mapping_array_free(character_diffs);
         }
     }
-    
-    // Scan remaining equal lines
-    int remaining = original_count - seq1_last_start;
-    scan_for_whitespace_changes(
-        remaining,
-        seq1_last_start,
-        seq2_last_start,
-        original_lines, original_count,
-        modified_lines, modified_count,
-        consider_whitespace_changes,
-        &timeout,
-        options,
-        alignments,
-        &hit_timeout
-    );
+    diff_free(tasks.tasks);
     
     // Convert to line mappings
-    DetailedLineRangeMappingArray* changes = line_range_mapping_from_range_mappings(
+    phase_start = diff_stats_phase_start();
+    DetailedLineRangeMappingArray* changes = line_range_mapping_from_range_mappings_n(
         alignments,
-        original_lines, original_count,
-        modified_lines, modified_count,
+        original_lines, original_lengths, original_count,
+        modified_lines, modified_lengths, modified_count,
         false  // dontAssertStartLine
     );
+    diff_stats_add_phase(DIFF_PHASE_LINE_MAPPING, phase_start);
     
     // VSCode: if (options.computeMoves) { moves = this.computeMoves(...); }
-    //
-    // SKIPPED: computeMoves is not implemented
-    //
-    // Reason: Neovim does not support moved block visualization in UI.
-    // The computeMoves algorithm exists in VSCode at:
-    //   src/vs/editor/common/diff/defaultLinesDiffComputer/computeMovedLines.ts
-    //
-    // When UI support is added, implement:
-    // 1. Port computeMovedLines() function
-    // 2. Port refineDiff for moved blocks
-    // 3. Populate moves array instead of leaving it empty
-    //
-    // For now, always return empty moves array.
+    MovedTextArray moves = {NULL, 0, 0};
+    if (options->compute_moves && changes) {
+        phase_start = diff_stats_phase_start();
+        compute_moves(
+            changes,
+            original_lines, original_lengths, original_count,
+            modified_lines, modified_lengths, modified_count,
+            &timeout,
+            consider_whitespace_changes,
+            options,
+            &moves
+        );
+        diff_stats_add_phase(DIFF_PHASE_MOVES, phase_start);
+    }
     
     // Create LinesDiff result
-    LinesDiff* result = (LinesDiff*)malloc(sizeof(LinesDiff));
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
     if (!result) {
+        free_moved_text_array_contents(&moves);
         free_detailed_line_range_mapping_array(changes);
         range_mapping_array_free(alignments);
         sequence_diff_array_free(line_alignments);
@@ -505,19 +1150,17 @@ LinesDiff* compute_diff(
     // Transfer changes
     if (changes) {
         result->changes = *changes;
-        free(changes);  // Free the container, not the contents
+        diff_free(changes);  // Free the container, not the contents
     } else {
         result->changes.mappings = NULL;
         result->changes.count = 0;
         result->changes.capacity = 0;
     }
     
-    // No moves
-    result->moves.moves = NULL;
-    result->moves.count = 0;
-    result->moves.capacity = 0;
+    result->moves = moves;
     
     result->hit_timeout = hit_timeout;
+    result->hit_memory_limit = false;  // Set by compute_diff()
     
     // Cleanup
     range_mapping_array_free(alignments);
@@ -537,17 +1180,15 @@ void free_lines_diff(LinesDiff* diff) {
     if (diff->changes.mappings) {
         for (int i = 0; i < diff->changes.count; i++) {
             if (diff->changes.mappings[i].inner_changes) {
-                free(diff->changes.mappings[i].inner_changes);
+                diff_free(diff->changes.mappings[i].inner_changes);
             }
         }
-        free(diff->changes.mappings);
+        diff_free(diff->changes.mappings);
     }
     
-    if (diff->moves.moves) {
-        free(diff->moves.moves);
-    }
+    free_moved_text_array_contents(&diff->moves);
     
-    free(diff);
+    diff_free(diff);
 }
 
 /**
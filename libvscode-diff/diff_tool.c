@@ -2,196 +2,605 @@
 // Diff Tool - Standalone executable for computing and displaying diffs
 // ============================================================================
 //
-// Usage: diff_tool <original_file> <modified_file>
+// Usage: diff_tool [options] <original_file> <modified_file>
+//        diff_tool [options] --manifest <file>
 //
 // This tool:
-// 1. Reads two files from disk
-// 2. Uses compute_diff() to compute their LinesDiff
-// 3. Uses print_utils to print the results
+// 1. Maps both files into memory (read() fallback for pipes, stdin and
+//    Windows) and splits them into zero-copy line views
+// 2. Uses compute_diff_n() to compute their LinesDiff
+// 3. Prints the results through print_utils, as compact JSON, or as packed
+//    binary records
+//
+// Options:
+//   --json                    One JSON object per file pair, one per line
+//   --binary                  One packed record per file pair on stdout (see
+//                             write_packed_lines_diff(); an empty record for
+//                             a pair that failed)
+//   --repeat <n>              Diff every pair n times (benchmarking)
+//   --stats                   Report per-phase timings over the runs
+//   --manifest <file>         Diff every "original<TAB>modified" pair listed
+//                             in <file> ("-" = stdin) in this one process.
+//                             Blank lines and lines starting with '#' are
+//                             skipped.
+//   --ignore-trim-whitespace  DiffOptions.ignore_trim_whitespace
+//   --compute-moves           DiffOptions.compute_moves
+//   --timeout <ms>            DiffOptions.max_computation_time_ms
+//   --token-refine <chars>    DiffOptions.token_refine_min_chars
+//
+// A file name of "-" reads stdin. Exit status is 1 when any pair failed.
 //
 // ============================================================================
 
 #include "include/default_lines_diff_computer.h"
+#include "include/packed_lines_diff.h"
 #include "include/print_utils.h"
+#include "include/text_lines.h"
 #include "include/types.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 // ============================================================================
-// File Reading Utilities
+// File Input
 // ============================================================================
 
 /**
- * Read lines from a file into a dynamically allocated array.
- * Returns the number of lines read, or -1 on error.
- * 
- * IMPORTANT: Matches JavaScript's split('\n') behavior:
- *   - "a\nb\nc".split('\n') -> ["a", "b", "c"] (3 lines)
- *   - "a\nb\nc\n".split('\n') -> ["a", "b", "c", ""] (4 lines with trailing empty)
- *   - Keeps '\r' if present (doesn't strip it like fgets does)
+ * A file's bytes: mapped read-only, read into a heap buffer, or empty.
  */
-static int read_file_lines(const char* filename, char*** lines_out) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
-        return -1;
-    }
-    
-    // Read entire file content
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    char* content = (char*)malloc(file_size + 1);
-    if (!content) {
-        fclose(file);
-        return -1;
-    }
-    
-    size_t bytes_read = fread(content, 1, file_size, file);
-    content[bytes_read] = '\0';
-    fclose(file);
-    
-    // Count lines by counting '\n' characters (matching JavaScript split('\n'))
-    // This matches: "a\nb\nc".split('\n') -> ["a", "b", "c"] (3 lines)
-    //               "a\nb\nc\n".split('\n') -> ["a", "b", "c", ""] (4 lines)
-    int line_count = 1;  // At least one line (even empty file has 1 empty line)
-    for (size_t i = 0; i < bytes_read; i++) {
-        if (content[i] == '\n') {
-            line_count++;
+typedef struct {
+    const char* data;
+    size_t len;
+    bool mapped;        // data came from mmap() and is unmapped on close
+    bool owned;         // data is a heap buffer and is freed on close
+} InputFile;
+
+/**
+ * Read a whole stream into a growing heap buffer (pipes, stdin, Windows).
+ */
+static bool read_stream(FILE* stream, InputFile* file) {
+    size_t capacity = 64 * 1024;
+    size_t len = 0;
+    char* data = (char*)malloc(capacity);
+    if (!data) return false;
+
+    for (;;) {
+        if (len == capacity) {
+            char* grown = (char*)realloc(data, capacity * 2);
+            if (!grown) {
+                free(data);
+                return false;
+            }
+            data = grown;
+            capacity *= 2;
         }
+        size_t n = fread(data + len, 1, capacity - len, stream);
+        len += n;
+        if (n == 0) break;
     }
-    
-    // Allocate lines array
-    char** lines = (char**)malloc(line_count * sizeof(char*));
-    if (!lines) {
-        free(content);
-        return -1;
-    }
-    
-    // Split by '\n' only, keeping '\r' if present (matching JavaScript behavior)
-    // JavaScript: "line1\r\nline2\r\n".split('\n') -> ["line1\r", "line2\r", ""]
-    int line_idx = 0;
-    size_t line_start = 0;
-    
-    for (size_t i = 0; i <= bytes_read; i++) {
-        if (i == bytes_read || content[i] == '\n') {
-            // Extract line: everything from line_start to current position (excluding '\n')
-            size_t line_len = i - line_start;
-            
-            lines[line_idx] = (char*)malloc(line_len + 1);
-            if (!lines[line_idx]) {
-                for (int j = 0; j < line_idx; j++) {
-                    free(lines[j]);
-                }
-                free(lines);
-                free(content);
-                return -1;
-            }
-            
-            memcpy(lines[line_idx], content + line_start, line_len);
-            lines[line_idx][line_len] = '\0';
-            line_idx++;
-            line_start = i + 1;
+    if (ferror(stream)) {
+        free(data);
+        return false;
+    }
+
+    file->data = data;
+    file->len = len;
+    file->mapped = false;
+    file->owned = true;
+    return true;
+}
+
+/**
+ * Open a file for diffing ("-" = stdin).
+ * Regular files are mmap()ed; anything mmap() refuses is read instead.
+ */
+static bool input_file_open(const char* filename, InputFile* file) {
+    if (strcmp(filename, "-") == 0) {
+        if (!read_stream(stdin, file)) {
+            fprintf(stderr, "Error: Cannot read stdin\n");
+            return false;
+        }
+        return true;
+    }
+
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) {
+            // mmap() rejects empty mappings
+            close(fd);
+            file->data = "";
+            file->len = 0;
+            file->mapped = false;
+            file->owned = false;
+            return true;
         }
+        void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            file->data = (const char*)data;
+            file->len = (size_t)st.st_size;
+            file->mapped = true;
+            file->owned = false;
+            return true;
+        }
+    }
+
+    // Pipe, FIFO or a file system without mmap: read it
+    FILE* stream = fdopen(fd, "rb");
+    if (!stream) {
+        close(fd);
+        fprintf(stderr, "Error: Cannot read file '%s'\n", filename);
+        return false;
+    }
+#else
+    FILE* stream = fopen(filename, "rb");
+    if (!stream) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        return false;
+    }
+#endif
+
+    bool ok = read_stream(stream, file);
+    fclose(stream);
+    if (!ok) {
+        fprintf(stderr, "Error: Cannot read file '%s'\n", filename);
+    }
+    return ok;
+}
+
+static void input_file_close(InputFile* file) {
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap((void*)file->data, file->len);
+    }
+#endif
+    if (file->owned) {
+        free((void*)file->data);
     }
-    
-    free(content);
-    *lines_out = lines;
-    return line_count;
+}
+
+// ============================================================================
+// Timing
+// ============================================================================
+
+static int64_t now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (int64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
 }
 
 /**
- * Free lines array.
+ * DiffStats of the last run plus timings over all --repeat runs.
  */
-static void free_lines(char** lines, int count) {
-    if (!lines) return;
-    for (int i = 0; i < count; i++) {
-        free(lines[i]);
+typedef struct {
+    DiffStats last;
+    int runs;
+    int64_t phase_ns_sum[DIFF_PHASE_COUNT];
+    int64_t total_ns_min;
+    int64_t total_ns_sum;
+} RunStats;
+
+static const char* const PHASE_NAMES[DIFF_PHASE_COUNT] = {
+    "line_hash", "line_diff", "line_optimize", "char_refine", "line_mapping", "moves", "render_plan",
+};
+
+static void run_stats_add(RunStats* stats, const DiffStats* run, int64_t wall_ns) {
+    stats->last = *run;
+    for (int p = 0; p < DIFF_PHASE_COUNT; p++) {
+        stats->phase_ns_sum[p] += run->phase_ns[p];
+    }
+    if (stats->runs == 0 || wall_ns < stats->total_ns_min) {
+        stats->total_ns_min = wall_ns;
     }
-    free(lines);
+    stats->total_ns_sum += wall_ns;
+    stats->runs++;
 }
 
 // ============================================================================
-// Main Program
+// JSON Output
 // ============================================================================
 
-int main(int argc, char* argv[]) {
-    // Check arguments
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <original_file> <modified_file>\n", argv[0]);
-        return 1;
+static void print_json_string(const char* s) {
+    putchar('"');
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            printf("\\%c", *p);
+        } else if (*p < 0x20) {
+            printf("\\u%04x", *p);
+        } else {
+            putchar(*p);
+        }
     }
-    
-    const char* original_file = argv[1];
-    const char* modified_file = argv[2];
-    
-    // Read original file
-    char** original_lines = NULL;
-    int original_count = read_file_lines(original_file, &original_lines);
-    if (original_count < 0) {
-        return 1;
+    putchar('"');
+}
+
+static void print_json_char_range(const CharRange* r) {
+    printf("%d,%d,%d,%d", r->start_line, r->start_col, r->end_line, r->end_col);
+}
+
+/**
+ * [{"original":[start,end],"modified":[start,end],"inner":[[8 ints]...]}...]
+ * Inner changes are [orig start_line, start_col, end_line, end_col, then the
+ * same for modified]; lines and columns 1-based, ends exclusive.
+ */
+static void print_json_changes(const DetailedLineRangeMapping* changes, int count) {
+    putchar('[');
+    for (int i = 0; i < count; i++) {
+        const DetailedLineRangeMapping* m = &changes[i];
+        printf("%s{\"original\":[%d,%d],\"modified\":[%d,%d],\"inner\":[", i ? "," : "",
+               m->original.start_line, m->original.end_line,
+               m->modified.start_line, m->modified.end_line);
+        for (int j = 0; j < m->inner_change_count; j++) {
+            printf("%s[", j ? "," : "");
+            print_json_char_range(&m->inner_changes[j].original);
+            putchar(',');
+            print_json_char_range(&m->inner_changes[j].modified);
+            putchar(']');
+        }
+        printf("]}");
     }
-    
-    // Read modified file
-    char** modified_lines = NULL;
-    int modified_count = read_file_lines(modified_file, &modified_lines);
-    if (modified_count < 0) {
-        free_lines(original_lines, original_count);
-        return 1;
+    putchar(']');
+}
+
+static void print_json_stats(const RunStats* stats) {
+    const DiffStats* s = &stats->last;
+    printf(",\"stats\":{\"runs\":%d,\"total_ns_min\":%lld,\"total_ns_mean\":%lld,\"phase_ns_mean\":{",
+           stats->runs, (long long)stats->total_ns_min,
+           (long long)(stats->total_ns_sum / stats->runs));
+    for (int p = 0; p < DIFF_PHASE_COUNT; p++) {
+        printf("%s\"%s\":%lld", p ? "," : "", PHASE_NAMES[p],
+               (long long)(stats->phase_ns_sum[p] / stats->runs));
+    }
+    printf("},\"line_engines\":{\"dp\":%d,\"myers\":%d,\"linear\":%d}"
+           ",\"char_engines\":{\"dp\":%d,\"myers\":%d,\"linear\":%d}"
+           ",\"dp_cells\":%lld,\"myers_max_d\":%d,\"hunks_refined\":%d"
+           ",\"scratch_allocations\":%lld,\"scratch_bytes\":%lld"
+           ",\"heap_allocations\":%lld,\"heap_bytes\":%lld,\"phase_heap_bytes\":{",
+           s->line_engines.dp, s->line_engines.myers, s->line_engines.linear,
+           s->char_engines.dp, s->char_engines.myers, s->char_engines.linear,
+           (long long)s->dp_cells, s->myers_max_d, s->hunks_refined,
+           (long long)s->scratch_allocations, (long long)s->scratch_bytes,
+           (long long)s->heap_allocations, (long long)s->heap_bytes);
+    for (int p = 0; p < DIFF_PHASE_COUNT; p++) {
+        printf("%s\"%s\":%lld", p ? "," : "", PHASE_NAMES[p], (long long)s->phase_heap_bytes[p]);
+    }
+    printf("}}");
+}
+
+static void print_json_result(const char* original_file, const char* modified_file,
+                              const LinesDiff* diff, const RunStats* stats) {
+    printf("{\"original\":");
+    print_json_string(original_file);
+    printf(",\"modified\":");
+    print_json_string(modified_file);
+    if (!diff) {
+        printf(",\"error\":\"failed\"}\n");
+        return;
+    }
+
+    printf(",\"changes\":");
+    print_json_changes(diff->changes.mappings, diff->changes.count);
+    printf(",\"moves\":[");
+    for (int i = 0; i < diff->moves.count; i++) {
+        const MovedText* move = &diff->moves.moves[i];
+        printf("%s{\"original\":[%d,%d],\"modified\":[%d,%d],\"changes\":", i ? "," : "",
+               move->original.start_line, move->original.end_line,
+               move->modified.start_line, move->modified.end_line);
+        print_json_changes(move->changes, move->change_count);
+        putchar('}');
+    }
+    printf("],\"hit_timeout\":%s,\"hit_memory_limit\":%s",
+           diff->hit_timeout ? "true" : "false",
+           diff->hit_memory_limit ? "true" : "false");
+    if (stats) {
+        print_json_stats(stats);
+    }
+    printf("}\n");
+}
+
+// ============================================================================
+// Text Output
+// ============================================================================
+
+static void print_text_stats(const RunStats* stats) {
+    const DiffStats* s = &stats->last;
+    printf("Stats (%d run%s):\n", stats->runs, stats->runs == 1 ? "" : "s");
+    printf("  %-14s min  %10.3f ms   mean %10.3f ms\n", "total",
+           (double)stats->total_ns_min / 1e6,
+           (double)stats->total_ns_sum / stats->runs / 1e6);
+    for (int p = 0; p < DIFF_PHASE_COUNT; p++) {
+        printf("  %-14s mean %10.3f ms   heap %lld allocations, %lld bytes\n", PHASE_NAMES[p],
+               (double)stats->phase_ns_sum[p] / stats->runs / 1e6,
+               (long long)s->phase_heap_allocations[p], (long long)s->phase_heap_bytes[p]);
     }
-    
+    printf("  line engines   dp %d, myers %d, linear %d\n",
+           s->line_engines.dp, s->line_engines.myers, s->line_engines.linear);
+    printf("  char engines   dp %d, myers %d, linear %d\n",
+           s->char_engines.dp, s->char_engines.myers, s->char_engines.linear);
+    printf("  dp cells %lld, myers max d %d, hunks refined %d\n",
+           (long long)s->dp_cells, s->myers_max_d, s->hunks_refined);
+    printf("  scratch %lld allocations, %lld bytes\n",
+           (long long)s->scratch_allocations, (long long)s->scratch_bytes);
+    printf("  heap    %lld allocations, %lld bytes\n",
+           (long long)s->heap_allocations, (long long)s->heap_bytes);
+}
+
+static void print_text_result(const char* original_file, const char* modified_file,
+                              int original_count, int modified_count,
+                              const LinesDiff* diff, const RunStats* stats) {
     printf("=================================================================\n");
     printf("Diff Tool - Computing differences\n");
     printf("=================================================================\n");
     printf("Original: %s (%d lines)\n", original_file, original_count);
     printf("Modified: %s (%d lines)\n", modified_file, modified_count);
     printf("=================================================================\n\n");
-    
-    // Set up diff options
-    DiffOptions options = {
-        .ignore_trim_whitespace = false,
-        .max_computation_time_ms = 0,  // No timeout
-        .compute_moves = false,
-        .extend_to_subwords = false
-    };
-    
-    // Compute diff
-    LinesDiff* diff = compute_diff(
-        (const char**)original_lines,
-        original_count,
-        (const char**)modified_lines,
-        modified_count,
-        &options
-    );
-    
-    if (!diff) {
-        fprintf(stderr, "Error: Failed to compute diff\n");
-        free_lines(original_lines, original_count);
-        free_lines(modified_lines, modified_count);
-        return 1;
-    }
-    
-    // Print the results
+
     printf("Diff Results:\n");
     printf("=================================================================\n");
     printf("Number of changes: %d\n", diff->changes.count);
     printf("Hit timeout: %s\n", diff->hit_timeout ? "yes" : "no");
     printf("\n");
-    
+
     if (diff->changes.count > 0) {
         print_detailed_line_range_mapping_array("Changes", &diff->changes);
     } else {
         printf("No differences found - files are identical.\n");
     }
-    
+
+    if (stats) {
+        printf("\n");
+        print_text_stats(stats);
+    }
+
     printf("\n=================================================================\n");
-    
-    // Cleanup
+}
+
+/**
+ * Write one packed record to stdout; a NULL diff writes an empty record.
+ */
+static void print_binary_result(const LinesDiff* diff) {
+    PackedLinesDiff* packed = diff ? pack_lines_diff(diff) : NULL;
+    static const uint8_t no_bytes[1] = { 0 };
+    PackedLinesDiff empty = { 0, no_bytes };
+    if (!write_packed_lines_diff(packed ? packed : &empty, stdout)) {
+        fprintf(stderr, "Error: Failed to write binary result\n");
+    }
+    free_packed_lines_diff(packed);
+}
+
+// ============================================================================
+// Main Program
+// ============================================================================
+
+typedef struct {
+    DiffOptions options;
+    bool json;
+    bool binary;
+    bool stats;
+    int repeat;
+} ToolConfig;
+
+/**
+ * Diff one file pair and print the result. Returns false on any error.
+ */
+static bool diff_pair(const ToolConfig* config, const char* original_file,
+                      const char* modified_file) {
+    InputFile original_input, modified_input;
+    if (!input_file_open(original_file, &original_input)) {
+        if (config->json) print_json_result(original_file, modified_file, NULL, NULL);
+        if (config->binary) print_binary_result(NULL);
+        return false;
+    }
+    if (!input_file_open(modified_file, &modified_input)) {
+        input_file_close(&original_input);
+        if (config->json) print_json_result(original_file, modified_file, NULL, NULL);
+        if (config->binary) print_binary_result(NULL);
+        return false;
+    }
+
+    TextLines original_lines, modified_lines;
+    bool split = text_lines_split(original_input.data, original_input.len, &original_lines);
+    if (split && !text_lines_split(modified_input.data, modified_input.len, &modified_lines)) {
+        text_lines_free(&original_lines);
+        split = false;
+    }
+
+    LinesDiff* diff = NULL;
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (int run = 0; split && run < config->repeat; run++) {
+        free_lines_diff(diff);
+        DiffStats run_stats;
+        int64_t start = now_ns();
+        diff = compute_diff_n_with_stats(
+            original_lines.lines, original_lines.lengths, original_lines.count,
+            modified_lines.lines, modified_lines.lengths, modified_lines.count,
+            &config->options, config->stats ? &run_stats : NULL);
+        int64_t wall_ns = now_ns() - start;
+        if (!diff) break;
+        if (config->stats) run_stats_add(&stats, &run_stats, wall_ns);
+    }
+
+    if (!diff) {
+        fprintf(stderr, "Error: Failed to compute diff of '%s' and '%s'\n",
+                original_file, modified_file);
+    }
+    if (config->binary) {
+        print_binary_result(diff);
+    } else if (config->json) {
+        print_json_result(original_file, modified_file, diff, config->stats ? &stats : NULL);
+    } else if (diff) {
+        print_text_result(original_file, modified_file, original_lines.count,
+                          modified_lines.count, diff, config->stats ? &stats : NULL);
+    }
+
     free_lines_diff(diff);
-    free_lines(original_lines, original_count);
-    free_lines(modified_lines, modified_count);
-    
-    return 0;
+    if (split) {
+        text_lines_free(&original_lines);
+        text_lines_free(&modified_lines);
+    }
+    input_file_close(&original_input);
+    input_file_close(&modified_input);
+    return diff != NULL;
+}
+
+/**
+ * Split a manifest line into its two tab-separated paths, in place.
+ * Returns false for lines to skip (blank, comments) or malformed ones.
+ */
+static bool parse_manifest_line(char* line, char** original_file, char** modified_file) {
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\r') {
+        line[--len] = '\0';
+    }
+    if (len == 0 || line[0] == '#') {
+        return false;
+    }
+    char* tab = strchr(line, '\t');
+    if (!tab || tab == line || tab[1] == '\0') {
+        fprintf(stderr, "Warning: Skipping malformed manifest line '%s'\n", line);
+        return false;
+    }
+    *tab = '\0';
+    *original_file = line;
+    *modified_file = tab + 1;
+    return true;
+}
+
+static bool diff_manifest(const ToolConfig* config, const char* manifest_file) {
+    InputFile manifest;
+    if (!input_file_open(manifest_file, &manifest)) {
+        return false;
+    }
+    TextLines entries;
+    if (!text_lines_split(manifest.data, manifest.len, &entries)) {
+        input_file_close(&manifest);
+        return false;
+    }
+
+    bool all_ok = true;
+    int pairs = 0;
+    int failed = 0;
+    int64_t start = now_ns();
+    char* line = NULL;
+    size_t line_capacity = 0;
+    for (int i = 0; i < entries.count; i++) {
+        // Paths are used as C strings, so copy each entry out of the view
+        size_t len = (size_t)entries.lengths[i];
+        if (len + 1 > line_capacity) {
+            char* grown = (char*)realloc(line, len + 1);
+            if (!grown) {
+                all_ok = false;
+                break;
+            }
+            line = grown;
+            line_capacity = len + 1;
+        }
+        memcpy(line, entries.lines[i], len);
+        line[len] = '\0';
+
+        char* original_file;
+        char* modified_file;
+        if (!parse_manifest_line(line, &original_file, &modified_file)) {
+            continue;
+        }
+        pairs++;
+        if (!diff_pair(config, original_file, modified_file)) {
+            failed++;
+            all_ok = false;
+        }
+    }
+    free(line);
+
+    if (config->stats) {
+        fprintf(stderr, "Manifest: %d pair%s, %d failed, %.3f ms\n",
+                pairs, pairs == 1 ? "" : "s", failed, (double)(now_ns() - start) / 1e6);
+    }
+    text_lines_free(&entries);
+    input_file_close(&manifest);
+    return all_ok;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options] <original_file> <modified_file>\n"
+            "       %s [options] --manifest <file>\n"
+            "Options: --json --binary --repeat <n> --stats --ignore-trim-whitespace\n"
+            "         --compute-moves --timeout <ms> --token-refine <chars>\n",
+            program, program);
+}
+
+int main(int argc, char* argv[]) {
+    ToolConfig config;
+    memset(&config, 0, sizeof(config));
+    config.repeat = 1;
+
+    const char* manifest_file = NULL;
+    const char* files[2];
+    int file_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            config.json = true;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            config.binary = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            config.stats = true;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            config.repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            manifest_file = argv[++i];
+        } else if (strcmp(argv[i], "--ignore-trim-whitespace") == 0) {
+            config.options.ignore_trim_whitespace = true;
+        } else if (strcmp(argv[i], "--compute-moves") == 0) {
+            config.options.compute_moves = true;
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            config.options.max_computation_time_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--token-refine") == 0 && i + 1 < argc) {
+            config.options.token_refine_min_chars = atoi(argv[++i]);
+        } else if ((argv[i][0] != '-' || argv[i][1] == '\0') && file_count < 2) {
+            files[file_count++] = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.repeat < 1 || (manifest_file ? file_count != 0 : file_count != 2)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+#ifdef _WIN32
+    if (config.binary) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    bool ok = manifest_file ? diff_manifest(&config, manifest_file)
+                            : diff_pair(&config, files[0], files[1]);
+    return ok ? 0 : 1;
 }
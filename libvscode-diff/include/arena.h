@@ -0,0 +1,85 @@
+/**
+ * Bump/Arena Allocator for Per-Diff Scratch Memory
+ *
+ * NOT a general-purpose allocator. One compute_diff() call produces thousands
+ * of short-lived intermediates during char-level refinement (CharSequence
+ * buffers, SequenceDiffArrays from Myers and the optimization passes, word
+ * extension copies). None of them outlive the hunk being refined, so they are
+ * carved out of large blocks instead of individual malloc() calls.
+ *
+ * Two layers:
+ * 1. DiffArena - chained blocks with bump allocation; reset/destroy are O(blocks)
+ * 2. Scratch API (diff_scratch_*) - malloc/realloc/free drop-ins used by the
+ *    refinement code. They allocate from the arena installed on the calling
+ *    thread, or fall back to the C heap when none is installed. free() is a
+ *    no-op inside an arena; memory comes back on reset/destroy.
+ *
+ * Ownership rule: a pointer from diff_scratch_* must be released with
+ * diff_scratch_free() in the same scope it was allocated in. Results that
+ * leave the scope (e.g. the RangeMappingArray returned per hunk) use malloc().
+ *
+ * Lifecycle: each refinement worker owns one arena for the duration of a
+ * compute_diff() call and resets it between hunks.
+ * Thread safety: arenas are single-threaded; the installed arena is per thread.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct DiffArena DiffArena;
+
+/**
+ * Create an arena
+ *
+ * @param block_size Size of each block in bytes (0 = default, 64 KB).
+ *                   Larger requests get a dedicated block.
+ * @return New arena, or NULL on allocation failure
+ */
+DiffArena* diff_arena_create(size_t block_size);
+
+/**
+ * Allocate size bytes (16-byte aligned) from the arena
+ * @return Pointer valid until the next reset/destroy, or NULL on failure
+ */
+void* diff_arena_alloc(DiffArena* arena, size_t size);
+
+/**
+ * Release every allocation at once, keeping blocks for reuse
+ */
+void diff_arena_reset(DiffArena* arena);
+
+/**
+ * Destroy the arena and all its blocks
+ */
+void diff_arena_destroy(DiffArena* arena);
+
+/**
+ * Total bytes reserved by the arena's blocks
+ */
+size_t diff_arena_capacity(const DiffArena* arena);
+
+// ============================================================================
+// Scratch API (thread-local arena, heap fallback)
+// ============================================================================
+
+/**
+ * Install arena as the calling thread's scratch allocator
+ *
+ * @param arena Arena to install (NULL = use the C heap)
+ * @return Previously installed arena; pass it to diff_scratch_end()
+ */
+DiffArena* diff_scratch_begin(DiffArena* arena);
+
+/**
+ * Restore the scratch allocator returned by diff_scratch_begin()
+ */
+void diff_scratch_end(DiffArena* previous);
+
+void* diff_scratch_malloc(size_t size);
+void* diff_scratch_calloc(size_t count, size_t size);
+void* diff_scratch_realloc(void* ptr, size_t size);
+void diff_scratch_free(void* ptr);
+
+#endif // ARENA_H
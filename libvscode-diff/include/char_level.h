@@ -2,6 +2,7 @@
 #define CHAR_LEVEL_H
 
 #include "types.h"
+#include "diff_workspace.h"
 
 /**
  * Step 4: Character-Level Refinement - FULL VSCODE PARITY
@@ -27,6 +28,17 @@
 typedef struct {
     bool consider_whitespace_changes;  // If false, trim whitespace
     bool extend_to_subwords;           // If true, extend to CamelCase subwords
+    const Timeout* timeout;            // Shared compute_diff budget (NULL = infinite)
+    DiffEngineThresholds engine;       // DP vs O(ND) selection (zero = VSCode's 500-char cutoff)
+    DiffEngineCounts* engine_counts;   // Output: engines that ran are added here (NULL = not reported)
+    /**
+     * Diff hunks of at least this many elements (both sides together) token
+     * first: words, whitespace runs and single other characters, then
+     * characters only inside changed tokens (0 = never). NOT part of VSCode:
+     * makes long minified lines tractable, but placements can differ from a
+     * plain character diff.
+     */
+    int token_min_chars;
 } CharLevelOptions;
 
 /**
@@ -48,6 +60,10 @@ typedef struct {
  * 7. removeVeryShortMatchingTextBetweenLongDiffs(slice1, slice2, diffs)
  * 8. Translate character offsets to Range positions
  * 
+ * Timeout: options->timeout is the budget shared by the whole diff. Once it
+ * is exhausted, the region falls back to a single whole-range mapping and
+ * out_hit_timeout is set (VSCode: DiffAlgorithmResult.trivial).
+ * 
  * @param line_diff Single line-level diff region to refine
  * @param lines_a Original file lines
  * @param len_a Number of lines in original
@@ -65,6 +81,33 @@ RangeMappingArray* refine_diff_char_level(
     bool* out_hit_timeout
 );
 
+/**
+ * refine_diff_char_level for lines of known byte length
+ * (lengths may be NULL for NUL-terminated lines; see line_sequence_create_n)
+ */
+RangeMappingArray* refine_diff_char_level_n(
+    const SequenceDiff* line_diff,
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    const CharLevelOptions* options,
+    bool* out_hit_timeout
+);
+
+/**
+ * refine_diff_char_level_n with its working memory in workspace
+ * (NULL = heap, same as refine_diff_char_level_n)
+ * 
+ * Not VSCode: see diff_workspace.h.
+ */
+RangeMappingArray* refine_diff_char_level_ex(
+    DiffWorkspace* workspace,
+    const SequenceDiff* line_diff,
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    const CharLevelOptions* options,
+    bool* out_hit_timeout
+);
+
 /**
  * Refine all line-level diffs to character-level - VSCode Parity
  * 
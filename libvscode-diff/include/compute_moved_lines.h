@@ -0,0 +1,57 @@
+/**
+ * Moved Block Detection
+ *
+ * Finds blocks of lines that were moved between the original and modified
+ * file, given the line-level changes of a finished diff. Runs after
+ * char-level refinement when DiffOptions.compute_moves is set.
+ *
+ * Two sources of moves, as in VSCode:
+ * 1. A pure deletion paired with a pure insertion whose character histograms
+ *    are more than 90% similar
+ * 2. Runs of 3+ identical lines (by trimmed-line hash) inside any remaining
+ *    changes, found through an index of 3-line hash windows instead of a
+ *    pairwise scan, then extended up/down over similar lines
+ *
+ * Close moves are joined, short ones dropped, and moves whose both sides fall
+ * inside the same change are removed.
+ *
+ * VSCode Reference: src/vs/editor/common/diff/defaultLinesDiffComputer/computeMovedLines.ts
+ */
+
+#ifndef COMPUTE_MOVED_LINES_H
+#define COMPUTE_MOVED_LINES_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Compute moved line blocks
+ *
+ * @param changes Line-level changes of the diff (sorted, as produced by compute_diff)
+ * @param original_lines Original file lines
+ * @param original_count Number of original lines
+ * @param modified_lines Modified file lines
+ * @param modified_count Number of modified lines
+ * @param hashed_original Trimmed-line IDs of the original lines
+ * @param hashed_modified Trimmed-line IDs of the modified lines (same ID space)
+ * @param timeout Shared diff timeout (no moves are reported once it expires)
+ * @param out Output: moves sorted by original start, with changes = NULL
+ * @return false on allocation failure (out is left empty)
+ *
+ * VSCode Reference: computeMovedLines.ts computeMovedLines()
+ * VSCode Parity: 100% (trim() uses ASCII whitespace, as everywhere in this library)
+ */
+bool compute_moved_lines(
+    const DetailedLineRangeMappingArray* changes,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const uint32_t* hashed_original,
+    const uint32_t* hashed_modified,
+    const Timeout* timeout,
+    MovedTextArray* out
+);
+
+#endif // COMPUTE_MOVED_LINES_H
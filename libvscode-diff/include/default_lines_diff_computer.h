@@ -2,6 +2,8 @@
 #define DEFAULT_LINES_DIFF_COMPUTER_H
 
 #include "types.h"
+#include "diff_workspace.h"
+#include <stddef.h>
 
 /**
  * Compute diff between two files.
@@ -27,6 +29,164 @@ LinesDiff* compute_diff(
     const DiffOptions* options
 );
 
+/**
+ * compute_diff() for lines of known byte length.
+ * 
+ * original_lengths[i] / modified_lengths[i] give the byte length of each
+ * line, so lines need not be NUL-terminated (e.g. views into one buffer) and
+ * may contain NUL bytes. Either array may be NULL for NUL-terminated lines.
+ * Move detection compares NUL-terminated copies, so there an embedded NUL
+ * ends the line.
+ * 
+ * @return LinesDiff structure (caller must free with free_lines_diff())
+ * 
+ * NOT part of VSCode: JS strings carry their length, C strings do not.
+ */
+LinesDiff* compute_diff_n(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+);
+
+/**
+ * compute_diff_n() with its working memory in a reusable workspace.
+ * 
+ * Line hashing, the line diff, character refinement and move detection take
+ * their buffers from workspace (NULL = none, same as compute_diff_n()), so
+ * re-diffing files of similar size makes almost no allocations besides the
+ * result. Same result as compute_diff_n().
+ * 
+ * @return LinesDiff structure (caller must free with free_lines_diff())
+ * 
+ * NOT part of VSCode: see diff_workspace.h.
+ */
+LinesDiff* compute_diff_ex(
+    DiffWorkspace* workspace,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+);
+
+/**
+ * compute_diff() on two text blobs, e.g. whole files or git blob output.
+ * 
+ * Each side is split at '\n' like JS text.split('\n') (a trailing newline
+ * yields a final empty line, '\r' stays part of its line); lines are views
+ * into the buffers, never copied. Move detection behaves as for
+ * compute_diff_n().
+ * 
+ * @return LinesDiff structure (caller must free with free_lines_diff()),
+ *         NULL on allocation failure
+ * 
+ * NOT part of VSCode: the TS side always receives string[] lines.
+ */
+LinesDiff* compute_diff_text(
+    const char* original_text,
+    size_t original_len,
+    const char* modified_text,
+    size_t modified_len,
+    const DiffOptions* options
+);
+
+/**
+ * compute_diff() that also reports where the time went.
+ * 
+ * @param stats Output: phase timings and counters of this call, reset first
+ *              (NULL = plain compute_diff())
+ * @return LinesDiff structure (caller must free with free_lines_diff())
+ * 
+ * NOT part of VSCode: diagnostics for slow diffs.
+ */
+LinesDiff* compute_diff_with_stats(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    DiffStats* stats
+);
+
+/**
+ * compute_diff_with_stats() on lines with explicit byte lengths, see
+ * compute_diff_n().
+ * 
+ * NOT part of VSCode: diagnostics for slow diffs.
+ */
+LinesDiff* compute_diff_n_with_stats(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options,
+    DiffStats* stats
+);
+
+/**
+ * One side of a diff hashed once, to be diffed against many others, e.g. a
+ * working-tree file against each revision in its history.
+ * 
+ * Holds the trimmed-line hashes, the interned line table and the per-line
+ * byte lengths of that side. Diffs only read it, so one prepared side may be
+ * used from several threads at once.
+ * 
+ * NOT part of VSCode: VSCode rehashes both sides on every diff.
+ */
+typedef struct DiffPreparedLines DiffPreparedLines;
+
+/** Which side of the diff the prepared lines are */
+typedef enum {
+    DIFF_PREPARED_ORIGINAL,
+    DIFF_PREPARED_MODIFIED
+} DiffPreparedSide;
+
+/**
+ * Prepare lines for compute_diff_prepared().
+ * 
+ * @param lengths Byte length per line (NULL = NUL-terminated lines)
+ * @return Prepared side (free with diff_prepared_lines_destroy()), NULL on
+ *         allocation failure. lines must stay valid until it is destroyed;
+ *         lengths are copied.
+ */
+DiffPreparedLines* diff_prepared_lines_create(const char** lines, const int* lengths, int count);
+
+/**
+ * Free a prepared side (can be NULL).
+ */
+void diff_prepared_lines_destroy(DiffPreparedLines* prepared);
+
+/**
+ * compute_diff_n() with one side already prepared.
+ * 
+ * The result is identical to compute_diff_n() on the same lines; only the
+ * prepared side's hashing and measuring is skipped.
+ * 
+ * @param side Whether prepared is the original or the modified side; the
+ *             other lines are the opposite side
+ * @param other_lengths Byte length per line (NULL = NUL-terminated lines)
+ * @return LinesDiff structure (caller must free with free_lines_diff()),
+ *         NULL on failure
+ * 
+ * NOT part of VSCode: one-vs-many diffs.
+ */
+LinesDiff* compute_diff_prepared(
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide side,
+    const char** other_lines,
+    const int* other_lengths,
+    int other_count,
+    const DiffOptions* options
+);
+
 /**
  * Free LinesDiff structure and all contained data.
  * 
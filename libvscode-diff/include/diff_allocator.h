@@ -0,0 +1,61 @@
+/**
+ * Library Allocator
+ *
+ * Every heap allocation the library makes goes through diff_malloc(),
+ * diff_calloc(), diff_realloc() and diff_free(), which call the installed
+ * DiffAllocator: the C heap unless an embedder installs its own (mimalloc, a
+ * thread-local pool, the host editor's allocator, a counting wrapper).
+ *
+ * Accounting: each diff_malloc / diff_calloc / diff_realloc call adds one
+ * call and the requested bytes to the calling thread's DiffStats
+ * (heap_allocations, heap_bytes, and the same per phase), so
+ * compute_diff_with_stats() reports what one diff asked the allocator for.
+ * Arena blocks and heap-backed scratch allocations are included; allocations
+ * served from an arena are not (they appear in scratch_*).
+ *
+ * Results the library hands out (LinesDiff, RenderPlan, FlatLinesDiff, ...)
+ * come from the installed allocator too: release them with the library's
+ * free_* functions, never with free() behind a custom allocator.
+ *
+ * NOT part of VSCode.
+ */
+
+#ifndef DIFF_ALLOCATOR_H
+#define DIFF_ALLOCATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    void* (*allocate)(void* user_data, size_t size);
+    void* (*reallocate)(void* user_data, void* ptr, size_t size);
+    void (*release)(void* user_data, void* ptr);            // ptr may be NULL
+    // Zero-filled allocation (NULL = allocate() plus memset), overflow
+    // already checked
+    void* (*allocate_zeroed)(void* user_data, size_t count, size_t size);
+    void* user_data;
+} DiffAllocator;
+
+/**
+ * Install the allocator every later allocation goes through
+ *
+ * Process-wide and not synchronized: install it before the first diff, with
+ * nothing allocated by the previous allocator still alive (caches,
+ * sessions, workspaces, results), and not while diffs run on other threads.
+ *
+ * @param allocator Hooks to copy (NULL = back to the C heap)
+ * @return false (nothing changed) if a required hook is missing
+ */
+bool diff_set_allocator(const DiffAllocator* allocator);
+
+/**
+ * The installed allocator (the C heap's hooks by default)
+ */
+DiffAllocator diff_get_allocator(void);
+
+void* diff_malloc(size_t size);
+void* diff_calloc(size_t count, size_t size);
+void* diff_realloc(void* ptr, size_t size);
+void diff_free(void* ptr);
+
+#endif // DIFF_ALLOCATOR_H
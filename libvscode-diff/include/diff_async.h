@@ -0,0 +1,124 @@
+/**
+ * Asynchronous Diff Jobs
+ *
+ * Runs compute_diff() (and optionally generate_render_plan()) on a native
+ * worker thread so the editor's main loop stays responsive on large files.
+ *
+ * Completion is signalled through a file descriptor that becomes readable
+ * once the job finishes, so an event loop (libuv in Neovim) can wait for it
+ * without polling. Where no descriptor is available (Windows), callers poll
+ * diff_async_status() instead.
+ *
+ * Cancellation sets an atomic flag that every Timeout of the job observes:
+ * the Myers loops, the line DP and the refinement workers stop at their next
+ * timeout check, and the job finishes as DIFF_ASYNC_CANCELLED.
+ *
+ * Not VSCode: VSCode runs the diff in a web worker and drops stale results.
+ */
+
+#ifndef DIFF_ASYNC_H
+#define DIFF_ASYNC_H
+
+#include "types.h"
+#include "diff_cache.h"
+#include <stdbool.h>
+
+typedef enum {
+    DIFF_ASYNC_RUNNING = 0,
+    DIFF_ASYNC_DONE = 1,        // Result available
+    DIFF_ASYNC_CANCELLED = 2,   // diff_async_cancel() stopped the job first
+    DIFF_ASYNC_FAILED = 3       // Allocation failure
+} DiffAsyncStatus;
+
+typedef struct DiffAsyncJob DiffAsyncJob;
+
+/**
+ * Start a diff on a worker thread
+ *
+ * Lines and options are copied; the caller's arrays can be released as soon
+ * as this returns.
+ *
+ * @param build_render_plan Also build the RenderPlan on the worker
+ * @param cache Result cache the worker goes through (NULL = none); must
+ *              outlive the job
+ * @return New job, or NULL if it could not be allocated or started
+ */
+DiffAsyncJob* diff_async_start(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    bool build_render_plan,
+    DiffCache* cache
+);
+
+/**
+ * diff_async_start() for speculative work such as prefetching into the cache:
+ * the worker drops to the lowest thread priority first (see
+ * diff_thread_lower_priority()), so it only gets CPU time the editor leaves
+ * idle.
+ */
+DiffAsyncJob* diff_async_start_background(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    bool build_render_plan,
+    DiffCache* cache
+);
+
+/**
+ * Current state of a job (safe to call from any thread)
+ */
+DiffAsyncStatus diff_async_status(const DiffAsyncJob* job);
+
+/**
+ * Descriptor that becomes readable once the job is no longer running
+ *
+ * Owned by the job and closed by diff_async_destroy(); do not read from it.
+ *
+ * @return File descriptor, or -1 where completion can only be polled
+ */
+int diff_async_fd(const DiffAsyncJob* job);
+
+/**
+ * Ask the job to stop (returns immediately; safe to call repeatedly)
+ *
+ * A job that already finished keeps its result.
+ */
+void diff_async_cancel(DiffAsyncJob* job);
+
+/**
+ * Result of a finished job
+ *
+ * @return Diff owned by the job, or NULL unless the status is DIFF_ASYNC_DONE
+ */
+const LinesDiff* diff_async_get_diff(const DiffAsyncJob* job);
+
+/**
+ * Statistics of a finished job's diff and render plan
+ *
+ * A result served by the cache has no timings (total_ns == 0).
+ *
+ * @return Stats owned by the job, or NULL unless the status is DIFF_ASYNC_DONE
+ */
+const DiffStats* diff_async_get_stats(const DiffAsyncJob* job);
+
+/**
+ * Take the render plan of a finished job started with build_render_plan
+ *
+ * @return Plan (free with free_render_plan()), or NULL if there is none or it
+ *         was already taken
+ */
+RenderPlan* diff_async_take_render_plan(DiffAsyncJob* job);
+
+/**
+ * Cancel the job, wait for the worker and free everything it owns
+ *
+ * @param job Job to destroy (can be NULL)
+ */
+void diff_async_destroy(DiffAsyncJob* job);
+
+#endif // DIFF_ASYNC_H
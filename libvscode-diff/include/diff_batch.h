@@ -0,0 +1,92 @@
+/**
+ * Batch Diff
+ *
+ * Diffs many independent file pairs in one call on a worker pool, e.g. every
+ * changed file of a branch under review. Each job runs the full
+ * compute_diff() pipeline on one thread; idle workers take the next pending
+ * job from a shared queue, so a thread finishing small files keeps pulling
+ * work while another is still busy with a large one.
+ *
+ * Jobs are started largest first (by line count), so a huge file begins
+ * early instead of being the last one left while the other cores sit idle.
+ * A job's own DiffOptions.refine_threads still applies inside that job.
+ *
+ * Not VSCode: VSCode computes one diff per editor.
+ */
+
+#ifndef DIFF_BATCH_H
+#define DIFF_BATCH_H
+
+#include "types.h"
+#include "diff_cache.h"
+#include "default_lines_diff_computer.h"
+#include <stdbool.h>
+
+/**
+ * One file pair of a batch. Arrays must stay valid until
+ * compute_diff_batch() returns.
+ */
+typedef struct {
+    const char** original_lines;
+    const int* original_lengths;    // NULL = NUL-terminated lines
+    int original_count;
+    const char** modified_lines;
+    const int* modified_lengths;    // NULL = NUL-terminated lines
+    int modified_count;
+    const DiffOptions* options;
+} DiffBatchJob;
+
+/**
+ * Diff every job on up to thread_count threads (the caller's included)
+ *
+ * The calling thread's cancel flag is forwarded to the workers.
+ *
+ * @param thread_count Worker threads (<= 0 = one per online processor)
+ * @param cache Result cache every job goes through (NULL = none)
+ * @param results Output: job_count diffs, in job order (free each with
+ *                free_lines_diff()); NULL where a job failed
+ * @return true if every job produced a diff
+ */
+bool compute_diff_batch(
+    const DiffBatchJob* jobs,
+    int job_count,
+    int thread_count,
+    DiffCache* cache,
+    LinesDiff** results
+);
+
+/**
+ * One side of a prepared batch. Arrays must stay valid until
+ * compute_diff_prepared_batch() returns.
+ */
+typedef struct {
+    const char** lines;
+    const int* lengths;             // NULL = NUL-terminated lines
+    int count;
+} DiffBatchLines;
+
+/**
+ * Diff one prepared side against every entry of others, on up to
+ * thread_count threads (the caller's included)
+ *
+ * Each result equals compute_diff_prepared(prepared, side, others[i]...);
+ * the prepared side is hashed once and shared by all workers.
+ *
+ * @param side Whether prepared is the original or the modified side of
+ *             every diff
+ * @param thread_count Worker threads (<= 0 = one per online processor)
+ * @param results Output: other_count diffs, in order (free each with
+ *                free_lines_diff()); NULL where a diff failed
+ * @return true if every diff was produced
+ */
+bool compute_diff_prepared_batch(
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide side,
+    const DiffBatchLines* others,
+    int other_count,
+    const DiffOptions* options,
+    int thread_count,
+    LinesDiff** results
+);
+
+#endif // DIFF_BATCH_H
@@ -0,0 +1,100 @@
+/**
+ * Content-Addressed Diff Result Cache
+ *
+ * Remembers the results of recent compute_diff() calls, keyed by a 128-bit
+ * hash of both sides and the options that shape the result. Reopening the
+ * same HEAD:file vs. working copy pair, or stepping back and forth through
+ * history, then costs one pass over the text instead of a diff.
+ *
+ * Results are held as FlatLinesDiff blocks in a bounded LRU. With a spill
+ * directory, entries are written there when evicted from memory (or when the
+ * cache is destroyed) and read back on a later miss, so the cache survives
+ * across editor sessions.
+ *
+ * Not part of the key: max_computation_time_ms and refine_threads. Neither
+ * changes a diff that finished in time, and results that hit the timeout are
+ * never cached.
+ *
+ * Thread-safe: one cache can serve several threads (e.g. async jobs).
+ *
+ * Not VSCode: VSCode recomputes the diff whenever a diff editor opens.
+ */
+
+#ifndef DIFF_CACHE_H
+#define DIFF_CACHE_H
+
+#include "types.h"
+#include <stdint.h>
+
+typedef struct DiffCache DiffCache;
+
+typedef struct {
+    int64_t hits;           // Served from memory
+    int64_t disk_hits;      // Served from the spill directory
+    int64_t misses;         // Computed
+    int entries;            // Currently in memory
+} DiffCacheStats;
+
+/**
+ * Create a cache
+ *
+ * @param capacity Results kept in memory (at least 1)
+ * @param spill_dir Existing directory for evicted entries, or NULL for a
+ *                  memory-only cache
+ * @return New cache, or NULL on allocation failure
+ */
+DiffCache* diff_cache_create(int capacity, const char* spill_dir);
+
+/**
+ * compute_diff() through the cache
+ *
+ * @return New diff (free with free_lines_diff()), or NULL on failure
+ */
+LinesDiff* diff_cache_compute(
+    DiffCache* cache,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+);
+
+/**
+ * compute_diff_n() through the cache: lines of known byte length
+ *
+ * The key covers each line's full byte span, so lines need not be
+ * NUL-terminated and may contain NUL bytes. Either length array may be NULL
+ * for NUL-terminated lines; a hit does not depend on which form was used.
+ *
+ * @return New diff (free with free_lines_diff()), or NULL on failure
+ */
+LinesDiff* diff_cache_compute_n(
+    DiffCache* cache,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+);
+
+/**
+ * Snapshot of the cache counters
+ */
+DiffCacheStats diff_cache_get_stats(const DiffCache* cache);
+
+/**
+ * Drop every in-memory entry (the spill directory is left alone)
+ */
+void diff_cache_clear(DiffCache* cache);
+
+/**
+ * Spill entries not yet on disk (if there is a spill directory), then free
+ * the cache and its in-memory entries
+ *
+ * @param cache Cache to free (can be NULL)
+ */
+void diff_cache_destroy(DiffCache* cache);
+
+#endif // DIFF_CACHE_H
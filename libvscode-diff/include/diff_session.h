@@ -0,0 +1,102 @@
+/**
+ * Incremental Diff Session
+ *
+ * Keeps both sides of a diff and the last LinesDiff alive between edits, so a
+ * view that refreshes while the user types does not re-run compute_diff() on
+ * the whole file.
+ *
+ * Each edit is re-diffed inside a window: the edited lines plus every change
+ * within DIFF_SESSION_CONTEXT_LINES of them, padded by that many unchanged
+ * lines on both ends. The window edges sit in unchanged regions of the
+ * previous diff, so they map 1:1 between the two sides; changes outside the
+ * window are kept (shifted past the edit) and the window's changes are
+ * spliced in between.
+ *
+ * The result is always a correct diff of the current text. Where several
+ * alignments are equally good (e.g. runs of repeated lines crossing the
+ * window edge) it may pick a different one than a full compute_diff() would;
+ * diff_session_recompute() restores the exact full-file result.
+ *
+ * Falls back to a full recompute when the window would be the whole file,
+ * when the previous diff hit the timeout, and when compute_moves is set
+ * (moves are matched across the whole file).
+ *
+ * Not VSCode: VSCode always re-diffs whole documents.
+ */
+
+#ifndef DIFF_SESSION_H
+#define DIFF_SESSION_H
+
+#include "types.h"
+#include <stdbool.h>
+
+/** Unchanged lines kept on each side of an edit before the window edge */
+#define DIFF_SESSION_CONTEXT_LINES 8
+
+typedef enum {
+    DIFF_SIDE_ORIGINAL = 0,
+    DIFF_SIDE_MODIFIED = 1
+} DiffSide;
+
+typedef struct DiffSession DiffSession;
+
+/**
+ * Create a session and compute the initial diff
+ *
+ * Lines are copied; the caller's arrays can be released afterwards.
+ *
+ * @return New session, or NULL on allocation failure
+ */
+DiffSession* diff_session_create(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+);
+
+/**
+ * Replace lines [start_line, start_line + old_count) of one side with
+ * new_lines and update the diff
+ *
+ * Same shape as nvim_buf_set_lines() / nvim_buf_attach() on_lines:
+ * start_line is 0-based, old_count lines are removed, new_count inserted.
+ *
+ * @return false on invalid ranges (session unchanged) or allocation failure
+ *         (the lines may be updated while the diff is stale; retry with
+ *         diff_session_recompute())
+ */
+bool diff_session_edit(
+    DiffSession* session,
+    DiffSide side,
+    int start_line,
+    int old_count,
+    const char** new_lines,
+    int new_count
+);
+
+/**
+ * Re-diff both sides in full (exact compute_diff() result)
+ *
+ * @return false on allocation failure (previous diff kept)
+ */
+bool diff_session_recompute(DiffSession* session);
+
+/**
+ * Current diff, owned by the session
+ *
+ * Valid until the next edit/recompute or diff_session_destroy().
+ */
+const LinesDiff* diff_session_get_diff(const DiffSession* session);
+
+/**
+ * Current lines of one side, owned by the session (same lifetime as the diff)
+ */
+const char* const* diff_session_get_lines(const DiffSession* session, DiffSide side, int* out_count);
+
+/**
+ * Destroy the session, its lines and its diff
+ */
+void diff_session_destroy(DiffSession* session);
+
+#endif // DIFF_SESSION_H
@@ -0,0 +1,84 @@
+/**
+ * Reusable Diff Workspace
+ *
+ * Holds the working memory of diff calls between calls: scratch arenas
+ * (LineSequences, DP rows, Myers V arrays and snake paths, CharSequence
+ * element buffers, optimization pass copies) and the line hash map's slot
+ * table and key pool. Passing one workspace to repeated *_ex calls lets the
+ * second and later diffs of similar size run with almost no heap calls,
+ * e.g. re-diffing a buffer on every save.
+ *
+ * Memory is only given back by diff_workspace_destroy(); a workspace keeps
+ * the high-water mark of the calls it served.
+ *
+ * Threading: the library has no global state besides per-thread settings,
+ * so workspaces on different threads never interact. One workspace serves
+ * one call at a time; the refinement workers of that call share it (each
+ * takes its own arena). Use one workspace per thread.
+ *
+ * Not VSCode: VSCode's allocations are garbage collected.
+ */
+
+#ifndef DIFF_WORKSPACE_H
+#define DIFF_WORKSPACE_H
+
+#include "arena.h"
+#include "string_hash_map.h"
+#include <stddef.h>
+
+typedef struct DiffWorkspace DiffWorkspace;
+
+/**
+ * Create an empty workspace (buffers are created by the first calls)
+ *
+ * @return New workspace, or NULL on allocation failure
+ */
+DiffWorkspace* diff_workspace_create(void);
+
+/**
+ * Destroy the workspace and all its buffers (can be NULL)
+ */
+void diff_workspace_destroy(DiffWorkspace* workspace);
+
+/**
+ * Bytes currently held by the workspace (call while no diff is using it)
+ */
+size_t diff_workspace_capacity(const DiffWorkspace* workspace);
+
+// ============================================================================
+// Library Internals
+// ============================================================================
+
+/**
+ * Make diff calls on the calling thread use workspace (NULL = none)
+ */
+void diff_set_thread_workspace(DiffWorkspace* workspace);
+
+DiffWorkspace* diff_get_thread_workspace(void);
+
+/**
+ * Take an idle arena of workspace, rewound, or a new arena when workspace
+ * is NULL or all its arenas are taken. Safe to call from several threads.
+ *
+ * @return Arena to hand back with diff_workspace_release_arena(), NULL on
+ *         allocation failure
+ */
+DiffArena* diff_workspace_acquire_arena(DiffWorkspace* workspace);
+
+/**
+ * Return an arena from diff_workspace_acquire_arena() (NULL is ignored)
+ */
+void diff_workspace_release_arena(DiffWorkspace* workspace, DiffArena* arena);
+
+/**
+ * Take the workspace's hash map, emptied, or a new map when workspace is
+ * NULL or its map is taken. Same threading as the arenas.
+ */
+StringHashMap* diff_workspace_acquire_hash_map(DiffWorkspace* workspace);
+
+/**
+ * Return a map from diff_workspace_acquire_hash_map() (NULL is ignored)
+ */
+void diff_workspace_release_hash_map(DiffWorkspace* workspace, StringHashMap* map);
+
+#endif // DIFF_WORKSPACE_H
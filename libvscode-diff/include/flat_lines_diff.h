@@ -0,0 +1,112 @@
+/**
+ * Flat LinesDiff for the FFI Boundary
+ *
+ * Packs a LinesDiff into one struct-of-arrays block of ints, allocated once
+ * and released with a single free_flat_lines_diff() call. LuaJIT indexes the
+ * arrays directly through FFI instead of converting every mapping into
+ * nested Lua tables.
+ *
+ * Changes of moved blocks are stored after the top-level changes in the same
+ * arrays, so one set of accessors covers both.
+ *
+ * All line and column numbers keep the LinesDiff conventions (1-based,
+ * end-exclusive).
+ *
+ * Not VSCode: VSCode hands LinesDiff objects to the editor directly.
+ */
+
+#ifndef FLAT_LINES_DIFF_H
+#define FLAT_LINES_DIFF_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/** ints per change: original start/end, modified start/end */
+#define FLAT_CHANGE_STRIDE 4
+
+/** ints per inner change: original start_line/start_col/end_line/end_col, then modified */
+#define FLAT_INNER_STRIDE 8
+
+/** ints per move: original start/end, modified start/end, first change, change count */
+#define FLAT_MOVE_STRIDE 6
+
+typedef struct {
+    int change_count;           // Top-level changes
+    int total_change_count;     // change_count + changes of all moves
+    int inner_change_count;     // Inner changes of all total_change_count changes
+    int move_count;
+    int hit_timeout;            // 0 or 1
+    int hit_memory_limit;       // 0 or 1
+
+    // All arrays point into the same allocation as this header
+    const int* changes;         // total_change_count * FLAT_CHANGE_STRIDE
+    const int* inner_offsets;   // total_change_count + 1: inner changes of change i
+                                // are [inner_offsets[i], inner_offsets[i + 1])
+    const int* inner_changes;   // inner_change_count * FLAT_INNER_STRIDE
+    const int* moves;           // move_count * FLAT_MOVE_STRIDE; "first change"
+                                // indexes changes (always >= change_count)
+} FlatLinesDiff;
+
+/**
+ * Pack a LinesDiff into a flat buffer
+ *
+ * @param diff Diff to pack (not modified or freed)
+ * @return Flat diff (free with free_flat_lines_diff()), or NULL on allocation failure
+ */
+FlatLinesDiff* flatten_lines_diff(const LinesDiff* diff);
+
+/**
+ * compute_diff() followed by flatten_lines_diff()
+ *
+ * @return Flat diff (free with free_flat_lines_diff()), or NULL on failure
+ */
+FlatLinesDiff* compute_diff_flat(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+);
+
+/**
+ * Rebuild a LinesDiff from a flat diff (inverse of flatten_lines_diff())
+ *
+ * @return New diff (free with free_lines_diff()), or NULL on allocation failure
+ */
+LinesDiff* expand_flat_lines_diff(const FlatLinesDiff* flat);
+
+/**
+ * Write a flat diff to a binary stream (native byte order, same-build cache
+ * files only)
+ *
+ * @return true if every byte was written
+ */
+bool write_flat_lines_diff(const FlatLinesDiff* flat, FILE* out);
+
+/**
+ * Read a flat diff written by write_flat_lines_diff()
+ *
+ * @return Flat diff (free with free_flat_lines_diff()), or NULL if the stream
+ *         is truncated, inconsistent or allocation fails
+ */
+FlatLinesDiff* read_flat_lines_diff(FILE* in);
+
+/**
+ * Allocate a flat diff for the given counts, arrays unset (for decoders
+ * that fill them in place through casts of the const pointers)
+ *
+ * @return Flat diff (free with free_flat_lines_diff()), or NULL on allocation failure
+ */
+FlatLinesDiff* flat_lines_diff_alloc(int change_count, int total_change_count,
+                                     int inner_change_count, int move_count,
+                                     bool hit_timeout, bool hit_memory_limit);
+
+/**
+ * Free a flat diff
+ *
+ * @param flat Flat diff to free (can be NULL)
+ */
+void free_flat_lines_diff(FlatLinesDiff* flat);
+
+#endif // FLAT_LINES_DIFF_H
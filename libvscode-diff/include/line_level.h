@@ -3,6 +3,7 @@
 
 #include "types.h"
 #include "sequence.h"
+#include "diff_workspace.h"
 
 /**
  * Line-Level Diff Computation (Steps 1-3 Consolidation) - FULL VSCODE PARITY
@@ -14,6 +15,7 @@
  * 1. Create perfect hash map for line deduplication
  * 2. Create LineSequence with hashed lines
  * 3. Run Myers diff (DP for small files <1700 lines, O(ND) for large)
+ *    - O(ND) only runs on the window left after stripping the common prefix/suffix
  *    - DP uses equality scoring for whitespace sensitivity
  * 4. optimizeSequenceDiffs() - Step 2 optimization
  * 5. removeVeryShortMatchingLinesBetweenDiffs() - Step 3 optimization
@@ -40,7 +42,8 @@
  *      Use DP algorithm with equality scoring:
  *        score = (line1 == line2) ? (empty ? 0.1 : 1 + log(1 + len)) : 0.99
  *    Else:
- *      Use Myers O(ND) algorithm
+ *      Strip lines equal on both sides at the start/end
+ *      Use Myers O(ND) algorithm on the remaining window
  * 5. lineAlignments = optimizeSequenceDiffs(seq1, seq2, lineAlignments)
  * 6. lineAlignments = removeVeryShortMatchingLinesBetweenDiffs(seq1, seq2, lineAlignments)
  * 
@@ -62,6 +65,145 @@ SequenceDiffArray* compute_line_alignments(
     bool* hit_timeout
 );
 
+/**
+ * Options for compute_line_alignments_with_options()
+ * 
+ * Zero-initialized options give exactly compute_line_alignments().
+ */
+typedef struct {
+    /**
+     * Anchor large diffs (O(ND) path, >= 1700 lines) on lines that occur
+     * exactly once on each side, patience-diff style, and run DP/Myers on each
+     * gap between anchors independently. NOT part of VSCode: placements can
+     * differ from VSCode on files with moved or heavily edited blocks, but a
+     * timeout only degrades the gap that ran out of budget.
+     */
+    bool anchor_unique_lines;
+    int threads;              // Worker threads for anchored gaps / linear-space halves (0/1 = sequential)
+    /**
+     * Use linear-space Myers (myers_linear_diff_algorithm) wherever O(ND)
+     * Myers would run. NOT part of VSCode: O(N + M) memory instead of
+     * O(D) snakes for very large inputs; same edit distance, but equally
+     * good placements can differ.
+     */
+    bool linear_space;
+    DiffEngineThresholds engine;     // DP vs O(ND) selection (zero = VSCode's 1700-line cutoff)
+    DiffEngineCounts* engine_counts; // Output: engines that ran are added here (NULL = not reported)
+} LineAlignmentOptions;
+
+/**
+ * compute_line_alignments() with extra options
+ * 
+ * @param options Options (NULL = defaults, same as compute_line_alignments)
+ */
+SequenceDiffArray* compute_line_alignments_with_options(
+    const char** lines_a, int len_a,
+    const char** lines_b, int len_b,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout
+);
+
+/**
+ * compute_line_alignments_with_options for lines of known byte length
+ * 
+ * lengths_a/lengths_b give the byte length of each line (lines need not be
+ * NUL-terminated and may contain NUL bytes); either may be NULL for
+ * NUL-terminated lines.
+ */
+SequenceDiffArray* compute_line_alignments_n(
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout
+);
+
+/**
+ * compute_line_alignments_n using workspace's buffers (NULL = none)
+ * 
+ * The hash map and, for single-threaded alignments (options->threads <= 1),
+ * all working memory come from the workspace, so repeated calls stop
+ * allocating once it has grown to their size. Same result as
+ * compute_line_alignments_n.
+ * 
+ * Not VSCode: see diff_workspace.h.
+ */
+SequenceDiffArray* compute_line_alignments_ex(
+    DiffWorkspace* workspace,
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout
+);
+
+/**
+ * Steps 4-6 of compute_line_alignments_n on two already hashed sequences
+ * 
+ * seq1/seq2 are trimmed-hash LineSequences whose IDs come from one map (or
+ * a base map and its overlay), so equal trimmed lines have equal IDs.
+ * hash_count bounds their IDs (unique-line anchoring counts occurrences per
+ * ID). The sequences are only read, so several alignments over the same
+ * sequences may run on different threads at once.
+ * 
+ * Not VSCode: lets callers share interning across more than two sides.
+ */
+SequenceDiffArray* compute_line_alignments_sequences(
+    const ISequence* seq1, const ISequence* seq2,
+    int hash_count,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout
+);
+
+/**
+ * One side hashed once, for diffing against many others (not VSCode)
+ * 
+ * Holds the trimmed-line LineSequence of that side and the perfect hash map
+ * its IDs came from. Comparisons only read it (the other side's new lines
+ * go into a per-comparison overlay map), so one prepared side may be used
+ * by several threads at once.
+ */
+typedef struct {
+    ISequence* sequence;      // LineSequence over the prepared lines (trimmed hashes)
+    StringHashMap* hash_map;  // Frozen after init
+} PreparedLineSequence;
+
+/**
+ * Hash lines for compute_line_alignments_prepared()
+ * 
+ * lines (and lengths, NULL = NUL-terminated) must outlive the prepared side.
+ * Allocated off any scratch arena of the calling thread.
+ * 
+ * @return false on allocation failure (prepared is left empty)
+ */
+bool prepared_line_sequence_init(PreparedLineSequence* prepared,
+                                 const char** lines, const int* lengths, int count);
+
+/**
+ * Free a prepared side (safe on one left empty by a failed init)
+ */
+void prepared_line_sequence_free(PreparedLineSequence* prepared);
+
+/**
+ * compute_line_alignments_n with one side already prepared
+ * 
+ * Same alignments as compute_line_alignments_n on the same lines: hash IDs
+ * are numbered differently, but two lines get equal IDs exactly when their
+ * trimmed contents are equal, which is all the steps look at.
+ * 
+ * @param prepared_is_original true: prepared is seq1 (original), the other
+ *                             lines are seq2; false: the other way round
+ */
+SequenceDiffArray* compute_line_alignments_prepared(
+    const PreparedLineSequence* prepared, bool prepared_is_original,
+    const char** other_lines, const int* other_lengths, int other_count,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout
+);
+
 /**
  * Helper: Free SequenceDiffArray
  */
@@ -19,6 +19,8 @@ typedef double (*EqualityScoreFn)(const ISequence* seq1, const ISequence* seq2,
  * 
  * Uses dynamic programming to compute LCS-based diff.
  * Suitable for small sequences where O(MN) space is acceptable.
+ * Runs myers_nd_diff_algorithm() instead when the matrix does not fit the
+ * thread's memory budget (utils.h, not VSCode).
  * 
  * @param seq1 First sequence
  * @param seq2 Second sequence
@@ -38,7 +40,8 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
  * Myers O(ND) Forward-only Algorithm (original implementation)
  * 
  * Direct implementation of Myers' O(ND) algorithm.
- * Used for large inputs.
+ * Used for large inputs. Continues in myers_linear_diff_algorithm() when
+ * the snake graph outgrows the thread's memory budget (not VSCode).
  * 
  * @param seq1 First sequence
  * @param seq2 Second sequence
@@ -49,6 +52,73 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
 SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequence* seq2,
                                            int timeout_ms, bool* hit_timeout);
 
+/**
+ * Myers O(ND) Linear-Space Algorithm (opt-in, not VSCode)
+ * 
+ * Divide and conquer on the middle snake (Myers 1986, section 4b): O(N + M)
+ * memory instead of the forward algorithm's snake graph, at roughly twice
+ * the work. Gives the same edit distance and SequenceDiffArray shape as
+ * myers_nd_diff_algorithm(); equal-cost alternatives may be placed differently.
+ * Returns the trivial diff when even the V arrays exceed the memory budget.
+ * 
+ * @param seq1 First sequence
+ * @param seq2 Second sequence
+ * @param timeout_ms Maximum milliseconds to run (0 = no timeout)
+ * @param threads Threads for independent large halves (0/1 = sequential)
+ * @param hit_timeout Output: set to true if timeout was reached
+ * @return Array of SequenceDiff structures (caller must free)
+ */
+SequenceDiffArray* myers_linear_diff_algorithm(const ISequence* seq1, const ISequence* seq2,
+                                               int timeout_ms, int threads, bool* hit_timeout);
+
+/**
+ * Cost model default for DiffEngineThresholds.dp_max_cells
+ * (about 1 MB of packed DP directions)
+ */
+#define DIFF_ENGINE_DP_MAX_CELLS (4 * 1024 * 1024)
+
+/**
+ * Cost estimate for diffing one pair of sequences
+ */
+typedef struct {
+    int64_t dp_cells;        // len1 * len2
+    int64_t dp_bytes;        // DP direction matrix plus rolling rows
+    int64_t nd_bytes;        // O(ND) snake graph at the estimated distance
+    int min_distance;        // Edit distance lower bound from element histograms
+    double dp_cost;          // Estimated DP time (arbitrary units)
+    double nd_cost;          // Estimated O(ND) time (same units)
+} DiffEngineEstimate;
+
+/**
+ * Engine Selection by Cost Model (not VSCode)
+ * 
+ * VSCode picks the DP by a fixed total length (1700 lines, 500 chars), which
+ * treats a 1699 x 1 diff like an 850 x 850 one. This estimates instead:
+ * - DP: len1 * len2 cells, each costing more when scored (score_fn calls)
+ * - O(ND): roughly D^2 / 2 diagonal steps plus one pass of snake compares,
+ *   with D bounded from below by the elements the two histograms do not share
+ * 
+ * and prefers the DP when its matrix fits max_dp_cells and it is the cheaper
+ * of the two.
+ * 
+ * @param scored The DP would run with an equality score function
+ * @param max_dp_cells Largest DP matrix (0 = DIFF_ENGINE_DP_MAX_CELLS)
+ * @param estimate Output: the numbers behind the choice (can be NULL)
+ * @return true to run the DP, false for O(ND)
+ */
+bool diff_engine_prefers_dp(const ISequence* seq1, const ISequence* seq2, bool scored,
+                            int max_dp_cells, DiffEngineEstimate* estimate);
+
+/**
+ * Short engine name ("dp", "myers", "linear") for reports
+ */
+const char* diff_engine_name(DiffEngine engine);
+
+/**
+ * Add one range diffed by engine to counts (no-op when counts is NULL)
+ */
+void diff_engine_count(DiffEngineCounts* counts, DiffEngine engine);
+
 /**
  * Legacy wrapper for backward compatibility
  * 
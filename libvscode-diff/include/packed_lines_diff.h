@@ -0,0 +1,162 @@
+/**
+ * Packed LinesDiff: Compact Binary Serialization
+ *
+ * Encodes a diff as one byte block of varints, with every number stored as
+ * a delta from its predecessor:
+ * - changes: start line relative to the previous change's end line, then
+ *   the range length (both sides)
+ * - inner changes: start line relative to the previous range's end (the
+ *   change's first line for the first range), start column relative to the
+ *   previous end column on the same line, end relative to start
+ * - moves: like changes; their changes follow the top-level changes
+ *
+ * A typical single-line inner change takes 8 bytes instead of 32, and the
+ * bytes carry no pointers or byte order: a packed diff can be stored in the
+ * result cache (spill files), written by diff_tool --binary, or handed to
+ * another thread or process as is. PackedLinesDiffReader walks the bytes in
+ * place without allocating.
+ *
+ * Layout:
+ *
+ *   "VDP1" flags change_count total_change_count inner_change_count move_count
+ *   total_change_count x change: original start, length, modified start,
+ *                                length, inner count, inner changes
+ *   move_count x move: original start, length, modified start, length,
+ *                      change count
+ *
+ * All numbers are LEB128 varints, signed ones zigzag-encoded. flags: bit 0
+ * hit_timeout, bit 1 hit_memory_limit.
+ *
+ * Not VSCode: VSCode hands LinesDiff objects to the editor directly.
+ */
+
+#ifndef PACKED_LINES_DIFF_H
+#define PACKED_LINES_DIFF_H
+
+#include "types.h"
+#include "flat_lines_diff.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    size_t size;
+    const uint8_t* data;            // size bytes, in the same allocation as this header
+} PackedLinesDiff;
+
+/**
+ * Sequential decoder over packed bytes (the bytes are not copied and must
+ * outlive the reader). Fields above the state are valid after init.
+ */
+typedef struct {
+    int change_count;               // Top-level changes
+    int total_change_count;         // change_count + changes of all moves
+    int inner_change_count;         // Inner changes of all changes
+    int move_count;
+    bool hit_timeout;
+    bool hit_memory_limit;
+    bool failed;                    // A next call found malformed bytes
+
+    // Decoder state
+    const uint8_t* cursor;
+    const uint8_t* end;
+    int changes_read;
+    int inner_left;                 // Unread inner changes of the last change
+    int moves_read;
+    int original_line;              // End line of the previous change / move
+    int modified_line;
+    int inner_line[2];              // End position of the previous inner range
+    int inner_col[2];
+} PackedLinesDiffReader;
+
+/**
+ * Pack a LinesDiff
+ *
+ * @return Packed diff (free with free_packed_lines_diff()), or NULL on
+ *         allocation failure
+ */
+PackedLinesDiff* pack_lines_diff(const LinesDiff* diff);
+
+/**
+ * Pack a flat diff (same bytes as pack_lines_diff() on the expanded diff)
+ */
+PackedLinesDiff* pack_flat_lines_diff(const FlatLinesDiff* flat);
+
+/**
+ * Decode packed bytes into a new LinesDiff
+ *
+ * @return New diff (free with free_lines_diff()), or NULL if the bytes are
+ *         malformed or allocation fails
+ */
+LinesDiff* unpack_lines_diff(const uint8_t* data, size_t size);
+
+/**
+ * Decode packed bytes into a new flat diff
+ *
+ * @return Flat diff (free with free_flat_lines_diff()), or NULL if the bytes
+ *         are malformed or allocation fails
+ */
+FlatLinesDiff* unpack_flat_lines_diff(const uint8_t* data, size_t size);
+
+/**
+ * Write a packed diff to a binary stream: its size as a varint, then the bytes
+ *
+ * @return true if every byte was written
+ */
+bool write_packed_lines_diff(const PackedLinesDiff* packed, FILE* out);
+
+/**
+ * Read a packed diff written by write_packed_lines_diff()
+ *
+ * @return Packed diff (free with free_packed_lines_diff()), or NULL if the
+ *         stream is truncated or allocation fails (the bytes themselves are
+ *         checked when decoded)
+ */
+PackedLinesDiff* read_packed_lines_diff(FILE* in);
+
+/**
+ * Free a packed diff
+ *
+ * @param packed Packed diff to free (can be NULL)
+ */
+void free_packed_lines_diff(PackedLinesDiff* packed);
+
+// ============================================================================
+// In-Place Reading
+// ============================================================================
+
+/**
+ * Start reading packed bytes
+ *
+ * @return false if the header is malformed
+ */
+bool packed_reader_init(PackedLinesDiffReader* reader, const uint8_t* data, size_t size);
+
+/**
+ * Next change, in flat order (top-level changes, then those of each move).
+ * Inner changes not yet read from the previous change are skipped.
+ *
+ * @param out_inner_count Inner changes to read with packed_reader_next_inner_change()
+ * @return false after the last change or on malformed bytes (reader->failed)
+ */
+bool packed_reader_next_change(PackedLinesDiffReader* reader, LineRange* out_original,
+                               LineRange* out_modified, int* out_inner_count);
+
+/**
+ * Next inner change of the current change
+ *
+ * @return false after its last inner change or on malformed bytes
+ */
+bool packed_reader_next_inner_change(PackedLinesDiffReader* reader, RangeMapping* out);
+
+/**
+ * Next move; changes not yet read are skipped first. out->changes is NULL:
+ * the move's out->change_count changes are the ones following the previous
+ * move's in flat order (the first move's follow the top-level changes).
+ *
+ * @return false after the last move or on malformed bytes
+ */
+bool packed_reader_next_move(PackedLinesDiffReader* reader, MovedText* out);
+
+#endif // PACKED_LINES_DIFF_H
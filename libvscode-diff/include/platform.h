@@ -10,6 +10,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "diff_allocator.h"
 
 // ============================================================================
 // String Duplication (portable strdup)
@@ -23,12 +26,12 @@
  * - MSVC Windows: _strdup() available
  * - C89/C99: Not standard, need manual implementation
  * 
- * Returns: Allocated copy of string (caller must free), or NULL on failure
+ * Returns: Allocated copy of string (caller must diff_free), or NULL on failure
  */
 static inline char* diff_strdup(const char* s) {
     if (!s) return NULL;
     size_t len = strlen(s) + 1;
-    char* copy = (char*)malloc(len);
+    char* copy = (char*)diff_malloc(len);
     if (copy) {
         memcpy(copy, s, len);
     }
@@ -53,4 +56,231 @@ static inline char* diff_strdup(const char* s) {
     #define diff_fileno fileno
 #endif
 
+// ============================================================================
+// Thread-Local Storage
+// ============================================================================
+
+/**
+ * Portable thread-local storage class.
+ * 
+ * Platform differences:
+ * - MSVC: __declspec(thread)
+ * - C11 compilers (GCC, Clang, MinGW): _Thread_local
+ */
+#if defined(_MSC_VER)
+    #define DIFF_THREAD_LOCAL __declspec(thread)
+#else
+    #define DIFF_THREAD_LOCAL _Thread_local
+#endif
+
+// ============================================================================
+// Threads and Mutexes (minimal portable subset)
+// ============================================================================
+
+/**
+ * Just enough threading for a fixed worker pool: create/join plus a mutex.
+ * 
+ * Platform differences:
+ * - POSIX: pthreads (link with -pthread)
+ * - Windows: Win32 threads and CRITICAL_SECTION
+ * 
+ * Thread entry points use the POSIX signature; the Win32 path wraps it.
+ * All functions return true on success.
+ */
+typedef void* (*diff_thread_fn)(void* arg);
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    
+    typedef struct {
+        HANDLE handle;
+        diff_thread_fn fn;
+        void* arg;
+    } diff_thread_t;
+    typedef CRITICAL_SECTION diff_mutex_t;
+    
+    static inline DWORD WINAPI diff_thread_trampoline(LPVOID param) {
+        diff_thread_t* thread = (diff_thread_t*)param;
+        thread->fn(thread->arg);
+        return 0;
+    }
+    
+    static inline bool diff_thread_create(diff_thread_t* thread, diff_thread_fn fn, void* arg) {
+        thread->fn = fn;
+        thread->arg = arg;
+        thread->handle = CreateThread(NULL, 0, diff_thread_trampoline, thread, 0, NULL);
+        return thread->handle != NULL;
+    }
+    
+    static inline void diff_thread_join(diff_thread_t* thread) {
+        WaitForSingleObject(thread->handle, INFINITE);
+        CloseHandle(thread->handle);
+    }
+    
+    static inline void diff_mutex_init(diff_mutex_t* mutex) { InitializeCriticalSection(mutex); }
+    static inline void diff_mutex_lock(diff_mutex_t* mutex) { EnterCriticalSection(mutex); }
+    static inline void diff_mutex_unlock(diff_mutex_t* mutex) { LeaveCriticalSection(mutex); }
+    static inline void diff_mutex_destroy(diff_mutex_t* mutex) { DeleteCriticalSection(mutex); }
+#else
+    #include <pthread.h>
+    
+    typedef struct {
+        pthread_t handle;
+    } diff_thread_t;
+    typedef pthread_mutex_t diff_mutex_t;
+    
+    static inline bool diff_thread_create(diff_thread_t* thread, diff_thread_fn fn, void* arg) {
+        return pthread_create(&thread->handle, NULL, fn, arg) == 0;
+    }
+    
+    static inline void diff_thread_join(diff_thread_t* thread) {
+        pthread_join(thread->handle, NULL);
+    }
+    
+    static inline void diff_mutex_init(diff_mutex_t* mutex) { pthread_mutex_init(mutex, NULL); }
+    static inline void diff_mutex_lock(diff_mutex_t* mutex) { pthread_mutex_lock(mutex); }
+    static inline void diff_mutex_unlock(diff_mutex_t* mutex) { pthread_mutex_unlock(mutex); }
+    static inline void diff_mutex_destroy(diff_mutex_t* mutex) { pthread_mutex_destroy(mutex); }
+#endif
+
+// ============================================================================
+// Processor Count
+// ============================================================================
+
+/**
+ * Online logical processors, for sizing worker pools (at least 1).
+ * 
+ * Platform differences:
+ * - Windows: GetSystemInfo()
+ * - POSIX: sysconf(_SC_NPROCESSORS_ONLN) (Linux, macOS, BSD)
+ */
+static inline int diff_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    int count = 1;
+#endif
+    return count > 0 ? count : 1;
+}
+
+// ============================================================================
+// Thread Priority
+// ============================================================================
+
+/**
+ * Drop the calling thread to the lowest priority it can set on its own, so it
+ * only runs when nothing else wants the CPU (background work). Best effort:
+ * it cannot be raised again, and threads it creates start at the same level.
+ *
+ * Platform differences:
+ * - Windows: SetThreadPriority(THREAD_PRIORITY_LOWEST)
+ * - Linux: setpriority() on the calling thread (nice 19; Linux applies it
+ *   per thread)
+ * - Others: no-op (setpriority() would lower the whole process)
+ */
+#if defined(__linux__)
+    #include <sys/resource.h>
+#endif
+
+static inline void diff_thread_lower_priority(void) {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+    (void)setpriority(PRIO_PROCESS, 0, 19);
+#endif
+}
+
+// ============================================================================
+// Atomic Flags
+// ============================================================================
+
+/**
+ * Flag set by one thread and polled by others (cancellation, completion).
+ * 
+ * Platform differences:
+ * - MSVC: Interlocked* on a volatile LONG
+ * - C11 compilers (GCC, Clang, MinGW): <stdatomic.h>
+ */
+#if defined(_MSC_VER)
+    typedef volatile LONG diff_atomic_flag;
+    
+    static inline void diff_atomic_flag_init(diff_atomic_flag* flag) { *flag = 0; }
+    static inline void diff_atomic_flag_set(diff_atomic_flag* flag) { InterlockedExchange(flag, 1); }
+    static inline bool diff_atomic_flag_is_set(const diff_atomic_flag* flag) {
+        return InterlockedCompareExchange((diff_atomic_flag*)flag, 0, 0) != 0;
+    }
+#else
+    #include <stdatomic.h>
+    
+    typedef atomic_int diff_atomic_flag;
+    
+    static inline void diff_atomic_flag_init(diff_atomic_flag* flag) { atomic_init(flag, 0); }
+    static inline void diff_atomic_flag_set(diff_atomic_flag* flag) {
+        atomic_store_explicit(flag, 1, memory_order_release);
+    }
+    static inline bool diff_atomic_flag_is_set(const diff_atomic_flag* flag) {
+        return atomic_load_explicit((diff_atomic_flag*)flag, memory_order_acquire) != 0;
+    }
+#endif
+
+// ============================================================================
+// Forced Inlining
+// ============================================================================
+
+/**
+ * Inline a kernel at every call site, so arguments that are constants there
+ * specialize its loops (compile-time variants without duplicated source).
+ * 
+ * Platform differences:
+ * - MSVC: __forceinline
+ * - GCC, Clang: always_inline attribute
+ * - Anything else: plain inline hint
+ */
+#if defined(_MSC_VER)
+    #define DIFF_FORCE_INLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+    #define DIFF_FORCE_INLINE inline __attribute__((always_inline))
+#else
+    #define DIFF_FORCE_INLINE inline
+#endif
+
+// ============================================================================
+// Bit Scanning
+// ============================================================================
+
+/**
+ * Index of the lowest set bit of a non-zero 64-bit word.
+ * 
+ * Platform differences:
+ * - MSVC x64/ARM64: _BitScanForward64
+ * - GCC, Clang: __builtin_ctzll
+ * - Anything else: portable loop
+ */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    #include <intrin.h>
+    static inline int diff_ctz64(uint64_t word) {
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return (int)index;
+    }
+#elif defined(__GNUC__) || defined(__clang__)
+    static inline int diff_ctz64(uint64_t word) { return __builtin_ctzll(word); }
+#else
+    static inline int diff_ctz64(uint64_t word) {
+        int index = 0;
+        while (!(word & 1)) {
+            word >>= 1;
+            index++;
+        }
+        return index;
+    }
+#endif
+
 #endif // PLATFORM_H
@@ -65,6 +65,20 @@ DetailedLineRangeMapping get_line_range_mapping(
     int modified_line_count
 );
 
+/**
+ * get_line_range_mapping for lines of known byte length
+ * (lengths may be NULL for NUL-terminated lines)
+ */
+DetailedLineRangeMapping get_line_range_mapping_n(
+    const RangeMapping* range_mapping,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_line_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_line_count
+);
+
 /**
  * Convert character-level RangeMappings to line-level DetailedLineRangeMappings.
  * 
@@ -92,6 +106,21 @@ DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings(
     bool dont_assert_start_line
 );
 
+/**
+ * line_range_mapping_from_range_mappings for lines of known byte length
+ * (lengths may be NULL for NUL-terminated lines)
+ */
+DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings_n(
+    const RangeMappingArray* alignments,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_line_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_line_count,
+    bool dont_assert_start_line
+);
+
 /**
  * Free DetailedLineRangeMappingArray.
  */
@@ -13,6 +13,7 @@
  * - Line-level highlights (entire line as insert/delete)
  * - Character-level highlights (precise character ranges)
  * - Filler line information for alignment
+ * - Hunk index (runs of highlighted lines) for viewport-limited rendering
  * 
  * @param diff LinesDiff from compute_diff()
  * @param original_lines Original file lines
@@ -29,6 +30,33 @@ RenderPlan* generate_render_plan(
     int modified_count
 );
 
+/**
+ * generate_render_plan for lines of known byte length
+ * (lengths may be NULL for NUL-terminated lines)
+ */
+RenderPlan* generate_render_plan_n(
+    const LinesDiff* diff,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count
+);
+
+/**
+ * Find the first hunk ending after a line.
+ * 
+ * Hunks are the runs of consecutive lines with line or character highlights,
+ * so a renderer can visit only the hunks overlapping a viewport: start here
+ * with the viewport's first line and stop at the first hunk starting past it.
+ * 
+ * @param side One side of a render plan
+ * @param line 1-indexed buffer line
+ * @return Index of the first hunk with end_line > line (hunk_count if none)
+ */
+int render_plan_find_hunk(const SideRenderPlan* side, int line);
+
 /**
  * Free render plan and all contained data.
  * 
@@ -36,4 +64,59 @@ RenderPlan* generate_render_plan(
  */
 void free_render_plan(RenderPlan* plan);
 
+/**
+ * Generate a sparse render plan from LinesDiff result.
+ *
+ * Same highlights, fillers and hunks as generate_render_plan_n(), but only
+ * highlighted lines are materialized, with all character highlights of a
+ * side in one pool: memory and build time follow the size of the changes
+ * instead of the line counts.
+ *
+ * Not VSCode: Neovim-specific rendering structure.
+ *
+ * @return SparseRenderPlan (caller must free with free_sparse_render_plan())
+ */
+SparseRenderPlan* generate_sparse_render_plan(
+    const LinesDiff* diff,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count
+);
+
+/**
+ * generate_sparse_render_plan for lines of known byte length
+ * (lengths may be NULL for NUL-terminated lines)
+ */
+SparseRenderPlan* generate_sparse_render_plan_n(
+    const LinesDiff* diff,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count
+);
+
+/**
+ * Find the record of a line by binary search.
+ *
+ * @param side One side of a sparse render plan
+ * @param line 1-indexed buffer line
+ * @return The line's record, NULL if the line is unchanged
+ */
+const SparseLineRecord* sparse_render_plan_find_line(const SparseSideRenderPlan* side, int line);
+
+/**
+ * render_plan_find_hunk() for a sparse render plan side
+ */
+int sparse_render_plan_find_hunk(const SparseSideRenderPlan* side, int line);
+
+/**
+ * Free sparse render plan and all contained data.
+ *
+ * @param plan SparseRenderPlan to free (can be NULL)
+ */
+void free_sparse_render_plan(SparseRenderPlan* plan);
+
 #endif // RENDER_PLAN_H
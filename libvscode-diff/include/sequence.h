@@ -44,6 +44,22 @@ struct ISequence {
      */
     int (*getLength)(const ISequence* self);
     
+    /**
+     * Get all elements as one contiguous array (optional fast path)
+     * 
+     * Returns the array that getElement() reads from, so that element i is
+     * getElements(self)[i] for 0 <= i < getLength(self). Lets the Myers
+     * kernels compare elements without a function call per element.
+     * 
+     * For LineSequence: trimmed_hash
+     * For CharSequence: elements
+     * 
+     * REUSED BY: Step 1 (Myers), Step 4 (char_level via Myers)
+     * 
+     * Optional: Can be NULL (or return NULL) if elements are not stored densely
+     */
+    const uint32_t* (*getElements)(const ISequence* self);
+    
     /**
      * Check if two elements are strongly equal (exact comparison)
      * 
@@ -93,10 +109,16 @@ struct ISequence {
 typedef struct {
     const char** lines;      // Original lines (NOT owned - just a reference)
     uint32_t* trimmed_hash;  // Perfect hash of each line after trimming (collision-free)
+    uint16_t* indentation;   // Leading spaces/tabs per line for boundary scoring
+                             // (LINE_INDENTATION_OVERFLOW: too deep, rescan the line)
+    int* line_lengths;       // Byte length of each line (lines may contain NULs)
     int length;
     bool ignore_whitespace;  // If true, getElement returns hash of trimmed line
+    bool ascii;              // Every line is ASCII without NUL bytes (selects ASCII kernels)
 } LineSequence;
 
+#define LINE_INDENTATION_OVERFLOW UINT16_MAX
+
 // Forward declare StringHashMap
 typedef struct StringHashMap StringHashMap;
 
@@ -119,6 +141,43 @@ typedef struct StringHashMap StringHashMap;
 ISequence* line_sequence_create(const char** lines, int length, bool ignore_whitespace,
                                StringHashMap* hash_map);
 
+/**
+ * Create a LineSequence from lines of known byte length
+ * 
+ * Same as line_sequence_create, but lengths[i] gives the byte length of
+ * lines[i] (lines need not be NUL-terminated and may contain NUL bytes).
+ * lengths may be NULL for NUL-terminated lines; it is copied, not retained.
+ * 
+ * Not VSCode: JS strings carry their length, C strings need it passed along.
+ */
+ISequence* line_sequence_create_n(const char** lines, const int* lengths, int length,
+                                  bool ignore_whitespace, StringHashMap* hash_map);
+
+/**
+ * Create a LineSequence whose hashes agree with one built over base
+ * 
+ * Lines already interned in base get base's IDs; others are interned into
+ * hash_map, numbered after base (see string_hash_map_get_or_create_layered_n).
+ * base is only read, so one prepared side can be compared against many
+ * sequences, from several threads, without rehashing it.
+ * 
+ * Not VSCode: see compute_diff_prepared().
+ */
+ISequence* line_sequence_create_layered_n(const char** lines, const int* lengths, int length,
+                                          bool ignore_whitespace, const StringHashMap* base,
+                                          StringHashMap* hash_map);
+
+/**
+ * Create a view of lines [start, start + length) of an existing LineSequence
+ * 
+ * Shares the parent's lines and hashes (no copying, no rehashing). Offsets in
+ * the view are relative to start. The parent must outlive the view; destroying
+ * the view does not touch the parent's arrays.
+ * 
+ * REUSED BY: Step 1 (Myers over the window left after common prefix/suffix stripping)
+ */
+ISequence* line_sequence_create_window(const ISequence* parent, int start, int length);
+
 /**
  * CharSequence - Sequence of characters with line boundary tracking
  * 
@@ -131,6 +190,7 @@ ISequence* line_sequence_create(const char** lines, int length, bool ignore_whit
  */
 typedef struct {
     uint32_t* elements;              // Character codes (trimmed if !consider_whitespace)
+    uint8_t* categories;             // Boundary category of each element (for getBoundaryScore)
     int length;                      // Length of elements array
     int* line_start_offsets;         // Offset where each line starts in elements array
     int* trimmed_ws_lengths;         // Leading whitespace trimmed from each line (0 if consider_whitespace)
@@ -173,6 +233,16 @@ ISequence* char_sequence_create_from_range(const char** lines,
                                            const CharRange* range,
                                            bool consider_whitespace);
 
+/**
+ * char_sequence_create_from_range for lines of known byte length
+ * (lengths may be NULL for NUL-terminated lines; see line_sequence_create_n)
+ */
+ISequence* char_sequence_create_from_range_n(const char** lines,
+                                             const int* lengths,
+                                             int line_count,
+                                             const CharRange* range,
+                                             bool consider_whitespace);
+
 /**
  * Offset preference for translate operations - VSCode Parity
  * 
@@ -239,6 +309,17 @@ bool char_sequence_find_word_containing(const CharSequence* seq, int offset,
 bool char_sequence_find_subword_containing(const CharSequence* seq, int offset,
                                           int* out_start, int* out_end);
 
+/**
+ * End offset (exclusive) of the token starting at offset
+ * 
+ * Tokens are words (same word characters as
+ * char_sequence_find_word_containing), runs of spaces/tabs, and single
+ * other elements. Used by token-first refinement (see CharLevelOptions).
+ * 
+ * Not VSCode.
+ */
+int char_sequence_token_end(const CharSequence* seq, int offset);
+
 /**
  * Translate character offset range to position range - VSCode Parity
  * 
@@ -6,6 +6,7 @@
  * 
  * Supported operations:
  * - Insert/lookup via get_or_create() - assigns next ID if new, returns existing ID if seen
+ * - Pre-sizing via reserve()
  * - Size query
  * - Destruction
  * 
@@ -15,7 +16,7 @@
  * Provides 100% parity with VSCode's perfectHashes Map<string, number> usage pattern.
  * 
  * Lifecycle: Created per diff computation, destroyed after completion.
- * Memory: ~O(unique_lines) - typically < 200KB for normal files.
+ * Memory: ~O(unique_lines) - one slot array plus one contiguous key pool.
  * 
  * VSCode Reference: defaultLinesDiffComputer.ts (perfectHashes Map + getOrCreateHash)
  */
@@ -23,6 +24,7 @@
 #ifndef STRING_HASH_MAP_H
 #define STRING_HASH_MAP_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -48,11 +50,61 @@ StringHashMap* string_hash_map_create(void);
  */
 uint32_t string_hash_map_get_or_create(StringHashMap* map, const char* str);
 
+/**
+ * Get or create hash for a (pointer, length) view
+ * 
+ * Same as get_or_create() for the first len bytes of str, which need not be
+ * NUL-terminated. Lets callers intern substrings (e.g. trimmed lines) without
+ * copying them first; the bytes are copied into the map only when new.
+ * 
+ * @param map The hash map
+ * @param str Start of the key bytes
+ * @param len Key length in bytes
+ * @return Unique integer for this string
+ */
+uint32_t string_hash_map_get_or_create_n(StringHashMap* map, const char* str, size_t len);
+
+/**
+ * Get or create hash for a view, on top of a read-only base map
+ * 
+ * Strings already in base keep base's ID; new strings are added to map and
+ * numbered after base's (base size + their ID in map). The IDs are the same
+ * as interning into a copy of base, but base is never written, so several
+ * threads can layer their own maps over one shared base.
+ * 
+ * Not VSCode: lets one prepared side be diffed against many others.
+ * 
+ * @param map Map that receives strings not in base
+ * @param base Map consulted first (not modified)
+ * @return Unique integer for this string
+ */
+uint32_t string_hash_map_get_or_create_layered_n(StringHashMap* map, const StringHashMap* base,
+                                                 const char* str, size_t len);
+
+/**
+ * Pre-size the table to hold n unique strings without rehashing
+ * 
+ * Only grows; IDs already handed out are unaffected.
+ */
+void string_hash_map_reserve(StringHashMap* map, int n);
+
 /**
  * Get current size (number of unique strings)
  */
 int string_hash_map_size(const StringHashMap* map);
 
+/**
+ * Forget every string, keeping the slot table and key pool for reuse
+ * 
+ * IDs start again at 0. Not VSCode: lets a DiffWorkspace reuse one map.
+ */
+void string_hash_map_clear(StringHashMap* map);
+
+/**
+ * Bytes held by the slot table and key pool
+ */
+size_t string_hash_map_capacity_bytes(const StringHashMap* map);
+
 /**
  * Destroy the hash map and free all memory
  */
@@ -0,0 +1,46 @@
+/**
+ * Text Blob Input - split one contiguous buffer into line views
+ *
+ * NOT part of VSCode: the TS side receives string[] lines. Files and git blob
+ * output arrive as one buffer, so instead of splitting them into separately
+ * allocated strings, the buffer is scanned once for '\n' and each line
+ * becomes a (pointer, length) view into the caller's bytes (zero-copy). The
+ * views feed the length-aware entry points (compute_diff_n,
+ * generate_render_plan_n).
+ *
+ * Semantics match JS text.split('\n'), which is what the plugin did before:
+ *   "a\nb"     -> ["a", "b"]
+ *   "a\nb\n"   -> ["a", "b", ""]     (trailing empty line)
+ *   ""         -> [""]               (one empty line)
+ *   "a\r\nb"   -> ["a\r", "b"]       ('\r' stays part of the line)
+ *
+ * Ownership: the views point into buf, which must outlive the TextLines.
+ */
+
+#ifndef TEXT_LINES_H
+#define TEXT_LINES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    const char** lines;   // Line starts inside the caller's buffer (not NUL-terminated)
+    int* lengths;         // Byte length of each line, without the '\n'
+    int count;
+} TextLines;
+
+/**
+ * Split buf[0, len) at every '\n'
+ *
+ * @param out Output: line views (free with text_lines_free())
+ * @return false on allocation failure, or when a line or the line count
+ *         does not fit in an int
+ */
+bool text_lines_split(const char* buf, size_t len, TextLines* out);
+
+/**
+ * Free the view arrays (not the underlying buffer)
+ */
+void text_lines_free(TextLines* lines);
+
+#endif // TEXT_LINES_H
@@ -0,0 +1,78 @@
+/**
+ * Three-Way Diff
+ *
+ * Diffs a merge base against both sides of a merge (ours and theirs) for
+ * merge-conflict views. All three sides are interned into one perfect hash
+ * map, so the base is hashed once, and the base->ours and base->theirs line
+ * alignments run concurrently over the shared sequences.
+ *
+ * The two alignments are then combined into merge regions: changes of one
+ * side whose base ranges overlap or touch a change of the other side are
+ * grouped, diff3 style, into one region that both sides changed. Only
+ * conflicting regions are refined at character level.
+ *
+ * Not VSCode: VSCode's merge editor runs two independent two-way diffs.
+ */
+
+#ifndef THREE_WAY_DIFF_H
+#define THREE_WAY_DIFF_H
+
+#include "types.h"
+#include <stdbool.h>
+
+/** Who changed a merge region */
+typedef enum {
+    MERGE_REGION_OURS,        // Only ours changed it: take ours
+    MERGE_REGION_THEIRS,      // Only theirs changed it: take theirs
+    MERGE_REGION_BOTH_SAME,   // Both changed it to the same lines
+    MERGE_REGION_CONFLICT     // Both changed it differently
+} MergeRegionKind;
+
+/**
+ * One changed region of the base and where it lies on each side
+ *
+ * Lines outside every region are unchanged on both sides. The inner changes
+ * are base->ours and base->theirs character ranges (base is the "original"
+ * of each RangeMapping); they are only computed for conflicts and are NULL
+ * otherwise.
+ */
+typedef struct {
+    MergeRegionKind kind;
+    LineRange base;
+    LineRange ours;
+    LineRange theirs;
+    RangeMapping* ours_inner_changes;
+    int ours_inner_change_count;
+    RangeMapping* theirs_inner_changes;
+    int theirs_inner_change_count;
+} MergeRegion;
+
+typedef struct {
+    MergeRegion* regions;     // In base order
+    int count;
+    bool hit_timeout;
+    bool hit_memory_limit;
+} ThreeWayDiff;
+
+/**
+ * Diff base against ours and theirs
+ *
+ * Line arrays follow compute_diff_n(): lengths may be NULL for
+ * NUL-terminated lines. options applies to both diffs; compute_moves is
+ * ignored. The calling thread's cancel flag is forwarded to the worker.
+ *
+ * @return ThreeWayDiff (free with free_three_way_diff()), NULL on failure
+ */
+ThreeWayDiff* compute_three_way_diff(
+    const char** base_lines, const int* base_lengths, int base_count,
+    const char** ours_lines, const int* ours_lengths, int ours_count,
+    const char** theirs_lines, const int* theirs_lengths, int theirs_count,
+    const DiffOptions* options
+);
+
+/**
+ * Free ThreeWayDiff and its inner changes (can be NULL)
+ */
+void free_three_way_diff(ThreeWayDiff* diff);
+
+#endif // THREE_WAY_DIFF_H
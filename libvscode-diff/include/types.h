@@ -25,6 +25,11 @@ typedef struct {
     int capacity;
 } SequenceDiffArray;
 
+/**
+ * Cancellation flag shared with another thread (opaque, see utils.h)
+ */
+typedef struct DiffCancelFlag DiffCancelFlag;
+
 /**
  * Timeout - Timeout mechanism for diff computation
  * Maps to VSCode's ITimeout interface.
@@ -32,8 +37,43 @@ typedef struct {
 typedef struct {
     int timeout_ms;         // Timeout in milliseconds (0 = infinite)
     int64_t start_time_ms;  // Start time in milliseconds
+    const DiffCancelFlag* cancel;  // Expires the timeout once set (NULL = none)
 } Timeout;
 
+/**
+ * Diff engine for one sequence range
+ */
+typedef enum {
+    DIFF_ENGINE_DP,          // O(MN) DP (myers_dp_diff_algorithm)
+    DIFF_ENGINE_MYERS,       // Forward O(ND) Myers (myers_nd_diff_algorithm)
+    DIFF_ENGINE_LINEAR       // Linear-space O(ND) Myers (myers_linear_diff_algorithm)
+} DiffEngine;
+
+/**
+ * How a pipeline step chooses between the DP and O(ND) engines.
+ * Zero-initialized thresholds give VSCode's fixed cutoffs.
+ */
+typedef struct {
+    int dp_max_total;        // Fixed cutoff: DP when len1 + len2 < dp_max_total (0 = VSCode's 1700 / 500)
+    /**
+     * Estimate both engines' cost per range (DP cells and memory against an
+     * edit distance estimated from element histograms) and run the cheaper
+     * one; dp_max_total is then unused. NOT part of VSCode: a different
+     * engine can place equally good diffs differently.
+     */
+    bool cost_model;
+    int dp_max_cells;        // Cost model: largest DP matrix (0 = DIFF_ENGINE_DP_MAX_CELLS)
+} DiffEngineThresholds;
+
+/**
+ * Ranges diffed by each engine, for benchmarks and diagnostics
+ */
+typedef struct {
+    int dp;
+    int myers;
+    int linear;
+} DiffEngineCounts;
+
 /**
  * CharRange - Represents a range of characters within text
  * Maps to VSCode's Range class.
@@ -95,6 +135,8 @@ typedef struct {
 typedef struct {
     LineRange original;
     LineRange modified;
+    DetailedLineRangeMapping* changes;  // Diff of the moved block against its new location (NULL if none)
+    int change_count;                   // Number of changes
 } MovedText;
 
 typedef struct {
@@ -110,8 +152,23 @@ typedef struct {
 typedef struct {
     bool ignore_trim_whitespace;   // If true, ignore leading/trailing whitespace
     int max_computation_time_ms;   // 0 = infinite timeout
-    bool compute_moves;            // If true, compute moved blocks (not implemented yet)
+    bool compute_moves;            // If true, detect moved blocks (LinesDiff.moves)
     bool extend_to_subwords;       // If true, extend diffs to subword boundaries
+    int refine_threads;            // Worker threads for char-level refinement and anchored gaps (0/1 = sequential)
+    bool anchor_unique_lines;      // If true, split large line diffs at unique lines (not VSCode)
+    bool linear_space_myers;       // If true, use linear-space Myers for large line diffs (not VSCode)
+    bool cost_model_engine;        // If true, pick DP or O(ND) per range by estimated cost (not VSCode)
+    int line_dp_max_lines;         // Line DP cutoff on total lines, without the cost model (0 = 1700)
+    int char_dp_max_chars;         // Char DP cutoff on total chars, without the cost model (0 = 500)
+    int dp_max_cells;              // Cost model: largest DP matrix in cells (0 = default)
+    /**
+     * Working-memory budget for each pipeline step in bytes (0 = unlimited).
+     * Over budget, a range degrades DP -> O(ND) -> linear-space Myers ->
+     * whole range changed, and a hunk keeps line-level changes only.
+     * NOT part of VSCode.
+     */
+    int64_t max_memory_bytes;
+    int token_refine_min_chars;    // Token-first char refinement for hunks this long (0 = off, not VSCode)
 } DiffOptions;
 
 /**
@@ -122,8 +179,46 @@ typedef struct {
     DetailedLineRangeMappingArray changes;
     MovedTextArray moves;
     bool hit_timeout;
+    bool hit_memory_limit;         // A step degraded under max_memory_bytes (not VSCode)
 } LinesDiff;
 
+/**
+ * Pipeline phases timed by DiffStats
+ */
+typedef enum {
+    DIFF_PHASE_LINE_HASH,          // Line hashing and LineSequence setup
+    DIFF_PHASE_LINE_DIFF,          // Engine choice and line-level DP / Myers
+    DIFF_PHASE_LINE_OPTIMIZE,      // optimize_sequence_diffs() and short-match removal on lines
+    DIFF_PHASE_CHAR_REFINE,        // Character refinement of all hunks (wall time)
+    DIFF_PHASE_LINE_MAPPING,       // line_range_mapping_from_range_mappings()
+    DIFF_PHASE_MOVES,              // compute_moves() (when enabled)
+    DIFF_PHASE_RENDER_PLAN,        // generate_render_plan() (async jobs only)
+    DIFF_PHASE_COUNT
+} DiffPhase;
+
+/**
+ * DiffStats - Where one compute_diff_with_stats() call spent its time.
+ * Counters add up over every range and hunk, whichever thread ran it.
+ * NOT part of VSCode: diagnostics for slow diffs.
+ */
+typedef struct {
+    int64_t phase_ns[DIFF_PHASE_COUNT];
+    int64_t total_ns;              // 0 when the result came from a cache
+    DiffEngineCounts line_engines; // Engines that diffed line ranges
+    DiffEngineCounts char_engines; // Engines that diffed hunks' characters
+    int64_t dp_cells;              // DP matrix cells filled
+    int myers_max_d;               // Largest edit distance an O(ND) run reached
+    int hunks_refined;             // Char refinement tasks (hunks and whitespace-only lines)
+    int64_t scratch_allocations;   // diff_scratch_* allocations (working memory)
+    int64_t scratch_bytes;         // Bytes requested by them
+    int64_t heap_allocations;      // diff_malloc/calloc/realloc calls (diff_allocator.h)
+    int64_t heap_bytes;            // Bytes requested by them
+    int64_t phase_heap_allocations[DIFF_PHASE_COUNT];  // Of those, made during each phase
+    int64_t phase_heap_bytes[DIFF_PHASE_COUNT];
+    bool hit_timeout;
+    bool hit_memory_limit;
+} DiffStats;
+
 // ============================================================================
 // RENDER DATA STRUCTURES (For UI)
 // ============================================================================
@@ -161,12 +256,27 @@ typedef struct {
     CharHighlight* char_highlights;  // Array of character-level highlights
 } LineMetadata;
 
+/**
+ * Filler (virtual) lines inserted below a buffer line to keep both sides
+ * aligned. Fillers at the same position are merged into one entry.
+ *
+ * VSCode Reference: diffEditorViewZones.ts (view zones from computeRangeAlignment)
+ */
+typedef struct {
+    int after_line;     // 1-indexed buffer line the fillers follow (0 = before line 1)
+    int count;          // Number of filler lines
+} FillerLine;
+
 /**
  * Render plan for one side (left/original or right/modified).
  */
 typedef struct {
     int line_count;
     LineMetadata* line_metadata;  // Array of line_count elements
+    int filler_count;
+    FillerLine* fillers;          // Sorted by after_line
+    int hunk_count;
+    LineRange* hunks;             // Runs of lines with any highlight, sorted (interval index)
 } SideRenderPlan;
 
 /**
@@ -178,4 +288,39 @@ typedef struct {
     SideRenderPlan right;  // Modified/right buffer
 } RenderPlan;
 
+/**
+ * One highlighted line of a sparse render plan.
+ */
+typedef struct {
+    int line_num;              // 1-indexed line number in buffer
+    HighlightType type;        // Line-level highlight type (HL_NONE for char-only lines)
+    int char_highlight_start;  // First of this line's highlights in the side's pool
+    int char_highlight_count;
+} SparseLineRecord;
+
+/**
+ * Sparse render plan for one side: only lines with a line or character
+ * highlight get a record, so size follows the changes, not the file.
+ * Lines without a record are unchanged (HL_NONE, no char highlights).
+ */
+typedef struct {
+    int line_count;
+    int record_count;
+    SparseLineRecord* records;       // Sorted by line_num
+    int char_highlight_count;
+    CharHighlight* char_highlights;  // Pool, grouped per record in record order
+    int filler_count;
+    FillerLine* fillers;             // Sorted by after_line
+    int hunk_count;
+    LineRange* hunks;                // Runs of consecutive records, sorted
+} SparseSideRenderPlan;
+
+/**
+ * Sparse counterpart of RenderPlan (same fillers and hunks).
+ */
+typedef struct {
+    SparseSideRenderPlan left;
+    SparseSideRenderPlan right;
+} SparseRenderPlan;
+
 #endif // DIFF_TYPES_H
@@ -1,6 +1,7 @@
 #ifndef UTF8_UTILS_H
 #define UTF8_UTILS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /**
@@ -53,6 +54,13 @@ int utf8_is_char_boundary(const char* str, int byte_pos);
  */
 uint32_t utf8_decode_char(const char* str, int* byte_pos);
 
+/**
+ * Bounded utf8_decode_char: decodes one code point from str[*byte_pos, byte_len)
+ * into *codepoint, NUL bytes included (U+0000). Returns false without
+ * advancing on invalid or truncated UTF-8.
+ */
+bool utf8_decode_char_n(const char* str, int byte_len, int* byte_pos, uint32_t* codepoint);
+
 /**
  * Count UTF-16 code units in a UTF-8 string
  * (matches JavaScript string.length behavior)
@@ -61,6 +69,26 @@ uint32_t utf8_decode_char(const char* str, int* byte_pos);
  */
 int utf8_to_utf16_length(const char* str);
 
+/**
+ * Count UTF-16 code units in the first byte_len bytes of a UTF-8 string
+ * (does not require, or write, a terminator at str + byte_len; NUL bytes
+ * inside the span count as one code unit each)
+ */
+int utf8_to_utf16_length_n(const char* str, int byte_len);
+
+/**
+ * Length of the leading run of ASCII bytes (0x01-0x7F) in str[0, byte_len)
+ * Stops at the first non-ASCII or NUL byte; scans 16 bytes at a time with
+ * SSE2/NEON where available. Never reads past str + byte_len.
+ */
+int utf8_ascii_run_length(const char* str, int byte_len);
+
+/**
+ * Widen count ASCII bytes to UTF-16 code units, one per uint32_t
+ * (ASCII maps 1:1 to UTF-16, so no decoding is needed)
+ */
+void utf8_widen_ascii(const char* str, int count, uint32_t* out);
+
 /**
  * Convert UTF-8 string to UTF-16 code units array
  * Returns malloc'd array of uint16_t that must be freed by caller
@@ -74,4 +102,10 @@ uint16_t* utf8_to_utf16(const char* str, int* out_length);
  */
 int utf16_pos_to_utf8_byte(const char* str, int utf16_pos);
 
+/**
+ * Same as utf16_pos_to_utf8_byte, for a string of byte_len bytes that need
+ * not be NUL-terminated (and may contain NUL bytes)
+ */
+int utf16_pos_to_utf8_byte_n(const char* str, int byte_len, int utf16_pos);
+
 #endif // UTF8_UTILS_H
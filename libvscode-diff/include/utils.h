@@ -2,7 +2,9 @@
 #define UTILS_H
 
 #include "types.h"
+#include "platform.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // Memory management helpers
@@ -13,10 +15,86 @@ void detailed_line_range_mapping_array_free(DetailedLineRangeMappingArray* arr);
 // Unicode whitespace detection (matches JavaScript /\s/ regex)
 bool is_unicode_whitespace(uint32_t ch);
 
+// ASCII whitespace (space, \t \n \v \f \r): one compare and a bit test, for
+// the ASCII-only kernels; same set as isspace() in the C locale
+#define DIFF_ASCII_WHITESPACE_MASK \
+    ((UINT64_C(1) << ' ') | (UINT64_C(1) << '\t') | (UINT64_C(1) << '\n') | \
+     (UINT64_C(1) << '\v') | (UINT64_C(1) << '\f') | (UINT64_C(1) << '\r'))
+static inline bool diff_is_ascii_whitespace(uint32_t ch) {
+    return ch <= ' ' && ((DIFF_ASCII_WHITESPACE_MASK >> ch) & 1) != 0;
+}
+
 // String utilities
 char* trim_string(const char* str);
 
+// Line lengths (compute_diff_n)
+// Line arrays travel with an optional byte-length array; NULL lengths means
+// the lines are NUL-terminated. With lengths, lines need not be terminated
+// and may contain NUL bytes.
+int diff_line_length(const char** lines, const int* lengths, int index);
+int* diff_line_lengths_create(const char** lines, int count);
+bool diff_lines_equal(const char* a, int len_a, const char* b, int len_b);
+
 // Time utilities
 int64_t get_current_time_ms(void);
 
+// Timeout utilities (VSCode: ITimeout)
+// Wall-clock budget; hot loops check it through timeout_check_amortized so
+// the clock is read at most once per TIMEOUT_CHECK_INTERVAL units of work.
+#define TIMEOUT_CHECK_INTERVAL 4096
+void timeout_init(Timeout* timeout, int timeout_ms);
+bool timeout_is_valid(const Timeout* timeout);
+int timeout_remaining_ms(const Timeout* timeout);
+bool timeout_check_amortized(const Timeout* timeout, int* work_since_check, int work);
+
+// Cancellation
+// A set flag expires every Timeout that carries it. timeout_init() picks up
+// the calling thread's flag, so algorithms that start their own Timeout from
+// a timeout_ms observe it too; worker pools forward it to their threads.
+DiffCancelFlag* diff_cancel_flag_create(void);
+void diff_cancel_flag_destroy(DiffCancelFlag* flag);
+void diff_cancel_flag_set(DiffCancelFlag* flag);
+bool diff_cancel_flag_is_set(const DiffCancelFlag* flag);
+void diff_set_thread_cancel_flag(const DiffCancelFlag* flag);
+const DiffCancelFlag* diff_get_thread_cancel_flag(void);
+
+// Memory budget (DiffOptions.max_memory_bytes)
+// Caps the working memory of one algorithm step (DP matrix, O(ND) snake
+// graph, a hunk's character sequences); inputs and results are not counted.
+// Steps that would exceed it degrade to a cheaper engine or coarser output
+// and mark the budget exceeded. Installed per thread like the cancel flag:
+// compute_diff() installs its own and worker pools forward it.
+typedef struct {
+    int64_t max_bytes;            // 0 = unlimited
+    diff_atomic_flag exceeded;    // Set once any step degraded
+} DiffMemoryBudget;
+
+void diff_memory_budget_init(DiffMemoryBudget* budget, int64_t max_bytes);
+bool diff_memory_budget_exceeded(const DiffMemoryBudget* budget);
+void diff_set_thread_memory_budget(DiffMemoryBudget* budget);
+DiffMemoryBudget* diff_get_thread_memory_budget(void);
+bool diff_memory_fits(int64_t bytes);
+
+// Diff statistics (compute_diff_with_stats)
+// Collected into the DiffStats installed on the calling thread; worker pools
+// collect into a private copy per worker and merge it when they finish.
+// Phases are timed on the thread that runs compute_diff() only; a phase's
+// heap counters are what the thread's stats gained between its start and
+// add_phase (including merged workers).
+typedef struct {
+    int64_t ns;                   // 0 when nothing is collected
+    int64_t heap_allocations;
+    int64_t heap_bytes;
+} DiffPhaseStart;
+
+int64_t get_current_time_ns(void);
+void diff_set_thread_stats(DiffStats* stats);
+DiffStats* diff_get_thread_stats(void);
+int64_t diff_stats_clock_ns(void);
+DiffPhaseStart diff_stats_phase_start(void);
+void diff_stats_add_phase(DiffPhase phase, DiffPhaseStart start);
+void diff_stats_count_allocation(size_t bytes);
+void diff_stats_count_heap_allocation(size_t bytes);
+void diff_stats_merge(DiffStats* into, const DiffStats* from);
+
 #endif // UTILS_H
@@ -0,0 +1,213 @@
+/**
+ * Bump/Arena Allocator Implementation
+ *
+ * Implementation details:
+ * - Blocks form a singly linked list; allocation bumps an offset in the
+ *   current block and moves to the next (reused or new) block when full
+ * - Requests larger than the block size get a dedicated block
+ * - Reset rewinds every block instead of freeing, so steady-state hunk
+ *   refinement performs no heap calls at all
+ * - Scratch allocations carry a small size header so realloc can copy, and
+ *   grow in place when they are the most recent allocation
+ */
+
+#include "arena.h"
+#include "diff_allocator.h"
+#include "platform.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t capacity;        // Usable bytes in data[]
+    size_t used;            // Bytes handed out
+    // Block data follows the (aligned) header
+} ArenaBlock;
+
+struct DiffArena {
+    ArenaBlock* head;
+    ArenaBlock* current;
+    size_t block_size;
+    void* last_alloc;       // Most recent scratch allocation (for in-place realloc)
+};
+
+static size_t align_up(size_t n) {
+    return (n + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+#define BLOCK_HEADER_SIZE align_up(sizeof(ArenaBlock))
+
+static unsigned char* block_data(ArenaBlock* block) {
+    return (unsigned char*)block + BLOCK_HEADER_SIZE;
+}
+
+static ArenaBlock* block_create(size_t capacity) {
+    ArenaBlock* block = (ArenaBlock*)diff_malloc(BLOCK_HEADER_SIZE + capacity);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    return block;
+}
+
+DiffArena* diff_arena_create(size_t block_size) {
+    DiffArena* arena = (DiffArena*)diff_malloc(sizeof(DiffArena));
+    if (!arena) return NULL;
+
+    arena->block_size = block_size > 0 ? align_up(block_size) : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->head = block_create(arena->block_size);
+    if (!arena->head) {
+        diff_free(arena);
+        return NULL;
+    }
+    arena->current = arena->head;
+    arena->last_alloc = NULL;
+    return arena;
+}
+
+void* diff_arena_alloc(DiffArena* arena, size_t size) {
+    size = align_up(size > 0 ? size : 1);
+
+    ArenaBlock* block = arena->current;
+    if (block->capacity - block->used < size) {
+        // Reuse the next block left over from a reset if it fits
+        ArenaBlock* next = block->next;
+        if (next && next->capacity >= size) {
+            block = next;
+        } else {
+            size_t capacity = size > arena->block_size ? size : arena->block_size;
+            ArenaBlock* fresh = block_create(capacity);
+            if (!fresh) return NULL;
+            fresh->next = block->next;
+            block->next = fresh;
+            block = fresh;
+        }
+        arena->current = block;
+    }
+
+    void* ptr = block_data(block) + block->used;
+    block->used += size;
+    return ptr;
+}
+
+void diff_arena_reset(DiffArena* arena) {
+    for (ArenaBlock* block = arena->head; block; block = block->next) {
+        block->used = 0;
+    }
+    arena->current = arena->head;
+    arena->last_alloc = NULL;
+}
+
+void diff_arena_destroy(DiffArena* arena) {
+    if (!arena) return;
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        diff_free(block);
+        block = next;
+    }
+    diff_free(arena);
+}
+
+size_t diff_arena_capacity(const DiffArena* arena) {
+    size_t total = 0;
+    for (const ArenaBlock* block = arena->head; block; block = block->next) {
+        total += block->capacity;
+    }
+    return total;
+}
+
+// ============================================================================
+// Scratch API
+// ============================================================================
+
+static DIFF_THREAD_LOCAL DiffArena* tls_scratch_arena = NULL;
+
+// Size header stored in front of each arena-backed scratch allocation
+#define SCRATCH_HEADER_SIZE ARENA_ALIGNMENT
+
+static size_t scratch_size(const void* ptr) {
+    return *(const size_t*)((const unsigned char*)ptr - SCRATCH_HEADER_SIZE);
+}
+
+DiffArena* diff_scratch_begin(DiffArena* arena) {
+    DiffArena* previous = tls_scratch_arena;
+    tls_scratch_arena = arena;
+    return previous;
+}
+
+void diff_scratch_end(DiffArena* previous) {
+    tls_scratch_arena = previous;
+}
+
+void* diff_scratch_malloc(size_t size) {
+    diff_stats_count_allocation(size);
+    DiffArena* arena = tls_scratch_arena;
+    if (!arena) {
+        return diff_malloc(size);
+    }
+
+    unsigned char* raw = (unsigned char*)diff_arena_alloc(arena, SCRATCH_HEADER_SIZE + size);
+    if (!raw) return NULL;
+    *(size_t*)raw = size;
+    arena->last_alloc = raw + SCRATCH_HEADER_SIZE;
+    return arena->last_alloc;
+}
+
+void* diff_scratch_calloc(size_t count, size_t size) {
+    if (!tls_scratch_arena) {
+        diff_stats_count_allocation(count * size);
+        return diff_calloc(count, size);
+    }
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void* ptr = diff_scratch_malloc(count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* diff_scratch_realloc(void* ptr, size_t size) {
+    DiffArena* arena = tls_scratch_arena;
+    if (!arena) {
+        diff_stats_count_allocation(size);
+        return diff_realloc(ptr, size);
+    }
+    if (!ptr) {
+        return diff_scratch_malloc(size);
+    }
+
+    size_t old_size = scratch_size(ptr);
+    if (size <= old_size) {
+        return ptr;
+    }
+
+    // Most recent allocation with room left in its block: grow in place
+    ArenaBlock* block = arena->current;
+    unsigned char* block_end = block_data(block) + block->used;
+    if (ptr == arena->last_alloc &&
+        block_end == (unsigned char*)ptr + align_up(old_size) &&
+        block->capacity - block->used >= align_up(size) - align_up(old_size)) {
+        diff_stats_count_allocation(size);
+        block->used += align_up(size) - align_up(old_size);
+        *(size_t*)((unsigned char*)ptr - SCRATCH_HEADER_SIZE) = size;
+        return ptr;
+    }
+
+    void* fresh = diff_scratch_malloc(size);
+    if (!fresh) return NULL;
+    memcpy(fresh, ptr, old_size);
+    return fresh;
+}
+
+void diff_scratch_free(void* ptr) {
+    if (!tls_scratch_arena) {
+        diff_free(ptr);
+    }
+    // Arena-backed: released in bulk on reset/destroy
+}
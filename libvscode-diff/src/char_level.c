@@ -11,14 +11,18 @@
  */
 
 #include "char_level.h"
+#include "diff_allocator.h"
 #include "myers.h"
 #include "optimize.h"
 #include "sequence.h"
+#include "string_hash_map.h"
 #include "types.h"
+#include "utils.h"
+#include "arena.h"
+#include "diff_workspace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
-#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <limits.h>
@@ -38,15 +42,15 @@ static bool line_range_is_empty(LineRange range) {
     return range.start_line >= range.end_line;
 }
 
-static int safe_line_length(const char** lines, int line_count, int line_number) {
+static int safe_line_length(const char** lines, const int* lengths, int line_count, int line_number) {
     if (line_number < 1 || line_number > line_count) {
         return 0;
     }
-    const char* line = lines[line_number - 1];
-    return line ? (int)strlen(line) : 0;
+    return diff_line_length(lines, lengths, line_number - 1);
 }
 
-static void normalize_position(int* line, int* column, const char** lines, int line_count) {
+static void normalize_position(int* line, int* column, const char** lines, const int* lengths,
+                               int line_count) {
     if (!line || !column) {
         return;
     }
@@ -65,7 +69,7 @@ static void normalize_position(int* line, int* column, const char** lines, int l
 
     if (*line > line_count) {
         *line = line_count;
-        int len = safe_line_length(lines, line_count, *line);
+        int len = safe_line_length(lines, lengths, line_count, *line);
         if (*column > len + 1) {
             *column = len + 1;
         }
@@ -75,7 +79,7 @@ static void normalize_position(int* line, int* column, const char** lines, int l
         return;
     }
 
-    int len = safe_line_length(lines, line_count, *line);
+    int len = safe_line_length(lines, lengths, line_count, *line);
     if (*column > len + 1) {
         *column = len + 1;
     }
@@ -88,8 +92,10 @@ static RangeMapping line_range_mapping_to_range_mapping2(
     LineRange original,
     LineRange modified,
     const char** original_lines,
+    const int* original_lengths,
     int original_count,
     const char** modified_lines,
+    const int* modified_lengths,
     int modified_count
 ) {
     RangeMapping mapping;
@@ -118,12 +124,12 @@ static RangeMapping line_range_mapping_to_range_mapping2(
         int orig_start_line = original.start_line;
         int orig_end_line = original.end_line - 1;
         int orig_end_col = INT_MAX / 2;
-        normalize_position(&orig_end_line, &orig_end_col, original_lines, original_count);
+        normalize_position(&orig_end_line, &orig_end_col, original_lines, original_lengths, original_count);
 
         int mod_start_line = modified.start_line;
         int mod_end_line = modified.end_line - 1;
         int mod_end_col = INT_MAX / 2;
-        normalize_position(&mod_end_line, &mod_end_col, modified_lines, modified_count);
+        normalize_position(&mod_end_line, &mod_end_col, modified_lines, modified_lengths, modified_count);
 
         mapping.original.start_line = orig_start_line;
         mapping.original.start_col = 1;
@@ -140,19 +146,19 @@ static RangeMapping line_range_mapping_to_range_mapping2(
     if (original.start_line > 1 && modified.start_line > 1) {
         int orig_start_line = original.start_line - 1;
         int orig_start_col = INT_MAX / 2;
-        normalize_position(&orig_start_line, &orig_start_col, original_lines, original_count);
+        normalize_position(&orig_start_line, &orig_start_col, original_lines, original_lengths, original_count);
 
         int orig_end_line = original.end_line - 1;
         int orig_end_col = INT_MAX / 2;
-        normalize_position(&orig_end_line, &orig_end_col, original_lines, original_count);
+        normalize_position(&orig_end_line, &orig_end_col, original_lines, original_lengths, original_count);
 
         int mod_start_line = modified.start_line - 1;
         int mod_start_col = INT_MAX / 2;
-        normalize_position(&mod_start_line, &mod_start_col, modified_lines, modified_count);
+        normalize_position(&mod_start_line, &mod_start_col, modified_lines, modified_lengths, modified_count);
 
         int mod_end_line = modified.end_line - 1;
         int mod_end_col = INT_MAX / 2;
-        normalize_position(&mod_end_line, &mod_end_col, modified_lines, modified_count);
+        normalize_position(&mod_end_line, &mod_end_col, modified_lines, modified_lengths, modified_count);
 
         mapping.original.start_line = orig_start_line;
         mapping.original.start_col = orig_start_col;
@@ -168,11 +174,11 @@ static RangeMapping line_range_mapping_to_range_mapping2(
 
     int orig_line = original.start_line;
     int orig_col = 1;
-    normalize_position(&orig_line, &orig_col, original_lines, original_count);
+    normalize_position(&orig_line, &orig_col, original_lines, original_lengths, original_count);
 
     int mod_line = modified.start_line;
     int mod_col = 1;
-    normalize_position(&mod_line, &mod_col, modified_lines, modified_count);
+    normalize_position(&mod_line, &mod_col, modified_lines, modified_lengths, modified_count);
 
     mapping.original.start_line = orig_line;
     mapping.original.start_col = orig_col;
@@ -188,14 +194,15 @@ static RangeMapping line_range_mapping_to_range_mapping2(
 
 /**
  * Create RangeMappingArray with initial capacity
+ * (C heap, not scratch: the array is returned to the caller)
  */
 static RangeMappingArray* create_range_mapping_array(int capacity) {
-    RangeMappingArray* arr = (RangeMappingArray*)malloc(sizeof(RangeMappingArray));
+    RangeMappingArray* arr = (RangeMappingArray*)diff_malloc(sizeof(RangeMappingArray));
     if (!arr) return NULL;
     
-    arr->mappings = (RangeMapping*)malloc(sizeof(RangeMapping) * capacity);
+    arr->mappings = (RangeMapping*)diff_malloc(sizeof(RangeMapping) * capacity);
     if (!arr->mappings) {
-        free(arr);
+        diff_free(arr);
         return NULL;
     }
     
@@ -209,7 +216,7 @@ static RangeMappingArray* create_range_mapping_array(int capacity) {
  */
 static bool grow_range_mapping_array(RangeMappingArray* arr) {
     int new_capacity = arr->capacity * 2;
-    RangeMapping* new_mappings = (RangeMapping*)realloc(arr->mappings, 
+    RangeMapping* new_mappings = (RangeMapping*)diff_realloc(arr->mappings, 
                                                        sizeof(RangeMapping) * new_capacity);
     if (!new_mappings) return false;
     
@@ -245,82 +252,93 @@ typedef struct {
 } OffsetPair;
 
 /**
- * Invert diffs to get equal mappings - VSCode SequenceDiff.invert()
+ * Equal mappings between diffs, produced on demand - VSCode SequenceDiff.invert()
+ * 
+ * Not VSCode: instead of materializing the inverted array, the queue walks
+ * the gaps of diffs directly. Gap k lies between diffs[k - 1] and diffs[k]
+ * (gap count runs to the end of both sequences); gaps empty on both sides
+ * are skipped, as invert() never emits them.
  */
-static SequenceDiffArray* invert_diffs(const SequenceDiffArray* diffs, int length1, int length2) {
-    SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
-    result->capacity = diffs->count + 2;
-    result->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff) * result->capacity);
-    result->count = 0;
-    
-    int prev_end1 = 0;
-    int prev_end2 = 0;
-    
-    for (int i = 0; i < diffs->count; i++) {
-        const SequenceDiff* d = &diffs->diffs[i];
-        
-        // Add equal range before this diff
-        if (d->seq1_start > prev_end1 || d->seq2_start > prev_end2) {
-            SequenceDiff equal = {
-                .seq1_start = prev_end1,
-                .seq1_end = d->seq1_start,
-                .seq2_start = prev_end2,
-                .seq2_end = d->seq2_start
-            };
-            result->diffs[result->count++] = equal;
-        }
-        
-        prev_end1 = d->seq1_end;
-        prev_end2 = d->seq2_end;
-    }
-    
-    // Add final equal range
-    if (prev_end1 < length1 || prev_end2 < length2) {
+typedef struct {
+    const SequenceDiffArray* diffs;
+    int length1;
+    int length2;
+    int gap;
+} EqualMappingQueue;
+
+/** Next equal mapping into *out without consuming it; false once exhausted */
+static bool equal_mapping_peek(EqualMappingQueue* queue, SequenceDiff* out) {
+    const SequenceDiffArray* diffs = queue->diffs;
+    for (; queue->gap <= diffs->count; queue->gap++) {
+        int k = queue->gap;
         SequenceDiff equal = {
-            .seq1_start = prev_end1,
-            .seq1_end = length1,
-            .seq2_start = prev_end2,
-            .seq2_end = length2
+            .seq1_start = k > 0 ? diffs->diffs[k - 1].seq1_end : 0,
+            .seq1_end = k < diffs->count ? diffs->diffs[k].seq1_start : queue->length1,
+            .seq2_start = k > 0 ? diffs->diffs[k - 1].seq2_end : 0,
+            .seq2_end = k < diffs->count ? diffs->diffs[k].seq2_start : queue->length2
         };
-        result->diffs[result->count++] = equal;
+        if (equal.seq1_end > equal.seq1_start || equal.seq2_end > equal.seq2_start) {
+            *out = equal;
+            return true;
+        }
     }
-    
-    return result;
+    return false;
+}
+
+/** Consume the mapping the last successful peek returned (like shift()) */
+static void equal_mapping_pop(EqualMappingQueue* queue) {
+    queue->gap++;
 }
 
 /**
- * Merge two sorted diff arrays - VSCode mergeSequenceDiffs()
+ * Merge sorted additional diffs into diffs - VSCode mergeSequenceDiffs()
+ * 
+ * Not VSCode: merges into diffs->diffs in place. The array is grown to
+ * hold both inputs and its own diffs are moved to the tail, so the write
+ * index, which trails the number of diffs consumed, never reaches one that
+ * is still unread.
  */
-static SequenceDiffArray* merge_diffs(SequenceDiffArray* arr1, SequenceDiffArray* arr2) {
-    SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
-    result->capacity = arr1->count + arr2->count;
-    result->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff) * result->capacity);
-    result->count = 0;
+static void merge_diffs_in_place(SequenceDiffArray* diffs, const SequenceDiffArray* additional) {
+    int count1 = diffs->count;
+    int count2 = additional->count;
     
+    if (count2 > 0) {
+        if (count1 + count2 > diffs->capacity) {
+            diffs->capacity = count1 + count2;
+            diffs->diffs = (SequenceDiff*)diff_scratch_realloc(diffs->diffs,
+                                                               sizeof(SequenceDiff) * diffs->capacity);
+        }
+        memmove(diffs->diffs + count2, diffs->diffs, sizeof(SequenceDiff) * count1);
+    }
+    
+    const SequenceDiff* arr1 = diffs->diffs + count2;
+    const SequenceDiff* arr2 = additional->diffs;
+    SequenceDiff* result = diffs->diffs;
+    int result_count = 0;
     int i1 = 0, i2 = 0;
     
-    while (i1 < arr1->count || i2 < arr2->count) {
+    while (i1 < count1 || i2 < count2) {
         SequenceDiff next;
         
-        if (i1 < arr1->count && (i2 >= arr2->count || arr1->diffs[i1].seq1_start < arr2->diffs[i2].seq1_start)) {
-            next = arr1->diffs[i1++];
+        if (i1 < count1 && (i2 >= count2 || arr1[i1].seq1_start < arr2[i2].seq1_start)) {
+            next = arr1[i1++];
         } else {
-            next = arr2->diffs[i2++];
+            next = arr2[i2++];
         }
         
         // Merge with previous if they overlap/touch
-        if (result->count > 0 && result->diffs[result->count - 1].seq1_end >= next.seq1_start) {
-            SequenceDiff* prev = &result->diffs[result->count - 1];
+        if (result_count > 0 && result[result_count - 1].seq1_end >= next.seq1_start) {
+            SequenceDiff* prev = &result[result_count - 1];
             prev->seq1_start = min_int(prev->seq1_start, next.seq1_start);
             prev->seq1_end = max_int(prev->seq1_end, next.seq1_end);
             prev->seq2_start = min_int(prev->seq2_start, next.seq2_start);
             prev->seq2_end = max_int(prev->seq2_end, next.seq2_end);
         } else {
-            result->diffs[result->count++] = next;
+            result[result_count++] = next;
         }
     }
     
-    return result;
+    diffs->count = result_count;
 }
 
 /**
@@ -341,12 +359,11 @@ typedef struct {
  * This function mirrors VSCode's scanWord behavior, including the critical
  * while loop that continues consuming and merging overlapping equal spans.
  * 
- * NOTE: This modifies the queue_pos to consume equal mappings from the shared queue,
- * matching VSCode's closure-based approach where scanWord modifies the same array.
+ * NOTE: This consumes equal mappings from the shared queue, matching VSCode's
+ * closure-based approach where scanWord modifies the same array.
  */
 static void scan_word(ScanWordContext* ctx, int offset1, int offset2, 
-                     SequenceDiffArray* all_equal_mappings, int* queue_start_pos,
-                     const SequenceDiff* current_equal_mapping) {
+                     EqualMappingQueue* queue, const SequenceDiff* current_equal_mapping) {
     if (offset1 < *ctx->last_offset1 || offset2 < *ctx->last_offset2) {
         return;
     }
@@ -378,10 +395,11 @@ static void scan_word(ScanWordContext* ctx, int offset1, int offset2,
     int equal_chars2 = max_int(0, equal_end2 - equal_start2);
     
     // VSCode critical feature: Keep consuming and merging overlapping equal spans
-    // from the remaining queue (starting at queue_start_pos).
+    // from the remaining queue.
     // This is where we achieve parity with VSCode's while(equalMappings.length > 0) loop.
-    while (*queue_start_pos < all_equal_mappings->count) {
-        const SequenceDiff* next = &all_equal_mappings->diffs[*queue_start_pos];
+    SequenceDiff next_mapping;
+    while (equal_mapping_peek(queue, &next_mapping)) {
+        const SequenceDiff* next = &next_mapping;
         
         // Check if the next equal mapping intersects with our current word
         bool intersects = (next->seq1_start < word.seq1_end && next->seq1_end > word.seq1_start) ||
@@ -429,7 +447,7 @@ static void scan_word(ScanWordContext* ctx, int offset1, int offset2,
         
         // If the word extends beyond the next equal mapping, consume it (shift)
         if (word.seq1_end >= next->seq1_end) {
-            (*queue_start_pos)++;  // Consume this mapping from the queue
+            equal_mapping_pop(queue);  // Consume this mapping from the queue
         } else {
             break;
         }
@@ -449,7 +467,7 @@ static void scan_word(ScanWordContext* ctx, int offset1, int offset2,
     if (should_extend) {
         if (ctx->additional->count >= ctx->additional->capacity) {
             ctx->additional->capacity *= 2;
-            ctx->additional->diffs = (SequenceDiff*)realloc(ctx->additional->diffs, 
+            ctx->additional->diffs = (SequenceDiff*)diff_scratch_realloc(ctx->additional->diffs, 
                                                       sizeof(SequenceDiff) * ctx->additional->capacity);
         }
         ctx->additional->diffs[ctx->additional->count++] = word;
@@ -463,18 +481,26 @@ static void scan_word(ScanWordContext* ctx, int offset1, int offset2,
  * Extend diffs to entire word boundaries if appropriate - VSCode Parity
  * 
  * This is the complex function from VSCode's heuristicSequenceOptimizations.ts
+ * 
+ * Not VSCode: diffs is extended in place (see merge_diffs_in_place()); only
+ * the word extensions found get an array of their own.
  */
 static SequenceDiffArray* extend_diffs_to_entire_word(
     const CharSequence* seq1,
     const CharSequence* seq2,
-    const SequenceDiffArray* diffs,
+    SequenceDiffArray* diffs,
     bool use_subwords,
     bool force
 ) {
-    SequenceDiffArray* equal_mappings = invert_diffs(diffs, seq1->length, seq2->length);
-    SequenceDiffArray* additional = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
+    EqualMappingQueue queue = {
+        .diffs = diffs,
+        .length1 = seq1->length,
+        .length2 = seq2->length,
+        .gap = 0
+    };
+    SequenceDiffArray* additional = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
     additional->capacity = 100;
-    additional->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff) * additional->capacity);
+    additional->diffs = (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff) * additional->capacity);
     additional->count = 0;
     
     int last_offset1 = 0;
@@ -492,50 +518,74 @@ static SequenceDiffArray* extend_diffs_to_entire_word(
     };
     
     // VSCode uses: while (equalMappings.length > 0) { const next = equalMappings.shift()!; ... }
-    // We simulate with a position that advances. The key is that scan_word can also
-    // advance queue_pos (consuming mappings), matching VSCode's closure-based approach.
-    int queue_pos = 0;
-    while (queue_pos < equal_mappings->count) {
-        const SequenceDiff current = equal_mappings->diffs[queue_pos];
-        queue_pos++;  // Consume current mapping (like shift())
+    // The queue stands in for that array, and scan_word can consume from it
+    // too, matching VSCode's closure-based approach.
+    SequenceDiff current;
+    while (equal_mapping_peek(&queue, &current)) {
+        equal_mapping_pop(&queue);  // Consume current mapping (like shift())
         
         if (current.seq1_start >= current.seq1_end) {
             continue;
         }
         
         // Scan at start of equal region
-        // Pass queue_pos as the start of remaining items (what's left after shift)
-        scan_word(&ctx, current.seq1_start, current.seq2_start, 
-                 equal_mappings, &queue_pos, &current);
+        scan_word(&ctx, current.seq1_start, current.seq2_start, &queue, &current);
         
         // Scan at end of equal region (one char before end)
         // VSCode: next.getEndExclusives().delta(-1)
         if (current.seq1_end > current.seq1_start + 1) {
-            scan_word(&ctx, current.seq1_end - 1, current.seq2_end - 1, 
-                     equal_mappings, &queue_pos, &current);
+            scan_word(&ctx, current.seq1_end - 1, current.seq2_end - 1, &queue, &current);
         }
     }
     
     // Merge original diffs with additional word extensions
-    SequenceDiffArray* merged = merge_diffs((SequenceDiffArray*)diffs, additional);
+    merge_diffs_in_place(diffs, additional);
     
     // Cleanup
-    free(equal_mappings->diffs);
-    free(equal_mappings);
-    free(additional->diffs);
-    free(additional);
+    diff_scratch_free(additional->diffs);
+    diff_scratch_free(additional);
     
-    return merged;
+    return diffs;
 }
 
 // =============================================================================
 // removeVeryShortMatchingTextBetweenLongDiffs() - VSCode Parity
 // =============================================================================
 
+static bool is_ascii_space(uint32_t c) {
+    return diff_is_ascii_whitespace(c);
+}
+
+/**
+ * Length of elements [start, end) after trimming whitespace (JS trim())
+ * 
+ * Works on the element range directly instead of materializing the text.
+ * If out_line_breaks is given, it receives the '\n'/'\r' count inside the
+ * trimmed span.
+ */
+static int trimmed_element_length(const CharSequence* seq, int start, int end, int* out_line_breaks) {
+    const uint32_t* elements = seq->elements;
+    while (start < end && is_ascii_space(elements[start])) start++;
+    while (end > start && is_ascii_space(elements[end - 1])) end--;
+    
+    if (out_line_breaks) {
+        int line_breaks = 0;
+        for (int i = start; i < end; i++) {
+            if (elements[i] == '\n' || elements[i] == '\r') line_breaks++;
+        }
+        *out_line_breaks = line_breaks;
+    }
+    return end - start;
+}
+
 /**
  * Remove very short matching text between long diffs - VSCode Parity
  * 
  * Complex heuristic from VSCode's heuristicSequenceOptimizations.ts
+ * 
+ * Not VSCode: gaps are measured on seq1's elements rather than on
+ * getText() strings, and both phases merge into diffs->diffs in place
+ * (the write index never passes the read index).
  */
 static SequenceDiffArray* remove_very_short_text(
     const CharSequence* seq1,
@@ -551,10 +601,8 @@ static SequenceDiffArray* remove_very_short_text(
     
     do {
         should_repeat = false;
-        SequenceDiff* result = (SequenceDiff*)malloc(sizeof(SequenceDiff) * diffs->capacity);
-        int result_count = 0;
-        
-        result[result_count++] = diffs->diffs[0];
+        SequenceDiff* result = diffs->diffs;
+        int result_count = 1;
         
         for (int i = 1; i < diffs->count; i++) {
             SequenceDiff* last_result = &result[result_count - 1];
@@ -579,30 +627,16 @@ static SequenceDiffArray* remove_very_short_text(
                 continue;
             }
             
-            // Get unchanged text and check length
-            char* unchanged_text = char_sequence_get_text(seq1, unchanged_start, unchanged_end);
-            if (!unchanged_text) {
+            // Trimmed length and line breaks of the unchanged text
+            if (unchanged_start < 0 || unchanged_end > seq1->length) {
                 result[result_count++] = cur;
                 continue;
             }
-            
-            // Trim and check
-            char* trimmed = unchanged_text;
-            while (*trimmed && isspace(*trimmed)) trimmed++;
-            char* end = trimmed + strlen(trimmed) - 1;
-            while (end > trimmed && isspace(*end)) *end-- = '\0';
-            
-            bool short_text = (strlen(trimmed) <= 20);
-            
-            // Count newlines
             int newline_count = 0;
-            for (char* p = trimmed; *p; p++) {
-                if (*p == '\n' || *p == '\r') newline_count++;
-            }
+            bool short_text = trimmed_element_length(seq1, unchanged_start, unchanged_end,
+                                                     &newline_count) <= 20;
             bool single_line = (newline_count <= 1);
             
-            free(unchanged_text);
-            
             if (!short_text || !single_line) {
                 result[result_count++] = cur;
                 continue;
@@ -641,20 +675,21 @@ static SequenceDiffArray* remove_very_short_text(
             }
         }
         
-        free(diffs->diffs);
-        diffs->diffs = result;
         diffs->count = result_count;
-        diffs->capacity = diffs->capacity;  // Keep same capacity
         
     } while (counter++ < 10 && should_repeat);
     
     // Second phase: Remove short prefixes/suffixes (VSCode's forEachWithNeighbors logic)
-    SequenceDiff* new_diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff) * (diffs->capacity + 10));
+    // Written in place: neighbors are read from the original values, so the
+    // previous diff is kept aside before its slot can be overwritten
+    SequenceDiff* new_diffs = diffs->diffs;
     int new_count = 0;
+    SequenceDiff saved[2];  // Original values of diffs i - 1 and i, alternating
     
     for (int i = 0; i < diffs->count; i++) {
-        const SequenceDiff* prev = (i > 0) ? &diffs->diffs[i - 1] : NULL;
-        const SequenceDiff* cur = &diffs->diffs[i];
+        saved[i & 1] = diffs->diffs[i];
+        const SequenceDiff* prev = (i > 0) ? &saved[(i - 1) & 1] : NULL;
+        const SequenceDiff* cur = &saved[i & 1];
         const SequenceDiff* next = (i < diffs->count - 1) ? &diffs->diffs[i + 1] : NULL;
         
         SequenceDiff new_diff = *cur;
@@ -668,48 +703,20 @@ static SequenceDiffArray* remove_very_short_text(
         char_sequence_extend_to_full_lines(seq1, cur->seq1_start, cur->seq1_end, &full_start, &full_end);
         
         // Check prefix
-        if (full_start < cur->seq1_start && is_large_diff) {
-            int text_len = cur->seq1_start - full_start;
-            char* prefix = char_sequence_get_text(seq1, full_start, cur->seq1_start);
-            if (prefix) {
-                // Trim whitespace
-                const char* start = prefix;
-                const char* end = prefix + strlen(prefix) - 1;
-                while (*start && isspace((unsigned char)*start)) start++;
-                while (end > start && isspace((unsigned char)*end)) end--;
-
-                int trimmed_len = (start > end) ? 0 : (int)(end - start + 1);
-                bool should_include = (text_len > 0 && trimmed_len <= 3);
-
-                if (should_include) {
-                    int prefix_len = cur->seq1_start - full_start;
-                    new_diff.seq1_start -= prefix_len;
-                    new_diff.seq2_start -= prefix_len;
-                }
-                free(prefix);
+        if (full_start < cur->seq1_start && is_large_diff && full_start >= 0) {
+            int prefix_len = cur->seq1_start - full_start;
+            if (trimmed_element_length(seq1, full_start, cur->seq1_start, NULL) <= 3) {
+                new_diff.seq1_start -= prefix_len;
+                new_diff.seq2_start -= prefix_len;
             }
         }
         
         // Check suffix
-        if (cur->seq1_end < full_end && is_large_diff) {
-            int text_len = full_end - cur->seq1_end;
-            char* suffix = char_sequence_get_text(seq1, cur->seq1_end, full_end);
-            if (suffix) {
-                // Trim whitespace
-                const char* start = suffix;
-                const char* end = suffix + strlen(suffix) - 1;
-                while (*start && isspace((unsigned char)*start)) start++;
-                while (end > start && isspace((unsigned char)*end)) end--;
-
-                int trimmed_len = (start > end) ? 0 : (int)(end - start + 1);
-                bool should_include = (text_len > 0 && trimmed_len <= 3);
-
-                if (should_include) {
-                    int suffix_len = full_end - cur->seq1_end;
-                    new_diff.seq1_end += suffix_len;
-                    new_diff.seq2_end += suffix_len;
-                }
-                free(suffix);
+        if (cur->seq1_end < full_end && is_large_diff && full_end <= seq1->length) {
+            int suffix_len = full_end - cur->seq1_end;
+            if (trimmed_element_length(seq1, cur->seq1_end, full_end, NULL) <= 3) {
+                new_diff.seq1_end += suffix_len;
+                new_diff.seq2_end += suffix_len;
             }
         }
         
@@ -739,10 +746,7 @@ static SequenceDiffArray* remove_very_short_text(
         new_diffs[new_count++] = new_diff;
     }
     
-    free(diffs->diffs);
-    diffs->diffs = new_diffs;
     diffs->count = new_count;
-    diffs->capacity = diffs->capacity + 10;
     
     return diffs;
 }
@@ -786,15 +790,263 @@ static RangeMapping translate_diff_to_range(
     return mapping;
 }
 
+/** Character ranges with fewer elements in total use the DP (VSCode refineDiff) */
+#define CHAR_DP_MAX_TOTAL_CHARS 500
+
+/**
+ * Whether the unscored DP should diff the characters: VSCode's fixed cutoff,
+ * or the cost model when thresholds->cost_model is set (not VSCode)
+ */
+static bool char_range_uses_dp(const ISequence* seq1, const ISequence* seq2, int len1, int len2,
+                               const DiffEngineThresholds* thresholds) {
+    if (thresholds->cost_model) {
+        return diff_engine_prefers_dp(seq1, seq2, false, thresholds->dp_max_cells, NULL);
+    }
+    int dp_max_total = thresholds->dp_max_total > 0 ? thresholds->dp_max_total : CHAR_DP_MAX_TOTAL_CHARS;
+    return len1 + len2 < dp_max_total;
+}
+
+// =============================================================================
+// Token-First Diff (not VSCode)
+// =============================================================================
+//
+// For very long hunks (minified files, generated code), the characters are
+// first grouped into tokens (char_sequence_token_end) and the token
+// sequences are diffed; characters are then only diffed inside each changed
+// token range. The resulting character diffs go through Steps 3-8 like any
+// other, so columns and word extension behave as for a character diff.
+// Placements can differ from a full character diff (a match across a
+// token boundary is not seen), which is why the mode is opt-in.
+
+/** A plain element array as a (non-owning) ISequence */
+typedef struct {
+    const uint32_t* elements;
+    int length;
+} ElementArray;
+
+static uint32_t element_array_get_element(const ISequence* self, int offset) {
+    return ((const ElementArray*)self->data)->elements[offset];
+}
+
+static int element_array_get_length(const ISequence* self) {
+    return ((const ElementArray*)self->data)->length;
+}
+
+static const uint32_t* element_array_get_elements(const ISequence* self) {
+    return ((const ElementArray*)self->data)->elements;
+}
+
+static bool element_array_is_strongly_equal(const ISequence* self, int offset1, int offset2) {
+    const ElementArray* array = (const ElementArray*)self->data;
+    return array->elements[offset1] == array->elements[offset2];
+}
+
+static void element_array_destroy(ISequence* self) {
+    (void)self;  // Stack-allocated, elements not owned
+}
+
+static void element_array_sequence_init(ISequence* iface, ElementArray* array,
+                                        const uint32_t* elements, int length) {
+    array->elements = elements;
+    array->length = length;
+    memset(iface, 0, sizeof(*iface));
+    iface->data = array;
+    iface->getElement = element_array_get_element;
+    iface->getLength = element_array_get_length;
+    iface->getElements = element_array_get_elements;
+    iface->isStronglyEqual = element_array_is_strongly_equal;
+    iface->destroy = element_array_destroy;
+}
+
+/**
+ * Token IDs of seq and the element offset where each token starts
+ * (starts[count] = seq->length). IDs are perfect hashes of the tokens'
+ * elements, shared through map by both sides.
+ * @return false on allocation failure
+ */
+static bool tokenize_char_sequence(const CharSequence* seq, StringHashMap* map,
+                                   uint32_t** out_ids, int** out_starts, int* out_count) {
+    uint32_t* ids = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * (size_t)(seq->length + 1));
+    int* starts = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(seq->length + 1));
+    if (!ids || !starts) {
+        diff_scratch_free(ids);
+        diff_scratch_free(starts);
+        return false;
+    }
+    int count = 0;
+    for (int offset = 0; offset < seq->length; count++) {
+        int end = char_sequence_token_end(seq, offset);
+        starts[count] = offset;
+        ids[count] = string_hash_map_get_or_create_n(map, (const char*)(seq->elements + offset),
+                                                     sizeof(uint32_t) * (size_t)(end - offset));
+        offset = end;
+    }
+    starts[count] = seq->length;
+    *out_ids = ids;
+    *out_starts = starts;
+    *out_count = count;
+    return true;
+}
+
+static bool scratch_diffs_append(SequenceDiffArray* arr, SequenceDiff diff) {
+    if (arr->count >= arr->capacity) {
+        int capacity = arr->capacity == 0 ? 8 : arr->capacity * 2;
+        SequenceDiff* diffs = (SequenceDiff*)diff_scratch_realloc(arr->diffs,
+                                                                  sizeof(SequenceDiff) * (size_t)capacity);
+        if (!diffs) return false;
+        arr->diffs = diffs;
+        arr->capacity = capacity;
+    }
+    arr->diffs[arr->count++] = diff;
+    return true;
+}
+
+/** DP or O(ND) on two element sequences, as for a character range */
+static SequenceDiffArray* diff_elements(const ISequence* seq1, const ISequence* seq2,
+                                        const CharLevelOptions* options, int timeout_ms,
+                                        bool* hit_timeout) {
+    int len1 = seq1->getLength(seq1);
+    int len2 = seq2->getLength(seq2);
+    if (char_range_uses_dp(seq1, seq2, len1, len2, &options->engine)) {
+        SequenceDiffArray* diffs = myers_dp_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout,
+                                                           NULL, NULL);
+        if (diffs) diff_engine_count(options->engine_counts, DIFF_ENGINE_DP);
+        return diffs;
+    }
+    SequenceDiffArray* diffs = myers_nd_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout);
+    if (diffs) diff_engine_count(options->engine_counts, DIFF_ENGINE_MYERS);
+    return diffs;
+}
+
+/**
+ * Character diffs of seq1 -> seq2, computed token first (see above)
+ * @return Scratch-allocated diffs in character offsets, NULL on failure
+ */
+static SequenceDiffArray* token_first_diff(const CharSequence* seq1, const CharSequence* seq2,
+                                           const CharLevelOptions* options, int timeout_ms,
+                                           bool* hit_timeout) {
+    StringHashMap* map = string_hash_map_create();
+    if (!map) return NULL;
+    uint32_t* ids1 = NULL;
+    uint32_t* ids2 = NULL;
+    int* starts1 = NULL;
+    int* starts2 = NULL;
+    int count1 = 0;
+    int count2 = 0;
+    bool ok = tokenize_char_sequence(seq1, map, &ids1, &starts1, &count1) &&
+              tokenize_char_sequence(seq2, map, &ids2, &starts2, &count2);
+    string_hash_map_destroy(map);
+
+    SequenceDiffArray* token_diffs = NULL;
+    if (ok) {
+        ISequence tokens1, tokens2;
+        ElementArray array1, array2;
+        element_array_sequence_init(&tokens1, &array1, ids1, count1);
+        element_array_sequence_init(&tokens2, &array2, ids2, count2);
+        token_diffs = diff_elements(&tokens1, &tokens2, options, timeout_ms, hit_timeout);
+    }
+
+    SequenceDiffArray* diffs = token_diffs
+        ? (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray)) : NULL;
+    ok = diffs != NULL;
+    if (diffs) {
+        diffs->diffs = NULL;
+        diffs->count = 0;
+        diffs->capacity = 0;
+    }
+
+    bool budgeted = options->timeout && options->timeout->timeout_ms > 0;
+    for (int i = 0; ok && i < token_diffs->count; i++) {
+        const SequenceDiff* token = &token_diffs->diffs[i];
+        SequenceDiff range = {
+            .seq1_start = starts1[token->seq1_start],
+            .seq1_end = starts1[token->seq1_end],
+            .seq2_start = starts2[token->seq2_start],
+            .seq2_end = starts2[token->seq2_end]
+        };
+        int remaining_ms = budgeted ? timeout_remaining_ms(options->timeout) : 0;
+        if (range.seq1_start == range.seq1_end || range.seq2_start == range.seq2_end ||
+            *hit_timeout || (budgeted && remaining_ms == 0)) {
+            // Pure insertion/deletion, or no budget left: the range as is
+            if (budgeted && remaining_ms == 0) *hit_timeout = true;
+            ok = scratch_diffs_append(diffs, range);
+            continue;
+        }
+
+        ISequence chars1, chars2;
+        ElementArray slice1, slice2;
+        element_array_sequence_init(&chars1, &slice1, seq1->elements + range.seq1_start,
+                                    range.seq1_end - range.seq1_start);
+        element_array_sequence_init(&chars2, &slice2, seq2->elements + range.seq2_start,
+                                    range.seq2_end - range.seq2_start);
+        SequenceDiffArray* inner = diff_elements(&chars1, &chars2, options, remaining_ms,
+                                                 hit_timeout);
+        if (!inner) {
+            ok = false;
+            break;
+        }
+        for (int j = 0; ok && j < inner->count; j++) {
+            SequenceDiff d = inner->diffs[j];
+            d.seq1_start += range.seq1_start;
+            d.seq1_end += range.seq1_start;
+            d.seq2_start += range.seq2_start;
+            d.seq2_end += range.seq2_start;
+            ok = scratch_diffs_append(diffs, d);
+        }
+        diff_scratch_free(inner->diffs);
+        diff_scratch_free(inner);
+    }
+
+    if (token_diffs) {
+        diff_scratch_free(token_diffs->diffs);
+        diff_scratch_free(token_diffs);
+    }
+    diff_scratch_free(ids1);
+    diff_scratch_free(ids2);
+    diff_scratch_free(starts1);
+    diff_scratch_free(starts2);
+    if (!ok && diffs) {
+        diff_scratch_free(diffs->diffs);
+        diff_scratch_free(diffs);
+        return NULL;
+    }
+    return diffs;
+}
+
 /**
  * Main refinement function - VSCode's refineDiff() - FULL PARITY
  */
+/**
+ * Working memory of a CharSequence over a range: element and category per
+ * byte, three offsets per line (see CharSequence). Not VSCode.
+ */
+static int64_t char_range_sequence_bytes(const char** lines, const int* lengths, int line_count,
+                                         const CharRange* range) {
+    int64_t bytes = 0;
+    for (int line = range->start_line; line <= range->end_line && line <= line_count; line++) {
+        bytes += (int64_t)diff_line_length(lines, lengths, line - 1) * (int64_t)(sizeof(uint32_t) + sizeof(uint8_t)) +
+                 (int64_t)(3 * sizeof(int));
+    }
+    return bytes;
+}
+
 RangeMappingArray* refine_diff_char_level(
     const SequenceDiff* line_diff,
     const char** lines_a, int len_a,
     const char** lines_b, int len_b,
     const CharLevelOptions* options,
     bool* out_hit_timeout
+) {
+    return refine_diff_char_level_n(line_diff, lines_a, NULL, len_a, lines_b, NULL, len_b,
+                                    options, out_hit_timeout);
+}
+
+RangeMappingArray* refine_diff_char_level_n(
+    const SequenceDiff* line_diff,
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    const CharLevelOptions* options,
+    bool* out_hit_timeout
 ) {
     // Initialize timeout flag
     if (out_hit_timeout) {
@@ -819,19 +1071,33 @@ RangeMappingArray* refine_diff_char_level(
         original_line_range,
         modified_line_range,
         lines_a,
+        lengths_a,
         len_a,
         lines_b,
+        lengths_b,
         len_b
     );
+    
+    // Over the memory budget the hunk keeps its line-level change only
+    // (one mapping over the whole range, not VSCode)
+    if (diff_get_thread_memory_budget() &&
+        !diff_memory_fits(char_range_sequence_bytes(lines_a, lengths_a, len_a, &base_range.original) +
+                          char_range_sequence_bytes(lines_b, lengths_b, len_b, &base_range.modified))) {
+        RangeMappingArray* coarse = create_range_mapping_array(1);
+        if (coarse) add_range_mapping(coarse, &base_range);
+        return coarse;
+    }
 
-    ISequence* seq1_iface = char_sequence_create_from_range(
+    ISequence* seq1_iface = char_sequence_create_from_range_n(
         lines_a,
+        lengths_a,
         len_a,
         &base_range.original,
         options->consider_whitespace_changes
     );
-    ISequence* seq2_iface = char_sequence_create_from_range(
+    ISequence* seq2_iface = char_sequence_create_from_range_n(
         lines_b,
+        lengths_b,
         len_b,
         &base_range.modified,
         options->consider_whitespace_changes
@@ -859,12 +1125,34 @@ RangeMappingArray* refine_diff_char_level(
     bool hit_timeout = false;
     SequenceDiffArray* diffs;
     
-    if (len1 + len2 < 500) {
+    // Hand the remainder of the shared budget to the algorithm
+    // (VSCode passes the same ITimeout into every refineDiff call)
+    int timeout_ms = 0;
+    if (options->timeout && options->timeout->timeout_ms > 0) {
+        timeout_ms = timeout_remaining_ms(options->timeout);
+    }
+    
+    if (options->timeout && options->timeout->timeout_ms > 0 && timeout_ms == 0) {
+        // Budget already exhausted: whole-range diff (DiffAlgorithmResult.trivial)
+        hit_timeout = true;
+        diffs = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
+        if (diffs) {
+            diffs->diffs = (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff));
+            diffs->diffs[0] = (SequenceDiff){0, len1, 0, len2};
+            diffs->count = (len1 > 0 || len2 > 0) ? 1 : 0;
+            diffs->capacity = 1;
+        }
+    } else if (options->token_min_chars > 0 && len1 + len2 >= options->token_min_chars) {
+        // Not VSCode: very long hunks are diffed token first
+        diffs = token_first_diff(seq1, seq2, options, timeout_ms, &hit_timeout);
+    } else if (char_range_uses_dp(seq1_iface, seq2_iface, len1, len2, &options->engine)) {
         // Use DP algorithm for small character sequences
-        diffs = myers_dp_diff_algorithm(seq1_iface, seq2_iface, 0, &hit_timeout, NULL, NULL);
+        diffs = myers_dp_diff_algorithm(seq1_iface, seq2_iface, timeout_ms, &hit_timeout, NULL, NULL);
+        if (diffs) diff_engine_count(options->engine_counts, DIFF_ENGINE_DP);
     } else {
         // Use O(ND) algorithm for large character sequences
-        diffs = myers_nd_diff_algorithm(seq1_iface, seq2_iface, 0, &hit_timeout);
+        diffs = myers_nd_diff_algorithm(seq1_iface, seq2_iface, timeout_ms, &hit_timeout);
+        if (diffs) diff_engine_count(options->engine_counts, DIFF_ENGINE_MYERS);
     }
     
     if (!diffs) {
@@ -877,17 +1165,11 @@ RangeMappingArray* refine_diff_char_level(
     optimize_sequence_diffs(seq1_iface, seq2_iface, diffs);
     
     // Step 4: extendDiffsToEntireWordIfAppropriate() - Word boundaries
-    SequenceDiffArray* extended = extend_diffs_to_entire_word(seq1, seq2, diffs, false, false);
-    free(diffs->diffs);
-    free(diffs);
-    diffs = extended;
+    extend_diffs_to_entire_word(seq1, seq2, diffs, false, false);
     
     // Step 5: extendDiffsToEntireWordIfAppropriate() for subwords (if enabled)
     if (options->extend_to_subwords) {
-        extended = extend_diffs_to_entire_word(seq1, seq2, diffs, true, true);
-        free(diffs->diffs);
-        free(diffs);
-        diffs = extended;
+        extend_diffs_to_entire_word(seq1, seq2, diffs, true, true);
     }
 
     // Step 6: removeShortMatches() - Remove ≤2 char gaps
@@ -899,8 +1181,8 @@ RangeMappingArray* refine_diff_char_level(
     // Step 8: Translate to RangeMapping with (line, column) positions
     RangeMappingArray* result = create_range_mapping_array(diffs->count);
     if (!result) {
-        free(diffs->diffs);
-        free(diffs);
+        diff_scratch_free(diffs->diffs);
+        diff_scratch_free(diffs);
         seq1_iface->destroy(seq1_iface);
         seq2_iface->destroy(seq2_iface);
         return NULL;
@@ -920,14 +1202,41 @@ RangeMappingArray* refine_diff_char_level(
     }
     
     // Cleanup
-    free(diffs->diffs);
-    free(diffs);
+    diff_scratch_free(diffs->diffs);
+    diff_scratch_free(diffs);
     seq1_iface->destroy(seq1_iface);
     seq2_iface->destroy(seq2_iface);
     
     return result;
 }
 
+/**
+ * refine_diff_char_level_n() on an arena of workspace (not VSCode).
+ * 
+ * Every intermediate is scratch memory, so the whole refinement runs inside
+ * the arena; only the returned array is on the heap.
+ */
+RangeMappingArray* refine_diff_char_level_ex(
+    DiffWorkspace* workspace,
+    const SequenceDiff* line_diff,
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    const CharLevelOptions* options,
+    bool* out_hit_timeout
+) {
+    DiffArena* arena = workspace ? diff_workspace_acquire_arena(workspace) : NULL;
+    DiffArena* previous = arena ? diff_scratch_begin(arena) : NULL;
+    RangeMappingArray* result = refine_diff_char_level_n(line_diff,
+                                                         lines_a, lengths_a, len_a,
+                                                         lines_b, lengths_b, len_b,
+                                                         options, out_hit_timeout);
+    if (arena) {
+        diff_scratch_end(previous);
+        diff_workspace_release_arena(workspace, arena);
+    }
+    return result;
+}
+
 /**
  * Refine all line-level diffs - VSCode Parity
  */
@@ -991,6 +1300,6 @@ RangeMappingArray* refine_all_diffs_char_level(
  */
 void free_range_mapping_array(RangeMappingArray* arr) {
     if (!arr) return;
-    if (arr->mappings) free(arr->mappings);
-    free(arr);
+    if (arr->mappings) diff_free(arr->mappings);
+    diff_free(arr);
 }
@@ -0,0 +1,1093 @@
+/**
+ * Moved Block Detection - VSCODE PARITY
+ *
+ * C port of computeMovedLines.ts. Pipeline:
+ * 1. computeMovesFromSimpleDeletionsToSimpleInsertions - histogram similarity
+ * 2. computeUnchangedMoves - 3-line hash windows over the remaining changes
+ * 3. joinCloseConsecutiveMoves, short-move filter, removeMovesInSameDiff
+ *
+ * VSCode keys its 3-line window map by the string "h1:h2:h3". Here the
+ * windows are (h1, h2, h3, line) tuples sorted once and binary searched, which
+ * enumerates the same candidates in the same order without building strings.
+ *
+ * JavaScript Note: strings are indexed by UTF-16 code units (charCodeAt, length)
+ * C Note: lines are converted with utf8_to_utf16 wherever VSCode indexes them
+ *
+ * VSCode Reference:
+ * src/vs/editor/common/diff/defaultLinesDiffComputer/computeMovedLines.ts
+ */
+
+#include "compute_moved_lines.h"
+#include "diff_allocator.h"
+#include "myers.h"
+#include "range_mapping.h"
+#include "sequence.h"
+#include "utf8_utils.h"
+#include "utils.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MOVE_MIN_LINES 3                 // Window size and minimum move length
+#define MOVE_SIMILARITY_THRESHOLD 0.90   // Deletion/insertion histogram similarity
+#define SIMILAR_LINE_MAX_LENGTH 300      // areLinesSimilar() gives up above this
+#define MOVE_MIN_TEXT_LENGTH 15          // Short-move filter (trimmed text length)
+
+// ============================================================================
+// Small Helpers
+// ============================================================================
+
+/** str.trim() as a (pointer, length) view - same isspace rule as the line hashes */
+static const char* trim_span(const char* str, size_t* out_len) {
+    while (*str && isspace((unsigned char)*str)) {
+        str++;
+    }
+    const char* end = str + strlen(str);
+    while (end > str && isspace((unsigned char)*(end - 1))) {
+        end--;
+    }
+    *out_len = (size_t)(end - str);
+    return str;
+}
+
+/** VSCode isSpace(): space or tab only */
+static bool is_space_unit(uint16_t unit) {
+    return unit == ' ' || unit == '\t';
+}
+
+static int line_range_length(LineRange range) {
+    return range.end_line - range.start_line;
+}
+
+static LineRange line_range_delta(LineRange range, int delta) {
+    LineRange result = { range.start_line + delta, range.end_line + delta };
+    return result;
+}
+
+static bool moved_text_array_push(MovedTextArray* arr, LineRange original, LineRange modified) {
+    if (arr->count >= arr->capacity) {
+        int new_capacity = arr->capacity == 0 ? 8 : arr->capacity * 2;
+        MovedText* new_moves = (MovedText*)diff_realloc(arr->moves, new_capacity * sizeof(MovedText));
+        if (!new_moves) return false;
+        arr->moves = new_moves;
+        arr->capacity = new_capacity;
+    }
+    MovedText* move = &arr->moves[arr->count++];
+    move->original = original;
+    move->modified = modified;
+    move->changes = NULL;
+    move->change_count = 0;
+    return true;
+}
+
+typedef struct {
+    MovedText move;
+    int order;
+} OrderedMove;
+
+static int compare_ordered_moves(const void* a, const void* b) {
+    const OrderedMove* ma = (const OrderedMove*)a;
+    const OrderedMove* mb = (const OrderedMove*)b;
+    if (ma->move.original.start_line != mb->move.original.start_line) {
+        return ma->move.original.start_line < mb->move.original.start_line ? -1 : 1;
+    }
+    return ma->order - mb->order;
+}
+
+/** moves.sort(compareBy(m => m.original.startLineNumber)) - stable, like Array.sort */
+static bool sort_moves_by_original_start(MovedTextArray* moves) {
+    if (moves->count < 2) return true;
+    OrderedMove* ordered = (OrderedMove*)diff_malloc(moves->count * sizeof(OrderedMove));
+    if (!ordered) return false;
+    for (int i = 0; i < moves->count; i++) {
+        ordered[i].move = moves->moves[i];
+        ordered[i].order = i;
+    }
+    qsort(ordered, moves->count, sizeof(OrderedMove), compare_ordered_moves);
+    for (int i = 0; i < moves->count; i++) {
+        moves->moves[i] = ordered[i].move;
+    }
+    diff_free(ordered);
+    return true;
+}
+
+/**
+ * findLastMonotonous(changes, c => c.modified.startLineNumber < limit)
+ * Binary search; -1 if no change qualifies.
+ */
+static int find_last_modified_start_before(const DetailedLineRangeMapping* const* changes,
+                                           int count, int limit) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (changes[mid]->modified.start_line < limit) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo - 1;
+}
+
+/**
+ * MonotonousArray.findLastMonotonous(c => c.original.startLineNumber < limit)
+ *
+ * VSCode's MonotonousArray keeps a cursor that only moves forward, even when
+ * the predicate changes between calls. The cursor is kept here as well so
+ * that interleaved queries return exactly what VSCode returns.
+ */
+static int monotonous_find_last_original_start_before(const DetailedLineRangeMapping* const* changes,
+                                                      int count, int* cursor, int limit) {
+    while (*cursor < count && changes[*cursor]->original.start_line < limit) {
+        (*cursor)++;
+    }
+    return *cursor - 1;
+}
+
+// ============================================================================
+// LineRangeSet
+// ============================================================================
+
+/**
+ * Sorted, non-touching set of line ranges
+ *
+ * VSCode Reference: src/vs/editor/common/core/lineRange.ts LineRangeSet
+ */
+typedef struct {
+    LineRange* ranges;
+    int count;
+    int capacity;
+} LineRangeSet;
+
+static void line_range_set_free(LineRangeSet* set) {
+    diff_free(set->ranges);
+    set->ranges = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+static bool line_range_set_insert(LineRangeSet* set, int idx, LineRange range) {
+    if (set->count >= set->capacity) {
+        int new_capacity = set->capacity == 0 ? 8 : set->capacity * 2;
+        LineRange* new_ranges = (LineRange*)diff_realloc(set->ranges, new_capacity * sizeof(LineRange));
+        if (!new_ranges) return false;
+        set->ranges = new_ranges;
+        set->capacity = new_capacity;
+    }
+    memmove(&set->ranges[idx + 1], &set->ranges[idx], (set->count - idx) * sizeof(LineRange));
+    set->ranges[idx] = range;
+    set->count++;
+    return true;
+}
+
+/** First index with end_line >= line (or count) */
+static int line_range_set_first_ending_at_or_after(const LineRangeSet* set, int line) {
+    int lo = 0, hi = set->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (set->ranges[mid].end_line >= line) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+/** Last index with start_line <= line (or -1) */
+static int line_range_set_last_starting_at_or_before(const LineRangeSet* set, int line) {
+    int lo = 0, hi = set->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (set->ranges[mid].start_line <= line) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo - 1;
+}
+
+/** VSCode: LineRangeSet.addRange() - merges every range it touches */
+static bool line_range_set_add(LineRangeSet* set, LineRange range) {
+    int i = line_range_set_first_ending_at_or_after(set, range.start_line);
+    int j = line_range_set_last_starting_at_or_before(set, range.end_line) + 1;
+    if (i == j) {
+        return line_range_set_insert(set, i, range);
+    }
+    LineRange joined = line_range_join(line_range_join(set->ranges[i], set->ranges[j - 1]), range);
+    set->ranges[i] = joined;
+    memmove(&set->ranges[i + 1], &set->ranges[j], (set->count - j) * sizeof(LineRange));
+    set->count -= (j - i) - 1;
+    return true;
+}
+
+/** VSCode: LineRangeSet.contains() */
+static bool line_range_set_contains(const LineRangeSet* set, int line) {
+    int idx = line_range_set_last_starting_at_or_before(set, line);
+    return idx >= 0 && set->ranges[idx].end_line > line;
+}
+
+/** VSCode: LineRangeSet.subtractFrom() - parts of range not covered by set */
+static bool line_range_set_subtract_from(const LineRangeSet* set, LineRange range, LineRangeSet* out) {
+    out->count = 0;
+    int i = line_range_set_first_ending_at_or_after(set, range.start_line);
+    int j = line_range_set_last_starting_at_or_before(set, range.end_line) + 1;
+    if (i == j) {
+        return line_range_set_insert(out, 0, range);
+    }
+    int start_line = range.start_line;
+    for (int k = i; k < j; k++) {
+        const LineRange* r = &set->ranges[k];
+        if (r->start_line > start_line) {
+            LineRange part = { start_line, r->start_line };
+            if (!line_range_set_insert(out, out->count, part)) return false;
+        }
+        start_line = r->end_line;
+    }
+    if (start_line < range.end_line) {
+        LineRange part = { start_line, range.end_line };
+        if (!line_range_set_insert(out, out->count, part)) return false;
+    }
+    return true;
+}
+
+/** VSCode: LineRangeSet.getIntersection() - keeps non-empty intersections only */
+static bool line_range_set_intersect(const LineRangeSet* a, const LineRangeSet* b, LineRangeSet* out) {
+    out->count = 0;
+    int i1 = 0, i2 = 0;
+    while (i1 < a->count && i2 < b->count) {
+        LineRange r1 = a->ranges[i1];
+        LineRange r2 = b->ranges[i2];
+        int start = r1.start_line > r2.start_line ? r1.start_line : r2.start_line;
+        int end = r1.end_line < r2.end_line ? r1.end_line : r2.end_line;
+        if (start < end) {
+            LineRange part = { start, end };
+            if (!line_range_set_insert(out, out->count, part)) return false;
+        }
+        if (r1.end_line < r2.end_line) {
+            i1++;
+        } else {
+            i2++;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Step 1: Simple Deletions -> Simple Insertions
+// ============================================================================
+
+/**
+ * Character histogram of a block of lines (UTF-16 code units plus one '\n'
+ * per line), stored sparsely as (unit, count) pairs sorted by unit.
+ *
+ * VSCode Reference: computeMovedLines.ts class LineRangeFragment
+ */
+typedef struct {
+    uint16_t unit;
+    int count;
+} HistogramBin;
+
+typedef struct {
+    LineRange range;
+    int source;             // Index of the change this fragment came from
+    HistogramBin* bins;
+    int bin_count;
+    int total_count;
+    bool taken;             // Removed from the insertion set
+} LineRangeFragment;
+
+/** Shared dense counters; only touched slots are reset after each fragment */
+typedef struct {
+    int* counts;            // 65536 entries
+    uint16_t* touched;
+    int touched_count;
+    int touched_capacity;
+} HistogramBuilder;
+
+static int compare_units(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+static bool histogram_add(HistogramBuilder* builder, uint16_t unit) {
+    if (builder->counts[unit]++ == 0) {
+        if (builder->touched_count >= builder->touched_capacity) {
+            int new_capacity = builder->touched_capacity == 0 ? 128 : builder->touched_capacity * 2;
+            uint16_t* grown = (uint16_t*)diff_realloc(builder->touched, new_capacity * sizeof(uint16_t));
+            if (!grown) return false;
+            builder->touched = grown;
+            builder->touched_capacity = new_capacity;
+        }
+        builder->touched[builder->touched_count++] = unit;
+    }
+    return true;
+}
+
+static bool line_range_fragment_init(LineRangeFragment* fragment, LineRange range, int source,
+                                     const char** lines, HistogramBuilder* builder) {
+    fragment->range = range;
+    fragment->source = source;
+    fragment->bins = NULL;
+    fragment->bin_count = 0;
+    fragment->total_count = 0;
+    fragment->taken = false;
+
+    bool ok = true;
+    int counter = 0;
+    builder->touched_count = 0;
+    for (int i = range.start_line - 1; i < range.end_line - 1 && ok; i++) {
+        int length = 0;
+        uint16_t* units = utf8_to_utf16(lines[i], &length);
+        if (!units && length > 0) {
+            ok = false;
+            break;
+        }
+        for (int j = 0; j < length && ok; j++) {
+            ok = histogram_add(builder, units[j]);
+        }
+        diff_free(units);
+        counter += length + 1;
+        ok = ok && histogram_add(builder, '\n');
+    }
+
+    if (ok) {
+        qsort(builder->touched, builder->touched_count, sizeof(uint16_t), compare_units);
+        fragment->bins = (HistogramBin*)diff_malloc((builder->touched_count + 1) * sizeof(HistogramBin));
+        ok = fragment->bins != NULL;
+    }
+    for (int k = 0; k < builder->touched_count; k++) {
+        uint16_t unit = builder->touched[k];
+        if (ok) {
+            fragment->bins[k].unit = unit;
+            fragment->bins[k].count = builder->counts[unit];
+        }
+        builder->counts[unit] = 0;
+    }
+    if (ok) {
+        fragment->bin_count = builder->touched_count;
+        fragment->total_count = counter;
+    }
+    return ok;
+}
+
+/**
+ * VSCode: LineRangeFragment.computeSimilarity()
+ * 1 - sum(|histogram difference|) / (total counts)
+ */
+static double line_range_fragment_similarity(const LineRangeFragment* a, const LineRangeFragment* b) {
+    long long sum_differences = 0;
+    int i = 0, j = 0;
+    while (i < a->bin_count || j < b->bin_count) {
+        if (j >= b->bin_count || (i < a->bin_count && a->bins[i].unit < b->bins[j].unit)) {
+            sum_differences += a->bins[i++].count;
+        } else if (i >= a->bin_count || b->bins[j].unit < a->bins[i].unit) {
+            sum_differences += b->bins[j++].count;
+        } else {
+            int diff = a->bins[i++].count - b->bins[j++].count;
+            sum_differences += diff < 0 ? -diff : diff;
+        }
+    }
+    return 1.0 - ((double)sum_differences / (double)(a->total_count + b->total_count));
+}
+
+/**
+ * Upper bound of line_range_fragment_similarity(): the histograms differ by
+ * at least the difference of their totals. Used to skip insertions that
+ * cannot beat the current best, without changing which one wins.
+ */
+static double line_range_fragment_similarity_bound(const LineRangeFragment* a, const LineRangeFragment* b) {
+    int diff = a->total_count - b->total_count;
+    if (diff < 0) diff = -diff;
+    return 1.0 - ((double)diff / (double)(a->total_count + b->total_count));
+}
+
+static void line_range_fragments_free(LineRangeFragment* fragments, int count) {
+    if (!fragments) return;
+    for (int i = 0; i < count; i++) {
+        diff_free(fragments[i].bins);
+    }
+    diff_free(fragments);
+}
+
+/**
+ * Pair each pure deletion (3+ lines) with the most similar pure insertion.
+ *
+ * VSCode Reference: computeMovedLines.ts computeMovesFromSimpleDeletionsToSimpleInsertions()
+ * VSCode Parity: 100%
+ */
+static bool compute_moves_from_simple_deletions_to_simple_insertions(
+    const DetailedLineRangeMappingArray* changes,
+    const char** original_lines,
+    const char** modified_lines,
+    const Timeout* timeout,
+    MovedTextArray* moves,
+    bool* excluded_changes
+) {
+    int deletion_count = 0, insertion_count = 0;
+    for (int i = 0; i < changes->count; i++) {
+        const DetailedLineRangeMapping* c = &changes->mappings[i];
+        if (line_range_length(c->modified) == 0 && line_range_length(c->original) >= MOVE_MIN_LINES) {
+            deletion_count++;
+        }
+        if (line_range_length(c->original) == 0 && line_range_length(c->modified) >= MOVE_MIN_LINES) {
+            insertion_count++;
+        }
+    }
+    if (deletion_count == 0 || insertion_count == 0) {
+        return true;
+    }
+
+    HistogramBuilder builder = { NULL, NULL, 0, 0 };
+    builder.counts = (int*)diff_calloc(65536, sizeof(int));
+    LineRangeFragment* deletions = (LineRangeFragment*)diff_calloc(deletion_count, sizeof(LineRangeFragment));
+    LineRangeFragment* insertions = (LineRangeFragment*)diff_calloc(insertion_count, sizeof(LineRangeFragment));
+    bool ok = builder.counts && deletions && insertions;
+
+    int d = 0, n = 0;
+    for (int i = 0; i < changes->count && ok; i++) {
+        const DetailedLineRangeMapping* c = &changes->mappings[i];
+        if (line_range_length(c->modified) == 0 && line_range_length(c->original) >= MOVE_MIN_LINES) {
+            ok = line_range_fragment_init(&deletions[d++], c->original, i, original_lines, &builder);
+        }
+        if (ok && line_range_length(c->original) == 0 && line_range_length(c->modified) >= MOVE_MIN_LINES) {
+            ok = line_range_fragment_init(&insertions[n++], c->modified, i, modified_lines, &builder);
+        }
+    }
+
+    for (int i = 0; i < deletion_count && ok; i++) {
+        const LineRangeFragment* deletion = &deletions[i];
+        double highest_similarity = -1;
+        int best = -1;
+        for (int j = 0; j < insertion_count; j++) {
+            const LineRangeFragment* insertion = &insertions[j];
+            if (insertion->taken) continue;
+            double bound = line_range_fragment_similarity_bound(deletion, insertion);
+            if (bound <= highest_similarity || bound <= MOVE_SIMILARITY_THRESHOLD) continue;
+            double similarity = line_range_fragment_similarity(deletion, insertion);
+            if (similarity > highest_similarity) {
+                highest_similarity = similarity;
+                best = j;
+            }
+        }
+        if (highest_similarity > MOVE_SIMILARITY_THRESHOLD && best >= 0) {
+            insertions[best].taken = true;
+            ok = moved_text_array_push(moves, deletion->range, insertions[best].range);
+            excluded_changes[deletion->source] = true;
+            excluded_changes[insertions[best].source] = true;
+        }
+        if (!timeout_is_valid(timeout)) {
+            break;
+        }
+    }
+
+    line_range_fragments_free(deletions, d);
+    line_range_fragments_free(insertions, n);
+    diff_free(builder.counts);
+    diff_free(builder.touched);
+    return ok;
+}
+
+// ============================================================================
+// Step 2: Unchanged Moves (3-line hash windows)
+// ============================================================================
+
+/**
+ * VSCode: areLinesSimilar() - used to grow a move over neighbouring lines.
+ *
+ * Reproduces VSCode exactly, including its quirks: the char sequences are
+ * built from Range(1, 1, 1, line.length) (so they stop one unit short), and
+ * common characters are looked up in the untrimmed line1 by sequence offset.
+ */
+static bool are_lines_similar(const char* line1, const char* line2, const Timeout* timeout) {
+    size_t trimmed1_length, trimmed2_length;
+    const char* trimmed1 = trim_span(line1, &trimmed1_length);
+    const char* trimmed2 = trim_span(line2, &trimmed2_length);
+    if (trimmed1_length == trimmed2_length && memcmp(trimmed1, trimmed2, trimmed1_length) == 0) {
+        return true;
+    }
+
+    int length1 = utf8_to_utf16_length(line1);
+    int length2 = utf8_to_utf16_length(line2);
+    if (length1 > SIMILAR_LINE_MAX_LENGTH && length2 > SIMILAR_LINE_MAX_LENGTH) {
+        return false;
+    }
+
+    // An expired timeout makes Myers return the trivial diff: nothing in common
+    int timeout_ms = 0;
+    if (timeout && timeout->timeout_ms > 0) {
+        timeout_ms = timeout_remaining_ms(timeout);
+        if (timeout_ms <= 0) return false;
+    }
+
+    // LinesSliceCharSequence([line], Range(1, 1, 1, line.length)): char_sequence
+    // clips after the leading whitespace, so shift the end column by its width
+    int leading_ws1 = (int)(trimmed1 - line1);
+    int leading_ws2 = (int)(trimmed2 - line2);
+    CharRange range1 = { 1, 1, 1, length1 + leading_ws1 };
+    CharRange range2 = { 1, 1, 1, length2 + leading_ws2 };
+    ISequence* seq1 = char_sequence_create_from_range(&line1, 1, &range1, false);
+    ISequence* seq2 = char_sequence_create_from_range(&line2, 1, &range2, false);
+    SequenceDiffArray* diffs = NULL;
+    if (seq1 && seq2) {
+        bool hit_timeout = false;
+        diffs = myers_nd_diff_algorithm(seq1, seq2, timeout_ms, &hit_timeout);
+    }
+    if (seq1) seq1->destroy(seq1);
+    if (seq2) seq2->destroy(seq2);
+
+    int unit_count1 = 0;
+    uint16_t* units1 = utf8_to_utf16(line1, &unit_count1);
+    uint16_t* longer_units = NULL;
+    if (length1 <= length2) {
+        int unit_count2 = 0;
+        longer_units = utf8_to_utf16(line2, &unit_count2);
+    }
+    if (!diffs || (!units1 && length1 > 0) || (length1 <= length2 && !longer_units && length2 > 0)) {
+        if (diffs) {
+            diff_scratch_free(diffs->diffs);
+            diff_scratch_free(diffs);
+        }
+        diff_free(units1);
+        diff_free(longer_units);
+        return false;
+    }
+
+    // SequenceDiff.invert(result.diffs, line1.length): count the gaps
+    int common_non_space_count = 0;
+    int gap_start = 0;
+    for (int i = 0; i <= diffs->count; i++) {
+        int gap_end = i < diffs->count ? diffs->diffs[i].seq1_start : length1;
+        for (int idx = gap_start; idx < gap_end; idx++) {
+            if (!is_space_unit(units1[idx])) {
+                common_non_space_count++;
+            }
+        }
+        if (i < diffs->count) {
+            gap_start = diffs->diffs[i].seq1_end;
+        }
+    }
+
+    // countNonWsChars(longer line), iterating over line1.length units
+    const uint16_t* longer = length1 > length2 ? units1 : longer_units;
+    int longer_line_length = 0;
+    for (int i = 0; i < length1; i++) {
+        if (!is_space_unit(longer[i])) {
+            longer_line_length++;
+        }
+    }
+
+    diff_scratch_free(diffs->diffs);
+    diff_scratch_free(diffs);
+    diff_free(units1);
+    diff_free(longer_units);
+
+    return (double)common_non_space_count / (double)longer_line_length > 0.6 &&
+           longer_line_length > 10;
+}
+
+typedef struct {
+    uint32_t hashes[MOVE_MIN_LINES];
+    int line;               // 1-based start of the window in the original
+} HashWindow;
+
+static int compare_hash_windows(const void* a, const void* b) {
+    const HashWindow* wa = (const HashWindow*)a;
+    const HashWindow* wb = (const HashWindow*)b;
+    for (int k = 0; k < MOVE_MIN_LINES; k++) {
+        if (wa->hashes[k] != wb->hashes[k]) {
+            return wa->hashes[k] < wb->hashes[k] ? -1 : 1;
+        }
+    }
+    return wa->line - wb->line;
+}
+
+/** First window whose hashes are >= key (windows sorted by compare_hash_windows) */
+static int hash_windows_lower_bound(const HashWindow* windows, int count, const uint32_t* key) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = 0;
+        for (int k = 0; k < MOVE_MIN_LINES && cmp == 0; k++) {
+            if (windows[mid].hashes[k] != key[k]) {
+                cmp = windows[mid].hashes[k] < key[k] ? -1 : 1;
+            }
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+typedef struct {
+    LineRange original;
+    LineRange modified;
+} PossibleMapping;
+
+typedef struct {
+    int length;             // modifiedLineRange.length
+    int index;
+} MappingOrder;
+
+static int compare_mapping_order(const void* a, const void* b) {
+    const MappingOrder* ma = (const MappingOrder*)a;
+    const MappingOrder* mb = (const MappingOrder*)b;
+    if (ma->length != mb->length) {
+        return mb->length - ma->length;     // Longest first
+    }
+    return ma->index - mb->index;           // Stable
+}
+
+static int compare_changes_by_modified_start(const void* a, const void* b) {
+    const DetailedLineRangeMapping* ca = *(const DetailedLineRangeMapping* const*)a;
+    const DetailedLineRangeMapping* cb = *(const DetailedLineRangeMapping* const*)b;
+    if (ca->modified.start_line != cb->modified.start_line) {
+        return ca->modified.start_line < cb->modified.start_line ? -1 : 1;
+    }
+    // Array.sort is stable: fall back to the original order
+    return ca < cb ? -1 : (ca > cb ? 1 : 0);
+}
+
+static bool int_array_push(int** items, int* count, int* capacity, int value) {
+    if (*count >= *capacity) {
+        int new_capacity = *capacity == 0 ? 16 : *capacity * 2;
+        int* grown = (int*)diff_realloc(*items, new_capacity * sizeof(int));
+        if (!grown) return false;
+        *items = grown;
+        *capacity = new_capacity;
+    }
+    (*items)[(*count)++] = value;
+    return true;
+}
+
+/**
+ * Collect every run of 3-line windows that appears in a change on both sides,
+ * extending a run while consecutive windows continue it.
+ *
+ * VSCode Reference: computeMovedLines.ts computeUnchangedMoves() (first half)
+ * @return false on allocation failure; *timed_out is set when VSCode would return []
+ */
+static bool collect_possible_mappings(
+    const DetailedLineRangeMapping* const* changes,
+    int change_count,
+    const uint32_t* hashed_original,
+    const uint32_t* hashed_modified,
+    const Timeout* timeout,
+    PossibleMapping** out_mappings,
+    int* out_count,
+    bool* timed_out
+) {
+    *out_mappings = NULL;
+    *out_count = 0;
+    *timed_out = false;
+
+    // original3LineHashes: sorted by (hashes, line), which is VSCode's per-key insertion order
+    int window_count = 0;
+    for (int c = 0; c < change_count; c++) {
+        int length = line_range_length(changes[c]->original);
+        if (length >= MOVE_MIN_LINES) window_count += length - (MOVE_MIN_LINES - 1);
+    }
+    HashWindow* windows = (HashWindow*)diff_malloc((window_count + 1) * sizeof(HashWindow));
+    if (!windows) return false;
+    int w = 0;
+    for (int c = 0; c < change_count; c++) {
+        const LineRange* range = &changes[c]->original;
+        for (int i = range->start_line; i < range->end_line - 2; i++) {
+            for (int k = 0; k < MOVE_MIN_LINES; k++) {
+                windows[w].hashes[k] = hashed_original[i - 1 + k];
+            }
+            windows[w].line = i;
+            w++;
+        }
+    }
+    qsort(windows, window_count, sizeof(HashWindow), compare_hash_windows);
+
+    PossibleMapping* mappings = NULL;
+    int mapping_count = 0, mapping_capacity = 0;
+    int* last = NULL;
+    int last_count = 0, last_capacity = 0;
+    int* next = NULL;
+    int next_count = 0, next_capacity = 0;
+    bool ok = true;
+
+    for (int c = 0; c < change_count && ok; c++) {
+        const LineRange* modified = &changes[c]->modified;
+        last_count = 0;
+        for (int i = modified->start_line; i < modified->end_line - 2 && ok; i++) {
+            const uint32_t* key = &hashed_modified[i - 1];
+            LineRange current_modified = { i, i + MOVE_MIN_LINES };
+            next_count = 0;
+
+            for (int wi = hash_windows_lower_bound(windows, window_count, key);
+                 wi < window_count && ok &&
+                 memcmp(windows[wi].hashes, key, sizeof(windows[wi].hashes)) == 0;
+                 wi++) {
+                LineRange range = { windows[wi].line, windows[wi].line + MOVE_MIN_LINES };
+
+                // Does this match extend some last match?
+                bool extended = false;
+                for (int l = 0; l < last_count; l++) {
+                    PossibleMapping* last_mapping = &mappings[last[l]];
+                    if (last_mapping->original.end_line + 1 == range.end_line &&
+                        last_mapping->modified.end_line + 1 == current_modified.end_line) {
+                        last_mapping->original.end_line = range.end_line;
+                        last_mapping->modified.end_line = current_modified.end_line;
+                        ok = int_array_push(&next, &next_count, &next_capacity, last[l]);
+                        extended = true;
+                        break;
+                    }
+                }
+                if (extended || !ok) continue;
+
+                if (mapping_count >= mapping_capacity) {
+                    int new_capacity = mapping_capacity == 0 ? 16 : mapping_capacity * 2;
+                    PossibleMapping* grown = (PossibleMapping*)diff_realloc(mappings, new_capacity * sizeof(PossibleMapping));
+                    if (!grown) {
+                        ok = false;
+                        break;
+                    }
+                    mappings = grown;
+                    mapping_capacity = new_capacity;
+                }
+                mappings[mapping_count].original = range;
+                mappings[mapping_count].modified = current_modified;
+                ok = int_array_push(&next, &next_count, &next_capacity, mapping_count);
+                mapping_count++;
+            }
+
+            // lastMappings = nextMappings
+            int* swap = last;
+            int swap_capacity = last_capacity;
+            last = next;
+            last_count = next_count;
+            last_capacity = next_capacity;
+            next = swap;
+            next_capacity = swap_capacity;
+        }
+
+        if (!timeout_is_valid(timeout)) {
+            *timed_out = true;
+            break;
+        }
+    }
+
+    diff_free(windows);
+    diff_free(last);
+    diff_free(next);
+    if (!ok || *timed_out) {
+        diff_free(mappings);
+        return ok;
+    }
+    *out_mappings = mappings;
+    *out_count = mapping_count;
+    return true;
+}
+
+/**
+ * Find moves made of unchanged 3+ line runs inside the (non-excluded) changes,
+ * then extend each over similar neighbouring lines of the changes it touches.
+ *
+ * @param changes Filtered changes; sorted by modified start in place (as VSCode does)
+ *
+ * VSCode Reference: computeMovedLines.ts computeUnchangedMoves()
+ * VSCode Parity: 100%
+ */
+static bool compute_unchanged_moves(
+    const DetailedLineRangeMapping** changes,
+    int change_count,
+    const uint32_t* hashed_original,
+    const uint32_t* hashed_modified,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const Timeout* timeout,
+    MovedTextArray* moves
+) {
+    // The index is built in original order, then changes are visited by modified start
+    PossibleMapping* possible = NULL;
+    int possible_count = 0;
+    bool timed_out = false;
+    qsort(changes, change_count, sizeof(*changes), compare_changes_by_modified_start);
+    if (!collect_possible_mappings(changes, change_count, hashed_original, hashed_modified,
+                                   timeout, &possible, &possible_count, &timed_out)) {
+        return false;
+    }
+    if (timed_out) {
+        return true;
+    }
+
+    MappingOrder* order = (MappingOrder*)diff_malloc((possible_count + 1) * sizeof(MappingOrder));
+    if (!order) {
+        diff_free(possible);
+        return false;
+    }
+    for (int i = 0; i < possible_count; i++) {
+        order[i].length = line_range_length(possible[i].modified);
+        order[i].index = i;
+    }
+    qsort(order, possible_count, sizeof(MappingOrder), compare_mapping_order);
+
+    LineRangeSet modified_set = { NULL, 0, 0 };
+    LineRangeSet original_set = { NULL, 0, 0 };
+    LineRangeSet modified_sections = { NULL, 0, 0 };
+    LineRangeSet original_sections = { NULL, 0, 0 };
+    LineRangeSet intersected = { NULL, 0, 0 };
+    bool ok = true;
+
+    for (int p = 0; p < possible_count && ok; p++) {
+        const PossibleMapping* mapping = &possible[order[p].index];
+        int diff_orig_to_mod = mapping->modified.start_line - mapping->original.start_line;
+
+        ok = line_range_set_subtract_from(&modified_set, mapping->modified, &modified_sections) &&
+             line_range_set_subtract_from(&original_set, mapping->original, &original_sections);
+        if (!ok) break;
+        for (int k = 0; k < original_sections.count; k++) {
+            original_sections.ranges[k] = line_range_delta(original_sections.ranges[k], diff_orig_to_mod);
+        }
+        ok = line_range_set_intersect(&modified_sections, &original_sections, &intersected);
+
+        for (int k = 0; k < intersected.count && ok; k++) {
+            LineRange modified_range = intersected.ranges[k];
+            if (line_range_length(modified_range) < MOVE_MIN_LINES) continue;
+            LineRange original_range = line_range_delta(modified_range, -diff_orig_to_mod);
+            ok = moved_text_array_push(moves, original_range, modified_range) &&
+                 line_range_set_add(&modified_set, modified_range) &&
+                 line_range_set_add(&original_set, original_range);
+        }
+    }
+    diff_free(order);
+    diff_free(possible);
+    line_range_set_free(&modified_sections);
+    line_range_set_free(&original_sections);
+    line_range_set_free(&intersected);
+
+    ok = ok && sort_moves_by_original_start(moves);
+
+    // Extend moves over similar lines of the changes they touch
+    int cursor = 0;
+    for (int i = 0; i < moves->count && ok; i++) {
+        MovedText move = moves->moves[i];
+
+        int first_orig = monotonous_find_last_original_start_before(changes, change_count, &cursor,
+                                                                    move.original.start_line + 1);
+        int first_mod = find_last_modified_start_before(changes, change_count, move.modified.start_line + 1);
+        int lines_above = 0;
+        if (first_orig >= 0 && first_mod >= 0) {
+            int above_orig = move.original.start_line - changes[first_orig]->original.start_line;
+            int above_mod = move.modified.start_line - changes[first_mod]->modified.start_line;
+            lines_above = above_orig > above_mod ? above_orig : above_mod;
+        }
+
+        int last_orig = monotonous_find_last_original_start_before(changes, change_count, &cursor,
+                                                                   move.original.end_line);
+        int last_mod = find_last_modified_start_before(changes, change_count, move.modified.end_line);
+        int lines_below = 0;
+        if (last_orig >= 0 && last_mod >= 0) {
+            int below_orig = changes[last_orig]->original.end_line - move.original.end_line;
+            int below_mod = changes[last_mod]->modified.end_line - move.modified.end_line;
+            lines_below = below_orig > below_mod ? below_orig : below_mod;
+        }
+
+        int extend_to_top;
+        for (extend_to_top = 0; extend_to_top < lines_above; extend_to_top++) {
+            int orig_line = move.original.start_line - extend_to_top - 1;
+            int mod_line = move.modified.start_line - extend_to_top - 1;
+            if (orig_line > original_count || mod_line > modified_count) break;
+            if (orig_line < 1 || mod_line < 1) break;
+            if (line_range_set_contains(&modified_set, mod_line) ||
+                line_range_set_contains(&original_set, orig_line)) break;
+            if (!are_lines_similar(original_lines[orig_line - 1], modified_lines[mod_line - 1], timeout)) break;
+        }
+        if (extend_to_top > 0) {
+            LineRange top_original = { move.original.start_line - extend_to_top, move.original.start_line };
+            LineRange top_modified = { move.modified.start_line - extend_to_top, move.modified.start_line };
+            ok = line_range_set_add(&original_set, top_original) &&
+                 line_range_set_add(&modified_set, top_modified);
+        }
+
+        int extend_to_bottom;
+        for (extend_to_bottom = 0; extend_to_bottom < lines_below && ok; extend_to_bottom++) {
+            int orig_line = move.original.end_line + extend_to_bottom;
+            int mod_line = move.modified.end_line + extend_to_bottom;
+            if (orig_line > original_count || mod_line > modified_count) break;
+            if (line_range_set_contains(&modified_set, mod_line) ||
+                line_range_set_contains(&original_set, orig_line)) break;
+            if (!are_lines_similar(original_lines[orig_line - 1], modified_lines[mod_line - 1], timeout)) break;
+        }
+        if (ok && extend_to_bottom > 0) {
+            LineRange bottom_original = { move.original.end_line, move.original.end_line + extend_to_bottom };
+            LineRange bottom_modified = { move.modified.end_line, move.modified.end_line + extend_to_bottom };
+            ok = line_range_set_add(&original_set, bottom_original) &&
+                 line_range_set_add(&modified_set, bottom_modified);
+        }
+
+        if (extend_to_top > 0 || extend_to_bottom > 0) {
+            moves->moves[i].original.start_line -= extend_to_top;
+            moves->moves[i].original.end_line += extend_to_bottom;
+            moves->moves[i].modified.start_line -= extend_to_top;
+            moves->moves[i].modified.end_line += extend_to_bottom;
+        }
+    }
+
+    line_range_set_free(&modified_set);
+    line_range_set_free(&original_set);
+    return ok;
+}
+
+// ============================================================================
+// Step 3: Join, Filter, Remove Moves Within One Change
+// ============================================================================
+
+/**
+ * VSCode Reference: computeMovedLines.ts joinCloseConsecutiveMoves()
+ * VSCode Parity: 100%
+ */
+static bool join_close_consecutive_moves(MovedTextArray* moves) {
+    if (moves->count == 0) return true;
+    if (!sort_moves_by_original_start(moves)) return false;
+
+    int result_count = 1;
+    for (int i = 1; i < moves->count; i++) {
+        MovedText* last = &moves->moves[result_count - 1];
+        const MovedText current = moves->moves[i];
+        int original_dist = current.original.start_line - last->original.end_line;
+        int modified_dist = current.modified.start_line - last->modified.end_line;
+        bool current_move_after_last = original_dist >= 0 && modified_dist >= 0;
+        if (current_move_after_last && original_dist + modified_dist <= 2) {
+            last->original = line_range_join(last->original, current.original);
+            last->modified = line_range_join(last->modified, current.modified);
+            continue;
+        }
+        moves->moves[result_count++] = current;
+    }
+    moves->count = result_count;
+    return true;
+}
+
+/**
+ * Ignore too short moves: the trimmed text must be 15+ UTF-16 units long and
+ * have at least two lines of 2+ units.
+ *
+ * VSCode Reference: computeMovedLines.ts computeMovedLines() filter
+ */
+static bool is_move_long_enough(const MovedText* move, const char** original_lines) {
+    int text_length = 0;
+    int long_lines = 0;
+    for (int i = move->original.start_line - 1; i < move->original.end_line - 1; i++) {
+        size_t trimmed_length;
+        const char* trimmed = trim_span(original_lines[i], &trimmed_length);
+        int length = utf8_to_utf16_length_n(trimmed, (int)trimmed_length);
+        text_length += length;
+        if (i > move->original.start_line - 1) text_length++;  // join('\n')
+        if (length >= 2) long_lines++;
+    }
+    return text_length >= MOVE_MIN_TEXT_LENGTH && long_lines >= 2;
+}
+
+/**
+ * Drop moves whose original and modified ends fall into the same change.
+ *
+ * VSCode Reference: computeMovedLines.ts removeMovesInSameDiff()
+ * VSCode Parity: 100%
+ */
+static void remove_moves_in_same_diff(const DetailedLineRangeMappingArray* changes,
+                                      const DetailedLineRangeMapping** sorted,
+                                      MovedTextArray* moves) {
+    // No change before the move: VSCode substitutes a fresh sentinel mapping,
+    // which never equals the (possibly undefined) modified-side lookup
+    const int SENTINEL = -2;
+    int cursor = 0;
+    int kept = 0;
+    for (int i = 0; i < moves->count; i++) {
+        const MovedText* m = &moves->moves[i];
+        int before_original = monotonous_find_last_original_start_before(
+            sorted, changes->count, &cursor, m->original.end_line);
+        if (before_original < 0) before_original = SENTINEL;
+        int before_modified = find_last_modified_start_before(sorted, changes->count, m->modified.end_line);
+        if (before_original != before_modified) {
+            moves->moves[kept++] = *m;
+        }
+    }
+    moves->count = kept;
+}
+
+// ============================================================================
+// Main Function
+// ============================================================================
+
+bool compute_moved_lines(
+    const DetailedLineRangeMappingArray* changes,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const uint32_t* hashed_original,
+    const uint32_t* hashed_modified,
+    const Timeout* timeout,
+    MovedTextArray* out
+) {
+    out->moves = NULL;
+    out->count = 0;
+    out->capacity = 0;
+    if (!changes || changes->count == 0) {
+        return true;
+    }
+
+    MovedTextArray moves = { NULL, 0, 0 };
+    MovedTextArray unchanged = { NULL, 0, 0 };
+    bool* excluded = (bool*)diff_calloc(changes->count, sizeof(bool));
+    const DetailedLineRangeMapping** filtered =
+        (const DetailedLineRangeMapping**)diff_malloc(changes->count * sizeof(*filtered));
+    bool ok = excluded && filtered;
+
+    ok = ok && compute_moves_from_simple_deletions_to_simple_insertions(
+        changes, original_lines, modified_lines, timeout, &moves, excluded);
+
+    bool valid = timeout_is_valid(timeout);
+    if (ok && valid) {
+        int filtered_count = 0;
+        for (int i = 0; i < changes->count; i++) {
+            if (!excluded[i]) filtered[filtered_count++] = &changes->mappings[i];
+        }
+        ok = compute_unchanged_moves(filtered, filtered_count, hashed_original, hashed_modified,
+                                     original_lines, original_count, modified_lines, modified_count,
+                                     timeout, &unchanged);
+    }
+
+    // pushMany(moves, unchangedMoves)
+    for (int i = 0; i < unchanged.count && ok && valid; i++) {
+        ok = moved_text_array_push(&moves, unchanged.moves[i].original, unchanged.moves[i].modified);
+    }
+    ok = ok && valid && join_close_consecutive_moves(&moves);
+
+    if (ok) {
+        int kept = 0;
+        for (int i = 0; i < moves.count; i++) {
+            if (is_move_long_enough(&moves.moves[i], original_lines)) {
+                moves.moves[kept++] = moves.moves[i];
+            }
+        }
+        moves.count = kept;
+
+        // removeMovesInSameDiff runs over all changes, in their own order
+        for (int i = 0; i < changes->count; i++) {
+            filtered[i] = &changes->mappings[i];
+        }
+        remove_moves_in_same_diff(changes, filtered, &moves);
+    }
+
+    diff_free(excluded);
+    diff_free(filtered);
+    diff_free(unchanged.moves);
+    if (!ok || moves.count == 0) {
+        diff_free(moves.moves);
+        return ok || !valid;
+    }
+    *out = moves;
+    return true;
+}
@@ -0,0 +1,88 @@
+// ============================================================================
+// Library Allocator
+// ============================================================================
+//
+// One process-wide hook table, the C heap by default. The hooks are copied in
+// by diff_set_allocator() and read without synchronization: installing one
+// is an initialization step, not something done while diffs run.
+//
+// Not VSCode: JavaScript has no allocator to replace.
+//
+// ============================================================================
+
+#include "diff_allocator.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* heap_allocate(void* user_data, size_t size) {
+    (void)user_data;
+    return malloc(size);
+}
+
+static void* heap_reallocate(void* user_data, void* ptr, size_t size) {
+    (void)user_data;
+    return realloc(ptr, size);
+}
+
+static void heap_release(void* user_data, void* ptr) {
+    (void)user_data;
+    free(ptr);
+}
+
+static void* heap_allocate_zeroed(void* user_data, size_t count, size_t size) {
+    (void)user_data;
+    return calloc(count, size);
+}
+
+static const DiffAllocator heap_allocator = {
+    heap_allocate, heap_reallocate, heap_release, heap_allocate_zeroed, NULL,
+};
+
+static DiffAllocator installed = {
+    heap_allocate, heap_reallocate, heap_release, heap_allocate_zeroed, NULL,
+};
+
+bool diff_set_allocator(const DiffAllocator* allocator) {
+    if (!allocator) {
+        installed = heap_allocator;
+        return true;
+    }
+    if (!allocator->allocate || !allocator->reallocate || !allocator->release) {
+        return false;
+    }
+    installed = *allocator;
+    return true;
+}
+
+DiffAllocator diff_get_allocator(void) {
+    return installed;
+}
+
+void* diff_malloc(size_t size) {
+    diff_stats_count_heap_allocation(size);
+    return installed.allocate(installed.user_data, size);
+}
+
+void* diff_calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    diff_stats_count_heap_allocation(count * size);
+    if (installed.allocate_zeroed) {
+        return installed.allocate_zeroed(installed.user_data, count, size);
+    }
+    void* ptr = installed.allocate(installed.user_data, count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* diff_realloc(void* ptr, size_t size) {
+    diff_stats_count_heap_allocation(size);
+    return installed.reallocate(installed.user_data, ptr, size);
+}
+
+void diff_free(void* ptr) {
+    installed.release(installed.user_data, ptr);
+}
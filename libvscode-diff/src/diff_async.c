@@ -0,0 +1,250 @@
+// ============================================================================
+// Asynchronous Diff Jobs
+// ============================================================================
+//
+// One worker thread per job. The worker installs the job's cancel flag as its
+// thread cancel flag, so the Timeout compute_diff() starts (and every Timeout
+// started below it, including those of the refinement workers) observes it.
+//
+// Completion: the worker publishes the result, sets `finished`, then writes
+// one byte to a pipe whose read end is handed out by diff_async_fd().
+//
+// Background jobs lower their worker's priority before computing anything;
+// the worker exits with the job, so the priority never has to be restored.
+//
+// Not VSCode: VSCode offloads diffs to a web worker.
+//
+// ============================================================================
+
+#include "diff_async.h"
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include "render_plan.h"
+#include "utils.h"
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+typedef struct {
+    const char** lines;     // Point into text
+    char* text;             // All lines, NUL-terminated, back to back
+    int* lengths;           // Byte length of each line, measured once by the copy
+    int count;
+} AsyncLines;
+
+struct DiffAsyncJob {
+    AsyncLines sides[2];    // Original, modified
+    DiffOptions options;
+    bool build_render_plan;
+    bool background;        // Worker runs at the lowest thread priority
+    DiffCache* cache;
+
+    DiffCancelFlag* cancel;
+    diff_atomic_flag finished;
+    int notify_fd[2];       // Pipe: read end, write end (-1 = none)
+    diff_thread_t thread;
+
+    // Written by the worker before `finished` is set
+    LinesDiff* diff;
+    RenderPlan* plan;
+    DiffStats stats;
+};
+
+static bool async_lines_copy(AsyncLines* out, const char** lines, int count) {
+    out->count = count;
+    out->lines = (const char**)diff_malloc((count > 0 ? (size_t)count : 1) * sizeof(char*));
+    out->lengths = diff_line_lengths_create(lines, count);
+    out->text = NULL;
+    if (!out->lines || !out->lengths) {
+        return false;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += (size_t)out->lengths[i] + 1;
+    }
+    out->text = (char*)diff_malloc(total > 0 ? total : 1);
+    if (!out->text) {
+        return false;
+    }
+
+    char* p = out->text;
+    for (int i = 0; i < count; i++) {
+        size_t len = (size_t)out->lengths[i] + 1;
+        memcpy(p, lines[i], len);
+        out->lines[i] = p;
+        p += len;
+    }
+    return true;
+}
+
+static void async_lines_free(AsyncLines* lines) {
+    diff_free((void*)lines->lines);
+    diff_free(lines->lengths);
+    diff_free(lines->text);
+}
+
+static void* async_worker(void* arg) {
+    DiffAsyncJob* job = (DiffAsyncJob*)arg;
+    if (job->background) {
+        diff_thread_lower_priority();
+    }
+    diff_set_thread_cancel_flag(job->cancel);
+    diff_set_thread_stats(&job->stats);
+
+    const AsyncLines* original = &job->sides[0];
+    const AsyncLines* modified = &job->sides[1];
+    LinesDiff* diff = job->cache
+        ? diff_cache_compute_n(job->cache, original->lines, original->lengths, original->count,
+                               modified->lines, modified->lengths, modified->count, &job->options)
+        : compute_diff_n(original->lines, original->lengths, original->count,
+                         modified->lines, modified->lengths, modified->count, &job->options);
+    RenderPlan* plan = NULL;
+    if (diff && job->build_render_plan && !diff_cancel_flag_is_set(job->cancel)) {
+        DiffPhaseStart phase_start = diff_stats_phase_start();
+        plan = generate_render_plan_n(diff, original->lines, original->lengths, original->count,
+                                      modified->lines, modified->lengths, modified->count);
+        diff_stats_add_phase(DIFF_PHASE_RENDER_PLAN, phase_start);
+        if (!plan) {
+            free_lines_diff(diff);
+            diff = NULL;
+        }
+    }
+
+    // A cancelled diff is a truncated one: never hand it out
+    if (diff_cancel_flag_is_set(job->cancel)) {
+        free_render_plan(plan);
+        free_lines_diff(diff);
+        plan = NULL;
+        diff = NULL;
+    }
+
+    diff_set_thread_stats(NULL);
+    job->diff = diff;
+    job->plan = plan;
+    diff_atomic_flag_set(&job->finished);
+
+#ifndef _WIN32
+    if (job->notify_fd[1] >= 0) {
+        char byte = 1;
+        ssize_t written = write(job->notify_fd[1], &byte, 1);
+        (void)written;  // Readers fall back to diff_async_status()
+    }
+#endif
+
+    diff_set_thread_cancel_flag(NULL);
+    return NULL;
+}
+
+static void async_job_free(DiffAsyncJob* job) {
+#ifndef _WIN32
+    if (job->notify_fd[0] >= 0) close(job->notify_fd[0]);
+    if (job->notify_fd[1] >= 0) close(job->notify_fd[1]);
+#endif
+    free_render_plan(job->plan);
+    free_lines_diff(job->diff);
+    diff_cancel_flag_destroy(job->cancel);
+    async_lines_free(&job->sides[0]);
+    async_lines_free(&job->sides[1]);
+    diff_free(job);
+}
+
+static DiffAsyncJob* async_start(const char** original_lines, int original_count,
+                                 const char** modified_lines, int modified_count,
+                                 const DiffOptions* options, bool build_render_plan,
+                                 DiffCache* cache, bool background) {
+    if (!options || original_count < 0 || modified_count < 0) return NULL;
+
+    DiffAsyncJob* job = (DiffAsyncJob*)diff_calloc(1, sizeof(DiffAsyncJob));
+    if (!job) return NULL;
+    job->notify_fd[0] = -1;
+    job->notify_fd[1] = -1;
+    job->options = *options;
+    job->build_render_plan = build_render_plan;
+    job->background = background;
+    job->cache = cache;
+    diff_atomic_flag_init(&job->finished);
+
+    job->cancel = diff_cancel_flag_create();
+    if (!job->cancel ||
+        !async_lines_copy(&job->sides[0], original_lines, original_count) ||
+        !async_lines_copy(&job->sides[1], modified_lines, modified_count)) {
+        async_job_free(job);
+        return NULL;
+    }
+
+#ifndef _WIN32
+    if (pipe(job->notify_fd) != 0) {
+        job->notify_fd[0] = -1;
+        job->notify_fd[1] = -1;
+    }
+#endif
+
+    if (!diff_thread_create(&job->thread, async_worker, job)) {
+        async_job_free(job);
+        return NULL;
+    }
+    return job;
+}
+
+DiffAsyncJob* diff_async_start(const char** original_lines, int original_count,
+                               const char** modified_lines, int modified_count,
+                               const DiffOptions* options, bool build_render_plan,
+                               DiffCache* cache) {
+    return async_start(original_lines, original_count, modified_lines, modified_count,
+                       options, build_render_plan, cache, false);
+}
+
+DiffAsyncJob* diff_async_start_background(const char** original_lines, int original_count,
+                                          const char** modified_lines, int modified_count,
+                                          const DiffOptions* options, bool build_render_plan,
+                                          DiffCache* cache) {
+    return async_start(original_lines, original_count, modified_lines, modified_count,
+                       options, build_render_plan, cache, true);
+}
+
+DiffAsyncStatus diff_async_status(const DiffAsyncJob* job) {
+    if (!diff_atomic_flag_is_set(&job->finished)) {
+        return DIFF_ASYNC_RUNNING;
+    }
+    if (job->diff) {
+        return DIFF_ASYNC_DONE;
+    }
+    return diff_cancel_flag_is_set(job->cancel) ? DIFF_ASYNC_CANCELLED : DIFF_ASYNC_FAILED;
+}
+
+int diff_async_fd(const DiffAsyncJob* job) {
+    return job->notify_fd[0];
+}
+
+void diff_async_cancel(DiffAsyncJob* job) {
+    if (job) {
+        diff_cancel_flag_set(job->cancel);
+    }
+}
+
+const LinesDiff* diff_async_get_diff(const DiffAsyncJob* job) {
+    return diff_async_status(job) == DIFF_ASYNC_DONE ? job->diff : NULL;
+}
+
+const DiffStats* diff_async_get_stats(const DiffAsyncJob* job) {
+    return diff_async_status(job) == DIFF_ASYNC_DONE ? &job->stats : NULL;
+}
+
+RenderPlan* diff_async_take_render_plan(DiffAsyncJob* job) {
+    if (diff_async_status(job) != DIFF_ASYNC_DONE) return NULL;
+    RenderPlan* plan = job->plan;
+    job->plan = NULL;
+    return plan;
+}
+
+void diff_async_destroy(DiffAsyncJob* job) {
+    if (!job) return;
+    diff_cancel_flag_set(job->cancel);
+    diff_thread_join(&job->thread);
+    async_job_free(job);
+}
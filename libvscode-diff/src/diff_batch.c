@@ -0,0 +1,205 @@
+// ============================================================================
+// Batch Diff
+// ============================================================================
+//
+// A fixed pool of workers shares one queue of job indices, ordered largest
+// first. Each worker takes the next index under the lock and runs the whole
+// pipeline for that job, so load balances itself: whoever is free takes the
+// next job, and only the largest jobs can end up running alone at the end.
+//
+// Each job writes only its own results[] slot. Each worker runs its jobs on
+// its own workspace, so later jobs reuse the buffers of earlier ones.
+//
+// A prepared batch diffs one prepared side against many others; the
+// prepared side is only read, so every worker shares it.
+//
+// Not VSCode: VSCode computes one diff per editor.
+//
+// ============================================================================
+
+#include "diff_batch.h"
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include "diff_workspace.h"
+#include "utils.h"
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Upper bound on batch workers, regardless of the requested count */
+#define MAX_BATCH_THREADS 64
+
+typedef struct {
+    const DiffBatchJob* jobs;  // NULL for a prepared batch
+    const DiffPreparedLines* prepared;
+    DiffPreparedSide prepared_side;
+    const DiffBatchLines* others;
+    const DiffOptions* options;
+    const int* order;          // Job indices, largest first
+    int job_count;
+    int next_job;              // Guarded by lock
+    diff_mutex_t lock;
+    DiffCache* cache;
+    const DiffCancelFlag* cancel;
+    LinesDiff** results;
+} BatchQueue;
+
+typedef struct {
+    int64_t size;              // Lines on both sides
+    int index;
+} BatchOrderEntry;
+
+static int compare_job_size_desc(const void* a, const void* b) {
+    const BatchOrderEntry* ea = (const BatchOrderEntry*)a;
+    const BatchOrderEntry* eb = (const BatchOrderEntry*)b;
+    if (ea->size != eb->size) return ea->size > eb->size ? -1 : 1;
+    return ea->index - eb->index;
+}
+
+/**
+ * Job indices, largest first (ties in job order). NULL on allocation failure.
+ * Sizes come from jobs, or from others for a prepared batch (the prepared
+ * side is the same in every job).
+ */
+static int* batch_order_create(const DiffBatchJob* jobs, const DiffBatchLines* others,
+                               int job_count) {
+    BatchOrderEntry* entries = (BatchOrderEntry*)diff_malloc(sizeof(BatchOrderEntry) * (size_t)job_count);
+    int* order = (int*)diff_malloc(sizeof(int) * (size_t)job_count);
+    if (!entries || !order) {
+        diff_free(entries);
+        diff_free(order);
+        return NULL;
+    }
+    for (int i = 0; i < job_count; i++) {
+        entries[i].size = jobs ? (int64_t)jobs[i].original_count + jobs[i].modified_count
+                               : (int64_t)others[i].count;
+        entries[i].index = i;
+    }
+    qsort(entries, (size_t)job_count, sizeof(BatchOrderEntry), compare_job_size_desc);
+    for (int i = 0; i < job_count; i++) {
+        order[i] = entries[i].index;
+    }
+    diff_free(entries);
+    return order;
+}
+
+static void run_batch_job(BatchQueue* queue, int index) {
+    if (!queue->jobs) {
+        const DiffBatchLines* other = &queue->others[index];
+        queue->results[index] = compute_diff_prepared(queue->prepared, queue->prepared_side,
+                                                      other->lines, other->lengths,
+                                                      other->count, queue->options);
+        return;
+    }
+    const DiffBatchJob* job = &queue->jobs[index];
+    queue->results[index] = queue->cache
+        ? diff_cache_compute_n(queue->cache, job->original_lines, job->original_lengths,
+                               job->original_count, job->modified_lines, job->modified_lengths,
+                               job->modified_count, job->options)
+        : compute_diff_n(job->original_lines, job->original_lengths, job->original_count,
+                         job->modified_lines, job->modified_lengths, job->modified_count,
+                         job->options);
+}
+
+static void* batch_worker(void* arg) {
+    BatchQueue* queue = (BatchQueue*)arg;
+    const DiffCancelFlag* previous = diff_get_thread_cancel_flag();
+    diff_set_thread_cancel_flag(queue->cancel);
+    // NULL on allocation failure: jobs then allocate as usual
+    DiffWorkspace* workspace = diff_workspace_create();
+    DiffWorkspace* previous_workspace = diff_get_thread_workspace();
+    diff_set_thread_workspace(workspace);
+    for (;;) {
+        diff_mutex_lock(&queue->lock);
+        int slot = queue->next_job++;
+        diff_mutex_unlock(&queue->lock);
+
+        if (slot >= queue->job_count) break;
+        run_batch_job(queue, queue->order[slot]);
+    }
+    diff_set_thread_workspace(previous_workspace);
+    diff_workspace_destroy(workspace);
+    diff_set_thread_cancel_flag(previous);
+    return NULL;
+}
+
+/**
+ * Run every job of a filled-in queue on up to thread_count threads
+ */
+static bool run_batch(BatchQueue* queue, int thread_count) {
+    int job_count = queue->job_count;
+    for (int i = 0; i < job_count; i++) {
+        queue->results[i] = NULL;
+    }
+
+    int* order = batch_order_create(queue->jobs, queue->others, job_count);
+    if (!order) return false;
+
+    queue->order = order;
+    queue->next_job = 0;
+    queue->cancel = diff_get_thread_cancel_flag();
+
+    if (thread_count <= 0) thread_count = diff_cpu_count();
+    if (thread_count > MAX_BATCH_THREADS) thread_count = MAX_BATCH_THREADS;
+    if (thread_count > job_count) thread_count = job_count;
+
+    diff_mutex_init(&queue->lock);
+    diff_thread_t threads[MAX_BATCH_THREADS];
+    int started = 0;
+    // thread_count - 1 workers plus the calling thread
+    for (int i = 0; i < thread_count - 1; i++) {
+        if (!diff_thread_create(&threads[started], batch_worker, queue)) break;
+        started++;
+    }
+    batch_worker(queue);
+    for (int i = 0; i < started; i++) {
+        diff_thread_join(&threads[i]);
+    }
+    diff_mutex_destroy(&queue->lock);
+    diff_free(order);
+
+    for (int i = 0; i < job_count; i++) {
+        if (!queue->results[i]) return false;
+    }
+    return true;
+}
+
+bool compute_diff_batch(
+    const DiffBatchJob* jobs,
+    int job_count,
+    int thread_count,
+    DiffCache* cache,
+    LinesDiff** results
+) {
+    if (job_count <= 0) return true;
+
+    BatchQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.jobs = jobs;
+    queue.job_count = job_count;
+    queue.cache = cache;
+    queue.results = results;
+    return run_batch(&queue, thread_count);
+}
+
+bool compute_diff_prepared_batch(
+    const DiffPreparedLines* prepared,
+    DiffPreparedSide side,
+    const DiffBatchLines* others,
+    int other_count,
+    const DiffOptions* options,
+    int thread_count,
+    LinesDiff** results
+) {
+    if (other_count <= 0) return true;
+
+    BatchQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.prepared = prepared;
+    queue.prepared_side = side;
+    queue.others = others;
+    queue.options = options;
+    queue.job_count = other_count;
+    queue.results = results;
+    return run_batch(&queue, thread_count);
+}
@@ -0,0 +1,389 @@
+// ============================================================================
+// Content-Addressed Diff Result Cache
+// ============================================================================
+//
+// Key: 128-bit hash (two murmur3-style 64-bit lanes, 16 bytes per step) over
+// the result-shaping options and, per side, the line count and every line.
+// Each line is mixed as its own chunk with its length folded into the last
+// block, so ["ab", "c"] and ["a", "bc"] hash differently and no bytes are
+// copied through a stream buffer.
+//
+// The in-memory LRU is a fixed array scanned linearly: capacities are small
+// and comparing 16-byte keys is far cheaper than the hash pass itself.
+//
+// Spill files: <dir>/<32 hex digits>.vdc holding a magic, the key and the
+// write_packed_lines_diff() stream (varint deltas, a fraction of the flat
+// block's size). Each is written once: on eviction, or when the cache is
+// destroyed with the entry still in memory. Files of other versions fail the
+// magic check and count as misses.
+//
+// ============================================================================
+
+#include "diff_cache.h"
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include "flat_lines_diff.h"
+#include "packed_lines_diff.h"
+#include "platform.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// 128-bit Hash
+// ============================================================================
+
+typedef struct {
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t total_length;
+} Hash128;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static const uint64_t HASH_C1 = 0x87c37b91114253d5ULL;
+static const uint64_t HASH_C2 = 0x4cf5ad432745937fULL;
+
+static inline void hash128_mix(Hash128* h, uint64_t k1, uint64_t k2) {
+    k1 *= HASH_C1; k1 = rotl64(k1, 31); k1 *= HASH_C2; h->h1 ^= k1;
+    h->h1 = rotl64(h->h1, 27); h->h1 += h->h2; h->h1 = h->h1 * 5 + 0x52dce729;
+
+    k2 *= HASH_C2; k2 = rotl64(k2, 33); k2 *= HASH_C1; h->h2 ^= k2;
+    h->h2 = rotl64(h->h2, 31); h->h2 += h->h1; h->h2 = h->h2 * 5 + 0x38495ab5;
+}
+
+static void hash128_init(Hash128* h) {
+    h->h1 = 0x9e3779b97f4a7c15ULL;
+    h->h2 = 0xc2b2ae3d27d4eb4fULL;
+    h->total_length = 0;
+}
+
+/**
+ * Mix one length-prefixed chunk: 16 bytes per step straight from `data`,
+ * the last partial block zero-padded together with the length
+ */
+static void hash128_chunk(Hash128* h, const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+    h->total_length += len;
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint64_t k1, k2;
+        memcpy(&k1, p + i, sizeof(k1));  // Unaligned-safe loads
+        memcpy(&k2, p + i + 8, sizeof(k2));
+        hash128_mix(h, k1, k2);
+    }
+
+    // Tail: up to 15 remaining bytes, little-endian into k1 then k2
+    uint64_t k1 = 0, k2 = 0;
+    size_t rest = len - i;
+    if (rest >= 8) {
+        memcpy(&k1, p + i, sizeof(k1));
+        for (size_t j = 8; j < rest; j++) {
+            k2 |= (uint64_t)p[i + j] << (8 * (j - 8));
+        }
+    } else {
+        for (size_t j = 0; j < rest; j++) {
+            k1 |= (uint64_t)p[i + j] << (8 * j);
+        }
+    }
+    hash128_mix(h, k1 ^ (uint64_t)len, k2 ^ ((uint64_t)len << 32));
+}
+
+static void hash128_final(const Hash128* h, uint64_t out[2]) {
+    uint64_t h1 = h->h1 ^ h->total_length;
+    uint64_t h2 = h->h2 ^ h->total_length;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+    out[0] = h1;
+    out[1] = h2;
+}
+
+/** Full byte span of every line, so embedded NULs are part of the key */
+static void hash_side(Hash128* h, const char** lines, const int* lengths, int count) {
+    uint32_t n = (uint32_t)count;
+    hash128_chunk(h, &n, sizeof(n));
+    for (int i = 0; i < count; i++) {
+        hash128_chunk(h, lines[i], (size_t)diff_line_length(lines, lengths, i));
+    }
+}
+
+static void diff_cache_key(const char** original_lines, const int* original_lengths,
+                           int original_count,
+                           const char** modified_lines, const int* modified_lengths,
+                           int modified_count,
+                           const DiffOptions* options, uint64_t key[2]) {
+    // Only the options that change a diff which finished within its budget
+    unsigned char shape[6] = {
+        (unsigned char)options->ignore_trim_whitespace,
+        (unsigned char)options->compute_moves,
+        (unsigned char)options->extend_to_subwords,
+        (unsigned char)options->anchor_unique_lines,
+        (unsigned char)options->linear_space_myers,
+        (unsigned char)options->cost_model_engine
+    };
+    int32_t thresholds[4] = {
+        options->line_dp_max_lines,
+        options->char_dp_max_chars,
+        options->dp_max_cells,
+        options->token_refine_min_chars
+    };
+
+    Hash128 h;
+    hash128_init(&h);
+    hash128_chunk(&h, shape, sizeof(shape));
+    hash128_chunk(&h, thresholds, sizeof(thresholds));
+    hash_side(&h, original_lines, original_lengths, original_count);
+    hash_side(&h, modified_lines, modified_lengths, modified_count);
+    hash128_final(&h, key);
+}
+
+// ============================================================================
+// Cache
+// ============================================================================
+
+typedef struct {
+    uint64_t key[2];
+    FlatLinesDiff* flat;    // NULL = free slot
+    uint64_t last_used;
+    bool on_disk;           // Spill file already exists
+} CacheEntry;
+
+struct DiffCache {
+    CacheEntry* entries;
+    int capacity;
+    char* spill_dir;        // NULL = memory only
+    uint64_t clock;
+    DiffCacheStats stats;
+    diff_mutex_t lock;
+};
+
+static const char SPILL_MAGIC[4] = {'V', 'D', 'C', '3'};
+
+DiffCache* diff_cache_create(int capacity, const char* spill_dir) {
+    if (capacity < 1) capacity = 1;
+
+    DiffCache* cache = (DiffCache*)diff_calloc(1, sizeof(DiffCache));
+    if (!cache) return NULL;
+    cache->entries = (CacheEntry*)diff_calloc((size_t)capacity, sizeof(CacheEntry));
+    cache->spill_dir = spill_dir ? diff_strdup(spill_dir) : NULL;
+    if (!cache->entries || (spill_dir && !cache->spill_dir)) {
+        diff_free(cache->entries);
+        diff_free(cache->spill_dir);
+        diff_free(cache);
+        return NULL;
+    }
+    cache->capacity = capacity;
+    diff_mutex_init(&cache->lock);
+    return cache;
+}
+
+/** <spill_dir>/<key>.vdc, or NULL on allocation failure */
+static char* spill_path(const DiffCache* cache, const uint64_t key[2]) {
+    size_t len = strlen(cache->spill_dir) + 1 + 32 + 4 + 1;
+    char* path = (char*)diff_malloc(len);
+    if (path) {
+        snprintf(path, len, "%s/%016llx%016llx.vdc", cache->spill_dir,
+                 (unsigned long long)key[0], (unsigned long long)key[1]);
+    }
+    return path;
+}
+
+/** Write an evicted entry; the file appears atomically via rename() */
+static void spill_entry(const DiffCache* cache, const CacheEntry* entry) {
+    char* path = spill_path(cache, entry->key);
+    if (!path) return;
+    size_t tmp_len = strlen(path) + 5;
+    char* tmp = (char*)diff_malloc(tmp_len);
+    if (!tmp) {
+        diff_free(path);
+        return;
+    }
+    snprintf(tmp, tmp_len, "%s.tmp", path);
+
+    PackedLinesDiff* packed = pack_flat_lines_diff(entry->flat);
+    FILE* out = packed ? fopen(tmp, "wb") : NULL;
+    if (out) {
+        bool ok = fwrite(SPILL_MAGIC, 1, sizeof(SPILL_MAGIC), out) == sizeof(SPILL_MAGIC) &&
+                  fwrite(entry->key, sizeof(uint64_t), 2, out) == 2 &&
+                  write_packed_lines_diff(packed, out);
+        ok = fclose(out) == 0 && ok;
+        if (!ok || rename(tmp, path) != 0) {
+            remove(tmp);
+        }
+    }
+    free_packed_lines_diff(packed);
+    diff_free(tmp);
+    diff_free(path);
+}
+
+static FlatLinesDiff* load_spilled(const DiffCache* cache, const uint64_t key[2]) {
+    char* path = spill_path(cache, key);
+    if (!path) return NULL;
+    FILE* in = fopen(path, "rb");
+    diff_free(path);
+    if (!in) return NULL;
+
+    char magic[4];
+    uint64_t stored_key[2];
+    FlatLinesDiff* flat = NULL;
+    if (fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+        memcmp(magic, SPILL_MAGIC, sizeof(magic)) == 0 &&
+        fread(stored_key, sizeof(uint64_t), 2, in) == 2 &&
+        stored_key[0] == key[0] && stored_key[1] == key[1]) {
+        PackedLinesDiff* packed = read_packed_lines_diff(in);
+        if (packed) flat = unpack_flat_lines_diff(packed->data, packed->size);
+        free_packed_lines_diff(packed);
+    }
+    fclose(in);
+    return flat;
+}
+
+static CacheEntry* find_entry(DiffCache* cache, const uint64_t key[2]) {
+    for (int i = 0; i < cache->capacity; i++) {
+        CacheEntry* entry = &cache->entries[i];
+        if (entry->flat && entry->key[0] == key[0] && entry->key[1] == key[1]) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/** Store flat (ownership moves to the cache), evicting the LRU entry if full */
+static CacheEntry* insert_entry(DiffCache* cache, const uint64_t key[2],
+                                FlatLinesDiff* flat, bool on_disk) {
+    CacheEntry* entry = find_entry(cache, key);
+    if (entry) {
+        // Another thread computed the same pair meanwhile
+        free_flat_lines_diff(flat);
+        return entry;
+    }
+
+    CacheEntry* victim = &cache->entries[0];
+    for (int i = 0; i < cache->capacity; i++) {
+        entry = &cache->entries[i];
+        if (!entry->flat) {
+            victim = entry;
+            break;
+        }
+        if (entry->last_used < victim->last_used) victim = entry;
+    }
+
+    if (victim->flat) {
+        if (cache->spill_dir && !victim->on_disk) spill_entry(cache, victim);
+        free_flat_lines_diff(victim->flat);
+        cache->stats.entries--;
+    }
+    victim->key[0] = key[0];
+    victim->key[1] = key[1];
+    victim->flat = flat;
+    victim->on_disk = on_disk;
+    cache->stats.entries++;
+    return victim;
+}
+
+/** Look up key in memory, then on disk; expanded copy or NULL */
+static LinesDiff* lookup(DiffCache* cache, const uint64_t key[2]) {
+    CacheEntry* entry = find_entry(cache, key);
+    if (entry) {
+        cache->stats.hits++;
+    } else if (cache->spill_dir) {
+        FlatLinesDiff* flat = load_spilled(cache, key);
+        if (flat) {
+            entry = insert_entry(cache, key, flat, true);
+            cache->stats.disk_hits++;
+        }
+    }
+    if (!entry) return NULL;
+
+    entry->last_used = ++cache->clock;
+    return expand_flat_lines_diff(entry->flat);
+}
+
+LinesDiff* diff_cache_compute(DiffCache* cache,
+                              const char** original_lines, int original_count,
+                              const char** modified_lines, int modified_count,
+                              const DiffOptions* options) {
+    return diff_cache_compute_n(cache, original_lines, NULL, original_count,
+                                modified_lines, NULL, modified_count, options);
+}
+
+LinesDiff* diff_cache_compute_n(DiffCache* cache,
+                                const char** original_lines, const int* original_lengths,
+                                int original_count,
+                                const char** modified_lines, const int* modified_lengths,
+                                int modified_count,
+                                const DiffOptions* options) {
+    uint64_t key[2];
+    diff_cache_key(original_lines, original_lengths, original_count,
+                   modified_lines, modified_lengths, modified_count, options, key);
+
+    diff_mutex_lock(&cache->lock);
+    LinesDiff* diff = lookup(cache, key);
+    if (!diff) cache->stats.misses++;
+    diff_mutex_unlock(&cache->lock);
+    if (diff) return diff;
+
+    // Compute outside the lock so other threads keep hitting the cache
+    diff = compute_diff_n(original_lines, original_lengths, original_count,
+                          modified_lines, modified_lengths, modified_count, options);
+    // Degraded results are not cached, so max_memory_bytes is not in the key
+    if (!diff || diff->hit_timeout || diff->hit_memory_limit) return diff;
+
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    if (flat) {
+        diff_mutex_lock(&cache->lock);
+        insert_entry(cache, key, flat, false)->last_used = ++cache->clock;
+        diff_mutex_unlock(&cache->lock);
+    }
+    return diff;
+}
+
+DiffCacheStats diff_cache_get_stats(const DiffCache* cache) {
+    DiffCache* mutable_cache = (DiffCache*)cache;
+    diff_mutex_lock(&mutable_cache->lock);
+    DiffCacheStats stats = cache->stats;
+    diff_mutex_unlock(&mutable_cache->lock);
+    return stats;
+}
+
+void diff_cache_clear(DiffCache* cache) {
+    diff_mutex_lock(&cache->lock);
+    for (int i = 0; i < cache->capacity; i++) {
+        free_flat_lines_diff(cache->entries[i].flat);
+        cache->entries[i].flat = NULL;
+    }
+    cache->stats.entries = 0;
+    diff_mutex_unlock(&cache->lock);
+}
+
+void diff_cache_destroy(DiffCache* cache) {
+    if (!cache) return;
+    if (cache->spill_dir) {
+        for (int i = 0; i < cache->capacity; i++) {
+            const CacheEntry* entry = &cache->entries[i];
+            if (entry->flat && !entry->on_disk) spill_entry(cache, entry);
+        }
+    }
+    diff_cache_clear(cache);
+    diff_mutex_destroy(&cache->lock);
+    diff_free(cache->entries);
+    diff_free(cache->spill_dir);
+    diff_free(cache);
+}
@@ -0,0 +1,428 @@
+// ============================================================================
+// Incremental Diff Session
+// ============================================================================
+//
+// Keeps owned copies of both sides and the previous LinesDiff. An edit is
+// re-diffed by compute_diff() over a window whose edges lie in unchanged
+// regions of the previous diff; the window's changes replace the old ones
+// and the changes after it are shifted by the edit's line delta.
+//
+// Every diff of a session runs on the session's workspace, so steady-state
+// edits reuse the buffers of the previous ones.
+//
+// Not VSCode: VSCode re-diffs whole documents on every change.
+//
+// ============================================================================
+
+#include "diff_session.h"
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char** lines;           // Owned copies
+    int count;
+    int capacity;
+} SessionLines;
+
+struct DiffSession {
+    DiffOptions options;
+    SessionLines sides[2];  // Indexed by DiffSide
+    LinesDiff* diff;
+    DiffWorkspace* workspace;
+};
+
+/**
+ * Region re-diffed for one edit, in pre-edit coordinates (0-based lines).
+ * Previous changes [first_change, end_change) lie inside it.
+ */
+typedef struct {
+    int start[2];           // Indexed by DiffSide
+    int end[2];             // Exclusive
+    int first_change;
+    int end_change;
+} SessionWindow;
+
+// ============================================================================
+// Line Storage
+// ============================================================================
+
+static void session_lines_free(SessionLines* side) {
+    for (int i = 0; i < side->count; i++) {
+        diff_free(side->lines[i]);
+    }
+    diff_free(side->lines);
+    side->lines = NULL;
+    side->count = 0;
+    side->capacity = 0;
+}
+
+/** Copy new_count lines; NULL on allocation failure (nothing leaked) */
+static char** copy_lines(const char** lines, int count) {
+    char** copies = (char**)diff_malloc((count > 0 ? count : 1) * sizeof(char*));
+    if (!copies) return NULL;
+    for (int i = 0; i < count; i++) {
+        copies[i] = diff_strdup(lines[i] ? lines[i] : "");
+        if (!copies[i]) {
+            for (int j = 0; j < i; j++) diff_free(copies[j]);
+            diff_free(copies);
+            return NULL;
+        }
+    }
+    return copies;
+}
+
+/**
+ * Replace lines [start, start + old_count) with new_lines.
+ * All-or-nothing: on allocation failure the side is left untouched.
+ */
+static bool session_lines_splice(SessionLines* side, int start, int old_count,
+                                 const char** new_lines, int new_count) {
+    char** copies = copy_lines(new_lines, new_count);
+    if (!copies) return false;
+
+    int new_total = side->count - old_count + new_count;
+    if (new_total > side->capacity) {
+        int new_capacity = side->capacity * 2 > new_total ? side->capacity * 2 : new_total;
+        char** grown = (char**)diff_realloc(side->lines, new_capacity * sizeof(char*));
+        if (!grown) {
+            for (int i = 0; i < new_count; i++) diff_free(copies[i]);
+            diff_free(copies);
+            return false;
+        }
+        side->lines = grown;
+        side->capacity = new_capacity;
+    }
+
+    for (int i = start; i < start + old_count; i++) {
+        diff_free(side->lines[i]);
+    }
+    int tail = side->count - start - old_count;
+    if (tail > 0 && old_count != new_count) {
+        memmove(&side->lines[start + new_count], &side->lines[start + old_count], tail * sizeof(char*));
+    }
+    if (new_count > 0) {
+        memcpy(&side->lines[start], copies, new_count * sizeof(char*));
+    }
+    side->count = new_total;
+    diff_free(copies);
+    return true;
+}
+
+// ============================================================================
+// Windowed Re-diff
+// ============================================================================
+
+static LineRange side_range(const DetailedLineRangeMapping* mapping, int side) {
+    return side == DIFF_SIDE_ORIGINAL ? mapping->original : mapping->modified;
+}
+
+/** 0-based [start, end) of a change on one side */
+static int change_start(const DetailedLineRangeMapping* mapping, int side) {
+    return side_range(mapping, side).start_line - 1;
+}
+
+static int change_end(const DetailedLineRangeMapping* mapping, int side) {
+    return side_range(mapping, side).end_line - 1;
+}
+
+/**
+ * Grow the edited range over every previous change within the context
+ * distance, then pad it with context lines. The padding is unchanged text, so
+ * the other side's window follows from the line offset before each edge.
+ *
+ * @return false if the window is the whole file (a full recompute is cheaper)
+ */
+static bool find_edit_window(const LinesDiff* diff, int side, int start, int old_count,
+                             const int line_counts[2], SessionWindow* window) {
+    const DetailedLineRangeMapping* changes = diff->changes.mappings;
+    int n = diff->changes.count;
+    int other = 1 - side;
+    int context = DIFF_SESSION_CONTEXT_LINES;
+    int lo = start;
+    int hi = start + old_count;
+
+    // First change ending at or after lo - context
+    int first = 0, last = n;
+    while (first < last) {
+        int mid = first + (last - first) / 2;
+        if (change_end(&changes[mid], side) >= lo - context) {
+            last = mid;
+        } else {
+            first = mid + 1;
+        }
+    }
+    int end = first;
+
+    bool grew = true;
+    while (grew) {
+        grew = false;
+        while (end < n && change_start(&changes[end], side) <= hi + context) {
+            if (change_start(&changes[end], side) < lo) lo = change_start(&changes[end], side);
+            if (change_end(&changes[end], side) > hi) hi = change_end(&changes[end], side);
+            end++;
+            grew = true;
+        }
+        while (first > 0 && change_end(&changes[first - 1], side) >= lo - context) {
+            first--;
+            if (change_start(&changes[first], side) < lo) lo = change_start(&changes[first], side);
+            if (change_end(&changes[first], side) > hi) hi = change_end(&changes[first], side);
+            grew = true;
+        }
+    }
+
+    window->first_change = first;
+    window->end_change = end;
+    window->start[side] = lo - context > 0 ? lo - context : 0;
+    window->end[side] = hi + context < line_counts[side] ? hi + context : line_counts[side];
+
+    // Unchanged lines map 1:1; the offset comes from the last change before each edge
+    int delta_start = first > 0
+        ? change_end(&changes[first - 1], other) - change_end(&changes[first - 1], side) : 0;
+    int delta_end = end > 0
+        ? change_end(&changes[end - 1], other) - change_end(&changes[end - 1], side) : 0;
+    window->start[other] = window->start[side] + delta_start;
+    window->end[other] = window->end[side] == line_counts[side]
+        ? line_counts[other] : window->end[side] + delta_end;
+
+    if (window->start[other] < 0 || window->start[other] > window->end[other] ||
+        window->end[other] > line_counts[other]) {
+        return false;
+    }
+    return !(window->start[0] == 0 && window->start[1] == 0 &&
+             window->end[0] == line_counts[0] && window->end[1] == line_counts[1]);
+}
+
+static void offset_char_range(CharRange* range, int line_offset) {
+    range->start_line += line_offset;
+    range->end_line += line_offset;
+}
+
+/**
+ * Re-diff the window (post-edit lines) and splice its changes into the
+ * previous diff.
+ *
+ * @return New LinesDiff, or NULL when the window cannot be diffed in isolation
+ *         or on allocation failure (the previous diff is left intact)
+ */
+static LinesDiff* rediff_window(const DiffSession* session, int side,
+                                const SessionWindow* window, int line_delta) {
+    const LinesDiff* previous = session->diff;
+    int start[2] = { window->start[0], window->start[1] };
+    int count[2];
+    for (int k = 0; k < 2; k++) {
+        count[k] = window->end[k] - window->start[k] + (k == side ? line_delta : 0);
+        // compute_diff() treats empty and single-empty-line inputs as whole
+        // files; a window never is one
+        if (count[k] == 0 || (count[k] == 1 && session->sides[k].lines[start[k]][0] == '\0')) {
+            return NULL;
+        }
+    }
+
+    DiffOptions options = session->options;
+    options.compute_moves = false;
+    LinesDiff* window_diff = compute_diff_ex(
+        session->workspace,
+        (const char**)&session->sides[DIFF_SIDE_ORIGINAL].lines[start[DIFF_SIDE_ORIGINAL]],
+        NULL,
+        count[DIFF_SIDE_ORIGINAL],
+        (const char**)&session->sides[DIFF_SIDE_MODIFIED].lines[start[DIFF_SIDE_MODIFIED]],
+        NULL,
+        count[DIFF_SIDE_MODIFIED],
+        &options
+    );
+    if (!window_diff) return NULL;
+
+    int head = window->first_change;
+    int tail = previous->changes.count - window->end_change;
+    int total = head + window_diff->changes.count + tail;
+
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
+    DetailedLineRangeMapping* mappings =
+        (DetailedLineRangeMapping*)diff_malloc((total > 0 ? total : 1) * sizeof(DetailedLineRangeMapping));
+    if (!result || !mappings) {
+        diff_free(result);
+        diff_free(mappings);
+        free_lines_diff(window_diff);
+        return NULL;
+    }
+
+    // Changes before the window: unchanged
+    if (head > 0) {
+        memcpy(mappings, previous->changes.mappings, head * sizeof(DetailedLineRangeMapping));
+    }
+
+    // Window changes: window-relative -> file lines
+    for (int i = 0; i < window_diff->changes.count; i++) {
+        DetailedLineRangeMapping* mapping = &mappings[head + i];
+        *mapping = window_diff->changes.mappings[i];
+        mapping->original.start_line += start[DIFF_SIDE_ORIGINAL];
+        mapping->original.end_line += start[DIFF_SIDE_ORIGINAL];
+        mapping->modified.start_line += start[DIFF_SIDE_MODIFIED];
+        mapping->modified.end_line += start[DIFF_SIDE_MODIFIED];
+        for (int j = 0; j < mapping->inner_change_count; j++) {
+            offset_char_range(&mapping->inner_changes[j].original, start[DIFF_SIDE_ORIGINAL]);
+            offset_char_range(&mapping->inner_changes[j].modified, start[DIFF_SIDE_MODIFIED]);
+        }
+    }
+
+    // Changes after the window: shifted past the edit on the edited side
+    for (int i = 0; i < tail; i++) {
+        DetailedLineRangeMapping* mapping = &mappings[head + window_diff->changes.count + i];
+        *mapping = previous->changes.mappings[window->end_change + i];
+        LineRange* range = side == DIFF_SIDE_ORIGINAL ? &mapping->original : &mapping->modified;
+        range->start_line += line_delta;
+        range->end_line += line_delta;
+        for (int j = 0; j < mapping->inner_change_count; j++) {
+            offset_char_range(side == DIFF_SIDE_ORIGINAL ? &mapping->inner_changes[j].original
+                                                         : &mapping->inner_changes[j].modified,
+                              line_delta);
+        }
+    }
+
+    result->changes.mappings = mappings;
+    result->changes.count = total;
+    result->changes.capacity = total;
+    result->moves.moves = NULL;
+    result->moves.count = 0;
+    result->moves.capacity = 0;
+    result->hit_timeout = window_diff->hit_timeout;
+    result->hit_memory_limit = window_diff->hit_memory_limit;
+
+    // The window diff's contents now belong to result
+    diff_free(window_diff->changes.mappings);
+    diff_free(window_diff->moves.moves);
+    diff_free(window_diff);
+    return result;
+}
+
+/**
+ * Free a previous diff whose changes outside the window were moved into a
+ * newer diff: only the replaced changes still own their inner changes.
+ */
+static void free_spliced_diff(LinesDiff* diff, const SessionWindow* window) {
+    for (int i = window->first_change; i < window->end_change; i++) {
+        diff_free(diff->changes.mappings[i].inner_changes);
+    }
+    diff_free(diff->changes.mappings);
+    diff_free(diff->moves.moves);
+    diff_free(diff);
+}
+
+static LinesDiff* compute_full_diff(const DiffSession* session) {
+    return compute_diff_ex(
+        session->workspace,
+        (const char**)session->sides[DIFF_SIDE_ORIGINAL].lines,
+        NULL,
+        session->sides[DIFF_SIDE_ORIGINAL].count,
+        (const char**)session->sides[DIFF_SIDE_MODIFIED].lines,
+        NULL,
+        session->sides[DIFF_SIDE_MODIFIED].count,
+        &session->options
+    );
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+DiffSession* diff_session_create(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+) {
+    if (original_count < 0 || modified_count < 0 || !options) return NULL;
+
+    DiffSession* session = (DiffSession*)diff_calloc(1, sizeof(DiffSession));
+    if (!session) return NULL;
+    session->options = *options;
+    session->workspace = diff_workspace_create();
+
+    if (!session->workspace ||
+        !session_lines_splice(&session->sides[DIFF_SIDE_ORIGINAL], 0, 0, original_lines, original_count) ||
+        !session_lines_splice(&session->sides[DIFF_SIDE_MODIFIED], 0, 0, modified_lines, modified_count)) {
+        diff_session_destroy(session);
+        return NULL;
+    }
+
+    session->diff = compute_full_diff(session);
+    if (!session->diff) {
+        diff_session_destroy(session);
+        return NULL;
+    }
+    return session;
+}
+
+bool diff_session_edit(
+    DiffSession* session,
+    DiffSide side,
+    int start_line,
+    int old_count,
+    const char** new_lines,
+    int new_count
+) {
+    if (!session || (side != DIFF_SIDE_ORIGINAL && side != DIFF_SIDE_MODIFIED)) return false;
+    SessionLines* edited = &session->sides[side];
+    if (start_line < 0 || old_count < 0 || new_count < 0 ||
+        start_line + old_count > edited->count || (new_count > 0 && !new_lines)) {
+        return false;
+    }
+
+    // Window in pre-edit coordinates, computed before the lines move
+    SessionWindow window;
+    int line_counts[2] = {
+        session->sides[DIFF_SIDE_ORIGINAL].count,
+        session->sides[DIFF_SIDE_MODIFIED].count
+    };
+    bool incremental = session->diff && !session->diff->hit_timeout &&
+                       !session->diff->hit_memory_limit &&
+                       !session->options.compute_moves &&
+                       find_edit_window(session->diff, side, start_line, old_count, line_counts, &window);
+
+    if (!session_lines_splice(edited, start_line, old_count, new_lines, new_count)) {
+        return false;
+    }
+
+    LinesDiff* updated = incremental ? rediff_window(session, side, &window, new_count - old_count) : NULL;
+    if (updated) {
+        free_spliced_diff(session->diff, &window);
+        session->diff = updated;
+        return true;
+    }
+    return diff_session_recompute(session);
+}
+
+bool diff_session_recompute(DiffSession* session) {
+    if (!session) return false;
+    LinesDiff* updated = compute_full_diff(session);
+    if (!updated) return false;
+    free_lines_diff(session->diff);
+    session->diff = updated;
+    return true;
+}
+
+const LinesDiff* diff_session_get_diff(const DiffSession* session) {
+    return session ? session->diff : NULL;
+}
+
+const char* const* diff_session_get_lines(const DiffSession* session, DiffSide side, int* out_count) {
+    if (!session || (side != DIFF_SIDE_ORIGINAL && side != DIFF_SIDE_MODIFIED)) {
+        if (out_count) *out_count = 0;
+        return NULL;
+    }
+    if (out_count) *out_count = session->sides[side].count;
+    return (const char* const*)session->sides[side].lines;
+}
+
+void diff_session_destroy(DiffSession* session) {
+    if (!session) return;
+    session_lines_free(&session->sides[DIFF_SIDE_ORIGINAL]);
+    session_lines_free(&session->sides[DIFF_SIDE_MODIFIED]);
+    free_lines_diff(session->diff);
+    diff_workspace_destroy(session->workspace);
+    diff_free(session);
+}
@@ -0,0 +1,133 @@
+/**
+ * Reusable Diff Workspace Implementation
+ *
+ * Implementation details:
+ * - A fixed table of arenas, created on first use; acquire hands out the
+ *   first idle one, rewound, so one call's line step, refinement workers and
+ *   move refinement each find their memory from the previous call
+ * - One hash map, emptied on acquire (slot table and key pool are kept)
+ * - When everything is taken, or without a workspace, acquire creates a
+ *   private arena/map that release destroys: callers need no second path
+ * - acquire/release take the workspace lock, since refinement workers of
+ *   one call acquire concurrently
+ */
+
+#include "diff_workspace.h"
+#include "diff_allocator.h"
+#include "platform.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+/** Arenas kept by a workspace (refinement workers are capped at 64 too) */
+#define WORKSPACE_MAX_ARENAS 64
+
+struct DiffWorkspace {
+    diff_mutex_t lock;
+    DiffArena* arenas[WORKSPACE_MAX_ARENAS];   // NULL until first used
+    bool arena_taken[WORKSPACE_MAX_ARENAS];
+    StringHashMap* hash_map;                   // NULL until first used
+    bool hash_map_taken;
+};
+
+static DIFF_THREAD_LOCAL DiffWorkspace* thread_workspace = NULL;
+
+DiffWorkspace* diff_workspace_create(void) {
+    DiffWorkspace* workspace = (DiffWorkspace*)diff_calloc(1, sizeof(DiffWorkspace));
+    if (!workspace) return NULL;
+    diff_mutex_init(&workspace->lock);
+    return workspace;
+}
+
+void diff_workspace_destroy(DiffWorkspace* workspace) {
+    if (!workspace) return;
+    for (int i = 0; i < WORKSPACE_MAX_ARENAS; i++) {
+        diff_arena_destroy(workspace->arenas[i]);
+    }
+    string_hash_map_destroy(workspace->hash_map);
+    diff_mutex_destroy(&workspace->lock);
+    diff_free(workspace);
+}
+
+size_t diff_workspace_capacity(const DiffWorkspace* workspace) {
+    if (!workspace) return 0;
+    size_t total = 0;
+    for (int i = 0; i < WORKSPACE_MAX_ARENAS; i++) {
+        if (workspace->arenas[i]) total += diff_arena_capacity(workspace->arenas[i]);
+    }
+    if (workspace->hash_map) total += string_hash_map_capacity_bytes(workspace->hash_map);
+    return total;
+}
+
+void diff_set_thread_workspace(DiffWorkspace* workspace) {
+    thread_workspace = workspace;
+}
+
+DiffWorkspace* diff_get_thread_workspace(void) {
+    return thread_workspace;
+}
+
+DiffArena* diff_workspace_acquire_arena(DiffWorkspace* workspace) {
+    if (!workspace) return diff_arena_create(0);
+
+    DiffArena* arena = NULL;
+    diff_mutex_lock(&workspace->lock);
+    for (int i = 0; i < WORKSPACE_MAX_ARENAS && !arena; i++) {
+        if (workspace->arena_taken[i]) continue;
+        if (!workspace->arenas[i]) {
+            workspace->arenas[i] = diff_arena_create(0);
+            if (!workspace->arenas[i]) break;
+        }
+        workspace->arena_taken[i] = true;
+        arena = workspace->arenas[i];
+    }
+    diff_mutex_unlock(&workspace->lock);
+
+    if (!arena) return diff_arena_create(0);
+    diff_arena_reset(arena);
+    return arena;
+}
+
+void diff_workspace_release_arena(DiffWorkspace* workspace, DiffArena* arena) {
+    if (!arena) return;
+    if (workspace) {
+        diff_mutex_lock(&workspace->lock);
+        for (int i = 0; i < WORKSPACE_MAX_ARENAS; i++) {
+            if (workspace->arenas[i] == arena) {
+                workspace->arena_taken[i] = false;
+                diff_mutex_unlock(&workspace->lock);
+                return;
+            }
+        }
+        diff_mutex_unlock(&workspace->lock);
+    }
+    diff_arena_destroy(arena);
+}
+
+StringHashMap* diff_workspace_acquire_hash_map(DiffWorkspace* workspace) {
+    if (!workspace) return string_hash_map_create();
+
+    StringHashMap* map = NULL;
+    diff_mutex_lock(&workspace->lock);
+    if (!workspace->hash_map_taken) {
+        if (!workspace->hash_map) workspace->hash_map = string_hash_map_create();
+        map = workspace->hash_map;
+        workspace->hash_map_taken = map != NULL;
+    }
+    diff_mutex_unlock(&workspace->lock);
+
+    if (!map) return string_hash_map_create();
+    string_hash_map_clear(map);
+    return map;
+}
+
+void diff_workspace_release_hash_map(DiffWorkspace* workspace, StringHashMap* map) {
+    if (!map) return;
+    if (workspace) {
+        diff_mutex_lock(&workspace->lock);
+        bool own = map == workspace->hash_map;
+        if (own) workspace->hash_map_taken = false;
+        diff_mutex_unlock(&workspace->lock);
+        if (own) return;
+    }
+    string_hash_map_destroy(map);
+}
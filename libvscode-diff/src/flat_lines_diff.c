@@ -0,0 +1,291 @@
+// ============================================================================
+// Flat LinesDiff
+// ============================================================================
+//
+// Header and all int arrays live in one malloc block:
+//
+//   [FlatLinesDiff][changes][inner_offsets][inner_changes][moves]
+//
+// The int block has no pointers, so it is also the on-disk format of
+// write_flat_lines_diff().
+//
+// ============================================================================
+
+#include "flat_lines_diff.h"
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+static int* write_change(int* out, const DetailedLineRangeMapping* mapping) {
+    out[0] = mapping->original.start_line;
+    out[1] = mapping->original.end_line;
+    out[2] = mapping->modified.start_line;
+    out[3] = mapping->modified.end_line;
+    return out + FLAT_CHANGE_STRIDE;
+}
+
+static int* write_char_range(int* out, const CharRange* range) {
+    out[0] = range->start_line;
+    out[1] = range->start_col;
+    out[2] = range->end_line;
+    out[3] = range->end_col;
+    return out + 4;
+}
+
+static int* write_inner_changes(int* out, const DetailedLineRangeMapping* mapping) {
+    for (int i = 0; i < mapping->inner_change_count; i++) {
+        out = write_char_range(out, &mapping->inner_changes[i].original);
+        out = write_char_range(out, &mapping->inner_changes[i].modified);
+    }
+    return out;
+}
+
+/** ints following the header for the given counts */
+static size_t flat_int_count(size_t total_changes, size_t inner_count, size_t move_count) {
+    return total_changes * FLAT_CHANGE_STRIDE + (total_changes + 1) +
+           inner_count * FLAT_INNER_STRIDE + move_count * FLAT_MOVE_STRIDE;
+}
+
+/** Allocate the block and point the arrays into it */
+FlatLinesDiff* flat_lines_diff_alloc(int change_count, int total_changes, int inner_count,
+                                     int move_count, bool hit_timeout, bool hit_memory_limit) {
+    size_t int_count = flat_int_count((size_t)total_changes, (size_t)inner_count, (size_t)move_count);
+    FlatLinesDiff* flat = (FlatLinesDiff*)diff_malloc(sizeof(FlatLinesDiff) + int_count * sizeof(int));
+    if (!flat) return NULL;
+
+    int* changes = (int*)(flat + 1);
+    int* inner_offsets = changes + (size_t)total_changes * FLAT_CHANGE_STRIDE;
+    int* inner_changes = inner_offsets + total_changes + 1;
+    int* moves = inner_changes + (size_t)inner_count * FLAT_INNER_STRIDE;
+
+    flat->change_count = change_count;
+    flat->total_change_count = total_changes;
+    flat->inner_change_count = inner_count;
+    flat->move_count = move_count;
+    flat->hit_timeout = hit_timeout ? 1 : 0;
+    flat->hit_memory_limit = hit_memory_limit ? 1 : 0;
+    flat->changes = changes;
+    flat->inner_offsets = inner_offsets;
+    flat->inner_changes = inner_changes;
+    flat->moves = moves;
+    return flat;
+}
+
+FlatLinesDiff* flatten_lines_diff(const LinesDiff* diff) {
+    if (!diff) return NULL;
+
+    size_t total_changes = (size_t)diff->changes.count;
+    size_t inner_count = 0;
+    for (int i = 0; i < diff->changes.count; i++) {
+        inner_count += (size_t)diff->changes.mappings[i].inner_change_count;
+    }
+    for (int m = 0; m < diff->moves.count; m++) {
+        const MovedText* move = &diff->moves.moves[m];
+        total_changes += (size_t)move->change_count;
+        for (int i = 0; i < move->change_count; i++) {
+            inner_count += (size_t)move->changes[i].inner_change_count;
+        }
+    }
+    if (total_changes > INT32_MAX || inner_count > INT32_MAX) return NULL;
+
+    FlatLinesDiff* flat = flat_lines_diff_alloc(diff->changes.count, (int)total_changes,
+                                                (int)inner_count, diff->moves.count,
+                                                diff->hit_timeout, diff->hit_memory_limit);
+    if (!flat) return NULL;
+
+    int* changes = (int*)flat->changes;
+    int* inner_offsets = (int*)flat->inner_offsets;
+    int* moves = (int*)flat->moves;
+
+    int change_index = 0;
+    int inner_index = 0;
+    int* inner_out = (int*)flat->inner_changes;
+    for (int i = 0; i < diff->changes.count; i++) {
+        const DetailedLineRangeMapping* mapping = &diff->changes.mappings[i];
+        changes = write_change(changes, mapping);
+        inner_offsets[change_index++] = inner_index;
+        inner_out = write_inner_changes(inner_out, mapping);
+        inner_index += mapping->inner_change_count;
+    }
+    for (int m = 0; m < diff->moves.count; m++) {
+        const MovedText* move = &diff->moves.moves[m];
+        int* out = moves + (size_t)m * FLAT_MOVE_STRIDE;
+        out[0] = move->original.start_line;
+        out[1] = move->original.end_line;
+        out[2] = move->modified.start_line;
+        out[3] = move->modified.end_line;
+        out[4] = change_index;
+        out[5] = move->change_count;
+        for (int i = 0; i < move->change_count; i++) {
+            changes = write_change(changes, &move->changes[i]);
+            inner_offsets[change_index++] = inner_index;
+            inner_out = write_inner_changes(inner_out, &move->changes[i]);
+            inner_index += move->changes[i].inner_change_count;
+        }
+    }
+    inner_offsets[change_index] = inner_index;
+
+    return flat;
+}
+
+// ============================================================================
+// Expansion
+// ============================================================================
+
+static CharRange read_char_range(const int* in) {
+    CharRange range = {in[0], in[1], in[2], in[3]};
+    return range;
+}
+
+/** Fill `mapping` from flat change `index`; false on allocation failure */
+static bool expand_change(const FlatLinesDiff* flat, int index, DetailedLineRangeMapping* mapping) {
+    const int* c = &flat->changes[(size_t)index * FLAT_CHANGE_STRIDE];
+    mapping->original.start_line = c[0];
+    mapping->original.end_line = c[1];
+    mapping->modified.start_line = c[2];
+    mapping->modified.end_line = c[3];
+
+    int first = flat->inner_offsets[index];
+    int count = flat->inner_offsets[index + 1] - first;
+    mapping->inner_change_count = count;
+    mapping->inner_changes = NULL;
+    if (count == 0) return true;
+
+    mapping->inner_changes = (RangeMapping*)diff_malloc((size_t)count * sizeof(RangeMapping));
+    if (!mapping->inner_changes) {
+        mapping->inner_change_count = 0;
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        const int* inner = &flat->inner_changes[(size_t)(first + i) * FLAT_INNER_STRIDE];
+        mapping->inner_changes[i].original = read_char_range(inner);
+        mapping->inner_changes[i].modified = read_char_range(inner + 4);
+    }
+    return true;
+}
+
+LinesDiff* expand_flat_lines_diff(const FlatLinesDiff* flat) {
+    if (!flat) return NULL;
+
+    LinesDiff* diff = (LinesDiff*)diff_calloc(1, sizeof(LinesDiff));
+    if (!diff) return NULL;
+    diff->hit_timeout = flat->hit_timeout != 0;
+    diff->hit_memory_limit = flat->hit_memory_limit != 0;
+
+    bool ok = true;
+    if (flat->change_count > 0) {
+        diff->changes.mappings = (DetailedLineRangeMapping*)diff_calloc(
+            (size_t)flat->change_count, sizeof(DetailedLineRangeMapping));
+        ok = diff->changes.mappings != NULL;
+        if (ok) diff->changes.capacity = flat->change_count;
+    }
+    for (int i = 0; ok && i < flat->change_count; i++) {
+        diff->changes.count = i + 1;
+        ok = expand_change(flat, i, &diff->changes.mappings[i]);
+    }
+
+    if (ok && flat->move_count > 0) {
+        diff->moves.moves = (MovedText*)diff_calloc((size_t)flat->move_count, sizeof(MovedText));
+        ok = diff->moves.moves != NULL;
+        if (ok) diff->moves.capacity = flat->move_count;
+    }
+    for (int m = 0; ok && m < flat->move_count; m++) {
+        const int* fm = &flat->moves[(size_t)m * FLAT_MOVE_STRIDE];
+        MovedText* move = &diff->moves.moves[m];
+        diff->moves.count = m + 1;
+        move->original.start_line = fm[0];
+        move->original.end_line = fm[1];
+        move->modified.start_line = fm[2];
+        move->modified.end_line = fm[3];
+        if (fm[5] == 0) continue;
+
+        move->changes = (DetailedLineRangeMapping*)diff_calloc((size_t)fm[5], sizeof(DetailedLineRangeMapping));
+        ok = move->changes != NULL;
+        for (int i = 0; ok && i < fm[5]; i++) {
+            move->change_count = i + 1;
+            ok = expand_change(flat, fm[4] + i, &move->changes[i]);
+        }
+    }
+
+    if (!ok) {
+        free_lines_diff(diff);
+        return NULL;
+    }
+    return diff;
+}
+
+// ============================================================================
+// Stream I/O
+// ============================================================================
+//
+// [change_count][total_change_count][inner_change_count][move_count]
+// [hit_timeout][hit_memory_limit][int block exactly as in memory]
+//
+// ============================================================================
+
+bool write_flat_lines_diff(const FlatLinesDiff* flat, FILE* out) {
+    int header[6] = {flat->change_count, flat->total_change_count, flat->inner_change_count,
+                     flat->move_count, flat->hit_timeout, flat->hit_memory_limit};
+    size_t int_count = flat_int_count((size_t)flat->total_change_count,
+                                      (size_t)flat->inner_change_count, (size_t)flat->move_count);
+    return fwrite(header, sizeof(int), 6, out) == 6 &&
+           fwrite(flat->changes, sizeof(int), int_count, out) == int_count;
+}
+
+/** Every index the accessors and expand_flat_lines_diff() follow is in range */
+static bool flat_is_consistent(const FlatLinesDiff* flat) {
+    int previous = 0;
+    for (int i = 0; i <= flat->total_change_count; i++) {
+        int offset = flat->inner_offsets[i];
+        if (offset < previous || offset > flat->inner_change_count) return false;
+        previous = offset;
+    }
+    if (flat->inner_offsets[0] != 0 || previous != flat->inner_change_count) return false;
+
+    for (int m = 0; m < flat->move_count; m++) {
+        const int* fm = &flat->moves[(size_t)m * FLAT_MOVE_STRIDE];
+        if (fm[4] < flat->change_count || fm[5] < 0 ||
+            fm[5] > flat->total_change_count - fm[4]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FlatLinesDiff* read_flat_lines_diff(FILE* in) {
+    int header[6];
+    if (fread(header, sizeof(int), 6, in) != 6) return NULL;
+    if (header[0] < 0 || header[1] < header[0] || header[1] == INT32_MAX ||
+        header[2] < 0 || header[3] < 0) {
+        return NULL;
+    }
+
+    FlatLinesDiff* flat = flat_lines_diff_alloc(header[0], header[1], header[2], header[3],
+                                                header[4] != 0, header[5] != 0);
+    if (!flat) return NULL;
+
+    size_t int_count = flat_int_count((size_t)header[1], (size_t)header[2], (size_t)header[3]);
+    if (fread((int*)flat->changes, sizeof(int), int_count, in) != int_count ||
+        !flat_is_consistent(flat)) {
+        diff_free(flat);
+        return NULL;
+    }
+    return flat;
+}
+
+FlatLinesDiff* compute_diff_flat(const char** original_lines, int original_count,
+                                 const char** modified_lines, int modified_count,
+                                 const DiffOptions* options) {
+    LinesDiff* diff = compute_diff(original_lines, original_count,
+                                   modified_lines, modified_count, options);
+    if (!diff) return NULL;
+
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    free_lines_diff(diff);
+    return flat;
+}
+
+void free_flat_lines_diff(FlatLinesDiff* flat) {
+    diff_free(flat);
+}
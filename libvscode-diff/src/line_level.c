@@ -14,13 +14,19 @@
  */
 
 #include "line_level.h"
+#include "diff_allocator.h"
+#include "arena.h"
+#include "diff_workspace.h"
 #include "myers.h"
 #include "optimize.h"
 #include "sequence.h"
 #include "string_hash_map.h"
+#include "utils.h"
+#include "platform.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <ctype.h>
 
 /**
  * Equality scoring function for line-level DP algorithm
@@ -37,10 +43,23 @@
  * 
  * This scoring function makes the DP algorithm prefer longer matching lines
  * and gives minimal score to empty line matches.
+ * 
+ * C Note: The DP only calls this when the trimmed hashes are equal, so the
+ * lines can only differ in their leading/trailing whitespace. Each line gets
+ * a perfect hash of that whitespace "frame" and its match score up front
+ * (LineScoreTable), which turns the per-cell strcmp/strlen/log into array
+ * loads. Same values as VSCode (line length in bytes, as before).
  */
 typedef struct {
-    const char** lines_a;
-    const char** lines_b;
+    uint32_t* frame_a;        // Whitespace-frame id per original line
+    uint32_t* frame_b;        // Whitespace-frame id per modified line
+    double* score_b;          // Match score per modified line
+} LineScoreTable;
+
+typedef struct {
+    const uint32_t* frame_a;  // Tables shifted to the diffed range
+    const uint32_t* frame_b;
+    const double* score_b;
 } LineEqualityContext;
 
 static double line_equality_score(const ISequence* seq1, const ISequence* seq2,
@@ -48,21 +67,546 @@ static double line_equality_score(const ISequence* seq1, const ISequence* seq2,
     (void)seq1;
     (void)seq2;
     
-    LineEqualityContext* ctx = (LineEqualityContext*)user_data;
-    const char* line_a = ctx->lines_a[offset1];
-    const char* line_b = ctx->lines_b[offset2];
+    const LineEqualityContext* ctx = (const LineEqualityContext*)user_data;
     
-    if (strcmp(line_a, line_b) == 0) {
-        // Lines are equal
-        if (strlen(line_b) == 0) {
-            return 0.1;  // Empty line match gets minimal score
-        }
-        return 1.0 + log(1.0 + (double)strlen(line_b));  // Prefer longer matches
+    // Trimmed content is equal (DP precondition): equal frames = equal lines
+    if (ctx->frame_a[offset1] == ctx->frame_b[offset2]) {
+        return ctx->score_b[offset2];
     }
     
     return 0.99;  // Non-matching lines get nearly 1.0 (high penalty)
 }
 
+/**
+ * Perfect hash of a line's leading and trailing whitespace
+ * 
+ * Key is leading whitespace + '|' + trailing whitespace; the separator is not
+ * whitespace, so the split is unambiguous. Whitespace is classified exactly
+ * like the trimming used for the line hashes (isspace).
+ */
+static uint32_t whitespace_frame_id(StringHashMap* frames, const char* line, size_t length) {
+    size_t lead = 0;
+    while (lead < length && isspace((unsigned char)line[lead])) {
+        lead++;
+    }
+    size_t trail = 0;
+    while (trail < length - lead && isspace((unsigned char)line[length - 1 - trail])) {
+        trail++;
+    }
+    
+    char stack_key[256];
+    size_t key_length = lead + 1 + trail;
+    char* key = key_length <= sizeof(stack_key) ? stack_key : (char*)diff_malloc(key_length);
+    if (!key) {
+        return UINT32_MAX;  // Matches nothing: falls back to the 0.99 score
+    }
+    memcpy(key, line, lead);
+    key[lead] = '|';
+    memcpy(key + lead + 1, line + length - trail, trail);
+    
+    uint32_t id = string_hash_map_get_or_create_n(frames, key, key_length);
+    if (key != stack_key) {
+        diff_free(key);
+    }
+    return id;
+}
+
+static void line_score_table_free(LineScoreTable* table) {
+    diff_scratch_free(table->frame_a);
+    diff_scratch_free(table->frame_b);
+    diff_scratch_free(table->score_b);
+    table->frame_a = NULL;
+    table->frame_b = NULL;
+    table->score_b = NULL;
+}
+
+/**
+ * Build the per-line tables for line_equality_score, once per diff
+ * @return false on allocation failure
+ */
+static bool line_score_table_init(LineScoreTable* table,
+                                  const LineSequence* a, const LineSequence* b) {
+    int len_a = a->length;
+    int len_b = b->length;
+    size_t count_a = (size_t)(len_a > 0 ? len_a : 1);
+    size_t count_b = (size_t)(len_b > 0 ? len_b : 1);
+    table->frame_a = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * count_a);
+    table->frame_b = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * count_b);
+    table->score_b = (double*)diff_scratch_malloc(sizeof(double) * count_b);
+    if (!table->frame_a || !table->frame_b || !table->score_b) {
+        line_score_table_free(table);
+        return false;
+    }
+    
+    StringHashMap* frames = string_hash_map_create();
+    for (int i = 0; i < len_a; i++) {
+        table->frame_a[i] = whitespace_frame_id(frames, a->lines[i], (size_t)a->line_lengths[i]);
+    }
+    for (int j = 0; j < len_b; j++) {
+        size_t length = (size_t)b->line_lengths[j];
+        table->frame_b[j] = whitespace_frame_id(frames, b->lines[j], length);
+        table->score_b[j] = length == 0
+            ? 0.1                                   // Empty line match gets minimal score
+            : 1.0 + log(1.0 + (double)length);      // Prefer longer matches
+    }
+    string_hash_map_destroy(frames);
+    return true;
+}
+
+/**
+ * Count the lines both sides share at the start and at the end
+ * 
+ * A line only counts when its trimmed hash matches AND the raw text is equal.
+ * The prefix is exactly what O(ND) Myers' first snake would consume; matching
+ * the suffix is also part of a minimal edit script, so the edit distance is
+ * unchanged. Placements at the window edges are normalized by
+ * optimize_sequence_diffs on the full sequences. The suffix never overlaps
+ * the prefix.
+ */
+static void find_common_affixes(const ISequence* seq1, const ISequence* seq2,
+                                int* out_prefix, int* out_suffix) {
+    const LineSequence* a = (const LineSequence*)seq1->data;
+    const LineSequence* b = (const LineSequence*)seq2->data;
+    int max_common = a->length < b->length ? a->length : b->length;
+    
+    int prefix = 0;
+    while (prefix < max_common &&
+           a->trimmed_hash[prefix] == b->trimmed_hash[prefix] &&
+           diff_lines_equal(a->lines[prefix], a->line_lengths[prefix],
+                            b->lines[prefix], b->line_lengths[prefix])) {
+        prefix++;
+    }
+    
+    int suffix = 0;
+    while (suffix < max_common - prefix) {
+        int i = a->length - 1 - suffix;
+        int j = b->length - 1 - suffix;
+        if (a->trimmed_hash[i] != b->trimmed_hash[j] ||
+            !diff_lines_equal(a->lines[i], a->line_lengths[i], b->lines[j], b->line_lengths[j])) {
+            break;
+        }
+        suffix++;
+    }
+    
+    *out_prefix = prefix;
+    *out_suffix = suffix;
+}
+
+/** Files with fewer lines in total use the scored DP (VSCode line 83) */
+#define LINE_DP_MAX_TOTAL_LINES 1700
+
+/** Upper bound on worker threads for anchored ranges */
+#define MAX_ANCHOR_THREADS 64
+
+/**
+ * Run Myers on lines [range.seq1_start, range.seq1_end) x
+ * [range.seq2_start, range.seq2_end) and map the result back to
+ * full-sequence offsets.
+ * 
+ * DIFF_ENGINE_DP needs initialized scores; threads only apply to
+ * DIFF_ENGINE_LINEAR.
+ */
+static SequenceDiffArray* diff_line_range(const ISequence* seq1, const ISequence* seq2,
+                                          const LineScoreTable* scores,
+                                          SequenceDiff range, DiffEngine engine,
+                                          int threads, int timeout_ms, bool* hit_timeout) {
+    ISequence* window1 = line_sequence_create_window(seq1, range.seq1_start,
+                                                     range.seq1_end - range.seq1_start);
+    ISequence* window2 = line_sequence_create_window(seq2, range.seq2_start,
+                                                     range.seq2_end - range.seq2_start);
+    
+    SequenceDiffArray* result;
+    if (engine == DIFF_ENGINE_DP) {
+        // Use DP algorithm with equality scoring for small files
+        LineEqualityContext ctx = {
+            .frame_a = scores->frame_a + range.seq1_start,
+            .frame_b = scores->frame_b + range.seq2_start,
+            .score_b = scores->score_b + range.seq2_start
+        };
+        
+        result = myers_dp_diff_algorithm(
+            window1, window2, timeout_ms, hit_timeout,
+            line_equality_score, &ctx
+        );
+    } else if (engine == DIFF_ENGINE_LINEAR) {
+        // O(N + M) memory for very large files
+        result = myers_linear_diff_algorithm(window1, window2, timeout_ms, threads, hit_timeout);
+    } else {
+        // Use Myers O(ND) for large files
+        result = myers_nd_diff_algorithm(window1, window2, timeout_ms, hit_timeout);
+    }
+    
+    window1->destroy(window1);
+    window2->destroy(window2);
+    
+    if (result) {
+        for (int i = 0; i < result->count; i++) {
+            SequenceDiff* diff = &result->diffs[i];
+            diff->seq1_start += range.seq1_start;
+            diff->seq1_end += range.seq1_start;
+            diff->seq2_start += range.seq2_start;
+            diff->seq2_end += range.seq2_start;
+        }
+    }
+    return result;
+}
+
+/**
+ * Whether the scored DP should diff a range: VSCode's fixed cutoff on total
+ * lines, or the cost model when thresholds->cost_model is set (not VSCode)
+ */
+static bool line_range_uses_dp(const ISequence* seq1, const ISequence* seq2, SequenceDiff range,
+                               const DiffEngineThresholds* thresholds) {
+    int len1 = range.seq1_end - range.seq1_start;
+    int len2 = range.seq2_end - range.seq2_start;
+    if (!thresholds->cost_model) {
+        return len1 + len2 < thresholds->dp_max_total;
+    }
+    
+    ISequence* window1 = line_sequence_create_window(seq1, range.seq1_start, len1);
+    ISequence* window2 = line_sequence_create_window(seq2, range.seq2_start, len2);
+    bool use_dp = diff_engine_prefers_dp(window1, window2, true, thresholds->dp_max_cells, NULL);
+    window1->destroy(window1);
+    window2->destroy(window2);
+    return use_dp;
+}
+
+// ============================================================================
+// Unique-Line Anchoring (patience-style, large files only)
+// ============================================================================
+
+/**
+ * Find anchors: lines whose trimmed hash occurs exactly once in each side of
+ * the window, reduced to the longest chain that is increasing on both sides
+ * (patience sorting, O(k log k)).
+ * 
+ * NOT part of VSCode. Enabled through LineAlignmentOptions.anchor_unique_lines.
+ * 
+ * @param hash_count Number of distinct hashes (perfect hashes are 0..hash_count-1)
+ * @param out_anchor1 Output: seq1 offsets of anchors, ascending (caller frees)
+ * @param out_anchor2 Output: seq2 offsets of anchors, ascending (caller frees)
+ * @return Number of anchors, or -1 on allocation failure
+ */
+static int find_unique_line_anchors(const ISequence* seq1, const ISequence* seq2,
+                                    SequenceDiff window, int hash_count,
+                                    int** out_anchor1, int** out_anchor2) {
+    const LineSequence* a = (const LineSequence*)seq1->data;
+    const LineSequence* b = (const LineSequence*)seq2->data;
+    int len1 = window.seq1_end - window.seq1_start;
+    int len2 = window.seq2_end - window.seq2_start;
+    int max_candidates = len1 < len2 ? len1 : len2;
+    
+    // Occurrence counts saturate at 2; position_b is valid when count_b == 1
+    size_t table_size = (size_t)(hash_count > 0 ? hash_count : 1);
+    unsigned char* count_a = (unsigned char*)diff_scratch_calloc(table_size, 1);
+    unsigned char* count_b = (unsigned char*)diff_scratch_calloc(table_size, 1);
+    int* position_b = (int*)diff_scratch_malloc(sizeof(int) * table_size);
+    // Candidates in seq1 order, then patience piles over their seq2 offsets
+    int* cand1 = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(max_candidates + 1));
+    int* cand2 = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(max_candidates + 1));
+    int* pile_top = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(max_candidates + 1));
+    int* predecessor = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(max_candidates + 1));
+    
+    int anchor_count = -1;
+    if (!count_a || !count_b || !position_b || !cand1 || !cand2 || !pile_top || !predecessor) {
+        goto cleanup;
+    }
+    
+    for (int i = window.seq1_start; i < window.seq1_end; i++) {
+        uint32_t h = a->trimmed_hash[i];
+        if (count_a[h] < 2) count_a[h]++;
+    }
+    for (int j = window.seq2_start; j < window.seq2_end; j++) {
+        uint32_t h = b->trimmed_hash[j];
+        if (count_b[h] < 2) count_b[h]++;
+        position_b[h] = j;
+    }
+    
+    int candidate_count = 0;
+    for (int i = window.seq1_start; i < window.seq1_end; i++) {
+        uint32_t h = a->trimmed_hash[i];
+        if (count_a[h] == 1 && count_b[h] == 1) {
+            cand1[candidate_count] = i;
+            cand2[candidate_count] = position_b[h];
+            candidate_count++;
+        }
+    }
+    
+    // Longest increasing subsequence of cand2 (cand1 is already ascending)
+    int piles = 0;
+    for (int k = 0; k < candidate_count; k++) {
+        int lo = 0;
+        int hi = piles;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (cand2[pile_top[mid]] < cand2[k]) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        predecessor[k] = lo > 0 ? pile_top[lo - 1] : -1;
+        pile_top[lo] = k;
+        if (lo == piles) piles++;
+    }
+    
+    // Walk the chain back from the last pile, writing anchors in place
+    int* anchor1 = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(piles + 1));
+    int* anchor2 = (int*)diff_scratch_malloc(sizeof(int) * (size_t)(piles + 1));
+    if (!anchor1 || !anchor2) {
+        diff_scratch_free(anchor1);
+        diff_scratch_free(anchor2);
+        goto cleanup;
+    }
+    int k = piles > 0 ? pile_top[piles - 1] : -1;
+    for (int n = piles - 1; n >= 0; n--) {
+        anchor1[n] = cand1[k];
+        anchor2[n] = cand2[k];
+        k = predecessor[k];
+    }
+    
+    *out_anchor1 = anchor1;
+    *out_anchor2 = anchor2;
+    anchor_count = piles;
+    
+cleanup:
+    diff_scratch_free(count_a);
+    diff_scratch_free(count_b);
+    diff_scratch_free(position_b);
+    diff_scratch_free(cand1);
+    diff_scratch_free(cand2);
+    diff_scratch_free(pile_top);
+    diff_scratch_free(predecessor);
+    return anchor_count;
+}
+
+/**
+ * One independent sub-range between two anchors
+ */
+typedef struct {
+    SequenceDiff range;
+    SequenceDiffArray* result;
+    bool hit_timeout;
+    DiffEngine engine;        // Engine that diffed the range
+} AnchoredRange;
+
+/**
+ * Shared state for the anchored-range worker pool.
+ * Inputs are read-only; each range's output slot is written by one worker.
+ */
+typedef struct {
+    AnchoredRange* ranges;
+    int range_count;
+    int next_range;           // Guarded by lock
+    diff_mutex_t lock;
+    
+    const ISequence* seq1;
+    const ISequence* seq2;
+    const LineScoreTable* scores;
+    const Timeout* timeout;
+    const DiffEngineThresholds* thresholds;  // DP or large_engine per gap
+    DiffEngine large_engine;  // Engine for gaps too big for the DP
+    DiffMemoryBudget* memory_budget;  // Caller's budget, forwarded to workers
+    DiffStats* stats;                 // Caller's statistics (NULL = none)
+} AnchoredRangeQueue;
+
+static void run_anchored_range(AnchoredRangeQueue* queue, AnchoredRange* range) {
+    // Each range takes whatever is left of the shared budget
+    int timeout_ms = 0;
+    if (queue->timeout->timeout_ms > 0) {
+        timeout_ms = timeout_remaining_ms(queue->timeout);
+        if (timeout_ms == 0) {
+            // Budget exhausted: this range stays one whole-range diff
+            SequenceDiffArray* whole =
+                (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
+            SequenceDiff* diff = (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff));
+            if (!whole || !diff) {
+                diff_scratch_free(whole);
+                diff_scratch_free(diff);
+                return;  // result stays NULL: reported as allocation failure
+            }
+            diff[0] = range->range;
+            whole->diffs = diff;
+            whole->count = 1;
+            whole->capacity = 1;
+            range->result = whole;
+            range->hit_timeout = true;
+            return;
+        }
+    }
+    
+    // Gaps already run in parallel, so the linear engine stays sequential
+    range->engine = line_range_uses_dp(queue->seq1, queue->seq2, range->range, queue->thresholds)
+                    ? DIFF_ENGINE_DP : queue->large_engine;
+    range->result = diff_line_range(queue->seq1, queue->seq2,
+                                    queue->scores, range->range,
+                                    range->engine, 0, timeout_ms, &range->hit_timeout);
+}
+
+static void* anchored_range_worker(void* arg) {
+    AnchoredRangeQueue* queue = (AnchoredRangeQueue*)arg;
+    // Per-range Myers timeouts must see the caller's cancellation
+    diff_set_thread_cancel_flag(queue->timeout->cancel);
+    diff_set_thread_memory_budget(queue->memory_budget);
+    // Counters go to a private copy, merged once the queue is drained
+    DiffStats local_stats;
+    memset(&local_stats, 0, sizeof(local_stats));
+    DiffStats* previous_stats = diff_get_thread_stats();
+    diff_set_thread_stats(queue->stats ? &local_stats : NULL);
+    for (;;) {
+        diff_mutex_lock(&queue->lock);
+        int idx = queue->next_range++;
+        diff_mutex_unlock(&queue->lock);
+        
+        if (idx >= queue->range_count) break;
+        run_anchored_range(queue, &queue->ranges[idx]);
+    }
+    diff_set_thread_stats(previous_stats);
+    if (queue->stats) {
+        diff_mutex_lock(&queue->lock);
+        diff_stats_merge(queue->stats, &local_stats);
+        diff_mutex_unlock(&queue->lock);
+    }
+    return NULL;
+}
+
+/**
+ * Split the window at unique-line anchors and diff each gap independently,
+ * on up to `threads` workers (the calling thread participates).
+ * 
+ * Small gaps use the scored DP, large ones O(ND), so a timeout only degrades
+ * the gap that ran out of budget instead of the whole file.
+ * Engines that ran are added to engine_counts (can be NULL).
+ * 
+ * @return Concatenated diffs in full-sequence offsets, or NULL on failure
+ */
+static SequenceDiffArray* diff_anchored(const ISequence* seq1, const ISequence* seq2,
+                                        const LineScoreTable* scores,
+                                        SequenceDiff window, int hash_count,
+                                        const DiffEngineThresholds* thresholds,
+                                        DiffEngine large_engine, int threads,
+                                        const Timeout* timeout, DiffEngineCounts* engine_counts,
+                                        bool* hit_timeout) {
+    int* anchor1 = NULL;
+    int* anchor2 = NULL;
+    int anchor_count = find_unique_line_anchors(seq1, seq2, window, hash_count,
+                                                &anchor1, &anchor2);
+    if (anchor_count < 0) {
+        return NULL;
+    }
+    
+    // Gaps between consecutive anchors (and the window edges)
+    AnchoredRange* ranges =
+        (AnchoredRange*)diff_scratch_malloc(sizeof(AnchoredRange) * (size_t)(anchor_count + 1));
+    if (!ranges) {
+        diff_scratch_free(anchor1);
+        diff_scratch_free(anchor2);
+        return NULL;
+    }
+    int range_count = 0;
+    int prev1 = window.seq1_start;
+    int prev2 = window.seq2_start;
+    for (int k = 0; k <= anchor_count; k++) {
+        int next1 = k < anchor_count ? anchor1[k] : window.seq1_end;
+        int next2 = k < anchor_count ? anchor2[k] : window.seq2_end;
+        if (next1 > prev1 || next2 > prev2) {
+            AnchoredRange* range = &ranges[range_count++];
+            range->range.seq1_start = prev1;
+            range->range.seq1_end = next1;
+            range->range.seq2_start = prev2;
+            range->range.seq2_end = next2;
+            range->result = NULL;
+            range->hit_timeout = false;
+            range->engine = large_engine;
+        }
+        prev1 = next1 + 1;
+        prev2 = next2 + 1;
+    }
+    diff_scratch_free(anchor1);
+    diff_scratch_free(anchor2);
+    
+    AnchoredRangeQueue queue = {
+        .ranges = ranges,
+        .range_count = range_count,
+        .next_range = 0,
+        .seq1 = seq1,
+        .seq2 = seq2,
+        .scores = scores,
+        .timeout = timeout,
+        .thresholds = thresholds,
+        .large_engine = large_engine,
+        .memory_budget = diff_get_thread_memory_budget(),
+        .stats = diff_get_thread_stats()
+    };
+    
+    int thread_count = threads;
+    if (thread_count > MAX_ANCHOR_THREADS) thread_count = MAX_ANCHOR_THREADS;
+    if (thread_count > range_count) thread_count = range_count;
+    
+    if (thread_count <= 1) {
+        for (int i = 0; i < range_count; i++) {
+            run_anchored_range(&queue, &ranges[i]);
+        }
+    } else {
+        diff_thread_t workers[MAX_ANCHOR_THREADS];
+        int started = 0;
+        diff_mutex_init(&queue.lock);
+        for (int i = 0; i < thread_count - 1; i++) {
+            if (!diff_thread_create(&workers[started], anchored_range_worker, &queue)) break;
+            started++;
+        }
+        anchored_range_worker(&queue);
+        for (int i = 0; i < started; i++) {
+            diff_thread_join(&workers[i]);
+        }
+        diff_mutex_destroy(&queue.lock);
+    }
+    
+    // Merge in range order (ranges never touch: an anchor separates them)
+    SequenceDiffArray* merged = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
+    int total = 0;
+    bool ok = merged != NULL;
+    for (int i = 0; i < range_count; i++) {
+        if (!ranges[i].result) {
+            ok = false;
+        } else {
+            total += ranges[i].result->count;
+        }
+        if (ranges[i].hit_timeout) {
+            *hit_timeout = true;
+        }
+        if (ranges[i].result) {
+            diff_engine_count(engine_counts, ranges[i].engine);
+        }
+    }
+    if (ok) {
+        merged->diffs =
+            (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff) * (size_t)(total > 0 ? total : 1));
+        merged->count = 0;
+        merged->capacity = total;
+        ok = merged->diffs != NULL;
+    }
+    for (int i = 0; i < range_count; i++) {
+        SequenceDiffArray* result = ranges[i].result;
+        if (!result) continue;
+        if (ok && result->count > 0) {
+            memcpy(merged->diffs + merged->count, result->diffs,
+                   sizeof(SequenceDiff) * (size_t)result->count);
+            merged->count += result->count;
+        }
+        diff_scratch_free(result->diffs);
+        diff_scratch_free(result);
+    }
+    diff_scratch_free(ranges);
+    
+    if (!ok) {
+        if (merged) diff_scratch_free(merged->diffs);
+        diff_scratch_free(merged);
+        return NULL;
+    }
+    return merged;
+}
+
 /**
  * compute_line_alignments() - VSCode Parity
  * 
@@ -73,64 +617,303 @@ SequenceDiffArray* compute_line_alignments(
     const char** lines_b, int len_b,
     int timeout_ms,
     bool* hit_timeout) {
+    return compute_line_alignments_with_options(lines_a, len_a, lines_b, len_b,
+                                                timeout_ms, NULL, hit_timeout);
+}
+
+SequenceDiffArray* compute_line_alignments_with_options(
+    const char** lines_a, int len_a,
+    const char** lines_b, int len_b,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout) {
+    return compute_line_alignments_n(lines_a, NULL, len_a, lines_b, NULL, len_b,
+                                     timeout_ms, options, hit_timeout);
+}
+
+/**
+ * Steps 4-6 on two hashed line sequences (see line_level.h)
+ */
+SequenceDiffArray* compute_line_alignments_sequences(
+    const ISequence* seq1, const ISequence* seq2,
+    int hash_count,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout) {
     
-    if (!lines_a || !lines_b || !hit_timeout) {
+    if (!seq1 || !seq2 || !hit_timeout) {
         return NULL;
     }
     
     *hit_timeout = false;
     
-    // Step 1: Create perfect hash map (VSCode line 68-75)
-    StringHashMap* hash_map = string_hash_map_create();
+    DiffPhaseStart phase_start = diff_stats_phase_start();
+    DiffEngineThresholds thresholds = {0, false, 0};
+    if (options) thresholds = options->engine;
+    if (thresholds.dp_max_total <= 0) thresholds.dp_max_total = LINE_DP_MAX_TOTAL_LINES;
     
-    // Step 2: Hash all lines (trimmed) - VSCode line 77-78
-    // VSCode always uses l.trim() for hashing, regardless of ignoreTrimWhitespace option
-    // The ignoreTrimWhitespace option only affects char-level comparison later
+    // Selection uses the full line counts so the DP/O(ND) choice matches VSCode
+    int len_a = seq1->getLength(seq1);
+    int len_b = seq2->getLength(seq2);
+    SequenceDiff full = {0, len_a, 0, len_b};
+    bool use_dp = !thresholds.cost_model && line_range_uses_dp(seq1, seq2, full, &thresholds);
+    DiffEngine large_engine = options && options->linear_space ? DIFF_ENGINE_LINEAR
+                                                               : DIFF_ENGINE_MYERS;
     
-    // Step 3: Create LineSequence with trimmed hashes (VSCode line 80-81)
-    // Pass true to hash trimmed lines, matching VSCode's getOrCreateHash(l.trim())
-    ISequence* seq1 = line_sequence_create(lines_a, len_a, true, hash_map);
-    ISequence* seq2 = line_sequence_create(lines_b, len_b, true, hash_map);
+    // Step 4a: Large files - strip the common prefix/suffix so O(ND) Myers only
+    // sees the window that actually differs. Optimization below still runs on
+    // the full sequences. The DP path is bounded by the 1700-line cutoff and
+    // keeps full input: its run-length scoring breaks ties across the whole
+    // sequence, so a window would change its (equally good) placements.
+    // The cost model (not VSCode) sizes the engines on the window instead.
+    int prefix = 0;
+    int suffix = 0;
+    if (!use_dp) {
+        find_common_affixes(seq1, seq2, &prefix, &suffix);
+    }
+    SequenceDiff window = {
+        .seq1_start = prefix,
+        .seq1_end = len_a - suffix,
+        .seq2_start = prefix,
+        .seq2_end = len_b - suffix
+    };
+    if (thresholds.cost_model) {
+        use_dp = line_range_uses_dp(seq1, seq2, window, &thresholds);
+    }
     
-    // Step 4: Run Myers diff with algorithm selection (VSCode line 83-97)
-    SequenceDiffArray* line_alignments;
+    // Step 4b: Run Myers diff with algorithm selection (VSCode line 83-97)
+    // Optionally split large windows at unique-line anchors first (not VSCode)
+    // Score tables are only needed where the scored DP can run
+    bool anchored = !use_dp && options && options->anchor_unique_lines;
+    LineScoreTable scores = {NULL, NULL, NULL};
+    bool scores_ok = !(use_dp || anchored) ||
+                     line_score_table_init(&scores, (const LineSequence*)seq1->data,
+                                           (const LineSequence*)seq2->data);
     
-    int total_lines = len_a + len_b;
-    if (total_lines < 1700) {
-        // Use DP algorithm with equality scoring for small files
-        LineEqualityContext ctx = {
-            .lines_a = lines_a,
-            .lines_b = lines_b
-        };
-        
-        line_alignments = myers_dp_diff_algorithm(
-            seq1, seq2, timeout_ms, hit_timeout,
-            line_equality_score, &ctx
-        );
+    SequenceDiffArray* line_alignments = NULL;
+    if (!scores_ok) {
+        // Allocation failure: reported as NULL below
+    } else if (anchored) {
+        Timeout timeout;
+        timeout_init(&timeout, timeout_ms);
+        line_alignments = diff_anchored(seq1, seq2, &scores, window,
+                                        hash_count, &thresholds,
+                                        large_engine, options->threads, &timeout,
+                                        options->engine_counts, hit_timeout);
     } else {
-        // Use Myers O(ND) for large files
-        line_alignments = myers_nd_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout);
+        DiffEngine engine = use_dp ? DIFF_ENGINE_DP : large_engine;
+        line_alignments = diff_line_range(seq1, seq2, &scores, window, engine,
+                                          options ? options->threads : 0,
+                                          timeout_ms, hit_timeout);
+        if (line_alignments && options) {
+            diff_engine_count(options->engine_counts, engine);
+        }
     }
+    line_score_table_free(&scores);
+    diff_stats_add_phase(DIFF_PHASE_LINE_DIFF, phase_start);
     
     if (!line_alignments) {
-        seq1->destroy(seq1);
-        seq2->destroy(seq2);
-        string_hash_map_destroy(hash_map);
         return NULL;
     }
     
     // Step 5: Apply Step 2 optimization (VSCode line 244)
+    // Runs on the full sequences, so diffs at the window edges can still be
+    // shifted/joined into the stripped prefix and suffix
+    phase_start = diff_stats_phase_start();
     line_alignments = optimize_sequence_diffs(seq1, seq2, line_alignments);
     
     // Step 6: Apply Step 3 optimization (VSCode line 245)
     line_alignments = remove_very_short_matching_lines_between_diffs(seq1, seq2, line_alignments);
+    diff_stats_add_phase(DIFF_PHASE_LINE_OPTIMIZE, phase_start);
+    
+    return line_alignments;
+}
+
+
+/**
+ * Install the calling thread's workspace arena for one alignment.
+ * 
+ * Only single-threaded alignments use it: arenas belong to one thread, and
+ * gap/linear-space workers allocate off the heap. Nothing happens without a
+ * workspace.
+ * 
+ * @return Installed arena (NULL = none), to pass to line_arena_end()
+ */
+static DiffArena* line_arena_begin(const LineAlignmentOptions* options, DiffArena** previous) {
+    DiffWorkspace* workspace = diff_get_thread_workspace();
+    if (!workspace || (options && options->threads > 1)) {
+        return NULL;
+    }
+    DiffArena* arena = diff_workspace_acquire_arena(workspace);
+    if (arena) {
+        *previous = diff_scratch_begin(arena);
+    }
+    return arena;
+}
+
+/**
+ * Uninstall a line_arena_begin() arena, moving the result to the heap
+ * (callers free it with free_sequence_diff_array).
+ */
+static SequenceDiffArray* line_arena_end(DiffArena* arena, DiffArena* previous,
+                                         SequenceDiffArray* result) {
+    if (!arena) {
+        return result;
+    }
+    diff_scratch_end(previous);
+    
+    SequenceDiffArray* copy = NULL;
+    if (result) {
+        copy = (SequenceDiffArray*)diff_malloc(sizeof(SequenceDiffArray));
+        SequenceDiff* diffs = (SequenceDiff*)diff_malloc(sizeof(SequenceDiff) *
+                                                    (size_t)(result->count > 0 ? result->count : 1));
+        if (copy && diffs) {
+            if (result->count > 0) {
+                memcpy(diffs, result->diffs, sizeof(SequenceDiff) * (size_t)result->count);
+            }
+            copy->diffs = diffs;
+            copy->count = result->count;
+            copy->capacity = result->count;
+        } else {
+            diff_free(copy);
+            diff_free(diffs);
+            copy = NULL;
+        }
+    }
+    diff_workspace_release_arena(diff_get_thread_workspace(), arena);
+    return copy;
+}
+
+SequenceDiffArray* compute_line_alignments_n(
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout) {
+    
+    if (!lines_a || !lines_b || !hit_timeout) {
+        return NULL;
+    }
+    
+    *hit_timeout = false;
+    DiffWorkspace* workspace = diff_get_thread_workspace();
+    DiffArena* previous = NULL;
+    DiffArena* arena = line_arena_begin(options, &previous);
+    
+    // Step 1: Create perfect hash map (VSCode line 68-75)
+    DiffPhaseStart phase_start = diff_stats_phase_start();
+    StringHashMap* hash_map = diff_workspace_acquire_hash_map(workspace);
+    
+    // Step 2: Hash all lines (trimmed) - VSCode line 77-78
+    // VSCode always uses l.trim() for hashing, regardless of ignoreTrimWhitespace option
+    // The ignoreTrimWhitespace option only affects char-level comparison later
+    
+    // Step 3: Create LineSequence with trimmed hashes (VSCode line 80-81)
+    // Pass true to hash trimmed lines, matching VSCode's getOrCreateHash(l.trim())
+    ISequence* seq1 = line_sequence_create_n(lines_a, lengths_a, len_a, true, hash_map);
+    ISequence* seq2 = line_sequence_create_n(lines_b, lengths_b, len_b, true, hash_map);
+    diff_stats_add_phase(DIFF_PHASE_LINE_HASH, phase_start);
+    
+    SequenceDiffArray* line_alignments = compute_line_alignments_sequences(
+        seq1, seq2, string_hash_map_size(hash_map), timeout_ms, options, hit_timeout);
     
     // Cleanup sequences (but keep the result)
     seq1->destroy(seq1);
     seq2->destroy(seq2);
-    string_hash_map_destroy(hash_map);
+    diff_workspace_release_hash_map(workspace, hash_map);
     
-    return line_alignments;
+    return line_arena_end(arena, previous, line_alignments);
+}
+
+SequenceDiffArray* compute_line_alignments_ex(
+    DiffWorkspace* workspace,
+    const char** lines_a, const int* lengths_a, int len_a,
+    const char** lines_b, const int* lengths_b, int len_b,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout) {
+    DiffWorkspace* previous = diff_get_thread_workspace();
+    diff_set_thread_workspace(workspace);
+    SequenceDiffArray* result = compute_line_alignments_n(lines_a, lengths_a, len_a,
+                                                          lines_b, lengths_b, len_b,
+                                                          timeout_ms, options, hit_timeout);
+    diff_set_thread_workspace(previous);
+    return result;
+}
+
+bool prepared_line_sequence_init(PreparedLineSequence* prepared,
+                                 const char** lines, const int* lengths, int count) {
+    prepared->sequence = NULL;
+    prepared->hash_map = NULL;
+    if (!lines && count > 0) {
+        return false;
+    }
+    
+    // Outlives any per-diff scratch arena of the calling thread
+    DiffArena* previous = diff_scratch_begin(NULL);
+    prepared->hash_map = string_hash_map_create();
+    if (prepared->hash_map) {
+        // Trimmed hashing, exactly as compute_line_alignments_n (VSCode line 80-81)
+        prepared->sequence = line_sequence_create_n(lines, lengths, count, true,
+                                                    prepared->hash_map);
+    }
+    diff_scratch_end(previous);
+    
+    if (!prepared->sequence) {
+        prepared_line_sequence_free(prepared);
+        return false;
+    }
+    return true;
+}
+
+void prepared_line_sequence_free(PreparedLineSequence* prepared) {
+    DiffArena* previous = diff_scratch_begin(NULL);
+    if (prepared->sequence) {
+        prepared->sequence->destroy(prepared->sequence);
+    }
+    string_hash_map_destroy(prepared->hash_map);
+    diff_scratch_end(previous);
+    prepared->sequence = NULL;
+    prepared->hash_map = NULL;
+}
+
+SequenceDiffArray* compute_line_alignments_prepared(
+    const PreparedLineSequence* prepared, bool prepared_is_original,
+    const char** other_lines, const int* other_lengths, int other_count,
+    int timeout_ms,
+    const LineAlignmentOptions* options,
+    bool* hit_timeout) {
+    
+    if (!prepared || !prepared->sequence || !other_lines || !hit_timeout) {
+        return NULL;
+    }
+    
+    *hit_timeout = false;
+    DiffWorkspace* workspace = diff_get_thread_workspace();
+    
+    // Only the other side is hashed: its new lines go into a private overlay,
+    // so the prepared map stays read-only and shareable between threads
+    DiffPhaseStart phase_start = diff_stats_phase_start();
+    StringHashMap* overlay = diff_workspace_acquire_hash_map(workspace);
+    if (!overlay) {
+        return NULL;
+    }
+    DiffArena* previous = NULL;
+    DiffArena* arena = line_arena_begin(options, &previous);
+    ISequence* other = line_sequence_create_layered_n(other_lines, other_lengths, other_count,
+                                                      true, prepared->hash_map, overlay);
+    diff_stats_add_phase(DIFF_PHASE_LINE_HASH, phase_start);
+    
+    int hash_count = string_hash_map_size(prepared->hash_map) + string_hash_map_size(overlay);
+    const ISequence* seq1 = prepared_is_original ? prepared->sequence : other;
+    const ISequence* seq2 = prepared_is_original ? other : prepared->sequence;
+    SequenceDiffArray* line_alignments = compute_line_alignments_sequences(
+        seq1, seq2, hash_count, timeout_ms, options, hit_timeout);
+    
+    other->destroy(other);
+    diff_workspace_release_hash_map(workspace, overlay);
+    
+    return line_arena_end(arena, previous, line_alignments);
 }
 
 /**
@@ -138,7 +921,7 @@ SequenceDiffArray* compute_line_alignments(
  */
 void free_sequence_diff_array(SequenceDiffArray* arr) {
     if (arr) {
-        free(arr->diffs);
-        free(arr);
+        diff_free(arr->diffs);
+        diff_free(arr);
     }
 }
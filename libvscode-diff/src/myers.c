@@ -4,6 +4,7 @@
  * This implementation provides two algorithms with automatic selection:
  * 1. O(MN) DP algorithm - for small sequences (exact LCS with optional scoring)
  * 2. O(ND) Myers algorithm - for large sequences (space-efficient)
+ * plus an opt-in linear-space O(ND) variant for very large inputs (not VSCode)
  * 
  * Algorithm selection matches VSCode exactly:
  * - Lines: DP if total < 1700, otherwise Myers O(ND)
@@ -11,7 +12,8 @@
  * 
  * INFRASTRUCTURE IMPROVEMENTS:
  * 1. ISequence interface - works with any sequence type (lines, chars)
- * 2. Hash-based comparison - fast element matching via getElement()
+ * 2. Hash-based comparison - fast element matching on dense element arrays
+ *    (getElements(), gathered via getElement() when a sequence has none)
  * 3. Strong equality check - prevents hash collision issues
  * 4. Boundary scoring support - enables optimization in Steps 2-3
  * 5. Timeout protection - prevents hanging on massive diffs
@@ -24,15 +26,15 @@
  */
 
 #include "myers.h"
+#include "diff_allocator.h"
 #include "sequence.h"
 #include "string_hash_map.h"
+#include "utils.h"
+#include "arena.h"
+#include "platform.h"
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
-
-// Forward declarations
-static int myers_get_x_after_snake(const ISequence* seq_a, const ISequence* seq_b,
-                                   int x, int y);
+#include <stdint.h>
 
 // Helper: Min/Max functions
 static int min_int(int a, int b) { return a < b ? a : b; }
@@ -41,35 +43,74 @@ static int max_int(int a, int b) { return a > b ? a : b; }
 static double max_double(double a, double b) { return a > b ? a : b; }
 
 //==============================================================================
-// 2D Array Helper (for DP algorithm)
+// Dense Element Access (shared by both algorithms)
 //==============================================================================
 
+/**
+ * Elements of seq as a contiguous array, so the kernels below index an array
+ * instead of calling getElement() per cell or per snake step.
+ * 
+ * Uses getElements() when the sequence provides it (LineSequence,
+ * CharSequence). Otherwise falls back to gathering through getElement() into
+ * scratch memory, which *owned receives (free with diff_scratch_free).
+ * 
+ * @return Element array, or NULL on allocation failure
+ */
+static const uint32_t* sequence_dense_elements(const ISequence* seq, int length,
+                                               uint32_t** owned) {
+    *owned = NULL;
+    if (seq->getElements) {
+        const uint32_t* elements = seq->getElements(seq);
+        if (elements) return elements;
+    }
+    
+    uint32_t* gathered = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * (size_t)(length > 0 ? length : 1));
+    if (!gathered) return NULL;
+    for (int i = 0; i < length; i++) {
+        gathered[i] = seq->getElement(seq, i);
+    }
+    *owned = gathered;
+    return gathered;
+}
 
-typedef struct {
-    double* data;
-    int rows;
-    int cols;
-} Array2D;
+//==============================================================================
+// Packed Direction Matrix (for DP algorithm)
+//==============================================================================
 
-static Array2D* array2d_create(int rows, int cols) {
-    Array2D* arr = (Array2D*)malloc(sizeof(Array2D));
-    arr->rows = rows;
-    arr->cols = cols;
-    arr->data = (double*)calloc(rows * cols, sizeof(double));
-    return arr;
-}
+/**
+ * Backtracking directions, 2 bits per cell (4 cells per byte).
+ *
+ * VSCode keeps three full len1*len2 matrices (lcsLengths, directions, lengths).
+ * Only the directions are needed after the fill pass; LCS scores and diagonal
+ * run lengths are only ever read from the previous row, so those are kept as
+ * two rolling rows instead. This cuts memory from 24 bytes to 2 bits per cell.
+ */
+#define DP_DIR_NONE       0
+#define DP_DIR_HORIZONTAL 1
+#define DP_DIR_VERTICAL   2
+#define DP_DIR_DIAGONAL   3
+
+typedef struct {
+    uint8_t* data;
+    size_t cols;
+} PackedDirections;
 
-static void array2d_free(Array2D* arr) {
-    free(arr->data);
-    free(arr);
+static bool packed_directions_init(PackedDirections* dirs, int rows, int cols) {
+    size_t cells = (size_t)rows * (size_t)cols;
+    dirs->cols = (size_t)cols;
+    dirs->data = (uint8_t*)diff_scratch_calloc((cells + 3) / 4, sizeof(uint8_t));
+    return dirs->data != NULL;
 }
 
-static double array2d_get(const Array2D* arr, int row, int col) {
-    return arr->data[row * arr->cols + col];
+static inline int packed_directions_get(const PackedDirections* dirs, int row, int col) {
+    size_t cell = (size_t)row * dirs->cols + (size_t)col;
+    return (dirs->data[cell >> 2] >> ((cell & 3) << 1)) & 3;
 }
 
-static void array2d_set(Array2D* arr, int row, int col, double value) {
-    arr->data[row * arr->cols + col] = value;
+/** Cells are written exactly once, so OR-ing into the zeroed byte is enough */
+static inline void packed_directions_set(PackedDirections* dirs, int row, int col, int dir) {
+    size_t cell = (size_t)row * dirs->cols + (size_t)col;
+    dirs->data[cell >> 2] |= (uint8_t)(dir << ((cell & 3) << 1));
 }
 
 //==============================================================================
@@ -77,109 +118,68 @@ static void array2d_set(Array2D* arr, int row, int col, double value) {
 // VSCode Reference: dynamicProgrammingDiffing.ts
 //==============================================================================
 
+static SequenceDiffArray* trivial_diff_result(int len1, int len2) {
+    SequenceDiffArray* result = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
+    if (len1 == 0 && len2 == 0) {
+        result->diffs = NULL;
+        result->count = 0;
+        result->capacity = 0;
+    } else {
+        result->diffs = (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff));
+        result->diffs[0].seq1_start = 0;
+        result->diffs[0].seq1_end = len1;
+        result->diffs[0].seq2_start = 0;
+        result->diffs[0].seq2_end = len2;
+        result->count = 1;
+        result->capacity = 1;
+    }
+    return result;
+}
+
 /**
- * Myers O(MN) DP-based Diff Algorithm
- * 
- * A O(MN) diffing algorithm that supports a score function.
- * Uses dynamic programming to find the longest common subsequence (LCS).
- * 
- * This implementation matches VSCode's DynamicProgrammingDiffing exactly:
- * - Uses 3 matrices: lcsLengths, directions, lengths
- * - Supports optional equality scoring
- * - Prefers consecutive diagonals for better diff quality
- * - Backtracks to build SequenceDiff array
+ * Scored fill pass (VSCode's recurrence, one cell at a time)
  * 
- * VSCode uses this for small sequences:
- * - Line-level: when total lines < 1700
- * - Char-level: when total chars < 500
+ * @return false on timeout
  */
-SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequence* seq2,
-                                           int timeout_ms, bool* hit_timeout,
-                                           EqualityScoreFn score_fn, void* user_data) {
-    if (hit_timeout) *hit_timeout = false;
-    
-    int len1 = seq1->getLength(seq1);
-    int len2 = seq2->getLength(seq2);
+static bool dp_fill_scored(const ISequence* seq1, const ISequence* seq2,
+                           const uint32_t* elements1, int len1,
+                           const uint32_t* elements2, int len2,
+                           double* prev_lcs, double* cur_lcs, int* prev_run, int* cur_run,
+                           PackedDirections* directions, Timeout* timeout,
+                           EqualityScoreFn score_fn, void* user_data) {
+    int work_since_check = TIMEOUT_CHECK_INTERVAL;
     
-    // Handle trivial cases
-    if (len1 == 0 || len2 == 0) {
-        SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
-        if (len1 == 0 && len2 == 0) {
-            result->diffs = NULL;
-            result->count = 0;
-            result->capacity = 0;
-        } else {
-            result->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff));
-            result->diffs[0].seq1_start = 0;
-            result->diffs[0].seq1_end = len1;
-            result->diffs[0].seq2_start = 0;
-            result->diffs[0].seq2_end = len2;
-            result->count = 1;
-            result->capacity = 1;
-        }
-        return result;
-    }
-    
-    // Create 3 matrices as in VSCode's implementation
-    Array2D* lcs_lengths = array2d_create(len1, len2);   // LCS length at each position
-    Array2D* directions = array2d_create(len1, len2);     // Direction taken (1=horizontal, 2=vertical, 3=diagonal)
-    Array2D* lengths = array2d_create(len1, len2);        // Length of consecutive diagonals
-    
-    // Timeout tracking
-    clock_t start_time = clock();
-    double timeout_seconds = timeout_ms / 1000.0;
-    
-    // Fill matrices (VSCode's algorithm)
     for (int s1 = 0; s1 < len1; s1++) {
+        if (!timeout_check_amortized(timeout, &work_since_check, len2)) {
+            return false;
+        }
+        
+        const uint32_t element1 = elements1[s1];
         for (int s2 = 0; s2 < len2; s2++) {
-            // Check timeout
-            if (timeout_ms > 0) {
-                clock_t current_time = clock();
-                double elapsed = (double)(current_time - start_time) / CLOCKS_PER_SEC;
-                if (elapsed > timeout_seconds) {
-                    if (hit_timeout) *hit_timeout = true;
-                    
-                    // Return trivial diff
-                    array2d_free(lcs_lengths);
-                    array2d_free(directions);
-                    array2d_free(lengths);
-                    
-                    SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
-                    result->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff));
-                    result->diffs[0].seq1_start = 0;
-                    result->diffs[0].seq1_end = len1;
-                    result->diffs[0].seq2_start = 0;
-                    result->diffs[0].seq2_end = len2;
-                    result->count = 1;
-                    result->capacity = 1;
-                    return result;
-                }
-            }
-            
             // Get values from previous cells
-            double horizontal_len = (s1 == 0) ? 0 : array2d_get(lcs_lengths, s1 - 1, s2);
-            double vertical_len = (s2 == 0) ? 0 : array2d_get(lcs_lengths, s1, s2 - 1);
+            double horizontal_len = (s1 == 0) ? 0 : prev_lcs[s2];
+            double vertical_len = (s2 == 0) ? 0 : cur_lcs[s2 - 1];
+            
+            // Diagonal predecessor's run length (0 unless it was a diagonal)
+            int diag_run = (s1 > 0 && s2 > 0) ? prev_run[s2 - 1] : 0;
             
             // Calculate diagonal score
             double extended_seq_score;
-            if (seq1->getElement(seq1, s1) == seq2->getElement(seq2, s2)) {
+            if (element1 == elements2[s2]) {
                 if (s1 == 0 || s2 == 0) {
                     extended_seq_score = 0;
                 } else {
-                    extended_seq_score = array2d_get(lcs_lengths, s1 - 1, s2 - 1);
+                    extended_seq_score = prev_lcs[s2 - 1];
                 }
                 
                 // Prefer consecutive diagonals (VSCode optimization)
-                if (s1 > 0 && s2 > 0 && array2d_get(directions, s1 - 1, s2 - 1) == 3) {
-                    extended_seq_score += array2d_get(lengths, s1 - 1, s2 - 1);
+                if (s1 > 0 && s2 > 0 &&
+                    packed_directions_get(directions, s1 - 1, s2 - 1) == DP_DIR_DIAGONAL) {
+                    extended_seq_score += diag_run;
                 }
                 
                 // Add equality score
-                if (score_fn) {
-                    extended_seq_score += score_fn(seq1, seq2, s1, s2, user_data);
-                } else {
-                    extended_seq_score += 1.0;
-                }
+                extended_seq_score += score_fn(seq1, seq2, s1, s2, user_data);
             } else {
                 extended_seq_score = -1;
             }
@@ -189,22 +189,208 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
             
             if (new_value == extended_seq_score) {
                 // Prefer diagonals (matching elements)
-                double prev_len = (s1 > 0 && s2 > 0) ? array2d_get(lengths, s1 - 1, s2 - 1) : 0;
-                array2d_set(lengths, s1, s2, prev_len + 1);
-                array2d_set(directions, s1, s2, 3);  // Diagonal
+                cur_run[s2] = diag_run + 1;
+                packed_directions_set(directions, s1, s2, DP_DIR_DIAGONAL);
             } else if (new_value == horizontal_len) {
-                array2d_set(lengths, s1, s2, 0);
-                array2d_set(directions, s1, s2, 1);  // Horizontal (delete from seq1)
+                cur_run[s2] = 0;
+                packed_directions_set(directions, s1, s2, DP_DIR_HORIZONTAL);  // Delete from seq1
             } else if (new_value == vertical_len) {
-                array2d_set(lengths, s1, s2, 0);
-                array2d_set(directions, s1, s2, 2);  // Vertical (insert into seq1)
+                cur_run[s2] = 0;
+                packed_directions_set(directions, s1, s2, DP_DIR_VERTICAL);  // Insert into seq1
+            } else {
+                cur_run[s2] = 0;
             }
             
-            array2d_set(lcs_lengths, s1, s2, new_value);
+            cur_lcs[s2] = new_value;
         }
+        
+        // Current row becomes the previous row
+        double* tmp_lcs = prev_lcs;
+        prev_lcs = cur_lcs;
+        cur_lcs = tmp_lcs;
+        int* tmp_run = prev_run;
+        prev_run = cur_run;
+        cur_run = tmp_run;
+    }
+    return true;
+}
+
+/**
+ * Match masks for the unscored fill pass: for every distinct element of seq2,
+ * a bit vector over seq2 positions (64 columns per word) marking where it
+ * occurs. Row s1 of the matrix matches exactly where the mask of
+ * elements1[s1] has bits set, so a row is scanned a word at a time and only
+ * matching cells do diagonal work.
+ * 
+ * This is the match table (Peq) of the bit-parallel LCS kernels (Allison-Dix,
+ * Hyyrö). Those kernels also pack the LCS row itself into bits, which relies
+ * on adjacent LCS cells differing by 0 or 1; VSCode's run-length bonus breaks
+ * that property, so the scores stay in an integer row.
+ * 
+ * Not VSCode: VSCode compares every cell.
+ */
+typedef struct {
+    uint32_t* keys;         // Open addressing, capacity slots
+    int* mask_index;        // Slot -> mask number, -1 for empty
+    int capacity;           // Power of two
+    uint64_t* masks;        // distinct * words
+    int words;
+} DpMatchMasks;
+
+static inline uint32_t dp_match_slot(uint32_t key, int capacity) {
+    return (key * 2654435769u) & (uint32_t)(capacity - 1);
+}
+
+static void dp_match_masks_free(DpMatchMasks* mm) {
+    diff_scratch_free(mm->keys);
+    diff_scratch_free(mm->mask_index);
+    diff_scratch_free(mm->masks);
+}
+
+static bool dp_match_masks_init(DpMatchMasks* mm, const uint32_t* elements2, int len2) {
+    mm->capacity = 16;
+    while (mm->capacity < len2 * 2) mm->capacity <<= 1;
+    mm->words = (len2 + 63) / 64;
+    mm->keys = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * (size_t)mm->capacity);
+    mm->mask_index = (int*)diff_scratch_malloc(sizeof(int) * (size_t)mm->capacity);
+    mm->masks = NULL;
+    if (!mm->keys || !mm->mask_index) {
+        dp_match_masks_free(mm);
+        return false;
     }
+    for (int i = 0; i < mm->capacity; i++) mm->mask_index[i] = -1;
     
-    // Backtrack to build diffs (VSCode's algorithm)
+    // Number the distinct elements, then size the masks to fit
+    int distinct = 0;
+    for (int s2 = 0; s2 < len2; s2++) {
+        uint32_t slot = dp_match_slot(elements2[s2], mm->capacity);
+        while (mm->mask_index[slot] >= 0 && mm->keys[slot] != elements2[s2]) {
+            slot = (slot + 1) & (uint32_t)(mm->capacity - 1);
+        }
+        if (mm->mask_index[slot] < 0) {
+            mm->keys[slot] = elements2[s2];
+            mm->mask_index[slot] = distinct++;
+        }
+    }
+    
+    mm->masks = (uint64_t*)diff_scratch_calloc((size_t)distinct * (size_t)mm->words, sizeof(uint64_t));
+    if (!mm->masks) {
+        dp_match_masks_free(mm);
+        return false;
+    }
+    for (int s2 = 0; s2 < len2; s2++) {
+        uint32_t slot = dp_match_slot(elements2[s2], mm->capacity);
+        while (mm->keys[slot] != elements2[s2]) {
+            slot = (slot + 1) & (uint32_t)(mm->capacity - 1);
+        }
+        mm->masks[(size_t)mm->mask_index[slot] * (size_t)mm->words + (size_t)(s2 >> 6)] |=
+            (uint64_t)1 << (s2 & 63);
+    }
+    return true;
+}
+
+/** Mask of key's positions in seq2, or NULL when key does not occur */
+static const uint64_t* dp_match_mask(const DpMatchMasks* mm, uint32_t key) {
+    uint32_t slot = dp_match_slot(key, mm->capacity);
+    while (mm->mask_index[slot] >= 0) {
+        if (mm->keys[slot] == key) {
+            return mm->masks + (size_t)mm->mask_index[slot] * (size_t)mm->words;
+        }
+        slot = (slot + 1) & (uint32_t)(mm->capacity - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Unscored fill pass: same recurrence and tie-breaking as dp_fill_scored()
+ * with an equality score of 1, so it writes the same directions.
+ * 
+ * Without a score function every value is an integer (at most ~len^2/2), and
+ * a cell's diagonal run is non-zero exactly when its direction is diagonal,
+ * so the run row stands in for the packed_directions_get() lookup. Between
+ * matches a cell only takes the larger of its upper and left neighbours.
+ * 
+ * Not VSCode: integer rows and match masks instead of per-cell comparisons.
+ * 
+ * @return false on timeout
+ */
+static bool dp_fill_unscored(const uint32_t* elements1, int len1, int len2,
+                             const DpMatchMasks* mm, int* prev_lcs, int* cur_lcs,
+                             int* prev_run, int* cur_run,
+                             PackedDirections* directions, Timeout* timeout) {
+    int work_since_check = TIMEOUT_CHECK_INTERVAL;
+    
+    // Row -1 is all zeros, which is what VSCode reads for s1 == 0
+    memset(prev_lcs, 0, sizeof(int) * (size_t)len2);
+    memset(prev_run, 0, sizeof(int) * (size_t)len2);
+    
+    for (int s1 = 0; s1 < len1; s1++) {
+        if (!timeout_check_amortized(timeout, &work_since_check, len2)) {
+            return false;
+        }
+        
+        const uint64_t* mask = dp_match_mask(mm, elements1[s1]);
+        int left = 0;   // cur_lcs[s2 - 1], 0 before the first column
+        for (int w = 0; w < mm->words; w++) {
+            uint64_t bits = mask ? mask[w] : 0;
+            int s2 = w * 64;
+            int word_end = min_int(s2 + 64, len2);
+            
+            while (s2 < word_end) {
+                int next_match = bits ? (w * 64 + diff_ctz64(bits)) : word_end;
+                
+                // Non-matching cells: horizontal unless the left value is larger
+                for (; s2 < next_match; s2++) {
+                    int up = prev_lcs[s2];
+                    if (up >= left) {
+                        left = up;
+                        packed_directions_set(directions, s1, s2, DP_DIR_HORIZONTAL);
+                    } else {
+                        packed_directions_set(directions, s1, s2, DP_DIR_VERTICAL);
+                    }
+                    cur_lcs[s2] = left;
+                    cur_run[s2] = 0;
+                }
+                if (s2 == word_end) break;
+                
+                // Matching cell
+                int up = prev_lcs[s2];
+                int diag_run = s2 > 0 ? prev_run[s2 - 1] : 0;
+                int extended = (s2 > 0 ? prev_lcs[s2 - 1] : 0) + diag_run + 1;
+                if (extended >= up && extended >= left) {
+                    left = extended;
+                    cur_run[s2] = diag_run + 1;
+                    packed_directions_set(directions, s1, s2, DP_DIR_DIAGONAL);
+                } else {
+                    cur_run[s2] = 0;
+                    if (up >= left) {
+                        left = up;
+                        packed_directions_set(directions, s1, s2, DP_DIR_HORIZONTAL);
+                    } else {
+                        packed_directions_set(directions, s1, s2, DP_DIR_VERTICAL);
+                    }
+                }
+                cur_lcs[s2] = left;
+                s2++;
+                bits &= bits - 1;
+            }
+        }
+        
+        // Current row becomes the previous row
+        int* tmp_lcs = prev_lcs;
+        prev_lcs = cur_lcs;
+        cur_lcs = tmp_lcs;
+        int* tmp_run = prev_run;
+        prev_run = cur_run;
+        cur_run = tmp_run;
+    }
+    return true;
+}
+
+/**
+ * Backtrack the direction matrix into SequenceDiffs (VSCode's algorithm)
+ */
+static SequenceDiffArray* dp_backtrack(const PackedDirections* directions, int len1, int len2) {
     // First pass: count diffs
     int diff_count = 0;
     int s1 = len1 - 1;
@@ -213,8 +399,8 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
     int last_align_s2 = len2;
     
     while (s1 >= 0 && s2 >= 0) {
-        int dir = (int)array2d_get(directions, s1, s2);
-        if (dir == 3) {
+        int dir = packed_directions_get(directions, s1, s2);
+        if (dir == DP_DIR_DIAGONAL) {
             // Diagonal - this is a match, emit diff if needed
             if (s1 + 1 != last_align_s1 || s2 + 1 != last_align_s2) {
                 diff_count++;
@@ -223,7 +409,7 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
             last_align_s2 = s2;
             s1--;
             s2--;
-        } else if (dir == 1) {
+        } else if (dir == DP_DIR_HORIZONTAL) {
             // Horizontal
             s1--;
         } else {
@@ -238,11 +424,11 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
     }
     
     // Second pass: build result
-    SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
+    SequenceDiffArray* result = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
     result->count = diff_count;
     result->capacity = diff_count;
     result->diffs = diff_count > 0 ? 
-                    (SequenceDiff*)malloc(diff_count * sizeof(SequenceDiff)) : NULL;
+                    (SequenceDiff*)diff_scratch_malloc(diff_count * sizeof(SequenceDiff)) : NULL;
     
     s1 = len1 - 1;
     s2 = len2 - 1;
@@ -251,8 +437,8 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
     int idx = diff_count - 1;
     
     while (s1 >= 0 && s2 >= 0) {
-        int dir = (int)array2d_get(directions, s1, s2);
-        if (dir == 3) {
+        int dir = packed_directions_get(directions, s1, s2);
+        if (dir == DP_DIR_DIAGONAL) {
             // Diagonal - emit diff if there was a gap
             if (s1 + 1 != last_align_s1 || s2 + 1 != last_align_s2) {
                 result->diffs[idx].seq1_start = s1 + 1;
@@ -265,7 +451,7 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
             last_align_s2 = s2;
             s1--;
             s2--;
-        } else if (dir == 1) {
+        } else if (dir == DP_DIR_HORIZONTAL) {
             s1--;
         } else {
             s2--;
@@ -280,11 +466,108 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
         result->diffs[idx].seq2_end = last_align_s2;
     }
     
-    // Cleanup
-    array2d_free(lcs_lengths);
-    array2d_free(directions);
-    array2d_free(lengths);
+    return result;
+}
+
+/**
+ * Myers O(MN) DP-based Diff Algorithm
+ * 
+ * A O(MN) diffing algorithm that supports a score function.
+ * Uses dynamic programming to find the longest common subsequence (LCS).
+ * 
+ * This implementation matches VSCode's DynamicProgrammingDiffing exactly:
+ * - Same recurrence as lcsLengths/directions/lengths, but only directions are
+ *   kept for the whole matrix (2-bit packed); scores and diagonal run lengths
+ *   use two rolling rows
+ * - Supports optional equality scoring
+ * - Prefers consecutive diagonals for better diff quality
+ * - Same tie-breaking: diagonal, then horizontal, then vertical
+ * - Backtracks to build SequenceDiff array
+ * 
+ * Without a score function (the char-level case) the fill pass runs on
+ * integer rows and per-element match masks (dp_fill_unscored()), which
+ * computes the same directions with diagonal work only at matching cells.
+ * 
+ * A matrix over the thread's memory budget (utils.h) runs O(ND) Myers
+ * instead (not VSCode).
+ * 
+ * VSCode uses this for small sequences:
+ * - Line-level: when total lines < 1700
+ * - Char-level: when total chars < 500
+ */
+SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequence* seq2,
+                                           int timeout_ms, bool* hit_timeout,
+                                           EqualityScoreFn score_fn, void* user_data) {
+    if (hit_timeout) *hit_timeout = false;
+    
+    int len1 = seq1->getLength(seq1);
+    int len2 = seq2->getLength(seq2);
+    
+    // Handle trivial cases
+    if (len1 == 0 || len2 == 0) {
+        return trivial_diff_result(len1, len2);
+    }
+    
+    // Directions, rolling rows and (unscored) match masks
+    size_t score_size = score_fn ? sizeof(double) : sizeof(int);
+    int64_t dp_bytes = ((int64_t)len1 * len2 + 3) / 4 +
+                       (int64_t)len2 * (int64_t)(2 * score_size + 2 * sizeof(int)) +
+                       (score_fn ? 0 : (int64_t)len2 * (int64_t)(sizeof(uint64_t) * ((len2 + 63) / 64) + 16));
+    if (!diff_memory_fits(dp_bytes)) {
+        return myers_nd_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout);
+    }
+    
+    uint32_t* owned1;
+    uint32_t* owned2;
+    const uint32_t* elements1 = sequence_dense_elements(seq1, len1, &owned1);
+    const uint32_t* elements2 = sequence_dense_elements(seq2, len2, &owned2);
+    
+    // Rolling rows indexed by s2: row s1 - 1 (prev) and row s1 (cur); the
+    // unscored pass keeps integer scores in the same buffers
+    PackedDirections directions;
+    DpMatchMasks match_masks = {NULL, NULL, 0, NULL, 0};
+    void* prev_lcs = diff_scratch_malloc((size_t)len2 * score_size);
+    void* cur_lcs = diff_scratch_malloc((size_t)len2 * score_size);
+    int* prev_run = (int*)diff_scratch_malloc((size_t)len2 * sizeof(int));
+    int* cur_run = (int*)diff_scratch_malloc((size_t)len2 * sizeof(int));
+    bool dirs_ok = packed_directions_init(&directions, len1, len2);
+    bool masks_ok = score_fn || (elements2 && dp_match_masks_init(&match_masks, elements2, len2));
+    
+    bool completed = false;
+    if (dirs_ok && masks_ok && prev_lcs && cur_lcs && prev_run && cur_run &&
+        elements1 && elements2) {
+        // Timeout tracking (wall clock, checked once per row and amortized
+        // over rows; VSCode checks timeout.isValid() per cell)
+        Timeout timeout;
+        timeout_init(&timeout, timeout_ms);
+        
+        if (score_fn) {
+            completed = dp_fill_scored(seq1, seq2, elements1, len1, elements2, len2,
+                                       (double*)prev_lcs, (double*)cur_lcs, prev_run, cur_run,
+                                       &directions, &timeout, score_fn, user_data);
+        } else {
+            completed = dp_fill_unscored(elements1, len1, len2, &match_masks,
+                                         (int*)prev_lcs, (int*)cur_lcs, prev_run, cur_run,
+                                         &directions, &timeout);
+        }
+        if (!completed && hit_timeout) *hit_timeout = true;
+        
+        DiffStats* stats = diff_get_thread_stats();
+        if (stats) stats->dp_cells += (int64_t)len1 * len2;
+    }
+    // Otherwise out of memory: degrade to a single whole-range diff
     
+    dp_match_masks_free(&match_masks);
+    diff_scratch_free(prev_lcs);
+    diff_scratch_free(cur_lcs);
+    diff_scratch_free(prev_run);
+    diff_scratch_free(cur_run);
+    diff_scratch_free(owned1);
+    diff_scratch_free(owned2);
+    
+    SequenceDiffArray* result = completed ? dp_backtrack(&directions, len1, len2)
+                                          : trivial_diff_result(len1, len2);
+    diff_scratch_free(directions.data);
     return result;
 }
 
@@ -293,161 +576,103 @@ SequenceDiffArray* myers_dp_diff_algorithm(const ISequence* seq1, const ISequenc
 // VSCode Reference: myersDiffAlgorithm.ts
 //==============================================================================
 
-// Simple dynamic array for storing integers (supports negative indices)
-typedef struct {
-    int* positive;
-    int* negative;
-    int pos_capacity;
-    int neg_capacity;
-} IntArray;
-
-static IntArray* intarray_create(void) {
-    IntArray* arr = (IntArray*)malloc(sizeof(IntArray));
-    arr->pos_capacity = 10;
-    arr->neg_capacity = 10;
-    arr->positive = (int*)calloc(arr->pos_capacity, sizeof(int));
-    arr->negative = (int*)calloc(arr->neg_capacity, sizeof(int));
-    return arr;
-}
-
-static void intarray_free(IntArray* arr) {
-    free(arr->positive);
-    free(arr->negative);
-    free(arr);
-}
-
-static int intarray_get(IntArray* arr, int idx) {
-    if (idx < 0) {
-        int neg_idx = -idx - 1;
-        return (neg_idx < arr->neg_capacity) ? arr->negative[neg_idx] : 0;
-    } else {
-        return (idx < arr->pos_capacity) ? arr->positive[idx] : 0;
-    }
-}
+/**
+ * Snake path graph, stored as one index-linked vector instead of one malloc
+ * per SnakePath. A path is the index of its last snake; -1 is the empty path.
+ * 
+ * VSCode Reference: SnakePath in myersDiffAlgorithm.ts (prev pointer chain)
+ */
+#define SNAKE_NONE (-1)
 
-static void intarray_set(IntArray* arr, int idx, int value) {
-    if (idx < 0) {
-        int neg_idx = -idx - 1;
-        if (neg_idx >= arr->neg_capacity) {
-            int new_cap = arr->neg_capacity * 2;
-            while (neg_idx >= new_cap) new_cap *= 2;
-            arr->negative = (int*)realloc(arr->negative, new_cap * sizeof(int));
-            memset(arr->negative + arr->neg_capacity, 0, 
-                   (new_cap - arr->neg_capacity) * sizeof(int));
-            arr->neg_capacity = new_cap;
-        }
-        arr->negative[neg_idx] = value;
-    } else {
-        if (idx >= arr->pos_capacity) {
-            int new_cap = arr->pos_capacity * 2;
-            while (idx >= new_cap) new_cap *= 2;
-            arr->positive = (int*)realloc(arr->positive, new_cap * sizeof(int));
-            memset(arr->positive + arr->pos_capacity, 0,
-                   (new_cap - arr->pos_capacity) * sizeof(int));
-            arr->pos_capacity = new_cap;
-        }
-        arr->positive[idx] = value;
-    }
+/** Edit distance an O(ND) run reached, for DiffStats (not VSCode) */
+static void stats_record_myers_d(int d) {
+    DiffStats* stats = diff_get_thread_stats();
+    if (stats && d > stats->myers_max_d) stats->myers_max_d = d;
 }
 
-// Simple path structure to track snake paths
-typedef struct SnakePath {
-    struct SnakePath* prev;
+typedef struct {
+    int prev;       // Index of the previous snake, SNAKE_NONE at the start
     int x;
     int y;
     int length;
-} SnakePath;
+} SnakeNode;
 
-static SnakePath* snakepath_create(SnakePath* prev, int x, int y, int length) {
-    SnakePath* path = (SnakePath*)malloc(sizeof(SnakePath));
-    path->prev = prev;
-    path->x = x;
-    path->y = y;
-    path->length = length;
-    return path;
-}
+typedef struct {
+    SnakeNode* nodes;
+    int count;
+    int capacity;
+    int64_t fixed_bytes;   // Other working memory counted against the budget
+    bool over_budget;      // Growth refused by the thread's memory budget
+} SnakePool;
 
-static void snakepath_free_chain(SnakePath* path) {
-    while (path) {
-        SnakePath* prev = path->prev;
-        free(path);
-        path = prev;
-    }
+/** Upper bound on the initial pool size; larger inputs grow by doubling */
+#define SNAKE_POOL_MAX_INITIAL (64 * 1024)
+
+static int snakepool_initial_capacity(int initial_capacity) {
+    if (initial_capacity < 16) initial_capacity = 16;
+    if (initial_capacity > SNAKE_POOL_MAX_INITIAL) initial_capacity = SNAKE_POOL_MAX_INITIAL;
+    return initial_capacity;
 }
 
-// Dynamic array for storing SnakePath pointers (supports negative indices)
-typedef struct {
-    SnakePath** positive;
-    SnakePath** negative;
-    int pos_capacity;
-    int neg_capacity;
-} PathArray;
-
-static PathArray* patharray_create(void) {
-    PathArray* arr = (PathArray*)malloc(sizeof(PathArray));
-    arr->pos_capacity = 10;
-    arr->neg_capacity = 10;
-    arr->positive = (SnakePath**)calloc(arr->pos_capacity, sizeof(SnakePath*));
-    arr->negative = (SnakePath**)calloc(arr->neg_capacity, sizeof(SnakePath*));
-    return arr;
-}
-
-static void patharray_free(PathArray* arr) {
-    // Note: We don't free individual paths here as they're freed later
-    free(arr->positive);
-    free(arr->negative);
-    free(arr);
-}
-
-static SnakePath* patharray_get(PathArray* arr, int idx) {
-    if (idx < 0) {
-        int neg_idx = -idx - 1;
-        return (neg_idx < arr->neg_capacity) ? arr->negative[neg_idx] : NULL;
-    } else {
-        return (idx < arr->pos_capacity) ? arr->positive[idx] : NULL;
-    }
+static bool snakepool_init(SnakePool* pool, int initial_capacity, int64_t fixed_bytes) {
+    initial_capacity = snakepool_initial_capacity(initial_capacity);
+    pool->nodes = (SnakeNode*)diff_scratch_malloc(sizeof(SnakeNode) * (size_t)initial_capacity);
+    pool->count = 0;
+    pool->capacity = initial_capacity;
+    pool->fixed_bytes = fixed_bytes;
+    pool->over_budget = false;
+    return pool->nodes != NULL;
 }
 
-static void patharray_set(PathArray* arr, int idx, SnakePath* value) {
-    if (idx < 0) {
-        int neg_idx = -idx - 1;
-        if (neg_idx >= arr->neg_capacity) {
-            int new_cap = arr->neg_capacity * 2;
-            while (neg_idx >= new_cap) new_cap *= 2;
-            arr->negative = (SnakePath**)realloc(arr->negative, 
-                                                 new_cap * sizeof(SnakePath*));
-            memset(arr->negative + arr->neg_capacity, 0,
-                   (new_cap - arr->neg_capacity) * sizeof(SnakePath*));
-            arr->neg_capacity = new_cap;
-        }
-        arr->negative[neg_idx] = value;
-    } else {
-        if (idx >= arr->pos_capacity) {
-            int new_cap = arr->pos_capacity * 2;
-            while (idx >= new_cap) new_cap *= 2;
-            arr->positive = (SnakePath**)realloc(arr->positive,
-                                                 new_cap * sizeof(SnakePath*));
-            memset(arr->positive + arr->pos_capacity, 0,
-                   (new_cap - arr->pos_capacity) * sizeof(SnakePath*));
-            arr->pos_capacity = new_cap;
+/** @return Index of the new snake, or SNAKE_NONE on allocation failure */
+static int snakepool_push(SnakePool* pool, int prev, int x, int y, int length) {
+    if (pool->count == pool->capacity) {
+        int new_capacity = pool->capacity * 2;
+        if (!diff_memory_fits(pool->fixed_bytes + (int64_t)sizeof(SnakeNode) * new_capacity)) {
+            pool->over_budget = true;
+            return SNAKE_NONE;
         }
-        arr->positive[idx] = value;
+        SnakeNode* grown = (SnakeNode*)diff_scratch_realloc(pool->nodes,
+                                                            sizeof(SnakeNode) * (size_t)new_capacity);
+        if (!grown) return SNAKE_NONE;
+        pool->nodes = grown;
+        pool->capacity = new_capacity;
     }
+    SnakeNode* node = &pool->nodes[pool->count];
+    node->prev = prev;
+    node->x = x;
+    node->y = y;
+    node->length = length;
+    return pool->count++;
 }
 
-// Helper: Get X position after following snake (diagonal matches)
-// Now uses ISequence.getElement() for hash-based comparison
-static int myers_get_x_after_snake(const ISequence* seq_a, const ISequence* seq_b,
-                                   int x, int y) {
-    int len_a = seq_a->getLength(seq_a);
-    int len_b = seq_b->getLength(seq_b);
+/**
+ * Get X position after following snake (diagonal matches)
+ * 
+ * Innermost loop of the library: compares the dense element arrays two
+ * elements (one 64-bit word) at a time, four words per iteration, then
+ * finishes element by element.
+ */
+static inline int myers_get_x_after_snake(const uint32_t* elements_a, int len_a,
+                                          const uint32_t* elements_b, int len_b,
+                                          int x, int y) {
+    const uint32_t* a = elements_a + x;
+    const uint32_t* b = elements_b + y;
+    int n = min_int(len_a - x, len_b - y);
+    int i = 0;
     
-    while (x < len_a && y < len_b && 
-           seq_a->getElement(seq_a, x) == seq_b->getElement(seq_b, y)) {
-        x++;
-        y++;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t a0, a1, a2, a3, b0, b1, b2, b3;
+        memcpy(&a0, a + i, 8);     memcpy(&b0, b + i, 8);
+        memcpy(&a1, a + i + 2, 8); memcpy(&b1, b + i + 2, 8);
+        memcpy(&a2, a + i + 4, 8); memcpy(&b2, b + i + 4, 8);
+        memcpy(&a3, a + i + 6, 8); memcpy(&b3, b + i + 6, 8);
+        if (((a0 ^ b0) | (a1 ^ b1) | (a2 ^ b2) | (a3 ^ b3)) != 0) break;
+    }
+    while (i < n && a[i] == b[i]) {
+        i++;
     }
-    return x;
+    return x + i;
 }
 
 // Main Myers O(ND) Forward Algorithm
@@ -461,13 +686,13 @@ SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequenc
     
     // Handle trivial cases
     if (len_a == 0 || len_b == 0) {
-        SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
+        SequenceDiffArray* result = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
         if (len_a == 0 && len_b == 0) {
             result->diffs = NULL;
             result->count = 0;
             result->capacity = 0;
         } else {
-            result->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff));
+            result->diffs = (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff));
             result->diffs[0].seq1_start = 0;
             result->diffs[0].seq1_end = len_a;
             result->diffs[0].seq2_start = 0;
@@ -478,48 +703,86 @@ SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequenc
         return result;
     }
 
-    IntArray* V = intarray_create();
-    PathArray* paths = patharray_create();
+    uint32_t* owned_a;
+    uint32_t* owned_b;
+    const uint32_t* elements_a = sequence_dense_elements(seq1, len_a, &owned_a);
+    const uint32_t* elements_b = sequence_dense_elements(seq2, len_b, &owned_b);
+    if (!elements_a || !elements_b) {
+        diff_scratch_free(owned_a);
+        diff_scratch_free(owned_b);
+        return trivial_diff_result(len_a, len_b);
+    }
+    
+    // Diagonals k range over [-len_b - 1, len_a + 1]; V and paths are flat
+    // arrays sized once from len_a + len_b and indexed by k + diagonal_offset
+    int diagonal_offset = len_b + 1;
+    size_t diagonal_count = (size_t)len_a + (size_t)len_b + 3;
+    int64_t fixed_bytes = (int64_t)diagonal_count * (int64_t)(2 * sizeof(int));
+    if (!diff_memory_fits(fixed_bytes + (int64_t)sizeof(SnakeNode) *
+                                        snakepool_initial_capacity(len_a + len_b))) {
+        diff_scratch_free(owned_a);
+        diff_scratch_free(owned_b);
+        return myers_linear_diff_algorithm(seq1, seq2, timeout_ms, 0, hit_timeout);
+    }
+    int* V = (int*)diff_scratch_calloc(diagonal_count, sizeof(int));
+    int* paths = (int*)diff_scratch_malloc(diagonal_count * sizeof(int));
+    SnakePool pool;
+    bool pool_ok = snakepool_init(&pool, len_a + len_b, fixed_bytes);
+    
+    if (!V || !paths || !pool_ok) {
+        diff_scratch_free(V);
+        diff_scratch_free(paths);
+        diff_scratch_free(pool.nodes);
+        diff_scratch_free(owned_a);
+        diff_scratch_free(owned_b);
+        return trivial_diff_result(len_a, len_b);
+    }
+    for (size_t i = 0; i < diagonal_count; i++) {
+        paths[i] = SNAKE_NONE;
+    }
+    V += diagonal_offset;
+    paths += diagonal_offset;
     
-    int initial_x = myers_get_x_after_snake(seq1, seq2, 0, 0);
-    intarray_set(V, 0, initial_x);
-    patharray_set(paths, 0, 
-                  initial_x == 0 ? NULL : snakepath_create(NULL, 0, 0, initial_x));
+    int initial_x = myers_get_x_after_snake(elements_a, len_a, elements_b, len_b, 0, 0);
+    V[0] = initial_x;
+    paths[0] = initial_x == 0 ? SNAKE_NONE : snakepool_push(&pool, SNAKE_NONE, 0, 0, initial_x);
 
     int d = 0;
     int k = 0;
     int found = 0;
+    bool out_of_memory = false;
     
-    // Timeout tracking
-    clock_t start_time = clock();
-    double timeout_seconds = timeout_ms / 1000.0;
+    // Timeout tracking (wall clock, amortized over diagonals and snakes)
+    Timeout timeout;
+    timeout_init(&timeout, timeout_ms);
+    int work_since_check = TIMEOUT_CHECK_INTERVAL;
+    int work = 0;
 
     // Main loop: increase edit distance until we reach the end
     while (!found) {
         d++;
         
         // Check timeout (VSCode's timeout support)
-        if (timeout_ms > 0) {
-            clock_t current_time = clock();
-            double elapsed = (double)(current_time - start_time) / CLOCKS_PER_SEC;
-            if (elapsed > timeout_seconds) {
-                if (hit_timeout) *hit_timeout = true;
-                
-                // Return trivial diff (entire range changed)
-                intarray_free(V);
-                patharray_free(paths);
-                
-                SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
-                result->diffs = (SequenceDiff*)malloc(sizeof(SequenceDiff));
-                result->diffs[0].seq1_start = 0;
-                result->diffs[0].seq1_end = len_a;
-                result->diffs[0].seq2_start = 0;
-                result->diffs[0].seq2_end = len_b;
-                result->count = 1;
-                result->capacity = 1;
-                return result;
+        if (out_of_memory || !timeout_check_amortized(&timeout, &work_since_check, work)) {
+            if (hit_timeout && !out_of_memory) *hit_timeout = true;
+            stats_record_myers_d(d - 1);
+            
+            // Return trivial diff (entire range changed)
+            diff_scratch_free(V - diagonal_offset);
+            diff_scratch_free(paths - diagonal_offset);
+            diff_scratch_free(pool.nodes);
+            diff_scratch_free(owned_a);
+            diff_scratch_free(owned_b);
+            
+            if (pool.over_budget) {
+                // Snake paths outgrew the memory budget: redo the range in
+                // linear space with what is left of the timeout (not VSCode)
+                int remaining = timeout_ms > 0 ? max_int(1, timeout_remaining_ms(&timeout)) : 0;
+                return myers_linear_diff_algorithm(seq1, seq2, remaining, 0, hit_timeout);
             }
+            return trivial_diff_result(len_a, len_b);
         }
+        work = 0;
         
         // Bounds for diagonals we need to consider
         int lower_bound = -min_int(d, len_b + (d % 2));
@@ -527,8 +790,8 @@ SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequenc
         
         for (k = lower_bound; k <= upper_bound; k += 2) {
             // Determine whether to go down (insert) or right (delete)
-            int max_x_top = (k == upper_bound) ? -1 : intarray_get(V, k + 1);
-            int max_x_left = (k == lower_bound) ? -1 : intarray_get(V, k - 1) + 1;
+            int max_x_top = (k == upper_bound) ? -1 : V[k + 1];
+            int max_x_left = (k == lower_bound) ? -1 : V[k - 1] + 1;
             
             int x = min_int(max_int(max_x_top, max_x_left), len_a);
             int y = x - k;
@@ -539,55 +802,63 @@ SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequenc
             }
             
             // Follow snake (diagonal matches)
-            int new_max_x = myers_get_x_after_snake(seq1, seq2, x, y);
-            intarray_set(V, k, new_max_x);
+            int new_max_x = myers_get_x_after_snake(elements_a, len_a, elements_b, len_b, x, y);
+            V[k] = new_max_x;
+            work += 1 + (new_max_x - x);
             
             // Track path
-            SnakePath* last_path = (x == max_x_top) ? 
-                                   patharray_get(paths, k + 1) :
-                                   patharray_get(paths, k - 1);
-            SnakePath* new_path = (new_max_x != x) ?
-                                  snakepath_create(last_path, x, y, new_max_x - x) :
-                                  last_path;
-            patharray_set(paths, k, new_path);
+            int last_path = (x == max_x_top) ? paths[k + 1] : paths[k - 1];
+            if (new_max_x != x) {
+                int new_path = snakepool_push(&pool, last_path, x, y, new_max_x - x);
+                if (new_path == SNAKE_NONE) {
+                    out_of_memory = true;
+                    break;
+                }
+                paths[k] = new_path;
+            } else {
+                paths[k] = last_path;
+            }
             
             // Check if we reached the end
-            if (intarray_get(V, k) == len_a && intarray_get(V, k) - k == len_b) {
+            if (V[k] == len_a && V[k] - k == len_b) {
                 found = 1;
                 break;
             }
         }
     }
 
+    stats_record_myers_d(d);
+    
     // Build result from path
-    SnakePath* path = patharray_get(paths, k);
+    int path = paths[k];
+    const SnakeNode* nodes = pool.nodes;
     
     // Count diffs first
     int diff_count = 0;
     int last_pos_a = len_a;
     int last_pos_b = len_b;
-    SnakePath* temp_path = path;
+    int temp_path = path;
     
     while (1) {
-        int end_x = temp_path ? temp_path->x + temp_path->length : 0;
-        int end_y = temp_path ? temp_path->y + temp_path->length : 0;
+        int end_x = temp_path != SNAKE_NONE ? nodes[temp_path].x + nodes[temp_path].length : 0;
+        int end_y = temp_path != SNAKE_NONE ? nodes[temp_path].y + nodes[temp_path].length : 0;
         
         if (end_x != last_pos_a || end_y != last_pos_b) {
             diff_count++;
         }
-        if (!temp_path) break;
+        if (temp_path == SNAKE_NONE) break;
         
-        last_pos_a = temp_path->x;
-        last_pos_b = temp_path->y;
-        temp_path = temp_path->prev;
+        last_pos_a = nodes[temp_path].x;
+        last_pos_b = nodes[temp_path].y;
+        temp_path = nodes[temp_path].prev;
     }
     
     // Allocate result
-    SequenceDiffArray* result = (SequenceDiffArray*)malloc(sizeof(SequenceDiffArray));
+    SequenceDiffArray* result = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
     result->count = diff_count;
     result->capacity = diff_count;
     result->diffs = diff_count > 0 ? 
-                    (SequenceDiff*)malloc(diff_count * sizeof(SequenceDiff)) : NULL;
+                    (SequenceDiff*)diff_scratch_malloc(diff_count * sizeof(SequenceDiff)) : NULL;
     
     // Fill result (in reverse order, then we'll reverse)
     int idx = diff_count - 1;
@@ -595,8 +866,8 @@ SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequenc
     last_pos_b = len_b;
     
     while (1) {
-        int end_x = path ? path->x + path->length : 0;
-        int end_y = path ? path->y + path->length : 0;
+        int end_x = path != SNAKE_NONE ? nodes[path].x + nodes[path].length : 0;
+        int end_y = path != SNAKE_NONE ? nodes[path].y + nodes[path].length : 0;
         
         if (end_x != last_pos_a || end_y != last_pos_b) {
             result->diffs[idx].seq1_start = end_x;
@@ -606,23 +877,493 @@ SequenceDiffArray* myers_nd_diff_algorithm(const ISequence* seq1, const ISequenc
             idx--;
         }
         
-        if (!path) break;
+        if (path == SNAKE_NONE) break;
         
-        last_pos_a = path->x;
-        last_pos_b = path->y;
-        path = path->prev;
+        last_pos_a = nodes[path].x;
+        last_pos_b = nodes[path].y;
+        path = nodes[path].prev;
+    }
+    
+    // Clean up - the whole path graph goes at once
+    diff_scratch_free(V - diagonal_offset);
+    diff_scratch_free(paths - diagonal_offset);
+    diff_scratch_free(pool.nodes);
+    diff_scratch_free(owned_a);
+    diff_scratch_free(owned_b);
+    
+    return result;
+}
+
+//==============================================================================
+// O(ND) Linear-Space Myers (middle snake, divide and conquer)
+// Not VSCode: Myers 1986, section 4b
+//==============================================================================
+
+/**
+ * Halves with fewer elements than this (both sides combined) are not worth
+ * a thread of their own
+ */
+#define LINEAR_PARALLEL_MIN_SIZE 8192
+
+/** State shared by every branch of one myers_linear_diff_algorithm() call */
+typedef struct {
+    const uint32_t* a;
+    const uint32_t* b;
+    const Timeout* timeout;
+    diff_atomic_flag failed;        // Timeout or allocation failure in any branch
+    diff_atomic_flag timed_out;
+} LinearShared;
+
+/**
+ * One branch of the recursion: the calling thread's, or a half handed to a
+ * worker. Internals use the C heap, not scratch memory: workers have no
+ * arena installed, and their lists are merged after the join.
+ */
+typedef struct {
+    LinearShared* shared;
+    int* v_forward;                 // V arrays for the bisection, v_size ints each
+    int* v_backward;
+    int v_size;
+    SequenceDiffArray out;          // Diffs emitted so far, in order
+    int work_since_check;
+    int threads;                    // Threads this branch may use (itself included)
+} LinearBranch;
+
+static bool linear_branch_init(LinearBranch* branch, LinearShared* shared, int size, int threads) {
+    branch->shared = shared;
+    branch->v_size = size + 3;
+    branch->v_forward = (int*)diff_malloc(sizeof(int) * 2 * (size_t)branch->v_size);
+    branch->v_backward = branch->v_forward ? branch->v_forward + branch->v_size : NULL;
+    branch->out.diffs = NULL;
+    branch->out.count = 0;
+    branch->out.capacity = 0;
+    branch->work_since_check = TIMEOUT_CHECK_INTERVAL;
+    branch->threads = threads;
+    return branch->v_forward != NULL;
+}
+
+static void linear_fail(LinearShared* shared, bool timed_out) {
+    if (timed_out) diff_atomic_flag_set(&shared->timed_out);
+    diff_atomic_flag_set(&shared->failed);
+}
+
+/** Append a diff, joining it to the previous one when they touch */
+static void linear_emit(LinearBranch* branch, int a_start, int a_end, int b_start, int b_end) {
+    SequenceDiffArray* out = &branch->out;
+    if (out->count > 0) {
+        SequenceDiff* last = &out->diffs[out->count - 1];
+        if (last->seq1_end == a_start && last->seq2_end == b_start) {
+            last->seq1_end = a_end;
+            last->seq2_end = b_end;
+            return;
+        }
+    }
+    if (out->count == out->capacity) {
+        int new_capacity = out->capacity > 0 ? out->capacity * 2 : 16;
+        SequenceDiff* grown = (SequenceDiff*)diff_realloc(out->diffs, sizeof(SequenceDiff) * (size_t)new_capacity);
+        if (!grown) {
+            linear_fail(branch->shared, false);
+            return;
+        }
+        out->diffs = grown;
+        out->capacity = new_capacity;
+    }
+    SequenceDiff* diff = &out->diffs[out->count++];
+    diff->seq1_start = a_start;
+    diff->seq1_end = a_end;
+    diff->seq2_start = b_start;
+    diff->seq2_end = b_end;
+}
+
+/**
+ * Find the middle snake of a[a_lo, a_lo + n) x b[b_lo, b_lo + m), searching
+ * forward and backward at once; both inputs non-empty
+ * 
+ * @return true with the split point (relative to a_lo and b_lo) in out_x, out_y
+ */
+static bool linear_bisect(LinearBranch* branch, int a_lo, int n, int b_lo, int m,
+                          int* out_x, int* out_y) {
+    const uint32_t* a = branch->shared->a + a_lo;
+    const uint32_t* b = branch->shared->b + b_lo;
+    int max_d = (n + m + 1) / 2;
+    int v_offset = max_d;
+    int v_length = 2 * max_d + 2;
+    int* v1 = branch->v_forward;
+    int* v2 = branch->v_backward;
+    for (int i = 0; i < v_length; i++) {
+        v1[i] = -1;
+        v2[i] = -1;
+    }
+    v1[v_offset + 1] = 0;
+    v2[v_offset + 1] = 0;
+    
+    int delta = n - m;
+    // With an odd delta the forward search detects the overlap, else the backward one
+    bool front = (delta % 2 != 0);
+    int k1_start = 0, k1_end = 0, k2_start = 0, k2_end = 0;
+    int work = 0;
+    
+    for (int d = 0; d < max_d; d++) {
+        if (diff_atomic_flag_is_set(&branch->shared->failed)) return false;
+        if (!timeout_check_amortized(branch->shared->timeout, &branch->work_since_check, work)) {
+            linear_fail(branch->shared, true);
+            return false;
+        }
+        work = 0;
+        
+        // Forward path
+        for (int k1 = -d + k1_start; k1 <= d - k1_end; k1 += 2) {
+            int k1_offset = v_offset + k1;
+            int x1 = (k1 == -d || (k1 != d && v1[k1_offset - 1] < v1[k1_offset + 1]))
+                         ? v1[k1_offset + 1] : v1[k1_offset - 1] + 1;
+            int y1 = x1 - k1;
+            int snake_start = x1;
+            while (x1 < n && y1 < m && a[x1] == b[y1]) {
+                x1++;
+                y1++;
+            }
+            work += 1 + (x1 - snake_start);
+            v1[k1_offset] = x1;
+            if (x1 > n) {
+                k1_end += 2;            // Ran off the right edge
+            } else if (y1 > m) {
+                k1_start += 2;          // Ran off the bottom edge
+            } else if (front) {
+                int k2_offset = v_offset + delta - k1;
+                if (k2_offset >= 0 && k2_offset < v_length && v2[k2_offset] != -1) {
+                    if (x1 >= n - v2[k2_offset]) {
+                        *out_x = x1;
+                        *out_y = y1;
+                        return true;
+                    }
+                }
+            }
+        }
+        
+        // Backward path (x2/y2 count from the ends)
+        for (int k2 = -d + k2_start; k2 <= d - k2_end; k2 += 2) {
+            int k2_offset = v_offset + k2;
+            int x2 = (k2 == -d || (k2 != d && v2[k2_offset - 1] < v2[k2_offset + 1]))
+                         ? v2[k2_offset + 1] : v2[k2_offset - 1] + 1;
+            int y2 = x2 - k2;
+            int snake_start = x2;
+            while (x2 < n && y2 < m && a[n - x2 - 1] == b[m - y2 - 1]) {
+                x2++;
+                y2++;
+            }
+            work += 1 + (x2 - snake_start);
+            v2[k2_offset] = x2;
+            if (x2 > n) {
+                k2_end += 2;
+            } else if (y2 > m) {
+                k2_start += 2;
+            } else if (!front) {
+                int k1_offset = v_offset + delta - k2;
+                if (k1_offset >= 0 && k1_offset < v_length && v1[k1_offset] != -1) {
+                    int x1 = v1[k1_offset];
+                    if (x1 >= n - x2) {
+                        *out_x = x1;
+                        *out_y = v_offset + x1 - k1_offset;
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static void linear_diff(LinearBranch* branch, int a_lo, int a_hi, int b_lo, int b_hi);
+
+typedef struct {
+    LinearBranch branch;
+    int a_lo, a_hi, b_lo, b_hi;
+} LinearTask;
+
+static void* linear_task_worker(void* arg) {
+    LinearTask* task = (LinearTask*)arg;
+    linear_diff(&task->branch, task->a_lo, task->a_hi, task->b_lo, task->b_hi);
+    return NULL;
+}
+
+/** Append every diff of src to branch->out (joining at the seam) */
+static void linear_append(LinearBranch* branch, const SequenceDiffArray* src) {
+    for (int i = 0; i < src->count; i++) {
+        const SequenceDiff* diff = &src->diffs[i];
+        linear_emit(branch, diff->seq1_start, diff->seq1_end, diff->seq2_start, diff->seq2_end);
     }
+}
+
+/**
+ * Diff a[a_lo, a_hi) x b[b_lo, b_hi) into branch->out
+ * 
+ * Each level splits at the middle snake, which halves the edit distance, so
+ * the recursion is O(log D) deep and only the V arrays are live.
+ */
+static void linear_diff(LinearBranch* branch, int a_lo, int a_hi, int b_lo, int b_hi) {
+    const uint32_t* a = branch->shared->a;
+    const uint32_t* b = branch->shared->b;
     
-    // Clean up - free the entire path chain from final path
-    SnakePath* final_path = patharray_get(paths, k);
-    snakepath_free_chain(final_path);
+    // Common prefix/suffix are matches
+    while (a_lo < a_hi && b_lo < b_hi && a[a_lo] == b[b_lo]) {
+        a_lo++;
+        b_lo++;
+    }
+    while (a_lo < a_hi && b_lo < b_hi && a[a_hi - 1] == b[b_hi - 1]) {
+        a_hi--;
+        b_hi--;
+    }
+    if (a_lo == a_hi || b_lo == b_hi) {
+        if (a_lo < a_hi || b_lo < b_hi) {
+            linear_emit(branch, a_lo, a_hi, b_lo, b_hi);
+        }
+        return;
+    }
     
-    intarray_free(V);
-    patharray_free(paths);
+    int x, y;
+    if (!linear_bisect(branch, a_lo, a_hi - a_lo, b_lo, b_hi - b_lo, &x, &y)) {
+        // No split (failure, or nothing in common): the range is one diff
+        linear_emit(branch, a_lo, a_hi, b_lo, b_hi);
+        return;
+    }
+    x += a_lo;
+    y += b_lo;
+    if ((x == a_lo && y == b_lo) || (x == a_hi && y == b_hi)) {
+        linear_emit(branch, a_lo, a_hi, b_lo, b_hi);
+        return;
+    }
     
+    int left_size = (x - a_lo) + (y - b_lo);
+    int right_size = (a_hi - x) + (b_hi - y);
+    if (branch->threads > 1 && left_size >= LINEAR_PARALLEL_MIN_SIZE &&
+        right_size >= LINEAR_PARALLEL_MIN_SIZE) {
+        // Left half on a worker, right half here; lists are joined in order
+        LinearTask task = {.a_lo = a_lo, .a_hi = x, .b_lo = b_lo, .b_hi = y};
+        int worker_threads = branch->threads / 2;
+        diff_thread_t worker;
+        if (linear_branch_init(&task.branch, branch->shared, left_size, worker_threads) &&
+            diff_thread_create(&worker, linear_task_worker, &task)) {
+            SequenceDiffArray before = branch->out;
+            branch->out.diffs = NULL;
+            branch->out.count = 0;
+            branch->out.capacity = 0;
+            branch->threads -= worker_threads;
+            linear_diff(branch, x, a_hi, y, b_hi);
+            branch->threads += worker_threads;
+            SequenceDiffArray right = branch->out;
+            branch->out = before;
+            
+            diff_thread_join(&worker);
+            linear_append(branch, &task.branch.out);
+            linear_append(branch, &right);
+            diff_free(right.diffs);
+            diff_free(task.branch.out.diffs);
+            diff_free(task.branch.v_forward);
+            return;
+        }
+        diff_free(task.branch.v_forward);  // Could not start: continue sequentially
+    }
+    
+    linear_diff(branch, a_lo, x, b_lo, y);
+    linear_diff(branch, x, a_hi, y, b_hi);
+}
+
+/**
+ * Myers O(ND) Linear-Space Algorithm
+ * 
+ * Same edit distance and SequenceDiffArray shape as myers_nd_diff_algorithm
+ * (maximal diffs separated by matches), in O(N + M) memory instead of one
+ * snake per step. Equal-cost alternatives may be placed differently.
+ */
+SequenceDiffArray* myers_linear_diff_algorithm(const ISequence* seq1, const ISequence* seq2,
+                                               int timeout_ms, int threads, bool* hit_timeout) {
+    if (hit_timeout) *hit_timeout = false;
+    
+    int len_a = seq1->getLength(seq1);
+    int len_b = seq2->getLength(seq2);
+    if (len_a == 0 || len_b == 0) {
+        return trivial_diff_result(len_a, len_b);
+    }
+    
+    uint32_t* owned_a;
+    uint32_t* owned_b;
+    LinearShared shared;
+    shared.a = sequence_dense_elements(seq1, len_a, &owned_a);
+    shared.b = sequence_dense_elements(seq2, len_b, &owned_b);
+    Timeout timeout;
+    timeout_init(&timeout, timeout_ms);
+    shared.timeout = &timeout;
+    diff_atomic_flag_init(&shared.failed);
+    diff_atomic_flag_init(&shared.timed_out);
+    
+    // Per-branch V arrays, one branch per thread at most (not VSCode)
+    int branches = threads > 1 ? threads : 1;
+    bool fits = diff_memory_fits((int64_t)branches * (int64_t)(2 * sizeof(int)) *
+                                 ((int64_t)len_a + len_b + 3));
+    
+    LinearBranch root;
+    bool ok = fits && shared.a && shared.b &&
+              linear_branch_init(&root, &shared, len_a + len_b, threads > 1 ? threads : 1);
+    if (ok) {
+        linear_diff(&root, 0, len_a, 0, len_b);
+        ok = !diff_atomic_flag_is_set(&shared.failed);
+    }
+    
+    SequenceDiffArray* result = NULL;
+    if (ok) {
+        int d = 0;
+        for (int i = 0; i < root.out.count; i++) {
+            const SequenceDiff* diff = &root.out.diffs[i];
+            d += (diff->seq1_end - diff->seq1_start) + (diff->seq2_end - diff->seq2_start);
+        }
+        stats_record_myers_d(d);
+        
+        result = (SequenceDiffArray*)diff_scratch_malloc(sizeof(SequenceDiffArray));
+        result->count = root.out.count;
+        result->capacity = root.out.count;
+        result->diffs = root.out.count > 0
+            ? (SequenceDiff*)diff_scratch_malloc(sizeof(SequenceDiff) * (size_t)root.out.count)
+            : NULL;
+        if (root.out.count > 0) {
+            memcpy(result->diffs, root.out.diffs, sizeof(SequenceDiff) * (size_t)root.out.count);
+        }
+    } else {
+        // Timeout, out of memory or over the memory budget: entire range
+        // changed, like the forward algorithm
+        if (hit_timeout && diff_atomic_flag_is_set(&shared.timed_out)) *hit_timeout = true;
+        result = trivial_diff_result(len_a, len_b);
+    }
+    
+    if (fits && shared.a && shared.b) {
+        diff_free(root.out.diffs);
+        diff_free(root.v_forward);
+    }
+    diff_scratch_free(owned_a);
+    diff_scratch_free(owned_b);
     return result;
 }
 
+//==============================================================================
+// Engine Selection by Cost Model (not VSCode)
+//==============================================================================
+
+/**
+ * Relative costs, one unit being one unscored DP cell (about 2.7 ns on the
+ * machine they were measured on): a scored cell also pays for double
+ * arithmetic, an O(ND) diagonal step for its snake pool push, and snake
+ * following is about one compare per element.
+ */
+#define ENGINE_COST_DP_CELL         1.0
+#define ENGINE_COST_DP_SCORED_CELL  2.0
+#define ENGINE_COST_ND_DIAGONAL     4.0
+#define ENGINE_COST_ND_SNAKE        1.0
+
+/**
+ * Lower bound on the edit distance: every element occurrence that the other
+ * sequence cannot match is one insert or delete.
+ * 
+ * @return Bound, or -1 on allocation failure
+ */
+static int histogram_distance_bound(const uint32_t* elements1, int len1,
+                                    const uint32_t* elements2, int len2) {
+    int capacity = 16;
+    while (capacity < len1 * 2) capacity <<= 1;
+    uint32_t* keys = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * (size_t)capacity);
+    int* counts = (int*)diff_scratch_malloc(sizeof(int) * (size_t)capacity);
+    if (!keys || !counts) {
+        diff_scratch_free(keys);
+        diff_scratch_free(counts);
+        return -1;
+    }
+    
+    // Occurrences per element of seq1 (-1 = empty slot)
+    uint32_t mask = (uint32_t)(capacity - 1);
+    for (int i = 0; i < capacity; i++) counts[i] = -1;
+    for (int i = 0; i < len1; i++) {
+        uint32_t slot = dp_match_slot(elements1[i], capacity);
+        while (counts[slot] >= 0 && keys[slot] != elements1[i]) slot = (slot + 1) & mask;
+        if (counts[slot] < 0) {
+            keys[slot] = elements1[i];
+            counts[slot] = 0;
+        }
+        counts[slot]++;
+    }
+    
+    // Elements of seq2 that an unused occurrence in seq1 can match
+    int common = 0;
+    for (int i = 0; i < len2; i++) {
+        uint32_t slot = dp_match_slot(elements2[i], capacity);
+        while (counts[slot] >= 0 && keys[slot] != elements2[i]) slot = (slot + 1) & mask;
+        if (counts[slot] > 0) {
+            counts[slot]--;
+            common++;
+        }
+    }
+    
+    diff_scratch_free(keys);
+    diff_scratch_free(counts);
+    return len1 + len2 - 2 * common;
+}
+
+bool diff_engine_prefers_dp(const ISequence* seq1, const ISequence* seq2, bool scored,
+                            int max_dp_cells, DiffEngineEstimate* estimate) {
+    int len1 = seq1->getLength(seq1);
+    int len2 = seq2->getLength(seq2);
+    int64_t cells = (int64_t)len1 * (int64_t)len2;
+    int64_t cell_limit = max_dp_cells > 0 ? max_dp_cells : DIFF_ENGINE_DP_MAX_CELLS;
+    
+    DiffEngineEstimate e;
+    e.dp_cells = cells;
+    e.dp_bytes = (cells + 3) / 4 + (int64_t)len2 * 2 * (int64_t)((scored ? sizeof(double) : sizeof(int)) + sizeof(int));
+    e.min_distance = -1;
+    e.dp_cost = (double)cells * (scored ? ENGINE_COST_DP_SCORED_CELL : ENGINE_COST_DP_CELL);
+    e.nd_cost = 0;
+    e.nd_bytes = 0;
+    
+    // Only estimate D when the DP is allowed at all
+    if (cells <= cell_limit) {
+        uint32_t* owned1;
+        uint32_t* owned2;
+        const uint32_t* elements1 = sequence_dense_elements(seq1, len1, &owned1);
+        const uint32_t* elements2 = sequence_dense_elements(seq2, len2, &owned2);
+        if (elements1 && elements2) {
+            e.min_distance = histogram_distance_bound(elements1, len1, elements2, len2);
+        }
+        diff_scratch_free(owned1);
+        diff_scratch_free(owned2);
+    }
+    
+    bool use_dp = false;
+    if (e.min_distance >= 0) {
+        double d = (double)e.min_distance;
+        e.nd_cost = ENGINE_COST_ND_DIAGONAL * (d * d / 2 + d) +
+                    ENGINE_COST_ND_SNAKE * (double)(len1 + len2);
+        e.nd_bytes = (int64_t)((d * d / 2 + d + 1) * (double)sizeof(SnakeNode));
+        use_dp = e.dp_cost <= e.nd_cost;
+    }
+    
+    if (estimate) *estimate = e;
+    return use_dp;
+}
+
+const char* diff_engine_name(DiffEngine engine) {
+    switch (engine) {
+        case DIFF_ENGINE_DP: return "dp";
+        case DIFF_ENGINE_MYERS: return "myers";
+        case DIFF_ENGINE_LINEAR: return "linear";
+    }
+    return "unknown";
+}
+
+void diff_engine_count(DiffEngineCounts* counts, DiffEngine engine) {
+    if (!counts) return;
+    switch (engine) {
+        case DIFF_ENGINE_DP: counts->dp++; break;
+        case DIFF_ENGINE_MYERS: counts->myers++; break;
+        case DIFF_ENGINE_LINEAR: counts->linear++; break;
+    }
+}
+
 //==============================================================================
 //==============================================================================
 // Legacy API for backward compatibility
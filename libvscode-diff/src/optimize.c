@@ -17,6 +17,7 @@
 #include "string_hash_map.h"
 #include "types.h"
 #include "utils.h"
+#include "arena.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -24,7 +25,7 @@
 #include <stdint.h>
 
 // Forward declarations
-static uint32_t decode_utf8(const char** str_ptr);
+static uint32_t decode_utf8(const char** str_ptr, const char* end);
 static SequenceDiffArray* join_sequence_diffs_by_shifting(
     const ISequence* seq1, const ISequence* seq2, SequenceDiffArray* diffs);
 static SequenceDiffArray* shift_sequence_diffs(
@@ -49,14 +50,12 @@ static inline int max_int(int a, int b) { return a > b ? a : b; }
  * characters, matching JavaScript's string handling.
  * 
  * @param str_ptr Pointer to string pointer (will be advanced)
- * @return Unicode code point, or 0 if invalid/end of string
+ * @param end End of the line (lines carry their length and may hold NULs)
+ * @return Unicode code point (0xFFFD if invalid or truncated)
  */
-static uint32_t decode_utf8(const char** str_ptr) {
+static uint32_t decode_utf8(const char** str_ptr, const char* end) {
     const unsigned char* p = (const unsigned char*)*str_ptr;
-    
-    if (*p == 0) {
-        return 0;  // End of string
-    }
+    ptrdiff_t avail = end - *str_ptr;
     
     // ASCII (single byte)
     if (*p < 0x80) {
@@ -65,21 +64,21 @@ static uint32_t decode_utf8(const char** str_ptr) {
     }
     
     // 2-byte sequence (110xxxxx 10xxxxxx)
-    if ((*p & 0xE0) == 0xC0 && p[1]) {
+    if ((*p & 0xE0) == 0xC0 && avail >= 2) {
         uint32_t ch = ((*p & 0x1F) << 6) | (p[1] & 0x3F);
         *str_ptr = (const char*)(p + 2);
         return ch;
     }
     
     // 3-byte sequence (1110xxxx 10xxxxxx 10xxxxxx)
-    if ((*p & 0xF0) == 0xE0 && p[1] && p[2]) {
+    if ((*p & 0xF0) == 0xE0 && avail >= 3) {
         uint32_t ch = ((*p & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
         *str_ptr = (const char*)(p + 3);
         return ch;
     }
     
     // 4-byte sequence (11110xxx 10xxxxxx 10xxxxxx 10xxxxxx)
-    if ((*p & 0xF8) == 0xF0 && p[1] && p[2] && p[3]) {
+    if ((*p & 0xF8) == 0xF0 && avail >= 4) {
         uint32_t ch = ((*p & 0x07) << 18) | ((p[1] & 0x3F) << 12) | 
                       ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
         *str_ptr = (const char*)(p + 4);
@@ -106,6 +105,11 @@ static uint32_t decode_utf8(const char** str_ptr) {
  * 2. Move diffs right and join if they meet
  * 
  * Only works for insertion/deletion diffs (one range is empty)
+ * 
+ * Not VSCode: both passes compact diffs->diffs in place instead of building
+ * new arrays. The write index never passes the read index, and the element
+ * a pass still has to read (the current one, and in pass 2 the next one) is
+ * always at or beyond it.
  */
 static SequenceDiffArray* join_sequence_diffs_by_shifting(
     const ISequence* seq1, const ISequence* seq2, SequenceDiffArray* diffs) {
@@ -117,11 +121,9 @@ static SequenceDiffArray* join_sequence_diffs_by_shifting(
     int len1 = seq1->getLength(seq1);
     int len2 = seq2->getLength(seq2);
     
-    // Result array for first pass (move left)
-    SequenceDiff* result1 = (SequenceDiff*)malloc(diffs->count * sizeof(SequenceDiff));
-    int result1_count = 0;
-    
-    result1[result1_count++] = diffs->diffs[0];
+    // First pass (move left) writes its result over the input
+    SequenceDiff* result1 = diffs->diffs;
+    int result1_count = 1;
     
     // First pass: Move all diffs left and join if possible
     for (int i = 1; i < diffs->count; i++) {
@@ -179,8 +181,8 @@ static SequenceDiffArray* join_sequence_diffs_by_shifting(
         result1[result1_count++] = cur;
     }
     
-    // Second pass: Move all diffs right and join if possible
-    SequenceDiff* result2 = (SequenceDiff*)malloc(result1_count * sizeof(SequenceDiff));
+    // Second pass: Move all diffs right and join if possible (again in place)
+    SequenceDiff* result2 = diffs->diffs;
     int result2_count = 0;
     
     for (int i = 0; i < result1_count - 1; i++) {
@@ -235,13 +237,8 @@ static SequenceDiffArray* join_sequence_diffs_by_shifting(
         result2[result2_count++] = result1[result1_count - 1];
     }
     
-    // Update original array
-    free(diffs->diffs);
-    diffs->diffs = result2;
     diffs->count = result2_count;
     
-    free(result1);
-    
     return diffs;
 }
 
@@ -412,6 +409,8 @@ SequenceDiffArray* optimize_sequence_diffs(const ISequence* seq1, const ISequenc
  *      s.seq2Range.start - last.seq2Range.endExclusive <= 2)"
  * 
  * REUSED BY: Step 4 (character-level short match removal)
+ * 
+ * Not VSCode: joins in place in diffs->diffs.
  */
 SequenceDiffArray* remove_short_matches(const ISequence* seq1 __attribute__((unused)),
                                        const ISequence* seq2 __attribute__((unused)),
@@ -420,38 +419,71 @@ SequenceDiffArray* remove_short_matches(const ISequence* seq1 __attribute__((unu
         return diffs;
     }
     
-    SequenceDiff* result = (SequenceDiff*)malloc(diffs->count * sizeof(SequenceDiff));
-    int result_count = 0;
+    SequenceDiff* result = diffs->diffs;
+    int result_count = 1;
     
-    for (int i = 0; i < diffs->count; i++) {
-        if (result_count == 0) {
-            result[result_count++] = diffs->diffs[i];
+    for (int i = 1; i < diffs->count; i++) {
+        SequenceDiff* last = &result[result_count - 1];
+        SequenceDiff s = diffs->diffs[i];
+        
+        int gap1 = s.seq1_start - last->seq1_end;
+        int gap2 = s.seq2_start - last->seq2_end;
+        
+        // VSCode: join if gap ≤ 2 in EITHER sequence
+        if (gap1 <= 2 || gap2 <= 2) {
+            // Join with last
+            last->seq1_end = s.seq1_end;
+            last->seq2_end = s.seq2_end;
         } else {
-            SequenceDiff* last = &result[result_count - 1];
-            SequenceDiff s = diffs->diffs[i];
-            
-            int gap1 = s.seq1_start - last->seq1_end;
-            int gap2 = s.seq2_start - last->seq2_end;
-            
-            // VSCode: join if gap ≤ 2 in EITHER sequence
-            if (gap1 <= 2 || gap2 <= 2) {
-                // Join with last
-                last->seq1_end = s.seq1_end;
-                last->seq2_end = s.seq2_end;
-            } else {
-                result[result_count++] = s;
-            }
+            result[result_count++] = s;
         }
     }
     
-    // Update original array
-    free(diffs->diffs);
-    diffs->diffs = result;
     diffs->count = result_count;
     
     return diffs;
 }
 
+/** Longest unchanged gap (in non-whitespace characters) that still joins */
+#define MAX_JOIN_NON_WS 4
+
+/**
+ * Non-whitespace characters of lines [start, end), counted up to limit + 1
+ * 
+ * ascii is a compile-time constant at both call sites: the ASCII variant
+ * tests bytes against a bit mask, the general one decodes UTF-8 to catch
+ * Unicode whitespace. Counting stops once past limit, where the answer
+ * (too long to join) no longer changes.
+ */
+static DIFF_FORCE_INLINE int count_non_whitespace_kernel(const LineSequence* seq, int start, int end,
+                                                         int limit, bool ascii) {
+    int count = 0;
+    for (int idx = start; idx < end && count <= limit; idx++) {
+        const char* line = seq->lines[idx];
+        if (!line) continue;
+        
+        const char* p = line;
+        const char* line_end = line + seq->line_lengths[idx];
+        if (ascii) {
+            for (; p < line_end && count <= limit; p++) {
+                count += !diff_is_ascii_whitespace((unsigned char)*p);
+            }
+        } else {
+            while (p < line_end && count <= limit) {
+                // Decode UTF-8 and check each character (Unicode-aware)
+                count += !is_unicode_whitespace(decode_utf8(&p, line_end));
+            }
+        }
+    }
+    return count;
+}
+
+/** count_non_whitespace_kernel() specialized once per sequence */
+static int count_non_whitespace(const LineSequence* seq, int start, int end, int limit) {
+    return seq->ascii ? count_non_whitespace_kernel(seq, start, end, limit, true)
+                      : count_non_whitespace_kernel(seq, start, end, limit, false);
+}
+
 /**
  * removeVeryShortMatchingLinesBetweenDiffs() - VSCode Parity (LINE-LEVEL Step 3)
  * 
@@ -473,6 +505,8 @@ SequenceDiffArray* remove_short_matches(const ISequence* seq1 __attribute__((unu
  *     return true;
  * }
  * ```
+ * 
+ * Not VSCode: every round joins in place in diffs->diffs.
  */
 SequenceDiffArray* remove_very_short_matching_lines_between_diffs(
     const ISequence* seq1,
@@ -492,12 +526,9 @@ SequenceDiffArray* remove_very_short_matching_lines_between_diffs(
     do {
         should_repeat = false;
         
-        // Create result array
-        SequenceDiff* result = malloc(sizeof(SequenceDiff) * diffs->capacity);
-        int result_count = 0;
-        
-        // Start with first diff
-        result[result_count++] = diffs->diffs[0];
+        // Start with first diff, already in place
+        SequenceDiff* result = diffs->diffs;
+        int result_count = 1;
         
         for (int i = 1; i < diffs->count; i++) {
             SequenceDiff cur = diffs->diffs[i];
@@ -509,24 +540,8 @@ SequenceDiffArray* remove_very_short_matching_lines_between_diffs(
             
             // Count non-whitespace characters in unchanged region
             // VSCode: unchangedText.replace(/\s/g, '').length
-            // We must use UTF-8 decoding to properly handle Unicode whitespace
-            int non_ws_count = 0;
-            for (int idx = unchanged_start; idx < unchanged_end; idx++) {
-                const char* line = line_seq->lines[idx];
-                if (!line) continue;
-                
-                // Decode UTF-8 and check each character
-                const char* p = line;
-                while (*p) {
-                    uint32_t ch = decode_utf8(&p);
-                    if (ch == 0) break;  // End of string or invalid
-                    
-                    // Check if this character is whitespace using Unicode-aware function
-                    if (!is_unicode_whitespace(ch)) {
-                        non_ws_count++;
-                    }
-                }
-            }
+            int non_ws_count = count_non_whitespace(line_seq, unchanged_start, unchanged_end,
+                                                    MAX_JOIN_NON_WS);
             
             // Calculate diff sizes
             int before_total = (last_result->seq1_end - last_result->seq1_start) +
@@ -535,7 +550,7 @@ SequenceDiffArray* remove_very_short_matching_lines_between_diffs(
                              (cur.seq2_end - cur.seq2_start);
             
             // VSCode logic: join if gap ≤4 non-ws chars AND one diff is large (>5 lines)
-            bool should_join = (non_ws_count <= 4) && 
+            bool should_join = (non_ws_count <= MAX_JOIN_NON_WS) && 
                               (before_total > 5 || after_total > 5);
             
             if (should_join) {
@@ -548,9 +563,6 @@ SequenceDiffArray* remove_very_short_matching_lines_between_diffs(
             }
         }
         
-        // Replace diffs with result
-        free(diffs->diffs);
-        diffs->diffs = result;
         diffs->count = result_count;
         
     } while (counter++ < 10 && should_repeat);
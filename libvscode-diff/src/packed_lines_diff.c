@@ -0,0 +1,417 @@
+// ============================================================================
+// Packed LinesDiff
+// ============================================================================
+//
+// One malloc block: [PackedLinesDiff][bytes]. The encoder sizes the block
+// for the worst case (5 bytes per varint), writes, then shrinks it.
+//
+// Every decoder goes through PackedLinesDiffReader, so unpacking to a
+// FlatLinesDiff or LinesDiff and in-place reading accept exactly the same
+// bytes. Deltas are taken modulo 2^32, so any int survives a round trip,
+// including ranges the pipeline never produces.
+//
+// ============================================================================
+
+#include "packed_lines_diff.h"
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t PACKED_MAGIC[4] = {'V', 'D', 'P', '1'};
+
+/** Longest varint of a 32-bit value */
+#define VARINT32_MAX_BYTES 5
+
+/** Fewest varints per change (4 line deltas, inner count), inner change, move */
+#define CHANGE_MIN_VARINTS 5
+#define INNER_MIN_VARINTS 8
+#define MOVE_MIN_VARINTS 5
+
+/** Largest packed diff read_packed_lines_diff() accepts */
+#define PACKED_MAX_STREAM_BYTES ((uint64_t)1 << 31)
+
+// ============================================================================
+// Varints
+// ============================================================================
+
+static uint8_t* put_varint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+/** value - base, zigzag-encoded */
+static uint8_t* put_delta(uint8_t* out, int value, int base) {
+    uint32_t delta = (uint32_t)value - (uint32_t)base;
+    return put_varint(out, (delta << 1) ^ (0u - (delta >> 31)));
+}
+
+static bool get_varint(PackedLinesDiffReader* reader, uint32_t* out) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (reader->cursor >= reader->end) return false;
+        uint8_t byte = *reader->cursor++;
+        if (shift == 28 && byte > 0x0F) return false;  // More than 32 bits
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** int with the given two's complement bits (without implementation-defined casts) */
+static int int_from_bits(uint32_t bits) {
+    return bits <= INT32_MAX ? (int)bits : -(int)(~bits) - 1;
+}
+
+static bool get_delta(PackedLinesDiffReader* reader, int base, int* out) {
+    uint32_t zigzag;
+    if (!get_varint(reader, &zigzag)) return false;
+    uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    *out = int_from_bits((uint32_t)base + delta);
+    return true;
+}
+
+static bool get_count(PackedLinesDiffReader* reader, int* out) {
+    uint32_t value;
+    if (!get_varint(reader, &value) || value > INT32_MAX) return false;
+    *out = (int)value;
+    return true;
+}
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+/** ranges: original start/end, modified start/end (flat change / move layout) */
+static uint8_t* put_line_ranges(uint8_t* out, const int* ranges, int* original_line,
+                                int* modified_line) {
+    out = put_delta(out, ranges[0], *original_line);
+    out = put_delta(out, ranges[1], ranges[0]);
+    out = put_delta(out, ranges[2], *modified_line);
+    out = put_delta(out, ranges[3], ranges[2]);
+    *original_line = ranges[1];
+    *modified_line = ranges[3];
+    return out;
+}
+
+/** range: start_line, start_col, end_line, end_col after the position (line, col) */
+static uint8_t* put_char_range(uint8_t* out, const int* range, int* line, int* col) {
+    out = put_delta(out, range[0], *line);
+    out = put_delta(out, range[1], range[0] == *line ? *col : 1);
+    out = put_delta(out, range[2], range[0]);
+    out = put_delta(out, range[3], range[2] == range[0] ? range[1] : 1);
+    *line = range[2];
+    *col = range[3];
+    return out;
+}
+
+PackedLinesDiff* pack_flat_lines_diff(const FlatLinesDiff* flat) {
+    if (!flat) return NULL;
+
+    size_t varints = 5 + (size_t)flat->total_change_count * CHANGE_MIN_VARINTS +
+                     (size_t)flat->inner_change_count * INNER_MIN_VARINTS +
+                     (size_t)flat->move_count * MOVE_MIN_VARINTS;
+    size_t capacity = sizeof(PACKED_MAGIC) + varints * VARINT32_MAX_BYTES;
+    PackedLinesDiff* packed = (PackedLinesDiff*)diff_malloc(sizeof(PackedLinesDiff) + capacity);
+    if (!packed) return NULL;
+
+    uint8_t* start = (uint8_t*)(packed + 1);
+    uint8_t* out = start;
+    memcpy(out, PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    out += sizeof(PACKED_MAGIC);
+    out = put_varint(out, (flat->hit_timeout ? 1u : 0u) | (flat->hit_memory_limit ? 2u : 0u));
+    out = put_varint(out, (uint32_t)flat->change_count);
+    out = put_varint(out, (uint32_t)flat->total_change_count);
+    out = put_varint(out, (uint32_t)flat->inner_change_count);
+    out = put_varint(out, (uint32_t)flat->move_count);
+
+    int original_line = 1;
+    int modified_line = 1;
+    for (int i = 0; i < flat->total_change_count; i++) {
+        const int* change = &flat->changes[(size_t)i * FLAT_CHANGE_STRIDE];
+        out = put_line_ranges(out, change, &original_line, &modified_line);
+
+        int first = flat->inner_offsets[i];
+        int count = flat->inner_offsets[i + 1] - first;
+        out = put_varint(out, (uint32_t)count);
+        int line[2] = {change[0], change[2]};
+        int col[2] = {1, 1};
+        for (int k = 0; k < count; k++) {
+            const int* inner = &flat->inner_changes[(size_t)(first + k) * FLAT_INNER_STRIDE];
+            out = put_char_range(out, inner, &line[0], &col[0]);
+            out = put_char_range(out, inner + 4, &line[1], &col[1]);
+        }
+    }
+
+    // Moves start their own chain; their changes were written in order above
+    original_line = 1;
+    modified_line = 1;
+    for (int m = 0; m < flat->move_count; m++) {
+        const int* move = &flat->moves[(size_t)m * FLAT_MOVE_STRIDE];
+        out = put_line_ranges(out, move, &original_line, &modified_line);
+        out = put_varint(out, (uint32_t)move[5]);
+    }
+
+    packed->size = (size_t)(out - start);
+    PackedLinesDiff* shrunk = (PackedLinesDiff*)diff_realloc(packed, sizeof(PackedLinesDiff) + packed->size);
+    if (shrunk) packed = shrunk;
+    packed->data = (const uint8_t*)(packed + 1);
+    return packed;
+}
+
+PackedLinesDiff* pack_lines_diff(const LinesDiff* diff) {
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    if (!flat) return NULL;
+    PackedLinesDiff* packed = pack_flat_lines_diff(flat);
+    free_flat_lines_diff(flat);
+    return packed;
+}
+
+void free_packed_lines_diff(PackedLinesDiff* packed) {
+    diff_free(packed);
+}
+
+// ============================================================================
+// In-Place Reading
+// ============================================================================
+
+bool packed_reader_init(PackedLinesDiffReader* reader, const uint8_t* data, size_t size) {
+    memset(reader, 0, sizeof(*reader));
+    if (!data || size < sizeof(PACKED_MAGIC) ||
+        memcmp(data, PACKED_MAGIC, sizeof(PACKED_MAGIC)) != 0) {
+        return false;
+    }
+    reader->cursor = data + sizeof(PACKED_MAGIC);
+    reader->end = data + size;
+
+    uint32_t flags;
+    if (!get_varint(reader, &flags) || flags > 3 ||
+        !get_count(reader, &reader->change_count) ||
+        !get_count(reader, &reader->total_change_count) ||
+        !get_count(reader, &reader->inner_change_count) ||
+        !get_count(reader, &reader->move_count) ||
+        reader->total_change_count < reader->change_count ||
+        reader->total_change_count == INT32_MAX) {
+        return false;
+    }
+    // Counts the remaining bytes cannot hold are malformed, and would make
+    // decoders allocate for them
+    uint64_t min_bytes = (uint64_t)reader->total_change_count * CHANGE_MIN_VARINTS +
+                         (uint64_t)reader->inner_change_count * INNER_MIN_VARINTS +
+                         (uint64_t)reader->move_count * MOVE_MIN_VARINTS;
+    if (min_bytes > (uint64_t)(reader->end - reader->cursor)) return false;
+
+    reader->hit_timeout = (flags & 1) != 0;
+    reader->hit_memory_limit = (flags & 2) != 0;
+    reader->original_line = 1;
+    reader->modified_line = 1;
+    return true;
+}
+
+static bool get_line_ranges(PackedLinesDiffReader* reader, LineRange* original, LineRange* modified) {
+    if (!get_delta(reader, reader->original_line, &original->start_line) ||
+        !get_delta(reader, original->start_line, &original->end_line) ||
+        !get_delta(reader, reader->modified_line, &modified->start_line) ||
+        !get_delta(reader, modified->start_line, &modified->end_line)) {
+        return false;
+    }
+    reader->original_line = original->end_line;
+    reader->modified_line = modified->end_line;
+    return true;
+}
+
+static bool get_char_range(PackedLinesDiffReader* reader, CharRange* range, int side) {
+    int* line = &reader->inner_line[side];
+    int* col = &reader->inner_col[side];
+    if (!get_delta(reader, *line, &range->start_line) ||
+        !get_delta(reader, range->start_line == *line ? *col : 1, &range->start_col) ||
+        !get_delta(reader, range->start_line, &range->end_line) ||
+        !get_delta(reader, range->end_line == range->start_line ? range->start_col : 1,
+                   &range->end_col)) {
+        return false;
+    }
+    *line = range->end_line;
+    *col = range->end_col;
+    return true;
+}
+
+bool packed_reader_next_inner_change(PackedLinesDiffReader* reader, RangeMapping* out) {
+    if (reader->failed || reader->inner_left <= 0) return false;
+    if (!get_char_range(reader, &out->original, 0) || !get_char_range(reader, &out->modified, 1)) {
+        reader->failed = true;
+        return false;
+    }
+    reader->inner_left--;
+    return true;
+}
+
+/** Skip the unread inner changes of the current change */
+static bool skip_inner_changes(PackedLinesDiffReader* reader) {
+    RangeMapping skipped;
+    while (reader->inner_left > 0) {
+        if (!packed_reader_next_inner_change(reader, &skipped)) return false;
+    }
+    return !reader->failed;
+}
+
+bool packed_reader_next_change(PackedLinesDiffReader* reader, LineRange* out_original,
+                               LineRange* out_modified, int* out_inner_count) {
+    if (!skip_inner_changes(reader) || reader->changes_read >= reader->total_change_count) {
+        return false;
+    }
+    int count;
+    if (!get_line_ranges(reader, out_original, out_modified) || !get_count(reader, &count)) {
+        reader->failed = true;
+        return false;
+    }
+    reader->changes_read++;
+    reader->inner_left = count;
+    reader->inner_line[0] = out_original->start_line;
+    reader->inner_line[1] = out_modified->start_line;
+    reader->inner_col[0] = 1;
+    reader->inner_col[1] = 1;
+    *out_inner_count = count;
+    return true;
+}
+
+bool packed_reader_next_move(PackedLinesDiffReader* reader, MovedText* out) {
+    LineRange original, modified;
+    int inner_count;
+    while (reader->changes_read < reader->total_change_count) {
+        if (!packed_reader_next_change(reader, &original, &modified, &inner_count)) return false;
+    }
+    if (!skip_inner_changes(reader) || reader->moves_read >= reader->move_count) {
+        return false;
+    }
+    if (reader->moves_read == 0) {
+        reader->original_line = 1;
+        reader->modified_line = 1;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!get_line_ranges(reader, &out->original, &out->modified) ||
+        !get_count(reader, &out->change_count)) {
+        reader->failed = true;
+        return false;
+    }
+    reader->moves_read++;
+    return true;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+FlatLinesDiff* unpack_flat_lines_diff(const uint8_t* data, size_t size) {
+    PackedLinesDiffReader reader;
+    if (!packed_reader_init(&reader, data, size)) return NULL;
+
+    FlatLinesDiff* flat = flat_lines_diff_alloc(reader.change_count, reader.total_change_count,
+                                                reader.inner_change_count, reader.move_count,
+                                                reader.hit_timeout, reader.hit_memory_limit);
+    if (!flat) return NULL;
+    int* changes = (int*)flat->changes;
+    int* inner_offsets = (int*)flat->inner_offsets;
+    int* inner_changes = (int*)flat->inner_changes;
+    int* moves = (int*)flat->moves;
+
+    bool ok = true;
+    int inner_index = 0;
+    for (int i = 0; ok && i < reader.total_change_count; i++) {
+        LineRange original, modified;
+        int count;
+        ok = packed_reader_next_change(&reader, &original, &modified, &count) &&
+             count <= reader.inner_change_count - inner_index;
+        if (!ok) break;
+        int* c = &changes[(size_t)i * FLAT_CHANGE_STRIDE];
+        c[0] = original.start_line;
+        c[1] = original.end_line;
+        c[2] = modified.start_line;
+        c[3] = modified.end_line;
+        inner_offsets[i] = inner_index;
+        for (int k = 0; ok && k < count; k++) {
+            RangeMapping mapping;
+            ok = packed_reader_next_inner_change(&reader, &mapping);
+            if (!ok) break;
+            int* inner = &inner_changes[(size_t)inner_index++ * FLAT_INNER_STRIDE];
+            inner[0] = mapping.original.start_line;
+            inner[1] = mapping.original.start_col;
+            inner[2] = mapping.original.end_line;
+            inner[3] = mapping.original.end_col;
+            inner[4] = mapping.modified.start_line;
+            inner[5] = mapping.modified.start_col;
+            inner[6] = mapping.modified.end_line;
+            inner[7] = mapping.modified.end_col;
+        }
+    }
+    ok = ok && inner_index == reader.inner_change_count;
+    if (ok) inner_offsets[reader.total_change_count] = inner_index;
+
+    int next_change = reader.change_count;
+    for (int m = 0; ok && m < reader.move_count; m++) {
+        MovedText move;
+        ok = packed_reader_next_move(&reader, &move) &&
+             move.change_count <= reader.total_change_count - next_change;
+        if (!ok) break;
+        int* fm = &moves[(size_t)m * FLAT_MOVE_STRIDE];
+        fm[0] = move.original.start_line;
+        fm[1] = move.original.end_line;
+        fm[2] = move.modified.start_line;
+        fm[3] = move.modified.end_line;
+        fm[4] = next_change;
+        fm[5] = move.change_count;
+        next_change += move.change_count;
+    }
+
+    if (!ok || next_change != reader.total_change_count || reader.cursor != reader.end) {
+        free_flat_lines_diff(flat);
+        return NULL;
+    }
+    return flat;
+}
+
+LinesDiff* unpack_lines_diff(const uint8_t* data, size_t size) {
+    FlatLinesDiff* flat = unpack_flat_lines_diff(data, size);
+    if (!flat) return NULL;
+    LinesDiff* diff = expand_flat_lines_diff(flat);
+    free_flat_lines_diff(flat);
+    return diff;
+}
+
+// ============================================================================
+// Stream I/O
+// ============================================================================
+
+bool write_packed_lines_diff(const PackedLinesDiff* packed, FILE* out) {
+    uint8_t prefix[10];
+    size_t prefix_len = (size_t)(put_varint(prefix, (uint64_t)packed->size) - prefix);
+    return fwrite(prefix, 1, prefix_len, out) == prefix_len &&
+           fwrite(packed->data, 1, packed->size, out) == packed->size;
+}
+
+PackedLinesDiff* read_packed_lines_diff(FILE* in) {
+    uint64_t size = 0;
+    for (int shift = 0;; shift += 7) {
+        int byte = fgetc(in);
+        if (byte == EOF || shift > 56) return NULL;
+        size |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    if (size > PACKED_MAX_STREAM_BYTES) return NULL;
+
+    PackedLinesDiff* packed = (PackedLinesDiff*)diff_malloc(sizeof(PackedLinesDiff) + (size_t)size);
+    if (!packed) return NULL;
+    packed->size = (size_t)size;
+    packed->data = (const uint8_t*)(packed + 1);
+    if (fread(packed + 1, 1, packed->size, in) != packed->size) {
+        diff_free(packed);
+        return NULL;
+    }
+    return packed;
+}
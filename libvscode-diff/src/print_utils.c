@@ -128,6 +128,10 @@ void diff_core_print_render_plan(const RenderPlan* plan) {
                    j, ch->line_num, ch->start_col, ch->end_col, ch_type_str);
         }
     }
+    for (int i = 0; i < plan->left.filler_count; i++) {
+        printf("  Filler: %d line(s) after line %d\n",
+               plan->left.fillers[i].count, plan->left.fillers[i].after_line);
+    }
     
     // Right side
     printf("\nRight side: %d lines\n", plan->right.line_count);
@@ -158,6 +162,10 @@ void diff_core_print_render_plan(const RenderPlan* plan) {
                    j, ch->line_num, ch->start_col, ch->end_col, ch_type_str);
         }
     }
+    for (int i = 0; i < plan->right.filler_count; i++) {
+        printf("  Filler: %d line(s) after line %d\n",
+               plan->right.fillers[i].count, plan->right.fillers[i].after_line);
+    }
     
     printf("\n");
 }
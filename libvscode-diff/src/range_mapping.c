@@ -9,6 +9,8 @@
  */
 
 #include "range_mapping.h"
+#include "diff_allocator.h"
+#include "utils.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -61,16 +63,16 @@ bool line_range_intersects_or_touches(LineRange a, LineRange b) {
  * Line numbers are 1-based as in VSCode.
  * 
  * @param lines Array of line strings
+ * @param lengths Byte length of each line (NULL = NUL-terminated lines)
  * @param line_count Total number of lines
  * @param line_number Line number (1-based)
  * @return Length of the line, or 0 if out of bounds
  */
-static int get_line_length(const char** lines, int line_count, int line_number) {
+static int get_line_length(const char** lines, const int* lengths, int line_count, int line_number) {
     if (line_number < 1 || line_number > line_count) {
         return 0;
     }
-    int index = line_number - 1;
-    return (int)strlen(lines[index]);
+    return diff_line_length(lines, lengths, line_number - 1);
 }
 
 // ============================================================================
@@ -101,6 +103,19 @@ DetailedLineRangeMapping get_line_range_mapping(
     int original_line_count,
     const char** modified_lines,
     int modified_line_count
+) {
+    return get_line_range_mapping_n(range_mapping, original_lines, NULL, original_line_count,
+                                    modified_lines, NULL, modified_line_count);
+}
+
+DetailedLineRangeMapping get_line_range_mapping_n(
+    const RangeMapping* range_mapping,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_line_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_line_count
 ) {
     DetailedLineRangeMapping result;
     
@@ -119,10 +134,10 @@ DetailedLineRangeMapping get_line_range_mapping(
     
     // If both ranges start past line end, start from next line
     if (range_mapping->modified.start_col - 1 
-        >= get_line_length(modified_lines, modified_line_count, 
+        >= get_line_length(modified_lines, modified_lengths, modified_line_count,
                           range_mapping->modified.start_line)
         && range_mapping->original.start_col - 1 
-           >= get_line_length(original_lines, original_line_count,
+           >= get_line_length(original_lines, original_lengths, original_line_count,
                              range_mapping->original.start_line)
         && range_mapping->original.start_line 
            <= range_mapping->original.end_line + line_end_delta
@@ -139,7 +154,7 @@ DetailedLineRangeMapping get_line_range_mapping(
     result.modified.end_line = range_mapping->modified.end_line + 1 + line_end_delta;
     
     // Preserve inner character change
-    result.inner_changes = (RangeMapping*)malloc(sizeof(RangeMapping));
+    result.inner_changes = (RangeMapping*)diff_malloc(sizeof(RangeMapping));
     if (result.inner_changes) {
         result.inner_changes[0] = *range_mapping;
         result.inner_change_count = 1;
@@ -208,15 +223,15 @@ static GroupArray* group_adjacent_detailed_mappings(
     DetailedLineRangeMapping* items,
     int count
 ) {
-    GroupArray* result = (GroupArray*)malloc(sizeof(GroupArray));
+    GroupArray* result = (GroupArray*)diff_malloc(sizeof(GroupArray));
     if (!result) return NULL;
     
-    result->groups = (Group*)malloc(sizeof(Group) * 8);
+    result->groups = (Group*)diff_malloc(sizeof(Group) * 8);
     result->count = 0;
     result->capacity = 8;
     
     if (!result->groups) {
-        free(result);
+        diff_free(result);
         return NULL;
     }
     
@@ -233,21 +248,21 @@ static GroupArray* group_adjacent_detailed_mappings(
             // Start new group
             if (result->count >= result->capacity) {
                 result->capacity *= 2;
-                Group* new_groups = (Group*)realloc(result->groups, 
+                Group* new_groups = (Group*)diff_realloc(result->groups, 
                                                     sizeof(Group) * result->capacity);
                 if (!new_groups) {
                     for (int j = 0; j < result->count; j++) {
-                        free(result->groups[j].items);
+                        diff_free(result->groups[j].items);
                     }
-                    free(result->groups);
-                    free(result);
+                    diff_free(result->groups);
+                    diff_free(result);
                     return NULL;
                 }
                 result->groups = new_groups;
             }
             
             current_group = &result->groups[result->count++];
-            current_group->items = (DetailedLineRangeMapping*)malloc(
+            current_group->items = (DetailedLineRangeMapping*)diff_malloc(
                 sizeof(DetailedLineRangeMapping) * (count - i)
             );
             if (!current_group->items) {
@@ -293,12 +308,28 @@ DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings(
     const char** modified_lines,
     int modified_line_count,
     bool dont_assert_start_line
+) {
+    return line_range_mapping_from_range_mappings_n(alignments,
+                                                    original_lines, NULL, original_line_count,
+                                                    modified_lines, NULL, modified_line_count,
+                                                    dont_assert_start_line);
+}
+
+DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings_n(
+    const RangeMappingArray* alignments,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_line_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_line_count,
+    bool dont_assert_start_line
 ) {
     (void)dont_assert_start_line;  // TODO: Add assertions
     
     if (!alignments || alignments->count == 0) {
         DetailedLineRangeMappingArray* result = 
-            (DetailedLineRangeMappingArray*)malloc(sizeof(DetailedLineRangeMappingArray));
+            (DetailedLineRangeMappingArray*)diff_malloc(sizeof(DetailedLineRangeMappingArray));
         if (result) {
             result->mappings = NULL;
             result->count = 0;
@@ -308,53 +339,53 @@ DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings(
     }
     
     // Step 1: Convert each RangeMapping to DetailedLineRangeMapping
-    DetailedLineRangeMapping* mapped = (DetailedLineRangeMapping*)malloc(
+    DetailedLineRangeMapping* mapped = (DetailedLineRangeMapping*)diff_malloc(
         sizeof(DetailedLineRangeMapping) * alignments->count
     );
     if (!mapped) return NULL;
     
     for (int i = 0; i < alignments->count; i++) {
-        mapped[i] = get_line_range_mapping(
+        mapped[i] = get_line_range_mapping_n(
             &alignments->mappings[i],
-            original_lines, original_line_count,
-            modified_lines, modified_line_count
+            original_lines, original_lengths, original_line_count,
+            modified_lines, modified_lengths, modified_line_count
         );
     }
     
     // Step 2: Group adjacent mappings
     GroupArray* groups = group_adjacent_detailed_mappings(mapped, alignments->count);
     if (!groups) {
-        free(mapped);
+        diff_free(mapped);
         return NULL;
     }
     
     // Step 3: Create result array
     DetailedLineRangeMappingArray* result = 
-        (DetailedLineRangeMappingArray*)malloc(sizeof(DetailedLineRangeMappingArray));
+        (DetailedLineRangeMappingArray*)diff_malloc(sizeof(DetailedLineRangeMappingArray));
     if (!result) {
         for (int i = 0; i < groups->count; i++) {
-            free(groups->groups[i].items);
+            diff_free(groups->groups[i].items);
         }
-        free(groups->groups);
-        free(groups);
-        free(mapped);
+        diff_free(groups->groups);
+        diff_free(groups);
+        diff_free(mapped);
         return NULL;
     }
     
-    result->mappings = (DetailedLineRangeMapping*)malloc(
+    result->mappings = (DetailedLineRangeMapping*)diff_malloc(
         sizeof(DetailedLineRangeMapping) * groups->count
     );
     result->count = 0;
     result->capacity = groups->count;
     
     if (!result->mappings) {
-        free(result);
+        diff_free(result);
         for (int i = 0; i < groups->count; i++) {
-            free(groups->groups[i].items);
+            diff_free(groups->groups[i].items);
         }
-        free(groups->groups);
-        free(groups);
-        free(mapped);
+        diff_free(groups->groups);
+        diff_free(groups);
+        diff_free(mapped);
         return NULL;
     }
     
@@ -372,7 +403,7 @@ DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings(
         change.modified = line_range_join(first->modified, last->modified);
         
         // Collect all inner changes from group
-        change.inner_changes = (RangeMapping*)malloc(sizeof(RangeMapping) * g->count);
+        change.inner_changes = (RangeMapping*)diff_malloc(sizeof(RangeMapping) * g->count);
         if (!change.inner_changes) {
             change.inner_change_count = 0;
         } else {
@@ -392,14 +423,14 @@ DetailedLineRangeMappingArray* line_range_mapping_from_range_mappings(
         Group* g = &groups->groups[i];
         for (int j = 0; j < g->count; j++) {
             if (g->items[j].inner_changes) {
-                free(g->items[j].inner_changes);
+                diff_free(g->items[j].inner_changes);
             }
         }
-        free(g->items);
+        diff_free(g->items);
     }
-    free(groups->groups);
-    free(groups);
-    free(mapped);
+    diff_free(groups->groups);
+    diff_free(groups);
+    diff_free(mapped);
     
     return result;
 }
@@ -415,10 +446,10 @@ void free_detailed_line_range_mapping_array(DetailedLineRangeMappingArray* arr)
     if (arr->mappings) {
         for (int i = 0; i < arr->count; i++) {
             if (arr->mappings[i].inner_changes) {
-                free(arr->mappings[i].inner_changes);
+                diff_free(arr->mappings[i].inner_changes);
             }
         }
-        free(arr->mappings);
+        diff_free(arr->mappings);
     }
-    free(arr);
+    diff_free(arr);
 }
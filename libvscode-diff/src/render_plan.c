@@ -12,6 +12,9 @@
 // ============================================================================
 
 #include "render_plan.h"
+#include "diff_allocator.h"
+#include "utils.h"
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -61,7 +64,7 @@ static void add_char_highlight(
     
     if (builder->count >= builder->capacity) {
         size_t new_capacity = builder->capacity == 0 ? 4 : builder->capacity * 2;
-        CharHighlight* new_highlights = (CharHighlight*)realloc(
+        CharHighlight* new_highlights = (CharHighlight*)diff_realloc(
             builder->highlights,
             new_capacity * sizeof(CharHighlight)
         );
@@ -77,11 +80,210 @@ static void add_char_highlight(
     hl->type = type;
 }
 
+/**
+ * Add highlights for one side of an inner change, split per line.
+ *
+ * Mirrors what the renderer can draw: ranges starting past the line content
+ * (line-ending-only changes) are skipped and the end column is clamped to the
+ * line length. Multi-line ranges cover the rest of the first line, all middle
+ * lines and the head of the last line.
+ */
+static void add_char_range_highlights(
+    CharHighlightBuilder* builder,
+    const CharRange* range,
+    const char** lines,
+    const int* lengths,
+    int line_count,
+    HighlightType type
+) {
+    // Skip empty ranges
+    if (range->start_line == range->end_line && range->start_col == range->end_col) {
+        return;
+    }
+    
+    // Skip line-ending-only changes (start column past visible content)
+    if (range->start_line < 1 || range->start_line > line_count ||
+        range->start_col > diff_line_length(lines, lengths, range->start_line - 1)) {
+        return;
+    }
+    
+    // Clamp end column to line content length
+    int end_col = range->end_col;
+    if (range->end_line >= 1 && range->end_line <= line_count) {
+        int end_len = diff_line_length(lines, lengths, range->end_line - 1);
+        if (end_col > end_len + 1) end_col = end_len + 1;
+    }
+    
+    if (range->start_line == range->end_line) {
+        add_char_highlight(builder, range->start_line, range->start_col, end_col, type);
+        return;
+    }
+    
+    // First line: from start_col to end of line
+    int first_len = diff_line_length(lines, lengths, range->start_line - 1);
+    add_char_highlight(builder, range->start_line, range->start_col, first_len + 1, type);
+    
+    // Middle lines: full line highlights (if any)
+    for (int line = range->start_line + 1; line < range->end_line && line <= line_count; line++) {
+        int line_len = diff_line_length(lines, lengths, line - 1);
+        add_char_highlight(builder, line, 1, line_len + 1, type);
+    }
+    
+    // Last line: from start to end_col
+    add_char_highlight(builder, range->end_line, 1, end_col, type);
+}
+
+// ============================================================================
+// Filler Lines
+// ============================================================================
+
+typedef struct {
+    FillerLine* fillers;
+    int count;
+    int capacity;
+} FillerBuilder;
+
+/**
+ * Add fillers after a line, merging with the previous entry at the same line.
+ *
+ * @return false on allocation failure
+ */
+static bool add_filler(FillerBuilder* builder, int after_line, int count) {
+    if (count <= 0) return true;
+    
+    if (builder->count > 0 && builder->fillers[builder->count - 1].after_line == after_line) {
+        builder->fillers[builder->count - 1].count += count;
+        return true;
+    }
+    
+    if (builder->count >= builder->capacity) {
+        int new_capacity = builder->capacity == 0 ? 8 : builder->capacity * 2;
+        FillerLine* grown = (FillerLine*)diff_realloc(builder->fillers, new_capacity * sizeof(FillerLine));
+        if (!grown) return false;
+        builder->fillers = grown;
+        builder->capacity = new_capacity;
+    }
+    
+    builder->fillers[builder->count].after_line = after_line;
+    builder->fillers[builder->count].count = count;
+    builder->count++;
+    return true;
+}
+
+/**
+ * Alignment state carried across the mappings of a diff.
+ */
+typedef struct {
+    int last_orig_line;     // 1-indexed, exclusive end of the last alignment
+    int last_mod_line;
+    bool first;             // VSCode's 'first' flag (per mapping)
+    FillerBuilder* left;
+    FillerBuilder* right;
+    bool ok;
+} AlignmentState;
+
+/**
+ * Emit the fillers for one alignment range: the shorter side gets the
+ * difference, placed after its last line in the range.
+ */
+static void add_alignment_fillers(AlignmentState* state, int orig_end, int mod_end,
+                                  int orig_len, int mod_len) {
+    int line_diff = mod_len - orig_len;
+    if (line_diff > 0) {
+        state->ok &= add_filler(state->left, orig_end - 1, line_diff);
+    } else if (line_diff < 0) {
+        state->ok &= add_filler(state->right, mod_end - 1, -line_diff);
+    }
+}
+
+/**
+ * VSCode Reference: diffEditorViewZones.ts computeRangeAlignment() emitAlignment()
+ */
+static void emit_alignment(AlignmentState* state, int orig_line_exclusive, int mod_line_exclusive) {
+    // Skip if going backwards
+    if (orig_line_exclusive < state->last_orig_line || mod_line_exclusive < state->last_mod_line) {
+        return;
+    }
+    
+    // Skip redundant alignments, but allow the first one
+    if (state->first) {
+        state->first = false;
+    } else if (orig_line_exclusive == state->last_orig_line ||
+               mod_line_exclusive == state->last_mod_line) {
+        return;
+    }
+    
+    int orig_len = orig_line_exclusive - state->last_orig_line;
+    int mod_len = mod_line_exclusive - state->last_mod_line;
+    if (orig_len > 0 || mod_len > 0) {
+        add_alignment_fillers(state, orig_line_exclusive, mod_line_exclusive, orig_len, mod_len);
+    }
+    
+    state->last_orig_line = orig_line_exclusive;
+    state->last_mod_line = mod_line_exclusive;
+}
+
+/**
+ * Add the fillers of one mapping, as described in docs/filler-line-algorithm.md.
+ *
+ * VSCode Reference: diffEditorViewZones.ts computeRangeAlignment()
+ */
+static void add_mapping_fillers(AlignmentState* state, const DetailedLineRangeMapping* mapping,
+                                const char** original_lines, const int* original_lengths,
+                                int original_count) {
+    if (!mapping->inner_changes || mapping->inner_change_count == 0) {
+        // No inner changes: simple line count difference at the mapping start
+        int orig_lines = mapping->original.end_line - mapping->original.start_line;
+        int mod_lines = mapping->modified.end_line - mapping->modified.start_line;
+        if (orig_lines > mod_lines) {
+            state->ok &= add_filler(state->right, mapping->modified.start_line - 1, orig_lines - mod_lines);
+        } else if (mod_lines > orig_lines) {
+            state->ok &= add_filler(state->left, mapping->original.start_line - 1, mod_lines - orig_lines);
+        }
+        state->last_orig_line = mapping->original.end_line;
+        state->last_mod_line = mapping->modified.end_line;
+        return;
+    }
+    
+    state->first = true;
+    
+    // Gap since the previous mapping (VSCode's handleAlignmentsOutsideOfDiffs)
+    int orig_gap = mapping->original.start_line - state->last_orig_line;
+    int mod_gap = mapping->modified.start_line - state->last_mod_line;
+    if (orig_gap > 0 || mod_gap > 0) {
+        add_alignment_fillers(state, mapping->original.start_line, mapping->modified.start_line,
+                              orig_gap, mod_gap);
+        state->last_orig_line = mapping->original.start_line;
+        state->last_mod_line = mapping->modified.start_line;
+    }
+    
+    for (int i = 0; i < mapping->inner_change_count; i++) {
+        const RangeMapping* inner = &mapping->inner_changes[i];
+        
+        // Unmodified text BEFORE the change on this line
+        if (inner->original.start_col > 1 && inner->modified.start_col > 1) {
+            emit_alignment(state, inner->original.start_line, inner->modified.start_line);
+        }
+        
+        // Unmodified text AFTER the change on this line
+        int end_idx = inner->original.end_line - 1;
+        int orig_line_len = end_idx >= 0 && end_idx < original_count
+                                ? diff_line_length(original_lines, original_lengths, end_idx)
+                                : 0;
+        if (inner->original.end_col <= orig_line_len) {
+            emit_alignment(state, inner->original.end_line, inner->modified.end_line);
+        }
+    }
+    
+    // Final alignment at the end of the mapping
+    emit_alignment(state, mapping->original.end_line, mapping->modified.end_line);
+}
+
 /**
  * Create line metadata array for one side.
  */
 static LineMetadata* create_line_metadata_array(int line_count) {
-    LineMetadata* metadata = (LineMetadata*)calloc(line_count, sizeof(LineMetadata));
+    LineMetadata* metadata = (LineMetadata*)diff_calloc(line_count, sizeof(LineMetadata));
     if (!metadata) return NULL;
     
     // Initialize all lines as unchanged (no highlight)
@@ -96,6 +298,66 @@ static LineMetadata* create_line_metadata_array(int line_count) {
     return metadata;
 }
 
+// ============================================================================
+// Hunk Index
+// ============================================================================
+
+static bool line_has_highlights(const LineMetadata* meta) {
+    return meta->type != HL_NONE || meta->char_highlight_count > 0;
+}
+
+/**
+ * Collect runs of highlighted lines into side->hunks.
+ * 
+ * @return false on allocation failure
+ */
+static bool build_hunk_index(SideRenderPlan* side) {
+    int count = 0;
+    for (int i = 0; i < side->line_count; i++) {
+        if (line_has_highlights(&side->line_metadata[i]) &&
+            (i == 0 || !line_has_highlights(&side->line_metadata[i - 1]))) {
+            count++;
+        }
+    }
+    
+    side->hunk_count = 0;
+    side->hunks = NULL;
+    if (count == 0) return true;
+    
+    side->hunks = (LineRange*)diff_malloc(count * sizeof(LineRange));
+    if (!side->hunks) return false;
+    
+    for (int i = 0; i < side->line_count; i++) {
+        if (!line_has_highlights(&side->line_metadata[i])) continue;
+        if (i == 0 || !line_has_highlights(&side->line_metadata[i - 1])) {
+            side->hunks[side->hunk_count].start_line = i + 1;
+            side->hunk_count++;
+        }
+        side->hunks[side->hunk_count - 1].end_line = i + 2;
+    }
+    return true;
+}
+
+/**
+ * Index of the first of the sorted hunks ending after a line.
+ */
+static int find_hunk(const LineRange* hunks, int hunk_count, int line) {
+    int lo = 0, hi = hunk_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (hunks[mid].end_line > line) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+int render_plan_find_hunk(const SideRenderPlan* side, int line) {
+    return find_hunk(side->hunks, side->hunk_count, line);
+}
+
 // ============================================================================
 // Main Function: generate_render_plan
 // ============================================================================
@@ -108,7 +370,8 @@ static LineMetadata* create_line_metadata_array(int line_count) {
  * 2. For each DetailedLineRangeMapping:
  *    a. Mark affected lines with line-level highlights
  *    b. Add character-level highlights from inner_changes
- * 3. Fill in filler lines where needed for alignment
+ * 3. Compute filler lines for alignment (per side, sorted by line)
+ * 4. Index the runs of highlighted lines (hunks) per side
  * 
  * @param diff LinesDiff from compute_diff()
  * @param original_lines Original file lines
@@ -123,10 +386,23 @@ RenderPlan* generate_render_plan(
     int original_count,
     const char** modified_lines,
     int modified_count
+) {
+    return generate_render_plan_n(diff, original_lines, NULL, original_count,
+                                  modified_lines, NULL, modified_count);
+}
+
+RenderPlan* generate_render_plan_n(
+    const LinesDiff* diff,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count
 ) {
     if (!diff) return NULL;
     
-    RenderPlan* plan = (RenderPlan*)malloc(sizeof(RenderPlan));
+    RenderPlan* plan = (RenderPlan*)diff_malloc(sizeof(RenderPlan));
     if (!plan) return NULL;
     
     // Allocate metadata for both sides
@@ -136,15 +412,30 @@ RenderPlan* generate_render_plan(
     plan->right.line_count = modified_count;
     plan->right.line_metadata = create_line_metadata_array(modified_count);
     
+    plan->left.filler_count = 0;
+    plan->left.fillers = NULL;
+    plan->right.filler_count = 0;
+    plan->right.fillers = NULL;
+    plan->left.hunk_count = 0;
+    plan->left.hunks = NULL;
+    plan->right.hunk_count = 0;
+    plan->right.hunks = NULL;
+    
     if (!plan->left.line_metadata || !plan->right.line_metadata) {
         free_render_plan(plan);
         return NULL;
     }
     
+    FillerBuilder left_fillers = {NULL, 0, 0};
+    FillerBuilder right_fillers = {NULL, 0, 0};
+    AlignmentState alignment = {1, 1, true, &left_fillers, &right_fillers, true};
+    
     // Process each change mapping
     for (int i = 0; i < diff->changes.count; i++) {
         const DetailedLineRangeMapping* mapping = &diff->changes.mappings[i];
         
+        add_mapping_fillers(&alignment, mapping, original_lines, original_lengths, original_count);
+        
         // Get line ranges (1-indexed, end exclusive)
         int orig_start = mapping->original.start_line;
         int orig_end = mapping->original.end_line;
@@ -175,110 +466,12 @@ RenderPlan* generate_render_plan(
             
             for (int j = 0; j < mapping->inner_change_count; j++) {
                 const RangeMapping* range = &mapping->inner_changes[j];
-                
-                // Original side: split multi-line ranges
-                if (range->original.start_line == range->original.end_line) {
-                    // Single line range
-                    add_char_highlight(
-                        &orig_builder,
-                        range->original.start_line,
-                        range->original.start_col,
-                        range->original.end_col,
-                        HL_CHAR_DELETE
-                    );
-                } else {
-                    // Multi-line range: split into per-line highlights
-                    // First line: from start_col to end of line
-                    int first_line_idx = range->original.start_line - 1;
-                    if (first_line_idx >= 0 && first_line_idx < original_count) {
-                        int line_len = strlen(original_lines[first_line_idx]);
-                        add_char_highlight(
-                            &orig_builder,
-                            range->original.start_line,
-                            range->original.start_col,
-                            line_len + 1,  // +1 for 1-based exclusive end
-                            HL_CHAR_DELETE
-                        );
-                    }
-                    
-                    // Middle lines: full line highlights (if any)
-                    for (int line = range->original.start_line + 1; line < range->original.end_line; line++) {
-                        int line_idx = line - 1;
-                        if (line_idx >= 0 && line_idx < original_count) {
-                            int line_len = strlen(original_lines[line_idx]);
-                            add_char_highlight(
-                                &orig_builder,
-                                line,
-                                1,
-                                line_len + 1,
-                                HL_CHAR_DELETE
-                            );
-                        }
-                    }
-                    
-                    // Last line: from start to end_col
-                    if (range->original.end_col > 1) {
-                        add_char_highlight(
-                            &orig_builder,
-                            range->original.end_line,
-                            1,
-                            range->original.end_col,
-                            HL_CHAR_DELETE
-                        );
-                    }
-                }
-                
-                // Modified side: split multi-line ranges
-                if (range->modified.start_line == range->modified.end_line) {
-                    // Single line range
-                    add_char_highlight(
-                        &mod_builder,
-                        range->modified.start_line,
-                        range->modified.start_col,
-                        range->modified.end_col,
-                        HL_CHAR_INSERT
-                    );
-                } else {
-                    // Multi-line range: split into per-line highlights
-                    // First line: from start_col to end of line
-                    int first_line_idx = range->modified.start_line - 1;
-                    if (first_line_idx >= 0 && first_line_idx < modified_count) {
-                        int line_len = strlen(modified_lines[first_line_idx]);
-                        add_char_highlight(
-                            &mod_builder,
-                            range->modified.start_line,
-                            range->modified.start_col,
-                            line_len + 1,
-                            HL_CHAR_INSERT
-                        );
-                    }
-                    
-                    // Middle lines: full line highlights (if any)
-                    for (int line = range->modified.start_line + 1; line < range->modified.end_line; line++) {
-                        int line_idx = line - 1;
-                        if (line_idx >= 0 && line_idx < modified_count) {
-                            int line_len = strlen(modified_lines[line_idx]);
-                            add_char_highlight(
-                                &mod_builder,
-                                line,
-                                1,
-                                line_len + 1,
-                                HL_CHAR_INSERT
-                            );
-                        }
-                    }
-                    
-                    // Last line: from start to end_col
-                    if (range->modified.end_col > 1) {
-                        add_char_highlight(
-                            &mod_builder,
-                            range->modified.end_line,
-                            1,
-                            range->modified.end_col,
-                            HL_CHAR_INSERT
-                        );
-                    }
-                }
+                add_char_range_highlights(&orig_builder, &range->original,
+                                          original_lines, original_lengths, original_count,
+                                          HL_CHAR_DELETE);
+                add_char_range_highlights(&mod_builder, &range->modified,
+                                          modified_lines, modified_lengths, modified_count,
+                                          HL_CHAR_INSERT);
             }
             
             // Attach character highlights to affected lines
@@ -292,9 +485,9 @@ RenderPlan* generate_render_plan(
                     
                     // Grow array if needed
                     if (meta->char_highlight_count == 0) {
-                        meta->char_highlights = (CharHighlight*)malloc(sizeof(CharHighlight));
+                        meta->char_highlights = (CharHighlight*)diff_malloc(sizeof(CharHighlight));
                     } else {
-                        CharHighlight* new_arr = (CharHighlight*)realloc(
+                        CharHighlight* new_arr = (CharHighlight*)diff_realloc(
                             meta->char_highlights,
                             (meta->char_highlight_count + 1) * sizeof(CharHighlight)
                         );
@@ -319,9 +512,9 @@ RenderPlan* generate_render_plan(
                     
                     // Grow array if needed
                     if (meta->char_highlight_count == 0) {
-                        meta->char_highlights = (CharHighlight*)malloc(sizeof(CharHighlight));
+                        meta->char_highlights = (CharHighlight*)diff_malloc(sizeof(CharHighlight));
                     } else {
-                        CharHighlight* new_arr = (CharHighlight*)realloc(
+                        CharHighlight* new_arr = (CharHighlight*)diff_realloc(
                             meta->char_highlights,
                             (meta->char_highlight_count + 1) * sizeof(CharHighlight)
                         );
@@ -336,11 +529,21 @@ RenderPlan* generate_render_plan(
                 }
             }
             
-            free(orig_builder.highlights);
-            free(mod_builder.highlights);
+            diff_free(orig_builder.highlights);
+            diff_free(mod_builder.highlights);
         }
     }
     
+    plan->left.fillers = left_fillers.fillers;
+    plan->left.filler_count = left_fillers.count;
+    plan->right.fillers = right_fillers.fillers;
+    plan->right.filler_count = right_fillers.count;
+    
+    if (!alignment.ok || !build_hunk_index(&plan->left) || !build_hunk_index(&plan->right)) {
+        free_render_plan(plan);
+        return NULL;
+    }
+    
     return plan;
 }
 
@@ -354,21 +557,265 @@ void free_render_plan(RenderPlan* plan) {
     if (plan->left.line_metadata) {
         for (int i = 0; i < plan->left.line_count; i++) {
             if (plan->left.line_metadata[i].char_highlights) {
-                free(plan->left.line_metadata[i].char_highlights);
+                diff_free(plan->left.line_metadata[i].char_highlights);
             }
         }
-        free(plan->left.line_metadata);
+        diff_free(plan->left.line_metadata);
     }
+    diff_free(plan->left.fillers);
+    diff_free(plan->left.hunks);
     
     // Free right side
     if (plan->right.line_metadata) {
         for (int i = 0; i < plan->right.line_count; i++) {
             if (plan->right.line_metadata[i].char_highlights) {
-                free(plan->right.line_metadata[i].char_highlights);
+                diff_free(plan->right.line_metadata[i].char_highlights);
             }
         }
-        free(plan->right.line_metadata);
+        diff_free(plan->right.line_metadata);
     }
+    diff_free(plan->right.fillers);
+    diff_free(plan->right.hunks);
     
-    free(plan);
+    diff_free(plan);
+}
+
+// ============================================================================
+// Sparse Render Plan
+// ============================================================================
+//
+// Same content as the dense plan, built without per-line arrays: the char
+// highlights of all mappings of a side go into one pool (sorted by line),
+// then one merge of the mapping line ranges with the pool lines emits the
+// records in line order. Nothing is sized by the line count.
+//
+// ============================================================================
+
+typedef struct {
+    CharHighlight highlight;
+    int order;              // Position before sorting, keeps the sort stable
+} OrderedHighlight;
+
+static int compare_ordered_highlights(const void* a, const void* b) {
+    const OrderedHighlight* ha = (const OrderedHighlight*)a;
+    const OrderedHighlight* hb = (const OrderedHighlight*)b;
+    if (ha->highlight.line_num != hb->highlight.line_num) {
+        return ha->highlight.line_num < hb->highlight.line_num ? -1 : 1;
+    }
+    return ha->order - hb->order;
+}
+
+/**
+ * Drop highlights outside [1, line_count] (as the dense plan does) and
+ * stable-sort the rest by line. Highlights already come in line order
+ * unless inner changes of a mapping overlap, so sorting is rarely needed.
+ *
+ * @return false on allocation failure
+ */
+static bool finish_highlight_pool(CharHighlightBuilder* pool, int line_count) {
+    int kept = 0;
+    bool sorted = true;
+    for (int i = 0; i < pool->count; i++) {
+        int line = pool->highlights[i].line_num;
+        if (line < 1 || line > line_count) continue;
+        if (kept > 0 && line < pool->highlights[kept - 1].line_num) sorted = false;
+        pool->highlights[kept++] = pool->highlights[i];
+    }
+    pool->count = kept;
+    if (sorted) return true;
+
+    OrderedHighlight* ordered = (OrderedHighlight*)diff_malloc(kept * sizeof(OrderedHighlight));
+    if (!ordered) return false;
+    for (int i = 0; i < kept; i++) {
+        ordered[i].highlight = pool->highlights[i];
+        ordered[i].order = i;
+    }
+    qsort(ordered, kept, sizeof(OrderedHighlight), compare_ordered_highlights);
+    for (int i = 0; i < kept; i++) {
+        pool->highlights[i] = ordered[i].highlight;
+    }
+    diff_free(ordered);
+    return true;
+}
+
+/**
+ * Append the record of a line with the pool highlights starting at next.
+ *
+ * @return Index of the first pool highlight past this line
+ */
+static int add_sparse_record(SparseSideRenderPlan* side, int line_num, HighlightType type, int next) {
+    SparseLineRecord* record = &side->records[side->record_count++];
+    record->line_num = line_num;
+    record->type = type;
+    record->char_highlight_start = next;
+    while (next < side->char_highlight_count && side->char_highlights[next].line_num == line_num) {
+        next++;
+    }
+    record->char_highlight_count = next - record->char_highlight_start;
+    return next;
+}
+
+/**
+ * Collect the records and hunks of one side from the mapping line ranges
+ * and the side's (finished) highlight pool.
+ *
+ * @return false on allocation failure
+ */
+static bool build_sparse_side(SparseSideRenderPlan* side, const LinesDiff* diff, bool modified_side) {
+    HighlightType type = modified_side ? HL_LINE_INSERT : HL_LINE_DELETE;
+
+    // Mapping ranges do not overlap, so this bounds the record count
+    int capacity = side->char_highlight_count;
+    for (int i = 0; i < diff->changes.count; i++) {
+        const DetailedLineRangeMapping* mapping = &diff->changes.mappings[i];
+        const LineRange* range = modified_side ? &mapping->modified : &mapping->original;
+        int start = range->start_line < 1 ? 1 : range->start_line;
+        int end = range->end_line > side->line_count + 1 ? side->line_count + 1 : range->end_line;
+        if (end > start) capacity += end - start;
+    }
+    if (capacity == 0) return true;
+
+    side->records = (SparseLineRecord*)diff_malloc(capacity * sizeof(SparseLineRecord));
+    if (!side->records) return false;
+
+    int next = 0;
+    for (int i = 0; i < diff->changes.count; i++) {
+        const DetailedLineRangeMapping* mapping = &diff->changes.mappings[i];
+        const LineRange* range = modified_side ? &mapping->modified : &mapping->original;
+        int start = range->start_line < 1 ? 1 : range->start_line;
+        int end = range->end_line > side->line_count + 1 ? side->line_count + 1 : range->end_line;
+        for (int line = start; line < end; line++) {
+            // Char-only lines before this one
+            while (next < side->char_highlight_count && side->char_highlights[next].line_num < line) {
+                next = add_sparse_record(side, side->char_highlights[next].line_num, HL_NONE, next);
+            }
+            next = add_sparse_record(side, line, type, next);
+        }
+    }
+    while (next < side->char_highlight_count) {
+        next = add_sparse_record(side, side->char_highlights[next].line_num, HL_NONE, next);
+    }
+
+    int hunk_count = 0;
+    for (int i = 0; i < side->record_count; i++) {
+        if (i == 0 || side->records[i].line_num != side->records[i - 1].line_num + 1) hunk_count++;
+    }
+    side->hunks = (LineRange*)diff_malloc(hunk_count * sizeof(LineRange));
+    if (!side->hunks) return false;
+    for (int i = 0; i < side->record_count; i++) {
+        int line = side->records[i].line_num;
+        if (i == 0 || line != side->records[i - 1].line_num + 1) {
+            side->hunks[side->hunk_count++].start_line = line;
+        }
+        side->hunks[side->hunk_count - 1].end_line = line + 1;
+    }
+    return true;
+}
+
+SparseRenderPlan* generate_sparse_render_plan(
+    const LinesDiff* diff,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count
+) {
+    return generate_sparse_render_plan_n(diff, original_lines, NULL, original_count,
+                                         modified_lines, NULL, modified_count);
+}
+
+SparseRenderPlan* generate_sparse_render_plan_n(
+    const LinesDiff* diff,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count
+) {
+    if (!diff) return NULL;
+
+    SparseRenderPlan* plan = (SparseRenderPlan*)diff_calloc(1, sizeof(SparseRenderPlan));
+    if (!plan) return NULL;
+    plan->left.line_count = original_count;
+    plan->right.line_count = modified_count;
+
+    FillerBuilder left_fillers = {NULL, 0, 0};
+    FillerBuilder right_fillers = {NULL, 0, 0};
+    AlignmentState alignment = {1, 1, true, &left_fillers, &right_fillers, true};
+    CharHighlightBuilder orig_pool, mod_pool;
+    init_char_highlight_builder(&orig_pool);
+    init_char_highlight_builder(&mod_pool);
+
+    for (int i = 0; i < diff->changes.count; i++) {
+        const DetailedLineRangeMapping* mapping = &diff->changes.mappings[i];
+
+        add_mapping_fillers(&alignment, mapping, original_lines, original_lengths, original_count);
+
+        for (int j = 0; mapping->inner_changes && j < mapping->inner_change_count; j++) {
+            const RangeMapping* range = &mapping->inner_changes[j];
+            add_char_range_highlights(&orig_pool, &range->original,
+                                      original_lines, original_lengths, original_count,
+                                      HL_CHAR_DELETE);
+            add_char_range_highlights(&mod_pool, &range->modified,
+                                      modified_lines, modified_lengths, modified_count,
+                                      HL_CHAR_INSERT);
+        }
+    }
+
+    plan->left.fillers = left_fillers.fillers;
+    plan->left.filler_count = left_fillers.count;
+    plan->right.fillers = right_fillers.fillers;
+    plan->right.filler_count = right_fillers.count;
+
+    bool ok = alignment.ok &&
+              finish_highlight_pool(&orig_pool, original_count) &&
+              finish_highlight_pool(&mod_pool, modified_count);
+    plan->left.char_highlights = orig_pool.highlights;
+    plan->left.char_highlight_count = orig_pool.count;
+    plan->right.char_highlights = mod_pool.highlights;
+    plan->right.char_highlight_count = mod_pool.count;
+
+    if (!ok || !build_sparse_side(&plan->left, diff, false) ||
+        !build_sparse_side(&plan->right, diff, true)) {
+        free_sparse_render_plan(plan);
+        return NULL;
+    }
+
+    return plan;
+}
+
+const SparseLineRecord* sparse_render_plan_find_line(const SparseSideRenderPlan* side, int line) {
+    int lo = 0, hi = side->record_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (side->records[mid].line_num < line) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < side->record_count && side->records[lo].line_num == line ? &side->records[lo] : NULL;
+}
+
+int sparse_render_plan_find_hunk(const SparseSideRenderPlan* side, int line) {
+    return find_hunk(side->hunks, side->hunk_count, line);
+}
+
+/**
+ * Free sparse render plan.
+ */
+void free_sparse_render_plan(SparseRenderPlan* plan) {
+    if (!plan) return;
+
+    diff_free(plan->left.records);
+    diff_free(plan->left.char_highlights);
+    diff_free(plan->left.fillers);
+    diff_free(plan->left.hunks);
+
+    diff_free(plan->right.records);
+    diff_free(plan->right.char_highlights);
+    diff_free(plan->right.fillers);
+    diff_free(plan->right.hunks);
+
+    diff_free(plan);
 }
@@ -14,8 +14,9 @@
 
 #include "sequence.h"
 #include "string_hash_map.h"
-#include "platform.h"
 #include "utf8_utils.h"
+#include "utils.h"
+#include "arena.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -41,13 +42,9 @@ static int get_utf16_substring_length(const char* str_start, const char* str_end
         return 0;
     }
     
-    // Temporarily null-terminate at str_end to measure substring
-    char saved_char = *str_end;
-    ((char*)str_end)[0] = '\0';
-    int utf16_length = utf8_to_utf16_length(str_start);
-    ((char*)str_end)[0] = saved_char;
-    
-    return utf16_length;
+    // Count within the byte span; the caller's line buffer is never modified
+    // (lines may live in read-only memory, e.g. string literals or Lua strings)
+    return utf8_to_utf16_length_n(str_start, (int)(str_end - str_start));
 }
 
 /**
@@ -56,16 +53,32 @@ static int get_utf16_substring_length(const char* str_start, const char* str_end
  * JavaScript Note: JS strings are stored as UTF-16 code units internally
  * C Note: We convert UTF-8 to UTF-16 code units for algorithm compatibility
  * 
+ * ASCII runs are widened in bulk; only the non-ASCII characters between
+ * them go through the decoder.
+ * 
  * Returns: number of UTF-16 code units written
  */
-static int write_utf8_as_utf16_units(const char* src, int num_utf16_units, 
+static int write_utf8_as_utf16_units(const char* src, int byte_len, int num_utf16_units,
                                       uint32_t* elements, int offset) {
     int byte_pos = 0;
     int utf16_units_written = 0;
     
-    while (utf16_units_written < num_utf16_units && src[byte_pos] != '\0') {
-        uint32_t codepoint = utf8_decode_char(src, &byte_pos);
-        if (codepoint == 0) break;
+    while (utf16_units_written < num_utf16_units && byte_pos < byte_len) {
+        int ascii = utf8_ascii_run_length(src + byte_pos, byte_len - byte_pos);
+        if (ascii > 0) {
+            if (ascii > num_utf16_units - utf16_units_written) {
+                ascii = num_utf16_units - utf16_units_written;
+            }
+            utf8_widen_ascii(src + byte_pos, ascii, elements + offset);
+            byte_pos += ascii;
+            offset += ascii;
+            utf16_units_written += ascii;
+            continue;
+        }
+        
+        // Bounded decode: the line may be unterminated or hold NUL bytes
+        uint32_t codepoint;
+        if (!utf8_decode_char_n(src, byte_len, &byte_pos, &codepoint)) break;
         
         if (codepoint < 0x10000) {
             // BMP character: 1 UTF-16 code unit (matches JS behavior)
@@ -100,28 +113,34 @@ static int write_utf8_as_utf16_units(const char* src, int num_utf16_units,
 // ============================================================================
 
 /**
- * Create a trimmed copy of string (caller must free)
+ * Find the trimmed span of a string without copying
+ * 
+ * JavaScript Note: str.trim() creates a new string
+ * C Note: We return a (pointer, length) view into the original line instead
+ * 
+ * Returns: start of the trimmed span of str[0, len); *out_len receives its
+ * length in bytes
  */
-static char* trim_string(const char* str) {
-    if (!str) return diff_strdup("");
+static const char* trim_span(const char* str, int len, size_t* out_len) {
+    if (!str) {
+        *out_len = 0;
+        return "";
+    }
+    
+    const char* end = str + len;
     
     // Skip leading whitespace
-    while (*str && isspace((unsigned char)*str)) {
+    while (str < end && isspace((unsigned char)*str)) {
         str++;
     }
     
     // Find end (non-whitespace)
-    const char* end = str + strlen(str);
     while (end > str && isspace((unsigned char)*(end - 1))) {
         end--;
     }
     
-    // Copy trimmed portion
-    int len = end - str;
-    char* result = (char*)malloc(len + 1);
-    memcpy(result, str, len);
-    result[len] = '\0';
-    return result;
+    *out_len = (size_t)(end - str);
+    return str;
 }
 
 // ============================================================================
@@ -144,6 +163,11 @@ static int line_seq_get_length(const ISequence* self) {
     return seq->length;
 }
 
+static const uint32_t* line_seq_get_elements(const ISequence* self) {
+    LineSequence* seq = (LineSequence*)self->data;
+    return seq->trimmed_hash;
+}
+
 static bool line_seq_is_strongly_equal(const ISequence* self, int offset1, int offset2) {
     LineSequence* seq = (LineSequence*)self->data;
     if (offset1 < 0 || offset1 >= seq->length || 
@@ -151,7 +175,8 @@ static bool line_seq_is_strongly_equal(const ISequence* self, int offset1, int o
         return false;
     }
     // Strong equality checks original lines (including whitespace)
-    return strcmp(seq->lines[offset1], seq->lines[offset2]) == 0;
+    return diff_lines_equal(seq->lines[offset1], seq->line_lengths[offset1],
+                            seq->lines[offset2], seq->line_lengths[offset2]);
 }
 
 /**
@@ -162,11 +187,10 @@ static bool line_seq_is_strongly_equal(const ISequence* self, int offset1, int o
  * VSCode Reference: lineSequence.ts getIndentation()
  * VSCode Parity: 100%
  */
-static int get_indentation(const char* line) {
+static int get_indentation(const char* line, int len) {
     int count = 0;
-    while (*line && (*line == ' ' || *line == '\t')) {
+    while (count < len && (line[count] == ' ' || line[count] == '\t')) {
         count++;
-        line++;
     }
     return count;
 }
@@ -185,6 +209,12 @@ static int get_indentation(const char* line) {
  * 
  * REUSED BY: Step 2 (shiftSequenceDiffs)
  */
+static int line_indentation(const LineSequence* seq, int index) {
+    int indent = seq->indentation[index];
+    return indent == LINE_INDENTATION_OVERFLOW ? get_indentation(seq->lines[index], seq->line_lengths[index])
+                                               : indent;
+}
+
 static int line_seq_get_boundary_score(const ISequence* self, int length) {
     LineSequence* seq = (LineSequence*)self->data;
     
@@ -192,16 +222,16 @@ static int line_seq_get_boundary_score(const ISequence* self, int length) {
         return 0;
     }
     
-    // Indentation before boundary (line at length-1)
+    // Indentation before boundary (line at length-1), precomputed at creation
     int indent_before = 0;
     if (length > 0) {
-        indent_before = get_indentation(seq->lines[length - 1]);
+        indent_before = line_indentation(seq, length - 1);
     }
     
     // Indentation after boundary (line at length)
     int indent_after = 0;
     if (length < seq->length) {
-        indent_after = get_indentation(seq->lines[length]);
+        indent_after = line_indentation(seq, length);
     }
     
     // VSCode formula: 1000 - (indentBefore + indentAfter)
@@ -211,9 +241,11 @@ static int line_seq_get_boundary_score(const ISequence* self, int length) {
 
 static void line_seq_destroy(ISequence* self) {
     LineSequence* seq = (LineSequence*)self->data;
-    free(seq->trimmed_hash);
-    free(seq);
-    free(self);
+    diff_scratch_free(seq->trimmed_hash);
+    diff_scratch_free(seq->indentation);
+    diff_scratch_free(seq->line_lengths);
+    diff_scratch_free(seq);
+    diff_scratch_free(self);
 }
 
 /**
@@ -225,10 +257,26 @@ static void line_seq_destroy(ISequence* self) {
  */
 ISequence* line_sequence_create(const char** lines, int length, bool ignore_whitespace,
                                StringHashMap* hash_map) {
-    LineSequence* seq = (LineSequence*)malloc(sizeof(LineSequence));
+    return line_sequence_create_n(lines, NULL, length, ignore_whitespace, hash_map);
+}
+
+/**
+ * Intern one line key: into hash_map alone, or layered over a read-only base
+ */
+static uint32_t line_key_id(StringHashMap* hash_map, const StringHashMap* base,
+                            const char* key, size_t key_len) {
+    return base ? string_hash_map_get_or_create_layered_n(hash_map, base, key, key_len)
+                : string_hash_map_get_or_create_n(hash_map, key, key_len);
+}
+
+static ISequence* line_sequence_build(const char** lines, const int* lengths, int length,
+                                      bool ignore_whitespace, StringHashMap* hash_map,
+                                      const StringHashMap* base) {
+    LineSequence* seq = (LineSequence*)diff_scratch_malloc(sizeof(LineSequence));
     seq->lines = lines;  // Just reference, not owned
     seq->length = length;
     seq->ignore_whitespace = ignore_whitespace;
+    seq->ascii = true;
     
     // Create internal hash map if not provided
     bool owns_hash_map = false;
@@ -237,15 +285,27 @@ ISequence* line_sequence_create(const char** lines, int length, bool ignore_whit
         owns_hash_map = true;
     }
     
-    // Pre-compute perfect hashes for all lines
-    seq->trimmed_hash = (uint32_t*)malloc(sizeof(uint32_t) * length);
+    // Pre-compute perfect hashes and indentation for all lines
+    // (worst case every line is new: size the table once up front)
+    string_hash_map_reserve(hash_map, string_hash_map_size(hash_map) + length);
+    seq->trimmed_hash = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * length);
+    seq->indentation = (uint16_t*)diff_scratch_malloc(sizeof(uint16_t) * (length > 0 ? length : 1));
+    seq->line_lengths = (int*)diff_scratch_malloc(sizeof(int) * (length > 0 ? length : 1));
     for (int i = 0; i < length; i++) {
+        int line_len = diff_line_length(lines, lengths, i);
+        seq->line_lengths[i] = line_len;
+        if (seq->ascii && utf8_ascii_run_length(lines[i], line_len) != line_len) {
+            seq->ascii = false;
+        }
+        int indent = get_indentation(lines[i], line_len);
+        seq->indentation[i] = (uint16_t)(indent < LINE_INDENTATION_OVERFLOW ? indent
+                                                                            : LINE_INDENTATION_OVERFLOW);
         if (ignore_whitespace) {
-            char* trimmed = trim_string(lines[i]);
-            seq->trimmed_hash[i] = string_hash_map_get_or_create(hash_map, trimmed);
-            free(trimmed);
+            size_t trimmed_len;
+            const char* trimmed = trim_span(lines[i], line_len, &trimmed_len);
+            seq->trimmed_hash[i] = line_key_id(hash_map, base, trimmed, trimmed_len);
         } else {
-            seq->trimmed_hash[i] = string_hash_map_get_or_create(hash_map, lines[i]);
+            seq->trimmed_hash[i] = line_key_id(hash_map, base, lines[i], (size_t)line_len);
         }
     }
     
@@ -255,10 +315,11 @@ ISequence* line_sequence_create(const char** lines, int length, bool ignore_whit
     }
     
     // Create ISequence wrapper
-    ISequence* iseq = (ISequence*)malloc(sizeof(ISequence));
+    ISequence* iseq = (ISequence*)diff_scratch_malloc(sizeof(ISequence));
     iseq->data = seq;
     iseq->getElement = line_seq_get_element;
     iseq->getLength = line_seq_get_length;
+    iseq->getElements = line_seq_get_elements;
     iseq->isStronglyEqual = line_seq_is_strongly_equal;
     iseq->getBoundaryScore = line_seq_get_boundary_score;
     iseq->destroy = line_seq_destroy;
@@ -266,6 +327,46 @@ ISequence* line_sequence_create(const char** lines, int length, bool ignore_whit
     return iseq;
 }
 
+ISequence* line_sequence_create_n(const char** lines, const int* lengths, int length,
+                                  bool ignore_whitespace, StringHashMap* hash_map) {
+    return line_sequence_build(lines, lengths, length, ignore_whitespace, hash_map, NULL);
+}
+
+ISequence* line_sequence_create_layered_n(const char** lines, const int* lengths, int length,
+                                          bool ignore_whitespace, const StringHashMap* base,
+                                          StringHashMap* hash_map) {
+    return line_sequence_build(lines, lengths, length, ignore_whitespace, hash_map, base);
+}
+
+static void line_seq_window_destroy(ISequence* self) {
+    diff_scratch_free(self->data);  // Hashes/lines belong to the parent
+    diff_scratch_free(self);
+}
+
+ISequence* line_sequence_create_window(const ISequence* parent, int start, int length) {
+    const LineSequence* base = (const LineSequence*)parent->data;
+    
+    LineSequence* seq = (LineSequence*)diff_scratch_malloc(sizeof(LineSequence));
+    seq->lines = base->lines + start;
+    seq->trimmed_hash = base->trimmed_hash + start;
+    seq->indentation = base->indentation + start;
+    seq->line_lengths = base->line_lengths + start;
+    seq->length = length;
+    seq->ignore_whitespace = base->ignore_whitespace;
+    seq->ascii = base->ascii;
+    
+    ISequence* iseq = (ISequence*)diff_scratch_malloc(sizeof(ISequence));
+    iseq->data = seq;
+    iseq->getElement = line_seq_get_element;
+    iseq->getLength = line_seq_get_length;
+    iseq->getElements = line_seq_get_elements;
+    iseq->isStronglyEqual = line_seq_is_strongly_equal;
+    iseq->getBoundaryScore = line_seq_get_boundary_score;
+    iseq->destroy = line_seq_window_destroy;
+    
+    return iseq;
+}
+
 // ============================================================================
 // CharSequence Implementation
 // ============================================================================
@@ -286,6 +387,11 @@ static int char_seq_get_length(const ISequence* self) {
     return seq->length;
 }
 
+static const uint32_t* char_seq_get_elements(const ISequence* self) {
+    CharSequence* seq = (CharSequence*)self->data;
+    return seq->elements;
+}
+
 static bool char_seq_is_strongly_equal(const ISequence* self, int offset1, int offset2) {
     CharSequence* seq = (CharSequence*)self->data;
     if (offset1 < 0 || offset1 >= seq->length || 
@@ -317,27 +423,39 @@ typedef enum {
     CHAR_BOUNDARY_LINE_BREAK_LF
 } CharBoundaryCategory;
 
-static CharBoundaryCategory get_char_category(int char_code) {
-    if (char_code == '\n') {
-        return CHAR_BOUNDARY_LINE_BREAK_LF;
-    } else if (char_code == '\r') {
-        return CHAR_BOUNDARY_LINE_BREAK_CR;
-    } else if (char_code == ' ' || char_code == '\t') {
-        return CHAR_BOUNDARY_SPACE;
-    } else if (char_code >= 'a' && char_code <= 'z') {
-        return CHAR_BOUNDARY_WORD_LOWER;
-    } else if (char_code >= 'A' && char_code <= 'Z') {
-        return CHAR_BOUNDARY_WORD_UPPER;
-    } else if (char_code >= '0' && char_code <= '9') {
-        return CHAR_BOUNDARY_WORD_NUMBER;
-    } else if (char_code == -1) {
-        return CHAR_BOUNDARY_END;
-    } else if (char_code == ',' || char_code == ';') {
-        return CHAR_BOUNDARY_SEPARATOR;
-    } else {
-        return CHAR_BOUNDARY_OTHER;
-    }
-}
+/**
+ * Category of each ASCII character: '\n', '\r', space/tab, a-z, A-Z, 0-9,
+ * ',' and ';' have their own; everything else (including all non-ASCII)
+ * is OTHER. END is used for the positions before/after the sequence.
+ * 
+ * VSCode Reference: linesSliceCharSequence.ts getCategory()
+ */
+#define L_ CHAR_BOUNDARY_WORD_LOWER
+#define U_ CHAR_BOUNDARY_WORD_UPPER
+#define N_ CHAR_BOUNDARY_WORD_NUMBER
+#define O_ CHAR_BOUNDARY_OTHER
+#define P_ CHAR_BOUNDARY_SEPARATOR
+#define S_ CHAR_BOUNDARY_SPACE
+#define R_ CHAR_BOUNDARY_LINE_BREAK_CR
+#define F_ CHAR_BOUNDARY_LINE_BREAK_LF
+static const uint8_t ASCII_CHAR_CATEGORIES[128] = {
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, S_, F_, O_, O_, R_, O_, O_,  // 0x00
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  // 0x10
+    S_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, P_, O_, O_, O_,  // 0x20  ' ' ','
+    N_, N_, N_, N_, N_, N_, N_, N_, N_, N_, O_, P_, O_, O_, O_, O_,  // 0x30  0-9 ';'
+    O_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_,  // 0x40  A-O
+    U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, U_, O_, O_, O_, O_, O_,  // 0x50  P-Z
+    O_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_,  // 0x60  a-o
+    L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, L_, O_, O_, O_, O_, O_,  // 0x70  p-z
+};
+#undef L_
+#undef U_
+#undef N_
+#undef O_
+#undef P_
+#undef S_
+#undef R_
+#undef F_
 
 static int get_category_boundary_score(CharBoundaryCategory category) {
     static const int scores[] = {
@@ -354,14 +472,38 @@ static int get_category_boundary_score(CharBoundaryCategory category) {
     return scores[category];
 }
 
+/**
+ * Fill seq->categories from seq->elements (one table lookup per element)
+ * all_ascii: every element is below 128, the range check is left out
+ */
+static bool char_seq_compute_categories(CharSequence* seq, bool all_ascii) {
+    seq->categories = (uint8_t*)diff_scratch_malloc(seq->length > 0 ? (size_t)seq->length : 1);
+    if (!seq->categories) {
+        return false;
+    }
+    const uint32_t* elements = seq->elements;
+    uint8_t* categories = seq->categories;
+    if (all_ascii) {
+        for (int i = 0; i < seq->length; i++) {
+            categories[i] = ASCII_CHAR_CATEGORIES[elements[i]];
+        }
+        return true;
+    }
+    for (int i = 0; i < seq->length; i++) {
+        uint32_t c = elements[i];
+        categories[i] = c < 128 ? ASCII_CHAR_CATEGORIES[c] : (uint8_t)CHAR_BOUNDARY_OTHER;
+    }
+    return true;
+}
+
 static int char_seq_get_boundary_score(const ISequence* self, int length) {
     CharSequence* seq = (CharSequence*)self->data;
     
-    int prev_char = (length > 0) ? (int)seq->elements[length - 1] : -1;
-    int next_char = (length < seq->length) ? (int)seq->elements[length] : -1;
-    
-    CharBoundaryCategory prev_category = get_char_category(prev_char);
-    CharBoundaryCategory next_category = get_char_category(next_char);
+    // Categories were classified once at creation; the ends are END
+    CharBoundaryCategory prev_category = (length > 0 && length <= seq->length)
+        ? (CharBoundaryCategory)seq->categories[length - 1] : CHAR_BOUNDARY_END;
+    CharBoundaryCategory next_category = (length >= 0 && length < seq->length)
+        ? (CharBoundaryCategory)seq->categories[length] : CHAR_BOUNDARY_END;
     
     // Don't break between \r and \n
     if (prev_category == CHAR_BOUNDARY_LINE_BREAK_CR && 
@@ -396,12 +538,13 @@ static int char_seq_get_boundary_score(const ISequence* self, int length) {
 
 static void char_seq_destroy(ISequence* self) {
     CharSequence* seq = (CharSequence*)self->data;
-    free(seq->elements);
-    free(seq->line_start_offsets);
-    free(seq->trimmed_ws_lengths);
-    free(seq->original_line_start_cols);
-    free(seq);
-    free(self);
+    diff_scratch_free(seq->elements);
+    diff_scratch_free(seq->categories);
+    diff_scratch_free(seq->line_start_offsets);
+    diff_scratch_free(seq->trimmed_ws_lengths);
+    diff_scratch_free(seq->original_line_start_cols);
+    diff_scratch_free(seq);
+    diff_scratch_free(self);
 }
 
 /**
@@ -412,11 +555,12 @@ static void char_seq_destroy(ISequence* self) {
  * REUSED BY: Step 4 (char_level.c) for each line-level diff
  */
 static ISequence* char_sequence_create_empty(bool consider_whitespace) {
-    CharSequence* seq = (CharSequence*)malloc(sizeof(CharSequence));
+    CharSequence* seq = (CharSequence*)diff_scratch_malloc(sizeof(CharSequence));
     if (!seq) {
         return NULL;
     }
     seq->elements = NULL;
+    seq->categories = NULL;
     seq->length = 0;
     seq->line_start_offsets = NULL;
     seq->trimmed_ws_lengths = NULL;
@@ -424,14 +568,15 @@ static ISequence* char_sequence_create_empty(bool consider_whitespace) {
     seq->line_count = 0;
     seq->consider_whitespace = consider_whitespace;
 
-    ISequence* iseq = (ISequence*)malloc(sizeof(ISequence));
+    ISequence* iseq = (ISequence*)diff_scratch_malloc(sizeof(ISequence));
     if (!iseq) {
-        free(seq);
+        diff_scratch_free(seq);
         return NULL;
     }
     iseq->data = seq;
     iseq->getElement = char_seq_get_element;
     iseq->getLength = char_seq_get_length;
+    iseq->getElements = char_seq_get_elements;
     iseq->isStronglyEqual = char_seq_is_strongly_equal;
     iseq->getBoundaryScore = char_seq_get_boundary_score;
     iseq->destroy = char_seq_destroy;
@@ -462,85 +607,69 @@ ISequence* char_sequence_create(const char** lines, int start_line, int end_line
     return char_sequence_create_from_range(lines, end_line, &range, consider_whitespace);
 }
 
-ISequence* char_sequence_create_from_range(const char** lines,
-                                           int line_count,
-                                           const CharRange* range,
-                                           bool consider_whitespace) {
-    if (!range || !lines) {
-        return char_sequence_create_empty(consider_whitespace);
-    }
-
-    if (range->start_line > range->end_line) {
-        return char_sequence_create_empty(consider_whitespace);
-    }
-
-    if (line_count <= 0) {
-        return char_sequence_create_empty(consider_whitespace);
-    }
-
-    int start_line_num = range->start_line;
-    int end_line_num = range->end_line;
+/** Per-line results of the counting pass, reused by the writing pass */
+typedef struct {
+    int effective_length;   // UTF-16 units taken from the line
+    int byte_length;        // Byte length of the line
+    bool ascii;             // Whole line is ASCII: UTF-16 columns == byte offsets
+} CharLineScan;
 
-    if (start_line_num < 1) {
-        start_line_num = 1;
-    }
-    if (start_line_num > line_count) {
-        start_line_num = line_count;
-    }
-
-    if (end_line_num < start_line_num) {
-        end_line_num = start_line_num;
-    }
-    if (end_line_num > line_count) {
-        end_line_num = line_count;
-    }
-
-    int line_span = end_line_num - start_line_num + 1;
-    if (line_span <= 0) {
-        return char_sequence_create_empty(consider_whitespace);
-    }
-
-    CharSequence* seq = (CharSequence*)malloc(sizeof(CharSequence));
-    if (!seq) {
-        return NULL;
-    }
-    seq->consider_whitespace = consider_whitespace;
-    seq->line_count = line_span;
-    seq->elements = NULL;
-    seq->line_start_offsets = (int*)malloc(sizeof(int) * (line_span + 1));
-    seq->trimmed_ws_lengths = (int*)malloc(sizeof(int) * line_span);
-    seq->original_line_start_cols = (int*)malloc(sizeof(int) * line_span);
-    if (!seq->line_start_offsets || !seq->trimmed_ws_lengths || !seq->original_line_start_cols) {
-        free(seq->line_start_offsets);
-        free(seq->trimmed_ws_lengths);
-        free(seq->original_line_start_cols);
-        free(seq);
-        return NULL;
+/**
+ * True when every line of [first_line, last_line] (1-indexed) is ASCII
+ * without NUL bytes: one vector scan per line, stopping at the first other
+ */
+static bool char_lines_ascii(const char** lines, const int* lengths, int first_line, int last_line) {
+    for (int line_number = first_line; line_number <= last_line; line_number++) {
+        const char* line = lines[line_number - 1];
+        if (!line) continue;
+        int length = diff_line_length(lines, lengths, line_number - 1);
+        if (utf8_ascii_run_length(line, length) != length) return false;
     }
+    return true;
+}
 
-    int* effective_lengths = (int*)malloc(sizeof(int) * line_span);
-    if (!effective_lengths) {
-        free(seq->line_start_offsets);
-        free(seq->trimmed_ws_lengths);
-        free(seq->original_line_start_cols);
-        free(seq);
-        return NULL;
-    }
+/**
+ * Call a CharSequence kernel with consider_whitespace and all_ascii turned
+ * into compile-time constants: each of the four variants is inlined, so the
+ * trimming and UTF-8 branches leave the loops of the variants without them
+ */
+#define CHAR_SEQUENCE_KERNEL(kernel, consider_whitespace, all_ascii, ...)                     \
+    ((all_ascii) ? ((consider_whitespace) ? kernel(__VA_ARGS__, true, true)                 \
+                                          : kernel(__VA_ARGS__, false, true))               \
+                 : ((consider_whitespace) ? kernel(__VA_ARGS__, true, false)                \
+                                          : kernel(__VA_ARGS__, false, false)))
 
-    // PASS 1: Count total UTF-16 code units
-    // JavaScript Note: In JS, strings are indexed by UTF-16 code units (str[i], str.length)
-    // C Note: We must convert UTF-8 to UTF-16 code units for algorithm compatibility
+/**
+ * PASS 1: Count total UTF-16 code units
+ * JavaScript Note: In JS, strings are indexed by UTF-16 code units (str[i], str.length)
+ * C Note: We must convert UTF-8 to UTF-16 code units for algorithm compatibility
+ * 
+ * Fills scans, trimmed_ws_lengths and original_line_start_cols; returns
+ * the element count. all_ascii: every line passed char_lines_ascii().
+ */
+static DIFF_FORCE_INLINE int char_sequence_scan_lines(CharSequence* seq, CharLineScan* scans,
+                                                      const char** lines, const int* lengths,
+                                                      int line_count, const CharRange* range,
+                                                      int start_line_num, int end_line_num,
+                                                      bool consider_whitespace, bool all_ascii) {
+    int line_span = seq->line_count;
     int total_len = 0;
     for (int idx = 0; idx < line_span; idx++) {
         int line_number = start_line_num + idx;
         const char* line = (line_number >= 1 && line_number <= line_count)
                                ? lines[line_number - 1]
                                : "";
+        int line_len_bytes = 0;
         if (!line) {
             line = "";
+        } else if (line_number >= 1 && line_number <= line_count) {
+            line_len_bytes = diff_line_length(lines, lengths, line_number - 1);
         }
-        int line_len_bytes = (int)strlen(line);
-        int line_len_utf16_units = utf8_to_utf16_length(line);  // Language conversion: UTF-8 → UTF-16
+        // Pure ASCII lines (the common case for source) map UTF-16 columns
+        // 1:1 to byte offsets, so none of the conversions below need decoding
+        bool ascii = all_ascii || utf8_ascii_run_length(line, line_len_bytes) == line_len_bytes;
+        int line_len_utf16_units = ascii ? line_len_bytes
+                                         : utf8_to_utf16_length_n(line, line_len_bytes);  // Language conversion: UTF-8 → UTF-16
 
         // Convert range column (UTF-16 units in JS) to byte offset (UTF-8 in C)
         int line_start_utf16_offset = 0;
@@ -550,7 +679,9 @@ ISequence* char_sequence_create_from_range(const char** lines,
             if (line_start_utf16_offset > line_len_utf16_units) {
                 line_start_utf16_offset = line_len_utf16_units;
             }
-            line_start_byte_offset = utf16_pos_to_utf8_byte(line, line_start_utf16_offset);  // Language conversion
+            line_start_byte_offset = ascii ? line_start_utf16_offset
+                                           : utf16_pos_to_utf8_byte_n(line, line_len_bytes,
+                                                                      line_start_utf16_offset);  // Language conversion
         }
         seq->original_line_start_cols[idx] = line_start_utf16_offset;
 
@@ -572,7 +703,8 @@ ISequence* char_sequence_create_from_range(const char** lines,
                 trimmed_start++;
             }
             // Count trimmed whitespace in UTF-16 units (Language conversion)
-            trimmed_ws_length_utf16_units = get_utf16_substring_length(ws_start, trimmed_start);
+            trimmed_ws_length_utf16_units = ascii ? (int)(trimmed_start - ws_start)
+                                                  : get_utf16_substring_length(ws_start, trimmed_start);
             
             // Skip trailing whitespace
             while (trimmed_end > trimmed_start && isspace((unsigned char)*(trimmed_end - 1))) {
@@ -585,7 +717,8 @@ ISequence* char_sequence_create_from_range(const char** lines,
         if (trimmed_len_bytes < 0) {
             trimmed_len_bytes = 0;
         }
-        int trimmed_len_utf16_units = get_utf16_substring_length(trimmed_start, trimmed_end);
+        int trimmed_len_utf16_units = ascii ? trimmed_len_bytes
+                                            : get_utf16_substring_length(trimmed_start, trimmed_end);
 
         // Calculate final line length in UTF-16 units (matching JS)
         int line_length_utf16_units = trimmed_len_utf16_units;
@@ -610,28 +743,31 @@ ISequence* char_sequence_create_from_range(const char** lines,
         }
 
         seq->trimmed_ws_lengths[idx] = trimmed_ws_length_utf16_units;
-        effective_lengths[idx] = line_length_utf16_units;
+        scans[idx].effective_length = line_length_utf16_units;
+        scans[idx].byte_length = line_len_bytes;
+        scans[idx].ascii = ascii;
 
         total_len += line_length_utf16_units;
         if (line_number < end_line_num) {
             total_len += 1;  // For '\n'
         }
     }
+    return total_len;
+}
 
-    seq->elements = (uint32_t*)malloc(sizeof(uint32_t) * (total_len + 1));
-    if (!seq->elements) {
-        free(effective_lengths);
-        free(seq->line_start_offsets);
-        free(seq->trimmed_ws_lengths);
-        free(seq->original_line_start_cols);
-        free(seq);
-        return NULL;
-    }
-    seq->length = total_len;
-
-    // PASS 2: Build elements array with UTF-16 code units
-    // JavaScript Note: In JS, strings are UTF-16 arrays, so str[i] returns a UTF-16 code unit
-    // C Note: We convert UTF-8 strings to UTF-16 code units to match JS behavior
+/**
+ * PASS 2: Build elements array with UTF-16 code units
+ * JavaScript Note: In JS, strings are UTF-16 arrays, so str[i] returns a UTF-16 code unit
+ * C Note: We convert UTF-8 strings to UTF-16 code units to match JS behavior
+ * 
+ * Fills elements and line_start_offsets[0, line_span); returns the
+ * number of elements written.
+ */
+static DIFF_FORCE_INLINE int char_sequence_write_lines(CharSequence* seq, const CharLineScan* scans,
+                                                       const char** lines, int line_count,
+                                                       int start_line_num, int end_line_num,
+                                                       bool consider_whitespace, bool all_ascii) {
+    int line_span = seq->line_count;
     int offset = 0;
     for (int idx = 0; idx < line_span; idx++) {
         int line_number = start_line_num + idx;
@@ -643,7 +779,10 @@ ISequence* char_sequence_create_from_range(const char** lines,
         if (!line) {
             line = "";
         }
-        int line_len_utf16_units = utf8_to_utf16_length(line);  // Language conversion
+        const CharLineScan* scan = &scans[idx];
+        bool ascii = all_ascii || scan->ascii;
+        int line_len_utf16_units = ascii ? scan->byte_length
+                                               : utf8_to_utf16_length_n(line, scan->byte_length);  // Language conversion
 
         // Calculate starting column in UTF-16 units (matching JS)
         int start_col_utf16_units = seq->original_line_start_cols[idx];
@@ -654,40 +793,149 @@ ISequence* char_sequence_create_from_range(const char** lines,
             start_col_utf16_units = line_len_utf16_units;
         }
 
-        int num_utf16_units = effective_lengths[idx];
+        int num_utf16_units = scan->effective_length;
         if (num_utf16_units < 0) {
             num_utf16_units = 0;
         }
 
-        // Convert UTF-16 position to byte offset (Language conversion)
-        int start_col_bytes = utf16_pos_to_utf8_byte(line, start_col_utf16_units);
-
-        // Write UTF-8 string as UTF-16 code units (Language conversion)
-        const char* src = line + start_col_bytes;
-        int utf16_units_written = write_utf8_as_utf16_units(src, num_utf16_units, seq->elements, offset);
-        offset += utf16_units_written;
+        if (ascii) {
+            // ASCII: columns are byte offsets, widen straight into elements
+            if (num_utf16_units > scan->byte_length - start_col_utf16_units) {
+                num_utf16_units = scan->byte_length - start_col_utf16_units;
+            }
+            utf8_widen_ascii(line + start_col_utf16_units, num_utf16_units, seq->elements + offset);
+            offset += num_utf16_units;
+        } else {
+            // Convert UTF-16 position to byte offset (Language conversion)
+            int start_col_bytes = utf16_pos_to_utf8_byte_n(line, scan->byte_length, start_col_utf16_units);
+
+            // Write UTF-8 string as UTF-16 code units (Language conversion)
+            const char* src = line + start_col_bytes;
+            int utf16_units_written = write_utf8_as_utf16_units(src, scan->byte_length - start_col_bytes,
+                                                                num_utf16_units, seq->elements, offset);
+            offset += utf16_units_written;
+        }
 
         // Add newline (same in both JS and C)
         if (line_number < end_line_num) {
             seq->elements[offset++] = '\n';
         }
     }
-    seq->line_start_offsets[line_span] = offset;
+    return offset;
+}
 
-    free(effective_lengths);
+ISequence* char_sequence_create_from_range(const char** lines,
+                                           int line_count,
+                                           const CharRange* range,
+                                           bool consider_whitespace) {
+    return char_sequence_create_from_range_n(lines, NULL, line_count, range, consider_whitespace);
+}
 
-    ISequence* iseq = (ISequence*)malloc(sizeof(ISequence));
-    if (!iseq) {
-        free(seq->elements);
-        free(seq->line_start_offsets);
-        free(seq->trimmed_ws_lengths);
-        free(seq->original_line_start_cols);
-        free(seq);
+ISequence* char_sequence_create_from_range_n(const char** lines,
+                                             const int* lengths,
+                                             int line_count,
+                                             const CharRange* range,
+                                             bool consider_whitespace) {
+    if (!range || !lines) {
+        return char_sequence_create_empty(consider_whitespace);
+    }
+
+    if (range->start_line > range->end_line) {
+        return char_sequence_create_empty(consider_whitespace);
+    }
+
+    if (line_count <= 0) {
+        return char_sequence_create_empty(consider_whitespace);
+    }
+
+    int start_line_num = range->start_line;
+    int end_line_num = range->end_line;
+
+    if (start_line_num < 1) {
+        start_line_num = 1;
+    }
+    if (start_line_num > line_count) {
+        start_line_num = line_count;
+    }
+
+    if (end_line_num < start_line_num) {
+        end_line_num = start_line_num;
+    }
+    if (end_line_num > line_count) {
+        end_line_num = line_count;
+    }
+
+    int line_span = end_line_num - start_line_num + 1;
+    if (line_span <= 0) {
+        return char_sequence_create_empty(consider_whitespace);
+    }
+
+    CharSequence* seq = (CharSequence*)diff_scratch_malloc(sizeof(CharSequence));
+    if (!seq) {
+        return NULL;
+    }
+    seq->consider_whitespace = consider_whitespace;
+    seq->line_count = line_span;
+    seq->elements = NULL;
+    seq->categories = NULL;
+    seq->line_start_offsets = (int*)diff_scratch_malloc(sizeof(int) * (line_span + 1));
+    seq->trimmed_ws_lengths = (int*)diff_scratch_malloc(sizeof(int) * line_span);
+    seq->original_line_start_cols = (int*)diff_scratch_malloc(sizeof(int) * line_span);
+    if (!seq->line_start_offsets || !seq->trimmed_ws_lengths || !seq->original_line_start_cols) {
+        diff_scratch_free(seq->line_start_offsets);
+        diff_scratch_free(seq->trimmed_ws_lengths);
+        diff_scratch_free(seq->original_line_start_cols);
+        diff_scratch_free(seq);
+        return NULL;
+    }
+
+    CharLineScan* scans = (CharLineScan*)diff_scratch_malloc(sizeof(CharLineScan) * line_span);
+    if (!scans) {
+        diff_scratch_free(seq->line_start_offsets);
+        diff_scratch_free(seq->trimmed_ws_lengths);
+        diff_scratch_free(seq->original_line_start_cols);
+        diff_scratch_free(seq);
+        return NULL;
+    }
+
+    // PASS 1 / PASS 2 below, specialized once for the whole range
+    bool all_ascii = char_lines_ascii(lines, lengths, start_line_num, end_line_num);
+    int total_len = CHAR_SEQUENCE_KERNEL(char_sequence_scan_lines, consider_whitespace, all_ascii,
+                                         seq, scans, lines, lengths, line_count, range,
+                                         start_line_num, end_line_num);
+
+    seq->elements = (uint32_t*)diff_scratch_malloc(sizeof(uint32_t) * (total_len + 1));
+    if (!seq->elements) {
+        diff_scratch_free(scans);
+        diff_scratch_free(seq->line_start_offsets);
+        diff_scratch_free(seq->trimmed_ws_lengths);
+        diff_scratch_free(seq->original_line_start_cols);
+        diff_scratch_free(seq);
+        return NULL;
+    }
+    seq->length = total_len;
+
+    int offset = CHAR_SEQUENCE_KERNEL(char_sequence_write_lines, consider_whitespace, all_ascii,
+                                      seq, scans, lines, line_count, start_line_num, end_line_num);
+    seq->line_start_offsets[line_span] = offset;
+
+    diff_scratch_free(scans);
+
+    ISequence* iseq = (ISequence*)diff_scratch_malloc(sizeof(ISequence));
+    if (!iseq || !char_seq_compute_categories(seq, all_ascii)) {
+        diff_scratch_free(iseq);
+        diff_scratch_free(seq->categories);
+        diff_scratch_free(seq->elements);
+        diff_scratch_free(seq->line_start_offsets);
+        diff_scratch_free(seq->trimmed_ws_lengths);
+        diff_scratch_free(seq->original_line_start_cols);
+        diff_scratch_free(seq);
         return NULL;
     }
     iseq->data = seq;
     iseq->getElement = char_seq_get_element;
     iseq->getLength = char_seq_get_length;
+    iseq->getElements = char_seq_get_elements;
     iseq->isStronglyEqual = char_seq_is_strongly_equal;
     iseq->getBoundaryScore = char_seq_get_boundary_score;
     iseq->destroy = char_seq_destroy;
@@ -875,6 +1123,30 @@ bool char_sequence_find_subword_containing(const CharSequence* seq, int offset,
     return true;
 }
 
+/**
+ * End of the token starting at offset (not VSCode)
+ * 
+ * A token is a word (maximal run of is_word_char, as in
+ * char_sequence_find_word_containing), a maximal run of spaces/tabs, or
+ * any other single element (punctuation, line breaks, non-ASCII).
+ */
+int char_sequence_token_end(const CharSequence* seq, int offset) {
+    if (offset >= seq->length) {
+        return seq->length;
+    }
+    int end = offset + 1;
+    if (is_word_char(seq->elements[offset])) {
+        while (end < seq->length && is_word_char(seq->elements[end])) {
+            end++;
+        }
+    } else if (seq->categories[offset] == CHAR_BOUNDARY_SPACE) {
+        while (end < seq->length && seq->categories[end] == CHAR_BOUNDARY_SPACE) {
+            end++;
+        }
+    }
+    return end;
+}
+
 /**
  * Count lines in character range - VSCode Parity
  * 
@@ -904,7 +1176,7 @@ char* char_sequence_get_text(const CharSequence* seq, int start_offset, int end_
     }
     
     int len = end_offset - start_offset;
-    char* result = (char*)malloc(len + 1);
+    char* result = (char*)diff_scratch_malloc(len + 1);
     if (!result) return NULL;
     
     for (int i = 0; i < len; i++) {
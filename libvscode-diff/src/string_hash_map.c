@@ -1,140 +1,308 @@
 /**
  * Specialized String-to-Sequential-ID Hash Map Implementation
- * 
+ *
  * This is NOT a general-purpose hash table. It's optimized for the specific use case
  * of assigning unique sequential integers to unique strings during diff computation.
- * 
+ *
  * Implementation details:
- * - FNV-1a hash for bucket selection (same performance as TypeScript Map's internal hash)
- * - Chaining for collision resolution
- * - Dynamic resizing at 75% load factor
+ * - Open addressing with Robin Hood linear probing (no per-entry allocations)
+ * - Each slot stores the full 64-bit hash, the key length and an offset into
+ *   one contiguous string pool, so most mismatches are rejected without
+ *   touching key bytes
+ * - Word-at-a-time 64-bit hash (8 bytes per step, murmur-style mixing)
+ * - Power-of-two capacity, resized at 75% load factor; reserve() pre-sizes
  * - Collision-free values: sequential IDs guarantee no value collisions
- * 
+ *
  * Performance: O(1) average lookup/insert, matching TypeScript Map
  * VSCode Parity: 100% - Exactly matches perfectHashes Map behavior
  */
 
 #include "string_hash_map.h"
-#include "platform.h"
+#include "diff_allocator.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define INITIAL_CAPACITY 16
 #define LOAD_FACTOR 0.75
+#define INITIAL_POOL_CAPACITY 4096
+#define EMPTY_SLOT UINT32_MAX
 
-typedef struct HashEntry {
-    char* key;              // Owned string copy
-    uint32_t value;         // Sequential integer (0, 1, 2, ...)
-    struct HashEntry* next; // Chaining for collision resolution
-} HashEntry;
+typedef struct {
+    uint64_t hash;          // Full hash of the key
+    size_t key_offset;      // Key bytes at pool + key_offset (NUL-terminated)
+    uint32_t key_length;    // Key length in bytes
+    uint32_t value;         // Sequential integer (0, 1, 2, ...), EMPTY_SLOT if unused
+} HashSlot;
 
 struct StringHashMap {
-    HashEntry** buckets;
-    int capacity;
+    HashSlot* slots;
+    uint32_t capacity;     // Always a power of two
     int size;              // Number of unique strings
+
+    char* pool;            // All keys, back to back
+    size_t pool_size;
+    size_t pool_capacity;
 };
 
+// ============================================================================
+// Hashing
+// ============================================================================
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
 /**
- * FNV-1a hash for bucket selection
- * 
- * NOTE: This is ONLY used to choose which bucket to place an entry in.
+ * 64-bit hash consuming 8 bytes per step
+ *
+ * NOTE: This is ONLY used to place and pre-filter entries.
  * The value returned to the caller is a sequential ID (0, 1, 2, ...),
  * NOT this hash value. This ensures perfect collision-free behavior.
  */
-static uint32_t hash_for_bucket(const char* str) {
-    uint32_t hash = 2166136261u;
-    while (*str) {
-        hash ^= (uint32_t)(unsigned char)(*str);
-        hash *= 16777619u;
-        str++;
+static uint64_t hash_bytes(const char* str, size_t len) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ (uint64_t)len;
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t k;
+        memcpy(&k, str + i, sizeof(k));  // Unaligned-safe load
+        k *= c1;
+        k = rotl64(k, 31);
+        k *= c2;
+        h ^= k;
+        h = rotl64(h, 27) * 5 + 0x52dce729;
+    }
+
+    // Tail: up to 7 remaining bytes
+    uint64_t k = 0;
+    for (size_t j = 0; i + j < len; j++) {
+        k |= (uint64_t)(unsigned char)str[i + j] << (8 * j);
+    }
+    k *= c1;
+    k = rotl64(k, 31);
+    k *= c2;
+    h ^= k;
+
+    return fmix64(h);
+}
+
+// ============================================================================
+// Table Management
+// ============================================================================
+
+static HashSlot* slots_create(uint32_t capacity) {
+    HashSlot* slots = (HashSlot*)diff_malloc(sizeof(HashSlot) * capacity);
+    if (!slots) return NULL;
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].value = EMPTY_SLOT;
+    }
+    return slots;
+}
+
+static inline uint32_t probe_distance(const StringHashMap* map, const HashSlot* slot, uint32_t idx) {
+    return (idx - (uint32_t)slot->hash) & (map->capacity - 1);
+}
+
+/**
+ * Robin Hood insertion of a key known to be absent
+ * Entries that are closer to their home slot yield to entries that are farther.
+ */
+static void insert_slot(StringHashMap* map, HashSlot entry) {
+    uint32_t mask = map->capacity - 1;
+    uint32_t idx = (uint32_t)entry.hash & mask;
+    uint32_t dist = 0;
+
+    for (;;) {
+        HashSlot* slot = &map->slots[idx];
+        if (slot->value == EMPTY_SLOT) {
+            *slot = entry;
+            return;
+        }
+        uint32_t slot_dist = probe_distance(map, slot, idx);
+        if (slot_dist < dist) {
+            HashSlot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+            dist = slot_dist;
+        }
+        idx = (idx + 1) & mask;
+        dist++;
+    }
+}
+
+static bool grow_to(StringHashMap* map, uint32_t new_capacity) {
+    HashSlot* old_slots = map->slots;
+    uint32_t old_capacity = map->capacity;
+
+    HashSlot* new_slots = slots_create(new_capacity);
+    if (!new_slots) return false;
+
+    map->slots = new_slots;
+    map->capacity = new_capacity;
+
+    // Rehash all entries (stored hashes, no key bytes touched)
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].value != EMPTY_SLOT) {
+            insert_slot(map, old_slots[i]);
+        }
+    }
+
+    diff_free(old_slots);
+    return true;
+}
+
+/** Smallest power-of-two capacity that holds n entries under LOAD_FACTOR */
+static uint32_t capacity_for(int n) {
+    uint32_t capacity = INITIAL_CAPACITY;
+    while ((double)n >= capacity * LOAD_FACTOR && capacity < (1u << 31)) {
+        capacity <<= 1;
     }
-    return hash;
+    return capacity;
 }
 
+/**
+ * Copy a key into the pool and return its offset
+ * 
+ * Running out of memory here is fatal, as in mem_alloc(): the caller has no
+ * way to report it, and inserting a slot without its key bytes would send
+ * later lookups outside the pool.
+ */
+static size_t pool_append(StringHashMap* map, const char* str, size_t len) {
+    size_t needed = map->pool_size + len + 1;
+    if (needed > map->pool_capacity) {
+        size_t new_capacity = map->pool_capacity * 2;
+        while (new_capacity < needed) new_capacity *= 2;
+        char* new_pool = (char*)diff_realloc(map->pool, new_capacity);
+        if (!new_pool) {
+            fprintf(stderr, "Memory reallocation failed: %zu bytes\n", new_capacity);
+            exit(1);
+        }
+        map->pool = new_pool;
+        map->pool_capacity = new_capacity;
+    }
+
+    size_t offset = map->pool_size;
+    memcpy(map->pool + offset, str, len);
+    map->pool[offset + len] = '\0';
+    map->pool_size = needed;
+    return offset;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
 StringHashMap* string_hash_map_create(void) {
-    StringHashMap* map = (StringHashMap*)malloc(sizeof(StringHashMap));
+    StringHashMap* map = (StringHashMap*)diff_malloc(sizeof(StringHashMap));
     map->capacity = INITIAL_CAPACITY;
     map->size = 0;
-    map->buckets = (HashEntry**)calloc(map->capacity, sizeof(HashEntry*));
+    map->slots = slots_create(map->capacity);
+    map->pool_capacity = INITIAL_POOL_CAPACITY;
+    map->pool_size = 0;
+    map->pool = (char*)diff_malloc(map->pool_capacity);
     return map;
 }
 
-/**
- * Resize the hash table when load factor exceeds threshold
- */
-static void resize_if_needed(StringHashMap* map) {
-    if ((double)map->size / map->capacity < LOAD_FACTOR) {
-        return;
+void string_hash_map_reserve(StringHashMap* map, int n) {
+    uint32_t capacity = capacity_for(n);
+    if (capacity > map->capacity) {
+        grow_to(map, capacity);
     }
-    
-    int new_capacity = map->capacity * 2;
-    HashEntry** new_buckets = (HashEntry**)calloc(new_capacity, sizeof(HashEntry*));
-    
-    // Rehash all entries
-    for (int i = 0; i < map->capacity; i++) {
-        HashEntry* entry = map->buckets[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            
-            // Recompute bucket for new capacity
-            uint32_t bucket = hash_for_bucket(entry->key) % new_capacity;
-            entry->next = new_buckets[bucket];
-            new_buckets[bucket] = entry;
-            
-            entry = next;
+}
+
+/** ID of a key with the given hash, or EMPTY_SLOT if absent (read-only) */
+static uint32_t find_value(const StringHashMap* map, uint64_t hash, const char* str, size_t len) {
+    uint32_t mask = map->capacity - 1;
+    uint32_t idx = (uint32_t)hash & mask;
+    uint32_t dist = 0;
+
+    // Robin Hood: stop once we are "richer" than the slot
+    for (;;) {
+        const HashSlot* slot = &map->slots[idx];
+        if (slot->value == EMPTY_SLOT || probe_distance(map, slot, idx) < dist) {
+            return EMPTY_SLOT;
+        }
+        if (slot->hash == hash && slot->key_length == len &&
+            memcmp(map->pool + slot->key_offset, str, len) == 0) {
+            return slot->value;
         }
+        idx = (idx + 1) & mask;
+        dist++;
     }
-    
-    free(map->buckets);
-    map->buckets = new_buckets;
-    map->capacity = new_capacity;
 }
 
-uint32_t string_hash_map_get_or_create(StringHashMap* map, const char* str) {
-    uint32_t bucket = hash_for_bucket(str) % map->capacity;
-    
-    // Search for existing entry
-    HashEntry* entry = map->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->key, str) == 0) {
-            return entry->value;  // Found existing
-        }
-        entry = entry->next;
+static uint32_t get_or_create_hashed(StringHashMap* map, uint64_t hash, const char* str, size_t len) {
+    uint32_t existing = find_value(map, hash, str, len);
+    if (existing != EMPTY_SLOT) {
+        return existing;
     }
-    
+
     // Not found - create new entry with sequential value
-    resize_if_needed(map);
-    
-    // Recompute bucket after potential resize
-    bucket = hash_for_bucket(str) % map->capacity;
-    
-    HashEntry* new_entry = (HashEntry*)malloc(sizeof(HashEntry));
-    new_entry->key = diff_strdup(str);
-    new_entry->value = map->size;  // Sequential: 0, 1, 2, ...
-    new_entry->next = map->buckets[bucket];
-    map->buckets[bucket] = new_entry;
-    
+    if ((double)(map->size + 1) > map->capacity * LOAD_FACTOR) {
+        grow_to(map, map->capacity * 2);
+    }
+
+    HashSlot entry;
+    entry.hash = hash;
+    entry.key_offset = pool_append(map, str, len);
+    entry.key_length = (uint32_t)len;
+    entry.value = (uint32_t)map->size;  // Sequential: 0, 1, 2, ...
+    insert_slot(map, entry);
+
     map->size++;
-    return new_entry->value;
+    return entry.value;
+}
+
+uint32_t string_hash_map_get_or_create_n(StringHashMap* map, const char* str, size_t len) {
+    return get_or_create_hashed(map, hash_bytes(str, len), str, len);
+}
+
+uint32_t string_hash_map_get_or_create_layered_n(StringHashMap* map, const StringHashMap* base,
+                                                 const char* str, size_t len) {
+    uint64_t hash = hash_bytes(str, len);
+    uint32_t value = find_value(base, hash, str, len);
+    if (value != EMPTY_SLOT) {
+        return value;
+    }
+    return (uint32_t)base->size + get_or_create_hashed(map, hash, str, len);
+}
+
+uint32_t string_hash_map_get_or_create(StringHashMap* map, const char* str) {
+    return string_hash_map_get_or_create_n(map, str, strlen(str));
 }
 
 int string_hash_map_size(const StringHashMap* map) {
     return map->size;
 }
 
+void string_hash_map_clear(StringHashMap* map) {
+    for (uint32_t i = 0; i < map->capacity; i++) {
+        map->slots[i].value = EMPTY_SLOT;
+    }
+    map->size = 0;
+    map->pool_size = 0;
+}
+
+size_t string_hash_map_capacity_bytes(const StringHashMap* map) {
+    return sizeof(HashSlot) * map->capacity + map->pool_capacity;
+}
+
 void string_hash_map_destroy(StringHashMap* map) {
     if (!map) return;
-    
-    for (int i = 0; i < map->capacity; i++) {
-        HashEntry* entry = map->buckets[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            free(entry->key);
-            free(entry);
-            entry = next;
-        }
-    }
-    
-    free(map->buckets);
-    free(map);
+
+    diff_free(map->slots);
+    diff_free(map->pool);
+    diff_free(map);
 }
@@ -0,0 +1,335 @@
+// ============================================================================
+// Three-Way Diff
+// ============================================================================
+//
+// base, ours and theirs are hashed into one perfect hash map, so each
+// distinct trimmed line gets one ID across all three sides and the base
+// LineSequence is built once. The maps and sequences are complete before
+// the two alignments start; from then on both only read them, so
+// base->theirs runs on a worker while the caller computes base->ours.
+//
+// Regions are formed with the two hunk lists merged in base order: a hunk
+// joins the open region while its base start is at or before the region's
+// base end. Each side's position within a region follows from the line
+// offset that side has accumulated before and after it.
+//
+// Not VSCode: VSCode's merge editor runs two independent two-way diffs.
+//
+// ============================================================================
+
+#include "three_way_diff.h"
+#include "diff_allocator.h"
+#include "line_level.h"
+#include "char_level.h"
+#include "sequence.h"
+#include "string_hash_map.h"
+#include "utils.h"
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** One base->side line alignment, run on either thread */
+typedef struct {
+    const ISequence* base;
+    const ISequence* side;
+    int hash_count;
+    int timeout_ms;
+    const LineAlignmentOptions* options;
+    const DiffCancelFlag* cancel;
+    DiffMemoryBudget* memory_budget;
+    SequenceDiffArray* result;
+    bool hit_timeout;
+} SideAlignment;
+
+static void run_side_alignment(SideAlignment* job) {
+    job->result = compute_line_alignments_sequences(job->base, job->side, job->hash_count,
+                                                    job->timeout_ms, job->options,
+                                                    &job->hit_timeout);
+}
+
+static void* side_alignment_worker(void* arg) {
+    SideAlignment* job = (SideAlignment*)arg;
+    // Timeouts the worker starts itself must see the caller's cancellation
+    diff_set_thread_cancel_flag(job->cancel);
+    diff_set_thread_memory_budget(job->memory_budget);
+    run_side_alignment(job);
+    return NULL;
+}
+
+/** Whether lines [a_start, a_end) of a equal lines [b_start, b_end) of b byte for byte */
+static bool line_ranges_equal(const char** a, const int* a_lengths, int a_start, int a_end,
+                              const char** b, const int* b_lengths, int b_start, int b_end) {
+    if (a_end - a_start != b_end - b_start) return false;
+    for (int i = 0; i < a_end - a_start; i++) {
+        int length = diff_line_length(a, a_lengths, a_start + i);
+        if (length != diff_line_length(b, b_lengths, b_start + i) ||
+            memcmp(a[a_start + i], b[b_start + i], (size_t)length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool merge_region_push(ThreeWayDiff* diff, int* capacity, const MergeRegion* region) {
+    if (diff->count >= *capacity) {
+        int new_capacity = *capacity == 0 ? 8 : *capacity * 2;
+        MergeRegion* regions = (MergeRegion*)diff_realloc(diff->regions,
+                                                     sizeof(MergeRegion) * (size_t)new_capacity);
+        if (!regions) return false;
+        diff->regions = regions;
+        *capacity = new_capacity;
+    }
+    diff->regions[diff->count++] = *region;
+    return true;
+}
+
+static LineRange line_range_from_offsets(int start, int end) {
+    LineRange range = { start + 1, end + 1 };  // 0-based [start, end) -> 1-based
+    return range;
+}
+
+/**
+ * Group both sides' hunks into merge regions (kinds and line ranges only)
+ * @return false on allocation failure
+ */
+static bool build_merge_regions(const SequenceDiffArray* ours, const SequenceDiffArray* theirs,
+                                const char** ours_lines, const int* ours_lengths,
+                                const char** theirs_lines, const int* theirs_lengths,
+                                ThreeWayDiff* diff) {
+    int capacity = 0;
+    int io = 0;
+    int it = 0;
+    int ours_offset = 0;     // ours line - base line after the hunks taken so far
+    int theirs_offset = 0;
+    while (io < ours->count || it < theirs->count) {
+        bool take_ours = it >= theirs->count ||
+                         (io < ours->count &&
+                          ours->diffs[io].seq1_start <= theirs->diffs[it].seq1_start);
+        int base_start = take_ours ? ours->diffs[io].seq1_start : theirs->diffs[it].seq1_start;
+        int base_end = base_start;
+        int ours_before = ours_offset;
+        int theirs_before = theirs_offset;
+        bool ours_changed = false;
+        bool theirs_changed = false;
+
+        for (;;) {
+            if (io < ours->count && ours->diffs[io].seq1_start <= base_end) {
+                const SequenceDiff* hunk = &ours->diffs[io++];
+                if (hunk->seq1_end > base_end) base_end = hunk->seq1_end;
+                ours_offset = hunk->seq2_end - hunk->seq1_end;
+                ours_changed = true;
+            } else if (it < theirs->count && theirs->diffs[it].seq1_start <= base_end) {
+                const SequenceDiff* hunk = &theirs->diffs[it++];
+                if (hunk->seq1_end > base_end) base_end = hunk->seq1_end;
+                theirs_offset = hunk->seq2_end - hunk->seq1_end;
+                theirs_changed = true;
+            } else {
+                break;
+            }
+        }
+
+        MergeRegion region;
+        memset(&region, 0, sizeof(region));
+        region.base = line_range_from_offsets(base_start, base_end);
+        region.ours = line_range_from_offsets(base_start + ours_before, base_end + ours_offset);
+        region.theirs = line_range_from_offsets(base_start + theirs_before,
+                                                base_end + theirs_offset);
+        if (!theirs_changed) {
+            region.kind = MERGE_REGION_OURS;
+        } else if (!ours_changed) {
+            region.kind = MERGE_REGION_THEIRS;
+        } else if (line_ranges_equal(ours_lines, ours_lengths,
+                                     region.ours.start_line - 1, region.ours.end_line - 1,
+                                     theirs_lines, theirs_lengths,
+                                     region.theirs.start_line - 1, region.theirs.end_line - 1)) {
+            region.kind = MERGE_REGION_BOTH_SAME;
+        } else {
+            region.kind = MERGE_REGION_CONFLICT;
+        }
+        if (!merge_region_push(diff, &capacity, &region)) return false;
+    }
+    return true;
+}
+
+/**
+ * Character-level changes of base range -> side range (one conflict side)
+ * @return false on allocation failure
+ */
+static bool refine_conflict_side(const LineRange* base_range, const LineRange* side_range,
+                                 const char** base_lines, const int* base_lengths, int base_count,
+                                 const char** side_lines, const int* side_lengths, int side_count,
+                                 const CharLevelOptions* char_options, bool* hit_timeout,
+                                 RangeMapping** out_changes, int* out_count) {
+    SequenceDiff hunk = {
+        .seq1_start = base_range->start_line - 1,
+        .seq1_end = base_range->end_line - 1,
+        .seq2_start = side_range->start_line - 1,
+        .seq2_end = side_range->end_line - 1
+    };
+    bool local_timeout = false;
+    RangeMappingArray* changes = refine_diff_char_level_n(
+        &hunk,
+        base_lines, base_lengths, base_count,
+        side_lines, side_lengths, side_count,
+        char_options, &local_timeout);
+    if (local_timeout) *hit_timeout = true;
+    if (!changes) return false;
+
+    *out_changes = changes->mappings;
+    *out_count = changes->count;
+    diff_free(changes);  // The container; the mappings now belong to the region
+    return true;
+}
+
+static ThreeWayDiff* three_way_diff_steps(
+    const char** base_lines, const int* base_lengths, int base_count,
+    const char** ours_lines, const int* ours_lengths, int ours_count,
+    const char** theirs_lines, const int* theirs_lengths, int theirs_count,
+    const DiffOptions* options
+) {
+    Timeout timeout;
+    timeout_init(&timeout, options->max_computation_time_ms);
+
+    // One map for all three sides, complete before either alignment starts
+    DiffPhaseStart phase_start = diff_stats_phase_start();
+    StringHashMap* hash_map = string_hash_map_create();
+    if (!hash_map) return NULL;
+    ISequence* base = line_sequence_create_n(base_lines, base_lengths, base_count, true, hash_map);
+    ISequence* ours = line_sequence_create_n(ours_lines, ours_lengths, ours_count, true, hash_map);
+    ISequence* theirs = line_sequence_create_n(theirs_lines, theirs_lengths, theirs_count, true,
+                                               hash_map);
+    diff_stats_add_phase(DIFF_PHASE_LINE_HASH, phase_start);
+
+    // Same line options as compute_diff_n(); engine counts would be shared
+    // by both threads, so they are not reported
+    LineAlignmentOptions line_options = {
+        .anchor_unique_lines = options->anchor_unique_lines,
+        .threads = options->refine_threads,
+        .linear_space = options->linear_space_myers,
+        .engine = {
+            .dp_max_total = options->line_dp_max_lines,
+            .cost_model = options->cost_model_engine,
+            .dp_max_cells = options->dp_max_cells
+        }
+    };
+    SideAlignment jobs[2];
+    for (int i = 0; i < 2; i++) {
+        jobs[i].base = base;
+        jobs[i].side = i == 0 ? ours : theirs;
+        jobs[i].hash_count = string_hash_map_size(hash_map);
+        jobs[i].timeout_ms = timeout.timeout_ms;
+        jobs[i].options = &line_options;
+        jobs[i].cancel = diff_get_thread_cancel_flag();
+        jobs[i].memory_budget = diff_get_thread_memory_budget();
+        jobs[i].result = NULL;
+        jobs[i].hit_timeout = false;
+    }
+
+    phase_start = diff_stats_phase_start();
+    diff_thread_t worker;
+    bool threaded = diff_thread_create(&worker, side_alignment_worker, &jobs[1]);
+    run_side_alignment(&jobs[0]);
+    if (threaded) {
+        diff_thread_join(&worker);
+    } else {
+        run_side_alignment(&jobs[1]);
+    }
+    diff_stats_add_phase(DIFF_PHASE_LINE_DIFF, phase_start);
+
+    base->destroy(base);
+    ours->destroy(ours);
+    theirs->destroy(theirs);
+    string_hash_map_destroy(hash_map);
+
+    ThreeWayDiff* diff = (ThreeWayDiff*)diff_malloc(sizeof(ThreeWayDiff));
+    bool ok = diff && jobs[0].result && jobs[1].result;
+    if (diff) {
+        diff->regions = NULL;
+        diff->count = 0;
+        diff->hit_timeout = jobs[0].hit_timeout || jobs[1].hit_timeout;
+        diff->hit_memory_limit = false;
+    }
+    ok = ok && build_merge_regions(jobs[0].result, jobs[1].result,
+                                   ours_lines, ours_lengths, theirs_lines, theirs_lengths, diff);
+    free_sequence_diff_array(jobs[0].result);
+    free_sequence_diff_array(jobs[1].result);
+
+    // Character level, conflicts only
+    CharLevelOptions char_options = {
+        .consider_whitespace_changes = !options->ignore_trim_whitespace,
+        .extend_to_subwords = options->extend_to_subwords,
+        .timeout = &timeout,
+        .engine = {
+            .dp_max_total = options->char_dp_max_chars,
+            .cost_model = options->cost_model_engine,
+            .dp_max_cells = options->dp_max_cells
+        },
+        .token_min_chars = options->token_refine_min_chars
+    };
+    phase_start = diff_stats_phase_start();
+    for (int i = 0; ok && i < diff->count; i++) {
+        MergeRegion* region = &diff->regions[i];
+        if (region->kind != MERGE_REGION_CONFLICT) continue;
+        ok = refine_conflict_side(&region->base, &region->ours,
+                                  base_lines, base_lengths, base_count,
+                                  ours_lines, ours_lengths, ours_count,
+                                  &char_options, &diff->hit_timeout,
+                                  &region->ours_inner_changes, &region->ours_inner_change_count) &&
+             refine_conflict_side(&region->base, &region->theirs,
+                                  base_lines, base_lengths, base_count,
+                                  theirs_lines, theirs_lengths, theirs_count,
+                                  &char_options, &diff->hit_timeout,
+                                  &region->theirs_inner_changes,
+                                  &region->theirs_inner_change_count);
+    }
+    diff_stats_add_phase(DIFF_PHASE_CHAR_REFINE, phase_start);
+
+    if (!ok) {
+        free_three_way_diff(diff);
+        return NULL;
+    }
+    return diff;
+}
+
+ThreeWayDiff* compute_three_way_diff(
+    const char** base_lines, const int* base_lengths, int base_count,
+    const char** ours_lines, const int* ours_lengths, int ours_count,
+    const char** theirs_lines, const int* theirs_lengths, int theirs_count,
+    const DiffOptions* options
+) {
+    if ((!base_lines && base_count > 0) || (!ours_lines && ours_count > 0) ||
+        (!theirs_lines && theirs_count > 0) || !options) {
+        return NULL;
+    }
+
+    if (options->max_memory_bytes <= 0) {
+        return three_way_diff_steps(base_lines, base_lengths, base_count,
+                                    ours_lines, ours_lengths, ours_count,
+                                    theirs_lines, theirs_lengths, theirs_count, options);
+    }
+
+    // Not VSCode: steps degrade instead of exceeding max_memory_bytes
+    DiffMemoryBudget budget;
+    diff_memory_budget_init(&budget, options->max_memory_bytes);
+    DiffMemoryBudget* previous = diff_get_thread_memory_budget();
+    diff_set_thread_memory_budget(&budget);
+    ThreeWayDiff* result = three_way_diff_steps(base_lines, base_lengths, base_count,
+                                                ours_lines, ours_lengths, ours_count,
+                                                theirs_lines, theirs_lengths, theirs_count,
+                                                options);
+    diff_set_thread_memory_budget(previous);
+    if (result) {
+        result->hit_memory_limit = diff_memory_budget_exceeded(&budget);
+    }
+    return result;
+}
+
+void free_three_way_diff(ThreeWayDiff* diff) {
+    if (!diff) return;
+    for (int i = 0; i < diff->count; i++) {
+        diff_free(diff->regions[i].ours_inner_changes);
+        diff_free(diff->regions[i].theirs_inner_changes);
+    }
+    diff_free(diff->regions);
+    diff_free(diff);
+}
@@ -1,8 +1,17 @@
 #include "utf8_utils.h"
+#include "diff_allocator.h"
 #include <string.h>
 #include <stdlib.h>
 #include <utf8proc.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF8_SIMD_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UTF8_SIMD_NEON 1
+#endif
+
 // Get the number of bytes in a UTF-8 character starting at the given byte
 int utf8_char_bytes(const char* str, int byte_pos) {
     if (!str) return 0;
@@ -111,6 +120,20 @@ uint32_t utf8_decode_char(const char* str, int* byte_pos) {
     return (uint32_t)codepoint;
 }
 
+bool utf8_decode_char_n(const char* str, int byte_len, int* byte_pos, uint32_t* codepoint) {
+    if (!str || !byte_pos || *byte_pos >= byte_len) return false;
+    
+    utf8proc_int32_t cp;
+    const utf8proc_uint8_t* ustr = (const utf8proc_uint8_t*)str;
+    utf8proc_ssize_t bytes = utf8proc_iterate(ustr + *byte_pos, byte_len - *byte_pos, &cp);
+    
+    if (bytes <= 0) return false;
+    
+    *byte_pos += bytes;
+    *codepoint = (uint32_t)cp;
+    return true;
+}
+
 /**
  * Count UTF-16 code units in a UTF-8 string
  * This matches JavaScript string.length behavior:
@@ -142,6 +165,97 @@ int utf8_to_utf16_length(const char* str) {
     return utf16_len;
 }
 
+/**
+ * Length of the leading ASCII run: 16 bytes per step, then the scalar tail
+ * (and the scalar scan of the block that stopped the vector loop)
+ */
+int utf8_ascii_run_length(const char* str, int byte_len) {
+    if (!str || byte_len <= 0) return 0;
+    
+    const unsigned char* bytes = (const unsigned char*)str;
+    int i = 0;
+#if defined(UTF8_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= byte_len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(bytes + i));
+        // High bit set (non-ASCII) or NUL byte ends the run
+        int stop = _mm_movemask_epi8(block) | _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+        if (stop) break;
+    }
+#elif defined(UTF8_SIMD_NEON)
+    for (; i + 16 <= byte_len; i += 16) {
+        uint8x16_t block = vld1q_u8(bytes + i);
+        uint8x16_t stop = vorrq_u8(vcgeq_u8(block, vdupq_n_u8(0x80)), vceqq_u8(block, vdupq_n_u8(0)));
+        if (vmaxvq_u8(stop)) break;
+    }
+#endif
+    while (i < byte_len && bytes[i] != 0 && bytes[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+void utf8_widen_ascii(const char* str, int count, uint32_t* out) {
+    const unsigned char* bytes = (const unsigned char*)str;
+    int i = 0;
+#if defined(UTF8_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(bytes + i));
+        __m128i lo16 = _mm_unpacklo_epi8(block, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(block, zero);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(lo16, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(lo16, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(hi16, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(hi16, zero));
+    }
+#elif defined(UTF8_SIMD_NEON)
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t block = vld1q_u8(bytes + i);
+        uint16x8_t lo16 = vmovl_u8(vget_low_u8(block));
+        uint16x8_t hi16 = vmovl_u8(vget_high_u8(block));
+        vst1q_u32(out + i, vmovl_u16(vget_low_u16(lo16)));
+        vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(lo16)));
+        vst1q_u32(out + i + 8, vmovl_u16(vget_low_u16(hi16)));
+        vst1q_u32(out + i + 12, vmovl_u16(vget_high_u16(hi16)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = bytes[i];
+    }
+}
+
+/**
+ * Count UTF-16 code units in the first byte_len bytes of a UTF-8 string
+ * Stops early only at an invalid sequence; NUL bytes count as characters
+ */
+int utf8_to_utf16_length_n(const char* str, int byte_len) {
+    if (!str || byte_len <= 0) return 0;
+    
+    int utf16_len = 0;
+    int i = 0;
+    const utf8proc_uint8_t* ustr = (const utf8proc_uint8_t*)str;
+    
+    while (i < byte_len) {
+        // ASCII runs are one code unit per byte
+        int ascii = utf8_ascii_run_length(str + i, byte_len - i);
+        if (ascii > 0) {
+            i += ascii;
+            utf16_len += ascii;
+            continue;
+        }
+        
+        utf8proc_int32_t codepoint;
+        utf8proc_ssize_t bytes = utf8proc_iterate(ustr + i, byte_len - i, &codepoint);
+        if (bytes <= 0) break;
+        
+        i += bytes;
+        utf16_len += (codepoint <= 0xFFFF) ? 1 : 2;
+    }
+    
+    return utf16_len;
+}
+
 /**
  * Convert UTF-8 string to UTF-16 code units array
  * Returns malloc'd array that must be freed by caller
@@ -156,7 +270,7 @@ uint16_t* utf8_to_utf16(const char* str, int* out_length) {
     if (utf16_len == 0) return NULL;
     
     // Allocate array
-    uint16_t* utf16 = (uint16_t*)malloc(utf16_len * sizeof(uint16_t));
+    uint16_t* utf16 = (uint16_t*)diff_malloc(utf16_len * sizeof(uint16_t));
     if (!utf16) {
         *out_length = 0;
         return NULL;
@@ -219,3 +333,24 @@ int utf16_pos_to_utf8_byte(const char* str, int utf16_pos) {
     
     return utf8_byte;
 }
+
+int utf16_pos_to_utf8_byte_n(const char* str, int byte_len, int utf16_pos) {
+    if (!str || utf16_pos < 0 || byte_len <= 0) return 0;
+    
+    int utf8_byte = 0;
+    int current_utf16_pos = 0;
+    const utf8proc_uint8_t* ustr = (const utf8proc_uint8_t*)str;
+    
+    // Bounded by byte_len instead of the terminator, so embedded NULs are
+    // stepped over like any other character
+    while (utf8_byte < byte_len && current_utf16_pos < utf16_pos) {
+        utf8proc_int32_t codepoint;
+        utf8proc_ssize_t bytes = utf8proc_iterate(ustr + utf8_byte, byte_len - utf8_byte, &codepoint);
+        if (bytes <= 0) break;
+        
+        utf8_byte += bytes;
+        current_utf16_pos += codepoint <= 0xFFFF ? 1 : 2;
+    }
+    
+    return utf8_byte;
+}
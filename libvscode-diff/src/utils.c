@@ -5,6 +5,9 @@
 #include <stdint.h>
 #include <time.h>
 #include "types.h"
+#include "utils.h"
+#include "diff_allocator.h"
+#include "platform.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -43,14 +46,14 @@
  * @return true if ch is whitespace according to JavaScript /\s/
  */
 bool is_unicode_whitespace(uint32_t ch) {
-    // ASCII whitespace (most common, check first for performance)
-    if (ch == 0x0020 ||  // Space
-        ch == 0x0009 ||  // Tab
-        ch == 0x000A ||  // Line Feed (LF)
-        ch == 0x000B ||  // Vertical Tab
-        ch == 0x000C ||  // Form Feed
-        ch == 0x000D) {  // Carriage Return (CR)
-        return true;
+    // ASCII whitespace (most common, check first for performance):
+    // Space, Tab, LF, Vertical Tab, Form Feed, CR
+    if (ch < 0x80) {
+        return diff_is_ascii_whitespace(ch);
+    }
+    // Nothing between DEL and no-break space
+    if (ch < 0x00A0) {
+        return false;
     }
     
     // Unicode whitespace characters
@@ -78,7 +81,7 @@ bool is_unicode_whitespace(uint32_t ch) {
 
 // Safe memory allocation with error checking
 void* mem_alloc(size_t size) {
-    void* ptr = malloc(size);
+    void* ptr = diff_malloc(size);
     if (!ptr && size > 0) {
         fprintf(stderr, "Memory allocation failed: %zu bytes\n", size);
         exit(1);
@@ -88,7 +91,7 @@ void* mem_alloc(size_t size) {
 
 // Safe memory reallocation
 void* mem_realloc(void* ptr, size_t size) {
-    void* new_ptr = realloc(ptr, size);
+    void* new_ptr = diff_realloc(ptr, size);
     if (!new_ptr && size > 0) {
         fprintf(stderr, "Memory reallocation failed: %zu bytes\n", size);
         exit(1);
@@ -161,7 +164,7 @@ char* trim_string(const char* str) {
     
     // All whitespace?
     if (*start == '\0') {
-        char* result = (char*)malloc(1);
+        char* result = (char*)diff_malloc(1);
         if (result) result[0] = '\0';
         return result;
     }
@@ -174,7 +177,7 @@ char* trim_string(const char* str) {
     
     // Allocate and copy
     size_t len = end - start + 1;
-    char* result = (char*)malloc(len + 1);
+    char* result = (char*)diff_malloc(len + 1);
     if (result) {
         memcpy(result, start, len);
         result[len] = '\0';
@@ -182,6 +185,41 @@ char* trim_string(const char* str) {
     return result;
 }
 
+// ============================================================================
+// Line Lengths - NOT part of VSCode (JS strings carry their length)
+// ============================================================================
+
+/**
+ * Byte length of lines[index]: lengths[index] when a length array is given,
+ * strlen otherwise (NULL lines count as empty).
+ */
+int diff_line_length(const char** lines, const int* lengths, int index) {
+    if (lengths) return lengths[index];
+    return lines[index] ? (int)strlen(lines[index]) : 0;
+}
+
+/**
+ * Measure every line once, for callers that hold NUL-terminated lines but
+ * want to go through the length-aware entry points.
+ *
+ * @return malloc'd array of count lengths (NULL on allocation failure)
+ */
+int* diff_line_lengths_create(const char** lines, int count) {
+    int* lengths = (int*)diff_malloc(sizeof(int) * (count > 0 ? count : 1));
+    if (!lengths) return NULL;
+    for (int i = 0; i < count; i++) {
+        lengths[i] = lines[i] ? (int)strlen(lines[i]) : 0;
+    }
+    return lengths;
+}
+
+/**
+ * Exact byte comparison of two lines of known length (JS: a === b)
+ */
+bool diff_lines_equal(const char* a, int len_a, const char* b, int len_b) {
+    return len_a == len_b && (len_a == 0 || memcmp(a, b, (size_t)len_a) == 0);
+}
+
 /**
  * Get current time in milliseconds.
  * 
@@ -199,6 +237,87 @@ int64_t get_current_time_ms(void) {
     #endif
 }
 
+/**
+ * Monotonic clock in nanoseconds, for DiffStats phase timings.
+ */
+int64_t get_current_time_ns(void) {
+    #ifdef _WIN32
+        LARGE_INTEGER frequency;
+        LARGE_INTEGER counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        return (int64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+    #else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+    #endif
+}
+
+// ============================================================================
+// Timeout Functions
+// ============================================================================
+
+/**
+ * Start a timeout budget of timeout_ms milliseconds (0 = infinite).
+ * 
+ * VSCode Reference: DateTimeout / InfiniteTimeout in diffAlgorithm.ts
+ */
+void timeout_init(Timeout* timeout, int timeout_ms) {
+    timeout->timeout_ms = timeout_ms;
+    timeout->start_time_ms = get_current_time_ms();
+    timeout->cancel = diff_get_thread_cancel_flag();
+}
+
+/**
+ * Check whether the budget is still available (reads the wall clock).
+ * A cancelled timeout is never valid, even when infinite.
+ * 
+ * VSCode Reference: ITimeout.isValid()
+ */
+bool timeout_is_valid(const Timeout* timeout) {
+    if (!timeout) {
+        return true;
+    }
+    if (timeout->cancel && diff_cancel_flag_is_set(timeout->cancel)) {
+        return false;
+    }
+    if (timeout->timeout_ms <= 0) {
+        return true;
+    }
+    return get_current_time_ms() - timeout->start_time_ms < timeout->timeout_ms;
+}
+
+/**
+ * Remaining budget in milliseconds for a finite timeout (0 once expired).
+ * 
+ * Used to hand the shared budget to algorithms that take a timeout_ms.
+ * Callers must check timeout->timeout_ms > 0 first: 0 also means infinite.
+ */
+int timeout_remaining_ms(const Timeout* timeout) {
+    int64_t remaining = timeout->timeout_ms - (get_current_time_ms() - timeout->start_time_ms);
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+/**
+ * Amortized validity check for hot loops.
+ * 
+ * Adds `work` to *work_since_check and only reads the clock once the counter
+ * crosses TIMEOUT_CHECK_INTERVAL. Callers initialize the counter to
+ * TIMEOUT_CHECK_INTERVAL so the first call always checks.
+ */
+bool timeout_check_amortized(const Timeout* timeout, int* work_since_check, int work) {
+    if (!timeout || (timeout->timeout_ms <= 0 && !timeout->cancel)) {
+        return true;
+    }
+    *work_since_check += work;
+    if (*work_since_check < TIMEOUT_CHECK_INTERVAL) {
+        return true;
+    }
+    *work_since_check = 0;
+    return timeout_is_valid(timeout);
+}
+
 // ============================================================================
 // SequenceDiffArray Functions
 // ============================================================================
@@ -222,8 +341,8 @@ void sequence_diff_array_append(SequenceDiffArray* arr, SequenceDiff diff) {
 
 void sequence_diff_array_free(SequenceDiffArray* arr) {
     if (!arr) return;
-    free(arr->diffs);
-    free(arr);
+    diff_free(arr->diffs);
+    diff_free(arr);
 }
 
 // ============================================================================
@@ -240,8 +359,8 @@ RangeMappingArray* range_mapping_array_create(void) {
 
 void range_mapping_array_free(RangeMappingArray* arr) {
     if (!arr) return;
-    free(arr->mappings);
-    free(arr);
+    diff_free(arr->mappings);
+    diff_free(arr);
 }
 
 // ============================================================================
@@ -259,8 +378,182 @@ DetailedLineRangeMappingArray* detailed_line_range_mapping_array_create(void) {
 void detailed_line_range_mapping_array_free(DetailedLineRangeMappingArray* arr) {
     if (!arr) return;
     for (int i = 0; i < arr->count; i++) {
-        free(arr->mappings[i].inner_changes);
+        diff_free(arr->mappings[i].inner_changes);
     }
-    free(arr->mappings);
-    free(arr);
+    diff_free(arr->mappings);
+    diff_free(arr);
+}
+
+// ============================================================================
+// Cancellation
+// ============================================================================
+
+struct DiffCancelFlag {
+    diff_atomic_flag set;
+};
+
+static DIFF_THREAD_LOCAL const DiffCancelFlag* thread_cancel_flag = NULL;
+
+/**
+ * Create an unset cancellation flag (NULL on allocation failure).
+ */
+DiffCancelFlag* diff_cancel_flag_create(void) {
+    DiffCancelFlag* flag = (DiffCancelFlag*)diff_malloc(sizeof(DiffCancelFlag));
+    if (flag) {
+        diff_atomic_flag_init(&flag->set);
+    }
+    return flag;
+}
+
+void diff_cancel_flag_destroy(DiffCancelFlag* flag) {
+    diff_free(flag);
+}
+
+/**
+ * Request cancellation; safe to call from any thread.
+ */
+void diff_cancel_flag_set(DiffCancelFlag* flag) {
+    if (flag) {
+        diff_atomic_flag_set(&flag->set);
+    }
+}
+
+bool diff_cancel_flag_is_set(const DiffCancelFlag* flag) {
+    return flag && diff_atomic_flag_is_set(&flag->set);
+}
+
+/**
+ * Make timeouts started on the calling thread observe flag (NULL = none).
+ */
+void diff_set_thread_cancel_flag(const DiffCancelFlag* flag) {
+    thread_cancel_flag = flag;
+}
+
+const DiffCancelFlag* diff_get_thread_cancel_flag(void) {
+    return thread_cancel_flag;
+}
+
+// ============================================================================
+// Memory Budget
+// ============================================================================
+
+static DIFF_THREAD_LOCAL DiffMemoryBudget* thread_memory_budget = NULL;
+
+void diff_memory_budget_init(DiffMemoryBudget* budget, int64_t max_bytes) {
+    budget->max_bytes = max_bytes > 0 ? max_bytes : 0;
+    diff_atomic_flag_init(&budget->exceeded);
+}
+
+bool diff_memory_budget_exceeded(const DiffMemoryBudget* budget) {
+    return budget && diff_atomic_flag_is_set(&budget->exceeded);
+}
+
+/**
+ * Make diff_memory_fits() on the calling thread check budget (NULL = none).
+ */
+void diff_set_thread_memory_budget(DiffMemoryBudget* budget) {
+    thread_memory_budget = budget;
+}
+
+DiffMemoryBudget* diff_get_thread_memory_budget(void) {
+    return thread_memory_budget;
+}
+
+/**
+ * Whether a step needing `bytes` of working memory fits the calling thread's
+ * budget. A step that does not fit must degrade, so this also records that
+ * the budget was exceeded.
+ */
+bool diff_memory_fits(int64_t bytes) {
+    DiffMemoryBudget* budget = thread_memory_budget;
+    if (!budget || budget->max_bytes <= 0 || bytes <= budget->max_bytes) {
+        return true;
+    }
+    diff_atomic_flag_set(&budget->exceeded);
+    return false;
+}
+
+// ============================================================================
+// Diff Statistics
+// ============================================================================
+
+static DIFF_THREAD_LOCAL DiffStats* thread_stats = NULL;
+
+/**
+ * Collect statistics of the calling thread's diff work into stats (NULL = none).
+ */
+void diff_set_thread_stats(DiffStats* stats) {
+    thread_stats = stats;
+}
+
+DiffStats* diff_get_thread_stats(void) {
+    return thread_stats;
+}
+
+/**
+ * Clock for timing the whole call; 0 (no clock read) when nothing is collected.
+ */
+int64_t diff_stats_clock_ns(void) {
+    return thread_stats ? get_current_time_ns() : 0;
+}
+
+/**
+ * Start of a timed phase: clock and heap counters (zeros when nothing is
+ * collected).
+ */
+DiffPhaseStart diff_stats_phase_start(void) {
+    DiffPhaseStart start = { 0, 0, 0 };
+    DiffStats* stats = thread_stats;
+    if (stats) {
+        start.ns = get_current_time_ns();
+        start.heap_allocations = stats->heap_allocations;
+        start.heap_bytes = stats->heap_bytes;
+    }
+    return start;
+}
+
+void diff_stats_add_phase(DiffPhase phase, DiffPhaseStart start) {
+    DiffStats* stats = thread_stats;
+    if (stats) {
+        stats->phase_ns[phase] += get_current_time_ns() - start.ns;
+        stats->phase_heap_allocations[phase] += stats->heap_allocations - start.heap_allocations;
+        stats->phase_heap_bytes[phase] += stats->heap_bytes - start.heap_bytes;
+    }
+}
+
+void diff_stats_count_allocation(size_t bytes) {
+    DiffStats* stats = thread_stats;
+    if (stats) {
+        stats->scratch_allocations++;
+        stats->scratch_bytes += (int64_t)bytes;
+    }
+}
+
+void diff_stats_count_heap_allocation(size_t bytes) {
+    DiffStats* stats = thread_stats;
+    if (stats) {
+        stats->heap_allocations++;
+        stats->heap_bytes += (int64_t)bytes;
+    }
+}
+
+static void engine_counts_add(DiffEngineCounts* into, const DiffEngineCounts* from) {
+    into->dp += from->dp;
+    into->myers += from->myers;
+    into->linear += from->linear;
+}
+
+/**
+ * Add a worker's counters to into (phase timings stay with the caller).
+ */
+void diff_stats_merge(DiffStats* into, const DiffStats* from) {
+    engine_counts_add(&into->line_engines, &from->line_engines);
+    engine_counts_add(&into->char_engines, &from->char_engines);
+    into->dp_cells += from->dp_cells;
+    if (from->myers_max_d > into->myers_max_d) into->myers_max_d = from->myers_max_d;
+    into->hunks_refined += from->hunks_refined;
+    into->scratch_allocations += from->scratch_allocations;
+    into->scratch_bytes += from->scratch_bytes;
+    into->heap_allocations += from->heap_allocations;
+    into->heap_bytes += from->heap_bytes;
 }
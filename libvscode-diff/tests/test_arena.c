@@ -0,0 +1,97 @@
+/**
+ * Test Suite for the Per-Diff Arena Allocator
+ *
+ * Verifies:
+ * 1. Aligned bump allocation across block boundaries
+ * 2. Scratch realloc keeps contents (in place and by copy)
+ * 3. Reset reuses blocks instead of growing
+ * 4. Scratch API falls back to the C heap when no arena is installed
+ */
+
+#include "arena.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+TEST(aligned_allocation) {
+    DiffArena* arena = diff_arena_create(256);
+    assert(arena != NULL);
+
+    // Enough small allocations to span several blocks, plus one oversized
+    for (int i = 0; i < 100; i++) {
+        void* ptr = diff_arena_alloc(arena, (size_t)(i % 7) + 1);
+        assert(ptr != NULL);
+        assert(((uintptr_t)ptr % 16) == 0);
+        (void)ptr;
+    }
+    unsigned char* big = (unsigned char*)diff_arena_alloc(arena, 4096);
+    assert(big != NULL);
+    memset(big, 0xAB, 4096);
+
+    diff_arena_destroy(arena);
+}
+
+TEST(scratch_realloc_preserves_contents) {
+    DiffArena* arena = diff_arena_create(1024);
+    DiffArena* previous = diff_scratch_begin(arena);
+
+    // Most recent allocation: grows in place
+    int* values = (int*)diff_scratch_malloc(4 * sizeof(int));
+    for (int i = 0; i < 4; i++) values[i] = i;
+    int* grown = (int*)diff_scratch_realloc(values, 8 * sizeof(int));
+    assert(grown == values);
+    for (int i = 0; i < 4; i++) assert(grown[i] == i);
+
+    // Not the most recent allocation: copied
+    int* other = (int*)diff_scratch_calloc(4, sizeof(int));
+    for (int i = 0; i < 4; i++) assert(other[i] == 0);
+    int* moved = (int*)diff_scratch_realloc(grown, 512 * sizeof(int));
+    assert(moved != grown);
+    for (int i = 0; i < 4; i++) assert(moved[i] == i);
+
+    diff_scratch_free(moved);  // No-op inside an arena
+    diff_scratch_free(other);
+
+    diff_scratch_end(previous);
+    diff_arena_destroy(arena);
+}
+
+TEST(reset_reuses_blocks) {
+    DiffArena* arena = diff_arena_create(512);
+
+    for (int i = 0; i < 64; i++) diff_arena_alloc(arena, 100);
+    size_t capacity = diff_arena_capacity(arena);
+
+    // Same workload after reset must not reserve more memory
+    for (int round = 0; round < 10; round++) {
+        diff_arena_reset(arena);
+        for (int i = 0; i < 64; i++) diff_arena_alloc(arena, 100);
+    }
+    assert(diff_arena_capacity(arena) == capacity);
+    (void)capacity;
+
+    diff_arena_destroy(arena);
+}
+
+TEST(scratch_heap_fallback) {
+    // No arena installed: plain malloc/realloc/free semantics
+    char* text = (char*)diff_scratch_malloc(6);
+    memcpy(text, "hello", 6);
+    text = (char*)diff_scratch_realloc(text, 64);
+    assert(strcmp(text, "hello") == 0);
+    diff_scratch_free(text);
+}
+
+int main(void) {
+    printf("=== Arena Allocator Tests ===\n\n");
+
+    RUN_TEST(aligned_allocation);
+    RUN_TEST(scratch_realloc_preserves_contents);
+    RUN_TEST(reset_reuses_blocks);
+    RUN_TEST(scratch_heap_fallback);
+
+    printf("\n=== ALL ARENA TESTS PASSED ✓ ===\n");
+    return 0;
+}
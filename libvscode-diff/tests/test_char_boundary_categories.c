@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <assert.h>
 #include "sequence.h"
 #include "sequence.h"
 
@@ -158,6 +159,66 @@ static void test_linebreak_priority() {
     printf("✓ PASSED\n");
 }
 
+// Reference classification, written out as in VSCode's getCategory()
+enum { REF_LOWER, REF_UPPER, REF_NUMBER, REF_END, REF_OTHER, REF_SEPARATOR, REF_SPACE, REF_CR, REF_LF };
+
+static int reference_category(int c) {
+    if (c == '\n') return REF_LF;
+    if (c == '\r') return REF_CR;
+    if (c == ' ' || c == '\t') return REF_SPACE;
+    if (c >= 'a' && c <= 'z') return REF_LOWER;
+    if (c >= 'A' && c <= 'Z') return REF_UPPER;
+    if (c >= '0' && c <= '9') return REF_NUMBER;
+    if (c == -1) return REF_END;
+    if (c == ',' || c == ';') return REF_SEPARATOR;
+    return REF_OTHER;
+}
+
+static int reference_score(int prev_char, int next_char) {
+    static const int category_scores[] = {0, 0, 0, 10, 2, 30, 3, 10, 10};
+    int prev = reference_category(prev_char);
+    int next = reference_category(next_char);
+    if (prev == REF_CR && next == REF_LF) return 0;
+    if (prev == REF_LF) return 150;
+    int score = 0;
+    if (prev != next) {
+        score += 10;
+        if (prev == REF_LOWER && next == REF_UPPER) score += 1;
+    }
+    return score + category_scores[prev] + category_scores[next];
+}
+
+// Precomputed categories must score every ASCII pair like the reference
+static void test_precomputed_categories_match_reference() {
+    printf("\n=== Test: Precomputed Categories Match Reference ===\n");
+    
+    // Each byte 1..127 next to every other class, plus non-ASCII (U+00E9, U+4E2D)
+    char text[512];
+    int pos = 0;
+    for (int c = 1; c < 128; c++) {
+        text[pos++] = (char)c;
+        text[pos++] = (char)(128 - c);
+    }
+    const char tail[] = "a\xC3\xA9" "B\xE4\xB8\xAD,";
+    for (int i = 0; tail[i]; i++) text[pos++] = tail[i];
+    text[pos] = '\0';
+    
+    const char* lines[] = {text};
+    ISequence* seq = char_sequence_create(lines, 0, 1, true);
+    CharSequence* chars = (CharSequence*)seq->data;
+    int mismatches = 0;
+    for (int i = 0; i <= chars->length; i++) {
+        int prev = i > 0 ? (int)chars->elements[i - 1] : -1;
+        int next = i < chars->length ? (int)chars->elements[i] : -1;
+        if (seq->getBoundaryScore(seq, i) != reference_score(prev, next)) mismatches++;
+    }
+    printf("  %d positions checked, %d mismatches\n", chars->length + 1, mismatches);
+    assert(mismatches == 0);
+    
+    seq->destroy(seq);
+    printf("✓ PASSED\n");
+}
+
 int main(void) {
     printf("╔══════════════════════════════════════════════════════════════╗\n");
     printf("║  Character Boundary Category Scoring Tests                  ║\n");
@@ -168,6 +229,7 @@ int main(void) {
     test_separator_priorities();
     test_end_of_sequence();
     test_linebreak_priority();
+    test_precomputed_categories_match_reference();
     test_boundary_scores_at_positions("fooBar", "CamelCase Word");
     test_boundary_scores_at_positions("hello, world;", "Separators");
     
@@ -21,6 +21,7 @@
 #include "char_level.h"
 #include "types.h"
 #include "test_utils.h"
+#include "utils.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
@@ -598,6 +599,159 @@ TEST(delete_and_add) {
     
 }
 
+/**
+ * Test 13: Exhausted shared timeout
+ * 
+ * When the compute_diff budget is already spent, refinement must not run
+ * Myers at all: the region becomes one whole-range mapping and the timeout
+ * flag is reported (VSCode: DiffAlgorithmResult.trivial + hitTimeout).
+ */
+TEST(exhausted_timeout_falls_back) {
+    const char* lines_a[] = {"Hello world"};
+    const char* lines_b[] = {"Hello there"};
+    SequenceDiff line_diff = {0, 1, 0, 1};
+    
+    Timeout timeout = {
+        .timeout_ms = 1,
+        .start_time_ms = get_current_time_ms() - 1000
+    };
+    CharLevelOptions opts = {
+        .consider_whitespace_changes = true,
+        .extend_to_subwords = false,
+        .timeout = &timeout
+    };
+    
+    bool hit_timeout = false;
+    RangeMappingArray* result = refine_diff_char_level(&line_diff, lines_a, 1, lines_b, 1, &opts, &hit_timeout);
+    
+    ASSERT(result != NULL, "Result should not be NULL");
+    ASSERT(hit_timeout, "Timeout flag should be set");
+    ASSERT_EQ(result->count, 1, "Whole-range mapping");
+    
+    RangeMapping* m = &result->mappings[0];
+    ASSERT_EQ(m->original.start_col, 1, "Original start col");
+    ASSERT_EQ(m->original.end_col, 12, "Original end col");
+    ASSERT_EQ(m->modified.start_col, 1, "Modified start col");
+    ASSERT_EQ(m->modified.end_col, 12, "Modified end col");
+    
+    free_range_mapping_array(result);
+    
+}
+
+/**
+ * Test 14: Engine selection
+ * 
+ * A one-word change is small enough for VSCode's DP; a zero cutoff keeps
+ * the default, a cutoff of 1 forces O(ND), and both find the same change.
+ */
+TEST(engine_selection) {
+    const char* lines_a[] = {"int total = count + 1;"};
+    const char* lines_b[] = {"int total = amount + 1;"};
+    SequenceDiff line_diff = {0, 1, 0, 1};
+    
+    DiffEngineCounts counts = {0, 0, 0};
+    CharLevelOptions opts = {
+        .consider_whitespace_changes = true,
+        .extend_to_subwords = false,
+        .timeout = NULL,
+        .engine_counts = &counts
+    };
+    
+    bool hit_timeout = false;
+    RangeMappingArray* dp = refine_diff_char_level(&line_diff, lines_a, 1, lines_b, 1, &opts, &hit_timeout);
+    ASSERT_EQ(counts.dp, 1, "Default cutoff runs the DP");
+    ASSERT_EQ(counts.myers, 0, "No O(ND) run");
+    
+    opts.engine.dp_max_total = 1;
+    RangeMappingArray* nd = refine_diff_char_level(&line_diff, lines_a, 1, lines_b, 1, &opts, &hit_timeout);
+    ASSERT_EQ(counts.myers, 1, "Cutoff of 1 runs O(ND)");
+    
+    ASSERT(dp != NULL && nd != NULL, "Results should not be NULL");
+    ASSERT_EQ(dp->count, nd->count, "Same number of mappings");
+    for (int i = 0; i < dp->count; i++) {
+        ASSERT_EQ(dp->mappings[i].original.start_col, nd->mappings[i].original.start_col, "Same start");
+        ASSERT_EQ(dp->mappings[i].original.end_col, nd->mappings[i].original.end_col, "Same end");
+    }
+    
+    free_range_mapping_array(dp);
+    free_range_mapping_array(nd);
+}
+
+/**
+ * Whether the text outside the mappings of a one-line pair is equal on both
+ * sides (every mapping on line 1, in order)
+ */
+static bool unchanged_text_matches(const char* a, const char* b, const RangeMappingArray* result) {
+    int col_a = 1;
+    int col_b = 1;
+    for (int i = 0; i < result->count; i++) {
+        const RangeMapping* m = &result->mappings[i];
+        if (m->original.start_line != 1 || m->original.end_line != 1 ||
+            m->modified.start_line != 1 || m->modified.end_line != 1) return false;
+        int gap = m->original.start_col - col_a;
+        if (gap < 0 || m->modified.start_col - col_b != gap ||
+            memcmp(a + col_a - 1, b + col_b - 1, (size_t)gap) != 0) return false;
+        col_a = m->original.end_col;
+        col_b = m->modified.end_col;
+    }
+    return strcmp(a + col_a - 1, b + col_b - 1) == 0;
+}
+
+/**
+ * Test 15: Token-first refinement (not VSCode)
+ * 
+ * A one-token change gives the same mapping as the character diff; on a
+ * long minified line only the changed values are reported, and the text in
+ * between matches.
+ */
+TEST(token_first_refinement) {
+    const char* lines_a[] = {"int total = count + 1;"};
+    const char* lines_b[] = {"int total = amount + 1;"};
+    SequenceDiff line_diff = {0, 1, 0, 1};
+    
+    CharLevelOptions opts = {
+        .consider_whitespace_changes = true,
+        .extend_to_subwords = false,
+        .timeout = NULL
+    };
+    bool hit_timeout = false;
+    RangeMappingArray* chars = refine_diff_char_level(&line_diff, lines_a, 1, lines_b, 1, &opts, &hit_timeout);
+    opts.token_min_chars = 1;
+    RangeMappingArray* tokens = refine_diff_char_level(&line_diff, lines_a, 1, lines_b, 1, &opts, &hit_timeout);
+    ASSERT(chars != NULL && tokens != NULL, "Results should not be NULL");
+    ASSERT_EQ(tokens->count, chars->count, "Same number of mappings");
+    for (int i = 0; i < chars->count; i++) {
+        ASSERT(memcmp(&tokens->mappings[i], &chars->mappings[i], sizeof(RangeMapping)) == 0,
+               "Same mapping");
+    }
+    free_range_mapping_array(chars);
+    free_range_mapping_array(tokens);
+    
+    // ~60 KB of minified JSON with three changed values
+    enum { RECORDS = 2000, RECORD_MAX = 40 };
+    static char json_a[RECORDS * RECORD_MAX];
+    static char json_b[RECORDS * RECORD_MAX];
+    int len_a = 0;
+    int len_b = 0;
+    for (int i = 0; i < RECORDS; i++) {
+        len_a += snprintf(json_a + len_a, RECORD_MAX, "{\"id\":%d,\"name\":\"item%d\"},", i, i);
+        int value = (i == 10 || i == 1000 || i == 1990) ? i + 7 : i;
+        len_b += snprintf(json_b + len_b, RECORD_MAX, "{\"id\":%d,\"name\":\"item%d\"},", i, value);
+    }
+    const char* minified_a[] = {json_a};
+    const char* minified_b[] = {json_b};
+    DiffEngineCounts counts = {0, 0, 0};
+    opts.token_min_chars = 1000;
+    opts.engine_counts = &counts;
+    tokens = refine_diff_char_level(&line_diff, minified_a, 1, minified_b, 1, &opts, &hit_timeout);
+    ASSERT(tokens != NULL, "Result should not be NULL");
+    ASSERT(!hit_timeout, "No timeout");
+    ASSERT_EQ(tokens->count, 3, "One mapping per changed value");
+    ASSERT(unchanged_text_matches(json_a, json_b, tokens), "Text between mappings is equal");
+    ASSERT_EQ(counts.dp + counts.myers, 4, "One token diff, one char diff per changed token");
+    free_range_mapping_array(tokens);
+}
+
 // =============================================================================
 // Main Test Runner
 // =============================================================================
@@ -617,6 +771,9 @@ int main(void) {
     RUN_TEST(real_code_function_rename);
     RUN_TEST(cross_line_range_mapping);
     RUN_TEST(delete_and_add);
+    RUN_TEST(exhausted_timeout_falls_back);
+    RUN_TEST(engine_selection);
+    RUN_TEST(token_first_refinement);
     
     printf("\n");
     printf("=======================================================\n");
@@ -6,13 +6,16 @@
  * - Character-level refinement
  * - Whitespace change detection
  * - Line mapping conversion
+ * - Moved block detection (compute_moves)
  * 
  * VSCode Parity: Tests match VSCode's DefaultLinesDiffComputer behavior
  */
 
 #include "default_lines_diff_computer.h"
 #include "print_utils.h"
+#include "test_utils.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // ============================================================================
@@ -209,10 +212,389 @@ bool test_ignore_whitespace() {
     return true;
 }
 
+bool test_parallel_refinement_matches_sequential() {
+    printf("Running test_parallel_refinement_matches_sequential...\n");
+    
+    // Many independent hunks: word edits every 10th line, whitespace-only
+    // edits every 7th line
+    enum { LINE_COUNT = 600 };
+    static char original_buf[LINE_COUNT][48];
+    static char modified_buf[LINE_COUNT][48];
+    const char* original[LINE_COUNT];
+    const char* modified[LINE_COUNT];
+    
+    for (int i = 0; i < LINE_COUNT; i++) {
+        snprintf(original_buf[i], sizeof(original_buf[i]), "int value_%d = compute(%d);", i, i);
+        if (i % 10 == 0) {
+            snprintf(modified_buf[i], sizeof(modified_buf[i]), "int value_%d = refine(%d);", i, i * 2);
+        } else if (i % 7 == 0) {
+            snprintf(modified_buf[i], sizeof(modified_buf[i]), "int  value_%d = compute(%d);", i, i);
+        } else {
+            snprintf(modified_buf[i], sizeof(modified_buf[i]), "%s", original_buf[i]);
+        }
+        original[i] = original_buf[i];
+        modified[i] = modified_buf[i];
+    }
+    
+    DiffOptions options = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false,
+        .refine_threads = 0
+    };
+    
+    LinesDiff* sequential = compute_diff(original, LINE_COUNT, modified, LINE_COUNT, &options);
+    options.refine_threads = 4;
+    LinesDiff* parallel = compute_diff(original, LINE_COUNT, modified, LINE_COUNT, &options);
+    
+    ASSERT(sequential != NULL && parallel != NULL, "Results should not be NULL");
+    ASSERT(sequential->changes.count >= 60, "Should have one change per edited region");
+    ASSERT(lines_diff_equal(sequential, parallel), "Threaded result must match sequential");
+    
+    free_lines_diff(sequential);
+    free_lines_diff(parallel);
+    
+    printf("  ✓ PASSED\n");
+    return true;
+}
+
+static bool lines_equal(const char** a, LineRange ra, const char** b, LineRange rb) {
+    if (ra.end_line - ra.start_line != rb.end_line - rb.start_line) return false;
+    for (int i = 0; i < ra.end_line - ra.start_line; i++) {
+        if (strcmp(a[ra.start_line - 1 + i], b[rb.start_line - 1 + i]) != 0) return false;
+    }
+    return true;
+}
+
+bool test_compute_moves_relocated_function() {
+    printf("Running test_compute_moves_relocated_function...\n");
+    
+    // helper() moves from the top of the file to the bottom
+    const char* original[] = {
+        "static int helper(int value) {",
+        "    int doubled = value * 2;",
+        "    return doubled + 1;",
+        "}",
+        "int first(void) { return 1; }",
+        "int second(void) { return 2; }",
+        "int third(void) { return 3; }",
+        "int fourth(void) { return 4; }",
+        "int fifth(void) { return 5; }"
+    };
+    const char* modified[] = {
+        "int first(void) { return 1; }",
+        "int second(void) { return 2; }",
+        "int third(void) { return 3; }",
+        "int fourth(void) { return 4; }",
+        "int fifth(void) { return 5; }",
+        "static int helper(int value) {",
+        "    int doubled = value * 2;",
+        "    return doubled + 1;",
+        "}"
+    };
+    
+    DiffOptions options = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    
+    LinesDiff* without_moves = compute_diff(original, 9, modified, 9, &options);
+    ASSERT(without_moves != NULL, "Result should not be NULL");
+    ASSERT_EQ(without_moves->moves.count, 0, "Moves are only computed on request");
+    
+    options.compute_moves = true;
+    LinesDiff* result = compute_diff(original, 9, modified, 9, &options);
+    ASSERT(result != NULL, "Result should not be NULL");
+    print_lines_diff(result);
+    
+    ASSERT(line_changes_equal(result, without_moves), "Moves must not change the changes");
+    ASSERT_EQ(result->moves.count, 1, "Should detect the moved function");
+    const MovedText* move = &result->moves.moves[0];
+    ASSERT_EQ(move->original.end_line - move->original.start_line, 4, "Whole function moves");
+    ASSERT(lines_equal(original, move->original, modified, move->modified),
+           "Move must map identical lines");
+    ASSERT_EQ(move->change_count, 0, "Unedited move has no changes");
+    
+    free_lines_diff(without_moves);
+    free_lines_diff(result);
+    
+    printf("  ✓ PASSED\n");
+    return true;
+}
+
+bool test_compute_moves_edited_block() {
+    printf("Running test_compute_moves_edited_block...\n");
+    
+    // A block moves and one of its lines is edited on the way: it is still a
+    // move (histograms > 90% similar), and the edit shows up in move->changes
+    const char* original[] = {
+        "local function render(buffer, lines)",
+        "  for index, line in ipairs(lines) do",
+        "    vim.api.nvim_buf_set_lines(buffer, index - 1, index, false, { line })",
+        "  end",
+        "  return #lines",
+        "end",
+        "local a = 1",
+        "local b = 2",
+        "local c = 3",
+        "local d = 4",
+        "local e = 5",
+        "local f = 6",
+        "local g = 7",
+        "local h = 8"
+    };
+    const char* modified[] = {
+        "local a = 1",
+        "local b = 2",
+        "local c = 3",
+        "local d = 4",
+        "local e = 5",
+        "local f = 6",
+        "local g = 7",
+        "local h = 8",
+        "local function render(buffer, lines)",
+        "  for index, line in ipairs(lines) do",
+        "    vim.api.nvim_buf_set_lines(buffer, index - 1, index, true, { line })",
+        "  end",
+        "  return #lines",
+        "end"
+    };
+    
+    DiffOptions options = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = true,
+        .extend_to_subwords = false
+    };
+    
+    LinesDiff* result = compute_diff(original, 14, modified, 14, &options);
+    ASSERT(result != NULL, "Result should not be NULL");
+    print_lines_diff(result);
+    
+    ASSERT_EQ(result->moves.count, 1, "Should detect the edited move");
+    const MovedText* move = &result->moves.moves[0];
+    ASSERT_EQ(move->original.start_line, 1, "Move starts at the function");
+    ASSERT_EQ(move->original.end_line, 7, "Move covers the function");
+    ASSERT_EQ(move->modified.start_line, 9, "Move lands after the locals");
+    ASSERT_EQ(move->modified.end_line, 15, "Move covers the function");
+    ASSERT_EQ(move->change_count, 1, "The edited line is a change within the move");
+    ASSERT_EQ(move->changes[0].original.start_line, 3, "Change is on the edited line");
+    ASSERT_EQ(move->changes[0].modified.start_line, 11, "Change is on the edited line");
+    
+    free_lines_diff(result);
+    
+    printf("  ✓ PASSED\n");
+    return true;
+}
+
+bool test_memory_budget_degrades() {
+    printf("Running test_memory_budget_degrades...\n");
+    
+    // A hunk on a 2000-char line (~20 KB of char sequences) and a short one
+    static char long_original[2001];
+    static char long_modified[2001];
+    memset(long_original, 'x', 2000);
+    memcpy(long_modified, long_original, sizeof(long_original));
+    long_modified[1000] = 'y';
+    const char* original[] = {"start", long_original, "middle", "int a = 1;", "end"};
+    const char* modified[] = {"start", long_modified, "middle", "int a = 2;", "end"};
+    
+    DiffOptions options = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    LinesDiff* precise = compute_diff(original, 5, modified, 5, &options);
+    options.max_memory_bytes = 4096;
+    LinesDiff* result = compute_diff(original, 5, modified, 5, &options);
+    ASSERT(precise != NULL && result != NULL, "Result should not be NULL");
+    print_lines_diff(result);
+    
+    ASSERT(!precise->hit_memory_limit, "Unlimited diff should not hit the memory limit");
+    ASSERT(result->hit_memory_limit, "Budgeted diff should report the memory limit");
+    ASSERT_EQ(result->changes.count, 2, "Line-level changes are kept");
+    ASSERT_EQ(result->changes.mappings[0].original.start_line, 2, "First change is the long line");
+    ASSERT_EQ(result->changes.mappings[0].inner_change_count, 1, "Long line keeps one coarse change");
+    const RangeMapping* coarse = &result->changes.mappings[0].inner_changes[0];
+    ASSERT_EQ(coarse->modified.start_line, 2, "Coarse change covers the whole line");
+    ASSERT_EQ(coarse->modified.start_col, 1, "Coarse change covers the whole line");
+    ASSERT_EQ(coarse->modified.end_line, 3, "Coarse change ends at the next line");
+    ASSERT_EQ(coarse->modified.end_col, 1, "Coarse change ends at the next line");
+    ASSERT_EQ(result->changes.mappings[1].inner_change_count,
+              precise->changes.mappings[1].inner_change_count, "Short hunk is still refined");
+    ASSERT(memcmp(result->changes.mappings[1].inner_changes, precise->changes.mappings[1].inner_changes,
+                  sizeof(RangeMapping) * (size_t)result->changes.mappings[1].inner_change_count) == 0,
+           "Short hunk is refined as without a budget");
+    
+    free_lines_diff(precise);
+    free_lines_diff(result);
+    
+    printf("  ✓ PASSED\n");
+    return true;
+}
+
+bool test_stats_report_phases_and_counters() {
+    printf("Running test_stats_report_phases_and_counters...\n");
+    
+    // Word edits every 10th line, whitespace-only edits every 7th line
+    enum { LINE_COUNT = 600 };
+    static char original_buf[LINE_COUNT][48];
+    static char modified_buf[LINE_COUNT][48];
+    const char* original[LINE_COUNT];
+    const char* modified[LINE_COUNT];
+    for (int i = 0; i < LINE_COUNT; i++) {
+        snprintf(original_buf[i], sizeof(original_buf[i]), "int value_%d = compute(%d);", i, i);
+        if (i % 10 == 0) {
+            snprintf(modified_buf[i], sizeof(modified_buf[i]), "int value_%d = refine(%d);", i, i * 2);
+        } else if (i % 7 == 0) {
+            snprintf(modified_buf[i], sizeof(modified_buf[i]), "int  value_%d = compute(%d);", i, i);
+        } else {
+            snprintf(modified_buf[i], sizeof(modified_buf[i]), "%s", original_buf[i]);
+        }
+        original[i] = original_buf[i];
+        modified[i] = modified_buf[i];
+    }
+    
+    DiffOptions options = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    DiffStats stats;
+    LinesDiff* result = compute_diff_with_stats(original, LINE_COUNT, modified, LINE_COUNT,
+                                                &options, &stats);
+    ASSERT(result != NULL, "Result should not be NULL");
+    
+    int64_t phase_sum = 0;
+    for (int p = 0; p < DIFF_PHASE_COUNT; p++) phase_sum += stats.phase_ns[p];
+    ASSERT(stats.total_ns > 0 && phase_sum <= stats.total_ns, "Phases are timed within the total");
+    ASSERT(stats.phase_ns[DIFF_PHASE_MOVES] == 0, "Moves were not computed");
+    ASSERT_EQ(stats.line_engines.dp, 1, "1200 lines use the line DP");
+    ASSERT(stats.hunks_refined >= result->changes.count, "Every change was refined");
+    ASSERT_EQ(stats.char_engines.dp + stats.char_engines.myers, stats.hunks_refined,
+              "One char engine run per hunk");
+    ASSERT(stats.dp_cells >= (int64_t)LINE_COUNT * LINE_COUNT, "Line DP cells are counted");
+    ASSERT(stats.scratch_allocations > 0 && stats.scratch_bytes > 0, "Scratch allocations are counted");
+    ASSERT(!stats.hit_timeout && !stats.hit_memory_limit, "No timeout or memory limit");
+    
+    // Worker pools merge their counters into the same totals
+    options.refine_threads = 4;
+    DiffStats parallel;
+    LinesDiff* threaded = compute_diff_with_stats(original, LINE_COUNT, modified, LINE_COUNT,
+                                                  &options, &parallel);
+    ASSERT(threaded != NULL, "Result should not be NULL");
+    ASSERT_EQ(parallel.hunks_refined, stats.hunks_refined, "Same hunks with threads");
+    ASSERT_EQ(parallel.char_engines.dp, stats.char_engines.dp, "Same engines with threads");
+    ASSERT(parallel.dp_cells == stats.dp_cells, "Same DP cells with threads");
+    ASSERT(parallel.scratch_allocations == stats.scratch_allocations, "Same allocations with threads");
+    
+    free_lines_diff(result);
+    free_lines_diff(threaded);
+    
+    printf("  ✓ PASSED\n");
+    return true;
+}
+
 // ============================================================================
 // Test Runner
 // ============================================================================
 
+/** Copy lines back to back into one heap block with no terminators */
+static char* pack_lines(const char** lines, int count, const char** views, int* lengths) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) total += strlen(lines[i]);
+    char* block = (char*)malloc(total > 0 ? total : 1);
+    char* cursor = block;
+    for (int i = 0; i < count; i++) {
+        lengths[i] = (int)strlen(lines[i]);
+        memcpy(cursor, lines[i], (size_t)lengths[i]);
+        views[i] = cursor;
+        cursor += lengths[i];
+    }
+    return block;
+}
+
+bool test_compute_diff_n_lengths() {
+    printf("Running test_compute_diff_n_lengths...\n");
+    
+    // A moved block, a word edit and a whitespace-only edit
+    const char* original[] = {
+        "static int helper(int value) {",
+        "    int doubled = value * 2;",
+        "    return doubled + 1;",
+        "}",
+        "int first(void) { return 1; }",
+        "int second(void) { return 2; }",
+        "int third(void) {  return 3; }",
+        "int fourth(void) { return 4; }"
+    };
+    const char* modified[] = {
+        "int first(void) { return 1; }",
+        "int second(void) { return 22; }",
+        "int third(void) { return 3; }",
+        "int fourth(void) { return 4; }",
+        "static int helper(int value) {",
+        "    int doubled = value * 2;",
+        "    return doubled + 1;",
+        "}"
+    };
+    DiffOptions options = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = true,
+        .extend_to_subwords = false
+    };
+    
+    // Unterminated views into one block give the same diff as C strings
+    const char* original_views[8];
+    const char* modified_views[8];
+    int original_lengths[8];
+    int modified_lengths[8];
+    char* original_block = pack_lines(original, 8, original_views, original_lengths);
+    char* modified_block = pack_lines(modified, 8, modified_views, modified_lengths);
+    LinesDiff* expected = compute_diff(original, 8, modified, 8, &options);
+    LinesDiff* result = compute_diff_n(original_views, original_lengths, 8,
+                                       modified_views, modified_lengths, 8, &options);
+    ASSERT(expected != NULL && result != NULL, "Results should not be NULL");
+    ASSERT(lines_diff_equal(expected, result), "Length-aware diff must match compute_diff");
+    ASSERT_EQ(result->moves.count, expected->moves.count, "Moves are detected the same way");
+    ASSERT(result->moves.count > 0, "The block move is detected");
+    free_lines_diff(expected);
+    free_lines_diff(result);
+    free(original_block);
+    free(modified_block);
+    
+    // Embedded NULs are line content: these lines differ after the NUL
+    const char* nul_original[] = {"same", "ab\0cd", "tail"};
+    const char* nul_modified[] = {"same", "ab\0cx", "tail"};
+    int nul_lengths[] = {4, 5, 4};
+    options.compute_moves = false;
+    LinesDiff* as_strings = compute_diff(nul_original, 3, nul_modified, 3, &options);
+    ASSERT(as_strings != NULL, "Result should not be NULL");
+    ASSERT_EQ(as_strings->changes.count, 0, "As C strings the lines end at the NUL");
+    free_lines_diff(as_strings);
+    
+    result = compute_diff_n(nul_original, nul_lengths, 3, nul_modified, nul_lengths, 3, &options);
+    ASSERT(result != NULL, "Result should not be NULL");
+    print_lines_diff(result);
+    ASSERT_EQ(result->changes.count, 1, "The NUL-containing line changed");
+    ASSERT_EQ(result->changes.mappings[0].original.start_line, 2, "Change is on line 2");
+    ASSERT_EQ(result->changes.mappings[0].inner_change_count, 1, "One word changed");
+    ASSERT_EQ(result->changes.mappings[0].inner_changes[0].original.start_col, 4,
+              "Change is the word after the NUL");
+    ASSERT_EQ(result->changes.mappings[0].inner_changes[0].original.end_col, 6,
+              "Change ends at the end of the line");
+    free_lines_diff(result);
+    
+    printf("  ✓ PASSED\n");
+    return true;
+}
+
 int main(void) {
     printf("\n");
     printf("═══════════════════════════════════════════════════════════\n");
@@ -223,6 +605,8 @@ int main(void) {
     int passed = 0;
     int total = 0;
     
+    // Suite-local runner: these tests return bool instead of asserting
+    #undef RUN_TEST
     #define RUN_TEST(test) \
         do { \
             total++; \
@@ -235,6 +619,12 @@ int main(void) {
     RUN_TEST(test_multiline_diff);
     RUN_TEST(test_whitespace_changes);
     RUN_TEST(test_ignore_whitespace);
+    RUN_TEST(test_parallel_refinement_matches_sequential);
+    RUN_TEST(test_compute_moves_relocated_function);
+    RUN_TEST(test_compute_moves_edited_block);
+    RUN_TEST(test_memory_budget_degrades);
+    RUN_TEST(test_stats_report_phases_and_counters);
+    RUN_TEST(test_compute_diff_n_lengths);
     
     printf("═══════════════════════════════════════════════════════════\n");
     if (passed == total) {
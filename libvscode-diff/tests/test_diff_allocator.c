@@ -0,0 +1,197 @@
+/**
+ * Test Suite for the Library Allocator
+ *
+ * Verifies:
+ * 1. With a counting allocator installed, every allocation of a diff, render
+ *    plan, flat/packed copy, session and cache goes through it and is
+ *    released through it
+ * 2. DiffStats heap counters match the calls the allocator saw, and the
+ *    per-phase counters add up within them
+ * 3. Incomplete hooks are rejected; NULL restores the C heap
+ */
+
+#include "diff_allocator.h"
+#include "default_lines_diff_computer.h"
+#include "render_plan.h"
+#include "flat_lines_diff.h"
+#include "packed_lines_diff.h"
+#include "diff_session.h"
+#include "diff_cache.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/** Size-prefixed heap blocks, so frees of foreign pointers would show */
+typedef struct {
+    long long calls;
+    long long bytes;
+    long long live;
+} Counters;
+
+#define HEADER 16
+
+static void* counting_allocate(void* user_data, size_t size) {
+    Counters* counters = (Counters*)user_data;
+    unsigned char* raw = (unsigned char*)malloc(HEADER + size);
+    if (!raw) return NULL;
+    memcpy(raw, &size, sizeof(size));
+    counters->calls++;
+    counters->bytes += (long long)size;
+    counters->live++;
+    return raw + HEADER;
+}
+
+static void* counting_reallocate(void* user_data, void* ptr, size_t size) {
+    Counters* counters = (Counters*)user_data;
+    if (!ptr) return counting_allocate(user_data, size);
+    unsigned char* raw = (unsigned char*)realloc((unsigned char*)ptr - HEADER, HEADER + size);
+    if (!raw) return NULL;
+    memcpy(raw, &size, sizeof(size));
+    counters->calls++;
+    counters->bytes += (long long)size;
+    return raw + HEADER;
+}
+
+static void counting_release(void* user_data, void* ptr) {
+    Counters* counters = (Counters*)user_data;
+    if (!ptr) return;
+    counters->live--;
+    free((unsigned char*)ptr - HEADER);
+}
+
+static Counters counters;
+
+static void install_counting(void) {
+    memset(&counters, 0, sizeof(counters));
+    DiffAllocator allocator;
+    memset(&allocator, 0, sizeof(allocator));
+    allocator.allocate = counting_allocate;
+    allocator.reallocate = counting_reallocate;
+    allocator.release = counting_release;
+    allocator.user_data = &counters;
+    bool installed = diff_set_allocator(&allocator);
+    assert(installed);
+    (void)installed;
+}
+
+static const char* original[] = {
+    "function area(shape) {",
+    "    if (shape.kind === 'circle') {",
+    "        return Math.PI * shape.r * shape.r;",
+    "    }",
+    "    return shape.w * shape.h;",
+    "}",
+    "const total = shapes.map(area).reduce((a, b) => a + b, 0);",
+};
+static const char* modified[] = {
+    "const total = shapes.map(area).reduce((a, b) => a + b, 0);",
+    "function area(shape) {",
+    "    if (shape.kind === \"circle\") {",
+    "        return Math.PI * shape.radius ** 2;",
+    "    }",
+    "    return shape.width * shape.height;",
+    "}",
+};
+
+TEST(every_allocation_goes_through_hooks) {
+    install_counting();
+    DiffOptions options;
+    memset(&options, 0, sizeof(options));
+    options.compute_moves = true;
+
+    LinesDiff* diff = compute_diff(original, 7, modified, 7, &options);
+    RenderPlan* plan = generate_render_plan(diff, original, 7, modified, 7);
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    PackedLinesDiff* packed = pack_lines_diff(diff);
+    LinesDiff* unpacked = unpack_lines_diff(packed->data, packed->size);
+    assert(diff && plan && flat && packed && unpacked);
+
+    DiffSession* session = diff_session_create(original, 7, modified, 7, &options);
+    const char* edit[] = { "    return shape.w * shape.h * 1;" };
+    bool edited = session && diff_session_edit(session, DIFF_SIDE_MODIFIED, 5, 1, edit, 1) &&
+                  diff_session_recompute(session);
+    const LinesDiff* session_diff = edited ? diff_session_get_diff(session) : NULL;
+    DiffCache* cache = diff_cache_create(2, NULL);
+    LinesDiff* cached = diff_cache_compute(cache, original, 7, modified, 7, &options);
+    assert(session_diff && cached);
+    assert(counters.calls > 0 && counters.live > 0);
+    (void)edited;
+    (void)session_diff;
+
+    free_lines_diff(cached);
+    diff_cache_destroy(cache);
+    diff_session_destroy(session);
+    free_lines_diff(unpacked);
+    free_packed_lines_diff(packed);
+    free_flat_lines_diff(flat);
+    free_render_plan(plan);
+    free_lines_diff(diff);
+    printf("  %lld calls, %lld bytes, %lld live after freeing\n",
+           counters.calls, counters.bytes, counters.live);
+    assert(counters.live == 0);
+
+    diff_set_allocator(NULL);
+}
+
+TEST(stats_match_allocator_calls) {
+    install_counting();
+    DiffOptions options;
+    memset(&options, 0, sizeof(options));
+
+    DiffStats stats;
+    LinesDiff* diff = compute_diff_with_stats(original, 7, modified, 7, &options, &stats);
+    long long calls = counters.calls;
+    long long bytes = counters.bytes;
+    assert(diff != NULL);
+    printf("  %lld heap calls (%lld bytes), %lld scratch allocations\n",
+           (long long)stats.heap_allocations, (long long)stats.heap_bytes,
+           (long long)stats.scratch_allocations);
+
+    int64_t phase_calls = 0;
+    int64_t phase_bytes = 0;
+    for (int phase = 0; phase < DIFF_PHASE_COUNT; phase++) {
+        phase_calls += stats.phase_heap_allocations[phase];
+        phase_bytes += stats.phase_heap_bytes[phase];
+    }
+    bool matches = stats.heap_allocations == calls && stats.heap_bytes == bytes &&
+                   phase_calls > 0 && phase_calls <= calls && phase_bytes <= bytes &&
+                   stats.phase_heap_allocations[DIFF_PHASE_CHAR_REFINE] > 0;
+    assert(matches);
+    (void)matches;
+
+    free_lines_diff(diff);
+    assert(counters.live == 0);
+    diff_set_allocator(NULL);
+}
+
+TEST(incomplete_hooks_rejected) {
+    DiffAllocator allocator = diff_get_allocator();
+    allocator.release = NULL;
+    bool rejected = !diff_set_allocator(&allocator) && diff_get_allocator().release != NULL;
+    assert(rejected);
+    (void)rejected;
+
+    // Back on the C heap: plain calloc semantics, overflow refused
+    bool restored = diff_set_allocator(NULL);
+    int* zeros = (int*)diff_calloc(64, sizeof(int));
+    bool zeroed = zeros != NULL && zeros[0] == 0 && zeros[63] == 0;
+    assert(restored && zeroed);
+    assert(diff_calloc(SIZE_MAX / 2, 4) == NULL);
+    (void)restored;
+    (void)zeroed;
+    diff_free(zeros);
+    diff_free(NULL);
+}
+
+int main(void) {
+    printf("=== Library Allocator Tests ===\n\n");
+
+    RUN_TEST(every_allocation_goes_through_hooks);
+    RUN_TEST(stats_match_allocator_calls);
+    RUN_TEST(incomplete_hooks_rejected);
+
+    printf("\n=== ALL ALLOCATOR TESTS PASSED ✓ ===\n");
+    return 0;
+}
@@ -0,0 +1,205 @@
+/**
+ * Test Suite for the Diff Result Cache
+ *
+ * Verifies:
+ * 1. A repeated diff is served from memory and equals compute_diff()
+ * 2. Result-shaping options are part of the key, the timeout budget is not
+ * 3. The least recently used entry is evicted first
+ * 4. Evicted and destroyed-with entries come back from the spill directory
+ * 5. diff_cache_compute_n() keys and diffs lines with embedded NULs by their
+ *    full length
+ */
+
+#include "diff_cache.h"
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static const DiffOptions base_options = {
+    .ignore_trim_whitespace = false,
+    .max_computation_time_ms = 0,
+    .compute_moves = true,
+    .extend_to_subwords = false,
+    .refine_threads = 0,
+    .anchor_unique_lines = false
+};
+
+static const char* original[] = {"int a = 1;", "int b = 2;", "int c = 3;", "return a + b;"};
+static const char* modified[] = {"int a = 10;", "int b = 2;", "int d = 4;", "return a + b + d;"};
+
+/** Diff through the cache, compare with compute_diff() */
+static bool cached_matches(DiffCache* cache, const char** a, int a_count,
+                           const char** b, int b_count, const DiffOptions* options) {
+    LinesDiff* cached = diff_cache_compute(cache, a, a_count, b, b_count, options);
+    LinesDiff* expected = compute_diff(a, a_count, b, b_count, options);
+    bool equal = cached && expected && lines_diff_equal(cached, expected);
+    free_lines_diff(cached);
+    free_lines_diff(expected);
+    return equal;
+}
+
+TEST(repeated_diff_hits_memory) {
+    DiffCache* cache = diff_cache_create(4, NULL);
+    assert(cache != NULL);
+
+    bool equal = cached_matches(cache, original, 4, modified, 4, &base_options) &&
+                 cached_matches(cache, original, 4, modified, 4, &base_options);
+    assert(equal);
+    (void)equal;
+
+    DiffCacheStats stats = diff_cache_get_stats(cache);
+    assert(stats.misses == 1 && stats.hits == 1 && stats.entries == 1);
+
+    // Same bytes, different line split: a different key
+    const char* split[] = {"int a = 1;int b = 2;", "", "int c = 3;", "return a + b;"};
+    LinesDiff* diff = diff_cache_compute(cache, split, 4, modified, 4, &base_options);
+    free_lines_diff(diff);
+    stats = diff_cache_get_stats(cache);
+    assert(stats.misses == 2);
+    (void)stats;
+
+    diff_cache_destroy(cache);
+}
+
+TEST(options_shape_the_key) {
+    DiffCache* cache = diff_cache_create(4, NULL);
+    assert(cache != NULL);
+
+    DiffOptions options = base_options;
+    free_lines_diff(diff_cache_compute(cache, original, 4, modified, 4, &options));
+
+    // Budget and threads do not change a finished diff
+    options.max_computation_time_ms = 5000;
+    options.refine_threads = 4;
+    bool equal = cached_matches(cache, original, 4, modified, 4, &options);
+    assert(equal);
+    DiffCacheStats stats = diff_cache_get_stats(cache);
+    assert(stats.hits == 1 && stats.misses == 1);
+
+    options.ignore_trim_whitespace = true;
+    equal = cached_matches(cache, original, 4, modified, 4, &options);
+    assert(equal);
+    stats = diff_cache_get_stats(cache);
+    assert(stats.hits == 1 && stats.misses == 2);
+    (void)equal;
+    (void)stats;
+
+    diff_cache_destroy(cache);
+}
+
+TEST(evicts_least_recently_used) {
+    const char* a[] = {"alpha"};
+    const char* b[] = {"beta"};
+    const char* c[] = {"gamma"};
+    DiffCache* cache = diff_cache_create(2, NULL);
+    assert(cache != NULL);
+
+    free_lines_diff(diff_cache_compute(cache, a, 1, b, 1, &base_options));  // miss
+    free_lines_diff(diff_cache_compute(cache, b, 1, c, 1, &base_options));  // miss
+    free_lines_diff(diff_cache_compute(cache, a, 1, b, 1, &base_options));  // hit, a/b now newest
+    free_lines_diff(diff_cache_compute(cache, a, 1, c, 1, &base_options));  // miss, evicts b/c
+    free_lines_diff(diff_cache_compute(cache, a, 1, b, 1, &base_options));  // hit
+    free_lines_diff(diff_cache_compute(cache, b, 1, c, 1, &base_options));  // miss
+
+    DiffCacheStats stats = diff_cache_get_stats(cache);
+    assert(stats.hits == 2 && stats.misses == 4 && stats.entries == 2);
+    (void)stats;
+
+    diff_cache_clear(cache);
+    assert(diff_cache_get_stats(cache).entries == 0);
+    diff_cache_destroy(cache);
+    diff_cache_destroy(NULL);
+}
+
+TEST(embedded_nul_lines_keyed_by_length) {
+    // Equal up to the NUL, different after it
+    const char* a[] = {"int x;", "name\0old", "return x;"};
+    const char* b[] = {"int x;", "name\0new", "return x;"};
+    const int lengths[] = {6, 8, 9};
+    DiffCache* cache = diff_cache_create(4, NULL);
+    assert(cache != NULL);
+
+    LinesDiff* expected = compute_diff_n(a, lengths, 3, b, lengths, 3, &base_options);
+    LinesDiff* first = diff_cache_compute_n(cache, a, lengths, 3, b, lengths, 3, &base_options);
+    LinesDiff* second = diff_cache_compute_n(cache, a, lengths, 3, b, lengths, 3, &base_options);
+    bool equal = expected && first && second && expected->changes.count == 1 &&
+                 lines_diff_equal(first, expected) && lines_diff_equal(second, expected);
+    assert(equal);
+    (void)equal;
+
+    // Truncated at the NUL the sides are equal: a different key, no changes
+    LinesDiff* truncated = diff_cache_compute(cache, a, 3, b, 3, &base_options);
+    assert(truncated && truncated->changes.count == 0);
+    DiffCacheStats stats = diff_cache_get_stats(cache);
+    assert(stats.misses == 2 && stats.hits == 1 && stats.entries == 2);
+    (void)stats;
+
+    free_lines_diff(truncated);
+    free_lines_diff(second);
+    free_lines_diff(first);
+    free_lines_diff(expected);
+    diff_cache_destroy(cache);
+}
+
+#ifndef _WIN32
+TEST(spills_to_disk) {
+    char dir[] = "/tmp/vscode_diff_cache_XXXXXX";
+    char* created = mkdtemp(dir);
+    assert(created != NULL);
+    (void)created;
+
+    const char* other[] = {"unrelated"};
+    const char* third[] = {"third"};
+    DiffCache* cache = diff_cache_create(1, dir);
+    assert(cache != NULL);
+    free_lines_diff(diff_cache_compute(cache, original, 4, modified, 4, &base_options));
+    free_lines_diff(diff_cache_compute(cache, other, 1, modified, 4, &base_options));  // spills original
+
+    bool equal = cached_matches(cache, original, 4, modified, 4, &base_options);  // spills other
+    assert(equal);
+    DiffCacheStats stats = diff_cache_get_stats(cache);
+    assert(stats.disk_hits == 1 && stats.misses == 2);
+    free_lines_diff(diff_cache_compute(cache, third, 1, modified, 4, &base_options));
+    diff_cache_destroy(cache);  // spills third
+
+    // A fresh cache over the same directory finds all three
+    cache = diff_cache_create(3, dir);
+    assert(cache != NULL);
+    equal = cached_matches(cache, other, 1, modified, 4, &base_options) &&
+            cached_matches(cache, original, 4, modified, 4, &base_options) &&
+            cached_matches(cache, third, 1, modified, 4, &base_options);
+    assert(equal);
+    stats = diff_cache_get_stats(cache);
+    assert(stats.disk_hits == 3 && stats.misses == 0);
+    diff_cache_destroy(cache);
+    (void)equal;
+    (void)stats;
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf %s", dir);
+    int removed = system(command);
+    (void)removed;
+}
+#endif
+
+int main(void) {
+    printf("=== Diff Result Cache Tests ===\n\n");
+
+    RUN_TEST(repeated_diff_hits_memory);
+    RUN_TEST(options_shape_the_key);
+    RUN_TEST(evicts_least_recently_used);
+    RUN_TEST(embedded_nul_lines_keyed_by_length);
+#ifndef _WIN32
+    RUN_TEST(spills_to_disk);
+#endif
+
+    printf("\n=== ALL DIFF RESULT CACHE TESTS PASSED ✓ ===\n");
+    return 0;
+}
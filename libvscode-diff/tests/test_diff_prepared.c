@@ -0,0 +1,197 @@
+/**
+ * Test Suite for Prepared-Side Diffs
+ *
+ * Verifies:
+ * 1. compute_diff_prepared() matches compute_diff_n() with the prepared side
+ *    as original and as modified, across DP and O(ND) sizes and options
+ * 2. One prepared side reused against many revisions in a prepared batch,
+ *    whatever the thread count
+ * 3. Edge cases: empty sides, explicit lengths with embedded NULs
+ */
+
+#include "default_lines_diff_computer.h"
+#include "diff_batch.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static const DiffOptions prepared_options = {
+    .ignore_trim_whitespace = false,
+    .max_computation_time_ms = 0,
+    .compute_moves = false,
+    .extend_to_subwords = false,
+    .refine_threads = 0,
+    .anchor_unique_lines = false
+};
+
+enum { REVISIONS = 8, MAX_LINES = 2400 };
+static char base_pool[MAX_LINES][48];
+static const char* base_lines[MAX_LINES];
+static char rev_pool[REVISIONS][MAX_LINES][48];
+static const char* rev_lines[REVISIONS][MAX_LINES];
+static int rev_counts[REVISIONS];
+
+/**
+ * A base file and revisions of it: edits, inserted lines, whitespace-only
+ * changes and repeated lines (so unique-line anchoring has work to do)
+ */
+static void build_revisions(int base_count) {
+    for (int i = 0; i < base_count; i++) {
+        if (i % 11 == 0) {
+            snprintf(base_pool[i], sizeof(base_pool[i]), "}");
+        } else {
+            snprintf(base_pool[i], sizeof(base_pool[i]), "    statement %d;", i);
+        }
+        base_lines[i] = base_pool[i];
+    }
+    for (int r = 0; r < REVISIONS; r++) {
+        int count = 0;
+        for (int i = 0; i < base_count && count < MAX_LINES - 1; i++) {
+            char* line = rev_pool[r][count];
+            if (i % (r + 5) == 2) {
+                snprintf(line, 48, "    statement %d changed in %d;", i, r);
+            } else if (i % (r + 7) == 3) {
+                snprintf(line, 48, "\t%s  ", base_lines[i] + 4);
+            } else {
+                memcpy(line, base_pool[i], 48);
+            }
+            rev_lines[r][count] = line;
+            count++;
+            if (i % (r + 13) == 4 && count < MAX_LINES - 1) {
+                snprintf(rev_pool[r][count], 48, "inserted %d in revision %d", i, r);
+                rev_lines[r][count] = rev_pool[r][count];
+                count++;
+            }
+        }
+        rev_counts[r] = count - (r % 3);
+    }
+}
+
+/** Both sides of every revision against compute_diff_n() */
+static bool prepared_matches(int base_count, const DiffOptions* options) {
+    build_revisions(base_count);
+    DiffPreparedLines* prepared = diff_prepared_lines_create(base_lines, NULL, base_count);
+    if (!prepared) return false;
+    bool match = true;
+    for (int r = 0; r < REVISIONS; r++) {
+        LinesDiff* expected = compute_diff_n(base_lines, NULL, base_count,
+                                             rev_lines[r], NULL, rev_counts[r], options);
+        LinesDiff* actual = compute_diff_prepared(prepared, DIFF_PREPARED_ORIGINAL,
+                                                  rev_lines[r], NULL, rev_counts[r], options);
+        match = match && expected && actual && lines_diff_equal(expected, actual);
+        free_lines_diff(expected);
+        free_lines_diff(actual);
+
+        expected = compute_diff_n(rev_lines[r], NULL, rev_counts[r],
+                                  base_lines, NULL, base_count, options);
+        actual = compute_diff_prepared(prepared, DIFF_PREPARED_MODIFIED,
+                                       rev_lines[r], NULL, rev_counts[r], options);
+        match = match && expected && actual && lines_diff_equal(expected, actual);
+        free_lines_diff(expected);
+        free_lines_diff(actual);
+    }
+    diff_prepared_lines_destroy(prepared);
+    return match;
+}
+
+TEST(matches_compute_diff_both_sides) {
+    DiffOptions options = prepared_options;
+    bool match = prepared_matches(300, &options);      // DP path
+    assert(match);
+    match = prepared_matches(MAX_LINES - 200, &options);  // O(ND) path
+    assert(match);
+
+    options.ignore_trim_whitespace = true;
+    options.compute_moves = true;
+    match = prepared_matches(300, &options);
+    assert(match);
+
+    options = prepared_options;
+    options.anchor_unique_lines = true;
+    match = prepared_matches(MAX_LINES - 200, &options);
+    assert(match);
+    (void)match;
+}
+
+TEST(prepared_batch_reuses_one_side) {
+    int base_count = 1800;
+    build_revisions(base_count);
+    DiffPreparedLines* prepared = diff_prepared_lines_create(base_lines, NULL, base_count);
+    assert(prepared);
+
+    DiffBatchLines others[REVISIONS];
+    for (int r = 0; r < REVISIONS; r++) {
+        others[r].lines = rev_lines[r];
+        others[r].lengths = NULL;
+        others[r].count = rev_counts[r];
+    }
+
+    const int thread_counts[] = { 1, 3, 0 };
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        LinesDiff* results[REVISIONS];
+        bool ok = compute_diff_prepared_batch(prepared, DIFF_PREPARED_MODIFIED, others, REVISIONS,
+                                              &prepared_options, thread_counts[t], results);
+        bool match = ok;
+        for (int r = 0; r < REVISIONS; r++) {
+            LinesDiff* expected = compute_diff_n(rev_lines[r], NULL, rev_counts[r],
+                                                 base_lines, NULL, base_count, &prepared_options);
+            match = match && expected && results[r] && lines_diff_equal(expected, results[r]);
+            free_lines_diff(expected);
+            free_lines_diff(results[r]);
+        }
+        assert(match);
+        (void)match;
+    }
+
+    bool ok = compute_diff_prepared_batch(prepared, DIFF_PREPARED_ORIGINAL, NULL, 0,
+                                          &prepared_options, 0, NULL);
+    assert(ok);
+    (void)ok;
+    diff_prepared_lines_destroy(prepared);
+}
+
+TEST(empty_sides_and_explicit_lengths) {
+    // Empty prepared side, and an empty other side
+    const char* one[] = { "only" };
+    DiffPreparedLines* empty = diff_prepared_lines_create(NULL, NULL, 0);
+    assert(empty);
+    LinesDiff* expected = compute_diff_n(one, NULL, 0, one, NULL, 1, &prepared_options);
+    LinesDiff* actual = compute_diff_prepared(empty, DIFF_PREPARED_ORIGINAL, one, NULL, 1,
+                                              &prepared_options);
+    bool match = expected && actual && lines_diff_equal(expected, actual);
+    assert(match);
+    free_lines_diff(expected);
+    free_lines_diff(actual);
+    diff_prepared_lines_destroy(empty);
+
+    // Lines that only differ after an embedded NUL
+    const char base_text[] = "a\0x" "b\0y" "c";
+    const char other_text[] = "a\0x" "b\0z" "c";
+    const char* base[] = { base_text, base_text + 3, base_text + 6 };
+    const char* other[] = { other_text, other_text + 3, other_text + 6 };
+    const int lengths[] = { 3, 3, 1 };
+    DiffPreparedLines* prepared = diff_prepared_lines_create(base, lengths, 3);
+    assert(prepared);
+    expected = compute_diff_n(base, lengths, 3, other, lengths, 3, &prepared_options);
+    actual = compute_diff_prepared(prepared, DIFF_PREPARED_ORIGINAL, other, lengths, 3,
+                                   &prepared_options);
+    match = expected && actual && lines_diff_equal(expected, actual) &&
+            actual->changes.count == 1;
+    assert(match);
+    (void)match;
+    free_lines_diff(expected);
+    free_lines_diff(actual);
+    diff_prepared_lines_destroy(prepared);
+}
+
+int main(void) {
+    printf("=== Prepared-Side Diff Tests ===\n\n");
+
+    RUN_TEST(matches_compute_diff_both_sides);
+    RUN_TEST(prepared_batch_reuses_one_side);
+    RUN_TEST(empty_sides_and_explicit_lengths);
+
+    printf("\n=== ALL PREPARED-SIDE DIFF TESTS PASSED ✓ ===\n");
+    return 0;
+}
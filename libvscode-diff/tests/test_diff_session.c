@@ -0,0 +1,171 @@
+/**
+ * Test Suite for the Incremental Diff Session
+ *
+ * Verifies:
+ * 1. The initial diff is the compute_diff() result
+ * 2. Windowed re-diffs after edits on either side match a full compute_diff()
+ *    of the current text (distinct lines, so there is a single best alignment)
+ * 3. Edits at the file edges and edits that grow or remove whole changes
+ * 4. Invalid edits are rejected without touching the session
+ */
+
+#include "diff_session.h"
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static const DiffOptions default_options = {
+    .ignore_trim_whitespace = false,
+    .max_computation_time_ms = 0,
+    .compute_moves = false,
+    .extend_to_subwords = false,
+    .refine_threads = 0,
+    .anchor_unique_lines = false
+};
+
+/** Session diff == compute_diff() over the session's current lines */
+static bool session_matches_full_diff(const DiffSession* session) {
+    int original_count, modified_count;
+    const char* const* original = diff_session_get_lines(session, DIFF_SIDE_ORIGINAL, &original_count);
+    const char* const* modified = diff_session_get_lines(session, DIFF_SIDE_MODIFIED, &modified_count);
+    LinesDiff* full = compute_diff((const char**)original, original_count,
+                                   (const char**)modified, modified_count, &default_options);
+    bool equal = full && lines_diff_equal(diff_session_get_diff(session), full);
+    free_lines_diff(full);
+    return equal;
+}
+
+static char text_pool[4096][48];
+static int text_pool_used = 0;
+
+/** A line no other line in the test shares */
+static const char* unique_line(const char* prefix) {
+    char* line = text_pool[text_pool_used % 4096];
+    snprintf(line, sizeof(text_pool[0]), "%s statement_%d();", prefix, text_pool_used);
+    text_pool_used++;
+    return line;
+}
+
+TEST(initial_diff_matches_compute_diff) {
+    const char* original[] = {"alpha", "beta", "gamma", "delta"};
+    const char* modified[] = {"alpha", "BETA", "gamma", "delta", "epsilon"};
+
+    DiffSession* session = diff_session_create(original, 4, modified, 5, &default_options);
+    assert(session != NULL);
+    bool equal = session_matches_full_diff(session);
+    assert(equal);
+    assert(diff_session_get_diff(session)->changes.count == 2);
+    (void)equal;
+
+    diff_session_destroy(session);
+}
+
+TEST(edits_match_full_diff) {
+    enum { LINE_COUNT = 400 };
+    const char* original[LINE_COUNT];
+    const char* modified[LINE_COUNT];
+    for (int i = 0; i < LINE_COUNT; i++) {
+        original[i] = unique_line("    int");
+        // A few scattered changes the edits will run into
+        modified[i] = (i % 37 == 0) ? unique_line("    long") : original[i];
+    }
+
+    DiffSession* session = diff_session_create(original, LINE_COUNT, modified, LINE_COUNT, &default_options);
+    assert(session != NULL);
+
+    // Deterministic pseudo-random edits on both sides: replace, insert, delete
+    unsigned int seed = 12345;
+    for (int step = 0; step < 300; step++) {
+        seed = seed * 1103515245u + 12345u;
+        DiffSide side = (seed >> 16) % 4 == 0 ? DIFF_SIDE_ORIGINAL : DIFF_SIDE_MODIFIED;
+        int count;
+        diff_session_get_lines(session, side, &count);
+
+        int start = (int)((seed >> 8) % (unsigned int)(count + 1));
+        int old_count = (int)((seed >> 4) % 3);
+        if (start + old_count > count) old_count = count - start;
+        int new_count = (int)((seed >> 20) % 3);
+        const char* new_lines[2];
+        for (int k = 0; k < new_count; k++) {
+            new_lines[k] = unique_line(k == 0 ? "    edited" : "    added");
+        }
+
+        bool ok = diff_session_edit(session, side, start, old_count, new_lines, new_count);
+        assert(ok);
+        bool equal = session_matches_full_diff(session);
+        if (!equal) {
+            printf("  ✗ FAIL: step %d (side %d, start %d, -%d +%d) differs from compute_diff\n",
+                   step, side, start, old_count, new_count);
+        }
+        assert(equal);
+        (void)ok;
+        (void)equal;
+    }
+
+    diff_session_destroy(session);
+}
+
+TEST(edits_at_file_edges) {
+    const char* lines[30];
+    for (int i = 0; i < 30; i++) lines[i] = unique_line("local");
+
+    DiffSession* session = diff_session_create(lines, 30, lines, 30, &default_options);
+    assert(session != NULL);
+    assert(diff_session_get_diff(session)->changes.count == 0);
+
+    const char* first[] = {"-- header comment", "-- second header line"};
+    bool ok = diff_session_edit(session, DIFF_SIDE_MODIFIED, 0, 0, first, 2);
+    assert(ok);
+    assert(session_matches_full_diff(session));
+
+    const char* last[] = {"return M"};
+    ok = diff_session_edit(session, DIFF_SIDE_MODIFIED, 32, 0, last, 1);
+    assert(ok);
+    assert(session_matches_full_diff(session));
+
+    // Undo both edits: back to no changes
+    ok = diff_session_edit(session, DIFF_SIDE_MODIFIED, 0, 2, NULL, 0) &&
+         diff_session_edit(session, DIFF_SIDE_MODIFIED, 30, 1, NULL, 0);
+    assert(ok);
+    assert(diff_session_get_diff(session)->changes.count == 0);
+    (void)ok;
+
+    diff_session_destroy(session);
+}
+
+TEST(invalid_edits_rejected) {
+    const char* lines[] = {"one", "two", "three"};
+    DiffSession* session = diff_session_create(lines, 3, lines, 3, &default_options);
+    assert(session != NULL);
+
+    const char* replacement[] = {"TWO"};
+    bool ok = diff_session_edit(session, DIFF_SIDE_MODIFIED, 2, 2, replacement, 1);
+    assert(!ok);
+    ok = diff_session_edit(session, DIFF_SIDE_MODIFIED, -1, 0, replacement, 1);
+    assert(!ok);
+    ok = diff_session_edit(session, (DiffSide)7, 0, 0, replacement, 1);
+    assert(!ok);
+    (void)ok;
+
+    int count;
+    diff_session_get_lines(session, DIFF_SIDE_MODIFIED, &count);
+    assert(count == 3);
+    assert(diff_session_get_diff(session)->changes.count == 0);
+    (void)count;
+
+    diff_session_destroy(session);
+}
+
+int main(void) {
+    printf("=== Diff Session Tests ===\n\n");
+
+    RUN_TEST(initial_diff_matches_compute_diff);
+    RUN_TEST(edits_match_full_diff);
+    RUN_TEST(edits_at_file_edges);
+    RUN_TEST(invalid_edits_rejected);
+
+    printf("\n=== ALL DIFF SESSION TESTS PASSED ✓ ===\n");
+    return 0;
+}
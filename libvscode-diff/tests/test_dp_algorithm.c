@@ -207,6 +207,67 @@ void test_large_sequence_uses_myers() {
     printf("✓ PASSED\n");
 }
 
+void test_dp_near_line_cutoff() {
+    printf("\n=== Test: DP Near Line Cutoff (packed directions) ===\n");
+    
+    // 849 + 850 = 1699 lines: the largest input the line-level DP path sees
+    const int size_a = 849;
+    const int size_b = 850;
+    char (*storage_a)[32] = malloc(size_a * sizeof(*storage_a));
+    char (*storage_b)[32] = malloc(size_b * sizeof(*storage_b));
+    const char** lines_a = malloc(size_a * sizeof(char*));
+    const char** lines_b = malloc(size_b * sizeof(char*));
+    
+    // b = a with line 100 modified and one line inserted before a[500]
+    for (int i = 0; i < size_a; i++) {
+        snprintf(storage_a[i], sizeof(storage_a[i]), "line %d", i);
+        lines_a[i] = storage_a[i];
+    }
+    for (int i = 0, j = 0; i < size_b; i++) {
+        if (i == 500) {
+            snprintf(storage_b[i], sizeof(storage_b[i]), "inserted");
+        } else {
+            snprintf(storage_b[i], sizeof(storage_b[i]),
+                     j == 100 ? "line %d modified" : "line %d", j);
+            j++;
+        }
+        lines_b[i] = storage_b[i];
+    }
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq_a = line_sequence_create(lines_a, size_a, false, hash_map);
+    ISequence* seq_b = line_sequence_create(lines_b, size_b, false, hash_map);
+    
+    bool hit_timeout = false;
+    SequenceDiffArray* result_dp = myers_dp_diff_algorithm(seq_a, seq_b, 0, &hit_timeout, NULL, NULL);
+    SequenceDiffArray* result_nd = myers_nd_diff_algorithm(seq_a, seq_b, 0, &hit_timeout);
+    
+    printf("  DP result: %d diff(s)\n", result_dp->count);
+    assert(!hit_timeout);
+    assert(result_dp->count == 2);
+    assert(result_dp->diffs[0].seq1_start == 100 && result_dp->diffs[0].seq1_end == 101);
+    assert(result_dp->diffs[0].seq2_start == 100 && result_dp->diffs[0].seq2_end == 101);
+    assert(result_dp->diffs[1].seq1_start == 500 && result_dp->diffs[1].seq1_end == 500);
+    assert(result_dp->diffs[1].seq2_start == 500 && result_dp->diffs[1].seq2_end == 501);
+    assert(diffs_equal(result_dp, result_nd));
+    
+    printf("✓ DP matches O(ND) at the 1700-line cutoff\n");
+    
+    free(result_dp->diffs);
+    free(result_dp);
+    free(result_nd->diffs);
+    free(result_nd);
+    seq_a->destroy(seq_a);
+    seq_b->destroy(seq_b);
+    string_hash_map_destroy(hash_map);
+    free(lines_a);
+    free(lines_b);
+    free(storage_a);
+    free(storage_b);
+    
+    printf("✓ PASSED\n");
+}
+
 int main(void) {
     printf("=======================================================\n");
     printf("  DP Algorithm Selection Tests\n");
@@ -217,6 +278,7 @@ int main(void) {
     test_char_sequence_threshold();
     test_dp_with_equality_scoring();
     test_large_sequence_uses_myers();
+    test_dp_near_line_cutoff();
     
     printf("\n=======================================================\n");
     printf("  ALL DP ALGORITHM TESTS PASSED ✓\n");
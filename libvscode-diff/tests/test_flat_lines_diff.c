@@ -0,0 +1,204 @@
+/**
+ * Test Suite for the Flat FFI Result Buffer
+ *
+ * Verifies:
+ * 1. Every change, inner change and move of a LinesDiff survives packing
+ * 2. Changes of moved blocks follow the top-level changes
+ * 3. Empty diffs still carry a valid inner_offsets sentinel
+ * 4. Expanding and stream round trips give back the same diff
+ */
+
+#include "flat_lines_diff.h"
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static const DiffOptions move_options = {
+    .ignore_trim_whitespace = false,
+    .max_computation_time_ms = 0,
+    .compute_moves = true,
+    .extend_to_subwords = false,
+    .refine_threads = 0,
+    .anchor_unique_lines = false
+};
+
+static bool char_range_matches(const int* flat, const CharRange* range) {
+    return flat[0] == range->start_line && flat[1] == range->start_col &&
+           flat[2] == range->end_line && flat[3] == range->end_col;
+}
+
+static bool change_matches(const FlatLinesDiff* flat, int index, const DetailedLineRangeMapping* mapping) {
+    const int* c = &flat->changes[index * FLAT_CHANGE_STRIDE];
+    if (c[0] != mapping->original.start_line || c[1] != mapping->original.end_line ||
+        c[2] != mapping->modified.start_line || c[3] != mapping->modified.end_line) {
+        return false;
+    }
+
+    int first = flat->inner_offsets[index];
+    if (flat->inner_offsets[index + 1] - first != mapping->inner_change_count) return false;
+    for (int i = 0; i < mapping->inner_change_count; i++) {
+        const int* inner = &flat->inner_changes[(first + i) * FLAT_INNER_STRIDE];
+        if (!char_range_matches(inner, &mapping->inner_changes[i].original) ||
+            !char_range_matches(inner + 4, &mapping->inner_changes[i].modified)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool flat_matches(const FlatLinesDiff* flat, const LinesDiff* diff) {
+    if (flat->change_count != diff->changes.count || flat->move_count != diff->moves.count ||
+        flat->hit_timeout != (diff->hit_timeout ? 1 : 0) ||
+        flat->hit_memory_limit != (diff->hit_memory_limit ? 1 : 0)) {
+        return false;
+    }
+    for (int i = 0; i < diff->changes.count; i++) {
+        if (!change_matches(flat, i, &diff->changes.mappings[i])) return false;
+    }
+
+    int next_change = diff->changes.count;
+    for (int m = 0; m < diff->moves.count; m++) {
+        const MovedText* move = &diff->moves.moves[m];
+        const int* fm = &flat->moves[m * FLAT_MOVE_STRIDE];
+        if (fm[0] != move->original.start_line || fm[1] != move->original.end_line ||
+            fm[2] != move->modified.start_line || fm[3] != move->modified.end_line ||
+            fm[4] != next_change || fm[5] != move->change_count) {
+            return false;
+        }
+        for (int i = 0; i < move->change_count; i++) {
+            if (!change_matches(flat, next_change + i, &move->changes[i])) return false;
+        }
+        next_change += move->change_count;
+    }
+    return next_change == flat->total_change_count &&
+           flat->inner_offsets[flat->total_change_count] == flat->inner_change_count;
+}
+
+TEST(packs_changes_and_inner_changes) {
+    const char* original[] = {"int a = 1;", "int b = 2;", "int c = 3;", "return a + b;"};
+    const char* modified[] = {"int a = 10;", "int b = 2;", "int d = 4;", "int e = 5;", "return a + b + d;"};
+
+    LinesDiff* diff = compute_diff(original, 4, modified, 5, &move_options);
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    assert(diff != NULL && flat != NULL);
+    assert(flat->change_count > 0 && flat->inner_change_count > 0);
+    bool matches = flat_matches(flat, diff);
+    assert(matches);
+    (void)matches;
+
+    free_flat_lines_diff(flat);
+    free_lines_diff(diff);
+}
+
+TEST(moved_block_changes_follow_top_level) {
+    // Six statements moved below an 8-line function, one of them edited
+    const char* block[] = {
+        "function handle_request(request, response) {",
+        "    const headers = parse_headers(request.raw);",
+        "    const body = decode_body(request.body, headers);",
+        "    validate_payload(body, request.schema);",
+        "    const result = dispatch(request.route, body);",
+        "    response.write(serialize(result));",
+        "    log_request(request, result.status);",
+        "}",
+    };
+    const char* rest[] = {
+        "const a = alpha();", "const b = beta();", "const c = gamma();",
+        "const d = delta();", "const e = epsilon();", "const f = zeta();",
+    };
+    const char* original[14];
+    const char* modified[14];
+    for (int i = 0; i < 8; i++) original[i] = block[i];
+    for (int i = 0; i < 6; i++) original[8 + i] = rest[i];
+    for (int i = 0; i < 6; i++) modified[i] = rest[i];
+    for (int i = 0; i < 8; i++) modified[6 + i] = block[i];
+    modified[2] = "const c = gamma(options);";
+
+    LinesDiff* diff = compute_diff(original, 14, modified, 14, &move_options);
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    assert(diff != NULL && flat != NULL);
+    assert(flat->move_count == 1);
+    assert(flat->total_change_count > flat->change_count);
+    bool matches = flat_matches(flat, diff);
+    assert(matches);
+    (void)matches;
+
+    free_flat_lines_diff(flat);
+    free_lines_diff(diff);
+}
+
+TEST(identical_files_are_empty) {
+    const char* lines[] = {"same", "lines"};
+
+    FlatLinesDiff* flat = compute_diff_flat(lines, 2, lines, 2, &move_options);
+    assert(flat != NULL);
+    assert(flat->change_count == 0 && flat->total_change_count == 0);
+    assert(flat->inner_change_count == 0 && flat->move_count == 0);
+    assert(flat->inner_offsets[0] == 0);
+
+    free_flat_lines_diff(flat);
+    free_flat_lines_diff(NULL);
+}
+
+TEST(expand_and_stream_round_trip) {
+    const char* original[] = {"fn alpha() {}", "fn beta() {}", "fn gamma() {}", "fn delta() {}",
+                              "fn epsilon() {}", "fn zeta() {}", "let x = 1;"};
+    const char* modified[] = {"let x = 2;", "fn alpha() {}", "fn beta() {}", "fn gamma() {}",
+                              "fn delta(d) {}", "fn epsilon() {}", "fn zeta() {}"};
+
+    LinesDiff* diff = compute_diff(original, 7, modified, 7, &move_options);
+    assert(diff != NULL);
+    diff->hit_memory_limit = true;  // Flags survive both round trips
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    assert(flat != NULL);
+
+    LinesDiff* expanded = expand_flat_lines_diff(flat);
+    FlatLinesDiff* reflat = flatten_lines_diff(expanded);
+    assert(expanded != NULL && reflat != NULL);
+    bool matches = flat_matches(reflat, diff);
+    assert(matches);
+
+    FILE* stream = tmpfile();
+    assert(stream != NULL);
+    bool written = write_flat_lines_diff(flat, stream);
+    assert(written);
+    rewind(stream);
+    FlatLinesDiff* read_back = read_flat_lines_diff(stream);
+    assert(read_back != NULL);
+    matches = flat_matches(read_back, diff);
+    assert(matches);
+
+    // Truncated stream is rejected
+    rewind(stream);
+    FILE* truncated = tmpfile();
+    assert(truncated != NULL);
+    char buffer[16];
+    size_t got = fread(buffer, 1, sizeof(buffer), stream);
+    fwrite(buffer, 1, got, truncated);
+    rewind(truncated);
+    assert(read_flat_lines_diff(truncated) == NULL);
+    (void)matches;
+    (void)written;
+
+    fclose(truncated);
+    fclose(stream);
+    free_flat_lines_diff(read_back);
+    free_flat_lines_diff(reflat);
+    free_lines_diff(expanded);
+    free_flat_lines_diff(flat);
+    free_lines_diff(diff);
+}
+
+int main(void) {
+    printf("=== Flat Result Buffer Tests ===\n\n");
+
+    RUN_TEST(packs_changes_and_inner_changes);
+    RUN_TEST(moved_block_changes_follow_top_level);
+    RUN_TEST(identical_files_are_empty);
+    RUN_TEST(expand_and_stream_round_trip);
+
+    printf("\n=== ALL FLAT RESULT BUFFER TESTS PASSED ✓ ===\n");
+    return 0;
+}
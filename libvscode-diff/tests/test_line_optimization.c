@@ -16,6 +16,7 @@
  */
 
 #include "types.h"
+#include "line_level.h"
 #include "myers.h"
 #include "optimize.h"
 #include "sequence.h"
@@ -827,6 +828,363 @@ TEST(line_opt_delete_and_add) {
     free_diff_array(expected_final);
 }
 
+// ============================================================================
+// TEST 12: Large File, Common Prefix/Suffix Stripped
+// ============================================================================
+
+/**
+ * Full-sequence pipeline without prefix/suffix stripping (O(ND) path)
+ */
+static SequenceDiffArray* full_pipeline_nd(const char** lines_a, int len_a,
+                                           const char** lines_b, int len_b) {
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq1 = line_sequence_create(lines_a, len_a, true, hash_map);
+    ISequence* seq2 = line_sequence_create(lines_b, len_b, true, hash_map);
+    bool timeout = false;
+    SequenceDiffArray* result = run_step1_myers(seq1, seq2, &timeout);
+    result = optimize_sequence_diffs(seq1, seq2, result);
+    result = remove_very_short_matching_lines_between_diffs(seq1, seq2, result);
+    seq1->destroy(seq1);
+    seq2->destroy(seq2);
+    string_hash_map_destroy(hash_map);
+    return result;
+}
+
+TEST(line_opt_large_file_middle_edit) {
+    printf("=== Test 12: Large File, Edit in the Middle ===\n");
+    
+    // 1. SETUP: 2000 unique lines, line 1000 replaced and one line inserted
+    enum { N = 2000 };
+    static char text_a[N][16];
+    static const char* original[N];
+    static const char* modified[N + 1];
+    for (int i = 0; i < N; i++) {
+        snprintf(text_a[i], sizeof(text_a[i]), "line %d", i);
+        original[i] = text_a[i];
+    }
+    int len_b = 0;
+    for (int i = 0; i < N; i++) {
+        if (i == 1000) {
+            modified[len_b++] = "changed";
+            modified[len_b++] = "inserted";
+        } else {
+            modified[len_b++] = original[i];
+        }
+    }
+    
+    // 2. RUN: only lines 1000 differ; offsets must map back to the full files
+    bool timeout = false;
+    SequenceDiffArray* actual = compute_line_alignments(original, N, modified, len_b,
+                                                        5000, &timeout);
+    print_sequence_diff_array("compute_line_alignments", actual);
+    
+    SequenceDiffArray* expected = create_diff_array(10);
+    add_diff(expected, 1000, 1001, 1000, 1002);
+    assert_diffs_equal(actual, expected);
+    assert(!timeout);
+    printf("  ✓ Window offsets mapped back\n");
+    
+    // 5. CLEANUP
+    free_sequence_diff_array(actual);
+    free_diff_array(expected);
+}
+
+// ============================================================================
+// TEST 13: Shifting Across the Stripped Window Edge
+// ============================================================================
+
+TEST(line_opt_large_file_shift_at_window_edge) {
+    printf("=== Test 13: Shift Across Window Edge ===\n");
+    
+    // 1. SETUP: "}" "" block duplicated after line 900 - the inserted block
+    // is ambiguous and the stripped prefix ends inside the repetition
+    enum { N = 1800 };
+    static char text_a[N][16];
+    static const char* original[N];
+    static const char* modified[N + 2];
+    for (int i = 0; i < N; i++) {
+        snprintf(text_a[i], sizeof(text_a[i]), "    stmt %d;", i);
+        original[i] = text_a[i];
+    }
+    original[899] = "}";
+    original[900] = "";
+    int len_b = 0;
+    for (int i = 0; i < N; i++) {
+        modified[len_b++] = original[i];
+        if (i == 900) {
+            modified[len_b++] = "}";
+            modified[len_b++] = "";
+        }
+    }
+    
+    // 2. RUN: must match the unstripped pipeline exactly
+    bool timeout = false;
+    SequenceDiffArray* actual = compute_line_alignments(original, N, modified, len_b,
+                                                        5000, &timeout);
+    SequenceDiffArray* expected = full_pipeline_nd(original, N, modified, len_b);
+    print_sequence_diff_array("stripped", actual);
+    print_sequence_diff_array("full", expected);
+    assert_diffs_equal(actual, expected);
+    assert_diff_count(actual, 1);
+    printf("  ✓ Matches full-sequence optimization\n");
+    
+    // 5. CLEANUP
+    free_sequence_diff_array(actual);
+    free_sequence_diff_array(expected);
+}
+
+// ============================================================================
+// TEST 14: Unique-Line Anchoring (sequential and parallel)
+// ============================================================================
+
+TEST(line_opt_anchored_matches_unanchored) {
+    printf("=== Test 14: Unique-Line Anchoring ===\n");
+    
+    // 1. SETUP: 3000 lines of unique code plus repeated braces/blank lines,
+    // edited every 40 lines (replace, delete or insert)
+    enum { N = 3000 };
+    static char text_a[N][24];
+    static char text_b[N][24];
+    static const char* original[N];
+    static const char* modified[N * 2];
+    for (int i = 0; i < N; i++) {
+        if (i % 5 == 4) {
+            original[i] = (i % 10 == 4) ? "}" : "";
+        } else {
+            snprintf(text_a[i], sizeof(text_a[i]), "    call_%d();", i);
+            original[i] = text_a[i];
+        }
+    }
+    int len_b = 0;
+    for (int i = 0; i < N; i++) {
+        switch (i % 120) {
+            case 10:
+                snprintf(text_b[i], sizeof(text_b[i]), "    edited_%d();", i);
+                modified[len_b++] = text_b[i];
+                break;
+            case 50:
+                break;  // deleted
+            case 90:
+                modified[len_b++] = "    // inserted";
+                modified[len_b++] = original[i];
+                break;
+            default:
+                modified[len_b++] = original[i];
+                break;
+        }
+    }
+    
+    // 2. RUN: anchoring only splits at lines Myers would match anyway here
+    bool timeout = false;
+    SequenceDiffArray* expected = compute_line_alignments(original, N, modified, len_b,
+                                                          0, &timeout);
+    
+    LineAlignmentOptions options = { .anchor_unique_lines = true, .threads = 0 };
+    SequenceDiffArray* sequential = compute_line_alignments_with_options(
+        original, N, modified, len_b, 0, &options, &timeout);
+    options.threads = 4;
+    SequenceDiffArray* parallel = compute_line_alignments_with_options(
+        original, N, modified, len_b, 0, &options, &timeout);
+    
+    printf("  unanchored: %d diffs, anchored: %d, parallel: %d\n",
+           expected->count, sequential->count, parallel->count);
+    assert_diffs_equal(sequential, expected);
+    assert_diffs_equal(parallel, expected);
+    assert(!timeout);
+    printf("  ✓ Anchored gaps give the same line alignments\n");
+    
+    // 5. CLEANUP
+    free_sequence_diff_array(expected);
+    free_sequence_diff_array(sequential);
+    free_sequence_diff_array(parallel);
+}
+
+// ============================================================================
+// TEST 15: DP Scoring Tells Apart Same-Length Whitespace Variants
+// ============================================================================
+
+TEST(line_opt_dp_score_whitespace_frames) {
+    printf("=== Test 15: DP Score, Whitespace Variants ===\n");
+    
+    // 1. SETUP: " foo();" and "\tfoo();" have the same trimmed hash and the
+    // same length; only the exact match may get the full equality score
+    const char* original[] = {"int x;", "\tfoo();", "}"};
+    const char* modified[] = {"int x;", " foo();", "\tfoo();", "}"};
+    
+    // 2. RUN: the exact line is matched, the space variant is the insertion
+    bool timeout = false;
+    SequenceDiffArray* actual = compute_line_alignments(original, 3, modified, 4, 0, &timeout);
+    print_sequence_diff_array("compute_line_alignments", actual);
+    
+    SequenceDiffArray* expected = create_diff_array(10);
+    add_diff(expected, 1, 1, 1, 2);
+    assert_diffs_equal(actual, expected);
+    printf("  ✓ Exact match preferred\n");
+    
+    // 5. CLEANUP
+    free_sequence_diff_array(actual);
+    free_diff_array(expected);
+}
+
+// ============================================================================
+// TEST 16: Engine Selection (VSCode cutoff, custom cutoff, cost model)
+// ============================================================================
+
+TEST(line_opt_engine_selection) {
+    printf("=== Test 16: Engine Selection ===\n");
+    
+    // 1. SETUP: 2000 lines with one edited line in the middle
+    enum { N = 2000 };
+    static char text[N][24];
+    static const char* original[N];
+    static const char* modified[N];
+    for (int i = 0; i < N; i++) {
+        snprintf(text[i], sizeof(text[i]), "line_%d();", i);
+        original[i] = text[i];
+        modified[i] = text[i];
+    }
+    modified[N / 2] = "edited();";
+    
+    // 2. RUN: VSCode's cutoff sends 4000 lines to O(ND)
+    bool timeout = false;
+    DiffEngineCounts counts = {0, 0, 0};
+    LineAlignmentOptions options = { .engine_counts = &counts };
+    SequenceDiffArray* fixed = compute_line_alignments_with_options(
+        original, N, modified, N, 0, &options, &timeout);
+    assert(counts.myers == 1 && counts.dp == 0);
+    
+    // A raised cutoff keeps it on the DP
+    counts = (DiffEngineCounts){0, 0, 0};
+    options.engine.dp_max_total = 2 * N + 1;
+    SequenceDiffArray* raised = compute_line_alignments_with_options(
+        original, N, modified, N, 0, &options, &timeout);
+    assert(counts.dp == 1 && counts.myers == 0);
+    
+    // The cost model sizes the 1 x 1 window left after the common affixes
+    counts = (DiffEngineCounts){0, 0, 0};
+    options.engine = (DiffEngineThresholds){ .cost_model = true };
+    SequenceDiffArray* modeled = compute_line_alignments_with_options(
+        original, N, modified, N, 0, &options, &timeout);
+    assert(counts.dp == 1 && counts.myers == 0);
+    
+    // 3. VERIFY: every engine finds the one replaced line
+    SequenceDiffArray* expected = create_diff_array(10);
+    add_diff(expected, N / 2, N / 2 + 1, N / 2, N / 2 + 1);
+    assert_diffs_equal(fixed, expected);
+    assert_diffs_equal(raised, expected);
+    assert_diffs_equal(modeled, expected);
+    assert(!timeout);
+    printf("  ✓ myers (fixed cutoff), dp (raised cutoff), dp (cost model)\n");
+    
+    // A cell budget below the window keeps the cost model off the DP
+    counts = (DiffEngineCounts){0, 0, 0};
+    options.engine.dp_max_cells = 1;
+    const char* short_side[] = {"other();"};
+    SequenceDiffArray* capped = compute_line_alignments_with_options(
+        original, 2, short_side, 1, 0, &options, &timeout);
+    assert(counts.myers == 1 && counts.dp == 0);
+    printf("  ✓ dp_max_cells bounds the DP\n");
+    
+    // 5. CLEANUP
+    free_sequence_diff_array(fixed);
+    free_sequence_diff_array(raised);
+    free_sequence_diff_array(modeled);
+    free_sequence_diff_array(capped);
+    free_diff_array(expected);
+}
+
+// ============================================================================
+// TEST 17: Gap Whitespace Counting (ASCII and UTF-8 kernels)
+// ============================================================================
+
+/** removeVeryShort on a 6-line change, a gap of text (line 7), a 1-line change */
+static bool gap_joins(const char* gap, bool expect_ascii) {
+    const char* lines[] = {"a", "b", "c", "d", "e", "f", gap, "g"};
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq = line_sequence_create(lines, 8, false, hash_map);
+    bool ascii_matches = ((LineSequence*)seq->data)->ascii == expect_ascii;
+    
+    SequenceDiffArray* diffs = create_diff_array(10);
+    add_diff(diffs, 0, 6, 0, 6);
+    add_diff(diffs, 7, 8, 7, 8);
+    remove_very_short_matching_lines_between_diffs(seq, seq, diffs);
+    bool joined = diffs->count == 1;
+    
+    seq->destroy(seq);
+    string_hash_map_destroy(hash_map);
+    free_diff_array(diffs);
+    assert(ascii_matches);
+    (void)ascii_matches;
+    return joined;
+}
+
+TEST(line_opt_gap_whitespace_kernels) {
+    printf("=== Test 17: Gap Whitespace, ASCII and UTF-8 ===\n");
+    
+    // ASCII: \t \v \f \r and spaces are whitespace, 4 other chars still join
+    bool short_ascii = gap_joins(" \t a; \v\f\r cd ", true);
+    bool long_ascii = gap_joins(" a b c d e ", true);
+    assert(short_ascii && !long_ascii);
+    printf("  ✓ ASCII gaps\n");
+    
+    // UTF-8: U+3000 and U+00A0 are whitespace (JS \s), accented letters not
+    bool short_utf8 = gap_joins("\xE3\x80\x80x\xC2\xA0y\xE3\x80\x80", false);
+    bool long_utf8 = gap_joins("\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9", false);
+    assert(short_utf8 && !long_utf8);
+    (void)short_ascii; (void)long_ascii; (void)short_utf8; (void)long_utf8;
+    printf("  ✓ UTF-8 gaps\n");
+}
+
+// ============================================================================
+// TEST 18: Post-Processing Passes Work In Place
+// ============================================================================
+
+TEST(line_opt_passes_in_place) {
+    printf("=== Test 18: Passes Keep the Input Array ===\n");
+    
+    // 1. SETUP: 4000 unique lines, every third one replaced - 1333 diffs
+    // separated by 2-line gaps that neither shifting nor gap rules join
+    enum { N = 4000 };
+    static char text_a[N][16];
+    static char text_b[N][16];
+    static const char* original[N];
+    static const char* modified[N];
+    SequenceDiffArray* diffs = create_diff_array(N);
+    for (int i = 0; i < N; i++) {
+        snprintf(text_a[i], sizeof(text_a[i]), "line %d", i);
+        snprintf(text_b[i], sizeof(text_b[i]), i % 3 == 2 ? "edit %d" : "line %d", i);
+        original[i] = text_a[i];
+        modified[i] = text_b[i];
+        if (i % 3 == 2) add_diff(diffs, i, i + 1, i, i + 1);
+    }
+    int count = diffs->count;
+    const SequenceDiff* buffer = diffs->diffs;
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq1 = line_sequence_create(original, N, false, hash_map);
+    ISequence* seq2 = line_sequence_create(modified, N, false, hash_map);
+    
+    // 2. RUN: optimize and removeVeryShort keep every diff, in the same array
+    optimize_sequence_diffs(seq1, seq2, diffs);
+    remove_very_short_matching_lines_between_diffs(seq1, seq2, diffs);
+    assert(diffs->diffs == buffer && diffs->count == count);
+    printf("  ✓ %d diffs kept without a copy\n", count);
+    
+    // removeShortMatches joins across every 2-line gap, still in place
+    remove_short_matches(seq1, seq2, diffs);
+    assert(diffs->diffs == buffer && diffs->count == 1);
+    assert(diffs->diffs[0].seq1_start == 2 && diffs->diffs[0].seq1_end == N - 1);
+    printf("  ✓ Joined into one diff in place\n");
+    (void)count;
+    (void)buffer;
+    
+    // 5. CLEANUP
+    seq1->destroy(seq1);
+    seq2->destroy(seq2);
+    string_hash_map_destroy(hash_map);
+    free_diff_array(diffs);
+}
+
 // ============================================================================
 // Main Test Runner
 // ============================================================================
@@ -849,6 +1207,13 @@ int main(void) {
     RUN_TEST(line_opt_mixed_changes);
     RUN_TEST(line_opt_multiline_string);
     RUN_TEST(line_opt_delete_and_add);
+    RUN_TEST(line_opt_large_file_middle_edit);
+    RUN_TEST(line_opt_large_file_shift_at_window_edge);
+    RUN_TEST(line_opt_anchored_matches_unanchored);
+    RUN_TEST(line_opt_dp_score_whitespace_frames);
+    RUN_TEST(line_opt_engine_selection);
+    RUN_TEST(line_opt_gap_whitespace_kernels);
+    RUN_TEST(line_opt_passes_in_place);
     
     printf("\n");
     printf("=======================================================\n");
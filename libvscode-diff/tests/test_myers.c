@@ -1,5 +1,7 @@
 #include "types.h"
 #include "myers.h"
+#include "string_hash_map.h"
+#include "utils.h"
 #include "print_utils.h"
 #include "test_utils.h"
 #include <stdio.h>
@@ -297,6 +299,408 @@ void test_delete_and_add() {
     free(result);
 }
 
+void test_nd_timeout() {
+    printf("\n=== Test: O(ND) Wall-Clock Timeout ===\n");
+    // Two large, completely different files: far more work than 1ms allows
+    const int size = 20000;
+    char (*storage)[24] = malloc(2 * size * sizeof(*storage));
+    const char** lines_a = malloc(size * sizeof(char*));
+    const char** lines_b = malloc(size * sizeof(char*));
+    for (int i = 0; i < size; i++) {
+        snprintf(storage[i], sizeof(storage[i]), "a%d", i);
+        snprintf(storage[size + i], sizeof(storage[i]), "b%d", i);
+        lines_a[i] = storage[i];
+        lines_b[i] = storage[size + i];
+    }
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq_a = line_sequence_create(lines_a, size, false, hash_map);
+    ISequence* seq_b = line_sequence_create(lines_b, size, false, hash_map);
+    
+    bool hit_timeout = false;
+    SequenceDiffArray* result = myers_nd_diff_algorithm(seq_a, seq_b, 1, &hit_timeout);
+    
+    assert(hit_timeout);
+    assert_diff_count(result, 1);
+    ASSERT_DIFF(result, 0, 0,size, 0,size);  // Trivial diff on timeout
+    
+    printf("✓ PASSED\n");
+    
+    free(result->diffs);
+    free(result);
+    seq_a->destroy(seq_a);
+    seq_b->destroy(seq_b);
+    string_hash_map_destroy(hash_map);
+    free(lines_a);
+    free(lines_b);
+    free(storage);
+}
+
+static bool diff_arrays_same(const SequenceDiffArray* a, const SequenceDiffArray* b) {
+    if (a->count != b->count) return false;
+    return a->count == 0 || memcmp(a->diffs, b->diffs, sizeof(SequenceDiff) * a->count) == 0;
+}
+
+void test_generic_sequence_fallback() {
+    printf("\n=== Test: Dense Kernels vs getElement() Fallback ===\n");
+    // Long runs of equal lines (snakes across many 8-element blocks), two
+    // edited blocks and a trailing deletion
+    enum { SIZE = 400 };
+    char storage[2 * SIZE][16];
+    const char* lines_a[SIZE];
+    const char* lines_b[SIZE];
+    for (int i = 0; i < SIZE; i++) {
+        snprintf(storage[i], sizeof(storage[i]), "l%d", i / 2);
+        lines_a[i] = storage[i];
+        if (i % 37 == i % 8) {
+            snprintf(storage[SIZE + i], sizeof(storage[i]), "x%d", i);
+            lines_b[i] = storage[SIZE + i];
+        } else {
+            lines_b[i] = lines_a[i];
+        }
+    }
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq_a = line_sequence_create(lines_a, SIZE, false, hash_map);
+    ISequence* seq_b = line_sequence_create(lines_b, SIZE - 3, false, hash_map);
+    
+    // Same sequences without the dense accessor
+    ISequence generic_a = *seq_a;
+    ISequence generic_b = *seq_b;
+    generic_a.getElements = NULL;
+    generic_b.getElements = NULL;
+    
+    bool hit_timeout = false;
+    SequenceDiffArray* nd_dense = myers_nd_diff_algorithm(seq_a, seq_b, 0, &hit_timeout);
+    SequenceDiffArray* nd_generic = myers_nd_diff_algorithm(&generic_a, &generic_b, 0, &hit_timeout);
+    SequenceDiffArray* dp_dense = myers_dp_diff_algorithm(seq_a, seq_b, 0, &hit_timeout, NULL, NULL);
+    SequenceDiffArray* dp_generic = myers_dp_diff_algorithm(&generic_a, &generic_b, 0, &hit_timeout, NULL, NULL);
+    
+    bool nd_same = diff_arrays_same(nd_dense, nd_generic);
+    bool dp_same = diff_arrays_same(dp_dense, dp_generic);
+    assert(nd_dense->count > 1);
+    assert(nd_same);
+    assert(dp_same);
+    (void)nd_same;
+    (void)dp_same;
+    
+    printf("✓ PASSED (%d O(ND) diffs, %d DP diffs)\n", nd_dense->count, dp_dense->count);
+    
+    SequenceDiffArray* results[] = {nd_dense, nd_generic, dp_dense, dp_generic};
+    for (int i = 0; i < 4; i++) {
+        free(results[i]->diffs);
+        free(results[i]);
+    }
+    seq_a->destroy(seq_a);
+    seq_b->destroy(seq_b);
+    string_hash_map_destroy(hash_map);
+}
+
+/** Equality score of 1: the scored DP pass with the unscored recurrence */
+static double unit_equality_score(const ISequence* seq1, const ISequence* seq2,
+                                  int offset1, int offset2, void* user_data) {
+    (void)seq1; (void)seq2; (void)offset1; (void)offset2; (void)user_data;
+    return 1.0;
+}
+
+void test_dp_match_masks_match_scored_pass() {
+    printf("\n=== Test: Unscored DP (match masks) vs Scored DP ===\n");
+    // Lengths around the 64-column word boundaries, small alphabets so that
+    // run-length bonuses and ties decide the alignment
+    static const char* alphabet[] = {"a", "b", "c", "d", "e", "f"};
+    const int sizes[] = {1, 2, 63, 64, 65, 130, 250};
+    unsigned int seed = 777;
+    int cases = 0;
+    
+    for (int si = 0; si < 7; si++) {
+        for (int sj = 0; sj < 7; sj++) {
+            for (int symbols = 2; symbols <= 6; symbols += 4) {
+                int len_a = sizes[si];
+                int len_b = sizes[sj];
+                const char** a = malloc(sizeof(char*) * (size_t)len_a);
+                const char** b = malloc(sizeof(char*) * (size_t)len_b);
+                for (int i = 0; i < len_a; i++) {
+                    seed = seed * 1103515245u + 12345u;
+                    a[i] = alphabet[(seed >> 16) % (unsigned int)symbols];
+                }
+                for (int i = 0; i < len_b; i++) {
+                    seed = seed * 1103515245u + 12345u;
+                    b[i] = (i < len_a && (seed >> 16) % 4 != 0) ? a[i] : alphabet[(seed >> 20) % (unsigned int)symbols];
+                }
+                
+                StringHashMap* hash_map = string_hash_map_create();
+                ISequence* seq_a = line_sequence_create(a, len_a, false, hash_map);
+                ISequence* seq_b = line_sequence_create(b, len_b, false, hash_map);
+                
+                bool hit_timeout = false;
+                SequenceDiffArray* masked = myers_dp_diff_algorithm(seq_a, seq_b, 0, &hit_timeout, NULL, NULL);
+                SequenceDiffArray* scored = myers_dp_diff_algorithm(seq_a, seq_b, 0, &hit_timeout,
+                                                                    unit_equality_score, NULL);
+                bool same = diff_arrays_same(masked, scored);
+                assert(same);
+                (void)same;
+                cases++;
+                
+                free(masked->diffs);
+                free(masked);
+                free(scored->diffs);
+                free(scored);
+                seq_a->destroy(seq_a);
+                seq_b->destroy(seq_b);
+                string_hash_map_destroy(hash_map);
+                free(a);
+                free(b);
+            }
+        }
+    }
+    
+    printf("✓ PASSED (%d cases: identical diffs)\n", cases);
+}
+
+/** Sum of both sides of every diff: the edit distance for a minimal diff */
+static int diff_cost(const SequenceDiffArray* diffs) {
+    int cost = 0;
+    for (int i = 0; i < diffs->count; i++) {
+        cost += (diffs->diffs[i].seq1_end - diffs->diffs[i].seq1_start) +
+                (diffs->diffs[i].seq2_end - diffs->diffs[i].seq2_start);
+    }
+    return cost;
+}
+
+/**
+ * Diffs are ordered, separated by at least one match, and everything
+ * outside them matches pairwise
+ */
+static bool diff_shape_valid(const SequenceDiffArray* diffs, const char** a, int len_a,
+                             const char** b, int len_b) {
+    int pos_a = 0;
+    int pos_b = 0;
+    for (int i = 0; i <= diffs->count; i++) {
+        int end_a = i < diffs->count ? diffs->diffs[i].seq1_start : len_a;
+        int end_b = i < diffs->count ? diffs->diffs[i].seq2_start : len_b;
+        if (end_a - pos_a != end_b - pos_b || end_a < pos_a) return false;
+        if (i > 0 && i < diffs->count && end_a == pos_a) return false;  // Touching diffs
+        for (; pos_a < end_a; pos_a++, pos_b++) {
+            if (strcmp(a[pos_a], b[pos_b]) != 0) return false;
+        }
+        if (i < diffs->count) {
+            pos_a = diffs->diffs[i].seq1_end;
+            pos_b = diffs->diffs[i].seq2_end;
+        }
+    }
+    return true;
+}
+
+void test_linear_space_matches_nd() {
+    printf("\n=== Test: Linear-Space Myers vs Forward O(ND) ===\n");
+    // Random edits over a small alphabet (many equal-cost alternatives),
+    // plus one pair large enough for the halves to run on worker threads
+    static const char* alphabet[] = {"a", "b", "c", "d", "e", "f"};
+    const int sizes[] = {0, 1, 7, 60, 500, 20000};
+    unsigned int seed = 12345;
+    int cases = 0;
+    
+    for (int si = 0; si < 6; si++) {
+        for (int variant = 0; variant < 3; variant++) {
+            int len_a = sizes[si];
+            int len_b = variant == 0 ? len_a : (variant == 1 ? len_a / 2 : len_a + 3);
+            const char** a = malloc(sizeof(char*) * (size_t)(len_a + 1));
+            const char** b = malloc(sizeof(char*) * (size_t)(len_b + 1));
+            for (int i = 0; i < len_a; i++) {
+                seed = seed * 1103515245u + 12345u;
+                a[i] = alphabet[(seed >> 16) % 6];
+            }
+            unsigned int edit_rate = len_a > 1000 ? 64 : 8;
+            for (int i = 0; i < len_b; i++) {
+                seed = seed * 1103515245u + 12345u;
+                // Mostly copies of a (long snakes), sometimes a random element
+                b[i] = (i < len_a && (seed >> 16) % edit_rate != 0) ? a[i] : alphabet[(seed >> 20) % 6];
+            }
+            
+            StringHashMap* hash_map = string_hash_map_create();
+            ISequence* seq_a = line_sequence_create(a, len_a, false, hash_map);
+            ISequence* seq_b = line_sequence_create(b, len_b, false, hash_map);
+            
+            bool hit_timeout = false;
+            SequenceDiffArray* nd = myers_nd_diff_algorithm(seq_a, seq_b, 0, &hit_timeout);
+            SequenceDiffArray* linear = myers_linear_diff_algorithm(seq_a, seq_b, 0, 1, &hit_timeout);
+            SequenceDiffArray* parallel = myers_linear_diff_algorithm(seq_a, seq_b, 0, 4, &hit_timeout);
+            
+            bool same_cost = diff_cost(nd) == diff_cost(linear);
+            bool valid = diff_shape_valid(linear, a, len_a, b, len_b);
+            bool deterministic = diff_arrays_same(linear, parallel);
+            assert(!hit_timeout);
+            assert(same_cost);
+            assert(valid);
+            assert(deterministic);
+            (void)same_cost;
+            (void)valid;
+            (void)deterministic;
+            cases++;
+            
+            SequenceDiffArray* results[] = {nd, linear, parallel};
+            for (int i = 0; i < 3; i++) {
+                free(results[i]->diffs);
+                free(results[i]);
+            }
+            seq_a->destroy(seq_a);
+            seq_b->destroy(seq_b);
+            string_hash_map_destroy(hash_map);
+            free(a);
+            free(b);
+        }
+    }
+    
+    printf("✓ PASSED (%d cases: same edit distance, valid shape, same result with threads)\n", cases);
+}
+
+void test_linear_space_timeout() {
+    printf("\n=== Test: Linear-Space Myers Timeout ===\n");
+    const int size = 20000;
+    char (*storage)[24] = malloc(2 * size * sizeof(*storage));
+    const char** lines_a = malloc(size * sizeof(char*));
+    const char** lines_b = malloc(size * sizeof(char*));
+    for (int i = 0; i < size; i++) {
+        snprintf(storage[i], sizeof(storage[i]), "a%d", i);
+        snprintf(storage[size + i], sizeof(storage[i]), "b%d", i);
+        lines_a[i] = storage[i];
+        lines_b[i] = storage[size + i];
+    }
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq_a = line_sequence_create(lines_a, size, false, hash_map);
+    ISequence* seq_b = line_sequence_create(lines_b, size, false, hash_map);
+    
+    bool hit_timeout = false;
+    SequenceDiffArray* result = myers_linear_diff_algorithm(seq_a, seq_b, 1, 2, &hit_timeout);
+    
+    assert(hit_timeout);
+    assert_diff_count(result, 1);
+    ASSERT_DIFF(result, 0, 0,size, 0,size);  // Trivial diff on timeout
+    
+    printf("✓ PASSED\n");
+    
+    free(result->diffs);
+    free(result);
+    seq_a->destroy(seq_a);
+    seq_b->destroy(seq_b);
+    string_hash_map_destroy(hash_map);
+    free(lines_a);
+    free(lines_b);
+    free(storage);
+}
+
+void test_engine_cost_model() {
+    printf("\n=== Test: Engine Cost Model ===\n");
+    // 1699 x 1 (VSCode's DP cutoff treats it like 850 x 850): cheap for the DP
+    // because nearly every line is an edit
+    enum { SIZE = 1699 };
+    char storage[SIZE][16];
+    const char* lines_a[SIZE];
+    for (int i = 0; i < SIZE; i++) {
+        snprintf(storage[i], sizeof(storage[i]), "l%d", i);
+        lines_a[i] = storage[i];
+    }
+    const char* lines_b[] = {"other"};
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* tall = line_sequence_create(lines_a, SIZE, false, hash_map);
+    ISequence* single = line_sequence_create(lines_b, 1, false, hash_map);
+    ISequence* half = line_sequence_create(lines_a, SIZE / 2, false, hash_map);
+    ISequence* half_edited = line_sequence_create(lines_a + 1, SIZE / 2, false, hash_map);
+    
+    DiffEngineEstimate estimate;
+    bool tall_dp = diff_engine_prefers_dp(tall, single, true, 0, &estimate);
+    assert(tall_dp);
+    assert(estimate.dp_cells == SIZE);
+    assert(estimate.min_distance == SIZE + 1);
+    
+    // 849 x 849 shifted by one line: D = 2, O(ND) is far cheaper
+    bool half_dp = diff_engine_prefers_dp(half, half_edited, true, 0, &estimate);
+    assert(!half_dp);
+    assert(estimate.min_distance == 2);
+    
+    // Over the cell budget the DP is never chosen
+    bool capped_dp = diff_engine_prefers_dp(tall, single, true, SIZE - 1, &estimate);
+    assert(!capped_dp);
+    (void)tall_dp;
+    (void)half_dp;
+    (void)capped_dp;
+    
+    assert(strcmp(diff_engine_name(DIFF_ENGINE_DP), "dp") == 0);
+    assert(strcmp(diff_engine_name(DIFF_ENGINE_LINEAR), "linear") == 0);
+    
+    printf("✓ PASSED\n");
+    
+    tall->destroy(tall);
+    single->destroy(single);
+    half->destroy(half);
+    half_edited->destroy(half_edited);
+    string_hash_map_destroy(hash_map);
+}
+
+void test_memory_budget_fallbacks() {
+    printf("\n=== Test: Memory Budget Fallbacks ===\n");
+    // 300 x 300: DP needs ~30 KB, forward O(ND) ~15 KB, linear space ~5 KB
+    enum { SIZE = 300 };
+    static const char* alphabet[] = {"a", "b", "c", "d"};
+    const char* a[SIZE];
+    const char* b[SIZE];
+    unsigned int seed = 4242;
+    for (int i = 0; i < SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        a[i] = alphabet[(seed >> 16) % 4];
+        b[i] = (seed >> 20) % 8 != 0 ? a[i] : alphabet[(seed >> 24) % 4];
+    }
+    
+    StringHashMap* hash_map = string_hash_map_create();
+    ISequence* seq_a = line_sequence_create(a, SIZE, false, hash_map);
+    ISequence* seq_b = line_sequence_create(b, SIZE, false, hash_map);
+    bool hit_timeout = false;
+    SequenceDiffArray* nd = myers_nd_diff_algorithm(seq_a, seq_b, 0, &hit_timeout);
+    
+    // DP over budget runs the forward O(ND) algorithm
+    DiffMemoryBudget budget;
+    diff_memory_budget_init(&budget, 20000);
+    diff_set_thread_memory_budget(&budget);
+    SequenceDiffArray* dp = myers_dp_diff_algorithm(seq_a, seq_b, 0, &hit_timeout, NULL, NULL);
+    bool dp_exceeded = diff_memory_budget_exceeded(&budget);
+    bool dp_is_nd = diff_arrays_same(dp, nd);
+    assert(dp_exceeded);
+    assert(dp_is_nd);
+    
+    // O(ND) over budget continues in linear space: same edit distance
+    diff_memory_budget_init(&budget, 6000);
+    SequenceDiffArray* linear = myers_nd_diff_algorithm(seq_a, seq_b, 0, &hit_timeout);
+    bool linear_exceeded = diff_memory_budget_exceeded(&budget);
+    bool linear_minimal = diff_cost(linear) == diff_cost(nd) && diff_shape_valid(linear, a, SIZE, b, SIZE);
+    assert(linear_exceeded);
+    assert(linear_minimal);
+    
+    // Nothing fits: whole range changed
+    diff_memory_budget_init(&budget, 100);
+    SequenceDiffArray* trivial = myers_dp_diff_algorithm(seq_a, seq_b, 0, &hit_timeout, NULL, NULL);
+    diff_set_thread_memory_budget(NULL);
+    assert(!hit_timeout);
+    assert_diff_count(trivial, 1);
+    ASSERT_DIFF(trivial, 0, 0,SIZE, 0,SIZE);
+    (void)dp_exceeded;
+    (void)dp_is_nd;
+    (void)linear_exceeded;
+    (void)linear_minimal;
+    
+    printf("✓ PASSED\n");
+    
+    SequenceDiffArray* results[] = {nd, dp, linear, trivial};
+    for (int i = 0; i < 4; i++) {
+        free(results[i]->diffs);
+        free(results[i]);
+    }
+    seq_a->destroy(seq_a);
+    seq_b->destroy(seq_b);
+    string_hash_map_destroy(hash_map);
+}
+
 int main() {
     printf("Running Myers Algorithm Tests\n");
     printf("==============================\n");
@@ -313,6 +717,13 @@ int main() {
     test_large_file();
     test_worst_case();
     test_delete_and_add();
+    test_nd_timeout();
+    test_generic_sequence_fallback();
+    test_dp_match_masks_match_scored_pass();
+    test_linear_space_matches_nd();
+    test_linear_space_timeout();
+    test_engine_cost_model();
+    test_memory_budget_fallbacks();
     
     printf("\n==============================\n");
     printf("All tests passed! ✓\n");
@@ -0,0 +1,276 @@
+/**
+ * Test Suite for Packed (Varint Delta) Diff Serialization
+ *
+ * Verifies:
+ * 1. Packing and unpacking give back the same flat diff and LinesDiff
+ * 2. The in-place reader walks changes, inner changes and moves
+ * 3. Packed diffs are a fraction of the flat block's size
+ * 4. Any int survives (backward ranges, INT32_MIN / INT32_MAX)
+ * 5. Truncated, trailing or corrupted bytes are rejected, also via streams
+ */
+
+#include "packed_lines_diff.h"
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static const DiffOptions move_options = {
+    .compute_moves = true,
+};
+
+static size_t flat_bytes(const FlatLinesDiff* flat) {
+    return ((size_t)flat->total_change_count * FLAT_CHANGE_STRIDE + (size_t)flat->total_change_count + 1 +
+            (size_t)flat->inner_change_count * FLAT_INNER_STRIDE +
+            (size_t)flat->move_count * FLAT_MOVE_STRIDE) * sizeof(int);
+}
+
+static bool flats_equal(const FlatLinesDiff* a, const FlatLinesDiff* b) {
+    return a->change_count == b->change_count && a->total_change_count == b->total_change_count &&
+           a->inner_change_count == b->inner_change_count && a->move_count == b->move_count &&
+           a->hit_timeout == b->hit_timeout && a->hit_memory_limit == b->hit_memory_limit &&
+           memcmp(a->changes, b->changes, flat_bytes(a)) == 0;
+}
+
+/** Six statements moved below an 8-line function, edits on both */
+static LinesDiff* moved_block_diff(void) {
+    static const char* block[] = {
+        "function handle_request(request, response) {",
+        "    const headers = parse_headers(request.raw);",
+        "    const body = decode_body(request.body, headers);",
+        "    validate_payload(body, request.schema);",
+        "    const result = dispatch(request.route, body);",
+        "    response.write(serialize(result));",
+        "    log_request(request, result.status);",
+        "}",
+    };
+    static const char* rest[] = {
+        "const a = alpha();", "const b = beta();", "const c = gamma();",
+        "const d = delta();", "const e = epsilon();", "const f = zeta();",
+    };
+    const char* original[15];
+    const char* modified[15];
+    original[0] = "// header";
+    for (int i = 0; i < 8; i++) original[1 + i] = block[i];
+    for (int i = 0; i < 6; i++) original[9 + i] = rest[i];
+    modified[0] = "// header, edited";
+    for (int i = 0; i < 6; i++) modified[1 + i] = rest[i];
+    for (int i = 0; i < 8; i++) modified[7 + i] = block[i];
+    modified[3] = "const c = gamma(options);";
+    return compute_diff(original, 15, modified, 15, &move_options);
+}
+
+TEST(round_trip_matches_flat) {
+    LinesDiff* diff = moved_block_diff();
+    assert(diff != NULL && diff->moves.count == 1);
+    diff->hit_memory_limit = true;  // Flags survive
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    PackedLinesDiff* packed = pack_lines_diff(diff);
+    PackedLinesDiff* from_flat = pack_flat_lines_diff(flat);
+    assert(flat && packed && from_flat);
+    bool same_bytes = packed->size == from_flat->size &&
+                      memcmp(packed->data, from_flat->data, packed->size) == 0;
+    assert(same_bytes);
+
+    FlatLinesDiff* unpacked = unpack_flat_lines_diff(packed->data, packed->size);
+    LinesDiff* expanded = unpack_lines_diff(packed->data, packed->size);
+    FlatLinesDiff* reflat = flatten_lines_diff(expanded);
+    bool matches = unpacked && reflat && flats_equal(unpacked, flat) && flats_equal(reflat, flat);
+    assert(matches);
+    (void)same_bytes;
+    (void)matches;
+
+    free_flat_lines_diff(reflat);
+    free_lines_diff(expanded);
+    free_flat_lines_diff(unpacked);
+    free_packed_lines_diff(from_flat);
+    free_packed_lines_diff(packed);
+    free_flat_lines_diff(flat);
+    free_lines_diff(diff);
+    free_packed_lines_diff(NULL);
+}
+
+TEST(reader_walks_in_place) {
+    LinesDiff* diff = moved_block_diff();
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    PackedLinesDiff* packed = pack_flat_lines_diff(flat);
+    assert(flat && packed);
+
+    PackedLinesDiffReader reader;
+    bool ok = packed_reader_init(&reader, packed->data, packed->size) &&
+              reader.change_count == flat->change_count &&
+              reader.total_change_count == flat->total_change_count &&
+              reader.move_count == flat->move_count && reader.hit_timeout == (flat->hit_timeout != 0);
+
+    // Every change and inner change, in flat order
+    LineRange original, modified;
+    int inner_count;
+    for (int i = 0; ok && i < flat->total_change_count; i++) {
+        const int* c = &flat->changes[i * FLAT_CHANGE_STRIDE];
+        ok = packed_reader_next_change(&reader, &original, &modified, &inner_count) &&
+             original.start_line == c[0] && original.end_line == c[1] &&
+             modified.start_line == c[2] && modified.end_line == c[3] &&
+             inner_count == flat->inner_offsets[i + 1] - flat->inner_offsets[i];
+        RangeMapping mapping;
+        for (int k = 0; ok && k < inner_count; k++) {
+            const int* inner = &flat->inner_changes[(flat->inner_offsets[i] + k) * FLAT_INNER_STRIDE];
+            ok = packed_reader_next_inner_change(&reader, &mapping) &&
+                 memcmp(&mapping.original, inner, sizeof(CharRange)) == 0 &&
+                 memcmp(&mapping.modified, inner + 4, sizeof(CharRange)) == 0;
+        }
+        ok = ok && !packed_reader_next_inner_change(&reader, &mapping);
+    }
+    ok = ok && !packed_reader_next_change(&reader, &original, &modified, &inner_count);
+    MovedText move;
+    for (int m = 0; ok && m < flat->move_count; m++) {
+        const int* fm = &flat->moves[m * FLAT_MOVE_STRIDE];
+        ok = packed_reader_next_move(&reader, &move) && move.changes == NULL &&
+             move.original.start_line == fm[0] && move.original.end_line == fm[1] &&
+             move.modified.start_line == fm[2] && move.modified.end_line == fm[3] &&
+             move.change_count == fm[5];
+    }
+    ok = ok && !packed_reader_next_move(&reader, &move) && !reader.failed;
+    assert(ok);
+
+    // Moves without reading the changes: they are skipped
+    ok = packed_reader_init(&reader, packed->data, packed->size) &&
+         packed_reader_next_change(&reader, &original, &modified, &inner_count) &&
+         packed_reader_next_move(&reader, &move) &&
+         move.original.start_line == flat->moves[0] && !reader.failed;
+    assert(ok);
+    (void)ok;
+
+    free_packed_lines_diff(packed);
+    free_flat_lines_diff(flat);
+    free_lines_diff(diff);
+}
+
+TEST(packed_is_compact) {
+    // 600 lines with a one-word edit every third line
+    enum { LINES = 600 };
+    static char original_text[LINES][48];
+    static char modified_text[LINES][48];
+    const char* original[LINES];
+    const char* modified[LINES];
+    for (int i = 0; i < LINES; i++) {
+        snprintf(original_text[i], sizeof(original_text[i]), "    total += values[%d] * weight;", i);
+        snprintf(modified_text[i], sizeof(modified_text[i]),
+                 i % 3 == 1 ? "    total += values[%d] * factor;" : "    total += values[%d] * weight;", i);
+        original[i] = original_text[i];
+        modified[i] = modified_text[i];
+    }
+    LinesDiff* diff = compute_diff(original, LINES, modified, LINES, &move_options);
+    FlatLinesDiff* flat = flatten_lines_diff(diff);
+    PackedLinesDiff* packed = pack_flat_lines_diff(flat);
+    assert(flat && packed && flat->inner_change_count >= LINES / 3);
+    printf("  %d changes: flat %zu bytes, packed %zu bytes\n", flat->change_count,
+           flat_bytes(flat), packed->size);
+    assert(packed->size * 3 < flat_bytes(flat));
+
+    free_packed_lines_diff(packed);
+    free_flat_lines_diff(flat);
+    free_lines_diff(diff);
+}
+
+TEST(extreme_values_survive) {
+    RangeMapping inner[2] = {
+        {{INT32_MAX, INT32_MIN, INT32_MIN, INT32_MAX}, {5, 9, 2, 1}},
+        {{-3, 0, 7, -7}, {0, 0, 0, 0}},
+    };
+    DetailedLineRangeMapping changes[2] = {
+        {{INT32_MAX, INT32_MIN}, {10, 4}, inner, 2},
+        {{1, 1}, {-100, 100}, NULL, 0},
+    };
+    LinesDiff diff;
+    memset(&diff, 0, sizeof(diff));
+    diff.changes.mappings = changes;
+    diff.changes.count = 2;
+    diff.changes.capacity = 2;
+    diff.hit_timeout = true;
+
+    FlatLinesDiff* flat = flatten_lines_diff(&diff);
+    PackedLinesDiff* packed = pack_flat_lines_diff(flat);
+    FlatLinesDiff* unpacked = packed ? unpack_flat_lines_diff(packed->data, packed->size) : NULL;
+    bool matches = flat && unpacked && flats_equal(flat, unpacked);
+    assert(matches);
+    (void)matches;
+
+    free_flat_lines_diff(unpacked);
+    free_packed_lines_diff(packed);
+    free_flat_lines_diff(flat);
+}
+
+TEST(malformed_bytes_rejected) {
+    LinesDiff* diff = moved_block_diff();
+    PackedLinesDiff* packed = pack_lines_diff(diff);
+    assert(packed);
+
+    // Every truncation, a trailing byte, a wrong magic
+    bool rejected = true;
+    for (size_t size = 0; size < packed->size; size++) {
+        FlatLinesDiff* flat = unpack_flat_lines_diff(packed->data, size);
+        rejected = rejected && flat == NULL;
+        free_flat_lines_diff(flat);
+    }
+    uint8_t* bytes = (uint8_t*)malloc(packed->size + 1);
+    memcpy(bytes, packed->data, packed->size);
+    bytes[packed->size] = 0;
+    rejected = rejected && unpack_flat_lines_diff(bytes, packed->size + 1) == NULL;
+    bytes[0] = 'X';
+    rejected = rejected && unpack_lines_diff(bytes, packed->size) == NULL;
+    bytes[0] = packed->data[0];
+    // Inner change count larger than the header's total
+    PackedLinesDiffReader reader;
+    rejected = rejected && packed_reader_init(&reader, bytes, packed->size);
+    bytes[4 + 3] = 0x7F;  // inner_change_count varint (header counts are single bytes here)
+    rejected = rejected && unpack_flat_lines_diff(bytes, packed->size) == NULL;
+    assert(rejected);
+
+    // Stream round trip, then a truncated stream
+    FILE* stream = tmpfile();
+    assert(stream != NULL);
+    bool written = write_packed_lines_diff(packed, stream) && write_packed_lines_diff(packed, stream);
+    assert(written);
+    rewind(stream);
+    PackedLinesDiff* first = read_packed_lines_diff(stream);
+    PackedLinesDiff* second = read_packed_lines_diff(stream);
+    bool read_back = first && second && first->size == packed->size &&
+                     memcmp(second->data, packed->data, packed->size) == 0 &&
+                     read_packed_lines_diff(stream) == NULL;
+    assert(read_back);
+
+    FILE* truncated = tmpfile();
+    assert(truncated != NULL);
+    rewind(stream);
+    char buffer[8];
+    size_t got = fread(buffer, 1, sizeof(buffer), stream);
+    fwrite(buffer, 1, got, truncated);
+    rewind(truncated);
+    assert(read_packed_lines_diff(truncated) == NULL);
+    (void)rejected;
+    (void)written;
+    (void)read_back;
+
+    fclose(truncated);
+    fclose(stream);
+    free_packed_lines_diff(first);
+    free_packed_lines_diff(second);
+    free(bytes);
+    free_packed_lines_diff(packed);
+    free_lines_diff(diff);
+}
+
+int main(void) {
+    printf("=== Packed Diff Serialization Tests ===\n\n");
+
+    RUN_TEST(round_trip_matches_flat);
+    RUN_TEST(reader_walks_in_place);
+    RUN_TEST(packed_is_compact);
+    RUN_TEST(extreme_values_survive);
+    RUN_TEST(malformed_bytes_rejected);
+
+    printf("\n=== ALL PACKED DIFF TESTS PASSED ✓ ===\n");
+    return 0;
+}
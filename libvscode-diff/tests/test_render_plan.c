@@ -6,6 +6,7 @@
 
 #include "diff_api.h"
 #include "render_plan.h"
+#include "default_lines_diff_computer.h"
 #include "print_utils.h"
 
 // Test 1: Simple single line change
@@ -121,6 +122,277 @@ void test_empty() {
     printf("✓ Test 3 passed\n");
 }
 
+// Test 4: Inserted lines get fillers on the original side
+void test_insertion_fillers() {
+    printf("\n=== Test 4: Insertion Fillers ===\n");
+    
+    // docs/filler-line-algorithm.md example: 3 lines inserted after line 12
+    const char* original[14];
+    const char* modified[17];
+    char buffer[17][32];
+    for (int i = 0; i < 14; i++) {
+        snprintf(buffer[i], sizeof(buffer[i]), "Line %d", i + 1);
+        original[i] = buffer[i];
+    }
+    for (int i = 0; i < 12; i++) modified[i] = original[i];
+    modified[12] = "Line 13 (new)";
+    modified[13] = "Line 14 (new)";
+    modified[14] = "Line 15 (new)";
+    modified[15] = original[12];
+    modified[16] = original[13];
+    
+    DiffOptions opts = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    
+    RenderPlan* plan = compute_diff_render_plan(original, 14, modified, 17, &opts);
+    
+    assert(plan != NULL);
+    assert(plan->right.filler_count == 0);
+    assert(plan->left.filler_count == 1);
+    assert(plan->left.fillers[0].after_line == 12);
+    assert(plan->left.fillers[0].count == 3);
+    assert(plan->right.line_metadata[12].type == HL_LINE_INSERT);
+    assert(plan->right.line_metadata[15].type == HL_NONE);
+    
+    diff_core_print_render_plan(plan);
+    
+    free_render_plan(plan);
+    printf("✓ Test 4 passed\n");
+}
+
+// Test 5: Deleted lines get fillers on the modified side
+void test_deletion_fillers() {
+    printf("\n=== Test 5: Deletion Fillers ===\n");
+    
+    const char* original[] = {
+        "keep 1",
+        "remove a",
+        "remove b",
+        "keep 2",
+        "keep 3"
+    };
+    
+    const char* modified[] = {
+        "keep 1",
+        "keep 2",
+        "keep 3"
+    };
+    
+    DiffOptions opts = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    
+    RenderPlan* plan = compute_diff_render_plan(original, 5, modified, 3, &opts);
+    
+    assert(plan != NULL);
+    assert(plan->left.filler_count == 0);
+    assert(plan->right.filler_count == 1);
+    assert(plan->right.fillers[0].after_line == 1);
+    assert(plan->right.fillers[0].count == 2);
+    assert(plan->left.line_metadata[1].type == HL_LINE_DELETE);
+    assert(plan->left.line_metadata[2].type == HL_LINE_DELETE);
+    
+    diff_core_print_render_plan(plan);
+    
+    free_render_plan(plan);
+    printf("✓ Test 5 passed\n");
+}
+
+// Test 6: A line split in two aligns on the unchanged prefix
+void test_split_line_fillers() {
+    printf("\n=== Test 6: Split Line Fillers ===\n");
+    
+    const char* original[] = {
+        "before",
+        "call(first_argument, second_argument);",
+        "after"
+    };
+    
+    const char* modified[] = {
+        "before",
+        "call(first_argument,",
+        "     second_argument);",
+        "after"
+    };
+    
+    DiffOptions opts = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    
+    RenderPlan* plan = compute_diff_render_plan(original, 3, modified, 4, &opts);
+    
+    assert(plan != NULL);
+    assert(plan->right.filler_count == 0);
+    assert(plan->left.filler_count == 1);
+    assert(plan->left.fillers[0].count == 1);
+    
+    // Char highlights stay within each line's content
+    for (int i = 0; i < plan->right.line_count; i++) {
+        const LineMetadata* meta = &plan->right.line_metadata[i];
+        for (int j = 0; j < meta->char_highlight_count; j++) {
+            assert(meta->char_highlights[j].end_col <= (int)strlen(modified[i]) + 1);
+        }
+    }
+    
+    diff_core_print_render_plan(plan);
+    
+    free_render_plan(plan);
+    printf("✓ Test 6 passed\n");
+}
+
+// Test 7: Hunk index lists runs of highlighted lines
+void test_hunk_index() {
+    printf("\n=== Test 7: Hunk Index ===\n");
+    
+    const char* original[] = {
+        "one", "two", "three", "four", "five", "six", "seven", "eight"
+    };
+    
+    const char* modified[] = {
+        "one", "TWO", "THREE", "four", "five", "six", "SEVEN", "eight"
+    };
+    
+    DiffOptions opts = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    
+    RenderPlan* plan = compute_diff_render_plan(original, 8, modified, 8, &opts);
+    
+    assert(plan != NULL);
+    assert(plan->right.hunk_count == 2);
+    assert(plan->right.hunks[0].start_line == 2 && plan->right.hunks[0].end_line == 4);
+    assert(plan->right.hunks[1].start_line == 7 && plan->right.hunks[1].end_line == 8);
+    assert(plan->left.hunk_count == 2);
+    
+    // First hunk ending after a line: inside, between and past the hunks
+    assert(render_plan_find_hunk(&plan->right, 1) == 0);
+    assert(render_plan_find_hunk(&plan->right, 3) == 0);
+    assert(render_plan_find_hunk(&plan->right, 4) == 1);
+    assert(render_plan_find_hunk(&plan->right, 7) == 1);
+    assert(render_plan_find_hunk(&plan->right, 8) == 2);
+    
+    free_render_plan(plan);
+    printf("✓ Test 7 passed\n");
+}
+
+// Whether a sparse plan side holds exactly the dense side's content
+static bool sparse_side_matches(const SparseSideRenderPlan* sparse, const SideRenderPlan* dense) {
+    if (sparse->line_count != dense->line_count ||
+        sparse->filler_count != dense->filler_count ||
+        sparse->hunk_count != dense->hunk_count ||
+        (dense->filler_count > 0 &&
+         memcmp(sparse->fillers, dense->fillers, dense->filler_count * sizeof(FillerLine)) != 0) ||
+        (dense->hunk_count > 0 &&
+         memcmp(sparse->hunks, dense->hunks, dense->hunk_count * sizeof(LineRange)) != 0)) {
+        return false;
+    }
+
+    int records = 0;
+    for (int i = 0; i < dense->line_count; i++) {
+        const LineMetadata* meta = &dense->line_metadata[i];
+        const SparseLineRecord* record = sparse_render_plan_find_line(sparse, i + 1);
+        if (meta->type == HL_NONE && meta->char_highlight_count == 0) {
+            if (record) return false;
+            continue;
+        }
+        records++;
+        if (!record || record->type != meta->type ||
+            record->char_highlight_count != meta->char_highlight_count ||
+            (meta->char_highlight_count > 0 &&
+             memcmp(&sparse->char_highlights[record->char_highlight_start], meta->char_highlights,
+                    meta->char_highlight_count * sizeof(CharHighlight)) != 0)) {
+            return false;
+        }
+    }
+    return records == sparse->record_count;
+}
+
+static bool sparse_plan_matches(const char** original, int original_count,
+                                const char** modified, int modified_count,
+                                const DiffOptions* opts) {
+    LinesDiff* diff = compute_diff(original, original_count, modified, modified_count, opts);
+    RenderPlan* dense = generate_render_plan(diff, original, original_count, modified, modified_count);
+    SparseRenderPlan* sparse = generate_sparse_render_plan(diff, original, original_count,
+                                                           modified, modified_count);
+    bool same = diff && dense && sparse &&
+                sparse_side_matches(&sparse->left, &dense->left) &&
+                sparse_side_matches(&sparse->right, &dense->right);
+    free_sparse_render_plan(sparse);
+    free_render_plan(dense);
+    free_lines_diff(diff);
+    return same;
+}
+
+enum { SPARSE_LINES = 20000 };
+static char sparse_pool[2][SPARSE_LINES][32];
+static const char* sparse_lines[2][SPARSE_LINES];
+
+// Test 8: Sparse plan matches the dense plan and is sized by the changes
+void test_sparse_render_plan() {
+    printf("\n=== Test 8: Sparse Render Plan ===\n");
+    
+    DiffOptions opts = {
+        .ignore_trim_whitespace = false,
+        .max_computation_time_ms = 0,
+        .compute_moves = false,
+        .extend_to_subwords = false
+    };
+    
+    // Char changes, insertions, deletions and a multi-line inner change
+    const char* original[] = {
+        "one", "two", "three", "four", "five", "six", "seven", "eight"
+    };
+    const char* modified[] = {
+        "one", "TWO", "added", "three", "five", "six and more", "text seven", "eight"
+    };
+    const char* empty[] = { "" };
+    bool same = sparse_plan_matches(original, 8, modified, 8, &opts) &&
+                sparse_plan_matches(modified, 8, original, 8, &opts) &&
+                sparse_plan_matches(original, 8, original, 8, &opts) &&
+                sparse_plan_matches(empty, 1, modified, 8, &opts) &&
+                sparse_plan_matches(original, 8, empty, 1, &opts);
+    assert(same);
+    
+    // Three changed lines in a large file: three records per side
+    for (int i = 0; i < SPARSE_LINES; i++) {
+        snprintf(sparse_pool[0][i], 32, "line %d", i);
+        snprintf(sparse_pool[1][i], 32, i % 7000 == 100 ? "line %d changed" : "line %d", i);
+        sparse_lines[0][i] = sparse_pool[0][i];
+        sparse_lines[1][i] = sparse_pool[1][i];
+    }
+    same = sparse_plan_matches(sparse_lines[0], SPARSE_LINES, sparse_lines[1], SPARSE_LINES, &opts);
+    assert(same);
+    (void)same;
+    
+    LinesDiff* diff = compute_diff(sparse_lines[0], SPARSE_LINES, sparse_lines[1], SPARSE_LINES, &opts);
+    SparseRenderPlan* plan = generate_sparse_render_plan(diff, sparse_lines[0], SPARSE_LINES,
+                                                         sparse_lines[1], SPARSE_LINES);
+    assert(plan != NULL);
+    assert(plan->right.record_count == 3 && plan->right.hunk_count == 3);
+    assert(plan->right.char_highlight_count == 3);
+    assert(sparse_render_plan_find_line(&plan->right, 7101) == &plan->right.records[1]);
+    assert(sparse_render_plan_find_line(&plan->right, 7102) == NULL);
+    assert(sparse_render_plan_find_hunk(&plan->right, 7102) == 2);
+    
+    free_sparse_render_plan(plan);
+    free_lines_diff(diff);
+    free_sparse_render_plan(NULL);
+    printf("✓ Test 8 passed\n");
+}
+
 int main() {
     printf("Testing Render Plan Generation\n");
     printf("================================\n");
@@ -128,6 +400,11 @@ int main() {
     test_simple_change();
     test_addition_deletion();
     test_empty();
+    test_insertion_fillers();
+    test_deletion_fillers();
+    test_split_line_fillers();
+    test_hunk_index();
+    test_sparse_render_plan();
     
     printf("\n================================\n");
     printf("All tests passed!\n");
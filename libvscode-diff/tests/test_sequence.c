@@ -11,6 +11,7 @@
 #include "sequence.h"
 #include "string_hash_map.h"
 #include "myers.h"
+#include "utf8_utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -69,6 +70,37 @@ void test_whitespace_handling() {
     printf("✓ PASSED\n");
 }
 
+void test_string_hash_map_sequential_ids() {
+    printf("\n=== Test: String Hash Map Sequential IDs ===\n");
+    
+    // IDs follow first-seen order, across growth and across reserve()
+    StringHashMap* map = string_hash_map_create();
+    char key[32];
+    const int count = 5000;
+    
+    for (int i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "line %d", i);
+        assert(string_hash_map_get_or_create(map, key) == (uint32_t)i);
+        if (i == 100) {
+            string_hash_map_reserve(map, 4 * count);
+        }
+    }
+    assert(string_hash_map_size(map) == count);
+    
+    // Lookups return the same IDs; prefixes and the empty string are distinct
+    for (int i = count - 1; i >= 0; i--) {
+        snprintf(key, sizeof(key), "line %d", i);
+        assert(string_hash_map_get_or_create(map, key) == (uint32_t)i);
+    }
+    assert(string_hash_map_get_or_create(map, "line") == (uint32_t)count);
+    assert(string_hash_map_get_or_create(map, "") == (uint32_t)count + 1);
+    assert(string_hash_map_get_or_create(map, "line") == (uint32_t)count);
+    assert(string_hash_map_size(map) == count + 2);
+    
+    string_hash_map_destroy(map);
+    printf("✓ PASSED\n");
+}
+
 void test_boundary_scoring() {
     printf("\n=== Test: Boundary Scoring ===\n");
     
@@ -107,6 +139,23 @@ void test_boundary_scoring() {
     
     printf("  ✓ Boundary scores correctly ordered by indentation\n");
     
+    // Windows share the parent's precomputed indentation
+    ISequence* window = line_sequence_create_window(seq, 2, 3);
+    assert(window->getBoundaryScore(window, 1) == score3);
+    window->destroy(window);
+    
+    // Indentation too deep for the compact table is rescanned from the line
+    char* deep = (char*)malloc(70002);
+    memset(deep, ' ', 70000);
+    deep[70000] = 'x';
+    deep[70001] = '\0';
+    const char* deep_lines[] = {"x", deep};
+    ISequence* deep_seq = line_sequence_create(deep_lines, 2, false, NULL);
+    assert(deep_seq->getBoundaryScore(deep_seq, 1) == 1000 - 70000);
+    deep_seq->destroy(deep_seq);
+    free(deep);
+    printf("  ✓ Windowed and deep-indentation scores\n");
+    
     seq->destroy(seq);
     printf("✓ PASSED\n");
 }
@@ -423,14 +472,108 @@ void test_column_translation_edge_cases() {
     printf("\n✓ PASSED\n");
 }
 
+/** Expected elements: the UTF-16 units of lines[i] joined with '\n' */
+static bool elements_match(const CharSequence* seq, const char** lines, int count) {
+    bool matches = true;
+    int offset = 0;
+    for (int i = 0; i < count; i++) {
+        int units = 0;
+        uint16_t* utf16 = utf8_to_utf16(lines[i], &units);
+        for (int j = 0; j < units && offset + j < seq->length; j++) {
+            matches = matches && seq->elements[offset + j] == utf16[j];
+        }
+        offset += units;
+        free(utf16);
+        if (i + 1 < count) {
+            matches = matches && offset < seq->length && seq->elements[offset] == '\n';
+            offset++;
+        }
+    }
+    return matches && seq->length == offset;
+}
+
+void test_ascii_fast_path() {
+    printf("\n=== Test: ASCII Fast Path in CharSequence ===\n");
+    
+    // Run detection stops at the first non-ASCII or NUL byte, at any
+    // position relative to the 16-byte blocks
+    char buffer[64];
+    for (int stop = 0; stop < 48; stop++) {
+        memset(buffer, 'a', sizeof(buffer));
+        buffer[stop] = (char)0xC3;
+        assert(utf8_ascii_run_length(buffer, 48) == stop);
+        buffer[stop] = '\0';
+        assert(utf8_ascii_run_length(buffer, 48) == stop);
+    }
+    memset(buffer, 'a', sizeof(buffer));
+    assert(utf8_ascii_run_length(buffer, 37) == 37);
+    assert(utf8_ascii_run_length(buffer, 0) == 0);
+    
+    uint32_t widened[40];
+    utf8_widen_ascii("0123456789abcdefghijklmnopqrstuvwxyzABC", 39, widened);
+    assert(widened[0] == '0' && widened[16] == 'g' && widened[38] == 'C');
+    printf("  ✓ Run detection and widening\n");
+    
+    // Pure ASCII, ASCII with non-ASCII spans, CJK and a surrogate pair
+    const char* lines[] = {
+        "    int value = compute_something(alpha, beta, gamma);   ",
+        "  const caf\xC3\xA9 = \"na\xC3\xAFve r\xC3\xA9sum\xC3\xA9 of the d\xC3\xA9j\xC3\xA0 vu\";",
+        "\xE4\xB8\xAD\xE6\x96\x87\xE6\xB5\x8B\xE8\xAF\x95 mixed with ascii text here",
+        "emoji \xF0\x9F\x98\x80 in the middle of a fairly long ascii line",
+        "",
+    };
+    ISequence* seq = char_sequence_create(lines, 0, 5, true);
+    bool matches = elements_match((const CharSequence*)seq->data, lines, 5);
+    assert(matches);
+    (void)matches;
+    seq->destroy(seq);
+    printf("  ✓ Elements match UTF-16 conversion (whitespace kept)\n");
+    
+    // Trimmed: elements start after the leading whitespace of each line
+    seq = char_sequence_create(lines, 0, 2, false);
+    CharSequence* trimmed = (CharSequence*)seq->data;
+    assert(trimmed->trimmed_ws_lengths[0] == 4);
+    assert(trimmed->trimmed_ws_lengths[1] == 2);
+    assert(trimmed->elements[0] == 'i');
+    int second = trimmed->line_start_offsets[1];
+    assert(trimmed->elements[second] == 'c');
+    assert(trimmed->elements[second + 9] == 0xE9);  // é after "const caf"
+    seq->destroy(seq);
+    printf("  ✓ Trimmed whitespace lengths and content\n");
+    
+    // Column ranges: UTF-16 columns on ASCII and non-ASCII lines
+    CharRange range = {1, 9, 2, 13};
+    seq = char_sequence_create_from_range(lines, 5, &range, true);
+    CharSequence* ranged = (CharSequence*)seq->data;
+    assert(ranged->elements[0] == 'v');       // "value" starts at column 9
+    second = ranged->line_start_offsets[1];
+    assert(ranged->length - second == 12);    // Columns 1..12 of line 2
+    assert(ranged->elements[ranged->length - 1] == 0xE9);
+    (void)second;
+    seq->destroy(seq);
+    
+    CharRange emoji_range = {4, 7, 4, 12};
+    seq = char_sequence_create_from_range(lines, 5, &emoji_range, true);
+    ranged = (CharSequence*)seq->data;
+    assert(ranged->length == 5);
+    assert(ranged->elements[0] == 0xD83D && ranged->elements[1] == 0xDE00);
+    assert(ranged->elements[2] == ' ' && ranged->elements[3] == 'i');
+    seq->destroy(seq);
+    printf("  ✓ Column ranges on ASCII and non-ASCII lines\n");
+    
+    printf("\n✓ PASSED\n");
+}
+
 int main() {
     printf("\n========================================\n");
     printf("Infrastructure Tests - ISequence\n");
     printf("========================================\n");
     
     test_whitespace_handling();
+    test_string_hash_map_sequential_ids();
     test_boundary_scoring();
     test_timeout();
+    test_ascii_fast_path();
     
     printf("\n========================================\n");
     printf("Column Translation Tests\n");
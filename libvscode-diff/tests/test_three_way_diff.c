@@ -0,0 +1,178 @@
+/**
+ * Test Suite for Three-Way Diff
+ *
+ * Verifies:
+ * 1. One-sided changes become OURS/THEIRS regions mapped onto both sides
+ * 2. Identical changes on both sides are BOTH_SAME, differing ones CONFLICT
+ *    with base->ours and base->theirs character changes
+ * 3. Overlapping and touching hunks group into one region; line offsets
+ *    from earlier insertions/deletions carry over
+ * 4. Unchanged sides, empty inputs and large inputs
+ */
+
+#include "three_way_diff.h"
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static const DiffOptions three_way_options = {
+    .ignore_trim_whitespace = false,
+    .max_computation_time_ms = 0,
+    .compute_moves = false,
+    .extend_to_subwords = false,
+    .refine_threads = 0,
+    .anchor_unique_lines = false
+};
+
+static ThreeWayDiff* diff3(const char** base, int base_count, const char** ours, int ours_count,
+                           const char** theirs, int theirs_count) {
+    return compute_three_way_diff(base, NULL, base_count, ours, NULL, ours_count,
+                                  theirs, NULL, theirs_count, &three_way_options);
+}
+
+static bool region_is(const MergeRegion* region, MergeRegionKind kind,
+                      int base_start, int base_end, int ours_start, int ours_end,
+                      int theirs_start, int theirs_end) {
+    return region->kind == kind &&
+           region->base.start_line == base_start && region->base.end_line == base_end &&
+           region->ours.start_line == ours_start && region->ours.end_line == ours_end &&
+           region->theirs.start_line == theirs_start && region->theirs.end_line == theirs_end;
+}
+
+static const char* base_file[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+
+TEST(one_sided_changes) {
+    const char* ours[] = { "a", "B", "c", "d", "e", "f", "g", "h" };
+    const char* theirs[] = { "a", "b", "c", "d", "e", "f", "G", "h" };
+    ThreeWayDiff* diff = diff3(base_file, 8, ours, 8, theirs, 8);
+    assert(diff && diff->count == 2 && !diff->hit_timeout);
+    bool ok = region_is(&diff->regions[0], MERGE_REGION_OURS, 2, 3, 2, 3, 2, 3) &&
+              region_is(&diff->regions[1], MERGE_REGION_THEIRS, 7, 8, 7, 8, 7, 8) &&
+              !diff->regions[0].ours_inner_changes && !diff->regions[1].theirs_inner_changes;
+    assert(ok);
+    (void)ok;
+    free_three_way_diff(diff);
+}
+
+TEST(same_change_and_conflict) {
+    const char* ours[] = { "a", "b", "c", "D", "e", "f", "g", "h", };
+    const char* same[] = { "a", "b", "c", "D", "e", "f", "g", "h", };
+    const char* other[] = { "a", "b", "c", "d is different", "e", "f", "g", "h" };
+
+    ThreeWayDiff* diff = diff3(base_file, 8, ours, 8, same, 8);
+    assert(diff && diff->count == 1);
+    bool ok = region_is(&diff->regions[0], MERGE_REGION_BOTH_SAME, 4, 5, 4, 5, 4, 5) &&
+              !diff->regions[0].ours_inner_changes;
+    assert(ok);
+    free_three_way_diff(diff);
+
+    diff = diff3(base_file, 8, ours, 8, other, 8);
+    assert(diff && diff->count == 1);
+    const MergeRegion* conflict = &diff->regions[0];
+    ok = region_is(conflict, MERGE_REGION_CONFLICT, 4, 5, 4, 5, 4, 5) &&
+         conflict->ours_inner_change_count == 1 && conflict->theirs_inner_change_count == 1;
+    assert(ok);
+    // "d" -> "D" and "d" -> "d is different": base is the original side
+    const RangeMapping* o = &conflict->ours_inner_changes[0];
+    const RangeMapping* t = &conflict->theirs_inner_changes[0];
+    ok = o->original.start_line == 4 && o->original.start_col == 1 && o->original.end_col == 2 &&
+         o->modified.start_line == 4 && o->modified.end_col == 2 &&
+         t->original.start_line == 4 && t->modified.start_line == 4 &&
+         t->original.start_col == 2 && t->modified.end_col == 15;
+    assert(ok);
+    (void)ok;
+    free_three_way_diff(diff);
+}
+
+TEST(grouping_and_offsets) {
+    // ours inserts two lines after "b"; theirs deletes "e" and "f"
+    const char* ours[] = { "a", "b", "x", "y", "c", "d", "e", "f", "g", "h" };
+    const char* theirs[] = { "a", "b", "c", "d", "g", "h" };
+    ThreeWayDiff* diff = diff3(base_file, 8, ours, 10, theirs, 6);
+    assert(diff && diff->count == 2);
+    bool ok = region_is(&diff->regions[0], MERGE_REGION_OURS, 3, 3, 3, 5, 3, 3) &&
+              region_is(&diff->regions[1], MERGE_REGION_THEIRS, 5, 7, 7, 9, 5, 5);
+    assert(ok);
+    free_three_way_diff(diff);
+
+    // Touching hunks (ours "c", theirs "d") and an overlapping pair
+    // (ours "f".."g", theirs "g") each form one conflict
+    const char* ours2[] = { "a", "b", "C", "d", "e", "F", "G", "h" };
+    const char* theirs2[] = { "a", "b", "c", "D", "e", "f", "Gg", "h" };
+    diff = diff3(base_file, 8, ours2, 8, theirs2, 8);
+    assert(diff && diff->count == 2);
+    ok = region_is(&diff->regions[0], MERGE_REGION_CONFLICT, 3, 5, 3, 5, 3, 5) &&
+         region_is(&diff->regions[1], MERGE_REGION_CONFLICT, 6, 8, 6, 8, 6, 8) &&
+         diff->regions[1].ours_inner_change_count > 0 &&
+         diff->regions[1].theirs_inner_change_count > 0;
+    assert(ok);
+    (void)ok;
+    free_three_way_diff(diff);
+}
+
+TEST(unchanged_and_empty) {
+    ThreeWayDiff* diff = diff3(base_file, 8, base_file, 8, base_file, 8);
+    assert(diff && diff->count == 0);
+    free_three_way_diff(diff);
+
+    // Both sides add the same file to an empty base
+    const char* added[] = { "new", "file" };
+    diff = diff3(NULL, 0, added, 2, added, 2);
+    bool ok = diff && diff->count == 1 &&
+              region_is(&diff->regions[0], MERGE_REGION_BOTH_SAME, 1, 1, 1, 3, 1, 3);
+    assert(ok);
+    (void)ok;
+    free_three_way_diff(diff);
+    free_three_way_diff(NULL);
+}
+
+enum { BIG = 3000 };
+static char big_pool[3][BIG][32];
+static const char* big[3][BIG];
+
+/** Large (O(ND) path) sides, changes apart: regions agree with compute_diff() */
+TEST(large_inputs_match_two_way_hunks) {
+    for (int i = 0; i < BIG; i++) {
+        snprintf(big_pool[0][i], 32, "line %d", i);
+        snprintf(big_pool[1][i], 32, i % 100 == 5 ? "ours %d" : "line %d", i);
+        snprintf(big_pool[2][i], 32, i % 100 == 55 ? "theirs %d" : "line %d", i);
+        for (int s = 0; s < 3; s++) big[s][i] = big_pool[s][i];
+    }
+    ThreeWayDiff* diff = diff3(big[0], BIG, big[1], BIG, big[2], BIG);
+    LinesDiff* ours = compute_diff(big[0], BIG, big[1], BIG, &three_way_options);
+    LinesDiff* theirs = compute_diff(big[0], BIG, big[2], BIG, &three_way_options);
+    bool ok = diff && ours && theirs && diff->count == ours->changes.count + theirs->changes.count;
+    int io = 0;
+    int it = 0;
+    for (int i = 0; ok && i < diff->count; i++) {
+        const MergeRegion* region = &diff->regions[i];
+        const DetailedLineRangeMapping* expected =
+            region->kind == MERGE_REGION_OURS ? &ours->changes.mappings[io++]
+                                              : &theirs->changes.mappings[it++];
+        const LineRange* side = region->kind == MERGE_REGION_OURS ? &region->ours
+                                                                  : &region->theirs;
+        ok = (region->kind == MERGE_REGION_OURS || region->kind == MERGE_REGION_THEIRS) &&
+             memcmp(&region->base, &expected->original, sizeof(LineRange)) == 0 &&
+             memcmp(side, &expected->modified, sizeof(LineRange)) == 0;
+    }
+    assert(ok);
+    (void)ok;
+    free_lines_diff(ours);
+    free_lines_diff(theirs);
+    free_three_way_diff(diff);
+}
+
+int main(void) {
+    printf("=== Three-Way Diff Tests ===\n\n");
+
+    RUN_TEST(one_sided_changes);
+    RUN_TEST(same_change_and_conflict);
+    RUN_TEST(grouping_and_offsets);
+    RUN_TEST(unchanged_and_empty);
+    RUN_TEST(large_inputs_match_two_way_hunks);
+
+    printf("\n=== ALL THREE-WAY DIFF TESTS PASSED ✓ ===\n");
+    return 0;
+}
@@ -12,6 +12,7 @@
 #include "../include/sequence.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 // ============================================================================
@@ -157,6 +158,60 @@ static inline void assert_diffs_equal(const SequenceDiffArray* actual,
     }
 }
 
+// ============================================================================
+// LinesDiff Comparison
+// ============================================================================
+
+/**
+ * Same line ranges and same inner changes, mapping for mapping
+ */
+static inline bool line_mappings_equal(const DetailedLineRangeMapping* a,
+                                       const DetailedLineRangeMapping* b, int count) {
+    for (int i = 0; i < count; i++) {
+        if (memcmp(&a[i].original, &b[i].original, sizeof(LineRange)) != 0 ||
+            memcmp(&a[i].modified, &b[i].modified, sizeof(LineRange)) != 0 ||
+            a[i].inner_change_count != b[i].inner_change_count) {
+            return false;
+        }
+        for (int j = 0; j < a[i].inner_change_count; j++) {
+            if (memcmp(&a[i].inner_changes[j], &b[i].inner_changes[j], sizeof(RangeMapping)) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Same changes and timeout flag, moves not compared (for diffs computed with
+ * and without compute_moves)
+ */
+static inline bool line_changes_equal(const LinesDiff* a, const LinesDiff* b) {
+    return a->changes.count == b->changes.count && a->hit_timeout == b->hit_timeout &&
+           line_mappings_equal(a->changes.mappings, b->changes.mappings, a->changes.count);
+}
+
+/**
+ * Same changes, timeout flag and moves (each with its own changes): what
+ * every suite means by two equal diffs
+ */
+static inline bool lines_diff_equal(const LinesDiff* a, const LinesDiff* b) {
+    if (!line_changes_equal(a, b) || a->moves.count != b->moves.count) {
+        return false;
+    }
+    for (int m = 0; m < a->moves.count; m++) {
+        const MovedText* ma = &a->moves.moves[m];
+        const MovedText* mb = &b->moves.moves[m];
+        if (memcmp(&ma->original, &mb->original, sizeof(LineRange)) != 0 ||
+            memcmp(&ma->modified, &mb->modified, sizeof(LineRange)) != 0 ||
+            ma->change_count != mb->change_count ||
+            !line_mappings_equal(ma->changes, mb->changes, ma->change_count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // ============================================================================
 // Step 1 Helper (Myers Algorithm Only - No Optimization)
 // ============================================================================
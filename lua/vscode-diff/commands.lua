@@ -5,12 +5,34 @@ local git = require("vscode-diff.git")
 local diff = require("vscode-diff.diff")
 local render = require("vscode-diff.render")
 
+-- Diff still computing on the worker thread; a newer :VscodeDiff supersedes it
+local pending_job = nil
+
+local function show_diff_async(original_lines, modified_lines)
+  if pending_job then
+    pending_job:cancel()
+  end
+
+  local job
+  job = diff.compute_render_plan_async(original_lines, modified_lines, nil, function(err, plan)
+    if pending_job == job then
+      pending_job = nil
+    end
+    if err then
+      vim.notify("vscode-diff: " .. err, vim.log.levels.ERROR)
+      return
+    end
+    render.create_diff_view(original_lines, modified_lines, plan)
+  end)
+  pending_job = job
+end
+
 --- Handles diffing the current buffer against a given git revision.
 -- @param revision string: The git revision (e.g., "HEAD", commit hash) to compare the current file against.
 -- This function checks if the current buffer is a file and part of a git repository,
 -- then asynchronously retrieves the file at the specified revision and computes the diff
--- between that version and the current buffer. The diff view is rendered after scheduling
--- the UI update to ensure thread safety.
+-- between that version and the current buffer on a worker thread. The diff view is rendered
+-- on the main loop once the result is ready.
 local function handle_git_diff(revision)
   local current_file = vim.api.nvim_buf_get_name(0)
 
@@ -33,8 +55,7 @@ local function handle_git_diff(revision)
         return
       end
 
-      local lines_diff = diff.compute_diff(lines_git, lines_current)
-      render.create_diff_view(lines_git, lines_current, lines_diff)
+      show_diff_async(lines_git, lines_current)
     end)
   end)
 end
@@ -43,24 +64,71 @@ local function handle_file_diff(file_a, file_b)
   local lines_a = vim.fn.readfile(file_a)
   local lines_b = vim.fn.readfile(file_b)
 
-  local lines_diff = diff.compute_diff(lines_a, lines_b)
-  render.create_diff_view(lines_a, lines_b, lines_diff)
+  show_diff_async(lines_a, lines_b)
+end
+
+local function format_ms(ns)
+  return string.format("%.3f ms", ns / 1e6)
+end
+
+local function format_engines(counts)
+  return string.format("dp %d, myers %d, linear %d", counts.dp, counts.myers, counts.linear)
+end
+
+local function yes_no(flag)
+  return flag and "yes" or "no"
+end
+
+--- Shows where the last diff spent its time, for attaching to bug reports.
+local function show_stats()
+  local stats = diff.last_stats()
+  if not stats then
+    vim.notify("vscode-diff: no diff computed yet", vim.log.levels.INFO)
+    return
+  end
+
+  local lines = { "vscode-diff stats (last diff)" }
+  if stats.total_ns == 0 then
+    table.insert(lines, "  diff served from cache")
+  else
+    table.insert(lines, string.format("  %-16s %s", "total", format_ms(stats.total_ns)))
+  end
+  for _, name in ipairs(diff.PHASE_NAMES) do
+    table.insert(lines, string.format("  %-16s %s, %d heap allocations (%.1f KB)", name,
+      format_ms(stats.phase_ns[name]), stats.phase_heap_allocations[name],
+      stats.phase_heap_bytes[name] / 1024))
+  end
+  table.insert(lines, string.format("  %-16s %s", "line engines", format_engines(stats.line_engines)))
+  table.insert(lines, string.format("  %-16s %s", "char engines", format_engines(stats.char_engines)))
+  table.insert(lines, string.format("  %-16s %d", "dp cells", stats.dp_cells))
+  table.insert(lines, string.format("  %-16s %d", "myers max D", stats.myers_max_d))
+  table.insert(lines, string.format("  %-16s %d", "hunks refined", stats.hunks_refined))
+  table.insert(lines, string.format("  %-16s %d (%.1f KB)", "allocations",
+    stats.scratch_allocations, stats.scratch_bytes / 1024))
+  table.insert(lines, string.format("  %-16s %d (%.1f KB)", "heap",
+    stats.heap_allocations, stats.heap_bytes / 1024))
+  table.insert(lines, string.format("  %-16s %s", "timeout", yes_no(stats.hit_timeout)))
+  table.insert(lines, string.format("  %-16s %s", "memory limit", yes_no(stats.hit_memory_limit)))
+
+  vim.notify(table.concat(lines, "\n"), vim.log.levels.INFO)
 end
 
 function M.vscode_diff(opts)
   local args = opts.fargs
 
   if #args == 0 then
-    vim.notify("Usage: :VscodeDiff <file_a> <file_b> OR :VscodeDiff <revision>", vim.log.levels.ERROR)
+    vim.notify("Usage: :VscodeDiff <file_a> <file_b> OR :VscodeDiff <revision> OR :VscodeDiff stats", vim.log.levels.ERROR)
     return
   end
 
-  if #args == 1 then
+  if #args == 1 and args[1] == "stats" then
+    show_stats()
+  elseif #args == 1 then
     handle_git_diff(args[1])
   elseif #args == 2 then
     handle_file_diff(args[1], args[2])
   else
-    vim.notify("Usage: :VscodeDiff <file_a> <file_b> OR :VscodeDiff <revision>", vim.log.levels.ERROR)
+    vim.notify("Usage: :VscodeDiff <file_a> <file_b> OR :VscodeDiff <revision> OR :VscodeDiff stats", vim.log.levels.ERROR)
   end
 end
 
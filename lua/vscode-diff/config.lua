@@ -12,6 +12,39 @@ M.defaults = {
     char_brightness = 1.4,  -- Multiplier for character backgrounds (1.3 = 130% = brighter)
   },
 
+  -- Rendering
+  render = {
+    -- Files with more lines than this only get highlights around the visible
+    -- lines, filled in as the windows scroll (false = always render everything)
+    lazy_threshold = 5000,
+    -- Lines rendered above and below the visible ones in lazy mode
+    lazy_margin = 200,
+  },
+
+  -- Diff result cache (C side), keyed by the content of both sides
+  cache = {
+    -- Results kept in memory (0 = no cache)
+    entries = 32,
+    -- Directory evicted results are written to and read back from, so they
+    -- survive restarts (nil = memory only)
+    dir = nil,
+  },
+
+  -- Background prefetch (see prefetch.lua): diffs of files changed in the
+  -- working tree are computed into the cache above while the editor is idle,
+  -- so `:VscodeDiff <revision>` opens them instantly
+  prefetch = {
+    enabled = false,
+    -- Revision the files are diffed against
+    revision = "HEAD",
+    -- No diff is started until this long after the last key press (ms)
+    idle_ms = 500,
+    -- Larger files are skipped (bytes)
+    max_file_bytes = 1024 * 1024,
+    -- Files queued at most
+    max_files = 100,
+  },
+
   -- Buffer options
   buffer_options = {
     modifiable = false,
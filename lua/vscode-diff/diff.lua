@@ -55,6 +55,8 @@ ffi.cdef[[
   typedef struct {
     LineRange original;
     LineRange modified;
+    DetailedLineRangeMapping* changes;
+    int change_count;
   } MovedText;
 
   typedef struct {
@@ -68,6 +70,7 @@ ffi.cdef[[
     DetailedLineRangeMappingArray changes;
     MovedTextArray moves;
     bool hit_timeout;
+    bool hit_memory_limit;
   } LinesDiff;
 
   // Options
@@ -76,8 +79,42 @@ ffi.cdef[[
     int max_computation_time_ms;
     bool compute_moves;
     bool extend_to_subwords;
+    int refine_threads;
+    bool anchor_unique_lines;
+    bool linear_space_myers;
+    bool cost_model_engine;
+    int line_dp_max_lines;
+    int char_dp_max_chars;
+    int dp_max_cells;
+    int64_t max_memory_bytes;
+    int token_refine_min_chars;
   } DiffOptions;
 
+  // Diff statistics (types.h)
+  typedef struct {
+    int dp;
+    int myers;
+    int linear;
+  } DiffEngineCounts;
+
+  typedef struct {
+    int64_t phase_ns[7];
+    int64_t total_ns;
+    DiffEngineCounts line_engines;
+    DiffEngineCounts char_engines;
+    int64_t dp_cells;
+    int myers_max_d;
+    int hunks_refined;
+    int64_t scratch_allocations;
+    int64_t scratch_bytes;
+    int64_t heap_allocations;
+    int64_t heap_bytes;
+    int64_t phase_heap_allocations[7];
+    int64_t phase_heap_bytes[7];
+    bool hit_timeout;
+    bool hit_memory_limit;
+  } DiffStats;
+
   // API functions
   LinesDiff* compute_diff(
     const char** original_lines,
@@ -86,9 +123,266 @@ ffi.cdef[[
     int modified_count,
     const DiffOptions* options
   );
+  LinesDiff* compute_diff_n(
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+  );
+  LinesDiff* compute_diff_text(
+    const char* original_text,
+    size_t original_len,
+    const char* modified_text,
+    size_t modified_len,
+    const DiffOptions* options
+  );
+  LinesDiff* compute_diff_with_stats(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    DiffStats* stats
+  );
 
   void free_lines_diff(LinesDiff* diff);
   const char* get_version(void);
+
+  // Render plan (render_plan.h / diff_api.h)
+  typedef enum {
+    HL_NONE = -1,
+    HL_LINE_INSERT = 0,
+    HL_LINE_DELETE = 1,
+    HL_CHAR_INSERT = 2,
+    HL_CHAR_DELETE = 3
+  } HighlightType;
+
+  typedef struct {
+    int line_num;
+    int start_col;
+    int end_col;
+    HighlightType type;
+  } CharHighlight;
+
+  typedef struct {
+    int line_num;
+    HighlightType type;
+    bool is_filler;
+    int char_highlight_count;
+    CharHighlight* char_highlights;
+  } LineMetadata;
+
+  typedef struct {
+    int after_line;
+    int count;
+  } FillerLine;
+
+  typedef struct {
+    int line_count;
+    LineMetadata* line_metadata;
+    int filler_count;
+    FillerLine* fillers;
+    int hunk_count;
+    LineRange* hunks;
+  } SideRenderPlan;
+
+  typedef struct {
+    SideRenderPlan left;
+    SideRenderPlan right;
+  } RenderPlan;
+
+  RenderPlan* generate_render_plan(
+    const LinesDiff* diff,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count
+  );
+  RenderPlan* generate_render_plan_n(
+    const LinesDiff* diff,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count
+  );
+  int render_plan_find_hunk(const SideRenderPlan* side, int line);
+  void free_render_plan(RenderPlan* plan);
+
+  // Incremental diff session
+  typedef enum {
+    DIFF_SIDE_ORIGINAL = 0,
+    DIFF_SIDE_MODIFIED = 1
+  } DiffSide;
+
+  typedef struct DiffSession DiffSession;
+
+  DiffSession* diff_session_create(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+  );
+  bool diff_session_edit(
+    DiffSession* session,
+    DiffSide side,
+    int start_line,
+    int old_count,
+    const char** new_lines,
+    int new_count
+  );
+  bool diff_session_recompute(DiffSession* session);
+  const LinesDiff* diff_session_get_diff(const DiffSession* session);
+  void diff_session_destroy(DiffSession* session);
+
+  // Flat result buffer (flat_lines_diff.h)
+  typedef struct {
+    int change_count;
+    int total_change_count;
+    int inner_change_count;
+    int move_count;
+    int hit_timeout;
+    int hit_memory_limit;
+    const int* changes;
+    const int* inner_offsets;
+    const int* inner_changes;
+    const int* moves;
+  } FlatLinesDiff;
+
+  FlatLinesDiff* compute_diff_flat(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+  );
+  void free_flat_lines_diff(FlatLinesDiff* flat);
+
+  // Diff result cache (diff_cache.h)
+  typedef struct DiffCache DiffCache;
+
+  typedef struct {
+    int64_t hits;
+    int64_t disk_hits;
+    int64_t misses;
+    int entries;
+  } DiffCacheStats;
+
+  DiffCache* diff_cache_create(int capacity, const char* spill_dir);
+  LinesDiff* diff_cache_compute(
+    DiffCache* cache,
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+  );
+  LinesDiff* diff_cache_compute_n(
+    DiffCache* cache,
+    const char** original_lines,
+    const int* original_lengths,
+    int original_count,
+    const char** modified_lines,
+    const int* modified_lengths,
+    int modified_count,
+    const DiffOptions* options
+  );
+  DiffCacheStats diff_cache_get_stats(const DiffCache* cache);
+  void diff_cache_clear(DiffCache* cache);
+  void diff_cache_destroy(DiffCache* cache);
+
+  // Asynchronous diff jobs (diff_async.h)
+  typedef enum {
+    DIFF_ASYNC_RUNNING = 0,
+    DIFF_ASYNC_DONE = 1,
+    DIFF_ASYNC_CANCELLED = 2,
+    DIFF_ASYNC_FAILED = 3
+  } DiffAsyncStatus;
+
+  typedef struct DiffAsyncJob DiffAsyncJob;
+
+  DiffAsyncJob* diff_async_start(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    bool build_render_plan,
+    DiffCache* cache
+  );
+  DiffAsyncJob* diff_async_start_background(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    bool build_render_plan,
+    DiffCache* cache
+  );
+  DiffAsyncStatus diff_async_status(const DiffAsyncJob* job);
+  int diff_async_fd(const DiffAsyncJob* job);
+  void diff_async_cancel(DiffAsyncJob* job);
+  const LinesDiff* diff_async_get_diff(const DiffAsyncJob* job);
+  const DiffStats* diff_async_get_stats(const DiffAsyncJob* job);
+  RenderPlan* diff_async_take_render_plan(DiffAsyncJob* job);
+  void diff_async_destroy(DiffAsyncJob* job);
+
+  typedef struct {
+    const char** original_lines;
+    const int* original_lengths;
+    int original_count;
+    const char** modified_lines;
+    const int* modified_lengths;
+    int modified_count;
+    const DiffOptions* options;
+  } DiffBatchJob;
+
+  bool compute_diff_batch(
+    const DiffBatchJob* jobs,
+    int job_count,
+    int thread_count,
+    DiffCache* cache,
+    LinesDiff** results
+  );
+
+  // Three-way diff (three_way_diff.h)
+  typedef enum {
+    MERGE_REGION_OURS = 0,
+    MERGE_REGION_THEIRS = 1,
+    MERGE_REGION_BOTH_SAME = 2,
+    MERGE_REGION_CONFLICT = 3
+  } MergeRegionKind;
+
+  typedef struct {
+    MergeRegionKind kind;
+    LineRange base;
+    LineRange ours;
+    LineRange theirs;
+    RangeMapping* ours_inner_changes;
+    int ours_inner_change_count;
+    RangeMapping* theirs_inner_changes;
+    int theirs_inner_change_count;
+  } MergeRegion;
+
+  typedef struct {
+    MergeRegion* regions;
+    int count;
+    bool hit_timeout;
+    bool hit_memory_limit;
+  } ThreeWayDiff;
+
+  ThreeWayDiff* compute_three_way_diff(
+    const char** base_lines, const int* base_lengths, int base_count,
+    const char** ours_lines, const int* ours_lengths, int ours_count,
+    const char** theirs_lines, const int* theirs_lengths, int theirs_count,
+    const DiffOptions* options
+  );
+  void free_three_way_diff(ThreeWayDiff* diff);
 ]]
 
 ---@class DiffOptions
@@ -96,17 +390,30 @@ ffi.cdef[[
 ---@field max_computation_time_ms integer
 ---@field compute_moves boolean
 ---@field extend_to_subwords boolean
+---@field refine_threads integer
+---@field anchor_unique_lines boolean
+---@field linear_space_myers boolean
+---@field cost_model_engine boolean
+---@field line_dp_max_lines integer
+---@field char_dp_max_chars integer
+---@field dp_max_cells integer
+---@field max_memory_bytes integer Working-memory budget per step in bytes (0 = unlimited)
+---@field token_refine_min_chars integer Token-first refinement for hunks this long (0 = off)
 
--- Convert Lua string array to C string array
+-- Convert Lua string array to C string array, plus the byte length of each
+-- line (Lua already knows them, so the C side never has to strlen)
 local function lua_to_c_strings(lines)
   local count = #lines
   local c_array = ffi.new("const char*[?]", count)
+  local c_lengths = ffi.new("int[?]", count)
 
   for i = 1, count do
-    c_array[i - 1] = lines[i]
+    local line = lines[i]
+    c_array[i - 1] = line
+    c_lengths[i - 1] = #line
   end
 
-  return c_array, count
+  return c_array, count, c_lengths
 end
 
 -- Convert C CharRange to Lua table
@@ -154,9 +461,18 @@ end
 
 -- Convert C MovedText to Lua table
 local function moved_text_to_lua(c_moved)
+  local changes = {}
+
+  if c_moved.changes ~= nil then
+    for i = 0, c_moved.change_count - 1 do
+      table.insert(changes, detailed_mapping_to_lua(c_moved.changes[i]))
+    end
+  end
+
   return {
     original = line_range_to_lua(c_moved.original),
-    modified = line_range_to_lua(c_moved.modified)
+    modified = line_range_to_lua(c_moved.modified),
+    changes = changes
   }
 end
 
@@ -179,20 +495,15 @@ local function lines_diff_to_lua(c_diff)
   return {
     changes = changes,
     moves = moves,
-    hit_timeout = c_diff.hit_timeout
+    hit_timeout = c_diff.hit_timeout,
+    hit_memory_limit = c_diff.hit_memory_limit
   }
 end
 
--- Main API: Compute diff between two sets of lines
--- Returns Lua table representation of LinesDiff
-function M.compute_diff(original_lines, modified_lines, options)
+-- Convert Lua options table to C DiffOptions
+local function lua_to_c_options(options)
   options = options or {}
 
-  -- Convert Lua lines to C arrays
-  local c_orig, orig_count = lua_to_c_strings(original_lines)
-  local c_mod, mod_count = lua_to_c_strings(modified_lines)
-
-  -- Create options struct
   ---@type DiffOptions
 ---@diagnostic disable-next-line: assign-type-mismatch
   local c_options = ffi.new("DiffOptions")
@@ -200,9 +511,130 @@ function M.compute_diff(original_lines, modified_lines, options)
   c_options.max_computation_time_ms = options.max_computation_time_ms or 5000
   c_options.compute_moves = options.compute_moves or false
   c_options.extend_to_subwords = options.extend_to_subwords or false
+  c_options.refine_threads = options.refine_threads or 0
+  c_options.anchor_unique_lines = options.anchor_unique_lines or false
+  c_options.linear_space_myers = options.linear_space_myers or false
+  c_options.cost_model_engine = options.cost_model_engine or false
+  c_options.line_dp_max_lines = options.line_dp_max_lines or 0
+  c_options.char_dp_max_chars = options.char_dp_max_chars or 0
+  c_options.dp_max_cells = options.dp_max_cells or 0
+  c_options.max_memory_bytes = options.max_memory_bytes or 0
+  c_options.token_refine_min_chars = options.token_refine_min_chars or 0
+
+  return c_options
+end
+
+-- Process-wide result cache, created on first use from config.cache
+local cache = nil
+
+local function get_cache()
+  if cache == nil then
+    local cache_config = require("vscode-diff.config").options.cache or {}
+    local entries = cache_config.entries or 0
+    if entries <= 0 then
+      cache = false
+    else
+      local dir = cache_config.dir
+      if dir ~= nil then
+        vim.fn.mkdir(dir, "p")
+      end
+      local c_cache = lib.diff_cache_create(entries, dir)
+      -- Destroying spills the in-memory entries when there is a directory
+      cache = c_cache ~= nil and ffi.gc(c_cache, lib.diff_cache_destroy) or false
+    end
+  end
+  return cache or nil
+end
+
+-- compute_diff() through the result cache when there is one
+local function compute_c_diff(c_orig, orig_count, orig_lengths, c_mod, mod_count, mod_lengths, options)
+  local c_options = lua_to_c_options(options)
+  local c_cache = get_cache()
+  if c_cache ~= nil then
+    return lib.diff_cache_compute_n(c_cache, c_orig, orig_lengths, orig_count, c_mod, mod_lengths, mod_count, c_options)
+  end
+  return lib.compute_diff_n(c_orig, orig_lengths, orig_count, c_mod, mod_lengths, mod_count, c_options)
+end
+
+-- Cache counters ({ hits, disk_hits, misses, entries }), or nil without a cache
+function M.cache_stats()
+  local c_cache = get_cache()
+  if c_cache == nil then
+    return nil
+  end
+
+  local stats = lib.diff_cache_get_stats(c_cache)
+  return {
+    hits = tonumber(stats.hits),
+    disk_hits = tonumber(stats.disk_hits),
+    misses = tonumber(stats.misses),
+    entries = stats.entries,
+  }
+end
+
+-- Drop the in-memory cache entries
+function M.clear_cache()
+  local c_cache = get_cache()
+  if c_cache ~= nil then
+    lib.diff_cache_clear(c_cache)
+  end
+end
+
+-- DiffStats.phase_ns order (DiffPhase in types.h)
+local PHASE_NAMES = {
+  "line_hash", "line_diff", "line_optimize", "char_refine", "line_mapping", "moves", "render_plan",
+}
+M.PHASE_NAMES = PHASE_NAMES
+
+local function engine_counts_to_lua(counts)
+  return { dp = counts.dp, myers = counts.myers, linear = counts.linear }
+end
+
+-- Convert C DiffStats to a Lua table (times in nanoseconds)
+local function stats_to_lua(c_stats)
+  if c_stats == nil then
+    return nil
+  end
+
+  local phase_ns = {}
+  local phase_heap_allocations = {}
+  local phase_heap_bytes = {}
+  for i, name in ipairs(PHASE_NAMES) do
+    phase_ns[name] = tonumber(c_stats.phase_ns[i - 1])
+    phase_heap_allocations[name] = tonumber(c_stats.phase_heap_allocations[i - 1])
+    phase_heap_bytes[name] = tonumber(c_stats.phase_heap_bytes[i - 1])
+  end
+  return {
+    phase_ns = phase_ns,
+    total_ns = tonumber(c_stats.total_ns),
+    line_engines = engine_counts_to_lua(c_stats.line_engines),
+    char_engines = engine_counts_to_lua(c_stats.char_engines),
+    dp_cells = tonumber(c_stats.dp_cells),
+    myers_max_d = c_stats.myers_max_d,
+    hunks_refined = c_stats.hunks_refined,
+    scratch_allocations = tonumber(c_stats.scratch_allocations),
+    scratch_bytes = tonumber(c_stats.scratch_bytes),
+    heap_allocations = tonumber(c_stats.heap_allocations),
+    heap_bytes = tonumber(c_stats.heap_bytes),
+    phase_heap_allocations = phase_heap_allocations,
+    phase_heap_bytes = phase_heap_bytes,
+    hit_timeout = c_stats.hit_timeout,
+    hit_memory_limit = c_stats.hit_memory_limit,
+  }
+end
+
+-- Stats of the most recent diff that collected them (see M.last_stats)
+local last_stats = nil
+
+-- Main API: Compute diff between two sets of lines
+-- Returns Lua table representation of LinesDiff
+function M.compute_diff(original_lines, modified_lines, options)
+  -- Convert Lua lines to C arrays
+  local c_orig, orig_count, orig_lengths = lua_to_c_strings(original_lines)
+  local c_mod, mod_count, mod_lengths = lua_to_c_strings(modified_lines)
 
-  -- Call C function
-  local c_diff = lib.compute_diff(c_orig, orig_count, c_mod, mod_count, c_options)
+  -- Call C function (through the result cache)
+  local c_diff = compute_c_diff(c_orig, orig_count, orig_lengths, c_mod, mod_count, mod_lengths, options)
 
   if c_diff == nil then
     error("compute_diff returned NULL")
@@ -217,6 +649,558 @@ function M.compute_diff(original_lines, modified_lines, options)
   return lua_diff
 end
 
+-- compute_diff() on two whole texts (e.g. file contents or `git show`
+-- output) instead of line tables. The C side splits on '\n' like
+-- JavaScript's split('\n'), so no per-line Lua strings are marshalled.
+function M.compute_diff_text(original_text, modified_text, options)
+  local c_diff = lib.compute_diff_text(original_text, #original_text,
+    modified_text, #modified_text, lua_to_c_options(options))
+  if c_diff == nil then
+    error("compute_diff_text returned NULL")
+  end
+
+  local lua_diff = lines_diff_to_lua(c_diff)
+  lib.free_lines_diff(c_diff)
+  return lua_diff
+end
+
+-- compute_diff() on many file pairs at once, spread over native threads
+-- (largest files first). pairs is a list of
+-- { original = lines, modified = lines, options = table|nil }; a pair
+-- without options uses the shared options. threads = nil uses every core.
+-- Returns one Lua LinesDiff per pair, in order.
+function M.compute_diff_batch(pairs, options, threads)
+  local count = #pairs
+  if count == 0 then
+    return {}
+  end
+
+  local c_jobs = ffi.new("DiffBatchJob[?]", count)
+  local c_results = ffi.new("LinesDiff*[?]", count)
+  -- Every C array must stay referenced until the call returns
+  local keep_alive = {}
+  local shared_options = lua_to_c_options(options)
+  keep_alive[#keep_alive + 1] = shared_options
+
+  for i = 1, count do
+    local pair = pairs[i]
+    local job = c_jobs[i - 1]
+    local c_orig, orig_count, orig_lengths = lua_to_c_strings(pair.original)
+    local c_mod, mod_count, mod_lengths = lua_to_c_strings(pair.modified)
+    job.original_lines = c_orig
+    job.original_lengths = orig_lengths
+    job.original_count = orig_count
+    job.modified_lines = c_mod
+    job.modified_lengths = mod_lengths
+    job.modified_count = mod_count
+    if pair.options then
+      local c_options = lua_to_c_options(pair.options)
+      keep_alive[#keep_alive + 1] = c_options
+      job.options = c_options
+    else
+      job.options = shared_options
+    end
+    keep_alive[#keep_alive + 1] = { c_orig, orig_lengths, c_mod, mod_lengths }
+  end
+
+  lib.compute_diff_batch(c_jobs, count, threads or 0, get_cache(), c_results)
+
+  local results = {}
+  local failed = false
+  for i = 1, count do
+    local c_diff = c_results[i - 1]
+    if c_diff == nil then
+      failed = true
+    else
+      results[i] = lines_diff_to_lua(c_diff)
+      lib.free_lines_diff(c_diff)
+    end
+  end
+
+  if failed then
+    error("compute_diff_batch returned NULL")
+  end
+  return results
+end
+
+local MERGE_REGION_KINDS = { [0] = "ours", "theirs", "both_same", "conflict" }
+
+local function inner_changes_to_lua(c_changes, count)
+  local changes = {}
+  if c_changes ~= nil then
+    for i = 0, count - 1 do
+      table.insert(changes, range_mapping_to_lua(c_changes[i]))
+    end
+  end
+  return changes
+end
+
+-- Three-way diff for merge-conflict views: base against ours and theirs,
+-- with all three sides hashed once and both line diffs run in parallel.
+-- Returns { regions = { { kind = "ours"|"theirs"|"both_same"|"conflict",
+-- base, ours, theirs = line ranges, ours_inner_changes,
+-- theirs_inner_changes = base->side char ranges (conflicts only) } },
+-- hit_timeout, hit_memory_limit }. Lines outside all regions are unchanged.
+function M.compute_three_way_diff(base_lines, ours_lines, theirs_lines, options)
+  local c_base, base_count, base_lengths = lua_to_c_strings(base_lines)
+  local c_ours, ours_count, ours_lengths = lua_to_c_strings(ours_lines)
+  local c_theirs, theirs_count, theirs_lengths = lua_to_c_strings(theirs_lines)
+
+  local c_diff = lib.compute_three_way_diff(c_base, base_lengths, base_count,
+    c_ours, ours_lengths, ours_count, c_theirs, theirs_lengths, theirs_count,
+    lua_to_c_options(options))
+  if c_diff == nil then
+    error("compute_three_way_diff returned NULL")
+  end
+
+  local regions = {}
+  for i = 0, c_diff.count - 1 do
+    local c_region = c_diff.regions[i]
+    table.insert(regions, {
+      kind = MERGE_REGION_KINDS[tonumber(c_region.kind)],
+      base = line_range_to_lua(c_region.base),
+      ours = line_range_to_lua(c_region.ours),
+      theirs = line_range_to_lua(c_region.theirs),
+      ours_inner_changes = inner_changes_to_lua(c_region.ours_inner_changes,
+        c_region.ours_inner_change_count),
+      theirs_inner_changes = inner_changes_to_lua(c_region.theirs_inner_changes,
+        c_region.theirs_inner_change_count)
+    })
+  end
+
+  local result = {
+    regions = regions,
+    hit_timeout = c_diff.hit_timeout,
+    hit_memory_limit = c_diff.hit_memory_limit
+  }
+  lib.free_three_way_diff(c_diff)
+  return result
+end
+
+-- compute_diff() that also returns where the time went (stats table, see
+-- stats_to_lua). Bypasses the result cache so the numbers are real.
+function M.compute_diff_with_stats(original_lines, modified_lines, options)
+  local c_orig, orig_count = lua_to_c_strings(original_lines)
+  local c_mod, mod_count = lua_to_c_strings(modified_lines)
+  local c_stats = ffi.new("DiffStats")
+
+  local c_diff = lib.compute_diff_with_stats(c_orig, orig_count, c_mod, mod_count,
+    lua_to_c_options(options), c_stats)
+  if c_diff == nil then
+    error("compute_diff_with_stats returned NULL")
+  end
+
+  local lua_diff = lines_diff_to_lua(c_diff)
+  lib.free_lines_diff(c_diff)
+  last_stats = stats_to_lua(c_stats)
+  return lua_diff, last_stats
+end
+
+-- Stats of the last async diff or compute_diff_with_stats() call, or nil
+function M.last_stats()
+  return last_stats
+end
+
+-- Render plan: line highlights, char highlights and fillers computed in C.
+-- Fields left/right are the C SideRenderPlan structs (0-based arrays);
+-- first_change holds the start lines of the first change, or nil.
+local function wrap_render_plan(c_plan, first_change)
+  if c_plan == nil then
+    error("generate_render_plan returned NULL")
+  end
+
+  local handle = ffi.gc(c_plan, lib.free_render_plan)
+  return {
+    handle = handle,
+    left = handle.left,
+    right = handle.right,
+    first_change = first_change,
+  }
+end
+
+-- Index of the first hunk (0-based) of a plan side ending after a 1-based line
+function M.find_hunk(side, line)
+  return lib.render_plan_find_hunk(side, line)
+end
+
+-- Start lines of the first change of a C LinesDiff, or nil
+local function first_change_of(c_diff)
+  if c_diff.changes.count == 0 then
+    return nil
+  end
+
+  local mapping = c_diff.changes.mappings[0]
+  return {
+    original = mapping.original.start_line,
+    modified = mapping.modified.start_line,
+  }
+end
+
+-- Compute diff and render plan in one pass, without building Lua tables
+function M.compute_render_plan(original_lines, modified_lines, options)
+  local c_orig, orig_count, orig_lengths = lua_to_c_strings(original_lines)
+  local c_mod, mod_count, mod_lengths = lua_to_c_strings(modified_lines)
+  local c_diff = compute_c_diff(c_orig, orig_count, orig_lengths, c_mod, mod_count, mod_lengths, options)
+
+  if c_diff == nil then
+    error("compute_diff returned NULL")
+  end
+
+  local first_change = first_change_of(c_diff)
+  local c_plan = lib.generate_render_plan_n(c_diff, c_orig, orig_lengths, orig_count,
+    c_mod, mod_lengths, mod_count)
+  lib.free_lines_diff(c_diff)
+
+  return wrap_render_plan(c_plan, first_change)
+end
+
+-- Build a render plan from a Lua LinesDiff table (compute_diff() shape)
+function M.lines_diff_to_render_plan(lines_diff, original_lines, modified_lines)
+  local c_orig, orig_count, orig_lengths = lua_to_c_strings(original_lines)
+  local c_mod, mod_count, mod_lengths = lua_to_c_strings(modified_lines)
+
+  local changes = lines_diff.changes
+  local inner_total = 0
+  for _, mapping in ipairs(changes) do
+    inner_total = inner_total + (mapping.inner_changes and #mapping.inner_changes or 0)
+  end
+
+  -- One array per level; the locals keep them alive during the call
+  local c_diff = ffi.new("LinesDiff")
+  local c_mappings = ffi.new("DetailedLineRangeMapping[?]", math.max(#changes, 1))
+  local c_inner = ffi.new("RangeMapping[?]", math.max(inner_total, 1))
+  local next_inner = 0
+
+  local function set_char_range(c_range, range)
+    c_range.start_line = range.start_line
+    c_range.start_col = range.start_col
+    c_range.end_line = range.end_line
+    c_range.end_col = range.end_col
+  end
+
+  for i, mapping in ipairs(changes) do
+    local c_mapping = c_mappings[i - 1]
+    c_mapping.original.start_line = mapping.original.start_line
+    c_mapping.original.end_line = mapping.original.end_line
+    c_mapping.modified.start_line = mapping.modified.start_line
+    c_mapping.modified.end_line = mapping.modified.end_line
+
+    local inner_changes = mapping.inner_changes or {}
+    if #inner_changes > 0 then
+      c_mapping.inner_changes = c_inner + next_inner
+      c_mapping.inner_change_count = #inner_changes
+      for _, inner in ipairs(inner_changes) do
+        set_char_range(c_inner[next_inner].original, inner.original)
+        set_char_range(c_inner[next_inner].modified, inner.modified)
+        next_inner = next_inner + 1
+      end
+    end
+  end
+
+  c_diff.changes.mappings = c_mappings
+  c_diff.changes.count = #changes
+  c_diff.changes.capacity = #changes
+
+  local first_change = nil
+  if #changes > 0 then
+    first_change = {
+      original = changes[1].original.start_line,
+      modified = changes[1].modified.start_line,
+    }
+  end
+
+  local c_plan = lib.generate_render_plan_n(c_diff, c_orig, orig_lengths, orig_count,
+    c_mod, mod_lengths, mod_count)
+
+  return wrap_render_plan(c_plan, first_change)
+end
+
+-- Flat diff view: indexes the C-owned buffer directly, no tables per change.
+-- Strides match FLAT_*_STRIDE in flat_lines_diff.h; all indices are 1-based.
+local FlatDiff = {}
+FlatDiff.__index = FlatDiff
+
+local CHANGE_STRIDE = 4
+local INNER_STRIDE = 8
+local MOVE_STRIDE = 6
+
+-- Compute diff into a flat buffer
+-- Returns a FlatDiff view; the buffer is freed when the view is collected
+function M.compute_diff_flat(original_lines, modified_lines, options)
+  local c_orig, orig_count = lua_to_c_strings(original_lines)
+  local c_mod, mod_count = lua_to_c_strings(modified_lines)
+  local c_flat = lib.compute_diff_flat(c_orig, orig_count, c_mod, mod_count, lua_to_c_options(options))
+
+  if c_flat == nil then
+    error("compute_diff_flat returned NULL")
+  end
+
+  return setmetatable({
+    handle = ffi.gc(c_flat, lib.free_flat_lines_diff),
+    change_count = c_flat.change_count,
+    move_count = c_flat.move_count,
+    hit_timeout = c_flat.hit_timeout ~= 0,
+    hit_memory_limit = c_flat.hit_memory_limit ~= 0,
+    changes = c_flat.changes,
+    inner_offsets = c_flat.inner_offsets,
+    inner_changes = c_flat.inner_changes,
+    moves = c_flat.moves,
+  }, FlatDiff)
+end
+
+-- Line ranges of change i: orig_start, orig_end, mod_start, mod_end (end-exclusive).
+-- Changes of moved blocks follow the top-level ones (see FlatDiff:move()).
+function FlatDiff:change(i)
+  local c = self.changes
+  local base = (i - 1) * CHANGE_STRIDE
+  return c[base], c[base + 1], c[base + 2], c[base + 3]
+end
+
+-- Inner changes of change i as an inclusive index range (empty when first > last)
+function FlatDiff:inner_range(i)
+  return self.inner_offsets[i - 1] + 1, self.inner_offsets[i]
+end
+
+-- Inner change j: original start_line, start_col, end_line, end_col, then modified
+function FlatDiff:inner_change(j)
+  local c = self.inner_changes
+  local base = (j - 1) * INNER_STRIDE
+  return c[base], c[base + 1], c[base + 2], c[base + 3],
+         c[base + 4], c[base + 5], c[base + 6], c[base + 7]
+end
+
+-- Move i: orig_start, orig_end, mod_start, mod_end, first change index, change count
+function FlatDiff:move(i)
+  local c = self.moves
+  local base = (i - 1) * MOVE_STRIDE
+  return c[base], c[base + 1], c[base + 2], c[base + 3], c[base + 4] + 1, c[base + 5]
+end
+
+local function flat_change_to_lua(flat, i)
+  local orig_start, orig_end, mod_start, mod_end = flat:change(i)
+  local inner_changes = {}
+  local first, last = flat:inner_range(i)
+
+  for j = first, last do
+    local osl, osc, oel, oec, msl, msc, mel, mec = flat:inner_change(j)
+    inner_changes[#inner_changes + 1] = {
+      original = { start_line = osl, start_col = osc, end_line = oel, end_col = oec },
+      modified = { start_line = msl, start_col = msc, end_line = mel, end_col = mec },
+    }
+  end
+
+  return {
+    original = { start_line = orig_start, end_line = orig_end },
+    modified = { start_line = mod_start, end_line = mod_end },
+    inner_changes = inner_changes,
+  }
+end
+
+-- Materialize the same table shape as compute_diff()
+function FlatDiff:to_table()
+  local changes = {}
+  for i = 1, self.change_count do
+    changes[i] = flat_change_to_lua(self, i)
+  end
+
+  local moves = {}
+  for i = 1, self.move_count do
+    local orig_start, orig_end, mod_start, mod_end, first, count = self:move(i)
+    local move_changes = {}
+    for k = 0, count - 1 do
+      move_changes[k + 1] = flat_change_to_lua(self, first + k)
+    end
+    moves[i] = {
+      original = { start_line = orig_start, end_line = orig_end },
+      modified = { start_line = mod_start, end_line = mod_end },
+      changes = move_changes,
+    }
+  end
+
+  return {
+    changes = changes,
+    moves = moves,
+    hit_timeout = self.hit_timeout,
+    hit_memory_limit = self.hit_memory_limit,
+  }
+end
+
+-- Incremental diff session for buffers that change while the diff is shown.
+-- The C side keeps copies of both sides and re-diffs only around each edit.
+local Session = {}
+Session.__index = Session
+
+local session_sides = {
+  original = lib.DIFF_SIDE_ORIGINAL,
+  modified = lib.DIFF_SIDE_MODIFIED,
+}
+
+-- Create a session over two sets of lines (copied by the C side)
+function M.create_session(original_lines, modified_lines, options)
+  local c_orig, orig_count = lua_to_c_strings(original_lines)
+  local c_mod, mod_count = lua_to_c_strings(modified_lines)
+  local c_session = lib.diff_session_create(c_orig, orig_count, c_mod, mod_count, lua_to_c_options(options))
+
+  if c_session == nil then
+    error("diff_session_create returned NULL")
+  end
+
+  return setmetatable({ handle = ffi.gc(c_session, lib.diff_session_destroy) }, Session)
+end
+
+-- Apply an edit to one side ("original" or "modified").
+-- Same arguments as nvim_buf_set_lines(): 0-based first, exclusive last.
+function Session:edit(side, first, last, new_lines)
+  local c_side = session_sides[side]
+  if c_side == nil then
+    error("invalid session side: " .. tostring(side))
+  end
+
+  local c_lines, count = lua_to_c_strings(new_lines or {})
+  if not lib.diff_session_edit(self.handle, c_side, first, last - first, c_lines, count) then
+    error("diff_session_edit failed")
+  end
+end
+
+-- Re-diff both sides in full
+function Session:recompute()
+  if not lib.diff_session_recompute(self.handle) then
+    error("diff_session_recompute failed")
+  end
+end
+
+-- Current diff as a Lua table (same shape as compute_diff())
+function Session:get()
+  return lines_diff_to_lua(lib.diff_session_get_diff(self.handle))
+end
+
+-- Release the session now instead of waiting for garbage collection
+function Session:close()
+  if self.handle ~= nil then
+    lib.diff_session_destroy(ffi.gc(self.handle, nil))
+    self.handle = nil
+  end
+end
+
+-- Asynchronous diffs run on a C worker thread. Completion wakes the event
+-- loop through the job's descriptor, or a polling timer where there is none.
+local uv = vim.uv or vim.loop
+
+-- Status poll interval when the job has no completion descriptor (ms)
+local ASYNC_POLL_MS = 10
+
+local AsyncJob = {}
+AsyncJob.__index = AsyncJob
+
+-- background: run at the lowest thread priority and leave last_stats alone
+local function start_async(original_lines, modified_lines, options, build_render_plan, collect, callback,
+                           background)
+  local c_orig, orig_count = lua_to_c_strings(original_lines)
+  local c_mod, mod_count = lua_to_c_strings(modified_lines)
+  local start = background and lib.diff_async_start_background or lib.diff_async_start
+  local c_job = start(c_orig, orig_count, c_mod, mod_count,
+    lua_to_c_options(options), build_render_plan, get_cache())
+
+  if c_job == nil then
+    error("diff_async_start returned NULL")
+  end
+
+  local job = setmetatable({ handle = ffi.gc(c_job, lib.diff_async_destroy) }, AsyncJob)
+
+  local function finish()
+    local cancelled = job.cancelled
+    local status = lib.diff_async_status(job.handle)
+    local ok, result = true, nil
+    if not cancelled and status == lib.DIFF_ASYNC_DONE then
+      if not background then
+        last_stats = stats_to_lua(lib.diff_async_get_stats(job.handle))
+      end
+      ok, result = pcall(collect, job.handle)
+    end
+    job:_close()
+
+    if cancelled or status == lib.DIFF_ASYNC_CANCELLED then
+      return
+    end
+    if status ~= lib.DIFF_ASYNC_DONE then
+      callback("diff computation failed", nil)
+    elseif not ok then
+      callback(tostring(result), nil)
+    else
+      callback(nil, result)
+    end
+  end
+
+  local fd = lib.diff_async_fd(c_job)
+  if fd >= 0 then
+    job.watcher = uv.new_poll(fd)
+    job.watcher:start("r", function()
+      job.watcher:stop()
+      vim.schedule(finish)
+    end)
+  else
+    job.watcher = uv.new_timer()
+    job.watcher:start(ASYNC_POLL_MS, ASYNC_POLL_MS, function()
+      if lib.diff_async_status(job.handle) ~= lib.DIFF_ASYNC_RUNNING then
+        job.watcher:stop()
+        vim.schedule(finish)
+      end
+    end)
+  end
+
+  return job
+end
+
+-- Stop the job; its callback will not be called. The worker is released once
+-- it has noticed the cancellation, so this never blocks.
+function AsyncJob:cancel()
+  if self.handle ~= nil and not self.cancelled then
+    self.cancelled = true
+    lib.diff_async_cancel(self.handle)
+  end
+end
+
+function AsyncJob:_close()
+  if self.watcher ~= nil then
+    self.watcher:stop()
+    self.watcher:close()
+    self.watcher = nil
+  end
+  if self.handle ~= nil then
+    lib.diff_async_destroy(ffi.gc(self.handle, nil))
+    self.handle = nil
+  end
+end
+
+-- compute_diff() on a worker thread. callback(err, lines_diff) runs on the
+-- main loop; returns a job with :cancel().
+function M.compute_diff_async(original_lines, modified_lines, options, callback)
+  return start_async(original_lines, modified_lines, options, false, function(c_job)
+    return lines_diff_to_lua(lib.diff_async_get_diff(c_job))
+  end, callback)
+end
+
+-- compute_render_plan() on a worker thread, diff and plan both built there.
+-- callback(err, plan) runs on the main loop; returns a job with :cancel().
+function M.compute_render_plan_async(original_lines, modified_lines, options, callback)
+  return start_async(original_lines, modified_lines, options, true, function(c_job)
+    local first_change = first_change_of(lib.diff_async_get_diff(c_job))
+    return wrap_render_plan(lib.diff_async_take_render_plan(c_job), first_change)
+  end, callback)
+end
+
+-- compute_diff() into the result cache at background priority, so a later
+-- diff of the same lines and options is a cache hit. callback(err) runs on
+-- the main loop; returns a job with :cancel(), or nil without a cache.
+function M.prefetch_diff_async(original_lines, modified_lines, options, callback)
+  if get_cache() == nil then
+    return nil
+  end
+  return start_async(original_lines, modified_lines, options, false, function()
+    return nil
+  end, callback, true)
+end
+
 -- Get library version
 function M.get_version()
   return ffi.string(lib.get_version())
@@ -77,28 +77,232 @@ local function run_git_async(args, opts, callback)
   end
 end
 
--- Get git root directory for the given file
+-- ============================================================================
+-- Persistent blob reader
+-- ============================================================================
+-- One long-lived `git cat-file --batch` process per repository root. Object
+-- names are written to its stdin back to back and git answers them in order,
+-- so requests are pipelined and their callbacks form a FIFO queue. Each
+-- answer is either
+--   <oid> <type> <size>\n<content>\n
+-- or
+--   <object> missing\n   (also "ambiguous")
+-- Callbacks get (err, content, type, oid) and run on the main loop
+-- (vim.schedule).
+
+local batches = {}
+
+local function batch_deliver(callback, err, content, object_type, oid)
+  vim.schedule(function()
+    callback(err, content, object_type, oid)
+  end)
+end
+
+local function batch_close(batch, err)
+  if batches[batch.root] == batch then
+    batches[batch.root] = nil
+  end
+  batch.closed = true
+  for _, request in ipairs(batch.queue) do
+    batch_deliver(request.callback, err, nil)
+  end
+  batch.queue = {}
+  if batch.stdin and not batch.stdin:is_closing() then batch.stdin:close() end
+  if batch.stdout and not batch.stdout:is_closing() then batch.stdout:close() end
+end
+
+-- Consume one chunk of stdout: headers, then bodies of known size. Bodies are
+-- collected as chunks and joined once, so big blobs are not copied per read.
+local function batch_on_data(batch, data)
+  while data and #data > 0 do
+    local body = batch.body
+    if body then
+      local need = body.size + 1 - body.have -- content plus git's trailing "\n"
+      if #data < need then
+        table.insert(body.chunks, data)
+        body.have = body.have + #data
+        return
+      end
+      table.insert(body.chunks, data:sub(1, need))
+      data = data:sub(need + 1)
+      batch.body = nil
+      local request = table.remove(batch.queue, 1)
+      local content = table.concat(body.chunks)
+      batch_deliver(request.callback, nil, content:sub(1, body.size), body.type, body.oid)
+    else
+      data = batch.pending .. data
+      batch.pending = ""
+      local newline = data:find("\n", 1, true)
+      if not newline then
+        batch.pending = data
+        return
+      end
+      local header = data:sub(1, newline - 1)
+      data = data:sub(newline + 1)
+      local oid, object_type, size = header:match("^(%x+) (%S+) (%d+)$")
+      if oid then
+        batch.body = { oid = oid, type = object_type, size = tonumber(size), have = 0, chunks = {} }
+      else
+        local request = table.remove(batch.queue, 1)
+        if request then
+          batch_deliver(request.callback, header, nil)
+        end
+      end
+    end
+  end
+end
+
+-- Blob reader for a repository root, spawned on first use (nil if git can't
+-- be started)
+local function get_batch(git_root)
+  local batch = batches[git_root]
+  if batch then
+    return batch
+  end
+
+  local stdin = vim.loop.new_pipe(false)
+  local stdout = vim.loop.new_pipe(false)
+  batch = { root = git_root, queue = {}, pending = "", body = nil, stdin = stdin, stdout = stdout }
+
+  ---@diagnostic disable-next-line: missing-fields
+  local handle = vim.loop.spawn("git", {
+    args = { "cat-file", "--batch" },
+    cwd = git_root,
+    stdio = { stdin, stdout, nil },
+  }, function()
+    batch_close(batch, "git cat-file exited")
+    if batch.handle and not batch.handle:is_closing() then
+      batch.handle:close()
+    end
+  end)
+
+  if not handle then
+    stdin:close()
+    stdout:close()
+    return nil
+  end
+  batch.handle = handle
+
+  stdout:read_start(function(err, data)
+    if err then
+      batch_close(batch, err)
+    elseif data then
+      batch_on_data(batch, data)
+    end
+  end)
+
+  batches[git_root] = batch
+  return batch
+end
+
+-- Queue one object name ("rev:path", "rev^{commit}", ...) on a reader
+-- callback: function(err, content, type, oid)
+local function batch_request(batch, object, callback)
+  if batch.closed then
+    batch_deliver(callback, "git cat-file exited", nil)
+    return
+  end
+  if object:find("\n", 1, true) then
+    batch_deliver(callback, "Object name contains a newline", nil)
+    return
+  end
+  table.insert(batch.queue, { callback = callback })
+  batch.stdin:write(object .. "\n")
+end
+
+-- Stop every blob reader (pending requests fail)
+function M.shutdown()
+  for _, batch in pairs(batches) do
+    batch_close(batch, "git cat-file stopped")
+  end
+end
+
+-- ============================================================================
+-- Repository roots and revisions
+-- ============================================================================
+
+-- Repository root of each directory asked about. Only hits are kept: a
+-- directory outside a repository may still become one (git init).
+local root_cache = {}
+
+-- Revisions resolved to commit ids, per repository root. Full object ids
+-- never move and are kept; symbolic names (HEAD, branches, HEAD~1) are
+-- reused for REVISION_TTL_MS, so opening a batch of files resolves them once
+-- while a new commit is still picked up soon after.
+local REVISION_TTL_MS = 2000
+local revision_cache = {}
+
+local function is_full_object_id(revision)
+  return (#revision == 40 or #revision == 64) and revision:match("^%x+$") ~= nil
+end
+
+local function cached_revision(git_root, revision)
+  local entry = revision_cache[git_root .. "\0" .. revision]
+  if not entry then
+    return nil
+  end
+  if entry.expires and vim.loop.now() > entry.expires then
+    revision_cache[git_root .. "\0" .. revision] = nil
+    return nil
+  end
+  return entry.oid
+end
+
+-- Resolve a revision to a commit id through the repository's blob reader
+-- callback: function(err, oid)
+local function resolve_revision(git_root, batch, revision, callback)
+  local oid = cached_revision(git_root, revision)
+  if oid then
+    vim.schedule(function()
+      callback(nil, oid)
+    end)
+    return
+  end
+
+  batch_request(batch, revision .. "^{commit}", function(err, _, _, commit_oid)
+    if err then
+      callback(err, nil)
+      return
+    end
+    revision_cache[git_root .. "\0" .. revision] = {
+      oid = commit_oid,
+      expires = not is_full_object_id(revision) and vim.loop.now() + REVISION_TTL_MS or nil,
+    }
+    callback(nil, commit_oid)
+  end)
+end
+
+-- Clear the repository root and revision caches
+function M.clear_cache()
+  root_cache = {}
+  revision_cache = {}
+end
+
+-- Get git root directory for the given file (cached per directory)
 function M.get_git_root(file_path)
   local dir = vim.fn.fnamemodify(file_path, ":h")
+  local cached = root_cache[dir]
+  if cached then
+    return cached
+  end
 
+  local root = nil
   -- Run synchronously for simplicity in this case
-  local result = vim.system and
-    vim.system({ "git", "rev-parse", "--show-toplevel" }, { cwd = dir, text = true }):wait()
-    or nil
-
   if vim.system then
+    local result = vim.system({ "git", "rev-parse", "--show-toplevel" }, { cwd = dir, text = true }):wait()
     if result and result.code == 0 then
-      return vim.trim(result.stdout)
+      root = vim.trim(result.stdout)
     end
   else
     -- Fallback for older Neovim
     local output = vim.fn.systemlist({ "git", "-C", dir, "rev-parse", "--show-toplevel" })
     if vim.v.shell_error == 0 and #output > 0 then
-      return output[1]
+      root = output[1]
     end
   end
 
-  return nil
+  root_cache[dir] = root
+  return root
 end
 
 -- Get relative path of file within git repository
@@ -113,10 +317,27 @@ function M.is_in_git_repo(file_path)
   return M.get_git_root(file_path) ~= nil
 end
 
+-- Split blob content into lines like the old `git show` path did
+local function content_to_lines(content)
+  local lines = vim.split(content, "\n")
+
+  -- Remove last empty line if present
+  if lines[#lines] == "" then
+    table.remove(lines, #lines)
+  end
+
+  return lines
+end
+
 -- Get file content from a specific git revision
 -- revision: e.g., "HEAD", "HEAD~1", commit hash, branch name, tag
 -- file_path: absolute path to the file
 -- callback: function(err, lines) where lines is a table of strings
+--
+-- Goes through the repository's `git cat-file --batch` reader. When the
+-- revision is not resolved yet, its lookup is queued right before the blob,
+-- so there is still one round trip and a missing blob can be told apart
+-- from a bad revision.
 function M.get_file_at_revision(revision, file_path, callback)
   local git_root = M.get_git_root(file_path)
 
@@ -125,13 +346,16 @@ function M.get_file_at_revision(revision, file_path, callback)
     return
   end
 
-  local rel_path = M.get_relative_path(file_path, git_root)
-  local git_object = revision .. ":" .. rel_path
+  M.get_repo_file_at_revision(git_root, revision, M.get_relative_path(file_path, git_root), callback)
+end
 
-  run_git_async(
-    { "show", git_object },
-    { cwd = git_root },
-    function(err, output)
+-- get_file_at_revision() for a path relative to a known repository root
+-- (skips the root lookup, which runs git synchronously once per directory)
+function M.get_repo_file_at_revision(git_root, revision, rel_path, callback)
+  local batch = get_batch(git_root)
+  if not batch then
+    -- git could not be started as a reader: one process for this file
+    run_git_async({ "show", revision .. ":" .. rel_path }, { cwd = git_root }, function(err, output)
       if err then
         -- Try to provide better error messages
         if err:match("does not exist") or err:match("exists on disk, but not in") then
@@ -141,16 +365,63 @@ function M.get_file_at_revision(revision, file_path, callback)
         end
         return
       end
+      callback(nil, content_to_lines(output))
+    end)
+    return
+  end
 
-      -- Split output into lines
-      local lines = vim.split(output, "\n")
+  local oid = cached_revision(git_root, revision)
+  local revision_ok = oid ~= nil
+  if not oid then
+    resolve_revision(git_root, batch, revision, function(err)
+      revision_ok = err == nil
+    end)
+  end
 
-      -- Remove last empty line if present
-      if lines[#lines] == "" then
-        table.remove(lines, #lines)
+  batch_request(batch, (oid or revision) .. ":" .. rel_path, function(err, content, object_type)
+    if err then
+      if revision_ok then
+        callback(string.format("File '%s' not found in revision '%s'", rel_path, revision), nil)
+      else
+        callback(string.format("Invalid revision '%s'", revision), nil)
       end
+      return
+    end
+    if object_type ~= "blob" then
+      callback(string.format("'%s' is not a file in revision '%s'", rel_path, revision), nil)
+      return
+    end
+
+    callback(nil, content_to_lines(content))
+  end)
+end
 
-      callback(nil, lines)
+-- Files of the working tree that differ from HEAD and still exist: modified
+-- in the index or the working tree (added, deleted, renamed, unmerged and
+-- untracked files have no pair to diff)
+-- callback: function(err, rel_paths, status) on the main loop, where status
+-- is the raw `git status` output, for telling whether anything changed
+function M.get_modified_files(git_root, callback)
+  run_git_async(
+    { "status", "--porcelain=v1", "-z", "--untracked-files=no", "--no-renames" },
+    { cwd = git_root },
+    function(err, output)
+      vim.schedule(function()
+        if err then
+          callback(err, nil, nil)
+          return
+        end
+
+        local files = {}
+        -- NUL-terminated "XY path" entries; paths are not quoted with -z
+        for entry in output:gmatch("([^%z]+)%z") do
+          local x, y, path = entry:sub(1, 1), entry:sub(2, 2), entry:sub(4)
+          if (x == "M" or y == "M") and x ~= "D" and y ~= "D" and x ~= "A" then
+            table.insert(files, path)
+          end
+        end
+        callback(nil, files, output)
+      end)
     end
   )
 end
@@ -164,17 +435,29 @@ function M.validate_revision(revision, file_path, callback)
     return
   end
 
-  run_git_async(
-    { "rev-parse", "--verify", revision },
-    { cwd = git_root },
-    function(err)
-      if err then
-        callback(string.format("Invalid revision '%s': %s", revision, err))
-      else
-        callback(nil)
+  local batch = get_batch(git_root)
+  if not batch then
+    run_git_async(
+      { "rev-parse", "--verify", revision },
+      { cwd = git_root },
+      function(err)
+        if err then
+          callback(string.format("Invalid revision '%s': %s", revision, err))
+        else
+          callback(nil)
+        end
       end
+    )
+    return
+  end
+
+  resolve_revision(git_root, batch, revision, function(err)
+    if err then
+      callback(string.format("Invalid revision '%s': %s", revision, err))
+    else
+      callback(nil)
     end
-  )
+  end)
 end
 
 return M
@@ -5,14 +5,26 @@ local config = require("vscode-diff.config")
 local diff = require("vscode-diff.diff")
 local render = require("vscode-diff.render")
 local git = require("vscode-diff.git")
+local prefetch = require("vscode-diff.prefetch")
 
 -- Configuration setup
 function M.setup(opts)
   config.setup(opts)
+  if config.options.prefetch.enabled then
+    prefetch.enable()
+  else
+    prefetch.disable()
+  end
 end
 
 -- Re-export diff module
 M.compute_diff = diff.compute_diff
+M.compute_diff_batch = diff.compute_diff_batch
+M.compute_three_way_diff = diff.compute_three_way_diff
+M.compute_render_plan = diff.compute_render_plan
+M.compute_diff_async = diff.compute_diff_async
+M.compute_render_plan_async = diff.compute_render_plan_async
+M.prefetch_diff_async = diff.prefetch_diff_async
 M.get_version = diff.get_version
 
 -- Re-export render module
@@ -24,4 +36,9 @@ M.create_diff_view = render.create_diff_view
 M.is_in_git_repo = git.is_in_git_repo
 M.get_file_at_revision = git.get_file_at_revision
 
+-- Re-export prefetch module
+M.enable_prefetch = prefetch.enable
+M.disable_prefetch = prefetch.disable
+M.prefetch_status = prefetch.status
+
 return M
@@ -0,0 +1,214 @@
+-- Background prefetch of diffs for changed files in the working tree
+--
+-- When `git status` changes, every file modified against the revision is
+-- queued. For each one the base blob comes through the repository's blob
+-- reader and the diff against the file (its loaded buffer, else the file on
+-- disk) is computed on a background-priority worker into the C result cache.
+-- `:VscodeDiff <revision>` on that file is then a cache hit.
+--
+-- One diff runs at a time, and none is started while the user is typing:
+-- every key press pushes the next start back by prefetch.idle_ms. The diff
+-- already running keeps going at its low thread priority.
+--
+-- Status is checked when prefetching starts, after writes, on focus and
+-- after shell commands.
+local M = {}
+
+local git = require("vscode-diff.git")
+local diff = require("vscode-diff.diff")
+local config = require("vscode-diff.config")
+
+local uv = vim.uv or vim.loop
+
+-- Prefetcher state while enabled, nil otherwise
+local state = nil
+
+local function options()
+  return config.options.prefetch or {}
+end
+
+-- Lines handle_git_diff() would diff against: the loaded buffer if there is
+-- one, else the file (nil when it is missing or too large)
+local function working_lines(path)
+  local bufnr = vim.fn.bufnr(path)
+  if bufnr ~= -1 and vim.api.nvim_buf_is_loaded(bufnr) then
+    return vim.api.nvim_buf_get_lines(bufnr, 0, -1, false)
+  end
+  local stat = uv.fs_stat(path)
+  if not stat or stat.type ~= "file" or stat.size > (options().max_file_bytes or math.huge) then
+    return nil
+  end
+  return vim.fn.readfile(path)
+end
+
+local pump
+
+-- Start the next queued diff once the user has been idle long enough
+pump = function()
+  if not state or state.job or state.fetching then
+    return
+  end
+  if #state.queue == 0 then
+    return
+  end
+
+  local wait = state.last_key + (options().idle_ms or 0) - uv.now()
+  if wait > 0 then
+    state.timer:stop()
+    state.timer:start(wait, 0, vim.schedule_wrap(pump))
+    return
+  end
+
+  local rel_path = table.remove(state.queue, 1)
+  state.queued[rel_path] = nil
+  local current = state
+  local path = current.root .. "/" .. rel_path
+  local revision = options().revision or "HEAD"
+
+  current.fetching = true
+  git.get_repo_file_at_revision(current.root, revision, rel_path, function(err, base_lines)
+    if state ~= current then
+      return
+    end
+    current.fetching = false
+    local lines = not err and working_lines(path) or nil
+    if lines then
+      -- Same lines and options (nil) as handle_git_diff(), so the cache key matches
+      current.job = diff.prefetch_diff_async(base_lines, lines, nil, function()
+        if state == current then
+          current.job = nil
+          current.done = current.done + 1
+          pump()
+        end
+      end)
+    end
+    if not current.job then
+      pump()
+    end
+  end)
+end
+
+local function queue_file(rel_path)
+  if state.queued[rel_path] or #state.queue >= (options().max_files or math.huge) then
+    return
+  end
+  state.queued[rel_path] = true
+  table.insert(state.queue, rel_path)
+end
+
+-- Re-read `git status`; queue every modified file when it changed (or the one
+-- written file, whose content changed without changing the status)
+local function refresh(written_path)
+  if not state then
+    return
+  end
+  if state.status_running then
+    state.status_again = true
+    return
+  end
+
+  local current = state
+  current.status_running = true
+  git.get_modified_files(current.root, function(err, files, status)
+    if state ~= current then
+      return
+    end
+    current.status_running = false
+    if not err then
+      local written = written_path and git.get_relative_path(written_path, current.root)
+      for _, rel_path in ipairs(files) do
+        if status ~= current.status or rel_path == written then
+          queue_file(rel_path)
+        end
+      end
+      current.status = status
+      pump()
+    end
+    if current.status_again then
+      current.status_again = false
+      refresh()
+    end
+  end)
+end
+
+--- Start prefetching for the repository containing `dir` (default: the
+-- working directory). Needs the result cache (cache.entries > 0).
+-- @return boolean: true if prefetching runs
+function M.enable(dir)
+  M.disable()
+
+  local root = git.get_git_root((dir or vim.fn.getcwd()) .. "/")
+  if not root then
+    return false
+  end
+  -- Without a cache there is nowhere to put the results
+  if not diff.cache_stats() then
+    return false
+  end
+
+  state = {
+    root = root,
+    queue = {},
+    queued = {},
+    status = nil,
+    done = 0,
+    last_key = 0,
+    timer = uv.new_timer(),
+    ns = vim.api.nvim_create_namespace("vscode_diff_prefetch"),
+    augroup = vim.api.nvim_create_augroup("VscodeDiffPrefetch", { clear = true }),
+  }
+
+  vim.on_key(function()
+    if state then
+      state.last_key = uv.now()
+    end
+  end, state.ns)
+
+  vim.api.nvim_create_autocmd("BufWritePost", {
+    group = state.augroup,
+    callback = function(args)
+      refresh(vim.api.nvim_buf_get_name(args.buf))
+    end,
+  })
+  vim.api.nvim_create_autocmd({ "FocusGained", "ShellCmdPost" }, {
+    group = state.augroup,
+    callback = function()
+      refresh()
+    end,
+  })
+
+  refresh()
+  return true
+end
+
+--- Stop prefetching; the running diff is cancelled.
+function M.disable()
+  if not state then
+    return
+  end
+  local current = state
+  state = nil
+
+  vim.on_key(nil, current.ns)
+  vim.api.nvim_del_augroup_by_id(current.augroup)
+  current.timer:stop()
+  current.timer:close()
+  if current.job then
+    current.job:cancel()
+  end
+end
+
+--- Progress: { root, queued, running, done }, or nil when disabled
+function M.status()
+  if not state then
+    return nil
+  end
+  return {
+    root = state.root,
+    queued = #state.queue,
+    running = state.job ~= nil or state.fetching == true,
+    done = state.done,
+  }
+end
+
+return M
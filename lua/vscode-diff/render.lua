@@ -2,10 +2,15 @@
 -- This uses a simplified approach optimized for Neovim's fixed-height grid:
 -- 1. Line-level highlights (dimmed colors) for entire changed line ranges
 -- 2. Character-level highlights (full brightness) for specific changed text
--- 3. Filler lines based on simple empty-range detection
+-- 3. Filler lines for side-by-side alignment
+-- All three come precomputed in the C render plan (render_plan.c).
 
 local M = {}
 local config = require('vscode-diff.config')
+local diff = require('vscode-diff.diff')
+
+-- HighlightType HL_NONE in types.h (unchanged line)
+local HL_NONE = -1
 
 -- Namespaces
 local ns_highlight = vim.api.nvim_create_namespace("vscode-diff-highlight")
@@ -67,24 +72,15 @@ end
 -- Helper Functions
 -- ============================================================================
 
--- Check if a range is empty (start and end are the same position)
-local function is_empty_range(range)
-  return range.start_line == range.end_line and
-         range.start_col == range.end_col
-end
+local set_extmark = vim.api.nvim_buf_set_extmark
 
--- Check if a column position is past the visible line content
--- This detects line-ending-only changes (\r\n handling)
-local function is_past_line_content(line_number, column, lines)
-  if line_number < 1 or line_number > #lines then
-    return true
-  end
-  local line_content = lines[line_number]
-  return column > #line_content
-end
+-- Filler row: diagonal slash pattern (diffview.nvim style) using
+-- "╱" (U+2571 BOX DRAWINGS LIGHT DIAGONAL UPPER RIGHT TO LOWER LEFT).
+-- A large number of characters fills any reasonable window width; rendering
+-- clips it to the actual window width. All filler rows share this chunk.
+local filler_row = {{string.rep("╱", 500), "VscodeDiffFiller"}}
 
 -- Insert virtual filler lines using extmarks
--- Style matching diffview.nvim - uses diagonal slash pattern filling the whole line
 local function insert_filler_lines(bufnr, after_line_0idx, count)
   if count <= 0 then
     return
@@ -95,305 +91,100 @@ local function insert_filler_lines(bufnr, after_line_0idx, count)
     after_line_0idx = 0
   end
 
-  -- Create virtual lines with diagonal slash pattern (diffview.nvim style)
-  -- Uses "╱" (U+2571 BOX DRAWINGS LIGHT DIAGONAL UPPER RIGHT TO LOWER LEFT)
   local virt_lines_content = {}
-
-  -- Use a large number of characters to ensure it fills any reasonable window width
-  -- The rendering will clip it to the actual window width automatically
-  local filler_text = string.rep("╱", 500)
-
-  for _ = 1, count do
-    table.insert(virt_lines_content, {{filler_text, "VscodeDiffFiller"}})
+  for i = 1, count do
+    virt_lines_content[i] = filler_row
   end
 
-  vim.api.nvim_buf_set_extmark(bufnr, ns_filler, after_line_0idx, 0, {
+  set_extmark(bufnr, ns_filler, after_line_0idx, 0, {
     virt_lines = virt_lines_content,
     virt_lines_above = false,
   })
 end
 
 -- ============================================================================
--- Step 1: Line-Level Highlights (Light Colors)
+-- Render Plan Application
 -- ============================================================================
 
--- Apply light background color to entire line ranges in the mapping
--- Uses hl_eol to extend highlight to cover the whole screen line
-local function apply_line_highlights(bufnr, line_range, hl_group)
-  -- Skip empty ranges
-  if line_range.end_line <= line_range.start_line then
-    return
-  end
-
-  -- Get buffer line count to avoid going out of bounds
-  local line_count = vim.api.nvim_buf_line_count(bufnr)
+-- Apply the highlights of lines [first_idx, last_idx) (0-based) of one side.
+-- The plan comes from C (render_plan.c) with one LineMetadata per buffer
+-- line, so a single pass in line order emits:
+-- 1. Line-level highlights (light colors): one hl_eol extmark per run of
+--    consecutive changed lines, priority 100
+-- 2. Character-level highlights (dark colors): one extmark per range, already
+--    split per line and clamped to the line content, priority 200
+-- Option tables are reused across calls; nvim copies them.
+local function apply_side_lines(bufnr, side, first_idx, last_idx, line_hl_group, char_hl_group)
+  local metadata = side.line_metadata
+  local line_opts = { end_line = 0, end_col = 0, hl_group = line_hl_group, hl_eol = true, priority = 100 }
+  local char_opts = { end_col = 0, hl_group = char_hl_group, priority = 200 }
+  local run_start = nil
+
+  for line_idx = first_idx, last_idx - 1 do
+    local meta = metadata[line_idx]
+
+    if meta.type ~= HL_NONE then
+      run_start = run_start or line_idx
+    elseif run_start then
+      line_opts.end_line = line_idx
+      set_extmark(bufnr, ns_highlight, run_start, 0, line_opts)
+      run_start = nil
+    end
 
-  -- Apply highlight to entire lines using hl_eol
-  -- This highlights the entire screen line including the area beyond EOL
-  for line = line_range.start_line, line_range.end_line - 1 do
-    if line > line_count then
-      break
+    local highlights = meta.char_highlights
+    for i = 0, meta.char_highlight_count - 1 do
+      local hl = highlights[i]
+      char_opts.end_col = hl.end_col - 1
+      set_extmark(bufnr, ns_highlight, line_idx, hl.start_col - 1, char_opts)
     end
+  end
 
-    local line_idx = line - 1  -- Convert to 0-indexed
-
-    -- Use hl_eol to extend highlight to the whole screen line
-    -- Priority 100 = lower than char highlights (200) so char highlights remain visible
-    vim.api.nvim_buf_set_extmark(bufnr, ns_highlight, line_idx, 0, {
-      end_line = line_idx + 1,
-      end_col = 0,
-      hl_group = hl_group,
-      hl_eol = true,  -- KEY: Extend highlight to cover the whole screen line
-      priority = 100,
-    })
+  if run_start then
+    line_opts.end_line = last_idx
+    set_extmark(bufnr, ns_highlight, run_start, 0, line_opts)
   end
 end
 
--- ============================================================================
--- Step 2: Character-Level Highlights (Dark Colors)
--- ============================================================================
-
--- Apply character-level highlight for specific changed text
-local function apply_char_highlight(bufnr, char_range, hl_group, lines)
-  local start_line = char_range.start_line
-  local start_col = char_range.start_col
-  local end_line = char_range.end_line
-  local end_col = char_range.end_col
-
-  -- Skip empty ranges
-  if is_empty_range(char_range) then
-    return
-  end
+-- Apply the highlights of one whole side
+local function apply_side_highlights(bufnr, side, line_hl_group, char_hl_group)
+  apply_side_lines(bufnr, side, 0, side.line_count, line_hl_group, char_hl_group)
+end
 
-  -- Skip line-ending-only changes (column past visible content)
-  if is_past_line_content(start_line, start_col, lines) then
-    return
-  end
+-- Insert the fillers of one side; returns the number of filler lines
+local function apply_side_fillers(bufnr, side)
+  local total = 0
+  local fillers = side.fillers
 
-  -- Clamp end column to line content length
-  if end_line >= 1 and end_line <= #lines then
-    local line_content = lines[end_line]
-    end_col = math.min(end_col, #line_content + 1)
+  for i = 0, side.filler_count - 1 do
+    local filler = fillers[i]
+    insert_filler_lines(bufnr, filler.after_line - 1, filler.count)
+    total = total + filler.count
   end
 
-  if start_line == end_line then
-    -- Single line range - use extmark with HIGH priority to override line highlight
-    local line_idx = start_line - 1  -- Convert to 0-indexed
-    if line_idx >= 0 then
-      vim.api.nvim_buf_set_extmark(bufnr, ns_highlight, line_idx, start_col - 1, {
-        end_col = end_col - 1,
-        hl_group = hl_group,
-        priority = 200,  -- Higher than line highlight (100)
-      })
-    end
-  else
-    -- Multi-line range
-
-    -- First line: from start_col to end of line
-    local first_line_idx = start_line - 1
-    if first_line_idx >= 0 then
-      vim.api.nvim_buf_set_extmark(bufnr, ns_highlight, first_line_idx, start_col - 1, {
-        end_line = first_line_idx + 1,
-        end_col = 0,  -- To start of next line (= end of this line)
-        hl_group = hl_group,
-        priority = 200,
-      })
-    end
-
-    -- Middle lines: entire line
-    for line = start_line + 1, end_line - 1 do
-      local line_idx = line - 1
-      if line_idx >= 0 then
-        vim.api.nvim_buf_set_extmark(bufnr, ns_highlight, line_idx, 0, {
-          end_line = line_idx + 1,
-          end_col = 0,  -- Entire line
-          hl_group = hl_group,
-          priority = 200,
-        })
-      end
-    end
-
-    -- Last line: from start to end_col
-    -- Only process if end_col > 1 OR if end_line is different from first_line
-    if end_col > 1 or end_line ~= start_line then
-      local last_line_idx = end_line - 1
-      if last_line_idx >= 0 and last_line_idx ~= first_line_idx then
-        vim.api.nvim_buf_set_extmark(bufnr, ns_highlight, last_line_idx, 0, {
-          end_col = end_col - 1,
-          hl_group = hl_group,
-          priority = 200,
-        })
-      end
-    end
-  end
+  return total
 end
 
 -- ============================================================================
--- Step 3: Filler Line Calculation (Simplified for Neovim)
+-- Main Rendering Function
 -- ============================================================================
 
--- Calculate filler lines based on inner changes
--- VSCode rule (from diffEditorViewZones.ts): 
---   Fillers are placed after `range.endLineNumberExclusive - 1`
--- 
--- Important: VSCode uses EXCLUSIVE end ranges [start, end), we use INCLUSIVE [start, end]
--- Conversion: VSCode's `endLineExclusive - 1` equals our `end_line`
---   Example for single line 35:
---     VSCode: startLine=35, endLineExclusive=36 → afterLineNumber = 36-1 = 35
---     Us:     start_line=35, end_line=35       → after_line = 35
--- Calculate filler lines based on inner changes
--- Based on VSCode's computeRangeAlignment in diffEditorViewZones.ts
---
--- VSCode's approach: Create alignments at the START and END lines of inner changes
--- - If inner change starts mid-line (col > 1): create alignment at START line
--- - If inner change ends before EOL: create alignment at END line
--- - Then view zones (fillers) are placed at alignment.endLineNumberExclusive - 1
---
--- For leading insertions (like line 1216), no alignment is created at the start
--- (since col=1), so the alignment from the previous region ends BEFORE the insertion,
--- placing fillers above the inserted content.
-local function calculate_fillers(mapping, original_lines, _modified_lines, last_orig_line, last_mod_line)
-  local fillers = {}
-
-  -- Initialize tracking from parameters (for global gap handling)
-  -- If not provided, default to mapping start (backward compatibility)
-  last_orig_line = last_orig_line or mapping.original.start_line
-  last_mod_line = last_mod_line or mapping.modified.start_line
-
-  if not mapping.inner_changes or #mapping.inner_changes == 0 then
-    -- Fallback: no inner changes, use simple line count difference
-    local mapping_orig_lines = mapping.original.end_line - mapping.original.start_line
-    local mapping_mod_lines = mapping.modified.end_line - mapping.modified.start_line
-
-    if mapping_orig_lines > mapping_mod_lines then
-      local diff = mapping_orig_lines - mapping_mod_lines
-      table.insert(fillers, {
-        buffer = 'modified',
-        after_line = mapping.modified.start_line - 1,
-        count = diff
-      })
-    elseif mapping_mod_lines > mapping_orig_lines then
-      local diff = mapping_mod_lines - mapping_orig_lines
-      table.insert(fillers, {
-        buffer = 'original',
-        after_line = mapping.original.start_line - 1,
-        count = diff
-      })
-    end
-    return fillers, mapping.original.end_line, mapping.modified.end_line
-  end
-
-  -- Track alignments (where original and modified lines should align)
-  local alignments = {}
-  local first = true  -- VSCode's 'first' flag to allow initial alignment
-
-  -- Handle gap alignment before processing inner changes (VSCode's handleAlignmentsOutsideOfDiffs)
-  -- This creates alignment for any gap between the last processed line and this mapping's start
-  local function handle_gap_alignment(orig_line_exclusive, mod_line_exclusive)
-    local orig_gap = orig_line_exclusive - last_orig_line
-    local mod_gap = mod_line_exclusive - last_mod_line
-
-    if orig_gap > 0 or mod_gap > 0 then
-      table.insert(alignments, {
-        orig_start = last_orig_line,
-        orig_end = orig_line_exclusive,
-        mod_start = last_mod_line,
-        mod_end = mod_line_exclusive,
-        orig_len = orig_gap,
-        mod_len = mod_gap
-      })
-      last_orig_line = orig_line_exclusive
-      last_mod_line = mod_line_exclusive
-    end
-  end
-
-  -- Emit gap alignment before processing this mapping's inner changes
-  handle_gap_alignment(mapping.original.start_line, mapping.modified.start_line)
-
-  local function emit_alignment(orig_line_exclusive, mod_line_exclusive)
-    -- Skip if going backwards
-    if orig_line_exclusive < last_orig_line or mod_line_exclusive < last_mod_line then
-      return
-    end
-
-    -- VSCode's logic: skip redundant alignments, but allow the first one
-    if first then
-      first = false
-    elseif orig_line_exclusive == last_orig_line or mod_line_exclusive == last_mod_line then
-      return
-    end
-
-    local orig_range_len = orig_line_exclusive - last_orig_line
-    local mod_range_len = mod_line_exclusive - last_mod_line
-
-    if orig_range_len > 0 or mod_range_len > 0 then
-      table.insert(alignments, {
-        orig_start = last_orig_line,
-        orig_end = orig_line_exclusive,
-        mod_start = last_mod_line,
-        mod_end = mod_line_exclusive,
-        orig_len = orig_range_len,
-        mod_len = mod_range_len
-      })
-    end
-
-    last_orig_line = orig_line_exclusive
-    last_mod_line = mod_line_exclusive
-  end
-
-  -- Process inner changes to create alignments (VSCode's innerHunkAlignment logic)
-  for _, inner in ipairs(mapping.inner_changes) do
-    -- If there's unmodified text BEFORE the diff on this line (column > 1)
-    if inner.original.start_col > 1 and inner.modified.start_col > 1 then
-      emit_alignment(inner.original.start_line, inner.modified.start_line)
-    end
-
-    -- If there's unmodified text AFTER the diff on this line
-    -- Check if the change ends before the end of the line
-    local orig_line_len = original_lines[inner.original.end_line] and #original_lines[inner.original.end_line] or 0
-    if inner.original.end_col <= orig_line_len then
-      -- CharRange.end_line is inclusive; emit_alignment uses this directly
-      -- for AFTER alignments (aligning the unchanged suffix on the same line)
-      emit_alignment(inner.original.end_line, inner.modified.end_line)
-    end
-  end
-
-  -- Final alignment at the end of the mapping (mapping ranges use EXCLUSIVE end)
-  emit_alignment(mapping.original.end_line, mapping.modified.end_line)
-
-  -- Convert alignments to fillers
-  -- VSCode: afterLineNumber = range.endLineNumberExclusive - 1
-  -- Our ranges are inclusive, so: after_line = end_line - 1
-  for _, align in ipairs(alignments) do
-    local line_diff = align.mod_len - align.orig_len
-
-    if line_diff > 0 then
-      -- Modified has more lines
-      table.insert(fillers, {
-        buffer = 'original',
-        after_line = align.orig_end - 1,
-        count = line_diff
-      })
-    elseif line_diff < 0 then
-      -- Original has more lines
-      table.insert(fillers, {
-        buffer = 'modified',
-        after_line = align.mod_end - 1,
-        count = -line_diff
-      })
-    end
+-- Accept either a render plan (diff.compute_render_plan()) or a LinesDiff
+-- table (diff.compute_diff())
+local function to_render_plan(plan_or_diff, original_lines, modified_lines)
+  if plan_or_diff.handle then
+    return plan_or_diff
   end
-
-  -- Return fillers and updated tracking state for next mapping
-  return fillers, last_orig_line, last_mod_line
+  return diff.lines_diff_to_render_plan(plan_or_diff, original_lines, modified_lines)
 end
 
--- ============================================================================
--- Main Rendering Function
--- ============================================================================
+-- Render a diff: set buffer content, then apply the render plan
+-- (see docs/filler-line-algorithm.md for how fillers are placed).
+-- With opts.lazy only fillers are inserted; highlights are left to
+-- M.attach_lazy_render().
+function M.render_diff(left_bufnr, right_bufnr, original_lines, modified_lines, lines_diff, opts)
+  opts = opts or {}
+  local plan = to_render_plan(lines_diff, original_lines, modified_lines)
 
--- Render diff with simplified 3-step algorithm
-function M.render_diff(left_bufnr, right_bufnr, original_lines, modified_lines, lines_diff)
   -- Clear existing highlights and fillers
   vim.api.nvim_buf_clear_namespace(left_bufnr, ns_highlight, 0, -1)
   vim.api.nvim_buf_clear_namespace(right_bufnr, ns_highlight, 0, -1)
@@ -404,72 +195,112 @@ function M.render_diff(left_bufnr, right_bufnr, original_lines, modified_lines,
   vim.api.nvim_buf_set_lines(left_bufnr, 0, -1, false, original_lines)
   vim.api.nvim_buf_set_lines(right_bufnr, 0, -1, false, modified_lines)
 
-  local total_left_fillers = 0
-  local total_right_fillers = 0
+  if not opts.lazy then
+    apply_side_highlights(left_bufnr, plan.left, "VscodeDiffLineDelete", "VscodeDiffCharDelete")
+    apply_side_highlights(right_bufnr, plan.right, "VscodeDiffLineInsert", "VscodeDiffCharInsert")
+  end
 
-  -- Track last processed line across all mappings for gap alignment (VSCode behavior)
-  local last_orig_line = 1  -- Start from line 1
-  local last_mod_line = 1
+  return {
+    left_fillers = apply_side_fillers(left_bufnr, plan.left),
+    right_fillers = apply_side_fillers(right_bufnr, plan.right),
+    plan = plan,
+  }
+end
 
-  -- Process each change mapping
-  for _, mapping in ipairs(lines_diff.changes) do
-    -- Check if ranges are empty
-    local orig_is_empty = (mapping.original.end_line <= mapping.original.start_line)
-    local mod_is_empty = (mapping.modified.end_line <= mapping.modified.start_line)
+-- ============================================================================
+-- Lazy Rendering
+-- ============================================================================
 
-    -- STEP 1: Apply line-level highlights (light colors, whole lines)
-    if not orig_is_empty then
-      apply_line_highlights(left_bufnr, mapping.original, "VscodeDiffLineDelete")
+-- Lines are rendered in fixed blocks so the work per scroll is bounded by the
+-- window height, not by the size of the hunks it crosses
+local LAZY_BLOCK_LINES = 256
+
+-- Render one block of a side: visit only the hunks overlapping it through the
+-- plan's hunk index
+local function render_block(view, block)
+  local side = view.side
+  local first_idx = block * LAZY_BLOCK_LINES
+  local last_idx = math.min(first_idx + LAZY_BLOCK_LINES, side.line_count)
+  local hunks = side.hunks
+
+  local i = diff.find_hunk(side, first_idx + 1)
+  while i < side.hunk_count do
+    local hunk = hunks[i]
+    local start_idx = hunk.start_line - 1
+    if start_idx >= last_idx then
+      break
     end
+    apply_side_lines(view.bufnr, side, math.max(start_idx, first_idx), math.min(hunk.end_line - 1, last_idx),
+                     view.line_hl_group, view.char_hl_group)
+    i = i + 1
+  end
 
-    if not mod_is_empty then
-      apply_line_highlights(right_bufnr, mapping.modified, "VscodeDiffLineInsert")
-    end
+  view.rendered[block] = true
+end
 
-    -- STEP 2: Apply character-level highlights (dark colors, specific text)
-    if mapping.inner_changes then
-      for _, inner in ipairs(mapping.inner_changes) do
-        -- Apply to original side
-        if not is_empty_range(inner.original) then
-          apply_char_highlight(left_bufnr, inner.original,
-                             "VscodeDiffCharDelete", original_lines)
-        end
-
-        -- Apply to modified side
-        if not is_empty_range(inner.modified) then
-          apply_char_highlight(right_bufnr, inner.modified,
-                             "VscodeDiffCharInsert", modified_lines)
-        end
-      end
+-- Render the blocks around the visible lines of a window that are not rendered yet
+local function render_visible(view, margin)
+  local top = vim.fn.line("w0", view.win) - margin
+  local bottom = math.min(vim.fn.line("w$", view.win) + margin, view.side.line_count)
+  if top < 1 then
+    top = 1
+  end
+
+  for block = math.floor((top - 1) / LAZY_BLOCK_LINES), math.floor((bottom - 1) / LAZY_BLOCK_LINES) do
+    if not view.rendered[block] then
+      render_block(view, block)
     end
+  end
+end
+
+-- Apply highlights only around the visible lines of both windows and fill in
+-- more on WinScrolled (which also fires on resize). Stops when a buffer is wiped.
+function M.attach_lazy_render(plan, left_win, left_buf, right_win, right_buf)
+  local margin = config.options.render.lazy_margin
+  local views = {
+    { win = left_win, bufnr = left_buf, side = plan.left, rendered = {},
+      line_hl_group = "VscodeDiffLineDelete", char_hl_group = "VscodeDiffCharDelete" },
+    { win = right_win, bufnr = right_buf, side = plan.right, rendered = {},
+      line_hl_group = "VscodeDiffLineInsert", char_hl_group = "VscodeDiffCharInsert" },
+  }
 
-    -- STEP 3: Calculate and insert filler lines
-    local fillers, new_last_orig, new_last_mod = calculate_fillers(
-      mapping, original_lines, modified_lines, last_orig_line, last_mod_line
-    )
-
-    -- Update global tracking state
-    last_orig_line = new_last_orig
-    last_mod_line = new_last_mod
-
-    for _, filler in ipairs(fillers) do
-      if filler.buffer == 'original' then
-        insert_filler_lines(left_bufnr, filler.after_line - 1, filler.count)
-        total_left_fillers = total_left_fillers + filler.count
-      else
-        insert_filler_lines(right_bufnr, filler.after_line - 1, filler.count)
-        total_right_fillers = total_right_fillers + filler.count
+  local function refresh()
+    local _ = plan  -- The sides point into the plan; keep it alive with the views
+    for _, view in ipairs(views) do
+      if vim.api.nvim_win_is_valid(view.win) and vim.api.nvim_win_get_buf(view.win) == view.bufnr then
+        render_visible(view, margin)
       end
     end
   end
 
-  return {
-    left_fillers = total_left_fillers,
-    right_fillers = total_right_fillers,
-  }
+  local group = vim.api.nvim_create_augroup("vscode_diff_lazy_render_" .. left_buf, { clear = true })
+  vim.api.nvim_create_autocmd("WinScrolled", { group = group, callback = refresh })
+  vim.api.nvim_create_autocmd("BufWipeout", {
+    group = group,
+    buffer = left_buf,
+    callback = function()
+      pcall(vim.api.nvim_del_augroup_by_id, group)
+    end,
+  })
+  vim.api.nvim_create_autocmd("BufWipeout", {
+    group = group,
+    buffer = right_buf,
+    callback = function()
+      pcall(vim.api.nvim_del_augroup_by_id, group)
+    end,
+  })
+
+  refresh()
+end
+
+-- Whether a diff of this size is rendered lazily (config.render.lazy_threshold)
+local function should_render_lazily(original_lines, modified_lines)
+  local threshold = config.options.render.lazy_threshold
+  return threshold ~= false and threshold ~= nil and math.max(#original_lines, #modified_lines) > threshold
 end
 
 -- Create side-by-side diff view
+-- lines_diff: render plan or LinesDiff table, as for render_diff()
 function M.create_diff_view(original_lines, modified_lines, lines_diff)
   -- Create buffers
   local left_buf = vim.api.nvim_create_buf(false, true)
@@ -491,8 +322,9 @@ function M.create_diff_view(original_lines, modified_lines, lines_diff)
   vim.bo[left_buf].modifiable = true
   vim.bo[right_buf].modifiable = true
 
-  -- Render diff (this inserts fillers and applies highlights)
-  local result = M.render_diff(left_buf, right_buf, original_lines, modified_lines, lines_diff)
+  -- Render diff (this inserts fillers and, unless lazy, applies highlights)
+  local lazy = should_render_lazily(original_lines, modified_lines)
+  local result = M.render_diff(left_buf, right_buf, original_lines, modified_lines, lines_diff, { lazy = lazy })
 
   -- Make buffers read-only again
   vim.bo[left_buf].modifiable = false
@@ -526,10 +358,10 @@ function M.create_diff_view(original_lines, modified_lines, lines_diff)
   pcall(vim.api.nvim_buf_set_name, right_buf, string.format("Modified_%d", unique_id))
 
   -- Auto-scroll to center the first hunk
-  if #lines_diff.changes > 0 then
-    local first_change = lines_diff.changes[1]
-    local target_line_left = first_change.original.start_line
-    local target_line_right = first_change.modified.start_line
+  local first_change = result.plan.first_change
+  if first_change then
+    local target_line_left = first_change.original
+    local target_line_right = first_change.modified
     
     vim.api.nvim_win_set_cursor(left_win, {target_line_left, 0})
     vim.api.nvim_win_set_cursor(right_win, {target_line_right, 0})
@@ -539,6 +371,10 @@ function M.create_diff_view(original_lines, modified_lines, lines_diff)
     vim.cmd("normal! zz")
   end
 
+  if lazy then
+    M.attach_lazy_render(result.plan, left_win, left_buf, right_win, right_buf)
+  end
+
   return {
     left_buf = left_buf,
     right_buf = right_buf,
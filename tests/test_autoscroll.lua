@@ -136,5 +136,38 @@ test("Right window is active after scroll", function()
   assert(current_win == view.right_win, "Right window should be active for scroll sync")
 end)
 
+-- Test 6: Large files only get highlights around the viewport
+test("Lazy rendering fills in highlights on scroll", function()
+  local original = {}
+  local modified = {}
+
+  -- One changed line every 50 lines, well above the lazy threshold
+  for i = 1, 20000 do
+    original[i] = "Line " .. i
+    modified[i] = (i % 50 == 0) and ("Changed " .. i) or original[i]
+  end
+
+  local plan = diff.compute_render_plan(original, modified)
+  local view = render.create_diff_view(original, modified, plan)
+
+  vim.cmd("redraw")
+
+  local ns = vim.api.nvim_create_namespace("vscode-diff-highlight")
+  local function extmark_at(line)
+    return #vim.api.nvim_buf_get_extmarks(view.right_buf, ns, { line - 1, 0 }, { line - 1, -1 }, {}) > 0
+  end
+
+  local initial = #vim.api.nvim_buf_get_extmarks(view.right_buf, ns, 0, -1, {})
+  assert(initial > 0, "Visible changes should be highlighted")
+  assert(initial < 400, "Highlights should not cover all 400 changes")
+  assert(not extmark_at(19950), "Changes far below the viewport should not be rendered yet")
+
+  vim.api.nvim_win_set_cursor(view.right_win, { 19950, 0 })
+  vim.cmd("normal! zz")
+  vim.cmd("doautocmd WinScrolled")
+
+  assert(extmark_at(19950), "Scrolling should render the newly visible changes")
+end)
+
 print(string.format("\n=================================================="))
 print(string.format("✓ All %d tests passed", pass_count))
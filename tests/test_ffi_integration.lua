@@ -117,7 +117,147 @@ test("Multiple calls don't leak memory", function()
   end
 end)
 
--- Test 10: Version string exists
+-- Test 10: Moved blocks are reported when requested
+test("Detects moved blocks with compute_moves", function()
+  local block = {
+    "local function helper(value)",
+    "  local doubled = value * 2",
+    "  return doubled + 1",
+    "end",
+  }
+  local rest = { "local a = 1", "local b = 2", "local c = 3", "local d = 4", "local e = 5" }
+  local original = vim.list_extend(vim.list_extend({}, block), rest)
+  local modified = vim.list_extend(vim.list_extend({}, rest), block)
+
+  local without = diff.compute_diff(original, modified)
+  assert(#without.moves == 0, "Moves should only be computed on request")
+
+  local result = diff.compute_diff(original, modified, { compute_moves = true })
+  assert(#result.moves == 1, "Should detect one moved block")
+  local move = result.moves[1]
+  assert(move.original.start_line == 1 and move.original.end_line == 5, "Move should cover the function")
+  assert(move.modified.start_line == 6 and move.modified.end_line == 10, "Move should land at the end")
+  assert(type(move.changes) == "table" and #move.changes == 0, "Unedited move should have no changes")
+end)
+
+-- Test 11: Incremental session tracks edits
+test("Session edits match compute_diff", function()
+  local original = {}
+  for i = 1, 50 do
+    table.insert(original, "line " .. i)
+  end
+  local modified = vim.list_extend({}, original)
+
+  local session = diff.create_session(original, modified)
+  assert(#session:get().changes == 0, "Identical sides should have no changes")
+
+  -- Replace line 10 and insert two lines after line 30 (0-based, end-exclusive)
+  session:edit("modified", 9, 10, { "changed 10" })
+  modified[10] = "changed 10"
+  session:edit("modified", 30, 30, { "new a", "new b" })
+  table.insert(modified, 31, "new a")
+  table.insert(modified, 32, "new b")
+
+  local result = session:get()
+  local expected = diff.compute_diff(original, modified)
+  assert(#result.changes == 2, "Should have two changes")
+  assert(vim.deep_equal(result.changes, expected.changes), "Session diff should match compute_diff")
+
+  local ok = pcall(session.edit, session, "modified", 60, 61, {})
+  assert(not ok, "Out of range edit should fail")
+  session:close()
+end)
+
+-- Test 12: Flat buffer matches the table result
+test("Flat diff view matches compute_diff", function()
+  local original = { "int a = 1;", "int b = 2;", "int c = 3;", "return a + b;" }
+  local modified = { "int a = 10;", "int b = 2;", "int d = 4;", "int e = 5;", "return a + b + d;" }
+
+  local flat = diff.compute_diff_flat(original, modified)
+  local expected = diff.compute_diff(original, modified)
+  assert(flat.change_count == #expected.changes, "Change counts should match")
+
+  local orig_start, orig_end, mod_start, mod_end = flat:change(1)
+  local first_change = expected.changes[1]
+  assert(orig_start == first_change.original.start_line and orig_end == first_change.original.end_line,
+    "Original range should match")
+  assert(mod_start == first_change.modified.start_line and mod_end == first_change.modified.end_line,
+    "Modified range should match")
+
+  local first, last = flat:inner_range(1)
+  assert(last - first + 1 == #first_change.inner_changes, "Inner change counts should match")
+  assert(vim.deep_equal(flat:to_table(), expected), "Materialized table should match compute_diff")
+end)
+
+-- Test 13: Render plan carries highlights and fillers
+test("Render plan places fillers for inserted lines", function()
+  local original = { "keep 1", "keep 2", "keep 3" }
+  local modified = { "keep 1", "new a", "new b", "keep 2", "keep 3" }
+
+  local plan = diff.compute_render_plan(original, modified)
+  assert(plan.right.line_count == 5, "Right side should cover every line")
+  assert(plan.right.line_metadata[1].type == 0, "Inserted line should be HL_LINE_INSERT")
+  assert(plan.left.filler_count == 1 and plan.right.filler_count == 0, "Fillers go on the original side")
+  assert(plan.left.fillers[0].after_line == 1 and plan.left.fillers[0].count == 2,
+    "Two fillers after line 1")
+  assert(plan.first_change.original == 2 and plan.first_change.modified == 2, "First change should be line 2")
+
+  local from_table = diff.lines_diff_to_render_plan(diff.compute_diff(original, modified), original, modified)
+  assert(from_table.left.filler_count == 1 and from_table.left.fillers[0].count == 2,
+    "Plan from a LinesDiff table should match")
+end)
+
+-- Test 14: Async jobs deliver the synchronous result, cancelled ones nothing
+test("Async diff matches compute_diff and cancels", function()
+  local original = { "int a = 1;", "int b = 2;", "int c = 3;", "return a + b;" }
+  local modified = { "int a = 10;", "int b = 2;", "int d = 4;", "return a + b + d;" }
+
+  local result, plan
+  diff.compute_diff_async(original, modified, nil, function(err, lines_diff)
+    assert(err == nil, err)
+    result = lines_diff
+  end)
+  diff.compute_render_plan_async(original, modified, nil, function(err, render_plan)
+    assert(err == nil, err)
+    plan = render_plan
+  end)
+  assert(vim.wait(5000, function() return result ~= nil and plan ~= nil end), "Async jobs should finish")
+  assert(vim.deep_equal(result, diff.compute_diff(original, modified)), "Async diff should match compute_diff")
+  assert(plan.left.line_count == 4 and plan.first_change.original == 1, "Async plan should cover the diff")
+
+  -- No line in common and no timeout: seconds of work unless cancelled
+  local big_original, big_modified = {}, {}
+  for i = 1, 3000 do
+    big_original[i] = "    original_statement_" .. i .. "(a, b);"
+    big_modified[i] = "    result = modified_call_" .. (i * 7) .. "(x);"
+  end
+  local called = false
+  local job = diff.compute_diff_async(big_original, big_modified, { max_computation_time_ms = 0 }, function()
+    called = true
+  end)
+  job:cancel()
+  assert(vim.wait(2000, function() return job.handle == nil end), "Cancelled job should release its worker")
+  assert(not called, "Cancelled job should not call back")
+end)
+
+-- Test 15: Repeated diffs come from the result cache
+test("Repeated compute_diff hits the cache", function()
+  local original = { "local a = 1", "local b = 2", "return a" }
+  local modified = { "local a = 1", "local b = 3", "return a + b" }
+
+  local first = diff.compute_diff(original, modified)
+  local before = diff.cache_stats()
+  assert(before ~= nil, "Cache should be enabled by default")
+  local second = diff.compute_diff(original, modified)
+  local after = diff.cache_stats()
+  assert(after.hits == before.hits + 1 and after.misses == before.misses, "Second diff should be a hit")
+  assert(vim.deep_equal(first, second), "Cached diff should match")
+
+  diff.clear_cache()
+  assert(diff.cache_stats().entries == 0, "Clearing should drop every entry")
+end)
+
+-- Test 16: Version string exists
 test("Can get version string", function()
   local version = diff.get_version()
   assert(type(version) == "string", "Version should be a string")
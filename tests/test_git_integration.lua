@@ -170,6 +170,78 @@ test("Multiple async calls work independently", function()
   vim.fn.delete(test_file)
 end)
 
+-- Test 9: Pipelined requests through the persistent reader
+test("Pipelined blob requests answer in order", function()
+  local current_file = debug.getinfo(1).source:sub(2)
+  if not git.is_in_git_repo(current_file) then
+    return
+  end
+
+  -- Cached root: the second lookup must not see a different answer
+  assert(git.get_git_root(current_file) == git.get_git_root(current_file), "Root should be cached")
+
+  local results = {}
+  local revisions = { "HEAD", "invalid-revision-12345", "HEAD" }
+  for i, revision in ipairs(revisions) do
+    git.get_file_at_revision(revision, current_file, function(err, lines)
+      results[i] = { err = err, lines = lines }
+    end)
+  end
+  local validated = nil
+  git.validate_revision("HEAD", current_file, function(err)
+    validated = err or true
+  end)
+
+  vim.wait(3000, function() return results[1] and results[2] and results[3] and validated end)
+  assert(results[1] and results[2] and results[3], "Every request should complete")
+  assert(validated == true, "HEAD should validate")
+  assert(results[2].err and results[2].err:match("Invalid revision"), "Bad revision should be reported")
+  if not results[1].err then
+    assert(#results[1].lines == #results[3].lines, "Same blob should come back twice")
+  end
+
+  git.shutdown()
+  local after_shutdown = false
+  git.get_file_at_revision("HEAD", current_file, function()
+    after_shutdown = true
+  end)
+  vim.wait(2000, function() return after_shutdown end)
+  assert(after_shutdown, "Reader should respawn after shutdown")
+end)
+
+-- Test 10: Modified files and background prefetch
+test("Lists modified files and prefetches them", function()
+  local current_file = debug.getinfo(1).source:sub(2)
+  local root = git.get_git_root(current_file)
+  if not root then
+    return
+  end
+
+  local result = nil
+  git.get_modified_files(root, function(err, files, status)
+    result = { err = err, files = files, status = status }
+  end)
+  vim.wait(3000, function() return result ~= nil end)
+  assert(result and not result.err, "git status should succeed")
+  assert(type(result.files) == "table" and type(result.status) == "string", "Should return files and status")
+  for _, rel_path in ipairs(result.files) do
+    assert(not rel_path:find("%z"), "Paths should be split on NUL")
+  end
+
+  local prefetch = require("vscode-diff.prefetch")
+  require("vscode-diff.config").options.prefetch.idle_ms = 0
+  if prefetch.enable(root) then
+    vim.wait(5000, function()
+      local status = prefetch.status()
+      return #result.files == 0 or (status.queued == 0 and not status.running and status.done > 0)
+    end)
+    local status = prefetch.status()
+    assert(status.root == root, "Prefetch should run in the repository")
+    prefetch.disable()
+    assert(prefetch.status() == nil, "Disabled prefetch has no status")
+  end
+end)
+
 -- Summary
 print("\n" .. string.rep("=", 50))
 if pass_count == test_count then